@@ -0,0 +1,208 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "bench/Benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+
+static volatile const void* g_sink = nullptr;
+
+void doNotOptimize(const void* p)
+{
+  g_sink = p;
+}
+
+
+Benchmark::Benchmark()
+: m_warmups(2)
+, m_repetitions(11)
+, m_scale(1.0)
+{
+}
+
+void Benchmark::setFilter(std::string const& filter)
+{
+  m_filter = filter;
+}
+
+void Benchmark::setWarmups(const int warmups)
+{
+  m_warmups = std::max(0, warmups);
+}
+
+void Benchmark::setRepetitions(const int repetitions)
+{
+  m_repetitions = std::max(1, repetitions);
+}
+
+void Benchmark::setScale(const double scale)
+{
+  m_scale = std::max(0.0, scale);
+}
+
+bool Benchmark::isEnabled(std::string const& name) const
+{
+  return m_filter.empty() || name.find(m_filter) != std::string::npos;
+}
+
+void Benchmark::run(std::string const& name, const int iterations, const double items, std::string const& unit,
+                    std::function<void()> const& body)
+{
+  run(name, iterations, items, unit, std::function<void()>(), body);
+}
+
+void Benchmark::run(std::string const& name, const int iterations, const double items, std::string const& unit,
+                    std::function<void()> const& setup, std::function<void()> const& body)
+{
+  if (!isEnabled(name))
+  {
+    return;
+  }
+
+  BenchmarkResult result;
+
+  result.name        = name;
+  result.warmups     = m_warmups;
+  result.repetitions = m_repetitions;
+  result.iterations  = std::max(1, int(std::lround(iterations * m_scale)));
+  result.items       = items;
+  result.unit        = unit;
+
+  std::vector<double> times;
+
+  for (int r = 0; r < m_warmups + m_repetitions; ++r)
+  {
+    if (setup)
+    {
+      setup();
+    }
+
+    const auto begin = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < result.iterations; ++i)
+    {
+      body();
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+
+    if (m_warmups <= r)
+    {
+      times.push_back(std::chrono::duration<double>(end - begin).count() / double(result.iterations));
+    }
+  }
+
+  std::sort(times.begin(), times.end());
+
+  double sum = 0.0;
+  for (const double t : times)
+  {
+    sum += t;
+  }
+
+  const size_t half = times.size() / 2;
+
+  result.minimum = times.front();
+  result.median  = (times.size() & 1) ? times[half] : 0.5 * (times[half - 1] + times[half]);
+  result.mean    = sum / double(times.size());
+  result.maximum = times.back();
+
+  std::cout << std::left << std::setw(48) << name << std::right
+            << " median " << std::setw(10) << std::fixed << std::setprecision(3) << result.median * 1000.0 << " ms"
+            << "  min "   << std::setw(10) << result.minimum * 1000.0 << " ms";
+  if (0.0 < items)
+  {
+    std::cout << "  " << std::setprecision(2) << items / result.median * 1.0e-6 << " M" << unit << "/s";
+  }
+  std::cout << '\n';
+
+  m_results.push_back(result);
+}
+
+std::vector<BenchmarkResult> const& Benchmark::getResults() const
+{
+  return m_results;
+}
+
+static std::string escapeJSON(std::string const& s)
+{
+  std::string escaped;
+
+  for (const char c : s)
+  {
+    if (c == '"' || c == '\\')
+    {
+      escaped += '\\';
+    }
+    escaped += c;
+  }
+  return escaped;
+}
+
+bool Benchmark::writeJSON(std::string const& filename) const
+{
+  std::ofstream file(filename);
+
+  if (!file)
+  {
+    std::cerr << "ERROR: writeJSON() could not open " << filename << '\n';
+    return false;
+  }
+
+  // One object per case, times in seconds per body call. The median is the value to track, the minimum the best case.
+  file << std::setprecision(9);
+  file << "{\n  \"benchmarks\": [\n";
+  for (size_t i = 0; i < m_results.size(); ++i)
+  {
+    BenchmarkResult const& r = m_results[i];
+
+    file << "    {"
+         << "\"name\": \"" << escapeJSON(r.name) << "\", "
+         << "\"warmups\": " << r.warmups << ", "
+         << "\"repetitions\": " << r.repetitions << ", "
+         << "\"iterations\": " << r.iterations << ", "
+         << "\"items\": " << r.items << ", "
+         << "\"unit\": \"" << escapeJSON(r.unit) << "\", "
+         << "\"min\": " << r.minimum << ", "
+         << "\"median\": " << r.median << ", "
+         << "\"mean\": " << r.mean << ", "
+         << "\"max\": " << r.maximum << ", "
+         << "\"items_per_second\": " << ((0.0 < r.items) ? r.items / r.median : 0.0)
+         << "}" << ((i + 1 < m_results.size()) ? "," : "") << '\n';
+  }
+  file << "  ]\n}\n";
+
+  return static_cast<bool>(file);
+}
@@ -0,0 +1,90 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Minimal host benchmark harness of the rtigo3_bench target.
+// Every case runs a pinned number of warmup and measured repetitions, each calling the body a pinned number of iterations.
+// There is no adaptive iteration count, so the work per repetition is identical between runs and machines.
+
+struct BenchmarkResult
+{
+  std::string name;
+  int         warmups;
+  int         repetitions;
+  int         iterations;   // Body calls per repetition.
+  double      items;        // Items processed per body call (bytes, tokens, texels, triangles, ...).
+  std::string unit;         // Name of the items.
+  double      minimum;      // Seconds per body call.
+  double      median;
+  double      mean;
+  double      maximum;
+};
+
+class Benchmark
+{
+public:
+  Benchmark();
+
+  void setFilter(std::string const& filter); // Only cases whose name contains the filter run.
+  void setWarmups(const int warmups);
+  void setRepetitions(const int repetitions);
+  void setScale(const double scale);         // Scales the iteration counts. Use it to trade stability for run time.
+
+  // The setup runs untimed before each repetition, the body iterations times inside the timed region.
+  void run(std::string const& name, const int iterations, const double items, std::string const& unit,
+           std::function<void()> const& setup, std::function<void()> const& body);
+  void run(std::string const& name, const int iterations, const double items, std::string const& unit,
+           std::function<void()> const& body);
+
+  bool isEnabled(std::string const& name) const;
+
+  bool writeJSON(std::string const& filename) const;
+
+  std::vector<BenchmarkResult> const& getResults() const;
+
+private:
+  std::string m_filter;
+  int         m_warmups;
+  int         m_repetitions;
+  double      m_scale;
+
+  std::vector<BenchmarkResult> m_results;
+};
+
+// Keeps the compiler from removing the computation of the value.
+void doNotOptimize(const void* p);
+
+#endif // BENCHMARK_H
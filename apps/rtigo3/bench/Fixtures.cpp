@@ -0,0 +1,516 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "bench/Fixtures.h"
+
+#include "inc/Camera.h"
+#include "inc/HostBVH.h"
+#include "inc/InputTrace.h"
+#include "inc/SceneGraph.h"
+#include "inc/SceneInterpreter.h"
+#include "inc/WavefrontQueue.h"
+
+#include "shaders/aov_definition.h"
+#include "shaders/vector_math.h"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+MaterialGUI makeMaterial(const float ior)
+{
+  MaterialGUI material;
+
+  material.name             = "material";
+  material.indexBSDF        = INDEX_BRDF_DIFFUSE;
+  material.albedo           = make_float3(0.5f, 0.5f, 0.5f);
+  material.absorptionColor  = make_float3(1.0f, 1.0f, 1.0f);
+  material.absorptionScale  = 0.0f;
+  material.roughness        = make_float2(0.1f, 0.1f);
+  material.ior              = ior;
+  material.thinwalled       = false;
+  material.useAlbedoTexture = false;
+  material.useCutoutTexture = false;
+
+  return material;
+}
+
+void makeRandomTransform(std::mt19937& rng, const float extent, float matrix[12])
+{
+  std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+
+  float4 q = make_float4(uniform(rng), uniform(rng), uniform(rng), uniform(rng));
+  const float invLength = 1.0f / sqrtf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+  q = q * invLength;
+
+  const float scale = 0.5f + 1.5f * fabsf(uniform(rng));
+
+  matrix[ 0] = scale * (1.0f - 2.0f * (q.y * q.y + q.z * q.z));
+  matrix[ 1] = scale * (2.0f * (q.x * q.y - q.z * q.w));
+  matrix[ 2] = scale * (2.0f * (q.x * q.z + q.y * q.w));
+  matrix[ 3] = extent * uniform(rng);
+  matrix[ 4] = scale * (2.0f * (q.x * q.y + q.z * q.w));
+  matrix[ 5] = scale * (1.0f - 2.0f * (q.x * q.x + q.z * q.z));
+  matrix[ 6] = scale * (2.0f * (q.y * q.z - q.x * q.w));
+  matrix[ 7] = extent * uniform(rng);
+  matrix[ 8] = scale * (2.0f * (q.x * q.z - q.y * q.w));
+  matrix[ 9] = scale * (2.0f * (q.y * q.z + q.x * q.w));
+  matrix[10] = scale * (1.0f - 2.0f * (q.x * q.x + q.y * q.y));
+  matrix[11] = extent * uniform(rng);
+}
+
+void buildHostBVHScene(HostBVH& bvh, std::vector< std::shared_ptr<sg::Triangles> >& geometries, const int numInstances)
+{
+  std::mt19937 rng(79);
+  std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+
+  geometries.clear();
+  geometries.push_back(std::make_shared<sg::Triangles>(0));
+  geometries.back()->createSphere(64, 32, 1.0f, M_PIf);
+  geometries.push_back(std::make_shared<sg::Triangles>(1));
+  geometries.back()->createTorus(64, 32, 0.25f, 1.0f);
+  geometries.push_back(std::make_shared<sg::Triangles>(2));
+  geometries.back()->createBox();
+  geometries.push_back(std::make_shared<sg::Triangles>(3));
+  geometries.back()->createPlane(8, 8, 1);
+
+  std::vector<TriangleAttributes> soup(3000);
+  std::vector<unsigned int>       soupIndices(3000);
+  for (size_t i = 0; i < soup.size(); ++i)
+  {
+    const float3 center = make_float3(uniform(rng), uniform(rng), uniform(rng)) * ((i % 3 == 0) ? 2.0f : 0.0f);
+
+    soup[i].vertex = (i % 3 == 0) ? center : soup[i - i % 3].vertex + make_float3(uniform(rng), uniform(rng), uniform(rng)) * 0.2f;
+    soupIndices[i] = unsigned(i);
+  }
+  geometries.push_back(std::make_shared<sg::Triangles>(4));
+  geometries.back()->setAttributes(soup);
+  geometries.back()->setIndices(soupIndices);
+
+  bvh.clear();
+
+  std::vector<int> meshes;
+  for (std::shared_ptr<sg::Triangles> const& geometry : geometries)
+  {
+    std::vector<TriangleAttributes> const& attributes = geometry->getAttributes();
+    std::vector<unsigned int>       const& indices    = geometry->getIndices();
+
+    meshes.push_back(bvh.addMesh(reinterpret_cast<const float*>(attributes.data()), sizeof(TriangleAttributes), attributes.size(), indices.data(), indices.size()));
+  }
+  const int meshEmpty = bvh.addMesh(nullptr, sizeof(TriangleAttributes), 0, nullptr, 0);
+
+  const float extent = 20.0f * std::cbrt(float(numInstances) / 50.0f);
+
+  float matrix[12];
+  for (int i = 0; i < numInstances; ++i)
+  {
+    makeRandomTransform(rng, extent, matrix);
+    bvh.addInstance(meshes[i % meshes.size()], matrix);
+  }
+
+  bvh.addInstance(meshEmpty, matrix);
+
+  const float singular[12] = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f };
+  bvh.addInstance(meshes[0], singular);
+
+  bvh.build();
+}
+
+std::vector<BvhRay> makeHostBVHRays(const size_t count, const float extent)
+{
+  std::mt19937 rng(179);
+  std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+
+  std::vector<BvhRay> rays(count);
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    BvhRay& ray = rays[i];
+
+    // Rays from the outside towards the scene, rays starting inside the scene, and short rays with a limited interval.
+    const float3 org = make_float3(uniform(rng), uniform(rng), uniform(rng)) * ((i & 1) ? 3.0f * extent : extent);
+    const float3 dir = normalize((i & 1) ? make_float3(uniform(rng), uniform(rng), uniform(rng)) * extent - org
+                                         : make_float3(uniform(rng), uniform(rng), uniform(rng)));
+    ray.org[0] = org.x;
+    ray.org[1] = org.y;
+    ray.org[2] = org.z;
+    ray.dir[0] = dir.x;
+    ray.dir[1] = dir.y;
+    ray.dir[2] = dir.z;
+    ray.tmin   = (i % 4 == 2) ? 5.0f : 0.0f;
+    ray.tmax   = (i % 8 == 2) ? 15.0f : RT_DEFAULT_MAX;
+  }
+  return rays;
+}
+
+float halfToFloat(const unsigned short h)
+{
+  const float sign     = (h & 0x8000) ? -1.0f : 1.0f;
+  const int   exponent = (h >> 10) & 0x1F;
+  const int   mantissa = h & 0x3FF;
+
+  if (exponent == 0)
+  {
+    return sign * ldexpf(float(mantissa), -24);
+  }
+  if (exponent == 31)
+  {
+    return (mantissa == 0) ? sign * INFINITY : NAN;
+  }
+  return sign * ldexpf(float(mantissa | 0x400), exponent - 25);
+}
+
+void fillRandom(std::vector<float>& data, const unsigned int seed)
+{
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> uniform(-100.0f, 100.0f);
+
+  for (float& f : data)
+  {
+    f = uniform(rng);
+  }
+}
+
+std::vector<unsigned int> makeWavefrontKeys(const unsigned int count, const unsigned int numKeys, const float ended, const unsigned int seed)
+{
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+
+  std::vector<unsigned int> keys(count);
+  for (unsigned int& key : keys)
+  {
+    key = (uniform(rng) < ended) ? WAVEFRONT_KEY_NONE : static_cast<unsigned int>(rng() % numKeys);
+  }
+  return keys;
+}
+
+void recordInputTrace(InputTrace& trace)
+{
+  trace.startRecording();
+
+  for (int f = 0; f < 599; ++f)
+  {
+    if (f == 30 || f == 300 || f == 400)
+    {
+      trace.record(INPUT_EVENT_BASE, 100 + (f / 300) * 100, 100 + (f / 300) * 100, 0.0f);
+    }
+    else if (30 < f && f < 90)
+    {
+      trace.record(INPUT_EVENT_ORBIT, 100 + (f - 30) * 4, 100 + (f - 30), 0.0f);
+    }
+    else if (f == 200 || f == 210 || f == 220)
+    {
+      trace.record(INPUT_EVENT_ZOOM, 0, 0, -1.0f);
+    }
+    else if (300 < f && f < 340)
+    {
+      trace.record(INPUT_EVENT_PAN, 200 - (f - 300) * 2, 200, 0.0f);
+    }
+    else if (400 < f && f < 430)
+    {
+      trace.record(INPUT_EVENT_DOLLY, 200, 200 + (f - 400), 0.0f);
+    }
+    else if (f == 500)
+    {
+      trace.record(INPUT_EVENT_FRAME, 0, 0, 0.0f);
+    }
+
+    // Parameter edits. Mouse ratio and tonemapper changes don't restart the accumulation.
+    if (f == 120)
+    {
+      trace.record(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_MOUSE_RATIO, 0, 2.5f);
+    }
+    else if (f == 150)
+    {
+      trace.record(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_GAMMA, 0, 1.0f / 2.2f);
+    }
+    else if (f == 250)
+    {
+      trace.record(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_SAMPLES_SQRT, 0, 2.0f);
+    }
+    else if (f == 450)
+    {
+      // A color edit with two changed components in one frame restarts once.
+      trace.record(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_MATERIAL_ALBEDO_R, 1, 0.123456789f);
+      trace.record(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_MATERIAL_ALBEDO_B, 1, 1.0e-7f);
+    }
+    else if (f == 460)
+    {
+      trace.record(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_LIGHT_EMISSION_G, 1, 12345.678f);
+    }
+    else if (f == 470)
+    {
+      trace.record(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_AOV_MASK, 0, float(AOV_DEPTH | AOV_NORMAL | AOV_DIRECT));
+    }
+
+    trace.nextFrame();
+  }
+}
+
+// CPU stand-in for the Application and its renderer in an input trace replay.
+// It applies the events to a Camera like Application::applyInputEvent() and restarts a progressive accumulation
+// whenever the camera or a parameter which affects the rendering changed. Each iteration shades a small image,
+// so restarts and refinement have a real cost.
+class ReplayStandIn
+{
+public:
+  ReplayStandIn()
+  : m_iterationIndex(0)
+  , m_restarts(0)
+  , m_restart(false)
+  , m_accumulation(128 * 128)
+  {
+    m_camera.setResolution(128, 128);
+  }
+
+  // Returns true when the accumulation must restart, like Application::applyInputEvent().
+  bool apply(InputEvent const& event)
+  {
+    switch (event.type)
+    {
+      case INPUT_EVENT_BASE:
+        m_camera.setBaseCoordinates(event.x, event.y);
+        break;
+      case INPUT_EVENT_ORBIT:
+        m_camera.orbit(event.x, event.y);
+        break;
+      case INPUT_EVENT_DOLLY:
+        m_camera.dolly(event.x, event.y);
+        break;
+      case INPUT_EVENT_PAN:
+        m_camera.pan(event.x, event.y);
+        break;
+      case INPUT_EVENT_ZOOM:
+        m_camera.zoom(event.value);
+        break;
+      case INPUT_EVENT_FOCUS:
+        m_camera.markDirty(); // No scene to pick. The focus change restarts the accumulation like in the application.
+        break;
+      case INPUT_EVENT_FRAME:
+        m_camera.frame(make_float3(-1.0f), make_float3(1.0f));
+        break;
+      case INPUT_EVENT_PARAMETER:
+        if (event.x == INPUT_PARAMETER_MOUSE_RATIO)
+        {
+          m_camera.setSpeedRatio(event.value);
+          return false;
+        }
+        // Application::applyParameter() only updates the rasterizer for these.
+        return !(event.x == INPUT_PARAMETER_PRESENT || (INPUT_PARAMETER_BALANCE_R <= event.x && event.x <= INPUT_PARAMETER_BRIGHTNESS));
+      default:
+        break;
+    }
+    return false;
+  }
+
+  // Application::replayInputEvents() calls restartRendering() once for all parameter edits of a frame.
+  void restartRendering()
+  {
+    m_restart = true;
+  }
+
+  void render()
+  {
+    float3 P;
+    float3 U;
+    float3 V;
+    float3 W;
+
+    // The camera and the parameters restart the same accumulation, that counts as one restart.
+    const bool isDirtyCamera = m_camera.getFrustum(P, U, V, W);
+
+    if (isDirtyCamera || m_restart)
+    {
+      m_restart = false;
+      ++m_restarts;
+      m_iterationIndex = 0;
+    }
+
+    // Accumulate the primary ray directions. Enough work to keep the frames from being free.
+    const float weight = 1.0f / float(m_iterationIndex + 1);
+    for (int y = 0; y < 128; ++y)
+    {
+      for (int x = 0; x < 128; ++x)
+      {
+        const float2 d = make_float2((float(x) + 0.5f) / 64.0f - 1.0f, (float(y) + 0.5f) / 64.0f - 1.0f);
+        const float3 direction = normalize(d.x * U + d.y * V + W);
+
+        float4& dst = m_accumulation[y * 128 + x];
+        dst = lerp(dst, make_float4(fabsf(direction.x), fabsf(direction.y), fabsf(direction.z), 1.0f), weight);
+      }
+    }
+
+    ++m_iterationIndex;
+  }
+
+  unsigned int getIterationIndex() const
+  {
+    return m_iterationIndex;
+  }
+
+  unsigned int getRestarts() const
+  {
+    return m_restarts;
+  }
+
+private:
+  Camera              m_camera;
+  unsigned int        m_iterationIndex;
+  unsigned int        m_restarts;
+  bool                m_restart;
+  std::vector<float4> m_accumulation;
+};
+
+void replayInputTrace(std::vector<InputEvent> const& events, std::unique_ptr<InputReplay>& replay)
+{
+  replay.reset(new InputReplay(events, false));
+
+  ReplayStandIn standIn;
+
+  std::vector<InputEvent> frameEvents;
+
+  while (!replay->isFinished())
+  {
+    replay->nextFrame(standIn.getIterationIndex(), standIn.getRestarts(), frameEvents);
+
+    bool restart = false;
+    for (InputEvent const& event : frameEvents)
+    {
+      restart |= standIn.apply(event);
+    }
+    if (restart)
+    {
+      standIn.restartRendering();
+    }
+    if (!replay->isFinished())
+    {
+      standIn.render();
+    }
+  }
+}
+
+bool saveAndLoadInputTrace(InputTrace& recorded, InputTrace& loaded)
+{
+  const std::string filename = "rtigo3_bench_trace.txt";
+
+  const bool isLoaded = recorded.save(filename) && loaded.load(filename);
+
+  remove(filename.c_str());
+
+  return isLoaded;
+}
+
+void writeSceneModels(std::string const& filename, const int instances)
+{
+  std::ostringstream stream;
+
+  std::mt19937 rng(54321);
+  std::uniform_real_distribution<float> uniform(-100.0f, 100.0f);
+
+  stream << "# Generated by rtigo3_bench.\n"
+         << "albedo 0.5 0.5 0.5\nmaterial default brdf_diffuse\n";
+  for (int i = 0; i < instances; ++i)
+  {
+    if ((i & 1023) == 0)
+    {
+      stream << "roughness " << (i & 0xFFFF) * 1.0e-5f << " 0.2\nmaterial \"Material " << (i >> 10) << "\" bsdf_ggx_smith\n";
+    }
+    stream << "push\n"
+           << "translate " << uniform(rng) << " " << uniform(rng) << " " << uniform(rng) << "\n"
+           << "rotate 1 " << uniform(rng) << " 0 " << uniform(rng) << "\n"
+           << "push\nscale 2 0.5 2\npop\n"
+           << "scale 0.5 0.5 0.5\n";
+    switch (i & 3)
+    {
+      case 0:
+        stream << "model sphere " << 16 + (i & 0xF0) << " 90 " << 0.25f * float(1 + ((i >> 2) & 3)) << " \"Material " << (i >> 10) << "\"\n";
+        break;
+      case 1:
+        stream << "model torus 180 90 0.75 " << 0.05f * float(1 + ((i >> 2) & 7)) << " \"Material " << (i >> 10) << "\"\n";
+        break;
+      case 2:
+        stream << "model plane " << 1 + (i & 0x7C) << " 1 " << ((i >> 2) % 3) << " missing\n";
+        break;
+      case 3:
+        stream << "model box \"Material " << (i >> 10) << "\"\n";
+        break;
+    }
+    stream << "pop\n";
+  }
+
+  std::ofstream file(filename, std::ios::binary);
+  file << stream.str();
+}
+
+bool interpretScene(std::string const& filename, const unsigned int numThreads, SceneResult& result)
+{
+  SceneInterpreter interpreter;
+
+  if (!interpreter.lex(filename))
+  {
+    return false;
+  }
+  interpreter.resolve();
+
+  result.scene = std::make_shared<sg::Group>(0);
+  result.geometries.clear();
+  result.mapGeometries.clear();
+  result.mapMaterialReferences.clear();
+  result.materials.clear();
+  result.idGeometry = 0;
+  result.idInstance = 0;
+
+  SceneTarget target;
+
+  target.scene                 = result.scene;
+  target.geometries            = &result.geometries;
+  target.mapGeometries         = &result.mapGeometries;
+  target.mapMaterialReferences = &result.mapMaterialReferences;
+  target.idGeometry            = &result.idGeometry;
+  target.idInstance            = &result.idInstance;
+
+  target.createMaterial = [&result](SceneMaterial const& material)
+  {
+    result.mapMaterialReferences[material.reference] = static_cast<int>(result.materials.size());
+    result.materials.push_back(material);
+  };
+
+  target.createModel = [](SceneModel const&)
+  {
+    return std::shared_ptr<sg::Group>();
+  };
+
+  return interpreter.expand(target, numThreads);
+}
@@ -0,0 +1,100 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef FIXTURES_H
+#define FIXTURES_H
+
+#include <cuda_runtime.h> // float3
+
+#include "inc/HostBVH.h"
+#include "inc/InputTrace.h"
+#include "inc/MaterialGUI.h"
+#include "inc/SceneGraph.h"
+#include "inc/SceneInterpreter.h"
+
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Deterministic test data shared by the rtigo3_bench benchmarks and the rtigo3_check checks.
+// All generators are seeded, so both targets work on identical inputs on every machine.
+
+// Diffuse material with the given IOR.
+MaterialGUI makeMaterial(const float ior);
+
+// Random rotation, uniform scale and translation inside [-extent, extent] as row-major 3x4 matrix.
+void makeRandomTransform(std::mt19937& rng, const float extent, float matrix[12]);
+
+// Instanced spheres, tori, boxes, planes, a triangle soup, an empty mesh and a singular instance.
+// The instances spread over a bigger volume with more instances, 50 of them fill [-20, 20]^3.
+void buildHostBVHScene(HostBVH& bvh, std::vector< std::shared_ptr<sg::Triangles> >& geometries, const int numInstances);
+std::vector<BvhRay> makeHostBVHRays(const size_t count, const float extent);
+
+// Reference decoder of IEEE 754 binary16 values.
+float halfToFloat(const unsigned short h);
+
+// Uniform random values in [-100, 100].
+void fillRandom(std::vector<float>& data, const unsigned int seed);
+
+// Shading keys of a bounce: hits per BSDF, with ended paths in between.
+std::vector<unsigned int> makeWavefrontKeys(const unsigned int count, const unsigned int numKeys, const float ended, const unsigned int seed);
+
+// Records an input trace of 600 frames with the recorder the application uses. The events are the ones
+// Application::guiEventHandler() and guiWindow() record: an orbit drag, idle refinement, mouse wheel zooms, a pan drag,
+// a dolly drag, a frame key press and GUI parameter edits with and without accumulation restart.
+void recordInputTrace(InputTrace& trace);
+
+// Same frame loop as Application::replay() with a CPU stand-in for the renderer. Returns the replay with the per frame measurements.
+void replayInputTrace(std::vector<InputEvent> const& events, std::unique_ptr<InputReplay>& replay);
+
+// Saves the recorded trace, loads it again and removes the file.
+bool saveAndLoadInputTrace(InputTrace& recorded, InputTrace& loaded);
+
+// Writes a scene description with interleaved materials, nested transforms, all runtime generated geometry types
+// and some instances referencing undefined materials.
+void writeSceneModels(std::string const& filename, const int instances);
+
+// The host side of the scene which Application::loadSceneDescription() appends to.
+struct SceneResult
+{
+  std::shared_ptr<sg::Group>                    scene;
+  std::vector< std::shared_ptr<sg::Triangles> > geometries;
+  std::map<std::string, unsigned int>           mapGeometries;
+  std::map<std::string, int>                    mapMaterialReferences;
+  std::vector<SceneMaterial>                    materials;
+  unsigned int                                  idGeometry;
+  unsigned int                                  idInstance;
+};
+
+bool interpretScene(std::string const& filename, const unsigned int numThreads, SceneResult& result);
+
+#endif // FIXTURES_H
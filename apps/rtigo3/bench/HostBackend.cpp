@@ -0,0 +1,103 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Host implementations of the few CUDA driver entry points reached by the benchmarked code.
+// The cuda::ArenaAllocator only needs cuMemAlloc() and cuMemFree() and the CU_CHECK error strings.
+// The BufferCache additionally synchronizes the context, which is a no-op here.
+// Backing the "device" pointers with aligned host memory measures the bookkeeping of the allocator alone,
+// and the rtigo3_bench and rtigo3_check executables run on machines without an NVIDIA driver.
+
+#include <cuda.h>
+
+#include <cstdlib>
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+
+extern "C"
+{
+
+CUresult CUDAAPI cuMemAlloc(CUdeviceptr* dptr, size_t bytesize)
+{
+  if (dptr == nullptr || bytesize == 0)
+  {
+    return CUDA_ERROR_INVALID_VALUE;
+  }
+
+  // cuMemAlloc() returns at least 256 byte aligned addresses. The arena alignment logic relies on that.
+#if defined(_WIN32)
+  void* p = _aligned_malloc(bytesize, 256);
+#else
+  void* p = nullptr;
+  if (posix_memalign(&p, 256, bytesize) != 0)
+  {
+    p = nullptr;
+  }
+#endif
+  if (p == nullptr)
+  {
+    return CUDA_ERROR_OUT_OF_MEMORY;
+  }
+
+  *dptr = reinterpret_cast<CUdeviceptr>(p);
+
+  return CUDA_SUCCESS;
+}
+
+CUresult CUDAAPI cuMemFree(CUdeviceptr dptr)
+{
+#if defined(_WIN32)
+  _aligned_free(reinterpret_cast<void*>(dptr));
+#else
+  free(reinterpret_cast<void*>(dptr));
+#endif
+
+  return CUDA_SUCCESS;
+}
+
+CUresult CUDAAPI cuCtxSynchronize(void)
+{
+  return CUDA_SUCCESS;
+}
+
+CUresult CUDAAPI cuGetErrorName(CUresult error, const char** pStr)
+{
+  *pStr = (error == CUDA_SUCCESS) ? "CUDA_SUCCESS" : "CUDA_ERROR";
+
+  return CUDA_SUCCESS;
+}
+
+CUresult CUDAAPI cuGetErrorString(CUresult error, const char** pStr)
+{
+  *pStr = (error == CUDA_SUCCESS) ? "no error" : "host backend error";
+
+  return CUDA_SUCCESS;
+}
+
+} // extern "C"
@@ -0,0 +1,915 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// rtigo3_bench: Host side micro-benchmarks of the CPU hot paths in rtigo3.
+// None of these cases need a GPU. The inputs are generated deterministically, so results are comparable between runs.
+// The benchmarks only measure. The rtigo3_check target verifies the results of the same functions.
+//
+// Usage: rtigo3_bench [--filter <substring>] [--warmups <n>] [--repetitions <n>] [--scale <factor>] [--json <filename>]
+
+#include "bench/Benchmark.h"
+#include "bench/Fixtures.h"
+
+#include "inc/Arena.h"
+#include "inc/BufferCache.h"
+#include "inc/EnvFormat.h"
+#include "inc/HostBVH.h"
+#include "inc/InputTrace.h"
+#include "inc/ParameterChannel.h"
+#include "inc/Parser.h"
+#include "inc/SampleRange.h"
+#include "inc/SceneGraph.h"
+#include "inc/SceneInterpreter.h"
+#include "inc/Tangents.h"
+#include "inc/TextureConversion.h"
+#include "inc/TileLayout.h"
+#include "inc/TimeView.h"
+#include "inc/Tonemapper.h"
+#include "inc/WavefrontQueue.h"
+
+#include "shaders/tile_layout.h"
+#include "shaders/vector_math.h"
+
+#include <dp/math/Batch.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// Writes a scene description in the syntax of the scene_rtigo3_*.txt files with the given number of instances.
+static size_t writeScene(std::string const& filename, const int instances)
+{
+  std::ostringstream stream;
+
+  std::mt19937 rng(12345);
+  std::uniform_real_distribution<float> uniform(-100.0f, 100.0f);
+
+  stream << "# Generated by rtigo3_bench.\n";
+  for (int i = 0; i < 64; ++i)
+  {
+    stream << "albedo 0.5 0.25 0.125\nroughness 0.1 0.1\nmaterial \"Material " << i << "\" brdf_ggx_smith\n";
+  }
+  for (int i = 0; i < instances; ++i)
+  {
+    stream << "push\n"
+           << "translate " << uniform(rng) << " " << uniform(rng) << " " << uniform(rng) << "\n"
+           << "rotate 0 1 0 " << uniform(rng) << "\n"
+           << "scale 0.5 0.5 0.5\n"
+           << "model sphere 180 90 1 \"Material " << (i & 63) << "\"\n"
+           << "pop\n";
+  }
+
+  const std::string text = stream.str();
+
+  std::ofstream file(filename, std::ios::binary);
+  file << text;
+
+  return text.size();
+}
+
+static void benchmarkParser(Benchmark& bench)
+{
+  const std::string name = "parser/tokenize";
+  if (!bench.isEnabled(name))
+  {
+    return;
+  }
+
+  const std::string filename = "rtigo3_bench_scene.txt";
+  const size_t bytes = writeScene(filename, 50000);
+
+  std::unique_ptr<Parser> parser;
+  std::string token;
+  size_t tokens = 0;
+
+  // The file load is untimed, the body runs the whole token loop of Application::loadSceneDescription().
+  // Parser::load() doesn't rewind the read position, so each repetition uses a new Parser.
+  bench.run(name, 1, double(bytes), "B",
+    [&]()
+    {
+      parser.reset(new Parser());
+      if (!parser->load(filename))
+      {
+        std::cerr << "ERROR: benchmarkParser() failed to load " << filename << '\n';
+      }
+    },
+    [&]()
+    {
+      ParserTokenType tokenType;
+      while ((tokenType = parser->getNextToken(token)) != PTT_EOF)
+      {
+        if (tokenType == PTT_UNKNOWN)
+        {
+          break;
+        }
+        ++tokens;
+      }
+      doNotOptimize(&tokens);
+    });
+
+  remove(filename.c_str());
+}
+
+static const char* typeName(const unsigned int type)
+{
+  static const char* names[7] = { "char", "uchar", "short", "ushort", "int", "uint", "float" };
+  return names[type];
+}
+
+static void benchmarkTextures(Benchmark& bench)
+{
+  const unsigned int width  = 1024;
+  const unsigned int height = 1024;
+  const size_t elements = size_t(width) * size_t(height);
+
+  // Source is RGB without alpha, destination RGBA with alpha set to one. That's the common expansion path when loading images.
+  // The host data is filled with a byte pattern. The values don't matter for the conversion speed, except for the float source which is normalized.
+  std::vector<unsigned char> src(elements * 3 * sizeof(float));
+  std::vector<unsigned char> dst(elements * 4 * sizeof(float));
+
+  for (unsigned int srcType = 0; srcType < 7; ++srcType)
+  {
+    const unsigned int hostEncoding = ENC_RED_0 | ENC_GREEN_1 | ENC_BLUE_2 | ENC_ALPHA_NONE | ENC_LUM_NONE | ENC_CHANNELS_3 | (srcType << ENC_TYPE_SHIFT);
+
+    if (srcType == 6)
+    {
+      float* p = reinterpret_cast<float*>(src.data());
+      for (size_t i = 0; i < elements * 3; ++i)
+      {
+        p[i] = float(i & 255) / 255.0f;
+      }
+    }
+    else
+    {
+      for (size_t i = 0; i < src.size(); ++i)
+      {
+        src[i] = static_cast<unsigned char>(i * 7);
+      }
+    }
+
+    for (unsigned int dstType = 0; dstType < 7; ++dstType)
+    {
+      // Integer destinations are read as normalized fixed point by the texture units, which is what the Texture class sets up.
+      const unsigned int deviceEncoding = ENC_RED_0 | ENC_GREEN_1 | ENC_BLUE_2 | ENC_ALPHA_3 | ENC_LUM_NONE | ENC_CHANNELS_4 | ENC_ALPHA_ONE |
+                                          (dstType << ENC_TYPE_SHIFT) | ((dstType < 6) ? ENC_FIXED_POINT : 0);
+
+      const std::string name = std::string("texture/convert_rgb_") + typeName(srcType) + "_to_rgba_" + typeName(dstType);
+
+      bench.run(name, 2, double(elements), "texel",
+        [&]()
+        {
+          convertTexels(dst.data(), deviceEncoding, src.data(), hostEncoding, elements);
+          doNotOptimize(dst.data());
+        });
+    }
+  }
+
+  const unsigned int widthEnv  = 2048;
+  const unsigned int heightEnv = 1024;
+
+  std::vector<float> rgba(size_t(widthEnv) * size_t(heightEnv) * 4);
+
+  std::mt19937 rng(4711);
+  std::uniform_real_distribution<float> uniform(0.0f, 4.0f);
+  for (float& f : rgba)
+  {
+    f = uniform(rng);
+  }
+
+  std::vector<float> cdfU;
+  std::vector<float> cdfV;
+
+  bench.run("texture/spherical_cdf_2048x1024", 1, double(widthEnv) * double(heightEnv), "texel",
+    [&]()
+    {
+      const float integral = calculateSphericalCDF(rgba.data(), widthEnv, heightEnv, cdfU, cdfV);
+      doNotOptimize(&integral);
+    });
+}
+
+static void benchmarkGeometry(Benchmark& bench)
+{
+  // The tessellations match the densest runtime generated objects in the example scenes times four.
+  const unsigned int tessU = 720;
+  const unsigned int tessV = 360;
+
+  bench.run("geometry/create_sphere_720x360", 2, double(tessU) * double(tessV) * 2.0, "tri",
+    [&]()
+    {
+      sg::Triangles geometry(0);
+      geometry.createSphere(tessU, tessV, 1.0f, M_PIf);
+      doNotOptimize(geometry.getAttributes().data());
+    });
+
+  bench.run("geometry/create_torus_720x360", 2, double(tessU) * double(tessV) * 2.0, "tri",
+    [&]()
+    {
+      sg::Triangles geometry(0);
+      geometry.createTorus(tessU, tessV, 0.75f, 0.25f);
+      doNotOptimize(geometry.getAttributes().data());
+    });
+
+  bench.run("geometry/create_plane_720x360", 2, double(tessU) * double(tessV) * 2.0, "tri",
+    [&]()
+    {
+      sg::Triangles geometry(0);
+      geometry.createPlane(tessU, tessV, 1);
+      doNotOptimize(geometry.getAttributes().data());
+    });
+
+  // Tangent generation runs on a copy of the sphere attributes, the copy happens in the untimed setup.
+  sg::Triangles sphere(0);
+  sphere.createSphere(tessU, tessV, 1.0f, M_PIf);
+
+  std::vector<TriangleAttributes> attributes;
+
+  bench.run("geometry/calculate_tangents_720x360", 1, double(sphere.getIndices().size() / 3), "tri",
+    [&]()
+    {
+      attributes = sphere.getAttributes();
+    },
+    [&]()
+    {
+      calculateTangents(attributes, sphere.getIndices());
+      doNotOptimize(attributes.data());
+    });
+}
+
+static void benchmarkTonemapper(Benchmark& bench)
+{
+  const size_t count = 1920 * 1080;
+
+  std::vector<float4> src(count);
+  std::vector<uchar3> dst(count);
+
+  std::mt19937 rng(815);
+  std::uniform_real_distribution<float> uniform(0.0f, 2.0f);
+  for (float4& c : src)
+  {
+    c = make_float4(uniform(rng), uniform(rng), uniform(rng), 1.0f);
+  }
+
+  // The defaults of the Application constructor.
+  TonemapperGUI parameters;
+
+  parameters.gamma           = 2.2f;
+  parameters.whitePoint      = 1.0f;
+  parameters.colorBalance[0] = 1.0f;
+  parameters.colorBalance[1] = 1.0f;
+  parameters.colorBalance[2] = 1.0f;
+  parameters.burnHighlights  = 0.8f;
+  parameters.crushBlacks     = 0.2f;
+  parameters.saturation      = 1.2f;
+  parameters.brightness      = 0.8f;
+
+  bench.run("tonemapper/screenshot_1920x1080", 2, double(count), "pixel",
+    [&]()
+    {
+      tonemap(parameters, src.data(), dst.data(), count);
+      doNotOptimize(dst.data());
+    });
+}
+
+static void benchmarkArena(Benchmark& bench)
+{
+  const int count = 4096;
+
+  // Geometry and acceleration structure buffers: only static allocations, freed in bulk at the end.
+  bench.run("arena/static_bulk", 4, double(count), "alloc",
+    [&]()
+    {
+      cuda::ArenaAllocator allocator(64 * 1024 * 1024);
+      std::vector<CUdeviceptr> ptrs(count);
+      for (int i = 0; i < count; ++i)
+      {
+        ptrs[i] = allocator.alloc(size_t(1024 + (i & 15) * 512), 128, cuda::USAGE_STATIC);
+      }
+      for (int i = 0; i < count; ++i)
+      {
+        allocator.free(ptrs[i]);
+      }
+      doNotOptimize(&ptrs);
+    });
+
+  // Acceleration structure builds: a static output and a short lived temp buffer per build.
+  bench.run("arena/temp_interleaved", 4, double(count) * 2.0, "alloc",
+    [&]()
+    {
+      cuda::ArenaAllocator allocator(64 * 1024 * 1024);
+      std::vector<CUdeviceptr> ptrs(count);
+      for (int i = 0; i < count; ++i)
+      {
+        const CUdeviceptr temp = allocator.alloc(size_t(4096 + (i & 7) * 1024), 256, cuda::USAGE_TEMP);
+        ptrs[i] = allocator.alloc(size_t(2048 + (i & 3) * 256), 128, cuda::USAGE_STATIC);
+        allocator.free(temp);
+      }
+      for (int i = 0; i < count; ++i)
+      {
+        allocator.free(ptrs[i]);
+      }
+      doNotOptimize(&ptrs);
+    });
+
+  // Worst case for the free list: random sizes freed in random order.
+  std::vector<size_t> sizes(count);
+  std::vector<int>    order(count);
+
+  std::mt19937 rng(2021);
+  std::uniform_int_distribution<size_t> uniform(16, 64 * 1024);
+  for (int i = 0; i < count; ++i)
+  {
+    sizes[i] = uniform(rng);
+    order[i] = i;
+  }
+  std::shuffle(order.begin(), order.end(), rng);
+
+  bench.run("arena/random_free", 4, double(count), "alloc",
+    [&]()
+    {
+      cuda::ArenaAllocator allocator(64 * 1024 * 1024);
+      std::vector<CUdeviceptr> ptrs(count);
+      for (int i = 0; i < count; ++i)
+      {
+        ptrs[i] = allocator.alloc(sizes[i], 16, cuda::USAGE_STATIC);
+      }
+      for (int i = 0; i < count; ++i)
+      {
+        allocator.free(ptrs[order[i]]);
+      }
+      doNotOptimize(&ptrs);
+    });
+}
+
+
+static void benchmarkTimeView(Benchmark& bench)
+{
+  const std::string name = "time_view/analyze_1920x1080";
+  if (bench.isEnabled(name))
+  {
+    const int width  = 1920;
+    const int height = 1080;
+
+    std::mt19937 rng(77);
+    std::uniform_real_distribution<float> uniform(1000.0f, 200000.0f);
+
+    std::vector<float>        cycles(width * height);
+    std::vector<unsigned int> ids(width * height * 2);
+
+    for (size_t i = 0; i < cycles.size(); ++i)
+    {
+      cycles[i]      = uniform(rng);
+      ids[i * 2    ] = unsigned(i % 997);
+      ids[i * 2 + 1] = unsigned(i % 61);
+    }
+
+    TimeViewReport report;
+
+    bench.run(name, 1, double(width) * height, "pixel",
+      [&]()
+      {
+        analyzeTimeView(cycles, ids, width, height, 64, 64, 64, 16, report);
+        doNotOptimize(&report);
+      });
+  }
+}
+
+
+static void benchmarkHostBVH(Benchmark& bench)
+{
+  const std::string nameBuild     = "host_bvh/build_2000_instances";
+  const std::string nameIntersect = "host_bvh/intersect_2000_instances";
+  if (bench.isEnabled(nameBuild) || bench.isEnabled(nameIntersect))
+  {
+    HostBVH bvh;
+    std::vector< std::shared_ptr<sg::Triangles> > geometries;
+
+    bench.run(nameBuild, 1, 2000.0, "instance",
+      [&]()
+      {
+        buildHostBVHScene(bvh, geometries, 2000);
+      });
+
+    if (!bench.isEnabled(nameBuild))
+    {
+      buildHostBVHScene(bvh, geometries, 2000);
+    }
+
+    const std::vector<BvhRay> rays = makeHostBVHRays(1 << 18, 20.0f * std::cbrt(2000.0f / 50.0f));
+
+    bench.run(nameIntersect, 1, double(rays.size()), "ray",
+      [&]()
+      {
+        BvhHit hit;
+        size_t numHits = 0;
+
+        for (BvhRay const& ray : rays)
+        {
+          numHits += (bvh.intersect(ray, hit)) ? 1 : 0;
+        }
+        doNotOptimize(&numHits);
+      });
+  }
+}
+
+
+static void benchmarkBatch(Benchmark& bench)
+{
+  const dp::math::SimdLevel levelDefault = dp::math::getSimdLevel();
+  const dp::math::SimdLevel levels[4]    = { dp::math::SimdLevel::SCALAR, dp::math::SimdLevel::SSE, dp::math::SimdLevel::AVX2, dp::math::SimdLevel::NEON };
+
+  // One million interleaved vertices with position, tangent, normal and texcoord like TriangleAttributes.
+  const size_t count  = 1 << 20;
+  const size_t stride = 12 * sizeof(float);
+
+  std::vector<float> attributes(12 * count);
+  fillRandom(attributes, 82);
+
+  std::vector<float> matrices(12 * 65536);
+  fillRandom(matrices, 83);
+
+  std::vector<float> points(3 * count);
+
+  const float* matrix = matrices.data();
+
+  for (const dp::math::SimdLevel level : levels)
+  {
+    if (dp::math::setSimdLevel(level) != level)
+    {
+      continue;
+    }
+
+    std::string suffix = std::string("_") + dp::math::getSimdLevelName(level);
+    std::transform(suffix.begin(), suffix.end(), suffix.begin(), [](const char c) { return char(tolower(c)); });
+
+    bench.run("batch/transform_points" + suffix, 4, double(count), "point",
+      [&]()
+      {
+        dp::math::transformPoints(matrix, attributes.data(), stride, points.data(), 3 * sizeof(float), count);
+        doNotOptimize(points.data());
+      });
+
+    bench.run("batch/calculate_bounds" + suffix, 4, double(count), "point",
+      [&]()
+      {
+        float lo[3];
+        float hi[3];
+        dp::math::calculateBounds(matrix, attributes.data(), stride, count, lo, hi);
+        doNotOptimize(lo);
+        doNotOptimize(hi);
+      });
+
+    std::vector<float> concatenated(matrices.size());
+
+    bench.run("batch/concatenate_matrices" + suffix, 16, double(matrices.size() / 12), "matrix",
+      [&]()
+      {
+        dp::math::concatenateMatrices(matrix, matrices.data(), concatenated.data(), matrices.size() / 12);
+        doNotOptimize(concatenated.data());
+      });
+  }
+
+  dp::math::setSimdLevel(levelDefault);
+}
+
+
+static void benchmarkEnvFormat(Benchmark& bench)
+{
+  const std::string nameHalf   = "env_format/rgba16f_2048x1024";
+  const std::string nameRGB9E5 = "env_format/rgb9e5_2048x1024";
+  if (bench.isEnabled(nameHalf) || bench.isEnabled(nameRGB9E5))
+  {
+    const size_t count = 2048 * 1024;
+
+    std::mt19937 rng(185);
+    std::uniform_real_distribution<float> uniform(0.0f, 4.0f);
+
+    std::vector<float> rgba(count * 4);
+    for (float& f : rgba)
+    {
+      f = uniform(rng) * uniform(rng) * uniform(rng);
+    }
+
+    std::vector<unsigned short> half(count * 4);
+    std::vector<unsigned int>   rgb9e5(count);
+
+    bench.run(nameHalf, 2, double(count), "texel",
+      [&]()
+      {
+        convertToRGBA16F(half.data(), rgba.data(), count);
+        doNotOptimize(half.data());
+      });
+
+    bench.run(nameRGB9E5, 2, double(count), "texel",
+      [&]()
+      {
+        convertToRGB9E5(rgb9e5.data(), rgba.data(), count);
+        doNotOptimize(rgb9e5.data());
+      });
+  }
+}
+
+
+static void benchmarkSampleRange(Benchmark& bench)
+{
+  const std::string name = "sample_range/merge_4_devices_1920x1080";
+  if (bench.isEnabled(name))
+  {
+    const size_t numPixels = 1920 * 1080;
+
+    std::vector< std::vector<float4> > buffers(4, std::vector<float4>(numPixels, make_float4(0.5f)));
+    std::vector<float4> merged(numPixels);
+
+    const std::vector<const float4*> sources = { buffers[0].data(), buffers[1].data(), buffers[2].data(), buffers[3].data() };
+    const std::vector<unsigned int>  counts  = { 64, 64, 64, 63 };
+
+    bench.run(name, 5, double(numPixels), "pixel",
+      [&]()
+      {
+        mergeSampleRanges(merged.data(), sources, counts, numPixels);
+        doNotOptimize(merged.data());
+      });
+  }
+}
+
+
+static void benchmarkWavefrontQueue(Benchmark& bench)
+{
+  const std::string name = "wavefront_queue/sort_1920x1080";
+  if (bench.isEnabled(name))
+  {
+    const unsigned int count = 1920 * 1080;
+
+    const std::vector<unsigned int> keys = makeWavefrontKeys(count, WAVEFRONT_NUM_KEYS, 0.3f, 89);
+
+    std::vector<unsigned int> sortedQueue(count);
+
+    WavefrontCounters counters;
+
+    bench.run(name, 5, double(count), "slot",
+      [&]()
+      {
+        memset(&counters, 0, sizeof(WavefrontCounters));
+        sortWavefrontQueue(keys.data(), count, counters, sortedQueue.data());
+        doNotOptimize(sortedQueue.data());
+      });
+  }
+}
+
+
+static void benchmarkBufferCache(Benchmark& bench)
+{
+  const std::string name = "buffer_cache/resize_churn";
+  if (bench.isEnabled(name))
+  {
+    const int count = 4096;
+
+    // Output, tile and time view buffer of a window resized by a few pixels per frame. Only the bookkeeping is measured,
+    // the host backend doesn't have the cost of cuMemAlloc() on a device.
+    std::vector<size_t> sizes(count * 3);
+    for (int i = 0; i < count; ++i)
+    {
+      const size_t width  = 1920 + (i & 63);
+      const size_t height = 1080 + ((i >> 3) & 31);
+
+      sizes[i * 3    ] = 16 * width * height;
+      sizes[i * 3 + 1] = 16 * (width / 2) * height;
+      sizes[i * 3 + 2] = 4 * width * height;
+    }
+
+    BufferCache cache;
+
+    bench.run(name, 1, double(count) * 3.0, "alloc",
+      [&]()
+      {
+        CUdeviceptr ptrs[3] = { 0, 0, 0 };
+        for (int i = 0; i < count; ++i)
+        {
+          for (int j = 0; j < 3; ++j)
+          {
+            cache.free(ptrs[j]);
+            ptrs[j] = cache.alloc(sizes[i * 3 + j]);
+          }
+        }
+        for (int j = 0; j < 3; ++j)
+        {
+          cache.free(ptrs[j]);
+        }
+      });
+
+    cache.trim();
+  }
+}
+
+
+// Host stand-in of the accumulation writes of a launch. The warps cover 8x4 launch indices, which read, blend and write
+// their pixels in the linear rows of the resolution or the contiguous 8x8 tiles. The host caches hold a whole row of warps,
+// so this mainly shows the cost of the index math. The transaction savings over PCIe or NVLINK need a device to measure.
+// The detiling costs of the present and host output paths of the tiled layout are measured separately.
+static void benchmarkTileLayout(Benchmark& bench)
+{
+  const int2   resolution = make_int2(1920, 1080);
+  const int2   tileSize   = make_int2(8, 8);
+  const int2   tileShift  = make_int2(3, 3);
+  const size_t numPixels  = size_t(resolution.x) * resolution.y;
+  const int    tilesX     = tileCount(resolution, tileShift).x;
+
+  std::vector<float4> linear(numPixels, make_float4(0.5f, 0.5f, 0.5f, 1.0f));
+  std::vector<float4> tiled(getTiledBufferSize(resolution, tileSize), make_float4(0.5f, 0.5f, 0.5f, 1.0f));
+
+  const float4 radiance = make_float4(1.0f, 0.25f, 0.125f, 1.0f);
+
+  bench.run("tile_layout/accumulate_linear_1920x1080", 2, double(sizeof(float4) * numPixels), "byte",
+    [&]()
+    {
+      for (int yWarp = 0; yWarp < resolution.y; yWarp += 4)
+      {
+        for (int xWarp = 0; xWarp < resolution.x; xWarp += 8)
+        {
+          for (int y = yWarp; y < std::min(yWarp + 4, resolution.y); ++y)
+          {
+            for (int x = xWarp; x < xWarp + 8; ++x)
+            {
+              float4& dst = linear[size_t(y) * resolution.x + x];
+              dst = lerp(dst, radiance, 0.125f);
+            }
+          }
+        }
+      }
+      doNotOptimize(linear.data());
+    });
+
+  bench.run("tile_layout/accumulate_tiled_1920x1080", 2, double(sizeof(float4) * numPixels), "byte",
+    [&]()
+    {
+      for (int yWarp = 0; yWarp < resolution.y; yWarp += 4)
+      {
+        for (int xWarp = 0; xWarp < resolution.x; xWarp += 8)
+        {
+          for (int y = yWarp; y < std::min(yWarp + 4, resolution.y); ++y)
+          {
+            for (int x = xWarp; x < xWarp + 8; ++x)
+            {
+              float4& dst = tiled[tiledIndex(x, y, tilesX, tileShift)];
+              dst = lerp(dst, radiance, 0.125f);
+            }
+          }
+        }
+      }
+      doNotOptimize(tiled.data());
+    });
+
+  bench.run("tile_layout/detile_1920x1080", 4, double(sizeof(float4) * numPixels), "byte",
+    [&]()
+    {
+      detileHost(linear.data(), tiled.data(), resolution, tileSize);
+      doNotOptimize(linear.data());
+    });
+
+  bench.run("tile_layout/retile_1920x1080", 4, double(sizeof(float4) * numPixels), "byte",
+    [&]()
+    {
+      retileHost(tiled.data(), linear.data(), resolution, tileSize);
+      doNotOptimize(tiled.data());
+    });
+}
+
+
+static void benchmarkParameterChannel(Benchmark& bench)
+{
+  const std::string name = "parameter_channel/slider_drag_frame";
+  if (bench.isEnabled(name))
+  {
+    ParameterChannel channel;
+
+    channel.setCameras(std::vector<CameraDefinition>(1));
+    channel.setLights(std::vector<LightDefinition>(16));
+    channel.setMaterials(std::vector<MaterialGUI>(256, makeMaterial(1.5f)));
+    channel.publish();
+
+    ParameterDiff diff;
+    float ior = 1.0f;
+
+    // One frame of a material slider drag: the GUI edits a few times, four devices pick up the coalesced diff.
+    bench.run(name, 1000, 1.0, "frame",
+      [&]()
+      {
+        for (int i = 0; i < 4; ++i)
+        {
+          ior += 0.001f;
+          channel.setMaterial(17, makeMaterial(ior));
+        }
+        channel.publish();
+
+        for (int device = 0; device < 4; ++device)
+        {
+          channel.acquire(device, diff);
+        }
+        doNotOptimize(&diff);
+      });
+  }
+}
+
+
+static void benchmarkReplay(Benchmark& bench)
+{
+  const std::string name = "replay/cpu_standin_frame_locked";
+  if (bench.isEnabled(name))
+  {
+    InputTrace recorded;
+    InputTrace trace;
+
+    recordInputTrace(recorded);
+
+    if (!saveAndLoadInputTrace(recorded, trace))
+    {
+      std::cerr << "ERROR: benchmarkReplay() failed to save and load the trace\n";
+      return;
+    }
+
+    std::unique_ptr<InputReplay> replay;
+
+    bench.run(name, 1, 600.0, "frame",
+      [&]()
+      {
+      },
+      [&]()
+      {
+        replayInputTrace(trace.getEvents(), replay);
+      });
+
+    std::cout << replay->getReport();
+  }
+}
+
+
+static void benchmarkScene(Benchmark& bench)
+{
+  const std::string nameSerial   = "scene/interpret_serial";
+  const std::string nameParallel = "scene/interpret_parallel";
+  if (bench.isEnabled(nameSerial) || bench.isEnabled(nameParallel))
+  {
+    const int instances = 20000;
+
+    const std::string filename = "rtigo3_bench_models.txt";
+    writeSceneModels(filename, instances);
+
+    const unsigned int numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    SceneResult result;
+
+    // The unknown material warnings of the missing references go to std::cerr on every run.
+    std::streambuf* bufferCerr = std::cerr.rdbuf(nullptr);
+
+    // The whole loadSceneDescription() work including lexing the file.
+    bench.run(nameSerial, 1, double(instances), "inst",
+      [&]()
+      {
+        result = SceneResult(); // Untimed destruction of the previous scene.
+      },
+      [&]()
+      {
+        interpretScene(filename, 1, result);
+      });
+
+    bench.run(nameParallel, 1, double(instances), "inst",
+      [&]()
+      {
+        result = SceneResult();
+      },
+      [&]()
+      {
+        interpretScene(filename, numThreads, result);
+      });
+
+    std::cerr.rdbuf(bufferCerr);
+
+    remove(filename.c_str());
+  }
+}
+
+
+static void printUsage(const char* argv0)
+{
+  std::cerr << "\nUsage: " << argv0 << " [options]\n"
+    "App Options:\n"
+    "   ? | help | --help     Print this usage message and exit.\n"
+    "  -f | --filter <text>   Only run benchmarks with names containing text.\n"
+    "  -w | --warmups <n>     Untimed warmup repetitions per benchmark (default 2).\n"
+    "  -r | --repetitions <n> Timed repetitions per benchmark (default 11).\n"
+    "  -s | --scale <factor>  Scale the iterations per repetition (default 1.0).\n"
+    "  -j | --json <filename> Write the results as JSON.\n"
+  << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+  Benchmark bench;
+
+  std::string filenameJSON;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string arg(argv[i]);
+
+    if (arg == "?" || arg == "help" || arg == "--help")
+    {
+      printUsage(argv[0]);
+      return 0;
+    }
+    else if ((arg == "-f" || arg == "--filter") && i + 1 < argc)
+    {
+      bench.setFilter(argv[++i]);
+    }
+    else if ((arg == "-w" || arg == "--warmups") && i + 1 < argc)
+    {
+      bench.setWarmups(atoi(argv[++i]));
+    }
+    else if ((arg == "-r" || arg == "--repetitions") && i + 1 < argc)
+    {
+      bench.setRepetitions(atoi(argv[++i]));
+    }
+    else if ((arg == "-s" || arg == "--scale") && i + 1 < argc)
+    {
+      bench.setScale(atof(argv[++i]));
+    }
+    else if ((arg == "-j" || arg == "--json") && i + 1 < argc)
+    {
+      filenameJSON = argv[++i];
+    }
+    else
+    {
+      std::cerr << "ERROR: Unknown option '" << arg << "'" << std::endl;
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  try
+  {
+    benchmarkParser(bench);
+    benchmarkTextures(bench);
+    benchmarkGeometry(bench);
+    benchmarkTonemapper(bench);
+    benchmarkArena(bench);
+    benchmarkTimeView(bench);
+    benchmarkHostBVH(bench);
+    benchmarkBatch(bench);
+    benchmarkEnvFormat(bench);
+    benchmarkSampleRange(bench);
+    benchmarkWavefrontQueue(bench);
+    benchmarkBufferCache(bench);
+    benchmarkTileLayout(bench);
+    benchmarkParameterChannel(bench);
+    benchmarkReplay(bench);
+    benchmarkScene(bench);
+  }
+  catch (std::exception const& e)
+  {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return 1;
+  }
+
+  if (!filenameJSON.empty() && !bench.writeJSON(filenameJSON))
+  {
+    return 1;
+  }
+
+  return 0;
+}
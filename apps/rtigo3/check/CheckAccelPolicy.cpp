@@ -0,0 +1,152 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "check/Checks.h"
+
+#include "inc/AccelPolicy.h"
+
+#include <iostream>
+#include <string>
+
+
+static AccelRequest makeAccelRequest(const size_t numTriangles, const size_t numInstances, const size_t sizeFastTrace, const size_t sizeFastBuild,
+                                     const size_t budgetRemaining)
+{
+  AccelRequest request;
+
+  request.numTriangles    = numTriangles;
+  request.numInstances    = numInstances;
+  request.sizeFastTrace   = sizeFastTrace;
+  request.sizeFastBuild   = sizeFastBuild;
+  request.budgetTotal     = 1000; // The default reserve of 0.1 keeps 100 bytes free.
+  request.budgetRemaining = budgetRemaining;
+
+  return request;
+}
+
+static bool isAccelDecision(AccelDecision const& decision, const bool fastTrace, const bool compaction, const bool allowUpdate, const char* reason)
+{
+  return decision.fastTrace == fastTrace && decision.fastBuild == !fastTrace && decision.compaction == compaction &&
+         decision.allowUpdate == allowUpdate && std::string(decision.reason) == reason;
+}
+
+// Returns false when the GAS build decisions don't switch at the configured thresholds or an exhausted budget isn't handled.
+bool checkAccelPolicy()
+{
+  const size_t maxSize = ~size_t(0);
+
+  AccelPolicy policy;
+
+  const AccelDecision fixed = decideAccelBuild(policy, makeAccelRequest(1000000, 10, 100, 50, 900));
+  if (fixed.fastTrace || fixed.fastBuild || fixed.compaction || fixed.allowUpdate || std::string(fixed.reason) != "fixed")
+  {
+    std::cerr << "ERROR: checkAccelPolicy() accelPolicy 0\n";
+    return false;
+  }
+
+  policy.mode        = 1;
+  policy.allowUpdate = 1;
+
+  struct Case
+  {
+    const char*  name;
+    AccelRequest request;
+    bool         fastTrace;
+    bool         compaction;
+    bool         allowUpdate;
+    const char*  reason;
+  };
+
+  const Case cases[] =
+  {
+    // Fast trace switches at fastTraceTriangles (100000) triangles times instances. Unreferenced GAS count as one instance.
+    { "below fast trace",      makeAccelRequest( 99999, 1, 200, 100, 900), false, true,  true,  "fast build, small geometry" },
+    { "at fast trace",         makeAccelRequest(100000, 1, 200, 100, 900), true,  true,  true,  "fast trace" },
+    { "instanced below",       makeAccelRequest( 25000, 3, 200, 100, 900), false, true,  true,  "fast build, small geometry" },
+    { "instanced at",          makeAccelRequest( 25000, 4, 200, 100, 900), true,  true,  true,  "fast trace" },
+    { "unreferenced",          makeAccelRequest(100000, 0, 200, 100, 900), true,  true,  true,  "fast trace" },
+    { "weight overflow",       makeAccelRequest(maxSize / 2, 3, 200, 100, 900), true, true, true, "fast trace" },
+    // Compaction switches at compactionTriangles (10000) as long as the budget isn't tight.
+    { "below compaction",      makeAccelRequest(  9999, 1, 200, 100, 900), false, false, true,  "fast build, small geometry" },
+    { "at compaction",         makeAccelRequest( 10000, 1, 200, 100, 900), false, true,  true,  "fast build, small geometry" },
+    // Tight means less than twice the reserve left after the build. Compaction is forced and ALLOW_UPDATE dropped then.
+    { "not tight",             makeAccelRequest(  5000, 1, 900, 700, 900), false, false, true,  "fast build, small geometry" },
+    { "tight",                 makeAccelRequest(  5000, 1, 900, 701, 900), false, true,  false, "fast build, tight budget" },
+    { "fast trace tight",      makeAccelRequest(200000, 1, 701, 100, 900), true,  true,  false, "fast trace, tight budget" },
+    // Fast trace must keep the reserve free, else the smaller fast build is used.
+    { "fast trace too big",    makeAccelRequest(200000, 1, 801, 100, 900), false, true,  true,  "fast build, fast trace exceeds budget" },
+    // Over budget and exhausted budgets get the smallest configuration.
+    { "over budget",           makeAccelRequest(200000, 1, 900, 801, 900), false, true,  false, "over budget" },
+    { "exhausted",             makeAccelRequest(     1, 1,   0,   0,   0), false, true,  false, "over budget" },
+    { "size overflow",         makeAccelRequest(200000, 1, maxSize, maxSize, 900), false, true, false, "over budget" },
+  };
+
+  for (Case const& c : cases)
+  {
+    if (!isAccelDecision(decideAccelBuild(policy, c.request), c.fastTrace, c.compaction, c.allowUpdate, c.reason))
+    {
+      std::cerr << "ERROR: checkAccelPolicy() case '" << c.name << "'\n";
+      return false;
+    }
+  }
+
+  if (fitsAccelBudget(maxSize, 0, 10) || fitsAccelBudget(5, maxSize, 10) || !fitsAccelBudget(5, 5, 10) || fitsAccelBudget(6, 5, 10))
+  {
+    std::cerr << "ERROR: checkAccelPolicy() fitsAccelBudget\n";
+    return false;
+  }
+
+  // Building GAS until the budget is exhausted. The remaining budget must never wrap around.
+  size_t remaining = 1000;
+  int    exhausted = -1;
+
+  for (int i = 0; i < 10; ++i)
+  {
+    const AccelDecision decision = decideAccelBuild(policy, makeAccelRequest(200000, 1, 300, 150, remaining));
+
+    const size_t size = (decision.fastTrace) ? 300 : 150;
+
+    if (!consumeAccelBudget(remaining, size) && exhausted < 0)
+    {
+      exhausted = i;
+    }
+    if (1000 < remaining || (0 <= exhausted && (remaining != 0 || !isAccelDecision(decideAccelBuild(policy, makeAccelRequest(200000, 1, 300, 150, remaining)), false, true, false, "over budget"))))
+    {
+      std::cerr << "ERROR: checkAccelPolicy() budget accounting after " << i << " builds\n";
+      return false;
+    }
+  }
+
+  // Three fast trace builds of 300 bytes leave only the reserve. The fourth build is over budget and exhausts it.
+  if (exhausted != 3)
+  {
+    std::cerr << "ERROR: checkAccelPolicy() budget exhausted after " << exhausted << " builds\n";
+    return false;
+  }
+  return true;
+}
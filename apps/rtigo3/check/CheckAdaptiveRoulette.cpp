@@ -0,0 +1,194 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "check/Checks.h"
+
+#include "shaders/adaptive_roulette.h"
+#include "shaders/vector_math.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+// Returns false when the adaptive Russian roulette and splitting change the expected path weight, leave the weight
+// window, or the roulette cache indexing does not cover the tiles.
+bool checkAdaptiveRoulette()
+{
+  // The window is centered at the reference and continuing paths keep their weight.
+  const float lower = 2.0f / (1.0f + ROULETTE_WINDOW);
+  const float upper = ROULETTE_WINDOW * lower;
+
+  if (1.0e-6f < fabsf(0.5f * (lower + upper) - 1.0f) || rouletteFactor(1.0f, 1.0f) != 1.0f ||
+      rouletteFactor(lower, 1.0f) != 1.0f || rouletteFactor(upper, 1.0f) != 1.0f)
+  {
+    std::cerr << "ERROR: checkAdaptiveRoulette() weight window [" << lower << ", " << upper << "]\n";
+    return false;
+  }
+
+  // Expected weight of the continuation for ratios between expected and reference radiance over seven decades.
+  // Survival returns weight 1 / factor with probability factor, splitting factor branches on average with weight 1 / factor each.
+  // Stratified random numbers give the expectation up to one stratum over the factor, the random ones check the estimator as it is used.
+  const int numStrata = 1 << 16;
+
+  std::mt19937 rng(94);
+  std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+
+  double maxErrorStratified = 0.0;
+  double maxErrorRandom     = 0.0; // In standard deviations.
+
+  for (int i = 0; i <= 70; ++i)
+  {
+    const float ratio  = powf(10.0f, -4.0f + 0.1f * float(i));
+    const float factor = rouletteFactor(ratio * 3.0f, 3.0f);
+
+    if (factor < ROULETTE_MIN_SURVIVAL || ROULETTE_MAX_SPLIT < factor)
+    {
+      std::cerr << "ERROR: checkAdaptiveRoulette() factor " << factor << " out of range for ratio " << ratio << '\n';
+      return false;
+    }
+
+    // Unclamped factors move the path weight to the reference.
+    if (factor != 1.0f && ROULETTE_MIN_SURVIVAL < factor && factor < ROULETTE_MAX_SPLIT && 1.0e-5f < fabsf(ratio / factor - 1.0f))
+    {
+      std::cerr << "ERROR: checkAdaptiveRoulette() weight " << ratio / factor << " after factor " << factor << '\n';
+      return false;
+    }
+
+    // Weight of one path continuation for the random number u.
+    auto weight = [factor](const float u) -> double
+    {
+      if (factor < 1.0f)
+      {
+        return (factor < u) ? 0.0 : 1.0 / double(factor); // Same termination test as the ray generation.
+      }
+      return double(rouletteBranches(factor, u)) / double(factor);
+    };
+
+    double sum = 0.0;
+    for (int k = 0; k < numStrata; ++k)
+    {
+      sum += weight((float(k) + 0.5f) / float(numStrata));
+    }
+
+    const double errorStratified = fabs(sum / double(numStrata) - 1.0);
+
+    if (1.0 / (double(numStrata) * double(factor)) < errorStratified)
+    {
+      std::cerr << "ERROR: checkAdaptiveRoulette() expected weight " << sum / double(numStrata) << " for factor " << factor << '\n';
+      return false;
+    }
+    maxErrorStratified = std::max(maxErrorStratified, errorStratified);
+
+    const int numSamples = 100000;
+
+    double sumRandom   = 0.0;
+    double sumSquared  = 0.0;
+    for (int k = 0; k < numSamples; ++k)
+    {
+      const double w = weight(uniform(rng));
+
+      sumRandom  += w;
+      sumSquared += w * w;
+    }
+
+    const double mean     = sumRandom / double(numSamples);
+    const double variance = std::max(sumSquared / double(numSamples) - mean * mean, 0.0);
+    const double sigma    = sqrt(variance / double(numSamples));
+
+    if (0.0 < sigma)
+    {
+      maxErrorRandom = std::max(maxErrorRandom, fabs(mean - 1.0) / sigma);
+    }
+    else if (mean != 1.0)
+    {
+      maxErrorRandom = HUGE_VAL;
+    }
+  }
+
+  if (5.0 < maxErrorRandom)
+  {
+    std::cerr << "ERROR: checkAdaptiveRoulette() expected weight off by " << maxErrorRandom << " standard deviations\n";
+    return false;
+  }
+
+  // Integral split factors are deterministic.
+  for (int n = 1; n <= int(ROULETTE_MAX_SPLIT); ++n)
+  {
+    if (rouletteBranches(float(n), 0.0f) != n || rouletteBranches(float(n), 0.999999f) != n)
+    {
+      std::cerr << "ERROR: checkAdaptiveRoulette() " << rouletteBranches(float(n), 0.0f) << " branches for factor " << n << '\n';
+      return false;
+    }
+  }
+
+  // Every pixel maps to the first depth entry of its own tile inside the cache.
+  for (const int2 resolution : { make_int2(1, 1), make_int2(1920, 1080), make_int2(33, 31), make_int2(64, 65) })
+  {
+    const int2 tiles = rouletteTiles(resolution);
+
+    std::vector<int> counts(tiles.x * tiles.y, 0);
+
+    for (int y = 0; y < resolution.y; ++y)
+    {
+      for (int x = 0; x < resolution.x; ++x)
+      {
+        const int index = rouletteIndex(tiles, x, y);
+
+        if (index < 0 || int(counts.size()) * ROULETTE_DEPTHS <= index || index % ROULETTE_DEPTHS != 0)
+        {
+          std::cerr << "ERROR: checkAdaptiveRoulette() cache index " << index << " for pixel (" << x << ", " << y << ")\n";
+          return false;
+        }
+        ++counts[index / ROULETTE_DEPTHS];
+      }
+    }
+
+    for (const int count : counts)
+    {
+      if (count == 0 || ROULETTE_TILE_SIZE * ROULETTE_TILE_SIZE < count)
+      {
+        std::cerr << "ERROR: checkAdaptiveRoulette() tile with " << count << " pixels at resolution " << resolution.x << "x" << resolution.y << '\n';
+        return false;
+      }
+    }
+  }
+
+  if (rouletteCacheEntry(make_float2(10.0f, ROULETTE_MIN_SAMPLES - 1.0f)) != -1.0f ||
+      rouletteCacheEntry(make_float2(8.0f * ROULETTE_MIN_SAMPLES, ROULETTE_MIN_SAMPLES)) != 8.0f)
+  {
+    std::cerr << "ERROR: checkAdaptiveRoulette() cache entry from the sample statistics\n";
+    return false;
+  }
+
+  std::cout << "adaptive_roulette: max expected weight error " << maxErrorStratified << " stratified, "
+            << maxErrorRandom << " standard deviations over 100000 random paths per factor\n";
+  return true;
+}
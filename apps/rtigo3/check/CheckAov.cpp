@@ -0,0 +1,455 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "check/Checks.h"
+
+#include "bench/Fixtures.h"
+
+#include "inc/Aov.h"
+#include "inc/EnvFormat.h"
+
+#include "shaders/aov_definition.h"
+#include "shaders/vector_math.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+
+struct ExpectedChannel
+{
+  const char*  name;
+  ExrPixelType type;
+  int          index;     // AovIndex of the source buffer, -1 for the beauty output and -2 for the derived indirect lighting.
+  int          component; // Element of the source pixel.
+};
+
+// All channels getAovChannels() produces, in the sorted order of the EXR channel list.
+static const ExpectedChannel expectedChannels[] =
+{
+  { "A",           EXR_PIXEL_FLOAT, -1,                  3 },
+  { "B",           EXR_PIXEL_FLOAT, -1,                  2 },
+  { "G",           EXR_PIXEL_FLOAT, -1,                  1 },
+  { "R",           EXR_PIXEL_FLOAT, -1,                  0 },
+  { "Z",           EXR_PIXEL_FLOAT, AOV_INDEX_DEPTH,     0 },
+  { "albedo.B",    EXR_PIXEL_HALF,  AOV_INDEX_ALBEDO,    2 },
+  { "albedo.G",    EXR_PIXEL_HALF,  AOV_INDEX_ALBEDO,    1 },
+  { "albedo.R",    EXR_PIXEL_HALF,  AOV_INDEX_ALBEDO,    0 },
+  { "direct.B",    EXR_PIXEL_FLOAT, AOV_INDEX_DIRECT,    2 },
+  { "direct.G",    EXR_PIXEL_FLOAT, AOV_INDEX_DIRECT,    1 },
+  { "direct.R",    EXR_PIXEL_FLOAT, AOV_INDEX_DIRECT,    0 },
+  { "indirect.B",  EXR_PIXEL_FLOAT, -2,                  2 },
+  { "indirect.G",  EXR_PIXEL_FLOAT, -2,                  1 },
+  { "indirect.R",  EXR_PIXEL_FLOAT, -2,                  0 },
+  { "instanceId",  EXR_PIXEL_UINT,  AOV_INDEX_INSTANCE,  0 },
+  { "materialId",  EXR_PIXEL_UINT,  AOV_INDEX_MATERIAL,  0 },
+  { "normal.X",    EXR_PIXEL_HALF,  AOV_INDEX_NORMAL,    0 },
+  { "normal.Y",    EXR_PIXEL_HALF,  AOV_INDEX_NORMAL,    1 },
+  { "normal.Z",    EXR_PIXEL_HALF,  AOV_INDEX_NORMAL,    2 },
+  { "primitiveId", EXR_PIXEL_UINT,  AOV_INDEX_PRIMITIVE, 0 }
+};
+
+// Reads the values of an OpenEXR file in memory. Sets failed instead of reading beyond the end.
+class ExrReader
+{
+public:
+  ExrReader(std::vector<char> const& data)
+  : m_data(data)
+  , m_offset(0)
+  , m_failed(false)
+  {
+  }
+
+  template <typename T>
+  T read()
+  {
+    T value = T();
+    if (m_data.size() < m_offset + sizeof(T))
+    {
+      m_failed = true;
+      return value;
+    }
+    memcpy(&value, m_data.data() + m_offset, sizeof(T));
+    m_offset += sizeof(T);
+    return value;
+  }
+
+  std::string readString()
+  {
+    std::string str;
+    while (m_offset < m_data.size() && m_data[m_offset] != 0)
+    {
+      str += m_data[m_offset++];
+    }
+    if (m_data.size() <= m_offset)
+    {
+      m_failed = true;
+      return str;
+    }
+    ++m_offset; // Terminating null.
+    return str;
+  }
+
+  std::vector<char> readBytes(const size_t size)
+  {
+    if (m_data.size() < m_offset + size)
+    {
+      m_failed = true;
+      return std::vector<char>();
+    }
+    m_offset += size;
+    return std::vector<char>(m_data.begin() + (m_offset - size), m_data.begin() + m_offset);
+  }
+
+  size_t getOffset() const
+  {
+    return m_offset;
+  }
+
+  bool hasFailed() const
+  {
+    return m_failed;
+  }
+
+private:
+  std::vector<char> const& m_data;
+  size_t                   m_offset;
+  bool                     m_failed;
+};
+
+struct ExrAttribute
+{
+  std::string       type;
+  std::vector<char> value;
+};
+
+template <typename T>
+static std::vector<char> toBytes(std::initializer_list<T> values)
+{
+  std::vector<char> bytes;
+  for (const T value : values)
+  {
+    const char* p = reinterpret_cast<const char*>(&value);
+    bytes.insert(bytes.end(), p, p + sizeof(T));
+  }
+  return bytes;
+}
+
+// Writes one AOV file with the channels of the given mask and parses it back. Returns an empty string when
+// the header, the offset table and every scanline match the source buffers.
+static std::string checkExrFile(const unsigned int aovMask, const int width, const int height,
+                                std::vector<float4> const& beauty, std::vector<unsigned char> const* aovs)
+{
+  const size_t numPixels = size_t(width) * height;
+
+  std::vector<float4>     indirect;
+  std::vector<ExrChannel> channels;
+
+  getAovChannels(aovMask, beauty.data(), aovs, numPixels, indirect, channels);
+
+  std::vector<ExpectedChannel> expected;
+  for (ExpectedChannel const& channel : expectedChannels)
+  {
+    const int bit = (channel.index == -2) ? AOV_INDEX_DIRECT : channel.index;
+    if (channel.index == -1 || (aovMask & (1u << bit)))
+    {
+      expected.push_back(channel);
+    }
+  }
+  if (channels.size() != expected.size())
+  {
+    return std::to_string(channels.size()) + " channels instead of " + std::to_string(expected.size());
+  }
+
+  const std::string filename = "rtigo3_check_aov.exr";
+  if (!saveEXR(filename, width, height, channels))
+  {
+    return "saveEXR() failed";
+  }
+
+  std::ifstream stream(filename, std::ios::binary);
+  std::vector<char> data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+  stream.close();
+  remove(filename.c_str());
+
+  ExrReader reader(data);
+
+  if (reader.read<int32_t>() != 20000630 || reader.read<int32_t>() != 2)
+  {
+    return "wrong magic number or version";
+  }
+
+  std::map<std::string, ExrAttribute> attributes;
+  while (!reader.hasFailed())
+  {
+    const std::string name = reader.readString();
+    if (name.empty())
+    {
+      break; // End of header.
+    }
+    ExrAttribute attribute;
+    attribute.type  = reader.readString();
+    attribute.value = reader.readBytes(size_t(reader.read<int32_t>()));
+    attributes[name] = attribute;
+  }
+  if (reader.hasFailed())
+  {
+    return "truncated header";
+  }
+
+  // The attributes required in every OpenEXR header.
+  const std::vector<char> window = toBytes<int32_t>({ 0, 0, width - 1, height - 1 });
+
+  const struct
+  {
+    const char*       name;
+    const char*       type;
+    std::vector<char> value;
+  } required[] =
+  {
+    { "compression",        "compression", std::vector<char>(1, 0) },
+    { "dataWindow",         "box2i",       window },
+    { "displayWindow",      "box2i",       window },
+    { "lineOrder",          "lineOrder",   std::vector<char>(1, 0) },
+    { "pixelAspectRatio",   "float",       toBytes<float>({ 1.0f }) },
+    { "screenWindowCenter", "v2f",         toBytes<float>({ 0.0f, 0.0f }) },
+    { "screenWindowWidth",  "float",       toBytes<float>({ 1.0f }) }
+  };
+  for (auto const& attribute : required)
+  {
+    auto it = attributes.find(attribute.name);
+    if (it == attributes.end() || it->second.type != attribute.type || it->second.value != attribute.value)
+    {
+      return std::string("attribute ") + attribute.name;
+    }
+  }
+
+  auto it = attributes.find("channels");
+  if (it == attributes.end() || it->second.type != "chlist" || attributes.size() != 8)
+  {
+    return "missing channel list or unexpected attributes";
+  }
+
+  ExrReader list(it->second.value);
+
+  size_t bytesPerLine = 0;
+  for (ExpectedChannel const& channel : expected)
+  {
+    if (list.readString() != channel.name || list.read<int32_t>() != int32_t(channel.type) ||
+        list.read<uint32_t>() != 0 || list.read<int32_t>() != 1 || list.read<int32_t>() != 1)
+    {
+      return std::string("channel list entry ") + channel.name;
+    }
+    bytesPerLine += ((channel.type == EXR_PIXEL_HALF) ? 2 : 4) * size_t(width);
+  }
+  if (list.read<char>() != 0 || list.getOffset() != it->second.value.size() || list.hasFailed())
+  {
+    return "channel list not terminated";
+  }
+
+  // The offset table points to the scanline chunks, which follow each other without gaps up to the end of the file.
+  const size_t firstLine = reader.getOffset() + sizeof(uint64_t) * height;
+  const size_t sizeChunk = sizeof(int32_t) * 2 + bytesPerLine;
+  for (int y = 0; y < height; ++y)
+  {
+    if (reader.read<uint64_t>() != firstLine + y * sizeChunk)
+    {
+      return "offset of scanline " + std::to_string(y);
+    }
+  }
+  if (data.size() != firstLine + height * sizeChunk)
+  {
+    return "file size";
+  }
+
+  for (int y = 0; y < height; ++y)
+  {
+    if (reader.read<int32_t>() != y || reader.read<int32_t>() != int32_t(bytesPerLine))
+    {
+      return "chunk header of scanline " + std::to_string(y);
+    }
+
+    const size_t row = size_t(height - 1 - y); // Scanline 0 is the top of the image, rtigo3 row 0 is the bottom.
+
+    for (ExpectedChannel const& channel : expected)
+    {
+      for (int x = 0; x < width; ++x)
+      {
+        const size_t i = row * width + x;
+
+        bool matches = false;
+        if (channel.type == EXR_PIXEL_HALF)
+        {
+          // The device packs the normal and albedo with __float2half_rn(). The writer must pass the bits through unchanged.
+          const unsigned short source = reinterpret_cast<const unsigned short*>(aovs[channel.index].data())[i * 4 + channel.component];
+          matches = (reader.read<unsigned short>() == source);
+        }
+        else if (channel.type == EXR_PIXEL_UINT)
+        {
+          matches = (reader.read<uint32_t>() == reinterpret_cast<const uint32_t*>(aovs[channel.index].data())[i]);
+        }
+        else
+        {
+          float source;
+          switch (channel.index)
+          {
+            case -1:
+              source = reinterpret_cast<const float*>(&beauty[i])[channel.component];
+              break;
+            case -2:
+              source = std::max(0.0f, reinterpret_cast<const float*>(&beauty[i])[channel.component] -
+                                      reinterpret_cast<const float*>(aovs[AOV_INDEX_DIRECT].data())[i * 4 + channel.component]);
+              break;
+            default:
+              source = reinterpret_cast<const float*>(aovs[channel.index].data())[i * getAovElementSize(channel.index) / sizeof(float) + channel.component];
+              break;
+          }
+          const float value = reader.read<float>();
+          matches = (memcmp(&value, &source, sizeof(float)) == 0);
+        }
+        if (!matches || reader.hasFailed())
+        {
+          return std::string("channel ") + channel.name + " at pixel " + std::to_string(x) + ", " + std::to_string(row);
+        }
+      }
+    }
+  }
+  return std::string();
+}
+
+// Returns false when the AOV channel packing or the EXR file doesn't reproduce the source buffers bit exactly,
+// the half packing loses more than half precision, or the multi-GPU merge of the AOV buffers is lossy.
+bool checkAov()
+{
+  // Odd resolutions check the scanline order and the row strides.
+  const int2 resolutions[] = { make_int2(1, 1), make_int2(37, 23), make_int2(128, 3) };
+  const unsigned int masks[] = { 0, AOV_ALBEDO | AOV_PRIMITIVE, AOV_DEPTH | AOV_DIRECT, AOV_NORMAL | AOV_INSTANCE | AOV_MATERIAL, (1u << NUM_AOVS) - 1 };
+
+  std::mt19937 rng(83);
+  std::uniform_real_distribution<float>        uniform(0.0f, 1.0f);
+  std::uniform_int_distribution<unsigned int> ids(0, 0xFFFFFFFFu);
+
+  int    numFiles     = 0;
+  double maxHalfError = 0.0;
+
+  for (const int2 resolution : resolutions)
+  {
+    const size_t numPixels = size_t(resolution.x) * resolution.y;
+
+    std::vector<float4>        beauty(numPixels);
+    std::vector<unsigned char> aovs[NUM_AOVS];
+
+    for (int i = 0; i < NUM_AOVS; ++i)
+    {
+      aovs[i].resize(getAovElementSize(i) * numPixels);
+    }
+
+    float*          depth  = reinterpret_cast<float*>(aovs[AOV_INDEX_DEPTH].data());
+    ushort4*        normal = reinterpret_cast<ushort4*>(aovs[AOV_INDEX_NORMAL].data());
+    ushort4*        albedo = reinterpret_cast<ushort4*>(aovs[AOV_INDEX_ALBEDO].data());
+    float4*         direct = reinterpret_cast<float4*>(aovs[AOV_INDEX_DIRECT].data());
+    unsigned int*   id[3]  = { reinterpret_cast<unsigned int*>(aovs[AOV_INDEX_INSTANCE].data()),
+                               reinterpret_cast<unsigned int*>(aovs[AOV_INDEX_MATERIAL].data()),
+                               reinterpret_cast<unsigned int*>(aovs[AOV_INDEX_PRIMITIVE].data()) };
+
+    for (size_t i = 0; i < numPixels; ++i)
+    {
+      beauty[i] = make_float4(4.0f * uniform(rng), 4.0f * uniform(rng), 4.0f * uniform(rng), 1.0f);
+      direct[i] = make_float4(2.0f * uniform(rng), 2.0f * uniform(rng), 2.0f * uniform(rng), 1.0f);
+      depth[i]  = (i % 5 == 0) ? 0.0f : 1000.0f * uniform(rng); // Misses are 0.0f.
+
+      const float3 n = normalize(make_float3(uniform(rng) - 0.5f, uniform(rng) - 0.5f, uniform(rng) - 0.5f));
+      const float3 a = make_float3(uniform(rng), uniform(rng), uniform(rng));
+
+      // Same packing as the raygeneration program: three components and 1.0f in w.
+      normal[i] = make_ushort4(floatToHalf(n.x), floatToHalf(n.y), floatToHalf(n.z), floatToHalf(1.0f));
+      albedo[i] = make_ushort4(floatToHalf(a.x), floatToHalf(a.y), floatToHalf(a.z), floatToHalf(1.0f));
+
+      for (int c = 0; c < 3; ++c)
+      {
+        const float source  = (c == 0) ? n.x : (c == 1) ? n.y : n.z;
+        const float decoded = halfToFloat(reinterpret_cast<const unsigned short*>(&normal[i])[c]);
+        maxHalfError = std::max(maxHalfError, double(fabsf(decoded - source)));
+
+        id[c][i] = (i % 7 == 0) ? 0u : ids(rng); // 0 is a miss, the IDs are stored + 1.
+      }
+    }
+
+    // 11 mantissa bits on values below 1.0f.
+    if (ldexpf(1.0f, -11) < maxHalfError || halfToFloat(normal[0].w) != 1.0f)
+    {
+      std::cerr << "ERROR: checkAov() half packing error " << maxHalfError << '\n';
+      return false;
+    }
+
+    for (const unsigned int mask : masks)
+    {
+      const std::string error = checkExrFile(mask, resolution.x, resolution.y, beauty, aovs);
+      if (!error.empty())
+      {
+        std::cerr << "ERROR: checkAov() " << error << " with mask 0x" << std::hex << mask << std::dec
+                  << " at " << resolution.x << "x" << resolution.y << '\n';
+        return false;
+      }
+      ++numFiles;
+    }
+
+    // Two devices rendering alternating rows leave the other rows zero. Merging both restores every AOV.
+    for (int i = 0; i < NUM_AOVS; ++i)
+    {
+      const size_t rowSize = getAovElementSize(i) * resolution.x;
+
+      std::vector<unsigned char> device[2] = { aovs[i], aovs[i] };
+      for (int y = 0; y < resolution.y; ++y)
+      {
+        memset(device[y & 1].data() + y * rowSize, 0, rowSize);
+      }
+
+      std::vector<unsigned char> merged;
+      accumulateAov(merged, device[0]);
+      accumulateAov(merged, device[1]);
+
+      if (merged != aovs[i])
+      {
+        std::cerr << "ERROR: checkAov() merge of " << getAovOptionName(i) << " at " << resolution.x << "x" << resolution.y << '\n';
+        return false;
+      }
+    }
+  }
+
+  std::cout << "aov: " << numFiles << " EXR files with all channels bit exact, max half error " << maxHalfError << '\n';
+  return true;
+}
@@ -0,0 +1,139 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "check/Checks.h"
+#include "bench/Fixtures.h"
+
+#include <dp/math/Batch.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+
+// Runs all batch functions at the active SIMD level on count elements with the given strides in floats.
+static void runBatch(const float matrix[12], std::vector<float> const& src, const size_t srcStride, const size_t dstStride, const size_t count,
+                     std::vector<float>& results)
+{
+  const size_t size = dstStride * count + 3;
+
+  std::vector<float> points(size, 0.0f);
+  std::vector<float> vectors(size, 0.0f);
+  std::vector<float> normals(size, 0.0f);
+  std::vector<float> inPlace(src.begin(), src.begin() + srcStride * count + 3);
+  std::vector<float> matrices(src.begin(), src.begin() + 12 * (count / 4 + 1));
+
+  dp::math::transformPoints(matrix, src.data(), srcStride * sizeof(float), points.data(), dstStride * sizeof(float), count);
+  dp::math::transformVectors(matrix, src.data(), srcStride * sizeof(float), vectors.data(), dstStride * sizeof(float), count);
+  dp::math::transformNormals(matrix, src.data(), srcStride * sizeof(float), normals.data(), dstStride * sizeof(float), count);
+  dp::math::transformPoints(matrix, inPlace.data(), srcStride * sizeof(float), inPlace.data(), srcStride * sizeof(float), count);
+  dp::math::concatenateMatrices(matrix, matrices.data(), matrices.data(), count / 4 + 1);
+
+  float bounds[12] = { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f };
+  const bool isBounded            = dp::math::calculateBounds(nullptr, src.data(), srcStride * sizeof(float), count, &bounds[0], &bounds[3]);
+  const bool isBoundedTransformed = dp::math::calculateBounds(matrix,  src.data(), srcStride * sizeof(float), count, &bounds[6], &bounds[9]);
+
+  results.clear();
+  results.insert(results.end(), points.begin(), points.end());
+  results.insert(results.end(), vectors.begin(), vectors.end());
+  results.insert(results.end(), normals.begin(), normals.end());
+  results.insert(results.end(), inPlace.begin(), inPlace.end());
+  results.insert(results.end(), matrices.begin(), matrices.end());
+  results.insert(results.end(), bounds, bounds + 12);
+  results.push_back((isBounded) ? 1.0f : 0.0f);
+  results.push_back((isBoundedTransformed) ? 1.0f : 0.0f);
+}
+
+// Returns false when a SIMD level of the dp::math batch functions isn't bit identical to the scalar fallback.
+// The counts cover every tail length of the four and eight wide paths.
+bool checkBatch()
+{
+  const dp::math::SimdLevel levelDefault = dp::math::getSimdLevel();
+  const dp::math::SimdLevel levels[3]    = { dp::math::SimdLevel::SSE, dp::math::SimdLevel::AVX2, dp::math::SimdLevel::NEON };
+
+  float matrix[12];
+  std::vector<float> random(12);
+  fillRandom(random, 80);
+  std::copy(random.begin(), random.end(), matrix);
+
+  std::vector<float> src(8 * 1100);
+  fillRandom(src, 81);
+
+  const size_t strides[3] = { 3, 4, 8 }; // Tight float3, float4 and interleaved vertex attributes.
+
+  std::vector<size_t> counts;
+  for (size_t count = 0; count <= 40; ++count)
+  {
+    counts.push_back(count);
+  }
+  counts.push_back(1021);
+  counts.push_back(1024);
+
+  bool isValid = true;
+
+  for (const dp::math::SimdLevel level : levels)
+  {
+    if (dp::math::setSimdLevel(level) != level)
+    {
+      std::cout << "batch: " << dp::math::getSimdLevelName(level) << " not supported, skipped\n";
+      continue;
+    }
+
+    for (const size_t srcStride : strides)
+    {
+      for (const size_t dstStride : strides)
+      {
+        for (const size_t count : counts)
+        {
+          std::vector<float> reference;
+          std::vector<float> results;
+
+          dp::math::setSimdLevel(dp::math::SimdLevel::SCALAR);
+          runBatch(matrix, src, srcStride, dstStride, count, reference);
+          dp::math::setSimdLevel(level);
+          runBatch(matrix, src, srcStride, dstStride, count, results);
+
+          if (isValid && memcmp(reference.data(), results.data(), sizeof(float) * reference.size()) != 0)
+          {
+            std::cerr << "ERROR: checkBatch() " << dp::math::getSimdLevelName(level) << " differs from scalar for count " << count
+                      << ", strides " << srcStride << ", " << dstStride << '\n';
+            isValid = false;
+          }
+        }
+      }
+    }
+    if (isValid)
+    {
+      std::cout << "batch: " << dp::math::getSimdLevelName(level) << " bit identical to scalar\n";
+    }
+  }
+
+  dp::math::setSimdLevel(levelDefault);
+  return isValid;
+}
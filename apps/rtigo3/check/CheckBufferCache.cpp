@@ -0,0 +1,136 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "check/Checks.h"
+
+#include "inc/BufferCache.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+
+
+// Returns false when the BufferCache violates its size class, reuse or retention rules.
+bool checkBufferCache()
+{
+  for (size_t size = 1; size < (size_t(1) << 28); size = size * 3 / 2 + 1)
+  {
+    const size_t sizeClass = BufferCache::getSizeClass(size);
+    if (sizeClass < size || (sizeClass & 255) != 0 || size + size / 3 + 256 < sizeClass ||
+        BufferCache::getSizeClass(sizeClass) != sizeClass || BufferCache::getSizeClass(size + 1) < sizeClass)
+    {
+      std::cerr << "ERROR: checkBufferCache() size class " << sizeClass << " for " << size << '\n';
+      return false;
+    }
+  }
+
+  BufferCache cache;
+
+  // A freed block is returned by the next allocation of the same size class.
+  const CUdeviceptr a = cache.alloc(1920 * 1080 * 16);
+  cache.free(a);
+  const CUdeviceptr b = cache.alloc(1921 * 1080 * 16);
+  if (a != b || cache.getStatistics().hits != 1 || cache.getStatistics().misses != 1)
+  {
+    std::cerr << "ERROR: checkBufferCache() no reuse\n";
+    return false;
+  }
+  cache.free(b);
+
+  // Interactive resizing with a few live buffers per resolution. The cache must stay within the high-water mark.
+  std::mt19937 rng(98);
+  std::uniform_int_distribution<int> uniform(-64, 64);
+
+  std::map<CUdeviceptr, size_t> live;
+
+  int width  = 1920;
+  int height = 1080;
+  for (int i = 0; i < 2000; ++i)
+  {
+    for (std::map<CUdeviceptr, size_t>::const_iterator it = live.begin(); it != live.end(); ++it)
+    {
+      cache.free(it->first);
+    }
+    live.clear();
+
+    width  = std::max(64, width  + uniform(rng));
+    height = std::max(64, height + uniform(rng));
+
+    const size_t sizes[3] = { size_t(16) * width * height, size_t(16) * (width / 2) * height, size_t(12) * width * height };
+    for (const size_t size : sizes)
+    {
+      const CUdeviceptr ptr = cache.alloc(size);
+      if (!live.insert(std::make_pair(ptr, size)).second)
+      {
+        std::cerr << "ERROR: checkBufferCache() pointer returned twice\n";
+        return false;
+      }
+    }
+
+    // Blocks of live buffers must not overlap.
+    CUdeviceptr end = 0;
+    size_t bytesInUse = 0;
+    for (std::map<CUdeviceptr, size_t>::const_iterator it = live.begin(); it != live.end(); ++it)
+    {
+      if (it->first < end)
+      {
+        std::cerr << "ERROR: checkBufferCache() overlapping blocks\n";
+        return false;
+      }
+      end = it->first + it->second;
+      bytesInUse += BufferCache::getSizeClass(it->second);
+    }
+
+    BufferCacheStatistics const& statistics = cache.getStatistics();
+    if (statistics.bytesInUse != bytesInUse || statistics.bytesHighWater < statistics.bytesInUse + statistics.bytesCached)
+    {
+      std::cerr << "ERROR: checkBufferCache() retention above the high-water mark\n";
+      return false;
+    }
+  }
+
+  for (std::map<CUdeviceptr, size_t>::const_iterator it = live.begin(); it != live.end(); ++it)
+  {
+    cache.free(it->first);
+  }
+
+  BufferCacheStatistics const& statistics = cache.getStatistics();
+
+  std::cout << "buffer_cache: " << statistics.hits << " hits, " << statistics.misses << " misses, " << statistics.evictions << " evictions, "
+            << (statistics.bytesHighWater >> 20) << " MiB high-water\n";
+
+  cache.trim();
+  if (cache.getStatistics().bytesCached != 0 || cache.getStatistics().bytesHighWater != 0)
+  {
+    std::cerr << "ERROR: checkBufferCache() trim\n";
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,153 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "check/Checks.h"
+
+#include "bench/Fixtures.h"
+
+#include "inc/EnvFormat.h"
+
+#include "shaders/env_format_definition.h"
+#include "shaders/vector_math.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+// Returns false when the compact environment formats don't round correctly, the SSE2 conversions differ from the scalar ones,
+// or the conversion errors exceed their bounds.
+bool checkEnvFormat()
+{
+  // Every finite half value round-trips, and the midpoints between neighbours round to the even mantissa.
+  for (unsigned int h = 0; h < 0x7BFF; ++h)
+  {
+    for (const unsigned short sign : { 0x0000, 0x8000 })
+    {
+      const unsigned short h0 = static_cast<unsigned short>(h | sign);
+      const unsigned short h1 = static_cast<unsigned short>((h + 1) | sign);
+
+      const float f0 = halfToFloat(h0);
+      const float f1 = halfToFloat(h1);
+      const float midpoint = 0.5f * (f0 + f1); // Exact, the midpoint needs one more mantissa bit only.
+
+      const unsigned short even = (h & 1) ? h1 : h0;
+
+      if (floatToHalf(f0) != h0 || floatToHalf(midpoint) != even ||
+          floatToHalf(nextafterf(midpoint, f0)) != h0 || floatToHalf(nextafterf(midpoint, f1)) != h1)
+      {
+        std::cerr << "ERROR: checkEnvFormat() half rounding at 0x" << std::hex << h0 << std::dec << '\n';
+        return false;
+      }
+    }
+  }
+
+  if (floatToHalf(65504.0f) != 0x7BFF || floatToHalf(65520.0f) != 0x7BFF || floatToHalf(INFINITY) != 0x7BFF || floatToHalf(-INFINITY) != 0xFBFF ||
+      (floatToHalf(NAN) & 0x7FFF) != 0x7E00)
+  {
+    std::cerr << "ERROR: checkEnvFormat() half clamping\n";
+    return false;
+  }
+
+  // Random radiance over the whole range plus the special values, with a count which leaves tails for both SSE2 loops.
+  std::mt19937 rng(85);
+  std::uniform_real_distribution<float> uniformExponent(-20.0f, 17.0f);
+  std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+
+  const size_t count = 100003;
+
+  std::vector<float> rgba(count * 4);
+  for (float& f : rgba)
+  {
+    f = exp2f(uniformExponent(rng)) * uniform(rng);
+  }
+
+  const float specials[] = { 0.0f, -0.0f, -1.0f, NAN, INFINITY, -INFINITY, 1.0e-40f, 65504.0f, 65520.0f, 1.0e30f, RGB9E5_MAX_VALUE, 0.5f };
+  for (size_t i = 0; i < 4096; ++i)
+  {
+    rgba[i] = specials[(i * 7 + i / 4) % (sizeof(specials) / sizeof(float))];
+  }
+
+  std::vector<unsigned short> half(count * 4);
+  std::vector<unsigned int>   rgb9e5(count);
+
+  convertToRGBA16F(half.data(), rgba.data(), count);
+  convertToRGB9E5(rgb9e5.data(), rgba.data(), count);
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    for (size_t c = 0; c < 4; ++c)
+    {
+      if (half[i * 4 + c] != floatToHalf(rgba[i * 4 + c]))
+      {
+        std::cerr << "ERROR: checkEnvFormat() RGBA16F conversion differs from floatToHalf() at texel " << i << '\n';
+        return false;
+      }
+    }
+    if (rgb9e5[i] != encodeRGB9E5(rgba[i * 4], rgba[i * 4 + 1], rgba[i * 4 + 2]))
+    {
+      std::cerr << "ERROR: checkEnvFormat() RGB9E5 conversion differs from encodeRGB9E5() at texel " << i << '\n';
+      return false;
+    }
+  }
+
+  // Error bounds on the normal ranges of both formats. RGB9E5 stays within half a mantissa step of the shared exponent,
+  // which is 2^-9 of the brightest channel, or slightly more when the rounding of the brightest channel bumps the exponent.
+  for (size_t i = 4096; i < count; ++i)
+  {
+    const float* c = &rgba[i * 4];
+
+    for (size_t j = 0; j < 4; ++j)
+    {
+      if (ldexpf(1.0f, -14) <= c[j] && c[j] <= 65504.0f && ldexpf(c[j], -11) < fabsf(halfToFloat(half[i * 4 + j]) - c[j]))
+      {
+        std::cerr << "ERROR: checkEnvFormat() RGBA16F error at texel " << i << '\n';
+        return false;
+      }
+    }
+
+    const float  maxRGB  = std::max(c[0], std::max(c[1], c[2]));
+    const float3 decoded = decodeRGB9E5(rgb9e5[i]);
+
+    if (ldexpf(1.0f, -15) <= maxRGB && maxRGB <= RGB9E5_MAX_VALUE &&
+        ldexpf(maxRGB, -9) * (1.0f + ldexpf(1.0f, -9)) < std::max(fabsf(decoded.x - c[0]), std::max(fabsf(decoded.y - c[1]), fabsf(decoded.z - c[2]))))
+    {
+      std::cerr << "ERROR: checkEnvFormat() RGB9E5 error at texel " << i << '\n';
+      return false;
+    }
+  }
+
+  if (getEnvFormatElementSize(ENV_FORMAT_RGBA32F) != 16 || getEnvFormatElementSize(ENV_FORMAT_RGBA16F) != 8 || getEnvFormatElementSize(ENV_FORMAT_RGB9E5) != 4)
+  {
+    std::cerr << "ERROR: checkEnvFormat() element sizes\n";
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,374 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "check/Checks.h"
+
+#include "inc/GltfLoader.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+// Binary buffer of the synthetic glTF model. Tightly packed positions, interleaved normals and texture coordinates,
+// 16-bit triangle indices, 8-bit strip indices and the instance translations.
+static std::vector<unsigned char> makeGltfBuffer()
+{
+  const float positions[12]  = { 0.0f, 0.0f, 0.0f,  1.0f, 0.0f, 0.0f,  1.0f, 1.0f, 0.0f,  0.0f, 1.0f, 0.0f };
+  const float texcoords[8]   = { 0.0f, 0.0f,  1.0f, 0.0f,  1.0f, 1.0f,  0.0f, 0.25f };
+  const unsigned short triangles[6] = { 0, 1, 2, 0, 2, 3 };
+  const unsigned char  strip[4]     = { 0, 1, 3, 2 };
+  const float translations[6] = { 10.0f, 0.0f, 0.0f,  -10.0f, 0.0f, 0.0f };
+
+  std::vector<unsigned char> buffer(168, 0);
+
+  memcpy(&buffer[0], positions, sizeof(positions));
+  for (int i = 0; i < 4; ++i)
+  {
+    const float normal[3] = { 0.0f, 0.0f, 1.0f };
+    memcpy(&buffer[48 + i * 20], normal, sizeof(normal));
+    memcpy(&buffer[48 + i * 20 + 12], &texcoords[i * 2], sizeof(float) * 2);
+  }
+  memcpy(&buffer[128], triangles, sizeof(triangles));
+  memcpy(&buffer[140], strip, sizeof(strip));
+  memcpy(&buffer[144], translations, sizeof(translations));
+
+  return buffer;
+}
+
+// glTF description of makeGltfBuffer() with the given JSON for its single buffer.
+static std::string makeGltfJson(std::string const& buffer)
+{
+  return std::string("{\"asset\":{\"version\":\"2.0\"},\"extensionsUsed\":[\"EXT_mesh_gpu_instancing\"],"
+    "\"buffers\":[") + buffer + "],"
+    "\"bufferViews\":["
+      "{\"buffer\":0,\"byteOffset\":0,\"byteLength\":48},"
+      "{\"buffer\":0,\"byteOffset\":48,\"byteLength\":80,\"byteStride\":20},"
+      "{\"buffer\":0,\"byteOffset\":128,\"byteLength\":12},"
+      "{\"buffer\":0,\"byteOffset\":140,\"byteLength\":4},"
+      "{\"buffer\":0,\"byteOffset\":144,\"byteLength\":24}],"
+    "\"accessors\":["
+      "{\"bufferView\":0,\"componentType\":5126,\"count\":4,\"type\":\"VEC3\"},"
+      "{\"bufferView\":1,\"componentType\":5126,\"count\":4,\"type\":\"VEC3\"},"
+      "{\"bufferView\":1,\"byteOffset\":12,\"componentType\":5126,\"count\":4,\"type\":\"VEC2\"},"
+      "{\"bufferView\":2,\"componentType\":5123,\"count\":6,\"type\":\"SCALAR\"},"
+      "{\"bufferView\":3,\"componentType\":5121,\"count\":4,\"type\":\"SCALAR\"},"
+      "{\"bufferView\":4,\"componentType\":5126,\"count\":2,\"type\":\"VEC3\"}],"
+    "\"materials\":[{\"name\":\"red\",\"pbrMetallicRoughness\":{\"baseColorFactor\":[1.0,0.0,0.0,1.0]}}],"
+    "\"meshes\":["
+      "{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"NORMAL\":1,\"TEXCOORD_0\":2},\"indices\":3,\"material\":0},"
+                       "{\"attributes\":{\"POSITION\":0},\"mode\":0}]},"
+      "{\"primitives\":[{\"attributes\":{\"POSITION\":0},\"indices\":4,\"mode\":5}]},"
+      "{\"primitives\":[{\"attributes\":{\"POSITION\":0},\"mode\":6}]}],"
+    "\"nodes\":["
+      "{\"name\":\"root\",\"translation\":[1.0,2.0,3.0],\"children\":[1,2]},"
+      "{\"mesh\":0,\"matrix\":[2.0,0.0,0.0,0.0, 0.0,2.0,0.0,0.0, 0.0,0.0,2.0,0.0, 4.0,5.0,6.0,1.0]},"
+      "{\"mesh\":1,\"extensions\":{\"EXT_mesh_gpu_instancing\":{\"attributes\":{\"TRANSLATION\":5}}}},"
+      "{\"mesh\":2,\"rotation\":[0.0,0.0,0.70710678,0.70710678]}],"
+    "\"scene\":0,\"scenes\":[{\"nodes\":[0,3]}]}";
+}
+
+static std::string encodeBase64(std::vector<unsigned char> const& data)
+{
+  const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+  std::string text;
+  for (size_t i = 0; i < data.size(); i += 3)
+  {
+    const unsigned int bits = (data[i] << 16) | ((i + 1 < data.size()) ? data[i + 1] << 8 : 0) | ((i + 2 < data.size()) ? data[i + 2] : 0);
+
+    text += alphabet[(bits >> 18) & 63];
+    text += alphabet[(bits >> 12) & 63];
+    text += (i + 1 < data.size()) ? alphabet[(bits >> 6) & 63] : '=';
+    text += (i + 2 < data.size()) ? alphabet[bits & 63] : '=';
+  }
+  return text;
+}
+
+static std::string makeGlb(std::string json, std::vector<unsigned char> bin)
+{
+  json.resize((json.size() + 3) & ~size_t(3), ' ');
+  bin.resize((bin.size() + 3) & ~size_t(3), 0);
+
+  const unsigned int header[3]    = { 0x46546C67, 2, static_cast<unsigned int>(12 + 8 + json.size() + 8 + bin.size()) };
+  const unsigned int chunkJson[2] = { static_cast<unsigned int>(json.size()), 0x4E4F534A };
+  const unsigned int chunkBin[2]  = { static_cast<unsigned int>(bin.size()), 0x004E4942 };
+
+  std::string glb(reinterpret_cast<const char*>(header), sizeof(header));
+  glb.append(reinterpret_cast<const char*>(chunkJson), sizeof(chunkJson));
+  glb += json;
+  glb.append(reinterpret_cast<const char*>(chunkBin), sizeof(chunkBin));
+  glb.append(reinterpret_cast<const char*>(bin.data()), bin.size());
+  return glb;
+}
+
+static void writeFile(std::string const& filename, std::string const& contents)
+{
+  std::ofstream(filename, std::ios::binary).write(contents.data(), contents.size());
+}
+
+// Loads filename and reads all primitives. Returns false when the load fails.
+// readPrimitive() results are appended to results, an empty entry for a failed primitive.
+// quiet suppresses the loader's error messages of the intentionally broken models.
+static bool loadGltf(std::string const& filename, GltfLoader& loader, std::vector< std::pair< std::vector<TriangleAttributes>, std::vector<unsigned int> > >& results,
+                     const bool quiet)
+{
+  std::streambuf* errors = std::cerr.rdbuf();
+  if (quiet)
+  {
+    std::cerr.rdbuf(nullptr);
+  }
+
+  const bool loaded = loader.load(filename);
+
+  for (size_t i = 0; i < loader.m_meshes.size() && loaded; ++i)
+  {
+    for (GltfPrimitive const& primitive : loader.m_meshes[i].primitives)
+    {
+      results.push_back(std::make_pair(std::vector<TriangleAttributes>(), std::vector<unsigned int>()));
+      if (!loader.readPrimitive(primitive, results.back().first, results.back().second))
+      {
+        results.back().first.clear();
+        results.back().second.clear();
+      }
+    }
+  }
+
+  std::cerr.rdbuf(errors);
+  return loaded;
+}
+
+static bool isNear(const float* a, const float* b, const int count)
+{
+  for (int i = 0; i < count; ++i)
+  {
+    if (1.0e-6f < fabsf(a[i] - b[i]))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns false when the glTF loader reads the synthetic model differently from what it describes,
+// gives different results for GLB, external and embedded buffers, or accepts truncated, out of bounds or corrupted input.
+bool checkGltfLoader()
+{
+  const std::vector<unsigned char> bin = makeGltfBuffer();
+
+  const std::string filenameGlb  = "rtigo3_check_model.glb";
+  const std::string filenameGltf = "rtigo3_check_model.gltf";
+  const std::string filenameData = "rtigo3_check_model_data.gltf";
+  const std::string filenameBin  = "rtigo3_check_model.bin";
+  const std::string filenameBad  = "rtigo3_check_model_bad.gltf";
+
+  const std::string glb = makeGlb(makeGltfJson("{\"byteLength\":168}"), bin);
+
+  writeFile(filenameGlb, glb);
+  writeFile(filenameGltf, makeGltfJson("{\"byteLength\":168,\"uri\":\"rtigo3_check_model.bin\"}"));
+  writeFile(filenameData, makeGltfJson("{\"byteLength\":168,\"uri\":\"data:application/octet-stream;base64," + encodeBase64(bin) + "\"}"));
+  writeFile(filenameBin, std::string(reinterpret_cast<const char*>(bin.data()), bin.size()));
+
+  bool success = true;
+
+  std::vector< std::pair< std::vector<TriangleAttributes>, std::vector<unsigned int> > > reference;
+
+  for (std::string const& filename : { filenameGlb, filenameGltf, filenameData })
+  {
+    GltfLoader loader;
+
+    std::vector< std::pair< std::vector<TriangleAttributes>, std::vector<unsigned int> > > results;
+
+    if (!loadGltf(filename, loader, results, false) || results.size() != 3 ||
+        loader.m_meshes.size() != 3 || loader.m_nodes.size() != 4 || loader.m_roots != std::vector<int>({ 0, 3 }) ||
+        loader.m_materials.size() != 1 || loader.m_materials[0].name != "red" || loader.m_materials[0].baseColor.x != 1.0f || loader.m_materials[0].baseColor.y != 0.0f)
+    {
+      std::cerr << "ERROR: checkGltfLoader() " << filename << " structure\n";
+      success = false;
+      break;
+    }
+
+    // Node transforms: translation, column-major matrix, instancing and rotation.
+    const float root[12]     = { 1.0f, 0.0f, 0.0f, 1.0f,  0.0f, 1.0f, 0.0f, 2.0f,  0.0f, 0.0f, 1.0f, 3.0f };
+    const float matrix[12]   = { 2.0f, 0.0f, 0.0f, 4.0f,  0.0f, 2.0f, 0.0f, 5.0f,  0.0f, 0.0f, 2.0f, 6.0f };
+    const float rotation[12] = { 0.0f, -1.0f, 0.0f, 0.0f,  1.0f, 0.0f, 0.0f, 0.0f,  0.0f, 0.0f, 1.0f, 0.0f };
+    const float instance[12] = { 1.0f, 0.0f, 0.0f, -10.0f,  0.0f, 1.0f, 0.0f, 0.0f,  0.0f, 0.0f, 1.0f, 0.0f };
+
+    if (!isNear(loader.m_nodes[0].matrix, root, 12) || loader.m_nodes[0].children != std::vector<int>({ 1, 2 }) || loader.m_nodes[0].mesh != -1 ||
+        !isNear(loader.m_nodes[1].matrix, matrix, 12) || !isNear(loader.m_nodes[3].matrix, rotation, 12) ||
+        loader.m_nodes[2].instances.size() != 24 || !isNear(&loader.m_nodes[2].instances[12], instance, 12) ||
+        !loader.m_nodes[1].instances.empty() || loader.m_meshes[0].primitives.size() != 1 || loader.m_meshes[0].primitives[0].material != 0)
+    {
+      std::cerr << "ERROR: checkGltfLoader() " << filename << " nodes\n";
+      success = false;
+      break;
+    }
+
+    // Triangle list with 16-bit indices, strip with 8-bit indices and generated normals, fan without indices.
+    const std::vector<unsigned int> expected[3] = { { 0, 1, 2, 0, 2, 3 }, { 0, 1, 3, 1, 2, 3 }, { 0, 1, 2, 0, 2, 3 } };
+
+    for (int i = 0; i < 3 && success; ++i)
+    {
+      std::vector<TriangleAttributes> const& attributes = results[i].first;
+
+      success = (results[i].second == expected[i] && attributes.size() == 4);
+
+      for (size_t v = 0; v < attributes.size() && success; ++v)
+      {
+        const float position[3] = { float(v == 1 || v == 2), float(2 <= v), 0.0f };
+
+        success = isNear(&attributes[v].vertex.x, position, 3) && fabsf(attributes[v].normal.z - 1.0f) < 1.0e-6f &&
+                  attributes[v].tangent.x == 0.0f && (i != 0 || attributes[v].texcoord.y == ((v == 3) ? 0.75f : 1.0f - float(v == 2)));
+      }
+      if (!success)
+      {
+        std::cerr << "ERROR: checkGltfLoader() " << filename << " primitive " << i << '\n';
+      }
+    }
+    if (!success)
+    {
+      break;
+    }
+
+    // The three buffer sources must give bit identical results.
+    if (reference.empty())
+    {
+      reference = results;
+    }
+    for (size_t i = 0; i < results.size() && success; ++i)
+    {
+      success = results[i].second == reference[i].second && results[i].first.size() == reference[i].first.size() &&
+                memcmp(results[i].first.data(), reference[i].first.data(), sizeof(TriangleAttributes) * results[i].first.size()) == 0;
+      if (!success)
+      {
+        std::cerr << "ERROR: checkGltfLoader() " << filename << " differs from the GLB\n";
+      }
+    }
+  }
+
+  // Every truncated GLB is rejected.
+  for (size_t size = 0; size < glb.size() && success; ++size)
+  {
+    writeFile(filenameBad, glb.substr(0, size));
+
+    GltfLoader loader;
+    std::vector< std::pair< std::vector<TriangleAttributes>, std::vector<unsigned int> > > results;
+
+    if (loadGltf(filenameBad, loader, results, true))
+    {
+      std::cerr << "ERROR: checkGltfLoader() accepted a GLB truncated to " << size << " bytes\n";
+      success = false;
+    }
+  }
+
+  // Invalid descriptions the load must reject, and invalid accessors readPrimitive() must reject.
+  const std::string json = makeGltfJson("{\"byteLength\":168,\"uri\":\"rtigo3_check_model.bin\"}");
+
+  const struct
+  {
+    const char* from;
+    const char* to;
+    bool        load; // Expected load() result. When true, the first primitive must fail.
+  } edits[] =
+  {
+    { "\"byteOffset\":144,\"byteLength\":24", "\"byteOffset\":148,\"byteLength\":24", false }, // Buffer view beyond the buffer.
+    { "{\"byteLength\":168,", "{\"byteLength\":169,", false },                                 // Buffer beyond the file.
+    { "rtigo3_check_model.bin", "rtigo3_check_missing.bin", false },
+    { "\"version\":\"2.0\"", "\"version\":\"1.0\"", false },
+    { "\"children\":[1,2]", "\"children\":[1,4]", false },
+    { "\"extensionsUsed\"", "\"extensionsRequired\":[\"KHR_draco_mesh_compression\"],\"extensionsUsed\"", false },
+    { "\"TRANSLATION\":5", "\"TRANSLATION\":6", false },
+    { "\"count\":4,\"type\":\"VEC3\"}", "\"count\":5,\"type\":\"VEC3\"}", true },            // Positions beyond their view.
+    { "\"count\":6,\"type\":\"SCALAR\"", "\"count\":7,\"type\":\"SCALAR\"", true },         // Indices beyond their view.
+    { "\"byteStride\":20", "\"byteStride\":8", true },                                       // Stride smaller than the element.
+    { "\"indices\":3,", "\"indices\":9,", true },
+    { "\"NORMAL\":1,", "\"NORMAL\":2,", true },                                               // VEC2 normals.
+  };
+
+  for (size_t i = 0; i < sizeof(edits) / sizeof(edits[0]) && success; ++i)
+  {
+    std::string text = json;
+    text.replace(text.find(edits[i].from), strlen(edits[i].from), edits[i].to);
+    writeFile(filenameBad, text);
+
+    GltfLoader loader;
+    std::vector< std::pair< std::vector<TriangleAttributes>, std::vector<unsigned int> > > results;
+
+    const bool loaded = loadGltf(filenameBad, loader, results, true);
+    if (loaded != edits[i].load || (loaded && !results[0].second.empty()))
+    {
+      std::cerr << "ERROR: checkGltfLoader() accepted the edit " << edits[i].to << '\n';
+      success = false;
+    }
+  }
+
+  // Strip index out of range in the binary buffer.
+  if (success)
+  {
+    std::string data(reinterpret_cast<const char*>(bin.data()), bin.size());
+    data[141] = 4;
+    writeFile(filenameBad, makeGlb(makeGltfJson("{\"byteLength\":168}"), std::vector<unsigned char>(data.begin(), data.end())));
+
+    GltfLoader loader;
+    std::vector< std::pair< std::vector<TriangleAttributes>, std::vector<unsigned int> > > results;
+
+    if (!loadGltf(filenameBad, loader, results, true) || !results[1].second.empty() || results[0].second.empty())
+    {
+      std::cerr << "ERROR: checkGltfLoader() accepted an out of range strip index\n";
+      success = false;
+    }
+  }
+
+  // Random byte corruption must never crash, whatever the loader decides.
+  std::mt19937 rng(90);
+  for (int i = 0; i < 2000 && success; ++i)
+  {
+    std::string corrupted = glb;
+    for (int j = 0; j < 4; ++j)
+    {
+      corrupted[rng() % corrupted.size()] = static_cast<char>(rng());
+    }
+    writeFile(filenameBad, corrupted);
+
+    GltfLoader loader;
+    std::vector< std::pair< std::vector<TriangleAttributes>, std::vector<unsigned int> > > results;
+    loadGltf(filenameBad, loader, results, true);
+  }
+
+  for (std::string const& filename : { filenameGlb, filenameGltf, filenameData, filenameBin, filenameBad })
+  {
+    std::remove(filename.c_str());
+  }
+  return success;
+}
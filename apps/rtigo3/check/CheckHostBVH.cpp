@@ -0,0 +1,101 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "check/Checks.h"
+#include "bench/Fixtures.h"
+
+#include "inc/HostBVH.h"
+#include "inc/SceneGraph.h"
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+
+// Returns false when the closest hits of the BVH traversal differ from the brute force reference.
+bool checkHostBVH()
+{
+  HostBVH bvh;
+  std::vector< std::shared_ptr<sg::Triangles> > geometries;
+
+  buildHostBVHScene(bvh, geometries, 50);
+
+  // Every triangle of every instance is intersected by the reference, so keep the ray count small.
+  const std::vector<BvhRay> rays = makeHostBVHRays(4000, 20.0f);
+
+  size_t numHits = 0;
+
+  for (size_t i = 0; i < rays.size(); ++i)
+  {
+    BvhHit hit;
+    BvhHit reference;
+
+    const bool isHit       = bvh.intersect(rays[i], hit);
+    const bool isReference = bvh.intersectBruteForce(rays[i], reference);
+
+    // The same triangle test runs in both, only the order of the tests differs. Equal distances can pick either primitive.
+    if (isHit != isReference ||
+        (isHit && (hit.t != reference.t || hit.t < rays[i].tmin || rays[i].tmax < hit.t)) ||
+        (!isHit && hit.instance != -1))
+    {
+      std::cerr << "ERROR: checkHostBVH() ray " << i << ": BVH " << isHit << " t = " << hit.t << " instance = " << hit.instance
+                << ", brute force " << isReference << " t = " << reference.t << " instance = " << reference.instance << '\n';
+      return false;
+    }
+    numHits += (isHit) ? 1 : 0;
+  }
+
+  // Both outcomes must be covered for the comparison to mean something.
+  if (numHits < rays.size() / 10 || rays.size() - rays.size() / 10 < numHits)
+  {
+    std::cerr << "ERROR: checkHostBVH() " << numHits << " hits of " << rays.size() << " rays\n";
+    return false;
+  }
+
+  BvhAabb bounds;
+  if (!bvh.getBounds(bounds) || bvh.getInstanceBounds(int(bvh.getNumInstances()) - 2, bounds) || bvh.getInstanceBounds(int(bvh.getNumInstances()), bounds))
+  {
+    std::cerr << "ERROR: checkHostBVH() bounds of empty, singular or invalid instances\n";
+    return false;
+  }
+
+  // The BVH owns copies of all mesh triangles.
+  size_t numTriangles = 0;
+  for (std::shared_ptr<sg::Triangles> const& geometry : geometries)
+  {
+    numTriangles += geometry->getIndices().size() / 3;
+  }
+  if (bvh.getMemoryUsage() < numTriangles * (sizeof(BvhTriangle) + sizeof(unsigned int)))
+  {
+    std::cerr << "ERROR: checkHostBVH() memory usage doesn't count the triangle copies\n";
+    return false;
+  }
+
+  std::cout << "host_bvh: " << numHits << " hits of " << rays.size() << " rays match the brute force reference\n";
+  return true;
+}
@@ -0,0 +1,226 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "check/Checks.h"
+#include "bench/Fixtures.h"
+
+#include "inc/HostBVH.h"
+#include "inc/SceneGraph.h"
+
+#include "shaders/vector_math.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+
+static bool isFile(std::string const& filename)
+{
+  return std::ifstream(filename, std::ios::binary).good();
+}
+
+// Returns false when released geometry doesn't come back bit identical from its cache file, when failed cache writes or reads
+// lose the resident data, or when the incremental host BVH rebuild of a hot reload differs from a full rebuild.
+bool checkHostResidency()
+{
+  const std::string filename       = "rtigo3_check_cache_0.bin";
+  const std::string filenameUnused = "rtigo3_check_cache_1.bin";
+
+  std::cout << "host_residency: the failed cache write and the truncated cache file report errors on purpose\n";
+
+  for (int variant = 0; variant < 2; ++variant)
+  {
+    std::shared_ptr<sg::Triangles> geometry = std::make_shared<sg::Triangles>(0);
+
+    if (variant == 0)
+    {
+      geometry->createSphere(32, 16, 1.0f, M_PIf);
+    }
+    else // Independent triangles without indices.
+    {
+      std::mt19937 rng(88);
+      std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+
+      std::vector<TriangleAttributes> soup(301);
+      for (TriangleAttributes& attribute : soup)
+      {
+        attribute.vertex = make_float3(uniform(rng), uniform(rng), uniform(rng));
+      }
+      geometry->setAttributes(soup);
+    }
+
+    const std::vector<TriangleAttributes> attributes = geometry->getAttributes();
+    const std::vector<unsigned int>       indices    = geometry->getIndices();
+    const size_t                          size       = geometry->getHostSizeInBytes();
+
+    const auto isIdentical = [&]()
+    {
+      return geometry->isHostResident() && geometry->getHostSizeInBytes() == size &&
+             geometry->getAttributes().size() == attributes.size() && geometry->getIndices() == indices &&
+             memcmp(geometry->getAttributes().data(), attributes.data(), sizeof(TriangleAttributes) * attributes.size()) == 0;
+    };
+
+    // A failed write keeps the geometry resident.
+    if (geometry->releaseHost("rtigo3_check_missing_directory/cache.bin") || !isIdentical())
+    {
+      std::cerr << "ERROR: checkHostResidency() failed cache write lost the geometry\n";
+      return false;
+    }
+
+    // Round trip, twice. The second release frees the arrays without writing another file.
+    for (int i = 0; i < 2; ++i)
+    {
+      if (!geometry->releaseHost((i == 0) ? filename : filenameUnused) || geometry->isHostResident() || geometry->getHostSizeInBytes() != size ||
+          !isFile(filename) || isFile(filenameUnused))
+      {
+        std::cerr << "ERROR: checkHostResidency() releaseHost() of variant " << variant << '\n';
+        return false;
+      }
+      if (!geometry->reloadHost() || !isIdentical())
+      {
+        std::cerr << "ERROR: checkHostResidency() reloadHost() of variant " << variant << " differs\n";
+        return false;
+      }
+    }
+
+    // A truncated cache file fails the reload without touching the released state. Restoring the file makes the retry succeed.
+    std::string contents;
+    {
+      std::ifstream input(filename, std::ios::binary);
+      contents.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    }
+    geometry->releaseHost(filename);
+    std::ofstream(filename, std::ios::binary).write(contents.data(), contents.size() - 1);
+
+    if (geometry->reloadHost() || geometry->isHostResident() || geometry->getHostSizeInBytes() != size)
+    {
+      std::cerr << "ERROR: checkHostResidency() truncated cache file of variant " << variant << '\n';
+      return false;
+    }
+
+    std::ofstream(filename, std::ios::binary).write(contents.data(), contents.size());
+
+    if (!geometry->reloadHost() || !isIdentical())
+    {
+      std::cerr << "ERROR: checkHostResidency() reloadHost() retry of variant " << variant << '\n';
+      return false;
+    }
+
+    geometry.reset();
+    if (isFile(filename))
+    {
+      std::cerr << "ERROR: checkHostResidency() the cache file outlived its geometry\n";
+      return false;
+    }
+  }
+
+  // A hot reload keeps the converted meshes, removes one, adds one and moves the instances.
+  // The incremental rebuild must answer every ray like a BVH built from scratch.
+  HostBVH bvh;
+  std::vector< std::shared_ptr<sg::Triangles> > geometries;
+
+  buildHostBVHScene(bvh, geometries, 50);
+
+  std::shared_ptr<sg::Triangles> added = std::make_shared<sg::Triangles>(5);
+  added->createTorus(32, 16, 0.5f, 1.5f);
+
+  bvh.clearInstances();
+
+  const size_t memoryBefore = bvh.getMemoryUsage();
+  bvh.removeMesh(0); // The sphere.
+  const size_t memoryAfter  = bvh.getMemoryUsage();
+
+  const int meshAdded = bvh.addMesh(reinterpret_cast<const float*>(added->getAttributes().data()), sizeof(TriangleAttributes), added->getAttributes().size(),
+                                    added->getIndices().data(), added->getIndices().size());
+
+  HostBVH reference;
+
+  std::vector<int> meshes;
+  for (std::shared_ptr<sg::Triangles> const& geometry : geometries)
+  {
+    std::vector<TriangleAttributes> const& attributes = geometry->getAttributes();
+    std::vector<unsigned int>       const& indices    = geometry->getIndices();
+
+    meshes.push_back(reference.addMesh(reinterpret_cast<const float*>(attributes.data()), sizeof(TriangleAttributes), attributes.size(), indices.data(), indices.size()));
+  }
+  reference.removeMesh(meshes[0]);
+  reference.addMesh(nullptr, sizeof(TriangleAttributes), 0, nullptr, 0); // Keeps the mesh indices of both BVHs equal.
+  reference.addMesh(reinterpret_cast<const float*>(added->getAttributes().data()), sizeof(TriangleAttributes), added->getAttributes().size(),
+                    added->getIndices().data(), added->getIndices().size());
+
+  std::mt19937 rng(88);
+
+  float matrix[12];
+  for (int i = 0; i < 60; ++i)
+  {
+    const int mesh = (i % 7 == 6) ? meshAdded : i % 6; // Includes instances of the removed mesh and the empty mesh.
+
+    makeRandomTransform(rng, 20.0f, matrix);
+    bvh.addInstance(mesh, matrix);
+    reference.addInstance(mesh, matrix);
+  }
+
+  bvh.build();
+  reference.build();
+
+  const std::vector<BvhRay> rays = makeHostBVHRays(4000, 20.0f);
+
+  size_t numHits = 0;
+
+  for (size_t i = 0; i < rays.size(); ++i)
+  {
+    BvhHit hit;
+    BvhHit hitReference;
+
+    const bool isHit       = bvh.intersect(rays[i], hit);
+    const bool isReference = reference.intersect(rays[i], hitReference);
+
+    if (isHit != isReference || (isHit && (hit.t != hitReference.t || hit.instance != hitReference.instance)) ||
+        (isHit && (hit.instance % 7) != 6 && hit.instance % 6 == 0))
+    {
+      std::cerr << "ERROR: checkHostResidency() incremental host BVH differs at ray " << i << '\n';
+      return false;
+    }
+    numHits += (isHit) ? 1 : 0;
+  }
+
+  if (numHits == 0 || memoryAfter + geometries[0]->getIndices().size() / 3 * (sizeof(BvhTriangle) + sizeof(unsigned int)) > memoryBefore)
+  {
+    std::cerr << "ERROR: checkHostResidency() " << numHits << " hits, the removed mesh is still counted\n";
+    return false;
+  }
+
+  std::cout << "host_residency: cache round trips bit identical, incremental host BVH matches the full rebuild on " << numHits << " hits\n";
+  return true;
+}
@@ -0,0 +1,123 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "check/Checks.h"
+#include "bench/Fixtures.h"
+
+#include "inc/InputTrace.h"
+
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+
+// Compares a recorded trace with its saved and loaded copy. Then replays it twice frame locked
+// and checks that both replays deliver the same events and reach the same iterations and restarts.
+bool checkInputTrace()
+{
+  InputTrace recorded;
+  InputTrace loaded;
+
+  recordInputTrace(recorded);
+
+  if (!saveAndLoadInputTrace(recorded, loaded))
+  {
+    std::cerr << "ERROR: checkInputTrace() failed to save and load the trace\n";
+    return false;
+  }
+
+  std::vector<InputEvent> const& a = recorded.getEvents();
+  std::vector<InputEvent> const& b = loaded.getEvents();
+
+  if (a.size() != b.size() || a.empty() || a.back().type != INPUT_EVENT_END || a.back().frame != 599)
+  {
+    std::cerr << "ERROR: checkInputTrace() recorded " << a.size() << " events, loaded " << b.size() << '\n';
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); ++i)
+  {
+    // The times are saved with microsecond resolution. Everything else must load identical.
+    if (a[i].type != b[i].type || a[i].frame != b[i].frame || a[i].x != b[i].x || a[i].y != b[i].y ||
+        a[i].value != b[i].value || 1.0e-6 < fabs(a[i].time - b[i].time))
+    {
+      std::cerr << "ERROR: checkInputTrace() event " << i << " differs after loading: "
+                << a[i].type << ' ' << a[i].frame << ' ' << a[i].x << ' ' << a[i].y << ' ' << a[i].value << " vs. "
+                << b[i].type << ' ' << b[i].frame << ' ' << b[i].x << ' ' << b[i].y << ' ' << b[i].value << '\n';
+      return false;
+    }
+  }
+
+  std::unique_ptr<InputReplay> first;
+  std::unique_ptr<InputReplay> second;
+
+  replayInputTrace(b, first);
+  replayInputTrace(b, second);
+
+  std::vector<ReplayFrame> const& framesFirst  = first->getFrames();
+  std::vector<ReplayFrame> const& framesSecond = second->getFrames();
+
+  if (framesFirst.size() != 600 || framesFirst.size() != framesSecond.size())
+  {
+    std::cerr << "ERROR: checkInputTrace() replayed " << framesFirst.size() << " and " << framesSecond.size() << " frames, expected 600\n";
+    return false;
+  }
+
+  unsigned int restarts = 0;
+  for (size_t i = 0; i < framesFirst.size(); ++i)
+  {
+    ReplayFrame const& f = framesFirst[i];
+    ReplayFrame const& s = framesSecond[i];
+
+    if (f.events != s.events || f.iteration != s.iteration || f.restarted != s.restarted)
+    {
+      std::cerr << "ERROR: checkInputTrace() frame " << i << " differs between the replays: events "
+                << f.events << ", " << s.events << " iteration " << f.iteration << ", " << s.iteration
+                << " restarted " << f.restarted << ", " << s.restarted << '\n';
+      return false;
+    }
+    if (f.restarted)
+    {
+      ++restarts;
+    }
+  }
+
+  // Frame 120 changes the mouse ratio and frame 150 the tonemapper. The parameter edits in 250, 450, 460 and 470 restart,
+  // the two albedo components in frame 450 only once.
+  if (framesFirst[120].restarted || framesFirst[150].restarted ||
+      !framesFirst[250].restarted || !framesFirst[450].restarted || !framesFirst[460].restarted || !framesFirst[470].restarted ||
+      framesFirst[450].iteration != 1 || framesFirst[459].iteration != 10)
+  {
+    std::cerr << "ERROR: checkInputTrace() the parameter edits restarted the wrong frames\n";
+    return false;
+  }
+
+  std::cout << "Input trace: " << a.size() << " events round trip, two replays with " << restarts << " identical restarts\n";
+
+  return true;
+}
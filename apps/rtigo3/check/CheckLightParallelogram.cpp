@@ -0,0 +1,279 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "check/Checks.h"
+
+#include "shaders/light_parallelogram.h"
+#include "shaders/vector_math.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+static LightDefinition makeParallelogramLight(float3 const& position, float3 const& vecU, float3 const& vecV)
+{
+  LightDefinition light;
+
+  memset(&light, 0, sizeof(LightDefinition));
+
+  const float3 n = cross(vecU, vecV);
+
+  light.type     = LIGHT_PARALLELOGRAM;
+  light.position = position;
+  light.vecU     = vecU;
+  light.vecV     = vecV;
+  light.area     = length(n);
+  light.normal   = (0.0f < light.area) ? n / light.area : make_float3(0.0f, 0.0f, 1.0f);
+  light.emission = make_float3(1.0f);
+  return light;
+}
+
+// Midpoint rule over the (s, t) in [s0, s1] x [t0, t1] part of the parallelogram of the integral of
+// integrand(direction, distance, cosLight) * cosLight / distance^2 dA, which is the integral over the subtended solid angle.
+template <typename T>
+static double integrateParallelogram(LightDefinition const& light, float3 const& point, T const& integrand,
+                                     const float s0, const float s1, const float t0, const float t1, const int n)
+{
+  double sum = 0.0;
+  for (int i = 0; i < n; ++i)
+  {
+    for (int j = 0; j < n; ++j)
+    {
+      const float s = s0 + (s1 - s0) * (i + 0.5f) / n;
+      const float t = t0 + (t1 - t0) * (j + 0.5f) / n;
+
+      const float3 d        = light.position + s * light.vecU + t * light.vecV - point;
+      const float  distance = length(d);
+      const float3 w        = d / distance;
+      const float  cosLight = fabsf(dot(w, light.normal));
+
+      sum += double(integrand(w, distance, cosLight)) * cosLight / (double(distance) * distance);
+    }
+  }
+  return sum * light.area * (s1 - s0) * (t1 - t0) / (double(n) * n);
+}
+
+// Returns false when the spherical rectangle solid angle or its samples differ from the area integral with the
+// cos / distance^2 Jacobian, when the light pdf doesn't belong to the strategy which sampled the light,
+// or when degenerate and grazing configurations produce invalid values.
+bool checkLightParallelogram()
+{
+  const LightDefinition lights[] =
+  {
+    makeParallelogramLight(make_float3(0.0f, 0.0f, 0.0f), make_float3(2.0f, 0.0f, 0.0f), make_float3(0.0f, 1.0f, 0.0f)),
+    makeParallelogramLight(make_float3(-1.0f, 0.5f, 2.0f), make_float3(1.6f, 0.0f, 1.2f), make_float3(0.0f, 0.8f, 0.0f)),
+  };
+
+  // Relative to the light's position. Above the center, offset, far away, grazing and from behind the light.
+  const float3 points[] =
+  {
+    make_float3(1.0f, 0.5f, 0.3f), make_float3(3.0f, -1.0f, 0.5f), make_float3(1.0f, 0.5f, 20.0f), make_float3(4.0f, 0.5f, 0.2f), make_float3(0.5f, 0.2f, -0.4f)
+  };
+
+  std::mt19937 rng(92);
+  std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+
+  double maxErrorSolidAngle = 0.0;
+  double maxErrorHistogram  = 0.0;
+  double maxErrorIrradiance = 0.0;
+  int    numSolidAngle      = 0;
+
+  for (LightDefinition const& light : lights)
+  {
+    for (float3 const& offset : points)
+    {
+      // Place the point in the light's frame.
+      const float3 uAxis = normalize(light.vecU);
+      const float3 vAxis = normalize(light.vecV);
+      const float3 point = light.position + offset.x * uAxis + offset.y * vAxis + offset.z * light.normal;
+
+      const bool useSolidAngle = useSolidAngleSampling(light, point);
+      numSolidAngle += (useSolidAngle) ? 1 : 0;
+
+      SphericalRectangle sq;
+      sphericalRectangleInit(sq, light.position, light.vecU, light.vecV, point);
+
+      const double reference = integrateParallelogram(light, point, [](float3 const&, const float, const float) { return 1.0f; }, 0.0f, 1.0f, 0.0f, 1.0f, 1024);
+      const double error     = fabs(sq.S - reference) / reference;
+
+      // Single precision loses the small solid angles. These are area sampled.
+      if (((useSolidAngle) ? 1.0e-3 : 5.0e-2) < error)
+      {
+        std::cerr << "ERROR: checkLightParallelogram() solid angle " << sq.S << ", area integral " << reference << '\n';
+        return false;
+      }
+      if (useSolidAngle)
+      {
+        maxErrorSolidAngle = std::max(maxErrorSolidAngle, error);
+      }
+
+      // Irradiance of a surface facing the light center, with the strategy and pdf the renderer picks for this point.
+      const float3 normal = normalize(light.position + 0.5f * (light.vecU + light.vecV) - point);
+
+      const double irradiance = integrateParallelogram(light, point, [&normal](float3 const& w, const float, const float) { return fmaxf(0.0f, dot(w, normal)); },
+                                                       0.0f, 1.0f, 0.0f, 1.0f, 1024);
+
+      const int numSamples = 100000;
+
+      std::vector<double> histogram(64, 0.0);
+
+      double estimate = 0.0;
+      for (int i = 0; i < numSamples; ++i)
+      {
+        const float u = uniform(rng);
+        const float v = uniform(rng);
+
+        const float3 p = (useSolidAngle) ? sphericalRectangleSample(sq, u, v) : light.position + u * light.vecU + v * light.vecV;
+
+        // Parallelogram coordinates of the sample.
+        const float3 d  = p - light.position;
+        const float  s  = dot(d, light.vecU) / dot(light.vecU, light.vecU);
+        const float  t  = dot(d, light.vecV) / dot(light.vecV, light.vecV);
+        const float  h  = dot(d, light.normal);
+
+        if (!(-1.0e-4f <= s && s <= 1.0f + 1.0e-4f && -1.0e-4f <= t && t <= 1.0f + 1.0e-4f && fabsf(h) < 1.0e-4f))
+        {
+          std::cerr << "ERROR: checkLightParallelogram() sample (" << s << ", " << t << ") off the light by " << h << '\n';
+          return false;
+        }
+
+        const float3 w        = p - point;
+        const float  distance = length(w);
+        const float  cosLight = fabsf(dot(w, light.normal)) / distance;
+
+        const float pdf = lightParallelogramPdf(light, point, distance, cosLight);
+
+        estimate += fmaxf(0.0f, dot(w / distance, normal)) / pdf;
+
+        histogram[std::min(7, int(s * 8.0f)) * 8 + std::min(7, int(t * 8.0f))] += 1.0;
+      }
+      estimate /= numSamples;
+
+      const double errorIrradiance = fabs(estimate - irradiance) / irradiance;
+      maxErrorIrradiance = std::max(maxErrorIrradiance, errorIrradiance);
+
+      if (1.0e-2 < errorIrradiance)
+      {
+        std::cerr << "ERROR: checkLightParallelogram() irradiance estimate " << estimate << ", reference " << irradiance
+                  << ((useSolidAngle) ? " with solid angle sampling\n" : " with area sampling\n");
+        return false;
+      }
+
+      // The solid angle samples are distributed by the subtended solid angle of each cell, the area samples by area.
+      for (int i = 0; i < 8; ++i)
+      {
+        for (int j = 0; j < 8; ++j)
+        {
+          const double fraction = (useSolidAngle)
+            ? integrateParallelogram(light, point, [](float3 const&, const float, const float) { return 1.0f; },
+                                     i / 8.0f, (i + 1) / 8.0f, j / 8.0f, (j + 1) / 8.0f, 64) / reference
+            : 1.0 / 64.0;
+
+          const double expected = fraction * numSamples;
+          const double observed = histogram[i * 8 + j];
+
+          maxErrorHistogram = std::max(maxErrorHistogram, fabs(observed - expected) / numSamples);
+
+          if (5.0 * sqrt(expected) + 1.0e-3 * numSamples < fabs(observed - expected))
+          {
+            std::cerr << "ERROR: checkLightParallelogram() cell (" << i << ", " << j << ") has " << observed << " samples, expected " << expected << '\n';
+            return false;
+          }
+        }
+      }
+    }
+  }
+
+  // Both strategies must have been exercised.
+  if (numSolidAngle == 0 || numSolidAngle == int(sizeof(lights) / sizeof(lights[0]) * sizeof(points) / sizeof(points[0])))
+  {
+    std::cerr << "ERROR: checkLightParallelogram() " << numSolidAngle << " configurations use solid angle sampling\n";
+    return false;
+  }
+
+  // Degenerate lights are area sampled.
+  const LightDefinition sheared = makeParallelogramLight(make_float3(0.0f), make_float3(2.0f, 0.0f, 0.0f), make_float3(0.5f, 1.0f, 0.0f));
+  const LightDefinition line    = makeParallelogramLight(make_float3(0.0f), make_float3(2.0f, 0.0f, 0.0f), make_float3(0.0f));
+
+  if (useSolidAngleSampling(sheared, make_float3(1.0f, 0.5f, 0.1f)) || useSolidAngleSampling(line, make_float3(1.0f, 0.0f, 0.1f)) ||
+      useSolidAngleSampling(lights[0], make_float3(3.0f, 0.5f, 0.0f))) // In the light's plane.
+  {
+    std::cerr << "ERROR: checkLightParallelogram() degenerate configuration uses solid angle sampling\n";
+    return false;
+  }
+
+  // Grazing and nearly touching points: finite solid angles in [0, 2 pi] and finite samples on the light, also at the parameter bounds.
+  const float3 grazing[] =
+  {
+    make_float3(3.0f, 0.5f, 0.0f), make_float3(2.0f + 1.0e-4f, 0.5f, 1.0e-4f), make_float3(1.0f, 0.5f, 1.0e-3f), make_float3(1.0e-3f, 1.0e-3f, 1.0e-3f), make_float3(-5.0f, 0.5f, 1.0e-5f)
+  };
+
+  for (float3 const& point : grazing)
+  {
+    SphericalRectangle sq;
+    sphericalRectangleInit(sq, lights[0].position, lights[0].vecU, lights[0].vecV, point);
+
+    if (!(0.0f <= sq.S && sq.S <= 2.0f * M_PIf + 1.0e-3f))
+    {
+      std::cerr << "ERROR: checkLightParallelogram() solid angle " << sq.S << " at a grazing point\n";
+      return false;
+    }
+
+    const float pdf = lightParallelogramPdf(lights[0], point, 1.0f, 0.5f);
+    if (!(0.0f < pdf && pdf < INFINITY))
+    {
+      std::cerr << "ERROR: checkLightParallelogram() pdf " << pdf << " at a grazing point\n";
+      return false;
+    }
+
+    if (DENOMINATOR_EPSILON < sq.S)
+    {
+      for (int i = 0; i <= 16; ++i)
+      {
+        for (int j = 0; j <= 16; ++j)
+        {
+          const float3 p = sphericalRectangleSample(sq, i / 16.0f, j / 16.0f);
+
+          if (!(-1.0e-3f <= p.x && p.x <= 2.001f && -1.0e-3f <= p.y && p.y <= 1.001f && fabsf(p.z) < 1.0e-3f))
+          {
+            std::cerr << "ERROR: checkLightParallelogram() grazing sample (" << p.x << ", " << p.y << ", " << p.z << ")\n";
+            return false;
+          }
+        }
+      }
+    }
+  }
+
+  std::cout << "light_parallelogram: " << numSolidAngle << " solid angle sampled configurations, max solid angle error " << maxErrorSolidAngle << ", max histogram error " << maxErrorHistogram
+            << ", max irradiance error " << maxErrorIrradiance << '\n';
+  return true;
+}
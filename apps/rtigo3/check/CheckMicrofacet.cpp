@@ -0,0 +1,231 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "check/Checks.h"
+
+#include "shaders/microfacet.h"
+#include "shaders/vector_math.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+static float3 makeDirection(const float cosTheta, const float phi)
+{
+  const float sinTheta = sqrtf(std::max(0.0f, 1.0f - cosTheta * cosTheta));
+
+  return make_float3(sinTheta * cosf(phi), sinTheta * sinf(phi), cosTheta);
+}
+
+// Midpoint rule over the upper hemisphere in (cos(theta), phi), where the solid angle measure is d(cos(theta)) * d(phi).
+template <typename T>
+static double integrateHemisphere(T const& integrand, const int numZ, const int numPhi)
+{
+  const double dz   = 1.0 / numZ;
+  const double dphi = 2.0 * M_PI / numPhi;
+
+  double sum = 0.0;
+  for (int i = 0; i < numZ; ++i)
+  {
+    for (int j = 0; j < numPhi; ++j)
+    {
+      sum += integrand(makeDirection(float((i + 0.5) * dz), float((j + 0.5) * dphi)));
+    }
+  }
+  return sum * dz * dphi;
+}
+
+// GGX Smith BRDF with a white Fresnel term.
+static float evalMicrofacetBRDF(const float ax, const float ay, float3 const& wo, float3 const& wi)
+{
+  if (wo.z <= 0.0f || wi.z <= 0.0f)
+  {
+    return 0.0f;
+  }
+  const float3 wm = normalize(wo + wi);
+
+  return distribution_d(ax, ay, wm) * distribution_G(ax, ay, wo, wi, wm) / (4.0f * wo.z * wi.z);
+}
+
+// Returns false when the GGX distribution isn't normalized, the visible normal sampling doesn't follow its pdf,
+// the BRDF gains energy in a white furnace or isn't reciprocal.
+bool checkMicrofacet()
+{
+  const float2 roughness[] = { { 0.1f, 0.1f }, { 0.3f, 0.3f }, { 0.2f, 0.6f }, { 1.0f, 1.0f } };
+  const float2 views[]     = { { 1.0f, 0.0f }, { 0.7071f, 0.3f }, { 0.17f, 2.0f } }; // (cos(theta), phi)
+
+  std::mt19937 rng(91);
+  std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+
+  double errorSampling = 0.0;
+  double minAlbedo     = 1.0;
+  double errorFurnace  = 0.0;
+  float  errorReciprocity = 0.0f;
+
+  for (const float2 alpha : roughness)
+  {
+    // The projected microfacet area is the macro surface: integral of D(wm) * wm.z = 1.
+    const double area = integrateHemisphere([&](float3 const& wm) { return distribution_d(alpha.x, alpha.y, wm) * wm.z; }, 2048, 128);
+    if (2.0e-3 < fabs(area - 1.0))
+    {
+      std::cerr << "ERROR: checkMicrofacet() integral of D * cos = " << area << " for roughness " << alpha.x << ", " << alpha.y << '\n';
+      return false;
+    }
+
+    for (const float2 view : views)
+    {
+      const float3 wo = makeDirection(view.x, view.y);
+
+      // The visible normals pdf integrates to one, that makes G1 the matching masking function of D.
+      const double visible = integrateHemisphere([&](float3 const& wm) { return distribution_pdf_visible(alpha.x, alpha.y, wo, wm); }, 2048, 128);
+      if (2.0e-3 < fabs(visible - 1.0))
+      {
+        std::cerr << "ERROR: checkMicrofacet() visible normals pdf integrates to " << visible << '\n';
+        return false;
+      }
+
+      // Histogram of sampled normals against the integrated pdf over the same bins.
+      const int numBinsZ   = 16;
+      const int numBinsPhi = 16;
+      const int numSamples = 200000;
+
+      std::vector<double> histogram(numBinsZ * numBinsPhi, 0.0);
+
+      // White furnace: with visible normal sampling the reflected sample weight is f * cos / pdf = G1(wi).
+      double albedo = 0.0;
+
+      for (int i = 0; i < numSamples; ++i)
+      {
+        const float3 wm = distribution_sample_visible(alpha.x, alpha.y, wo, uniform(rng), uniform(rng));
+
+        const float  pdf = distribution_pdf_visible(alpha.x, alpha.y, wo, wm);
+        const float3 wi  = reflect(-wo, wm);
+
+        if (!(0.0f < pdf))
+        {
+          std::cerr << "ERROR: checkMicrofacet() sampled a normal with pdf " << pdf << '\n';
+          return false;
+        }
+
+        const int binZ   = std::min(numBinsZ - 1, int(wm.z * numBinsZ));
+        const float phi  = atan2f(wm.y, wm.x);
+        const int binPhi = std::min(numBinsPhi - 1, int((phi + M_PIf) / (2.0f * M_PIf) * numBinsPhi));
+
+        histogram[binZ * numBinsPhi + binPhi] += 1.0;
+
+        if (0.0f < wi.z)
+        {
+          const float pdfReflection = distribution_pdf_reflection(alpha.x, alpha.y, wo, wm);
+          const float weight        = evalMicrofacetBRDF(alpha.x, alpha.y, wo, wi) * wi.z / pdfReflection;
+
+          // The reflection pdf is the visible normals pdf with the reflection Jacobian 1 / (4 * dot(wo, wm)).
+          if (1.0e-3f * pdfReflection < fabsf(pdfReflection - pdf / (4.0f * dot(wo, wm))) ||
+              1.0e-3f < fabsf(weight - distribution_G1(alpha.x, alpha.y, wi, wm)) || 1.0f + 1.0e-5f < weight)
+          {
+            std::cerr << "ERROR: checkMicrofacet() reflection weight " << weight << " pdf " << pdfReflection << '\n';
+            return false;
+          }
+          albedo += weight;
+        }
+      }
+      albedo /= numSamples;
+
+      for (int binZ = 0; binZ < numBinsZ; ++binZ)
+      {
+        for (int binPhi = 0; binPhi < numBinsPhi; ++binPhi)
+        {
+          // Subdivided midpoint rule inside the bin. Finer along z where the low roughness peaks are.
+          const int nz   = 64;
+          const int nphi = 8;
+
+          double expected = 0.0;
+          for (int i = 0; i < nz; ++i)
+          {
+            for (int j = 0; j < nphi; ++j)
+            {
+              const float z   = (binZ + (i + 0.5f) / nz) / numBinsZ;
+              const float phi = (binPhi + (j + 0.5f) / nphi) / numBinsPhi * 2.0f * M_PIf - M_PIf;
+
+              expected += distribution_pdf_visible(alpha.x, alpha.y, wo, makeDirection(z, phi));
+            }
+          }
+          expected *= numSamples * (1.0 / (numBinsZ * nz)) * (2.0 * M_PI / (numBinsPhi * nphi));
+
+          const double observed = histogram[binZ * numBinsPhi + binPhi];
+          const double error    = fabs(observed - expected) / numSamples;
+
+          errorSampling = std::max(errorSampling, error);
+
+          if (5.0 * sqrt(expected) + 1.0e-3 * numSamples < fabs(observed - expected))
+          {
+            std::cerr << "ERROR: checkMicrofacet() visible normal bin (" << binZ << ", " << binPhi << ") has " << observed << " samples, expected " << expected << '\n';
+            return false;
+          }
+        }
+      }
+
+      // The same albedo by quadrature over the reflected directions.
+      const double reference = integrateHemisphere([&](float3 const& wi) { return evalMicrofacetBRDF(alpha.x, alpha.y, wo, wi) * wi.z; }, 2048, 256);
+
+      if (1.0 + 1.0e-3 < albedo || 5.0e-3 < fabs(albedo - reference))
+      {
+        std::cerr << "ERROR: checkMicrofacet() white furnace albedo " << albedo << ", quadrature " << reference << '\n';
+        return false;
+      }
+      minAlbedo    = std::min(minAlbedo, albedo);
+      errorFurnace = std::max(errorFurnace, fabs(albedo - reference));
+    }
+
+    // Reciprocity: f(wo, wi) == f(wi, wo).
+    for (int i = 0; i < 10000; ++i)
+    {
+      const float3 wo = makeDirection(uniform(rng), 2.0f * M_PIf * uniform(rng));
+      const float3 wi = makeDirection(uniform(rng), 2.0f * M_PIf * uniform(rng));
+
+      const float f0 = evalMicrofacetBRDF(alpha.x, alpha.y, wo, wi);
+      const float f1 = evalMicrofacetBRDF(alpha.x, alpha.y, wi, wo);
+
+      const float error = fabsf(f0 - f1) / std::max(1.0e-6f, std::max(f0, f1));
+
+      errorReciprocity = std::max(errorReciprocity, error);
+
+      if (1.0e-5f < error)
+      {
+        std::cerr << "ERROR: checkMicrofacet() f(wo, wi) = " << f0 << " but f(wi, wo) = " << f1 << '\n';
+        return false;
+      }
+    }
+  }
+
+  std::cout << "microfacet: max sampling histogram error " << errorSampling << ", white furnace albedo >= " << minAlbedo
+            << " (quadrature error " << errorFurnace << "), max reciprocity error " << errorReciprocity << '\n';
+  return true;
+}
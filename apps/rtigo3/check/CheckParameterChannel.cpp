@@ -0,0 +1,175 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "check/Checks.h"
+#include "bench/Fixtures.h"
+
+#include "inc/MaterialGUI.h"
+#include "inc/ParameterChannel.h"
+
+#include "shaders/vector_math.h"
+
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+
+// Returns false when the parameter snapshots don't coalesce the edits into minimal diffs
+// or a consumer sees a snapshot which is torn or older than one it acquired before.
+bool checkParameterChannel()
+{
+  ParameterChannel channel;
+
+  DeviceState state = {};
+  state.samplesSqrt = 1;
+
+  channel.setState(state);
+  channel.setCameras(std::vector<CameraDefinition>(2));
+  channel.setLights(std::vector<LightDefinition>(1));
+  channel.setMaterials(std::vector<MaterialGUI>(3, makeMaterial(1.5f)));
+
+  ParameterDiff diff;
+
+  // Nothing published yet, the empty initial snapshot is news to a new consumer.
+  if (!channel.acquire(0, diff) || diff.isDirtyState || !diff.materials.empty() || channel.acquire(0, diff))
+  {
+    std::cerr << "ERROR: checkParameterChannel() initial snapshot\n";
+    return false;
+  }
+
+  // The first real snapshot is complete for every consumer.
+  if (!channel.publish() || !channel.acquire(0, diff) || !diff.isDirtyState ||
+      diff.cameras.size() != 2 || diff.lights.size() != 1 || diff.materials.size() != 3)
+  {
+    std::cerr << "ERROR: checkParameterChannel() complete snapshot\n";
+    return false;
+  }
+  if (channel.publish() || channel.acquire(0, diff))
+  {
+    std::cerr << "ERROR: checkParameterChannel() empty publish\n";
+    return false;
+  }
+
+  // A slider drag between two frames: many edits of one material, one camera set to its current value.
+  for (int i = 0; i < 100; ++i)
+  {
+    channel.setMaterial(2, makeMaterial(1.0f + 0.01f * i));
+  }
+  channel.setCamera(1, CameraDefinition());
+
+  const ParameterSnapshot* previous = diff.snapshot;
+
+  if (!channel.publish() || !channel.acquire(0, diff) || diff.isDirtyState || !diff.cameras.empty() || !diff.lights.empty() ||
+      diff.materials.size() != 1 || diff.materials[0] != 2 || (*diff.snapshot->materials)[2].ior != 1.99f ||
+      diff.snapshot->version != previous->version + 1 || diff.snapshot->lights != previous->lights)
+  {
+    std::cerr << "ERROR: checkParameterChannel() coalesced diff\n";
+    return false;
+  }
+
+  // A consumer which skipped versions gets the union of the changes.
+  ParameterDiff diffLate;
+  channel.acquire(1, diffLate);
+
+  LightDefinition light = LightDefinition();
+  light.emission = make_float3(2.0f, 2.0f, 2.0f);
+
+  channel.setLight(0, light);
+  channel.publish();
+  channel.setMaterial(0, makeMaterial(1.33f));
+  channel.publish();
+
+  if (!channel.acquire(0, diff) || diff.lights.size() != 1 || diff.materials.size() != 1 || diff.materials[0] != 0)
+  {
+    std::cerr << "ERROR: checkParameterChannel() skipped versions\n";
+    return false;
+  }
+
+  // One producer and four consumers. Every snapshot encodes its version in all sections.
+  const unsigned int versions  = 20000;
+  const int          consumers = 4;
+
+  // Snapshots up to the first version predate the stress test and carry no tags.
+  const unsigned int first = channel.getVersion();
+
+  std::atomic<bool> isValid(true);
+  std::vector<std::thread> threads;
+
+  for (int c = 0; c < consumers; ++c)
+  {
+    threads.push_back(std::thread([&channel, &isValid, c, first, versions]()
+    {
+      ParameterDiff diffConsumer;
+      unsigned int  last = first;
+
+      while (last < versions)
+      {
+        if (!channel.acquire(2 + c, diffConsumer) || diffConsumer.snapshot->version <= first)
+        {
+          continue;
+        }
+
+        const ParameterSnapshot& snapshot = *diffConsumer.snapshot;
+        const float tag = float(snapshot.version);
+
+        if (snapshot.version < last || (*snapshot.cameras)[0].P.x != tag || (*snapshot.materials)[1].ior != tag || snapshot.state->samplesSqrt != int(snapshot.version))
+        {
+          isValid = false;
+          return;
+        }
+        last = snapshot.version;
+      }
+    }));
+  }
+
+  for (unsigned int i = first + 1; i <= versions; ++i)
+  {
+    CameraDefinition camera = CameraDefinition();
+    camera.P.x = float(i);
+
+    state.samplesSqrt = int(i);
+
+    channel.setCamera(0, camera);
+    channel.setMaterial(1, makeMaterial(float(i)));
+    channel.setState(state);
+    channel.publish();
+  }
+
+  for (std::thread& thread : threads)
+  {
+    thread.join();
+  }
+
+  if (!isValid)
+  {
+    std::cerr << "ERROR: checkParameterChannel() concurrent consumers\n";
+    return false;
+  }
+  return true;
+}
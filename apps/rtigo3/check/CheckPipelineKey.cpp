@@ -0,0 +1,155 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "check/Checks.h"
+
+#include "inc/PipelineKey.h"
+
+#include <iostream>
+#include <map>
+#include <vector>
+
+
+static MaterialDefinition makeMaterialDefinition(const FunctionIndex indexBSDF, const bool cutout)
+{
+  MaterialDefinition material = {};
+
+  material.indexBSDF     = indexBSDF;
+  material.textureCutout = (cutout) ? 1 : 0;
+
+  return material;
+}
+
+// Returns false when the pipeline key derivation, the compatibility selection or the cache eviction of Device::updatePipeline() misbehave.
+bool checkPipelineKey()
+{
+  const PipelineKey generic = makeGenericPipelineKey(0, 2);
+
+  std::vector<MaterialDefinition> materials;
+  materials.push_back(makeMaterialDefinition(INDEX_BRDF_DIFFUSE, false));
+  materials.push_back(makeMaterialDefinition(INDEX_BRDF_GGX_SMITH, true));
+
+  std::vector<int> lightTypes(1, 2);
+
+  const PipelineKey key = derivePipelineKey(0, 2, 1, 0x5, materials, lightTypes);
+
+  if (key.generic || key.lensShader != 1 || key.aovMask != 0x5 || key.cutout != 1 || key.maskLights != 0x4 ||
+      key.maskBSDF != ((1u << INDEX_BRDF_DIFFUSE) | (1u << INDEX_BRDF_GGX_SMITH)))
+  {
+    std::cerr << "ERROR: checkPipelineKey() derived key\n";
+    return false;
+  }
+
+  // The generic pipeline renders everything of its strategy and miss shader, a specialized one only subsets of its programs.
+  materials.pop_back();
+  const PipelineKey subset = derivePipelineKey(0, 2, 1, 0x5, materials, lightTypes);
+
+  if (!isPipelineCompatible(generic, key) || isPipelineCompatible(key, generic) || !isPipelineCompatible(key, subset) || isPipelineCompatible(subset, key) ||
+      isPipelineCompatible(makeGenericPipelineKey(1, 2), key) || isPipelineCompatible(key, derivePipelineKey(0, 2, 0, 0x5, materials, lightTypes)) ||
+      isPipelineCompatible(key, derivePipelineKey(0, 2, 1, 0x1, materials, lightTypes)))
+  {
+    std::cerr << "ERROR: checkPipelineKey() compatibility\n";
+    return false;
+  }
+
+  struct Entry
+  {
+    unsigned int lastUse;
+  };
+
+  std::map<PipelineKey, Entry> pipelines;
+  pipelines[generic].lastUse = 0;
+
+  if (selectPipelineKey(pipelines, generic, subset, generic) != generic ||
+      selectPipelineKey(pipelines, key, subset, generic) != key)
+  {
+    std::cerr << "ERROR: checkPipelineKey() fallback selection\n";
+    return false;
+  }
+  pipelines[subset].lastUse = 0;
+  if (selectPipelineKey(pipelines, key, subset, generic) != subset)
+  {
+    std::cerr << "ERROR: checkPipelineKey() cached selection\n";
+    return false;
+  }
+
+  // The update loop of a GUI session cycling through lens shaders and AOV masks.
+  // The compilation finishes immediately here, so every required key is cached the frame after it was selected.
+  pipelines.clear();
+  pipelines[generic].lastUse = 0;
+
+  PipelineKey  active   = generic;
+  unsigned int useCount = 0;
+  size_t       compiled = 0;
+
+  for (int frame = 0; frame < 1000; ++frame)
+  {
+    const PipelineKey required = derivePipelineKey(0, 2, (frame / 7) % 3, unsigned(frame / 3) % 16u, materials, lightTypes);
+    const PipelineKey selected = selectPipelineKey(pipelines, active, required, generic);
+
+    if (selected != active)
+    {
+      active = selected;
+      pipelines[active].lastUse = ++useCount;
+    }
+    if (selected != required)
+    {
+      pipelines[required].lastUse = useCount;
+      ++compiled;
+    }
+
+    PipelineKey evict;
+    while (selectPipelineEviction(pipelines, active, PIPELINE_CACHE_SIZE, evict))
+    {
+      if (evict.generic || evict == active)
+      {
+        std::cerr << "ERROR: checkPipelineKey() evicted a generic or the active pipeline\n";
+        return false;
+      }
+      // Least recently used first.
+      for (std::map<PipelineKey, Entry>::const_iterator it = pipelines.begin(); it != pipelines.end(); ++it)
+      {
+        if (!it->first.generic && it->first != active && it->second.lastUse < pipelines[evict].lastUse)
+        {
+          std::cerr << "ERROR: checkPipelineKey() evicted a more recently used pipeline\n";
+          return false;
+        }
+      }
+      pipelines.erase(evict);
+    }
+
+    if (PIPELINE_CACHE_SIZE < pipelines.size() || pipelines.find(generic) == pipelines.end() || pipelines.find(active) == pipelines.end())
+    {
+      std::cerr << "ERROR: checkPipelineKey() cache size " << pipelines.size() << '\n';
+      return false;
+    }
+  }
+
+  std::cout << "pipeline_key: " << compiled << " specializations compiled in 1000 frames, " << pipelines.size() << " cached\n";
+  return true;
+}
@@ -0,0 +1,212 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "check/Checks.h"
+
+#include "shaders/ray_cone.h"
+#include "shaders/vector_math.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+
+// Pinhole primary ray direction like the lens shader, in double precision for the reference measurements.
+static void getPinholeDirection(const double fovY, const double aspect, const double width, const double height,
+                                const double x, const double y, double direction[3])
+{
+  const double tanHalf = tan(0.5 * fovY);
+
+  direction[0] = ((x / width)  * 2.0 - 1.0) * aspect * tanHalf;
+  direction[1] = ((y / height) * 2.0 - 1.0) * tanHalf;
+  direction[2] = -1.0;
+
+  const double invLength = 1.0 / sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+  for (int i = 0; i < 3; ++i)
+  {
+    direction[i] *= invLength;
+  }
+}
+
+// Intersects the ray from the origin with the plane through center with the normal n. Returns the ray distance.
+static double intersectPlane(const double direction[3], const double center[3], const double n[3])
+{
+  return (center[0] * n[0] + center[1] * n[1] + center[2] * n[2]) / (direction[0] * n[0] + direction[1] * n[1] + direction[2] * n[2]);
+}
+
+// Returns false when the pinhole spread, the cone width propagation or the texture LOD selection of the ray cones
+// differ from the pixel footprints measured with the neighbouring pixel rays.
+bool checkRayCone()
+{
+  const double fovY   = 45.0 * M_PI / 180.0;
+  const double width  = 1920.0;
+  const double height = 1080.0;
+  const double aspect = width / height;
+
+  const float3 V = make_float3(0.0f, float(tan(0.5 * fovY)), 0.0f);
+  const float3 W = make_float3(0.0f, 0.0f, -1.0f);
+
+  const float spread = rayConeSpreadPinhole(V, W, float(height));
+
+  // The spread is the angle between the rays through the two center pixels.
+  double d0[3];
+  double d1[3];
+  getPinholeDirection(fovY, aspect, width, height, 960.5, 540.5, d0);
+  getPinholeDirection(fovY, aspect, width, height, 960.5, 541.5, d1);
+
+  const double angle = acos(d0[0] * d1[0] + d0[1] * d1[1] + d0[2] * d1[2]);
+
+  if (1.0e-3 < fabs(spread - angle) / angle)
+  {
+    std::cerr << "ERROR: checkRayCone() pinhole spread " << spread << ", pixel angle " << angle << '\n';
+    return false;
+  }
+
+  // Width propagation. Specular interactions keep the spread, so the width only depends on the unfolded path length.
+  // Diffuse interactions widen the spread, the width continues from the hit.
+  std::mt19937 rng(93);
+  std::uniform_real_distribution<float> uniform(0.1f, 10.0f);
+
+  for (int i = 0; i < 1000; ++i)
+  {
+    const float t0 = uniform(rng);
+    const float t1 = uniform(rng);
+    const float t2 = uniform(rng);
+
+    float2 cone = make_float2(0.0f, spread);
+
+    cone.x = rayConeWidth(cone, t0);
+    cone.y = rayConeScatter(cone.y, false);
+    cone.x = rayConeWidth(cone, t1);
+
+    if (1.0e-5f * cone.x < fabsf(cone.x - spread * (t0 + t1)))
+    {
+      std::cerr << "ERROR: checkRayCone() specular width " << cone.x << ", unfolded " << spread * (t0 + t1) << '\n';
+      return false;
+    }
+
+    const float widthHit = cone.x;
+
+    cone.y = rayConeScatter(cone.y, true);
+    cone.x = rayConeWidth(cone, t2);
+
+    if (cone.y != RAY_CONE_DIFFUSE_SPREAD || 1.0e-5f * cone.x < fabsf(cone.x - (widthHit + RAY_CONE_DIFFUSE_SPREAD * t2)) ||
+        rayConeScatter(0.5f, true) != 0.5f)
+    {
+      std::cerr << "ERROR: checkRayCone() diffuse spread " << cone.y << " width " << cone.x << '\n';
+      return false;
+    }
+  }
+
+  // Texture LOD on a textured plane at increasing distances and tilts, against the isotropic footprint the
+  // neighbouring pixel rays cut out of the plane, in texels of a 1024x1024 texture mapped to one world unit.
+  const float textureLod = 0.5f * log2f(1024.0f * 1024.0f);
+
+  double maxErrorFrontal = 0.0;
+  double maxErrorTilted  = 0.0;
+
+  for (const double distance : { 1.0, 10.0, 100.0, 1000.0 })
+  {
+    for (const double tilt : { 0.0, 30.0, 60.0, 75.0 })
+    {
+      const double theta = tilt * M_PI / 180.0;
+
+      const double center[3] = { 0.0, 0.0, -distance };
+      const double axisU[3]  = { 1.0, 0.0, 0.0 };                  // Texture u along x.
+      const double axisV[3]  = { 0.0, cos(theta), sin(theta) };    // Texture v tilted away from the camera.
+      const double n[3]      = { 0.0, -sin(theta), cos(theta) };
+
+      double uv[3][2];
+      double t = 0.0;
+
+      for (int k = 0; k < 3; ++k)
+      {
+        double d[3];
+        getPinholeDirection(fovY, aspect, width, height, 960.5 + ((k == 1) ? 1.0 : 0.0), 540.5 + ((k == 2) ? 1.0 : 0.0), d);
+
+        const double s = intersectPlane(d, center, n);
+        const double p[3] = { s * d[0] - center[0], s * d[1] - center[1], s * d[2] - center[2] };
+
+        uv[k][0] = p[0] * axisU[0] + p[1] * axisU[1] + p[2] * axisU[2];
+        uv[k][1] = p[0] * axisV[0] + p[1] * axisV[1] + p[2] * axisV[2];
+
+        if (k == 0)
+        {
+          t = s;
+        }
+      }
+
+      const double footprintX = hypot(uv[1][0] - uv[0][0], uv[1][1] - uv[0][1]) * 1024.0;
+      const double footprintY = hypot(uv[2][0] - uv[0][0], uv[2][1] - uv[0][1]) * 1024.0;
+      const double reference  = std::max(0.0, log2(std::max(footprintX, footprintY)));
+
+      getPinholeDirection(fovY, aspect, width, height, 960.5, 540.5, d0);
+
+      const float3 e1 = make_float3(float(axisU[0]), float(axisU[1]), float(axisU[2]));
+      const float3 e2 = make_float3(float(axisV[0]), float(axisV[1]), float(axisV[2]));
+
+      const float lod = rayConeLod(e1, e2, make_float2(1.0f, 0.0f), make_float2(0.0f, 1.0f),
+                                   make_float3(float(d0[0]), float(d0[1]), float(d0[2])), rayConeWidth(make_float2(0.0f, spread), float(t)));
+
+      const double error = fabs(rayConeMipLevel(lod, textureLod) - reference);
+
+      if (tilt == 0.0)
+      {
+        maxErrorFrontal = std::max(maxErrorFrontal, error);
+      }
+      else
+      {
+        maxErrorTilted = std::max(maxErrorTilted, error);
+      }
+
+      if (((tilt == 0.0) ? 1.0e-3 : 5.0e-2) < error)
+      {
+        std::cerr << "ERROR: checkRayCone() mip level " << rayConeMipLevel(lod, textureLod) << ", footprint level " << reference
+                  << " at distance " << distance << " and tilt " << tilt << '\n';
+        return false;
+      }
+    }
+  }
+
+  // Degenerate triangles and texture coordinates select the LOD 0. Grazing hits stay finite.
+  const float3 direction = make_float3(0.0f, 0.0f, -1.0f);
+
+  if (rayConeMipLevel(rayConeLod(make_float3(1.0f, 0.0f, 0.0f), make_float3(2.0f, 0.0f, 0.0f), make_float2(1.0f, 0.0f), make_float2(0.0f, 1.0f), direction, 0.01f), textureLod) != 0.0f ||
+      rayConeMipLevel(rayConeLod(make_float3(1.0f, 0.0f, 0.0f), make_float3(0.0f, 1.0f, 0.0f), make_float2(1.0f, 0.0f), make_float2(2.0f, 0.0f), direction, 0.01f), textureLod) != 0.0f ||
+      rayConeMipLevel(rayConeLod(make_float3(1.0f, 0.0f, 0.0f), make_float3(0.0f, 1.0f, 0.0f), make_float2(1.0f, 0.0f), make_float2(0.0f, 1.0f), direction, 0.0f), textureLod) != 0.0f ||
+      !std::isfinite(rayConeLod(make_float3(1.0f, 0.0f, 0.0f), make_float3(0.0f, 0.0f, 1.0f), make_float2(1.0f, 0.0f), make_float2(0.0f, 1.0f), direction, 0.01f)))
+  {
+    std::cerr << "ERROR: checkRayCone() degenerate or grazing footprints\n";
+    return false;
+  }
+
+  std::cout << "ray_cone: pinhole spread error " << fabs(spread - angle) / angle << ", mip level error frontal " << maxErrorFrontal
+            << ", tilted up to 75 degrees " << maxErrorTilted << '\n';
+  return true;
+}
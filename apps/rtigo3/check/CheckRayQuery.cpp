@@ -0,0 +1,132 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "check/Checks.h"
+#include "bench/Fixtures.h"
+
+#include "inc/HostBVH.h"
+#include "inc/RayQuery.h"
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+
+// Returns false when the batched host ray queries differ from the brute force intersection.
+// Each ray is queried three times: as closest hit, masked out and as QUERY_FLAG_ANY_HIT occlusion test.
+// More rays than one task of traceRaysHost() handles, so the multi-threaded distribution is covered as well.
+bool checkRayQuery()
+{
+  HostBVH bvh;
+  std::vector< std::shared_ptr<sg::Triangles> > geometries;
+
+  buildHostBVHScene(bvh, geometries, 50);
+
+  const std::vector<BvhRay> rays = makeHostBVHRays(4000, 20.0f);
+
+  std::vector<BvhHit> references(rays.size());
+  std::vector<bool>   isReference(rays.size());
+
+  for (size_t i = 0; i < rays.size(); ++i)
+  {
+    isReference[i] = bvh.intersectBruteForce(rays[i], references[i]);
+  }
+
+  const unsigned int masks[3] = { 0xFF, 0x100, 0x01 }; // Only bits in 0xFF select the instances.
+  const unsigned int flags[3] = { QUERY_FLAG_NONE, QUERY_FLAG_NONE, QUERY_FLAG_ANY_HIT };
+
+  std::vector<QueryRay> queries(rays.size() * 3);
+
+  for (size_t i = 0; i < queries.size(); ++i)
+  {
+    BvhRay const& ray   = rays[i % rays.size()];
+    QueryRay&     query = queries[i];
+
+    memcpy(query.origin,    ray.org, sizeof(float) * 3);
+    memcpy(query.direction, ray.dir, sizeof(float) * 3);
+    query.tmin  = ray.tmin;
+    query.tmax  = ray.tmax;
+    query.mask  = masks[i / rays.size()];
+    query.flags = flags[i / rays.size()];
+  }
+
+  // Garbage in the output must not survive.
+  std::vector<QueryHit> hits(queries.size());
+  memset(hits.data(), 0xCD, sizeof(QueryHit) * hits.size());
+
+  traceRaysHost(bvh, queries.data(), hits.data(), queries.size());
+
+  size_t numHits   = 0;
+  size_t numMisses = 0;
+
+  for (size_t i = 0; i < queries.size(); ++i)
+  {
+    QueryRay const& query     = queries[i];
+    QueryHit const& hit       = hits[i];
+    BvhHit const&   reference = references[i % rays.size()];
+
+    const bool isMasked   = ((query.mask & 0xFF) == 0);
+    const bool isExpected = !isMasked && isReference[i % rays.size()];
+
+    bool isValid;
+
+    if (!isExpected)
+    {
+      isValid = (hit.t == -1.0f && hit.instance == QUERY_MISS && hit.primitive == QUERY_MISS && hit.u == 0.0f && hit.v == 0.0f);
+      ++numMisses;
+    }
+    else
+    {
+      // Any hit rays may report any hit inside the interval, the closest hit rays exactly the brute force distance.
+      isValid = (hit.instance < bvh.getNumInstances() && query.tmin <= hit.t && hit.t <= query.tmax &&
+                 0.0f <= hit.u && 0.0f <= hit.v && hit.u + hit.v <= 1.0f &&
+                 ((query.flags & QUERY_FLAG_ANY_HIT) != 0 || hit.t == reference.t));
+      ++numHits;
+    }
+
+    if (!isValid)
+    {
+      std::cerr << "ERROR: checkRayQuery() query " << i << " mask " << query.mask << " flags " << query.flags
+                << ": t = " << hit.t << " instance = " << hit.instance << " primitive = " << hit.primitive
+                << ", brute force " << isExpected << " t = " << reference.t << " instance = " << reference.instance << '\n';
+      return false;
+    }
+  }
+
+  // Both outcomes must be covered for the comparison to mean something. The masked third of the queries never hits.
+  if (numHits < queries.size() / 20 || numMisses < queries.size() / 3)
+  {
+    std::cerr << "ERROR: checkRayQuery() " << numHits << " hits of " << queries.size() << " queries\n";
+    return false;
+  }
+
+  std::cout << "ray_query: " << numHits << " hits and " << numMisses << " misses of " << queries.size()
+            << " closest hit, masked and any hit queries match the brute force reference\n";
+  return true;
+}
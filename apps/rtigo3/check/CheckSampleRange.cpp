@@ -0,0 +1,205 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "check/Checks.h"
+
+#include "inc/SampleRange.h"
+
+#include "shaders/vector_math.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+
+// Deterministic radiance of a pixel for a global sample index, like the seeding in the ray generation program.
+static float4 makeSampleRadiance(const size_t pixel, const unsigned int sample)
+{
+  unsigned int h = static_cast<unsigned int>(pixel) * 0x9E3779B9u ^ (sample + 0x7F4A7C15u) * 0x85EBCA6Bu;
+  h ^= h >> 16;
+  h *= 0x7FEB352Du;
+  h ^= h >> 15;
+
+  const float f = float(h & 0xFFFFFF) / float(0x1000000);
+
+  return make_float4(f * 4.0f, f * f, 1.0f - f, 1.0f);
+}
+
+// The running average of the accumulation in the ray generation program over the given global samples.
+static void accumulateSamples(std::vector<float4>& buffer, const unsigned int sampleOffset, const unsigned int count)
+{
+  for (unsigned int iterationIndex = 0; iterationIndex < count; ++iterationIndex)
+  {
+    for (size_t i = 0; i < buffer.size(); ++i)
+    {
+      const float4 radiance = makeSampleRadiance(i, sampleOffset + iterationIndex);
+
+      buffer[i] = (iterationIndex == 0) ? radiance : lerp(buffer[i], radiance, 1.0f / float(iterationIndex + 1));
+    }
+  }
+}
+
+// Returns false when the sample ranges don't partition the samples per pixel,
+// or when the merged device accumulations differ from the scalar weighted sum or from a single device accumulation.
+bool checkSampleRange()
+{
+  for (unsigned int samplesPerPixel = 0; samplesPerPixel <= 257; ++samplesPerPixel)
+  {
+    for (int count = 1; count <= 8; ++count)
+    {
+      unsigned int next = 0;
+
+      for (int index = 0; index < count; ++index)
+      {
+        const SampleRange range = getSampleRange(samplesPerPixel, count, index);
+
+        if (range.begin != next || range.end < range.begin ||
+            (index == 0 && 0 < samplesPerPixel && range.end == 0) ||
+            (range.end - range.begin) > getSampleRange(samplesPerPixel, count, 0).end)
+        {
+          std::cerr << "ERROR: checkSampleRange() range " << index << " of " << count << " devices for " << samplesPerPixel << " samples\n";
+          return false;
+        }
+        if (getSampleCount(range, 0) != 0 || getSampleCount(range, 1) != std::min(1u, range.end - range.begin) ||
+            getSampleCount(range, samplesPerPixel + 1) != range.end - range.begin)
+        {
+          std::cerr << "ERROR: checkSampleRange() sample count of range " << index << " of " << count << " devices\n";
+          return false;
+        }
+        next = range.end;
+      }
+
+      if (next != samplesPerPixel)
+      {
+        std::cerr << "ERROR: checkSampleRange() " << count << " devices don't cover " << samplesPerPixel << " samples\n";
+        return false;
+      }
+    }
+  }
+
+  // No overflow in the intermediates.
+  const SampleRange rangeLast = getSampleRange(0xFFFFFFFFu, 7, 6);
+  if (rangeLast.end != 0xFFFFFFFFu || getSampleRange(0xFFFFFFFFu, 7, 0).end != (0xFFFFFFFFull + 6) / 7)
+  {
+    std::cerr << "ERROR: checkSampleRange() overflow\n";
+    return false;
+  }
+
+  // The merge against the scalar weighted sum, and against one device which accumulated all samples.
+  const size_t       numPixels       = 4099; // Crosses the merge block size with a tail.
+  const unsigned int samplesPerPixel = 13;
+
+  std::vector<float4> single(numPixels);
+  accumulateSamples(single, 0, samplesPerPixel);
+
+  std::vector<float4> merged(numPixels);
+
+  for (int count = 1; count <= 4; ++count)
+  {
+    std::vector< std::vector<float4> > buffers(count, std::vector<float4>(numPixels));
+
+    for (unsigned int iterationIndex = 0; iterationIndex <= samplesPerPixel; ++iterationIndex)
+    {
+      std::vector<const float4*> sources;
+      std::vector<unsigned int>  counts;
+
+      unsigned int total = 0;
+
+      for (int index = 0; index < count; ++index)
+      {
+        const SampleRange range = getSampleRange(samplesPerPixel, count, index);
+
+        counts.push_back(getSampleCount(range, iterationIndex));
+        sources.push_back(buffers[index].data());
+
+        std::fill(buffers[index].begin(), buffers[index].end(), make_float4(NAN)); // Devices without samples must be ignored.
+        accumulateSamples(buffers[index], range.begin, counts.back());
+
+        total += counts.back();
+      }
+
+      std::fill(merged.begin(), merged.end(), make_float4(NAN));
+      mergeSampleRanges(merged.data(), sources, counts, numPixels);
+
+      // The scalar reference in the same operation order.
+      std::vector<float> weights;
+      std::vector<int>   active;
+      for (int index = 0; index < count; ++index)
+      {
+        if (counts[index] != 0)
+        {
+          active.push_back(index);
+          weights.push_back(float(counts[index]));
+        }
+      }
+      for (float& weight : weights)
+      {
+        weight /= float(total);
+      }
+
+      for (size_t i = 0; i < numPixels; ++i)
+      {
+        float4 expected = make_float4(0.0f);
+
+        if (active.size() == 1)
+        {
+          expected = buffers[active[0]][i];
+        }
+        else if (1 < active.size())
+        {
+          expected = buffers[active[0]][i] * weights[0];
+          for (size_t s = 1; s < active.size(); ++s)
+          {
+            expected = expected + buffers[active[s]][i] * weights[s];
+          }
+        }
+
+        if (memcmp(&merged[i], &expected, sizeof(float4)) != 0)
+        {
+          std::cerr << "ERROR: checkSampleRange() merge of " << count << " devices at iteration " << iterationIndex << " differs from the scalar sum at pixel " << i << '\n';
+          return false;
+        }
+      }
+    }
+
+    // All ranges done: the merge matches the single device accumulation up to the float rounding of the running averages.
+    for (size_t i = 0; i < numPixels; ++i)
+    {
+      const float4 d = merged[i] - single[i];
+
+      if (1.0e-5f < std::max(std::max(fabsf(d.x), fabsf(d.y)), std::max(fabsf(d.z), fabsf(d.w))))
+      {
+        std::cerr << "ERROR: checkSampleRange() merge of " << count << " devices differs from the single device accumulation at pixel " << i << '\n';
+        return false;
+      }
+    }
+  }
+  return true;
+}
@@ -0,0 +1,143 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "check/Checks.h"
+#include "bench/Fixtures.h"
+
+#include "inc/SceneGraph.h"
+#include "inc/SceneInterpreter.h"
+
+#include "shaders/vector_math.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// Compares everything the renderer reads from the host scene. Transforms and vertex attributes must match bitwise.
+static bool compareScenes(SceneResult const& a, SceneResult const& b)
+{
+  if (a.idGeometry != b.idGeometry || a.idInstance != b.idInstance ||
+      a.mapGeometries != b.mapGeometries || a.mapMaterialReferences != b.mapMaterialReferences ||
+      a.materials.size() != b.materials.size() || a.geometries.size() != b.geometries.size() ||
+      a.scene->getNumChildren() != b.scene->getNumChildren())
+  {
+    return false;
+  }
+
+  for (size_t i = 0; i < a.materials.size(); ++i)
+  {
+    SceneMaterial const& ma = a.materials[i];
+    SceneMaterial const& mb = b.materials[i];
+
+    if (ma.reference != mb.reference || ma.name != mb.name || ma.thinwalled != mb.thinwalled ||
+        memcmp(&ma.albedo, &mb.albedo, sizeof(float3)) != 0 ||
+        memcmp(&ma.roughness, &mb.roughness, sizeof(float2)) != 0 ||
+        memcmp(&ma.absorptionColor, &mb.absorptionColor, sizeof(float3)) != 0 ||
+        memcmp(&ma.absorptionScale, &mb.absorptionScale, sizeof(float)) != 0 ||
+        memcmp(&ma.ior, &mb.ior, sizeof(float)) != 0)
+    {
+      return false;
+    }
+  }
+
+  for (size_t i = 0; i < a.geometries.size(); ++i)
+  {
+    std::vector<TriangleAttributes> const& attributesA = a.geometries[i]->getAttributes();
+    std::vector<TriangleAttributes> const& attributesB = b.geometries[i]->getAttributes();
+    
+    if (a.geometries[i]->getId() != b.geometries[i]->getId() ||
+        attributesA.size() != attributesB.size() ||
+        a.geometries[i]->getIndices() != b.geometries[i]->getIndices() ||
+        (!attributesA.empty() && memcmp(attributesA.data(), attributesB.data(), sizeof(TriangleAttributes) * attributesA.size()) != 0))
+    {
+      return false;
+    }
+  }
+
+  for (size_t i = 0; i < a.scene->getNumChildren(); ++i)
+  {
+    std::shared_ptr<sg::Instance> instanceA = a.scene->getChild(i);
+    std::shared_ptr<sg::Instance> instanceB = b.scene->getChild(i);
+
+    if (instanceA->getId() != instanceB->getId() ||
+        instanceA->getMaterial() != instanceB->getMaterial() ||
+        memcmp(instanceA->getTransform(), instanceB->getTransform(), sizeof(float) * 12) != 0 ||
+        instanceA->getChild()->getId() != instanceB->getChild()->getId())
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Expands the same scene description serially and on all hardware threads. The scene graphs must be identical.
+bool checkScene()
+{
+  const int instances = 20000;
+
+  const std::string filename = "rtigo3_check_models.txt";
+  writeSceneModels(filename, instances);
+
+  const unsigned int numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+  SceneResult serial;
+  SceneResult parallel;
+
+  // The unknown material warnings of the missing references go to std::cerr.
+  std::streambuf* bufferCerr = std::cerr.rdbuf(nullptr);
+
+  const bool isInterpreted = interpretScene(filename, 1, serial) && interpretScene(filename, numThreads, parallel);
+
+  std::cerr.rdbuf(bufferCerr);
+
+  remove(filename.c_str());
+
+  if (!isInterpreted)
+  {
+    std::cerr << "ERROR: checkScene() failed to interpret " << filename << '\n';
+    return false;
+  }
+
+  const bool identical = compareScenes(serial, parallel);
+
+  std::cout << "scene: " << serial.scene->getNumChildren() << " instances, " << serial.geometries.size() << " geometries, "
+            << numThreads << " threads, scene graphs " << ((identical) ? "identical" : "DIFFERENT") << '\n';
+
+  if (!identical)
+  {
+    std::cerr << "ERROR: checkScene() the parallel scene expansion doesn't match the serial one\n";
+  }
+  return identical;
+}
@@ -0,0 +1,179 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "check/Checks.h"
+#include "bench/Fixtures.h"
+
+#include "inc/SceneDiff.h"
+#include "inc/SceneGraph.h"
+
+#include "shaders/vector_math.h"
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+static std::shared_ptr<sg::Instance> makeInstance(const unsigned int id, const float scale, const float3 translation, const int idMaterial, const int idLight,
+                                                  std::shared_ptr<sg::Node> child)
+{
+  const float matrix[12] = { scale, 0.0f, 0.0f, translation.x,
+                             0.0f, scale, 0.0f, translation.y,
+                             0.0f, 0.0f, scale, translation.z };
+
+  std::shared_ptr<sg::Instance> instance = std::make_shared<sg::Instance>(id);
+
+  instance->setTransform(matrix);
+  instance->setChild(child);
+  if (0 <= idMaterial)
+  {
+    instance->setMaterial(idMaterial);
+  }
+  if (0 <= idLight)
+  {
+    instance->setLight(idLight);
+  }
+  return instance;
+}
+
+static bool isSceneInstance(SceneInstance const& instance, const unsigned int idGeometry, const int idMaterial, const int idLight, const float scale, const float3 translation)
+{
+  const float matrix[12] = { scale, 0.0f, 0.0f, translation.x,
+                             0.0f, scale, 0.0f, translation.y,
+                             0.0f, 0.0f, scale, translation.z };
+
+  return instance.idGeometry == idGeometry && instance.idMaterial == idMaterial && instance.idLight == idLight &&
+         memcmp(instance.matrix, matrix, sizeof(matrix)) == 0;
+}
+
+// Returns false when the flattening of the scene graph or the hot reload diff of two scene states doesn't list exactly the expected device updates.
+bool checkSceneDiff()
+{
+  // root -> A (material 0, translate x 1) -> geometry 10
+  //      -> B (material 1, scale 2)       -> group -> C (light 0, translate y 3) -> geometry 11
+  //                                                -> D (inherits material 1)    -> geometry 10
+  std::shared_ptr<sg::Triangles> geometry10 = std::make_shared<sg::Triangles>(10);
+  std::shared_ptr<sg::Triangles> geometry11 = std::make_shared<sg::Triangles>(11);
+
+  std::shared_ptr<sg::Group> group = std::make_shared<sg::Group>(1);
+  group->addChild(makeInstance(4, 1.0f, make_float3(0.0f, 3.0f, 0.0f), -1, 0, geometry11));
+  group->addChild(makeInstance(5, 1.0f, make_float3(0.0f, 0.0f, 0.0f), -1, -1, geometry10));
+
+  std::shared_ptr<sg::Group> root = std::make_shared<sg::Group>(0);
+  root->addChild(makeInstance(2, 1.0f, make_float3(1.0f, 0.0f, 0.0f), 0, -1, geometry10));
+  root->addChild(makeInstance(3, 2.0f, make_float3(0.0f, 0.0f, 0.0f), 1, -1, group));
+
+  SceneDescription before;
+
+  flattenScene(root, before.instances);
+
+  if (before.instances.size() != 3 ||
+      !isSceneInstance(before.instances[0], 10, 0, -1, 1.0f, make_float3(1.0f, 0.0f, 0.0f)) ||
+      !isSceneInstance(before.instances[1], 11, 1,  0, 2.0f, make_float3(0.0f, 6.0f, 0.0f)) ||
+      !isSceneInstance(before.instances[2], 10, 1, -1, 2.0f, make_float3(0.0f, 0.0f, 0.0f)))
+  {
+    std::cerr << "ERROR: checkSceneDiff() flattened instances\n";
+    return false;
+  }
+
+  before.materials.push_back(makeMaterial(1.5f));
+  before.materials.push_back(makeMaterial(1.33f));
+
+  LightDefinition light = LightDefinition();
+  light.emission = make_float3(1.0f, 1.0f, 1.0f);
+  before.lights.push_back(light);
+
+  struct Case
+  {
+    const char*      name;
+    SceneDescription after;
+    const char*      summary;
+  };
+
+  std::vector<Case> cases;
+
+  cases.push_back({ "unchanged", before, "materials 0, lights 0, instances 0 moved, geometries +0 -0" });
+
+  cases.push_back({ "material parameter", before, "materials 1, lights 0, instances 0 moved, geometries +0 -0" });
+  cases.back().after.materials[1].roughness.x = 0.5f;
+
+  cases.push_back({ "material added", before, "materials all, lights 0, instances 0 moved, geometries +0 -0" });
+  cases.back().after.materials.push_back(makeMaterial(1.0f));
+
+  cases.push_back({ "light emission", before, "materials 0, lights 1, instances 0 moved, geometries +0 -0" });
+  cases.back().after.lights[0].emission.y = 2.0f;
+
+  cases.push_back({ "light removed", before, "materials 0, lights all, instances 0 moved, geometries +0 -0" });
+  cases.back().after.lights.clear();
+
+  cases.push_back({ "transform", before, "materials 0, lights 0, instances 2 moved, geometries +0 -0" });
+  cases.back().after.instances[0].matrix[3] = 2.0f;
+  cases.back().after.instances[2].matrix[0] = 3.0f;
+
+  cases.push_back({ "instance material", before, "materials 0, lights 0, instances rebuilt, geometries +0 -0" });
+  cases.back().after.instances[0].matrix[3] = 2.0f; // The rebuild covers the moved instance.
+  cases.back().after.instances[2].idMaterial = 0;
+
+  cases.push_back({ "geometry replaced", before, "materials 0, lights 0, instances rebuilt, geometries +1 -1" });
+  cases.back().after.instances[1].idGeometry = 12;
+
+  cases.push_back({ "instance removed", before, "materials 0, lights 0, instances rebuilt, geometries +0 -0" });
+  cases.back().after.instances.pop_back();
+
+  cases.push_back({ "instance appended", before, "materials 0, lights 0, instances rebuilt, geometries +1 -0" });
+  cases.back().after.instances.push_back(before.instances[1]);
+  cases.back().after.instances.back().idGeometry = 13;
+
+  for (Case const& c : cases)
+  {
+    const SceneDiff diff = diffScenes(before, c.after);
+
+    const std::string summary = formatSceneDiff(diff);
+    if (summary != c.summary || isEmpty(diff) != (c.name == cases[0].name))
+    {
+      std::cerr << "ERROR: checkSceneDiff() case '" << c.name << "': " << summary << '\n';
+      return false;
+    }
+  }
+
+  // The indices of the updates, not only their counts.
+  const SceneDiff diffMaterial  = diffScenes(before, cases[1].after);
+  const SceneDiff diffTransform = diffScenes(before, cases[5].after);
+  const SceneDiff diffGeometry  = diffScenes(before, cases[7].after);
+
+  if (diffMaterial.materials != std::vector<int>(1, 1) ||
+      diffTransform.instancesMoved != std::vector<unsigned int>({ 0, 2 }) ||
+      diffGeometry.geometriesAdded != std::vector<unsigned int>(1, 12) || diffGeometry.geometriesRemoved != std::vector<unsigned int>(1, 11))
+  {
+    std::cerr << "ERROR: checkSceneDiff() update indices\n";
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,110 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "check/Checks.h"
+
+#include "inc/TileLayout.h"
+
+#include "shaders/tile_layout.h"
+#include "shaders/vector_math.h"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+// Returns false when the tile ordered layout isn't a bijection or the host detiling doesn't round-trip bit exactly.
+bool checkTileLayout()
+{
+  const int2 resolutions[] = { make_int2(1, 1), make_int2(7, 5), make_int2(33, 17), make_int2(64, 64), make_int2(1921, 1083) };
+  const int2 tileSizes[]   = { make_int2(1, 1), make_int2(8, 8), make_int2(8, 4), make_int2(16, 2), make_int2(2, 32), make_int2(64, 64) };
+
+  std::mt19937 rng(99);
+  std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+
+  for (const int2 resolution : resolutions)
+  {
+    const size_t numPixels = size_t(resolution.x) * resolution.y;
+
+    std::vector<float4> linear(numPixels);
+    for (float4& c : linear)
+    {
+      c = make_float4(uniform(rng), uniform(rng), uniform(rng), uniform(rng));
+    }
+
+    for (const int2 tileSize : tileSizes)
+    {
+      int2 shift = make_int2(0, 0);
+      while ((1 << shift.x) < tileSize.x)
+      {
+        ++shift.x;
+      }
+      while ((1 << shift.y) < tileSize.y)
+      {
+        ++shift.y;
+      }
+
+      const int2   tiles = tileCount(resolution, shift);
+      const size_t size  = getTiledBufferSize(resolution, tileSize);
+
+      // Every pixel needs its own element inside the padded buffer.
+      std::vector<unsigned char> used(size, 0);
+
+      std::vector<float4> tiled(size, make_float4(-2.0f, -2.0f, -2.0f, -2.0f));
+      retileHost(tiled.data(), linear.data(), resolution, tileSize);
+
+      for (int y = 0; y < resolution.y; ++y)
+      {
+        for (int x = 0; x < resolution.x; ++x)
+        {
+          const unsigned int index = tiledIndex(x, y, tiles.x, shift);
+          if (size <= index || used[index] || memcmp(&tiled[index], &linear[size_t(y) * resolution.x + x], sizeof(float4)) != 0)
+          {
+            std::cerr << "ERROR: checkTileLayout() pixel " << x << ", " << y << " of " << resolution.x << "x" << resolution.y
+                      << " with tile size " << tileSize.x << "x" << tileSize.y << '\n';
+            return false;
+          }
+          used[index] = 1;
+        }
+      }
+
+      std::vector<float4> result(numPixels);
+      detileHost(result.data(), tiled.data(), resolution, tileSize);
+
+      if (memcmp(result.data(), linear.data(), sizeof(float4) * numPixels) != 0)
+      {
+        std::cerr << "ERROR: checkTileLayout() round-trip of " << resolution.x << "x" << resolution.y
+                  << " with tile size " << tileSize.x << "x" << tileSize.y << '\n';
+        return false;
+      }
+    }
+  }
+  return true;
+}
@@ -0,0 +1,158 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "check/Checks.h"
+
+#include "inc/TimeView.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+// Returns false when the multi-GPU merge, the aggregation or the CSV export of the time view differ from the hand computed report.
+bool checkTimeView()
+{
+  // 5x3 pixels with i cycles at linear index i. Two devices render the even and odd pixels.
+  // Columns 0-1 hit instance 0 with material 3, columns 2-3 hit instance 1 with material 0, column 4 misses.
+  const int width  = 5;
+  const int height = 3;
+
+  std::vector<float>        cyclesDevice[2];
+  std::vector<unsigned int> idsDevice[2];
+
+  for (int device = 0; device < 2; ++device)
+  {
+    cyclesDevice[device].assign(width * height, 0.0f);
+    idsDevice[device].assign(width * height * 2, 0);
+
+    for (int i = device; i < width * height; i += 2)
+    {
+      const int x = i % width;
+
+      cyclesDevice[device][i] = float(i);
+      if (x < 4)
+      {
+        idsDevice[device][i * 2    ] = (x < 2) ? 1 : 2; // Instance ID + 1
+        idsDevice[device][i * 2 + 1] = (x < 2) ? 4 : 1; // Material index + 1
+      }
+    }
+  }
+
+  std::vector<float>        cycles;
+  std::vector<unsigned int> ids;
+
+  accumulateTimeView(cycles, ids, cyclesDevice[0], idsDevice[0]);
+  accumulateTimeView(cycles, ids, cyclesDevice[1], idsDevice[1]);
+
+  for (int i = 0; i < width * height; ++i)
+  {
+    if (cycles[i] != float(i))
+    {
+      std::cerr << "ERROR: checkTimeView() merged cycles at " << i << '\n';
+      return false;
+    }
+  }
+
+  TimeViewReport report;
+
+  if (analyzeTimeView(cycles, std::vector<unsigned int>(3), width, height, 2, 2, 4, 3, report) ||
+      analyzeTimeView(cycles, ids, width, height + 1, 2, 2, 4, 3, report))
+  {
+    std::cerr << "ERROR: checkTimeView() accepted inconsistent sizes\n";
+    return false;
+  }
+
+  if (!analyzeTimeView(cycles, ids, width, height, 2, 2, 4, 3, report))
+  {
+    std::cerr << "ERROR: checkTimeView() rejected valid input\n";
+    return false;
+  }
+
+  std::vector<std::string> materialNames;
+  materialNames.push_back("Floor");
+
+  const std::string expected =
+    "# summary\n"
+    "width,height,tileWidth,tileHeight,minimum,maximum,average\n"
+    "5,3,2,2,0,14,7\n"
+    "\n# histogram\n"
+    "bin,lower,upper,pixels\n"
+    "0,0,3.5,4\n"
+    "1,3.5,7,3\n"
+    "2,7,10.5,4\n"
+    "3,10.5,14,4\n"
+    "\n# tiles\n"
+    "rank,tileX,tileY,pixelX,pixelY,cycles\n"
+    "0,2,1,4,2,14\n"
+    "1,1,1,2,2,12.5\n"
+    "2,0,1,0,2,10.5\n"
+    "\n# materials\n"
+    "material,name,pixels,cycles\n"
+    "-1,miss,3,9\n"
+    "0,Floor,6,7.5\n"
+    "3,,6,5.5\n"
+    "\n# instances\n"
+    "instance,pixels,cycles\n"
+    "-1,3,9\n"
+    "1,6,7.5\n"
+    "0,6,5.5\n";
+
+  const std::string csv = formatTimeViewCSV(report, materialNames);
+  if (csv != expected)
+  {
+    std::cerr << "ERROR: checkTimeView() CSV output\n" << csv;
+    return false;
+  }
+
+  // Names with separators, quotes and line breaks are quoted fields with doubled quotes.
+  materialNames.assign(4, std::string());
+  materialNames[0] = "Floor, \"rough\"";
+  materialNames[3] = "Glass\nthin";
+
+  const std::string expectedMaterials =
+    "material,name,pixels,cycles\n"
+    "-1,miss,3,9\n"
+    "0,\"Floor, \"\"rough\"\"\",6,7.5\n"
+    "3,\"Glass\nthin\",6,5.5\n";
+
+  if (formatTimeViewCSV(report, materialNames).find(expectedMaterials) == std::string::npos)
+  {
+    std::cerr << "ERROR: checkTimeView() CSV quoting\n" << formatTimeViewCSV(report, materialNames);
+    return false;
+  }
+
+  // A constant image has no histogram range. Everything goes into the first bin.
+  if (!analyzeTimeView(std::vector<float>(width * height, 3.0f), std::vector<unsigned int>(), width, height, 4, 4, 8, 100, report) ||
+      report.histogram[0] != unsigned(width * height) || report.binWidth != 0.0 || report.tiles.size() != 2 || !report.materials.empty())
+  {
+    std::cerr << "ERROR: checkTimeView() constant image\n";
+    return false;
+  }
+  return true;
+}
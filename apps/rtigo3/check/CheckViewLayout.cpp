@@ -0,0 +1,251 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "check/Checks.h"
+
+#include "inc/Camera.h"
+#include "inc/ViewLayout.h"
+
+#include "shaders/vector_math.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+static bool isFinite(const float3 v)
+{
+  return std::isfinite(v.x) && std::isfinite(v.y) && std::isfinite(v.z);
+}
+
+// Returns an empty string when the views tile the resolution exactly once, their sizes differ by at most a pixel per axis
+// and every view references its own camera with a usable frustum.
+static std::string validateLayout(const int2 resolution,
+                                  std::vector<CameraDefinition> const& cameras,
+                                  std::vector<ViewDefinition> const& views)
+{
+  std::vector<unsigned char> covered(size_t(resolution.x) * resolution.y, 0);
+  std::vector<unsigned char> referenced(cameras.size(), 0);
+
+  int2 minSize = resolution;
+  int2 maxSize = make_int2(0, 0);
+
+  for (ViewDefinition const& view : views)
+  {
+    if (view.size.x <= 0 || view.size.y <= 0 ||
+        view.origin.x < 0 || view.origin.y < 0 ||
+        resolution.x < view.origin.x + view.size.x || resolution.y < view.origin.y + view.size.y)
+    {
+      return "view outside of the resolution";
+    }
+    if (view.idCamera < 1 || int(cameras.size()) <= view.idCamera || referenced[view.idCamera])
+    {
+      return "invalid or shared idCamera " + std::to_string(view.idCamera);
+    }
+    referenced[view.idCamera] = 1;
+
+    CameraDefinition const& c = cameras[view.idCamera];
+    if (!isFinite(c.P) || !isFinite(c.U) || !isFinite(c.V) || !isFinite(c.W) ||
+        length(c.U) < 1e-6f || length(c.V) < 1e-6f || length(c.W) < 1e-6f ||
+        1e-4f < fabsf(dot(normalize(c.U), normalize(c.V))) ||
+        1e-4f < fabsf(dot(normalize(c.U), normalize(c.W))) ||
+        1e-4f < fabsf(dot(normalize(c.V), normalize(c.W))))
+    {
+      return "degenerate camera " + std::to_string(view.idCamera);
+    }
+
+    minSize = make_int2(std::min(minSize.x, view.size.x), std::min(minSize.y, view.size.y));
+    maxSize = make_int2(std::max(maxSize.x, view.size.x), std::max(maxSize.y, view.size.y));
+
+    for (int y = view.origin.y; y < view.origin.y + view.size.y; ++y)
+    {
+      for (int x = view.origin.x; x < view.origin.x + view.size.x; ++x)
+      {
+        if (covered[size_t(y) * resolution.x + x]++)
+        {
+          return "overlapping views at pixel " + std::to_string(x) + ", " + std::to_string(y);
+        }
+      }
+    }
+  }
+
+  if (std::find(covered.begin(), covered.end(), 0) != covered.end())
+  {
+    return "uncovered pixels";
+  }
+  if (1 < maxSize.x - minSize.x || 1 < maxSize.y - minSize.y)
+  {
+    return "view sizes differ by more than a pixel";
+  }
+  if (cameras.size() != views.size() + 1)
+  {
+    return "unreferenced cameras";
+  }
+  return std::string();
+}
+
+// Returns false when a stereo, cube or grid layout doesn't tile the output buffer or derives wrong cameras.
+bool checkViewLayout()
+{
+  // Includes odd and prime resolutions which aren't evenly divisible by the layouts.
+  const int2 resolutions[] = { make_int2(1, 1), make_int2(2, 1), make_int2(3, 2), make_int2(7, 5), make_int2(33, 17),
+                               make_int2(97, 61), make_int2(640, 480), make_int2(1921, 1083) };
+  const int2 grids[]       = { make_int2(1, 1), make_int2(2, 2), make_int2(3, 5), make_int2(8, 8), make_int2(16, 9), make_int2(0, 4) };
+
+  int numLayouts = 0;
+  int numViews   = 0;
+
+  std::vector<CameraDefinition> cameras;
+  std::vector<ViewDefinition>   views;
+
+  for (const int2 resolution : resolutions)
+  {
+    Camera interactive;
+    interactive.setResolution(resolution.x, resolution.y);
+    interactive.setBaseCoordinates(0, 0);
+    interactive.orbit(37, 11);
+
+    CameraDefinition camera;
+    interactive.getFrustum(camera.P, camera.U, camera.V, camera.W, true);
+
+    const float3 center = interactive.m_center;
+
+    for (int layout = 0; layout < VIEW_LAYOUT_COUNT; ++layout)
+    {
+      for (const int2 grid : grids)
+      {
+        if (layout != VIEW_LAYOUT_GRID && (grid.x != 1 || grid.y != 1))
+        {
+          continue; // Only the grid layout depends on the grid size.
+        }
+
+        createViewLayout(layout, grid, resolution, camera, center, cameras, views);
+
+        const std::string where = " of layout " + std::to_string(layout) + " grid " + std::to_string(grid.x) + "x" + std::to_string(grid.y) +
+                                  " at " + std::to_string(resolution.x) + "x" + std::to_string(resolution.y);
+
+        if (cameras.empty() || memcmp(&cameras[0], &camera, sizeof(CameraDefinition)) != 0)
+        {
+          std::cerr << "ERROR: checkViewLayout() cameras[0] isn't the interactive camera" << where << '\n';
+          return false;
+        }
+
+        size_t expected = 0;
+        switch (layout)
+        {
+          case VIEW_LAYOUT_STEREO:
+            expected = (2 <= resolution.x) ? 2 : 0;
+            break;
+          case VIEW_LAYOUT_CUBE:
+            expected = (3 <= resolution.x && 2 <= resolution.y) ? 6 : 0;
+            break;
+          case VIEW_LAYOUT_GRID:
+            expected = size_t(std::max(1, std::min(grid.x, resolution.x))) * std::max(1, std::min(grid.y, resolution.y));
+            break;
+        }
+        if (views.size() != expected)
+        {
+          std::cerr << "ERROR: checkViewLayout() " << views.size() << " views instead of " << expected << where << '\n';
+          return false;
+        }
+        if (views.empty())
+        {
+          continue;
+        }
+
+        const std::string error = validateLayout(resolution, cameras, views);
+        if (!error.empty())
+        {
+          std::cerr << "ERROR: checkViewLayout() " << error << where << '\n';
+          return false;
+        }
+
+        for (ViewDefinition const& view : views)
+        {
+          CameraDefinition const& c = cameras[view.idCamera];
+
+          // Stereo and grid views keep the vertical field of view and match the aspect ratio of their region.
+          // Cube faces always span 90 degrees.
+          const float aspect         = length(c.U) / length(c.V);
+          const float expectedAspect = (layout == VIEW_LAYOUT_CUBE) ? 1.0f : float(view.size.x) / float(view.size.y);
+          const float expectedV      = (layout == VIEW_LAYOUT_CUBE) ? 1.0f : length(camera.V);
+
+          if (1e-4f < fabsf(aspect - expectedAspect) / expectedAspect || 1e-4f < fabsf(length(c.V) - expectedV) / expectedV)
+          {
+            std::cerr << "ERROR: checkViewLayout() frustum of camera " << view.idCamera << where << '\n';
+            return false;
+          }
+
+          // Grid cameras orbit the center of interest, the others stay at the interactive camera position.
+          const float distance         = (layout == VIEW_LAYOUT_GRID) ? length(c.P - center) : length(c.P - camera.P);
+          const float expectedDistance = (layout == VIEW_LAYOUT_GRID)   ? length(camera.P - center) :
+                                         (layout == VIEW_LAYOUT_STEREO) ? length(camera.P - center) / 60.0f : 0.0f;
+          if (1e-3f * std::max(1.0f, expectedDistance) < fabsf(distance - expectedDistance))
+          {
+            std::cerr << "ERROR: checkViewLayout() position of camera " << view.idCamera << where << '\n';
+            return false;
+          }
+        }
+
+        if (layout == VIEW_LAYOUT_CUBE)
+        {
+          // The six faces look along all principal axes.
+          float3 sum = make_float3(0.0f, 0.0f, 0.0f);
+          float3 extent = make_float3(0.0f, 0.0f, 0.0f);
+          for (ViewDefinition const& view : views)
+          {
+            const float3 w = cameras[view.idCamera].W;
+            sum += w;
+            extent += make_float3(fabsf(w.x), fabsf(w.y), fabsf(w.z));
+          }
+          if (1e-6f < length(sum) || 1e-6f < length(extent - make_float3(2.0f, 2.0f, 2.0f)))
+          {
+            std::cerr << "ERROR: checkViewLayout() cube faces don't cover all axes" << where << '\n';
+            return false;
+          }
+        }
+
+        ++numLayouts;
+        numViews += int(views.size());
+      }
+    }
+  }
+
+  // Resolutions too small for any view.
+  createViewLayout(VIEW_LAYOUT_GRID, make_int2(4, 4), make_int2(0, 0), CameraDefinition(), make_float3(0.0f, 0.0f, 0.0f), cameras, views);
+  if (!views.empty() || cameras.size() != 1)
+  {
+    std::cerr << "ERROR: checkViewLayout() views for an empty resolution\n";
+    return false;
+  }
+
+  std::cout << "view_layout: " << numViews << " views in " << numLayouts << " layouts tile their resolution exactly once\n";
+  return true;
+}
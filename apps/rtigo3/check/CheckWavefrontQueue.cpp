@@ -0,0 +1,207 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "check/Checks.h"
+#include "bench/Fixtures.h"
+
+#include "inc/WavefrontQueue.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+// Returns false when the host queue sort differs from a stable sort by key, when the device block structure with
+// blocks finishing in any order produces an invalid queue, or when the bounce bookkeeping loses rays.
+bool checkWavefrontQueue()
+{
+  const unsigned int counts[]  = { 0, 1, 2, WAVEFRONT_BLOCK_SIZE - 1, WAVEFRONT_BLOCK_SIZE, WAVEFRONT_BLOCK_SIZE + 1, 10007 };
+  const float        endeds[]  = { 0.0f, 0.3f, 1.0f };
+  const unsigned int numKeys[] = { 1, 2, WAVEFRONT_NUM_KEYS };
+
+  for (const unsigned int count : counts)
+  {
+    for (const float ended : endeds)
+    {
+      for (const unsigned int n : numKeys)
+      {
+        const std::vector<unsigned int> keys = makeWavefrontKeys(count, n, ended, count + n);
+
+        // Host sort, all slots in one block: stable.
+        WavefrontCounters counters;
+        memset(&counters, 0, sizeof(WavefrontCounters));
+
+        std::vector<unsigned int> sortedQueue(count, ~0u);
+
+        const unsigned int numHits = sortWavefrontQueue(keys.data(), count, counters, sortedQueue.data());
+
+        std::vector<unsigned int> reference;
+        for (unsigned int slot = 0; slot < count; ++slot)
+        {
+          if (keys[slot] != WAVEFRONT_KEY_NONE)
+          {
+            reference.push_back(slot);
+          }
+        }
+        std::stable_sort(reference.begin(), reference.end(), [&keys](const unsigned int a, const unsigned int b) { return keys[a] < keys[b]; });
+
+        unsigned int sumHistogram = 0;
+        for (unsigned int key = 0; key < WAVEFRONT_NUM_KEYS; ++key)
+        {
+          sumHistogram += counters.histogram[key];
+        }
+
+        if (numHits != reference.size() || counters.hits != numHits || sumHistogram != numHits ||
+            !std::equal(reference.begin(), reference.end(), sortedQueue.begin()) ||
+            !isSortedWavefrontQueue(keys.data(), count, sortedQueue.data(), numHits))
+        {
+          std::cerr << "ERROR: checkWavefrontQueue() host sort of " << count << " slots with " << n << " keys\n";
+          return false;
+        }
+
+        // The device kernels: per block counts, then the offsets, then the scatter with the blocks in a random order.
+        WavefrontCounters device;
+        memset(&device, 0, sizeof(WavefrontCounters));
+
+        const unsigned int numBlocks = (count + WAVEFRONT_BLOCK_SIZE - 1) / WAVEFRONT_BLOCK_SIZE;
+
+        std::vector<unsigned int> blocks(numBlocks);
+        for (unsigned int b = 0; b < numBlocks; ++b)
+        {
+          blocks[b] = b;
+        }
+
+        std::mt19937 rng(count * 3 + n);
+
+        for (int pass = 0; pass < 2; ++pass)
+        {
+          std::shuffle(blocks.begin(), blocks.end(), rng);
+
+          for (const unsigned int b : blocks)
+          {
+            const unsigned int first = b * WAVEFRONT_BLOCK_SIZE;
+            const unsigned int last  = std::min(first + WAVEFRONT_BLOCK_SIZE, count);
+
+            unsigned int blockCounts[WAVEFRONT_NUM_KEYS] = {};
+            unsigned int ranks[WAVEFRONT_BLOCK_SIZE];
+
+            for (unsigned int slot = first; slot < last; ++slot)
+            {
+              ranks[slot - first] = wavefrontCountKey(blockCounts, keys[slot]);
+            }
+
+            if (pass == 0) // wavefront_histogram
+            {
+              for (unsigned int key = 0; key < WAVEFRONT_NUM_KEYS; ++key)
+              {
+                wavefrontAddHistogram(&device, blockCounts, key);
+              }
+            }
+            else // wavefront_scatter
+            {
+              unsigned int bases[WAVEFRONT_NUM_KEYS];
+              for (unsigned int key = 0; key < WAVEFRONT_NUM_KEYS; ++key)
+              {
+                bases[key] = wavefrontReserve(&device, blockCounts, key);
+              }
+              for (unsigned int slot = first; slot < last; ++slot)
+              {
+                if (keys[slot] < WAVEFRONT_NUM_KEYS)
+                {
+                  sortedQueue[bases[keys[slot]] + ranks[slot - first]] = slot;
+                }
+              }
+            }
+          }
+
+          if (pass == 0) // wavefront_offsets
+          {
+            wavefrontSortOffsets(&device);
+            std::fill(sortedQueue.begin(), sortedQueue.end(), ~0u);
+          }
+        }
+
+        if (device.hits != numHits || !isSortedWavefrontQueue(keys.data(), count, sortedQueue.data(), device.hits))
+        {
+          std::cerr << "ERROR: checkWavefrontQueue() device blocks of " << count << " slots with " << n << " keys\n";
+          return false;
+        }
+
+        // The validation must catch broken queues.
+        if (2 <= numHits)
+        {
+          std::vector<unsigned int> broken(sortedQueue);
+          broken[1] = broken[0];
+
+          if (isSortedWavefrontQueue(keys.data(), count, broken.data(), numHits) ||
+              isSortedWavefrontQueue(keys.data(), count, sortedQueue.data(), numHits - 1))
+          {
+            std::cerr << "ERROR: checkWavefrontQueue() accepted a broken queue\n";
+            return false;
+          }
+        }
+      }
+    }
+  }
+
+  // Bounce bookkeeping: the shading launch appends to the other ray queue, which the next trace launch reads.
+  WavefrontCounters counters;
+  memset(&counters, 0, sizeof(WavefrontCounters));
+
+  wavefrontReset(&counters, 1000);
+
+  unsigned long long traced = 0;
+  unsigned int       paths  = 1000;
+
+  for (int bounce = 0; bounce < 5; ++bounce)
+  {
+    if (counters.depth != bounce || counters.rays[counters.parity] != paths || counters.rays[counters.parity ^ 1] != 0)
+    {
+      std::cerr << "ERROR: checkWavefrontQueue() ray queues at bounce " << bounce << '\n';
+      return false;
+    }
+
+    counters.histogram[0] = paths / 2;
+    counters.shadows      = paths / 3;
+    paths                 = paths * 3 / 5;
+    counters.rays[counters.parity ^ 1] = paths; // Continued paths.
+
+    traced += counters.rays[counters.parity] + counters.shadows;
+
+    wavefrontAdvance(&counters);
+
+    if (counters.traced != traced || counters.hits != 0 || counters.shadows != 0 || counters.histogram[0] != 0)
+    {
+      std::cerr << "ERROR: checkWavefrontQueue() advance at bounce " << bounce << '\n';
+      return false;
+    }
+  }
+  return true;
+}
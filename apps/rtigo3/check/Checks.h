@@ -0,0 +1,61 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef CHECKS_H
+#define CHECKS_H
+
+// Host side correctness checks of the rtigo3_check target, one translation unit per checked module.
+// Each check prints a one line summary to std::cout. On failure it prints the reason to std::cerr and returns false.
+
+bool checkPipelineKey();
+bool checkTimeView();
+bool checkAccelPolicy();
+bool checkHostBVH();
+bool checkRayQuery();
+bool checkBatch();
+bool checkSceneDiff();
+bool checkEnvFormat();
+bool checkSampleRange();
+bool checkHostResidency();
+bool checkWavefrontQueue();
+bool checkGltfLoader();
+bool checkMicrofacet();
+bool checkLightParallelogram();
+bool checkRayCone();
+bool checkAdaptiveRoulette();
+bool checkBufferCache();
+bool checkTileLayout();
+bool checkParameterChannel();
+bool checkInputTrace();
+bool checkScene();
+bool checkViewLayout();
+bool checkAov();
+
+#endif // CHECKS_H
@@ -0,0 +1,136 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// rtigo3_check: Host side correctness checks of the CPU code paths and the host compiled shader functions in rtigo3.
+// None of the checks need a GPU. They run in a fixed order and stop at the first failure.
+//
+// Usage: rtigo3_check [--filter <substring>]
+
+#include "check/Checks.h"
+
+#include <exception>
+#include <iostream>
+#include <string>
+
+
+struct CheckCase
+{
+  const char* name;
+  bool (*check)();
+};
+
+static const CheckCase g_checks[] =
+{
+  { "pipeline_key",        checkPipelineKey },
+  { "time_view",           checkTimeView },
+  { "accel_policy",        checkAccelPolicy },
+  { "host_bvh",            checkHostBVH },
+  { "ray_query",           checkRayQuery },
+  { "batch",               checkBatch },
+  { "scene_diff",          checkSceneDiff },
+  { "env_format",          checkEnvFormat },
+  { "sample_range",        checkSampleRange },
+  { "host_residency",      checkHostResidency },
+  { "wavefront_queue",     checkWavefrontQueue },
+  { "gltf_loader",         checkGltfLoader },
+  { "microfacet",          checkMicrofacet },
+  { "light_parallelogram", checkLightParallelogram },
+  { "ray_cone",            checkRayCone },
+  { "adaptive_roulette",   checkAdaptiveRoulette },
+  { "buffer_cache",        checkBufferCache },
+  { "tile_layout",         checkTileLayout },
+  { "parameter_channel",   checkParameterChannel },
+  { "input_trace",         checkInputTrace },
+  { "scene",               checkScene },
+  { "view_layout",         checkViewLayout },
+  { "aov",                 checkAov }
+};
+
+
+static void printUsage(const char* argv0)
+{
+  std::cerr << "\nUsage: " << argv0 << " [options]\n"
+    "App Options:\n"
+    "   ? | help | --help     Print this usage message and exit.\n"
+    "  -f | --filter <text>   Only run checks with names containing text.\n"
+  << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+  std::string filter;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string arg(argv[i]);
+
+    if (arg == "?" || arg == "help" || arg == "--help")
+    {
+      printUsage(argv[0]);
+      return 0;
+    }
+    else if ((arg == "-f" || arg == "--filter") && i + 1 < argc)
+    {
+      filter = argv[++i];
+    }
+    else
+    {
+      std::cerr << "ERROR: Unknown option '" << arg << "'" << std::endl;
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  int numChecks = 0;
+
+  try
+  {
+    for (CheckCase const& c : g_checks)
+    {
+      if (std::string(c.name).find(filter) == std::string::npos)
+      {
+        continue;
+      }
+      if (!c.check())
+      {
+        std::cerr << "ERROR: The " << c.name << " check failed." << std::endl;
+        return 1;
+      }
+      ++numChecks;
+    }
+  }
+  catch (std::exception const& e)
+  {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return 1;
+  }
+
+  std::cout << numChecks << " checks passed." << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,99 @@
+// Copyright (c) 2002-2015, NVIDIA CORPORATION. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+/** @file */
+
+#include <dp/math/Config.h>
+
+#include <cstddef>
+
+
+namespace dp
+{
+  namespace math
+  {
+
+    //! Instruction set used by the batch functions below.
+    enum class SimdLevel
+    {
+      SCALAR,
+      SSE,    //!< SSE2, four elements per iteration.
+      AVX2,   //!< AVX2, eight elements per iteration with gather loads.
+      NEON    //!< ARM NEON, four elements per iteration.
+    };
+
+    //! Returns the instruction set currently used by the batch functions.
+    /** The first call detects the best instruction set supported by the CPU at runtime. */
+    DP_MATH_API SimdLevel getSimdLevel();
+
+    //! Overrides the instruction set used by the batch functions, e.g. to compare against the scalar fallback.
+    /** Levels not supported by the CPU or the compiler fall back to the next lower one.
+      * \returns the level which is active afterwards. */
+    DP_MATH_API SimdLevel setSimdLevel( SimdLevel level );
+
+    DP_MATH_API const char* getSimdLevelName( SimdLevel level );
+
+    /*! \brief Batched transformations of points, vectors and matrices.
+     *  \remarks All matrices are row-major affine 3x4 matrices in float[12] like the OptixInstance transform
+     *  and the sg::Instance transform in the host scene graph. Points and vectors are three consecutive floats
+     *  with a stride in bytes between elements, so positions inside interleaved vertex attributes can be used directly.
+     *  The stride must be a multiple of four bytes.
+     *  The SIMD paths do the same multiplications and additions in the same order as the scalar fallback
+     *  and don't use fused multiply-add instructions, so all paths return bit-identical results. */
+
+    //! Transforms \a count points \a src by the affine \a matrix into \a dst. \a src and \a dst may be identical.
+    DP_MATH_API void transformPoints( const float matrix[12]
+                                    , const float* src, size_t srcStride
+                                    , float* dst, size_t dstStride
+                                    , size_t count );
+
+    //! Transforms \a count vectors by the upper 3x3 part of the \a matrix, ignoring the translation.
+    DP_MATH_API void transformVectors( const float matrix[12]
+                                     , const float* src, size_t srcStride
+                                     , float* dst, size_t dstStride
+                                     , size_t count );
+
+    //! Transforms \a count normals with the transpose of the upper 3x3 part of the \a inverse matrix.
+    /** Pass the inverse of the matrix used for the points. The results are not normalized. */
+    DP_MATH_API void transformNormals( const float inverse[12]
+                                     , const float* src, size_t srcStride
+                                     , float* dst, size_t dstStride
+                                     , size_t count );
+
+    //! Concatenates \a count matrices: dst[i] = parent * local[i]. This is the transform of a child instance in the scene graph.
+    /** \a dst and \a local are arrays of \a count float[12] matrices. \a dst may be identical to \a local, but must not overlap \a parent. */
+    DP_MATH_API void concatenateMatrices( const float parent[12], const float* local, float* dst, size_t count );
+
+    //! Calculates the axis aligned bounding box of \a count points transformed by the \a matrix.
+    /** A null \a matrix means identity. \returns false and leaves \a lo and \a hi untouched if \a count is zero. */
+    DP_MATH_API bool calculateBounds( const float* matrix
+                                    , const float* src, size_t srcStride
+                                    , size_t count
+                                    , float lo[3], float hi[3] );
+
+  } // namespace math
+} // namespace dp
@@ -0,0 +1,772 @@
+// Copyright (c) 2002-2015, NVIDIA CORPORATION. All rights reserved.
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//  * Neither the name of NVIDIA CORPORATION nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+// OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <dp/math/Batch.h>
+
+#include "inc/MyAssert.h"
+
+#include <algorithm>
+#include <atomic>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#  define DP_MATH_BATCH_X86 1
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#  endif
+#  include <immintrin.h>
+   // The SIMD paths are compiled into the same translation unit as the scalar code and only selected at runtime,
+   // so the compiler must be allowed to emit these instructions per function. MSVC always allows intrinsics.
+#  if defined(__GNUC__) || defined(__clang__)
+#    define DP_MATH_TARGET_SSE2 __attribute__((target("sse2")))
+#    define DP_MATH_TARGET_AVX2 __attribute__((target("avx2")))
+#  else
+#    define DP_MATH_TARGET_SSE2
+#    define DP_MATH_TARGET_AVX2
+#  endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#  define DP_MATH_BATCH_NEON 1
+#  include <arm_neon.h>
+#endif
+
+// Bit-identical results between all paths require that the compiler never fuses a multiplication and an addition,
+// which it is allowed to do by default when FMA instructions are enabled, e.g. with -march=native.
+#if defined(__clang__)
+#  pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#  pragma GCC optimize("fp-contract=off")
+#elif defined(_MSC_VER)
+#  pragma fp_contract(off)
+#endif
+
+
+namespace dp
+{
+  namespace math
+  {
+
+    // The matrix which is applied per element. Normals use the transposed inverse.
+    struct BatchMatrix
+    {
+      float m[12];
+    };
+
+    inline const float* element( const float* base, size_t stride, size_t i )
+    {
+      return reinterpret_cast<const float*>( reinterpret_cast<const char*>( base ) + i * stride );
+    }
+
+    inline float* element( float* base, size_t stride, size_t i )
+    {
+      return reinterpret_cast<float*>( reinterpret_cast<char*>( base ) + i * stride );
+    }
+
+    static BatchMatrix transposeInverse( const float inverse[12] )
+    {
+      BatchMatrix t;
+      t.m[0] = inverse[0]; t.m[1] = inverse[4]; t.m[ 2] = inverse[ 8]; t.m[ 3] = 0.0f;
+      t.m[4] = inverse[1]; t.m[5] = inverse[5]; t.m[ 6] = inverse[ 9]; t.m[ 7] = 0.0f;
+      t.m[8] = inverse[2]; t.m[9] = inverse[6]; t.m[10] = inverse[10]; t.m[11] = 0.0f;
+      return t;
+    }
+
+
+    // Scalar reference implementation. The SIMD paths must use the same operation order.
+
+    template<bool TRANSLATE>
+    static void transformScalar( const float m[12], const float* src, size_t srcStride, float* dst, size_t dstStride, size_t begin, size_t end )
+    {
+      for ( size_t i = begin; i < end; ++i )
+      {
+        const float* p = element( src, srcStride, i );
+
+        const float x = p[0];
+        const float y = p[1];
+        const float z = p[2];
+
+        float rx = m[0] * x + m[1] * y + m[ 2] * z;
+        float ry = m[4] * x + m[5] * y + m[ 6] * z;
+        float rz = m[8] * x + m[9] * y + m[10] * z;
+        if ( TRANSLATE )
+        {
+          rx += m[3];
+          ry += m[7];
+          rz += m[11];
+        }
+
+        float* r = element( dst, dstStride, i );
+        r[0] = rx;
+        r[1] = ry;
+        r[2] = rz;
+      }
+    }
+
+    static void boundsScalar( const float* m, const float* src, size_t srcStride, size_t begin, size_t end, float lo[3], float hi[3] )
+    {
+      for ( size_t i = begin; i < end; ++i )
+      {
+        const float* p = element( src, srcStride, i );
+
+        float r[3] = { p[0], p[1], p[2] };
+        if ( m )
+        {
+          transformScalar<true>( m, p, 0, r, 0, 0, 1 );
+        }
+        for ( int j = 0; j < 3; ++j )
+        {
+          lo[j] = std::min( lo[j], r[j] );
+          hi[j] = std::max( hi[j], r[j] );
+        }
+      }
+    }
+
+    static void concatenateScalar( const float* a, const float* b, float* m )
+    {
+      float r[12];
+
+      r[ 0] = a[0] * b[0] + a[1] * b[4] + a[ 2] * b[ 8];
+      r[ 1] = a[0] * b[1] + a[1] * b[5] + a[ 2] * b[ 9];
+      r[ 2] = a[0] * b[2] + a[1] * b[6] + a[ 2] * b[10];
+      r[ 3] = a[0] * b[3] + a[1] * b[7] + a[ 2] * b[11] + a[3];
+
+      r[ 4] = a[4] * b[0] + a[5] * b[4] + a[ 6] * b[ 8];
+      r[ 5] = a[4] * b[1] + a[5] * b[5] + a[ 6] * b[ 9];
+      r[ 6] = a[4] * b[2] + a[5] * b[6] + a[ 6] * b[10];
+      r[ 7] = a[4] * b[3] + a[5] * b[7] + a[ 6] * b[11] + a[7];
+
+      r[ 8] = a[8] * b[0] + a[9] * b[4] + a[10] * b[ 8];
+      r[ 9] = a[8] * b[1] + a[9] * b[5] + a[10] * b[ 9];
+      r[10] = a[8] * b[2] + a[9] * b[6] + a[10] * b[10];
+      r[11] = a[8] * b[3] + a[9] * b[7] + a[10] * b[11] + a[11];
+
+      for ( int i = 0; i < 12; ++i ) // b and m may be identical.
+      {
+        m[i] = r[i];
+      }
+    }
+
+
+#if defined(DP_MATH_BATCH_X86)
+
+    // SSE2: Four elements per iteration in SoA layout.
+    // Loading all elements of a block before storing any result keeps in-place transformations correct.
+
+    DP_MATH_TARGET_SSE2
+    static inline void loadSSE( const float* src, size_t srcStride, size_t i, __m128& x, __m128& y, __m128& z )
+    {
+      const float* p0 = element( src, srcStride, i     );
+      const float* p1 = element( src, srcStride, i + 1 );
+      const float* p2 = element( src, srcStride, i + 2 );
+      const float* p3 = element( src, srcStride, i + 3 );
+
+      x = _mm_set_ps( p3[0], p2[0], p1[0], p0[0] );
+      y = _mm_set_ps( p3[1], p2[1], p1[1], p0[1] );
+      z = _mm_set_ps( p3[2], p2[2], p1[2], p0[2] );
+    }
+
+    template<bool TRANSLATE>
+    DP_MATH_TARGET_SSE2
+    static inline void transformSSE( const float m[12], __m128& x, __m128& y, __m128& z )
+    {
+      __m128 rx = _mm_add_ps( _mm_add_ps( _mm_mul_ps( _mm_set1_ps( m[0] ), x ), _mm_mul_ps( _mm_set1_ps( m[1] ), y ) ), _mm_mul_ps( _mm_set1_ps( m[ 2] ), z ) );
+      __m128 ry = _mm_add_ps( _mm_add_ps( _mm_mul_ps( _mm_set1_ps( m[4] ), x ), _mm_mul_ps( _mm_set1_ps( m[5] ), y ) ), _mm_mul_ps( _mm_set1_ps( m[ 6] ), z ) );
+      __m128 rz = _mm_add_ps( _mm_add_ps( _mm_mul_ps( _mm_set1_ps( m[8] ), x ), _mm_mul_ps( _mm_set1_ps( m[9] ), y ) ), _mm_mul_ps( _mm_set1_ps( m[10] ), z ) );
+      if ( TRANSLATE )
+      {
+        rx = _mm_add_ps( rx, _mm_set1_ps( m[3] ) );
+        ry = _mm_add_ps( ry, _mm_set1_ps( m[7] ) );
+        rz = _mm_add_ps( rz, _mm_set1_ps( m[11] ) );
+      }
+      x = rx;
+      y = ry;
+      z = rz;
+    }
+
+    DP_MATH_TARGET_SSE2
+    static inline void storeSSE( float* dst, size_t dstStride, size_t i, size_t n, __m128 x, __m128 y, __m128 z )
+    {
+      float rx[8];
+      float ry[8];
+      float rz[8];
+
+      _mm_storeu_ps( rx, x );
+      _mm_storeu_ps( ry, y );
+      _mm_storeu_ps( rz, z );
+
+      for ( size_t j = 0; j < n; ++j )
+      {
+        float* r = element( dst, dstStride, i + j );
+        r[0] = rx[j];
+        r[1] = ry[j];
+        r[2] = rz[j];
+      }
+    }
+
+    template<bool TRANSLATE>
+    DP_MATH_TARGET_SSE2
+    static void transformPointsSSE( const float m[12], const float* src, size_t srcStride, float* dst, size_t dstStride, size_t count )
+    {
+      size_t i = 0;
+      for ( ; i + 4 <= count; i += 4 )
+      {
+        __m128 x, y, z;
+        loadSSE( src, srcStride, i, x, y, z );
+        transformSSE<TRANSLATE>( m, x, y, z );
+        storeSSE( dst, dstStride, i, 4, x, y, z );
+      }
+      transformScalar<TRANSLATE>( m, src, srcStride, dst, dstStride, i, count );
+    }
+
+    DP_MATH_TARGET_SSE2
+    static void boundsSSE( const float* m, const float* src, size_t srcStride, size_t count, float lo[3], float hi[3] )
+    {
+      __m128 loX = _mm_set1_ps( lo[0] );
+      __m128 loY = _mm_set1_ps( lo[1] );
+      __m128 loZ = _mm_set1_ps( lo[2] );
+      __m128 hiX = _mm_set1_ps( hi[0] );
+      __m128 hiY = _mm_set1_ps( hi[1] );
+      __m128 hiZ = _mm_set1_ps( hi[2] );
+
+      size_t i = 0;
+      for ( ; i + 4 <= count; i += 4 )
+      {
+        __m128 x, y, z;
+        loadSSE( src, srcStride, i, x, y, z );
+        if ( m )
+        {
+          transformSSE<true>( m, x, y, z );
+        }
+        loX = _mm_min_ps( loX, x );
+        loY = _mm_min_ps( loY, y );
+        loZ = _mm_min_ps( loZ, z );
+        hiX = _mm_max_ps( hiX, x );
+        hiY = _mm_max_ps( hiY, y );
+        hiZ = _mm_max_ps( hiZ, z );
+      }
+
+      float l[3][4];
+      float h[3][4];
+      _mm_storeu_ps( l[0], loX );
+      _mm_storeu_ps( l[1], loY );
+      _mm_storeu_ps( l[2], loZ );
+      _mm_storeu_ps( h[0], hiX );
+      _mm_storeu_ps( h[1], hiY );
+      _mm_storeu_ps( h[2], hiZ );
+      for ( int j = 0; j < 3; ++j )
+      {
+        lo[j] = std::min( std::min( l[j][0], l[j][1] ), std::min( l[j][2], l[j][3] ) );
+        hi[j] = std::max( std::max( h[j][0], h[j][1] ), std::max( h[j][2], h[j][3] ) );
+      }
+
+      boundsScalar( m, src, srcStride, i, count, lo, hi );
+    }
+
+    // One matrix row per register. Adding -0.0f in the first three lanes is an exact identity,
+    // so the translation column can be added in the same instruction without changing the other results.
+    DP_MATH_TARGET_SSE2
+    static void concatenateSSE( const float* a, const float* local, float* dst, size_t count )
+    {
+      for ( size_t i = 0; i < count; ++i )
+      {
+        const float* b = local + i * 12;
+        float*       m = dst   + i * 12;
+
+        const __m128 b0 = _mm_loadu_ps( b     );
+        const __m128 b1 = _mm_loadu_ps( b + 4 );
+        const __m128 b2 = _mm_loadu_ps( b + 8 );
+
+        __m128 r[3];
+        for ( int j = 0; j < 3; ++j )
+        {
+          const float* row = a + j * 4;
+
+          const __m128 sum = _mm_add_ps( _mm_add_ps( _mm_mul_ps( _mm_set1_ps( row[0] ), b0 ), _mm_mul_ps( _mm_set1_ps( row[1] ), b1 ) ), _mm_mul_ps( _mm_set1_ps( row[2] ), b2 ) );
+          r[j] = _mm_add_ps( sum, _mm_set_ps( row[3], -0.0f, -0.0f, -0.0f ) );
+        }
+
+        _mm_storeu_ps( m,     r[0] );
+        _mm_storeu_ps( m + 4, r[1] );
+        _mm_storeu_ps( m + 8, r[2] );
+      }
+    }
+
+
+    // AVX2: Eight elements per iteration. The strided components are fetched with gather instructions.
+    // Only the multiply and add instructions are used, never FMA, to stay bit-identical to the scalar path.
+
+    DP_MATH_TARGET_AVX2
+    static inline void loadAVX2( const float* src, size_t srcStride, size_t i, __m256i offsets, __m256& x, __m256& y, __m256& z )
+    {
+      const float* p = element( src, srcStride, i );
+
+      x = _mm256_i32gather_ps( p,     offsets, 4 );
+      y = _mm256_i32gather_ps( p + 1, offsets, 4 );
+      z = _mm256_i32gather_ps( p + 2, offsets, 4 );
+    }
+
+    template<bool TRANSLATE>
+    DP_MATH_TARGET_AVX2
+    static inline void transformAVX2( const float m[12], __m256& x, __m256& y, __m256& z )
+    {
+      __m256 rx = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( _mm256_set1_ps( m[0] ), x ), _mm256_mul_ps( _mm256_set1_ps( m[1] ), y ) ), _mm256_mul_ps( _mm256_set1_ps( m[ 2] ), z ) );
+      __m256 ry = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( _mm256_set1_ps( m[4] ), x ), _mm256_mul_ps( _mm256_set1_ps( m[5] ), y ) ), _mm256_mul_ps( _mm256_set1_ps( m[ 6] ), z ) );
+      __m256 rz = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( _mm256_set1_ps( m[8] ), x ), _mm256_mul_ps( _mm256_set1_ps( m[9] ), y ) ), _mm256_mul_ps( _mm256_set1_ps( m[10] ), z ) );
+      if ( TRANSLATE )
+      {
+        rx = _mm256_add_ps( rx, _mm256_set1_ps( m[3] ) );
+        ry = _mm256_add_ps( ry, _mm256_set1_ps( m[7] ) );
+        rz = _mm256_add_ps( rz, _mm256_set1_ps( m[11] ) );
+      }
+      x = rx;
+      y = ry;
+      z = rz;
+    }
+
+    DP_MATH_TARGET_AVX2
+    static inline __m256i offsetsAVX2( size_t srcStride )
+    {
+      const int s = static_cast<int>( srcStride / sizeof(float) );
+      return _mm256_mullo_epi32( _mm256_set_epi32( 7, 6, 5, 4, 3, 2, 1, 0 ), _mm256_set1_epi32( s ) );
+    }
+
+    template<bool TRANSLATE>
+    DP_MATH_TARGET_AVX2
+    static void transformPointsAVX2( const float m[12], const float* src, size_t srcStride, float* dst, size_t dstStride, size_t count )
+    {
+      const __m256i offsets = offsetsAVX2( srcStride );
+
+      size_t i = 0;
+      for ( ; i + 8 <= count; i += 8 )
+      {
+        __m256 x, y, z;
+        loadAVX2( src, srcStride, i, offsets, x, y, z );
+        transformAVX2<TRANSLATE>( m, x, y, z );
+
+        float rx[8];
+        float ry[8];
+        float rz[8];
+        _mm256_storeu_ps( rx, x );
+        _mm256_storeu_ps( ry, y );
+        _mm256_storeu_ps( rz, z );
+        for ( size_t j = 0; j < 8; ++j )
+        {
+          float* r = element( dst, dstStride, i + j );
+          r[0] = rx[j];
+          r[1] = ry[j];
+          r[2] = rz[j];
+        }
+      }
+      transformScalar<TRANSLATE>( m, src, srcStride, dst, dstStride, i, count );
+    }
+
+    DP_MATH_TARGET_AVX2
+    static void boundsAVX2( const float* m, const float* src, size_t srcStride, size_t count, float lo[3], float hi[3] )
+    {
+      const __m256i offsets = offsetsAVX2( srcStride );
+
+      __m256 loX = _mm256_set1_ps( lo[0] );
+      __m256 loY = _mm256_set1_ps( lo[1] );
+      __m256 loZ = _mm256_set1_ps( lo[2] );
+      __m256 hiX = _mm256_set1_ps( hi[0] );
+      __m256 hiY = _mm256_set1_ps( hi[1] );
+      __m256 hiZ = _mm256_set1_ps( hi[2] );
+
+      size_t i = 0;
+      for ( ; i + 8 <= count; i += 8 )
+      {
+        __m256 x, y, z;
+        loadAVX2( src, srcStride, i, offsets, x, y, z );
+        if ( m )
+        {
+          transformAVX2<true>( m, x, y, z );
+        }
+        loX = _mm256_min_ps( loX, x );
+        loY = _mm256_min_ps( loY, y );
+        loZ = _mm256_min_ps( loZ, z );
+        hiX = _mm256_max_ps( hiX, x );
+        hiY = _mm256_max_ps( hiY, y );
+        hiZ = _mm256_max_ps( hiZ, z );
+      }
+
+      float l[3][8];
+      float h[3][8];
+      _mm256_storeu_ps( l[0], loX );
+      _mm256_storeu_ps( l[1], loY );
+      _mm256_storeu_ps( l[2], loZ );
+      _mm256_storeu_ps( h[0], hiX );
+      _mm256_storeu_ps( h[1], hiY );
+      _mm256_storeu_ps( h[2], hiZ );
+      for ( int j = 0; j < 3; ++j )
+      {
+        lo[j] = *std::min_element( l[j], l[j] + 8 );
+        hi[j] = *std::max_element( h[j], h[j] + 8 );
+      }
+
+      boundsScalar( m, src, srcStride, i, count, lo, hi );
+    }
+
+    static bool isSupported( SimdLevel level )
+    {
+      switch ( level )
+      {
+        case SimdLevel::SCALAR:
+          return true;
+        case SimdLevel::SSE:
+        case SimdLevel::AVX2:
+        {
+#if defined(_MSC_VER) && !defined(__clang__)
+          int info[4];
+          __cpuid( info, 1 );
+          const bool sse2 = ( info[3] & ( 1 << 26 ) ) != 0;
+          if ( level == SimdLevel::SSE )
+          {
+            return sse2;
+          }
+          // AVX2 also needs the OS to save the YMM registers.
+          const bool osxsave = ( info[2] & ( 1 << 27 ) ) != 0;
+          if ( !sse2 || !osxsave || ( _xgetbv( 0 ) & 6 ) != 6 )
+          {
+            return false;
+          }
+          __cpuidex( info, 7, 0 );
+          return ( info[1] & ( 1 << 5 ) ) != 0;
+#else
+          __builtin_cpu_init();
+          return ( level == SimdLevel::SSE ) ? ( __builtin_cpu_supports( "sse2" ) != 0 ) : ( __builtin_cpu_supports( "avx2" ) != 0 );
+#endif
+        }
+        default:
+          return false;
+      }
+    }
+
+#elif defined(DP_MATH_BATCH_NEON)
+
+    // NEON: Four elements per iteration, separate vmulq and vaddq because vfmaq would round differently than the scalar path.
+
+    static inline void loadNEON( const float* src, size_t srcStride, size_t i, float32x4_t& x, float32x4_t& y, float32x4_t& z )
+    {
+      float px[4];
+      float py[4];
+      float pz[4];
+      for ( size_t j = 0; j < 4; ++j )
+      {
+        const float* p = element( src, srcStride, i + j );
+        px[j] = p[0];
+        py[j] = p[1];
+        pz[j] = p[2];
+      }
+      x = vld1q_f32( px );
+      y = vld1q_f32( py );
+      z = vld1q_f32( pz );
+    }
+
+    template<bool TRANSLATE>
+    static inline void transformNEON( const float m[12], float32x4_t& x, float32x4_t& y, float32x4_t& z )
+    {
+      float32x4_t rx = vaddq_f32( vaddq_f32( vmulq_n_f32( x, m[0] ), vmulq_n_f32( y, m[1] ) ), vmulq_n_f32( z, m[ 2] ) );
+      float32x4_t ry = vaddq_f32( vaddq_f32( vmulq_n_f32( x, m[4] ), vmulq_n_f32( y, m[5] ) ), vmulq_n_f32( z, m[ 6] ) );
+      float32x4_t rz = vaddq_f32( vaddq_f32( vmulq_n_f32( x, m[8] ), vmulq_n_f32( y, m[9] ) ), vmulq_n_f32( z, m[10] ) );
+      if ( TRANSLATE )
+      {
+        rx = vaddq_f32( rx, vdupq_n_f32( m[3] ) );
+        ry = vaddq_f32( ry, vdupq_n_f32( m[7] ) );
+        rz = vaddq_f32( rz, vdupq_n_f32( m[11] ) );
+      }
+      x = rx;
+      y = ry;
+      z = rz;
+    }
+
+    template<bool TRANSLATE>
+    static void transformPointsNEON( const float m[12], const float* src, size_t srcStride, float* dst, size_t dstStride, size_t count )
+    {
+      size_t i = 0;
+      for ( ; i + 4 <= count; i += 4 )
+      {
+        float32x4_t x, y, z;
+        loadNEON( src, srcStride, i, x, y, z );
+        transformNEON<TRANSLATE>( m, x, y, z );
+
+        float rx[4];
+        float ry[4];
+        float rz[4];
+        vst1q_f32( rx, x );
+        vst1q_f32( ry, y );
+        vst1q_f32( rz, z );
+        for ( size_t j = 0; j < 4; ++j )
+        {
+          float* r = element( dst, dstStride, i + j );
+          r[0] = rx[j];
+          r[1] = ry[j];
+          r[2] = rz[j];
+        }
+      }
+      transformScalar<TRANSLATE>( m, src, srcStride, dst, dstStride, i, count );
+    }
+
+    static void boundsNEON( const float* m, const float* src, size_t srcStride, size_t count, float lo[3], float hi[3] )
+    {
+      float32x4_t loX = vdupq_n_f32( lo[0] );
+      float32x4_t loY = vdupq_n_f32( lo[1] );
+      float32x4_t loZ = vdupq_n_f32( lo[2] );
+      float32x4_t hiX = vdupq_n_f32( hi[0] );
+      float32x4_t hiY = vdupq_n_f32( hi[1] );
+      float32x4_t hiZ = vdupq_n_f32( hi[2] );
+
+      size_t i = 0;
+      for ( ; i + 4 <= count; i += 4 )
+      {
+        float32x4_t x, y, z;
+        loadNEON( src, srcStride, i, x, y, z );
+        if ( m )
+        {
+          transformNEON<true>( m, x, y, z );
+        }
+        loX = vminq_f32( loX, x );
+        loY = vminq_f32( loY, y );
+        loZ = vminq_f32( loZ, z );
+        hiX = vmaxq_f32( hiX, x );
+        hiY = vmaxq_f32( hiY, y );
+        hiZ = vmaxq_f32( hiZ, z );
+      }
+
+      float l[3][4];
+      float h[3][4];
+      vst1q_f32( l[0], loX );
+      vst1q_f32( l[1], loY );
+      vst1q_f32( l[2], loZ );
+      vst1q_f32( h[0], hiX );
+      vst1q_f32( h[1], hiY );
+      vst1q_f32( h[2], hiZ );
+      for ( int j = 0; j < 3; ++j )
+      {
+        lo[j] = *std::min_element( l[j], l[j] + 4 );
+        hi[j] = *std::max_element( h[j], h[j] + 4 );
+      }
+
+      boundsScalar( m, src, srcStride, i, count, lo, hi );
+    }
+
+    static void concatenateNEON( const float* a, const float* local, float* dst, size_t count )
+    {
+      const float32x4_t negativeZero = vdupq_n_f32( -0.0f );
+
+      for ( size_t i = 0; i < count; ++i )
+      {
+        const float* b = local + i * 12;
+        float*       m = dst   + i * 12;
+
+        const float32x4_t b0 = vld1q_f32( b     );
+        const float32x4_t b1 = vld1q_f32( b + 4 );
+        const float32x4_t b2 = vld1q_f32( b + 8 );
+
+        float32x4_t r[3];
+        for ( int j = 0; j < 3; ++j )
+        {
+          const float* row = a + j * 4;
+
+          const float32x4_t sum = vaddq_f32( vaddq_f32( vmulq_n_f32( b0, row[0] ), vmulq_n_f32( b1, row[1] ) ), vmulq_n_f32( b2, row[2] ) );
+          r[j] = vaddq_f32( sum, vsetq_lane_f32( row[3], negativeZero, 3 ) );
+        }
+
+        vst1q_f32( m,     r[0] );
+        vst1q_f32( m + 4, r[1] );
+        vst1q_f32( m + 8, r[2] );
+      }
+    }
+
+    static bool isSupported( SimdLevel level )
+    {
+      return level == SimdLevel::SCALAR || level == SimdLevel::NEON;
+    }
+
+#else
+
+    static bool isSupported( SimdLevel level )
+    {
+      return level == SimdLevel::SCALAR;
+    }
+
+#endif
+
+    static SimdLevel detectSimdLevel()
+    {
+      const SimdLevel levels[4] = { SimdLevel::AVX2, SimdLevel::NEON, SimdLevel::SSE, SimdLevel::SCALAR };
+      for ( SimdLevel level : levels )
+      {
+        if ( isSupported( level ) )
+        {
+          return level;
+        }
+      }
+      return SimdLevel::SCALAR;
+    }
+
+    static std::atomic<int>& simdLevel()
+    {
+      static std::atomic<int> level( static_cast<int>( detectSimdLevel() ) );
+      return level;
+    }
+
+    DP_MATH_API SimdLevel getSimdLevel()
+    {
+      return static_cast<SimdLevel>( simdLevel().load() );
+    }
+
+    DP_MATH_API SimdLevel setSimdLevel( SimdLevel level )
+    {
+      // Fall back in the order AVX2 -> SSE -> SCALAR and NEON -> SCALAR.
+      while ( !isSupported( level ) )
+      {
+        level = ( level == SimdLevel::AVX2 ) ? SimdLevel::SSE : SimdLevel::SCALAR;
+      }
+      simdLevel().store( static_cast<int>( level ) );
+      return level;
+    }
+
+    DP_MATH_API const char* getSimdLevelName( SimdLevel level )
+    {
+      switch ( level )
+      {
+        case SimdLevel::SSE:
+          return "SSE";
+        case SimdLevel::AVX2:
+          return "AVX2";
+        case SimdLevel::NEON:
+          return "NEON";
+        default:
+          return "scalar";
+      }
+    }
+
+    template<bool TRANSLATE>
+    static void transformDispatch( const float m[12], const float* src, size_t srcStride, float* dst, size_t dstStride, size_t count )
+    {
+      MY_ASSERT( srcStride % sizeof(float) == 0 && dstStride % sizeof(float) == 0 );
+
+      switch ( getSimdLevel() )
+      {
+#if defined(DP_MATH_BATCH_X86)
+        case SimdLevel::AVX2:
+          transformPointsAVX2<TRANSLATE>( m, src, srcStride, dst, dstStride, count );
+          break;
+        case SimdLevel::SSE:
+          transformPointsSSE<TRANSLATE>( m, src, srcStride, dst, dstStride, count );
+          break;
+#elif defined(DP_MATH_BATCH_NEON)
+        case SimdLevel::NEON:
+          transformPointsNEON<TRANSLATE>( m, src, srcStride, dst, dstStride, count );
+          break;
+#endif
+        default:
+          transformScalar<TRANSLATE>( m, src, srcStride, dst, dstStride, 0, count );
+          break;
+      }
+    }
+
+    DP_MATH_API void transformPoints( const float matrix[12], const float* src, size_t srcStride, float* dst, size_t dstStride, size_t count )
+    {
+      transformDispatch<true>( matrix, src, srcStride, dst, dstStride, count );
+    }
+
+    DP_MATH_API void transformVectors( const float matrix[12], const float* src, size_t srcStride, float* dst, size_t dstStride, size_t count )
+    {
+      transformDispatch<false>( matrix, src, srcStride, dst, dstStride, count );
+    }
+
+    DP_MATH_API void transformNormals( const float inverse[12], const float* src, size_t srcStride, float* dst, size_t dstStride, size_t count )
+    {
+      const BatchMatrix t = transposeInverse( inverse );
+      transformDispatch<false>( t.m, src, srcStride, dst, dstStride, count );
+    }
+
+    DP_MATH_API void concatenateMatrices( const float parent[12], const float* local, float* dst, size_t count )
+    {
+      switch ( getSimdLevel() )
+      {
+#if defined(DP_MATH_BATCH_X86)
+        case SimdLevel::AVX2: // A 3x4 row fits into one SSE register, there is nothing to gain from wider registers.
+        case SimdLevel::SSE:
+          concatenateSSE( parent, local, dst, count );
+          break;
+#elif defined(DP_MATH_BATCH_NEON)
+        case SimdLevel::NEON:
+          concatenateNEON( parent, local, dst, count );
+          break;
+#endif
+        default:
+          for ( size_t i = 0; i < count; ++i )
+          {
+            concatenateScalar( parent, local + i * 12, dst + i * 12 );
+          }
+          break;
+      }
+    }
+
+    DP_MATH_API bool calculateBounds( const float* matrix, const float* src, size_t srcStride, size_t count, float lo[3], float hi[3] )
+    {
+      if ( count == 0 )
+      {
+        return false;
+      }
+
+      MY_ASSERT( srcStride % sizeof(float) == 0 );
+
+      // Initialize with the first point, so that no infinities are needed.
+      float first[3] = { src[0], src[1], src[2] };
+      if ( matrix )
+      {
+        transformScalar<true>( matrix, src, 0, first, 0, 0, 1 );
+      }
+      for ( int j = 0; j < 3; ++j )
+      {
+        lo[j] = first[j];
+        hi[j] = first[j];
+      }
+
+      switch ( getSimdLevel() )
+      {
+#if defined(DP_MATH_BATCH_X86)
+        case SimdLevel::AVX2:
+          boundsAVX2( matrix, src, srcStride, count, lo, hi );
+          break;
+        case SimdLevel::SSE:
+          boundsSSE( matrix, src, srcStride, count, lo, hi );
+          break;
+#elif defined(DP_MATH_BATCH_NEON)
+        case SimdLevel::NEON:
+          boundsNEON( matrix, src, srcStride, count, lo, hi );
+          break;
+#endif
+        default:
+          boundsScalar( matrix, src, srcStride, 0, count, lo, hi );
+          break;
+      }
+      return true;
+    }
+
+  } // namespace math
+} // namespace dp
@@ -0,0 +1,160 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef ACCEL_POLICY_H
+#define ACCEL_POLICY_H
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+
+// Decides the OptixAccelBuildOptions per geometry acceleration structure (GAS).
+// OPTIX_BUILD_FLAG_PREFER_FAST_TRACE needs more memory and build time than OPTIX_BUILD_FLAG_PREFER_FAST_BUILD,
+// which only pays off for geometry which is big or instanced often. Compaction costs an additional copy but
+// can save more than half the memory. ALLOW_UPDATE enlarges the GAS to support refits.
+
+// System description settings.
+struct AccelPolicy
+{
+  AccelPolicy()
+  : mode(0)
+  , budget(0)
+  , fastTraceTriangles(100000)
+  , compactionTriangles(10000)
+  , reserve(0.1f)
+  , allowUpdate(0)
+  {
+  }
+
+  int          mode;                // "accelPolicy"     0 = OPTIX_BUILD_FLAG_NONE for all GAS (previous behaviour), 1 = automatic.
+  size_t       budget;              // "accelBudget"     Bytes of VRAM available for geometry. 0 = the free device memory at scene initialization.
+  unsigned int fastTraceTriangles;  // "accelFastTrace"  Minimum number of triangles times instances to prefer fast trace.
+  unsigned int compactionTriangles; // "accelCompaction" Minimum number of triangles to compact even when the budget isn't tight.
+  float        reserve;             // "accelReserve"    Fraction of the budget which should stay free for other allocations.
+  int          allowUpdate;         // "accelUpdate"     1 = request ALLOW_UPDATE as long as the budget isn't tight.
+};
+
+// Per GAS inputs. The sizes are output plus temporary bytes from optixAccelComputeMemoryUsage() for both build preferences.
+struct AccelRequest
+{
+  size_t numTriangles;
+  size_t numInstances;    // How often the GAS is referenced inside the scene.
+  size_t sizeFastTrace;
+  size_t sizeFastBuild;
+  size_t budgetTotal;
+  size_t budgetRemaining;
+};
+
+struct AccelDecision
+{
+  AccelDecision()
+  : fastTrace(false)
+  , fastBuild(false)
+  , compaction(false)
+  , allowUpdate(false)
+  , reason("fixed")
+  {
+  }
+
+  bool        fastTrace;
+  bool        fastBuild;
+  bool        compaction;
+  bool        allowUpdate;
+  const char* reason;     // Static string for the log.
+};
+
+
+// Returns true when size bytes can be allocated from remaining while keeping reserve bytes free. Overflow-safe.
+inline bool fitsAccelBudget(const size_t size, const size_t reserve, const size_t remaining)
+{
+  return size <= remaining && reserve <= remaining - size;
+}
+
+// Subtracts allocated bytes from the remaining budget.
+// Returns false when the allocation exceeded the remaining budget. The budget is exhausted then and stays at zero.
+inline bool consumeAccelBudget(size_t& remaining, const size_t size)
+{
+  if (remaining < size)
+  {
+    remaining = 0;
+    return false;
+  }
+  remaining -= size;
+  return true;
+}
+
+inline AccelDecision decideAccelBuild(AccelPolicy const& policy, AccelRequest const& request)
+{
+  AccelDecision decision;
+
+  if (policy.mode == 0)
+  {
+    return decision; // All flags off, the previous hardcoded OPTIX_BUILD_FLAG_NONE.
+  }
+
+  const size_t reserve = static_cast<size_t>(double(request.budgetTotal) * double(std::min(std::max(policy.reserve, 0.0f), 1.0f)));
+
+  // The trace cost of a GAS scales with how much of the screen it covers, approximated by its triangles times its instances.
+  const size_t numInstances = std::max(request.numInstances, size_t(1));
+  const size_t weighted     = (request.numTriangles <= ~size_t(0) / numInstances) ? request.numTriangles * numInstances : ~size_t(0);
+
+  if (!fitsAccelBudget(request.sizeFastBuild, reserve, request.budgetRemaining))
+  {
+    // Nothing fits anymore. Use the smallest configuration. The allocation itself may still succeed outside the budget.
+    decision.fastBuild  = true;
+    decision.compaction = true;
+    decision.reason     = "over budget";
+    return decision;
+  }
+
+  decision.fastTrace = (policy.fastTraceTriangles <= weighted) && fitsAccelBudget(request.sizeFastTrace, reserve, request.budgetRemaining);
+  decision.fastBuild = !decision.fastTrace;
+
+  const size_t sizeChosen = (decision.fastTrace) ? request.sizeFastTrace : request.sizeFastBuild;
+
+  // Tight means that less than twice the reserve would be left after this build.
+  const bool tight = !fitsAccelBudget(sizeChosen, reserve + reserve, request.budgetRemaining);
+
+  decision.compaction  = tight || (policy.compactionTriangles <= request.numTriangles);
+  decision.allowUpdate = (policy.allowUpdate != 0) && !tight;
+
+  if (decision.fastTrace)
+  {
+    decision.reason = (tight) ? "fast trace, tight budget" : "fast trace";
+  }
+  else
+  {
+    decision.reason = (policy.fastTraceTriangles <= weighted) ? "fast build, fast trace exceeds budget" : ((tight) ? "fast build, tight budget" : "fast build, small geometry");
+  }
+
+  return decision;
+}
+
+#endif // ACCEL_POLICY_H
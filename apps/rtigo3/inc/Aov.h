@@ -0,0 +1,85 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef AOV_H
+#define AOV_H
+
+#include <cuda_runtime.h>
+
+#include "shaders/aov_definition.h"
+
+#include <string>
+#include <vector>
+
+// Host side helpers for the arbitrary output variables (AOVs): buffer layout, option names, multi-GPU merge and the EXR export.
+
+// Bytes per pixel of the AOV buffer with the given AovIndex.
+size_t getAovElementSize(const int index);
+
+// The system description option name enabling this AOV, e.g. "aovDepth".
+const char* getAovOptionName(const int index);
+
+// Returns the AovIndex of the system description option name or -1 when it's not an AOV option.
+int findAovIndex(std::string const& optionName);
+
+// Merges the resolution sized AOV buffer of one device into the accumulated host buffer.
+// Devices only write the pixels they rendered and leave the others zero, so a bitwise OR merges all multi-GPU strategies.
+void accumulateAov(std::vector<unsigned char>& aov, std::vector<unsigned char> const& aovDevice);
+
+enum ExrPixelType
+{
+  EXR_PIXEL_UINT  = 0,
+  EXR_PIXEL_HALF  = 1,
+  EXR_PIXEL_FLOAT = 2
+};
+
+struct ExrChannel
+{
+  std::string  name;   // Layers use the "layer.channel" naming convention.
+  ExrPixelType type;
+  const void*  data;   // First element of this channel in pixel (0, 0).
+  size_t       stride; // Bytes between horizontally neighbouring pixels. Rows are tightly packed.
+};
+
+// Packs the linear beauty output and the AOVs enabled in aovMask into EXR channels. aovs holds the NUM_AOVS resolution sized raw buffers,
+// only the enabled ones are read. The indirect lighting is not rendered separately but derived as beauty - direct into the indirect storage,
+// which must outlive the channels.
+void getAovChannels(const unsigned int aovMask,
+                    const float4* beauty,
+                    std::vector<unsigned char> const* aovs,
+                    const size_t numPixels,
+                    std::vector<float4>& indirect,
+                    std::vector<ExrChannel>& channels);
+
+// Writes an uncompressed scanline OpenEXR file with the given channels. Row 0 of the data is the bottom of the image
+// like in all rtigo3 buffers. DevIL 1.8 cannot write *.exr, and only this minimal subset is needed for multi-layer AOVs.
+bool saveEXR(std::string const& filename, const int width, const int height, std::vector<ExrChannel> const& channels);
+
+#endif // AOV_H
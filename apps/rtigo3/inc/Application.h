@@ -53,12 +53,20 @@
 #endif
 
 #include "inc/Camera.h"
+#include "inc/GltfLoader.h"
+#include "inc/HostBVH.h"
+#include "inc/InputTrace.h"
+#include "inc/ViewLayout.h"
 #include "inc/Options.h"
 #include "inc/Rasterizer.h"
 #include "inc/Raytracer.h"
+#include "inc/SceneDiff.h"
 #include "inc/SceneGraph.h"
+#include "inc/SceneInterpreter.h"
+#include "inc/Tangents.h"
 #include "inc/Texture.h"
 #include "inc/Timer.h"
+#include "inc/Tonemapper.h"
 
 #include <dp/math/Matmnt.h>
 
@@ -74,6 +82,7 @@
 #include <assimp/DefaultLogger.hpp>
 #include <assimp/LogStream.hpp>
 
+#include <future>
 #include <map>
 #include <memory>
 
@@ -96,25 +105,6 @@ enum GuiState
 };
 
 
-enum KeywordScene
-{
-  KS_ALBEDO,
-  KS_ROUGHNESS,
-  KS_ABSORPTION,
-  KS_ABSORPTION_SCALE,
-  KS_IOR,
-  KS_THINWALLED,
-  KS_MATERIAL,
-  KS_IDENTITY,
-  KS_PUSH,
-  KS_POP,
-  KS_ROTATE,
-  KS_SCALE,
-  KS_TRANSLATE,
-  KS_MODEL
-};
-
-
 class Application
 {
 public:
@@ -127,6 +117,7 @@ public:
   void reshape(const int w, const int h);
   bool render();
   void benchmark();
+  void replay();
 
   void display();
 
@@ -141,27 +132,53 @@ private:
   bool saveSystemDescription();
   bool loadSceneDescription(std::string const& filename);
 
+  // Hot reload of the system and scene description files. Only the differences to the current state are sent to the devices.
+  void checkHotReload();
+  bool reloadSystemDescription();
+  bool reloadScene();
+  void updateDeviceState();
+
+  // Host residency policy. The host BVH keeps its own triangle copies, so released geometry is only reloaded from its cache file
+  // when a hot reload instances it for the first time. Released pictures are reloaded from their source images.
+  void releaseHostData();
+
   void restartRendering();
 
   bool screenshot(const bool tonemap);
+  bool saveTimeView();
+  bool saveAovs();
 
   void createCameras();
   void createLights();
   void createPictures();
 
-  void appendInstance(std::shared_ptr<sg::Group>& group,
-                      std::shared_ptr<sg::Triangles> geometry, 
-                      dp::math::Mat44f const& matrix, 
-                      std::string const& reference, 
-                      unsigned int& idInstance);
+  void createMaterial(SceneMaterial const& material);
 
   std::shared_ptr<sg::Group> createASSIMP(std::string const& filename);
   std::shared_ptr<sg::Group> traverseScene(const struct aiScene *scene, const unsigned int indexSceneBase, const struct aiNode* node);
 
-  void calculateTangents(std::vector<TriangleAttributes>& attributes, std::vector<unsigned int> const& indices);
+  std::shared_ptr<sg::Group> createGLTF(std::string const& filename);
+  std::shared_ptr<sg::Group> traverseGLTF(GltfLoader const& loader, const int indexNode, std::vector< std::shared_ptr<sg::Group> > const& meshGroups, std::vector<bool>& isVisited);
 
   void guiRenderingIndicator(const bool isRendering);
 
+  // Record the interaction when recording an input trace and apply it. Return true when the accumulation must restart.
+  bool inputEvent(const InputEventType type, const int x, const int y, const float value);
+  bool inputEventChanged(const InputParameter first, const int index, const float* current, const float* edited, const int count); // Vector widgets, one event per changed component.
+  bool applyInputEvent(InputEvent const& event);
+  bool applyParameter(const InputParameter parameter, const int index, const float value);
+  void replayInputEvents();
+
+  void initHostBVH();
+  void traverseHostBVH(std::shared_ptr<sg::Node> node, const float matrix[12], InstanceData data);
+  bool isReadyHostBVH();
+  bool getPickRay(const int x, const int y, BvhRay& ray) const;
+  int  pick(const int x, const int y, const bool focus);
+  void frameBounds(const bool selection);
+  void benchmarkHostBVH();
+
+  void updateViews();
+
   bool loadString(std::string const& filename, std::string& text);
   bool saveString(std::string const& filename, std::string const& text);
   std::string getDateTime();
@@ -178,7 +195,7 @@ private:
   // Command line options:
   int         m_width;   // Client window size.
   int         m_height;
-  int         m_mode;   // Application mode 0 = interactive, 1 = batched benchmark (single shot).
+  int         m_mode;   // Application mode 0 = interactive, 1 = batched benchmark (single shot), 2 = input trace replay without GUI.
   bool        m_optimize; // Command line option to let the assimp importer optimize the graph (sorts by material).
 
   // System options:
@@ -187,8 +204,12 @@ private:
   int         m_light;       // "light"
   int         m_miss;        // "miss"
   std::string m_environment; // "envMap"
+  int         m_envFormat;   // "envFormat" // EnvFormat of the environment texture on the devices. 0 = RGBA32F, 1 = RGBA16F, 2 = RGB9E5
   int         m_interop;     // "interop"// 0 = none all through host, 1 = register texture image, 2 = register pixel buffer
   bool        m_present;     // "present"
+  bool        m_hotReload;   // "hotReload" // Watch the system and scene description files and apply their changes while running.
+  bool        m_hostResidency;   // "hostResidency" // Release the host vertex, index and pixel data after all devices uploaded it.
+  std::string m_prefixHostCache; // "hostCache"     // Path and filename prefix of the geometry cache files used to reload released data.
   
   bool        m_presentNext;      // (derived)
   double      m_presentAtSecond;  // (derived)
@@ -203,6 +224,17 @@ private:
   float      m_epsilonFactor;       // "epsilonFactor"
   float      m_environmentRotation; // "envRotation"
   float      m_clockFactor;         // "clockFactor"
+  bool       m_specialize;          // "specialize"    // Compile scene-adaptive pipelines in the background.
+  bool       m_timeView;            // "timeView"      // Measure and display the per pixel clock cycles.
+  bool       m_roulette;            // "roulette"      // Adaptive Russian roulette and splitting instead of the fixed rule after pathLengths.x.
+  bool       m_tiledAccumulation;   // "tiledAccumulation" // Tile ordered accumulation buffers in the zero copy and local copy strategies.
+  unsigned int m_aovMask;           // "aovDepth", "aovNormal", "aovAlbedo", "aovInstanceId", "aovMaterialId", "aovPrimitiveId", "aovDirect" // AOV_* bits.
+  AccelPolicy m_accelPolicy;        // "accelPolicy", "accelBudget", "accelFastTrace", "accelCompaction", "accelReserve", "accelUpdate"
+  bool       m_bvhBenchmark;        // "bvhBenchmark"  // Print the host BVH build time, the traversal performance and the GPU ray query comparison after loading.
+  int        m_viewLayout;          // "viewLayout"    // ViewLayout enum. Multiple views rendered in one launch.
+  int2       m_viewGrid;            // "viewGrid"      // Number of views per row and column of the VIEW_LAYOUT_GRID thumbnail sheet.
+  bool       m_viewsSequential;     // "viewSequential" // Render the views with one launch each. For throughput comparisons.
+  bool       m_graphs;              // "graphs"        // Replay the steady state iteration as a captured CUDA graph per device.
 
   std::string m_prefixScreenshot;   // "prefixScreenshot", allows to set a path and the prefix for the screenshot filename. spp, data, time and extension will be appended.
   
@@ -214,7 +246,6 @@ private:
   
   Timer m_timer;
 
-  std::map<std::string, KeywordScene> m_mapKeywordScene;
 
   std::unique_ptr<Rasterizer> m_rasterizer;
   
@@ -247,6 +278,33 @@ private:
   std::map<std::string, Picture*> m_mapPictures;
 
   std::vector<unsigned int> m_remappedMeshIndices; 
+
+  // Host side BVH over all instances in m_scene for picking, click-to-focus and camera framing.
+  // Built asynchronously after the scene has been loaded. The top-level is rebuilt when a hot reload changed the instances,
+  // the meshes of unchanged geometries are kept.
+  HostBVH                   m_hostBVH;
+  std::future<void>         m_futureHostBVH;
+  std::vector<int>          m_hostMeshes;    // Host BVH mesh index per geometry ID, -1 when not converted yet, -2 when the cache file couldn't be read.
+  size_t                    m_sizeHostBVH;   // Bytes of the host BVH triangle copies and instances, measured before the background build.
+  std::vector<InstanceData> m_pickInstances; // Per host BVH instance. Same order as the device side instance IDs.
+  int                       m_picked;        // Selected instance index, -1 when nothing is selected.
+
+  // Hot reload state. The file modification times are polled about twice per second.
+  std::string m_filenameSystem;
+  std::string m_filenameScene;
+  long long   m_timeFileSystem;
+  long long   m_timeFileScene;
+  Timer       m_timerHotReload;
+
+  std::vector<ViewDefinition> m_views; // Current multi-view layout. Empty for single view rendering. m_cameras holds the view cameras after the interactive camera.
+
+  // Input trace recording and replay. During a replay the trace drives the camera instead of the mouse.
+  InputTrace                   m_inputTrace;
+  std::string                  m_filenameRecord;
+  std::unique_ptr<InputReplay> m_inputReplay;
+  std::string                  m_filenameReplay;
+  unsigned int                 m_iterationIndex; // Iteration index the renderer returned in the last frame.
+  unsigned int                 m_restarts;       // Number of restartRendering() calls.
 };
 
 #endif // APPLICATION_H
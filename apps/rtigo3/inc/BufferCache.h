@@ -0,0 +1,99 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef BUFFER_CACHE_H
+#define BUFFER_CACHE_H
+
+#include <cuda.h>
+
+#include <map>
+#include <vector>
+
+
+struct BufferCacheStatistics
+{
+  BufferCacheStatistics()
+  : hits(0)
+  , misses(0)
+  , evictions(0)
+  , bytesInUse(0)
+  , bytesCached(0)
+  , bytesHighWater(0)
+  {
+  }
+
+  size_t hits;           // alloc() calls served from the cache.
+  size_t misses;         // alloc() calls which needed a cuMemAlloc().
+  size_t evictions;      // Cached blocks released with cuMemFree().
+  size_t bytesInUse;     // Size class bytes of the allocated blocks.
+  size_t bytesCached;    // Size class bytes of the freed blocks kept for reuse.
+  size_t bytesHighWater; // Maximum of bytesInUse since construction or the last trim().
+};
+
+
+// Caching sub-allocator for the device buffers which are reallocated on resolution, tile size, strategy and scene changes.
+// Sizes are rounded up to size classes with four steps per power of two, so resizes by a few pixels hit the same bin.
+// Freed blocks stay cached as long as the bytes in use plus the cached bytes don't exceed the high-water mark of the bytes in use.
+// The least recently freed blocks are released first.
+// Reusing a freed block synchronizes the current context once, because work in flight may still access it.
+// The calls must happen with the owning device's context current.
+class BufferCache
+{
+public:
+  BufferCache();
+  ~BufferCache(); // Releases the cached blocks. All blocks must have been freed.
+
+  CUdeviceptr alloc(const size_t size);
+  void free(const CUdeviceptr ptr); // Returns the block to the cache. Freeing 0 is fine.
+  void trim();                      // Releases all cached blocks and resets the high-water mark.
+
+  BufferCacheStatistics const& getStatistics() const;
+
+  static size_t getSizeClass(const size_t size);
+
+private:
+  struct CachedBlock
+  {
+    CUdeviceptr ptr;
+    size_t      tick; // Freeing order for the eviction.
+  };
+
+  void evict(const size_t bytesRequired); // Release the least recently freed blocks until bytesRequired more stay within the high-water mark.
+  void release(const size_t sizeClass);   // Release the least recently freed block of that size class.
+
+private:
+  std::map<size_t, std::vector<CachedBlock> > m_bins;         // Cached blocks per size class. The vectors are ordered by tick.
+  std::map<CUdeviceptr, size_t>               m_blocksInUse;  // Size class of each allocated block.
+  size_t                                      m_tick;
+  bool                                        m_isPending;    // Blocks have been freed since the last synchronization.
+  BufferCacheStatistics                       m_statistics;
+};
+
+#endif // BUFFER_CACHE_H
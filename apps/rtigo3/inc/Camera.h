@@ -50,6 +50,7 @@ public:
   void dolly(int x, int y);
   void focus(int x, int y);
   void zoom(float x);
+  void frame(const float3& lo, const float3& hi); // Moves the center of interest to the box center and adjusts the distance so that the whole box is visible.
 
   bool  getFrustum(float3& p, float3& u, float3& v, float3& w, bool force = false);
   float getAspectRatio() const;
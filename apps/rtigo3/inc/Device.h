@@ -42,15 +42,23 @@
 // OptiX 7 function table structure.
 #include <optix_function_table.h>
 
+#include "inc/AccelPolicy.h"
+#include "inc/BufferCache.h"
+#include "inc/DeviceState.h"
 #include "inc/MaterialGUI.h"
+#include "inc/ParameterChannel.h"
 #include "inc/Picture.h"
+#include "inc/PipelineKey.h"
+#include "inc/SceneDiff.h"
 #include "inc/SceneGraph.h"
 #include "inc/Texture.h"
 #include "inc/MyAssert.h"
 
 #include "shaders/system_data.h"
 #include "shaders/per_ray_data.h"
+#include "shaders/ray_query_data.h"
 
+#include <future>
 #include <map>
 #include <memory>
 #include <vector>
@@ -61,6 +69,8 @@ enum RendererStrategy
   RS_INTERACTIVE_MULTI_GPU_ZERO_COPY,
   RS_INTERACTIVE_MULTI_GPU_PEER_ACCESS,
   RS_INTERACTIVE_MULTI_GPU_LOCAL_COPY,
+  RS_MULTI_GPU_SAMPLE_RANGE, // Each device renders the full frame for its own range of samples. Meant for final frames.
+  RS_WAVEFRONT_SINGLE_GPU,   // Single GPU wavefront path tracer. One launch per bounce and step with the hits sorted by BSDF.
   NUM_RENDERER_STRATEGIES
 };
 
@@ -217,6 +227,7 @@ enum ModuleIdentifier
   MODULE_ID_BXDF_DIFFUSE,
   MODULE_ID_BXDF_SPECULAR,
   MODULE_ID_BXDF_GGX_SMITH,
+  MODULE_ID_RAYGENERATION_WAVEFRONT,
   NUM_MODULE_IDENTIFIERS
 };
 
@@ -246,6 +257,13 @@ enum ProgramGroupId
   PGID_BSDF_GGX_SMITH_SAMPLE,
   PGID_BSDF_GGX_SMITH_EVAL, 
   LAST_DIRECT_CALLABLE_ID = PGID_BSDF_GGX_SMITH_EVAL,
+  // Additional raygeneration programs of the wavefront strategy using SbtRecordHeader. Selected per launch with the SBT raygenRecord.
+  PGID_WAVEFRONT_GENERATE,
+  PGID_WAVEFRONT_TRACE,
+  PGID_WAVEFRONT_SHADE,
+  PGID_WAVEFRONT_SHADOW,
+  PGID_WAVEFRONT_RESOLVE,
+  LAST_HEADER_ID = PGID_WAVEFRONT_RESOLVE,
   // Programs using SbtRecordGeometryInstanceData
   PGID_HIT_RADIANCE,
   PGID_HIT_SHADOW,
@@ -290,17 +308,49 @@ struct InstanceData
   int          idLight;    // Negative means no light. 
 };
 
-// GUI controllable settings in the device.
-struct DeviceState
+// One compiled OptixPipeline and the SBT record headers of its program groups.
+struct PipelineData
 {
-  int2         resolution;
-  int2         tileSize;
-  int2         pathLengths;
-  int          samplesSqrt;
-  LensShader   lensShader;
-  float        epsilonFactor;
-  float        envRotation;
-  float        clockFactor;
+  PipelineData()
+  : pipeline(nullptr)
+  , lastUse(0)
+  {
+  }
+
+  OptixPipeline                pipeline;
+  unsigned int                 lastUse; // Value of Device::m_pipelineUseCount at the last activation. Selects the cache eviction.
+  std::vector<SbtRecordHeader> headers; // Raygeneration, exception, miss and callables. Same layout as m_d_sbtRecordHeaders.
+
+  SbtRecordHeader hitRadiance;
+  SbtRecordHeader hitShadow;
+  SbtRecordHeader hitRadianceCutout;
+  SbtRecordHeader hitShadowCutout;
+};
+
+
+// One half of the double-buffered host ray query submission.
+struct QuerySlot
+{
+  QuerySlot()
+  : d_rays(0)
+  , d_hits(0)
+  , h_rays(nullptr)
+  , h_hits(nullptr)
+  , event(nullptr)
+  , capacity(0)
+  , dst(nullptr)
+  , count(0)
+  {
+  }
+
+  CUdeviceptr  d_rays;
+  CUdeviceptr  d_hits;
+  QueryRay*    h_rays;   // Pinned staging memory for asynchronous copies.
+  QueryHit*    h_hits;
+  CUevent      event;    // Recorded after the download of the hits.
+  unsigned int capacity; // Number of rays the buffers can hold.
+  QueryHit*    dst;      // Caller's destination of the pending hits. nullptr when the slot is free.
+  unsigned int count;
 };
 
 
@@ -325,13 +375,34 @@ public:
   virtual void initLights(std::vector<LightDefinition> const& lights);
   virtual void initMaterials(std::vector<MaterialGUI> const& materialsGUI);
   virtual void initScene(std::shared_ptr<sg::Group> root, const unsigned int numGeometries);
+  // Applies the instance and geometry part of a scene diff after a hot reload. root must reuse the geometry IDs of the previous scene.
+  virtual void updateScene(std::shared_ptr<sg::Group> root, const unsigned int numGeometries, SceneDiff const& diff);
+  virtual void initViews(std::vector<ViewDefinition> const& views); // Empty vector switches back to single view rendering.
   
   virtual void updateCamera(const int idCamera, CameraDefinition const& camera);
   virtual void updateLight(const int idLight, LightDefinition const& light);
   virtual void updateMaterial(const int idMaterial, MaterialGUI const& materialGUI);
+  void applyParameters(ParameterDiff const& diff); // The changed entries of the latest parameter snapshot. Asynchronous except for state changes.
   
   virtual void setState(DeviceState const& state);
   virtual void compositor(Device* other);
+
+  void setViewsSequential(const bool sequential); // Render the views with one launch each instead of a single launch. For throughput comparisons.
+  void setGraphs(const bool enable); // Replay the steady state iteration as a captured CUDA graph instead of issuing the launches directly.
+
+  void getTimeViewHost(std::vector<float>& cycles, std::vector<unsigned int>& ids); // Resolution sized. ids contains two entries per pixel: instance ID + 1, material index + 1.
+  void getAovHost(const int index, std::vector<unsigned char>& aov); // Resolution sized raw AovIndex buffer. All zero when that AOV is disabled.
+
+  BufferCacheStatistics const& getBufferCacheStatistics() const;
+  void trimBufferCache(); // Releases the cached device buffers.
+
+  // Batched ray queries against the current scene with the dedicated ray query pipeline. Asynchronous in m_cudaStream.
+  // rays and hits are device pointers on this device's context to count QueryRay and QueryHit structures.
+  void traceRays(CUdeviceptr rays, CUdeviceptr hits, const unsigned int count);
+  // Double-buffered submission of host rays. Returns after enqueueing upload, launch and download of this chunk.
+  // The hits are copied to the destination when the slot is reused two submissions later or inside finishRays().
+  void submitRays(const QueryRay* rays, QueryHit* hits, const unsigned int count);
+  void finishRays();
   
   // Abstract functions:
   virtual void activateContext() = 0;
@@ -345,11 +416,31 @@ private:
   void initDeviceAttributes();
   void initDeviceProperties();
   void initPipeline();
+  void createPipeline(PipelineKey const& key, PipelineData& data);
+  void activatePipeline(PipelineKey const& key);
+  void evictPipelines();
   void traverseNode(std::shared_ptr<sg::Node> node, float matrix[12], InstanceData data);
+  void countGeometryReferences(std::shared_ptr<sg::Node> node);
   unsigned int createGeometry(std::shared_ptr<sg::Triangles> geometry);
   void createInstance(const OptixTraversableHandle traversable, float matrix[12], InstanceData const& data);
   void createTLAS();
+  void updateTLAS();
   void createHitGroupRecords();
+  void updateTimeViewBuffers();
+  void updateAovBuffers();
+  void updateRouletteBuffers();
+  void updateRouletteCache();
+  void initQueryPipeline();
+  void updateQueryRecords();
+  void retireQuerySlot(QuerySlot& slot);
+  void captureIteration(const unsigned int width, const unsigned int height);
+  void destroyIterationGraph();
+
+protected:
+  void updatePipeline(); // Called at the beginning of the derived render() functions.
+  virtual void launch(const unsigned int width, const unsigned int height); // The optixLaunch() of the derived render() functions. Handles multi-view rendering.
+  // Uploads m_systemData.iterationIndex and calls launch(). Replays a CUDA graph of that sequence when possible. The stream must be synchronized.
+  void launchIteration(const unsigned int width, const unsigned int height);
 
 public:
   // Constructor arguments:
@@ -362,7 +453,7 @@ public:
   unsigned int     m_tex;         // The OpenGL HDR texture object.
   unsigned int     m_pbo;         // The OpenGL PixelBufferObject handle when interop should be used. 0 when not.
   
-  float m_clockFactor; // Clock Factor scaled by CLOCK_FACTOR_SCALE (1.0e-9f) for USE_TIME_VIEW
+  float m_clockFactor; // Clock Factor scaled by CLOCK_FACTOR_SCALE (1.0e-9f) for the time view.
 
   CUuuid m_deviceUUID;
   
@@ -378,13 +469,31 @@ public:
 
   CUcontext m_cudaContext;
   CUstream  m_cudaStream;
+
+  // Output, tile, texel, time view, AOV and roulette buffers, temporary acceleration structure build buffers, the IAS and the SBT records
+  // are reallocated on resolution, strategy and scene changes. They are recycled through this cache.
+  BufferCache m_bufferCache;
   
   OptixFunctionTable m_api;
   OptixDeviceContext m_optixContext;
   
   std::vector<std::string> m_moduleFilenames;
 
-  OptixPipeline m_pipeline;
+  OptixPipeline m_pipeline; // The currently active pipeline. Owned by m_pipelines.
+
+  std::map<PipelineKey, PipelineData> m_pipelines; // Cache of all compiled pipelines. Contains at least the generic one.
+
+  unsigned int      m_pipelineUseCount;    // Incremented per activation.
+  PipelineKey       m_pipelineKeyGeneric;  // Fallback which renders all settings.
+  PipelineKey       m_pipelineKeyActive;   // The key of m_pipeline.
+  PipelineKey       m_pipelineKeyPending;  // The key compiled by the background task.
+  PipelineData      m_pipelineDataPending; // Only written by the background task until m_futurePipeline is ready.
+  std::future<void> m_futurePipeline;
+
+  bool m_specialize;
+  bool m_isDirtyPipeline;
+
+  std::vector<int> m_lightTypes; // LightType per light, needed for the pipeline key.
   
   OptixShaderBindingTable m_sbt;
   
@@ -397,9 +506,16 @@ public:
   SbtRecordGeometryInstanceData m_sbtRecordHitShadowCutout;
 
   CUdeviceptr m_d_ias;
+  bool        m_allowUpdateIAS; // The TLAS has been built with OPTIX_BUILD_FLAG_ALLOW_UPDATE and can be refit.
 
   std::vector<GeometryData>  m_geometryData;
 
+  AccelPolicy         m_accelPolicy;
+  int                 m_envFormat;
+  std::vector<size_t> m_geometryReferences;   // Number of instances per GAS.
+  size_t              m_accelBudgetTotal;     // VRAM budget for the geometry in bytes.
+  size_t              m_accelBudgetRemaining;
+
   std::vector<OptixInstance> m_instances;
   std::vector<InstanceData>  m_instanceData; // idGeometry, idMaterial, idLight
 
@@ -420,6 +536,38 @@ public:
   Texture* m_textureEnv;
 
   std::vector<MaterialDefinition> m_materials; // Staging data for the device side sysData.materialDefinitions
+
+  // Multi-view rendering.
+  std::vector<ViewDefinition> m_views;           // Host copy of sysData.viewDefinitions.
+  int*                        m_h_viewOffsets;   // Pinned source data of the asynchronous viewOffset uploads in sequential view rendering. numViews + 1 entries, the last restores m_index.
+  int2                        m_viewLaunch;      // Launch width and height covering the biggest view.
+  bool                        m_viewsSequential;
+
+  // CUDA graph of the steady state iteration, the iterationIndex upload followed by launch().
+  bool                    m_useGraphs;
+  bool                    m_isDirtyGraph;     // The views changed. Pipeline, SBT and launch size are compared against the captured ones.
+  CUgraph                 m_graph;
+  CUgraphExec             m_graphExec;
+  unsigned int*           m_h_iterationIndex; // Pinned source of the iterationIndex upload. Read by every replay, so no node update is required.
+  OptixPipeline           m_graphPipeline;    // The state baked into m_graphExec.
+  OptixShaderBindingTable m_graphSbt;
+  unsigned int            m_graphWidth;
+  unsigned int            m_graphHeight;
+
+  // Ray query pipeline. Only created on the first traceRays() call.
+  std::string             m_queryModuleFilename;
+  OptixPipeline           m_queryPipeline;
+  SbtRecordHeader         m_queryHeaders[3];      // Raygeneration, miss, hit group.
+  OptixShaderBindingTable m_querySbt;
+  CUdeviceptr             m_d_queryRecords;       // Raygeneration and miss record followed by the hit group records.
+  unsigned int            m_queryNumHitRecords;   // NUM_RAYTYPES records per instance, like the renderer's SBT.
+  QueryParameters*        m_d_queryParameters;
+  QuerySlot               m_querySlots[2];
+  int                     m_querySlot;            // The slot used by the next submitRays().
+
+  // Host staging data of the adaptive roulette cache update. Sized when the roulette buffers are allocated.
+  std::vector<float2> m_rouletteStats;
+  std::vector<float>  m_rouletteCache;
 }; 
 
 #endif // DEVICE_H
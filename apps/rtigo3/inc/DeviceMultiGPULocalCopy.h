@@ -56,6 +56,8 @@ public:
   const void* getOutputBufferHost();
 
 private:
+  size_t getTexelCount() const;
+
   CUgraphicsResource  m_cudaGraphicsResource; // The handle for the registered OpenGL PBO when using interop.
 
   CUmodule    m_moduleCompositor;
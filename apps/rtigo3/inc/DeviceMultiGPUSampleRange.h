@@ -0,0 +1,72 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+ 
+#ifndef DEVICE_MULTI_GPU_SAMPLE_RANGE_H
+#define DEVICE_MULTI_GPU_SAMPLE_RANGE_H
+
+#include "inc/Device.h"
+#include "inc/SampleRange.h"
+
+// Renders the full frame like a single GPU into a GPU local accumulation buffer, but only the samples of its own range.
+// The base Device is constructed with index 0 and count 1, so the shaders and the multi-view distribution treat it as the only device.
+class DeviceMultiGPUSampleRange : public Device
+{
+public:
+  DeviceMultiGPUSampleRange(const RendererStrategy strategy,
+                            const int ordinal,
+                            const int index,
+                            const int count,
+                            const int miss, 
+                            const int interop,
+                            const unsigned int tex,
+                            const unsigned int pbo);
+  ~DeviceMultiGPUSampleRange();
+
+  void setState(DeviceState const& state); // Partial override to track the sample range.
+
+  void activateContext();
+  void synchronizeStream();
+  void render(const unsigned int iterationIndex, void** buffer);
+  void updateDisplayTexture();
+  const void* getOutputBufferHost();
+
+  void updateDisplayTexture(const float4* data); // Uploads the host side merged image of all devices.
+
+  SampleRange getSampleRange() const;
+
+private:
+  int         m_rangeIndex; // The actual device index and count, only used to select the sample range.
+  int         m_rangeCount;
+  SampleRange m_range;
+
+  std::vector<float4> m_bufferHost;
+};
+
+#endif // DEVICE_MULTI_GPU_SAMPLE_RANGE_H
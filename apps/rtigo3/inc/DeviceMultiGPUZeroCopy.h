@@ -53,6 +53,9 @@ public:
   void render(const unsigned int iterationIndex, void** buffer);
   void updateDisplayTexture();
   const void* getOutputBufferHost();
+
+private:
+  std::vector<float4> m_bufferHost; // The detiled image of the tile ordered accumulation layout. Empty for the linear layout.
 };
 
 #endif // DEVICE_MULTI_GPU_ZERO_COPY_H
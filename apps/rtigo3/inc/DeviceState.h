@@ -0,0 +1,60 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef DEVICE_STATE_H
+#define DEVICE_STATE_H
+
+#include <cuda_runtime.h> // int2
+
+#include "inc/AccelPolicy.h"
+
+#include "shaders/function_indices.h"
+
+// GUI controllable settings in the device.
+struct DeviceState
+{
+  int2         resolution;
+  int2         tileSize;
+  int2         pathLengths;
+  int          samplesSqrt;
+  LensShader   lensShader;
+  float        epsilonFactor;
+  float        envRotation;
+  float        clockFactor;
+  int          specialize; // 1 = compile scene-adaptive pipelines in the background.
+  int          timeView;   // 1 = measure per pixel clock cycles into the time view buffers and display them with the color ramp.
+  int          roulette;   // 1 = adaptive Russian roulette and splitting learned per image tile, 0 = fixed rule after pathLengths.x.
+  int          accumulationLayout; // ACCUMULATION_LAYOUT_* of shaders/tile_layout.h. Only the zero copy and local copy strategies use the tiled layout.
+  AccelPolicy  accelPolicy; // Acceleration structure build policy used by initScene().
+  unsigned int aovMask;     // AOV_* bits of the AOV buffers to render. See shaders/aov_definition.h.
+  int          envFormat;   // EnvFormat of the spherical environment texture used by initTextures().
+};
+
+#endif // DEVICE_STATE_H
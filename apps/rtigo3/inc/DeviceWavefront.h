@@ -0,0 +1,82 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+ 
+#ifndef DEVICE_WAVEFRONT_H
+#define DEVICE_WAVEFRONT_H
+
+#include "inc/DeviceSingleGPU.h"
+
+#include "shaders/wavefront_definition.h"
+
+// Single GPU wavefront path tracer. Uses the output buffer and interop handling of the single GPU device
+// and replaces the megakernel launch with one launch per bounce and step.
+class DeviceWavefront : public DeviceSingleGPU
+{
+public:
+  DeviceWavefront(const RendererStrategy strategy,
+                  const int ordinal,
+                  const int index,
+                  const int count,
+                  const int miss,
+                  const int interop,
+                  const unsigned int tex,
+                  const unsigned int pbo);
+  ~DeviceWavefront();
+
+  void setState(DeviceState const& state);
+  void render(const unsigned int iterationIndex, void** buffer);
+
+  void setWavefront(const bool enable); // false renders with the megakernel __raygen__path_tracer instead. For throughput comparisons.
+  unsigned long long getRayCount();     // Radiance and shadow rays traced by the wavefront launches since the buffers were allocated. Synchronizes.
+
+protected:
+  void launch(const unsigned int width, const unsigned int height);
+
+private:
+  void updateWavefrontBuffers();
+  void launchKernel(CUfunction function, const unsigned int numBlocks, const unsigned int numThreads);
+  void launchProgram(const int id, const unsigned int width, const unsigned int height);
+  void validateQueues();
+
+  CUmodule   m_moduleWavefront;
+  CUfunction m_functionReset;
+  CUfunction m_functionHistogram;
+  CUfunction m_functionOffsets;
+  CUfunction m_functionScatter;
+  CUfunction m_functionAdvance;
+
+  bool           m_useWavefront;
+  unsigned int   m_wavefrontCapacity; // Number of paths in the buffers. Reallocated when the resolution changes.
+  CUdeviceptr    m_d_wavefrontBuffer; // One allocation for all path state and queue arrays.
+  WavefrontData  m_wavefront;         // Host copy of the device pointers into m_d_wavefrontBuffer.
+  WavefrontData* m_d_wavefront;       // sysData.wavefront and the argument of the native kernels.
+};
+
+#endif // DEVICE_WAVEFRONT_H
@@ -0,0 +1,57 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef ENV_FORMAT_H
+#define ENV_FORMAT_H
+
+#include "shaders/env_format_definition.h"
+
+#include <cstddef>
+
+// Host conversion of the RGBA32F spherical environment texels into the compact device formats.
+// The SSE2 code paths produce bit identical results to the scalar functions used for the remaining texels.
+
+// Bytes per texel of the device environment texture in the given EnvFormat.
+size_t getEnvFormatElementSize(const int format);
+
+// The name printed in the memory report, e.g. "RGB9E5".
+const char* getEnvFormatName(const int format);
+
+// Round to nearest even. Finite values beyond the half range are clamped to 65504.0f, NaN stays NaN.
+unsigned short floatToHalf(const float f);
+
+// Negative and NaN components become zero, values above RGB9E5_MAX_VALUE are clamped.
+unsigned int encodeRGB9E5(const float r, const float g, const float b);
+
+// count is the number of RGBA texels. Alpha is dropped by the RGB9E5 conversion.
+void convertToRGBA16F(unsigned short* dst, const float* rgba, const size_t count);
+void convertToRGB9E5(unsigned int* dst, const float* rgba, const size_t count);
+
+#endif // ENV_FORMAT_H
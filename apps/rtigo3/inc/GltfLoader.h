@@ -0,0 +1,162 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef GLTF_LOADER_H
+#define GLTF_LOADER_H
+
+// For the vector types.
+#include <cuda_runtime.h>
+
+#include "shaders/vertex_attributes.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Read-only memory mapping of a whole file.
+class MappedFile
+{
+public:
+  MappedFile();
+  ~MappedFile();
+
+  MappedFile(MappedFile const&) = delete;
+  MappedFile& operator=(MappedFile const&) = delete;
+
+  bool open(std::string const& filename); // Returns false when the file can't be opened or is empty.
+  void close();
+
+  const unsigned char* getData() const;
+  size_t getSize() const;
+
+private:
+  const unsigned char* m_data;
+  size_t               m_size;
+#if defined(_WIN32)
+  void* m_file;    // HANDLE
+  void* m_mapping; // HANDLE
+#endif
+};
+
+
+// Accessor indices of one triangle primitive. -1 when the attribute is not present.
+struct GltfPrimitive
+{
+  int position;
+  int normal;
+  int tangent;
+  int texcoord; // TEXCOORD_0
+  int indices;
+  int mode;     // 4 = triangles, 5 = triangle strip, 6 = triangle fan. Points and lines are not loaded.
+  int material; // -1 uses the default material.
+};
+
+struct GltfMesh
+{
+  std::vector<GltfPrimitive> primitives;
+};
+
+struct GltfNode
+{
+  std::string      name;
+  float            matrix[12]; // Local transform, row-major 3x4 like sg::Instance.
+  int              mesh;       // -1 when the node has no mesh.
+  std::vector<int> children;
+  // EXT_mesh_gpu_instancing. 12 floats per instance, row-major 3x4 in the local space of the node.
+  // Empty when the node's mesh is not instanced.
+  std::vector<float> instances;
+};
+
+struct GltfMaterial
+{
+  std::string name;
+  float3      baseColor; // pbrMetallicRoughness.baseColorFactor.rgb
+};
+
+
+// Native glTF 2.0 (.gltf and .glb) loader for triangle meshes, node hierarchies and EXT_mesh_gpu_instancing.
+// The file and the external buffers stay memory mapped while the loader exists.
+// readPrimitive() reads the accessors by their stride from the mapped memory straight into the TriangleAttributes.
+class GltfLoader
+{
+public:
+  GltfLoader();
+  ~GltfLoader();
+
+  bool load(std::string const& filename); // Parses the JSON and maps all buffers. Returns false on any error.
+
+  // Fills the attributes and the triangle list indices of one primitive. Returns false when the accessors are invalid.
+  // Missing normals are calculated, missing tangents are returned as zero vectors. The texture coordinate v is flipped.
+  // Thread safe. Different primitives can be read in parallel.
+  bool readPrimitive(GltfPrimitive const& primitive, std::vector<TriangleAttributes>& attributes, std::vector<unsigned int>& indices) const;
+
+  std::vector<GltfMaterial> m_materials;
+  std::vector<GltfMesh>     m_meshes;
+  std::vector<GltfNode>     m_nodes;
+  std::vector<int>          m_roots; // Nodes of the default scene.
+
+private:
+  struct Buffer
+  {
+    const unsigned char* data;
+    size_t               size;
+  };
+
+  struct BufferView
+  {
+    int    buffer;
+    size_t offset;
+    size_t length;
+    size_t stride; // 0 means tightly packed.
+  };
+
+  struct Accessor
+  {
+    int    bufferView; // -1 (zeros plus sparse values) is not supported.
+    size_t offset;
+    size_t count;
+    int    componentType;
+    int    numComponents;
+    bool   normalized;
+  };
+
+  bool parse(const char* json, const size_t length, std::string const& path, const unsigned char* chunkBIN, const size_t sizeBIN);
+  bool readFloats(const int indexAccessor, const int numComponents, std::vector<float>& values) const; // Used for the instance transforms.
+  const unsigned char* getElements(Accessor const& accessor, size_t& stride) const; // nullptr when the accessor is out of bounds.
+
+  std::vector< std::unique_ptr<MappedFile> >     m_files;   // The model file and the external buffers.
+  std::vector< std::vector<unsigned char> >      m_decoded; // Base64 data URI buffers.
+  std::vector<Buffer>                            m_buffers;
+  std::vector<BufferView>                        m_bufferViews;
+  std::vector<Accessor>                          m_accessors;
+};
+
+#endif // GLTF_LOADER_H
@@ -0,0 +1,139 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef HOST_BVH_H
+#define HOST_BVH_H
+
+#include <cstddef>
+#include <vector>
+
+// Host side two-level bounding volume hierarchy for interactive queries like picking, click-to-focus and camera framing.
+// Both levels are 4-wide BVHs built with a binned surface area heuristic. Big subtrees are built in parallel.
+// Traversal tests all four child boxes of a node at once with SSE when available.
+// The meshes are copies in the precomputed edge layout of the triangle test, so they stay valid when the scene graph releases its host data.
+
+struct BvhRay
+{
+  float org[3];
+  float dir[3];
+  float tmin;
+  float tmax;
+};
+
+struct BvhHit
+{
+  float        t;         // Ray parameter of the closest hit.
+  int          instance;  // Instance index in addInstance() order. -1 means miss.
+  unsigned int primitive; // Triangle index inside the mesh.
+  float        u;         // Barycentric coordinates of the hit relative to the second and third triangle vertex.
+  float        v;
+};
+
+struct BvhAabb
+{
+  float lo[3];
+  float hi[3];
+};
+
+// Four children per node in SoA layout for the SIMD slab test.
+// Empty slots have all bounds at +infinity which makes the slab test fail for every ray.
+struct BvhNode4
+{
+  float lo[3][4];
+  float hi[3][4];
+  int   child[4]; // Inner child: node index. Leaf: first entry in the primitive array. -1 means empty slot.
+  int   count[4]; // 0 for inner children and empty slots, else the number of primitives in the leaf.
+};
+
+struct BvhTriangle
+{
+  float v0[3];
+  float e1[3]; // v1 - v0
+  float e2[3]; // v2 - v0
+};
+
+struct BvhMesh
+{
+  std::vector<BvhTriangle>  triangles;  // Reordered to match the leaves after the build.
+  std::vector<unsigned int> primitives; // Original triangle index per entry in triangles.
+  std::vector<BvhNode4>     nodes;      // nodes[0] is the root.
+  BvhAabb                   bounds;
+  bool                      isBuilt = false; // build() only builds new meshes.
+};
+
+struct BvhInstance
+{
+  int     mesh;
+  float   matrix[12];  // Object to world, row-major 3x4 like the OptixInstance transform.
+  float   inverse[12]; // World to object.
+  BvhAabb bounds;      // World space.
+  bool    valid;       // False for singular matrices or empty meshes. These are never hit.
+};
+
+
+class HostBVH
+{
+public:
+  HostBVH();
+
+  void clear();
+  void clearInstances(); // Keeps the meshes and their BVHs for the next addInstance() calls.
+
+  // positions points to the first vertex position, strideInBytes is the distance between two consecutive vertices.
+  // The triangles are copied, 36 bytes plus the original index each. Returns the mesh index to be used with addInstance().
+  int addMesh(const float* positions, const size_t strideInBytes, const size_t numVertices, const unsigned int* indices, const size_t numIndices);
+  int addInstance(const int mesh, const float matrix[12]);
+  void removeMesh(const int mesh); // Frees the mesh. The index stays reserved, instances of it are never hit.
+
+  void build(); // Builds the new mesh BVHs in parallel and then the top-level BVH over the instances.
+
+  bool intersect(BvhRay const& ray, BvhHit& hit) const;           // Closest hit.
+  bool intersectBruteForce(BvhRay const& ray, BvhHit& hit) const; // Reference result testing every triangle of every instance.
+
+  bool getBounds(BvhAabb& bounds) const; // World space scene bounds. False when there is nothing to hit.
+  bool getInstanceBounds(const int instance, BvhAabb& bounds) const;
+
+  size_t getNumInstances() const;
+  size_t getNumTriangles() const; // Triangles of all instances, counting instanced meshes multiple times.
+  size_t getMemoryUsage() const;  // Bytes allocated for the triangle copies, the nodes and the instances.
+
+private:
+  bool intersectInstance(BvhInstance const& instance, BvhRay const& ray, float& tmax, BvhHit& hit, const bool bruteForce) const;
+
+private:
+  std::vector<BvhMesh>      m_meshes;
+  std::vector<BvhInstance>  m_instances;
+  std::vector<unsigned int> m_order; // Instance index per top-level leaf entry.
+  std::vector<BvhNode4>     m_nodes; // Top-level BVH over the instances.
+  BvhAabb                   m_bounds;
+  bool                      m_isBuilt;
+};
+
+#endif // HOST_BVH_H
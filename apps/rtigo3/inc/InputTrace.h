@@ -0,0 +1,190 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef INPUT_TRACE_H
+#define INPUT_TRACE_H
+
+#include "inc/Timer.h"
+
+#include <string>
+#include <vector>
+
+// Camera and selection interactions as resolved by Application::guiEventHandler() and the parameter edits of Application::guiWindow().
+// Recording these instead of raw mouse states keeps the traces independent of the window system and ImGui,
+// so the same trace can drive the interactive application, the GUI-less replay mode and CPU stand-ins.
+enum InputEventType
+{
+  INPUT_EVENT_BASE,   // Camera::setBaseCoordinates(x, y) at the begin of a drag.
+  INPUT_EVENT_ORBIT,  // Camera::orbit(x, y)
+  INPUT_EVENT_DOLLY,  // Camera::dolly(x, y)
+  INPUT_EVENT_PAN,    // Camera::pan(x, y)
+  INPUT_EVENT_ZOOM,   // Camera::zoom(value)
+  INPUT_EVENT_FOCUS,  // Double click focus on the surface under (x, y).
+  INPUT_EVENT_SELECT, // Ctrl+click selection of the instance under (x, y).
+  INPUT_EVENT_FRAME,     // Key F, frame the selection or the whole scene.
+  INPUT_EVENT_PARAMETER, // GUI edit. x = InputParameter, y = material or light index, value = new value.
+  INPUT_EVENT_END        // Last recorded frame and time. Keeps the idle tail of a trace.
+};
+
+// The GUI parameters of INPUT_EVENT_PARAMETER. Vector parameters are edited per component.
+enum InputParameter
+{
+  INPUT_PARAMETER_MOUSE_RATIO,
+  INPUT_PARAMETER_PRESENT,
+  INPUT_PARAMETER_LENS_SHADER,
+  INPUT_PARAMETER_RESOLUTION_X,
+  INPUT_PARAMETER_RESOLUTION_Y,
+  INPUT_PARAMETER_VIEW_LAYOUT,
+  INPUT_PARAMETER_VIEW_GRID_X,
+  INPUT_PARAMETER_VIEW_GRID_Y,
+  INPUT_PARAMETER_VIEWS_SEQUENTIAL,
+  INPUT_PARAMETER_GRAPHS,
+  INPUT_PARAMETER_SAMPLES_SQRT,
+  INPUT_PARAMETER_PATH_LENGTH_MIN,
+  INPUT_PARAMETER_PATH_LENGTH_MAX,
+  INPUT_PARAMETER_ROULETTE,
+  INPUT_PARAMETER_TILED_ACCUMULATION,
+  INPUT_PARAMETER_EPSILON_FACTOR,
+  INPUT_PARAMETER_ENV_ROTATION,
+  INPUT_PARAMETER_SPECIALIZE,
+  INPUT_PARAMETER_TIME_VIEW,
+  INPUT_PARAMETER_CLOCK_FACTOR,
+  INPUT_PARAMETER_AOV_MASK,
+  INPUT_PARAMETER_BALANCE_R, // Tonemapper
+  INPUT_PARAMETER_BALANCE_G,
+  INPUT_PARAMETER_BALANCE_B,
+  INPUT_PARAMETER_GAMMA,
+  INPUT_PARAMETER_WHITE_POINT,
+  INPUT_PARAMETER_BURN_HIGHLIGHTS,
+  INPUT_PARAMETER_CRUSH_BLACKS,
+  INPUT_PARAMETER_SATURATION,
+  INPUT_PARAMETER_BRIGHTNESS,
+  INPUT_PARAMETER_MATERIAL_BXDF, // Materials
+  INPUT_PARAMETER_MATERIAL_ALBEDO_R,
+  INPUT_PARAMETER_MATERIAL_ALBEDO_G,
+  INPUT_PARAMETER_MATERIAL_ALBEDO_B,
+  INPUT_PARAMETER_MATERIAL_ALBEDO_TEXTURE,
+  INPUT_PARAMETER_MATERIAL_CUTOUT_TEXTURE,
+  INPUT_PARAMETER_MATERIAL_THINWALLED,
+  INPUT_PARAMETER_MATERIAL_ABSORPTION_R,
+  INPUT_PARAMETER_MATERIAL_ABSORPTION_G,
+  INPUT_PARAMETER_MATERIAL_ABSORPTION_B,
+  INPUT_PARAMETER_MATERIAL_ABSORPTION_SCALE,
+  INPUT_PARAMETER_MATERIAL_IOR,
+  INPUT_PARAMETER_MATERIAL_ROUGHNESS_X,
+  INPUT_PARAMETER_MATERIAL_ROUGHNESS_Y,
+  INPUT_PARAMETER_LIGHT_EMISSION_R, // Lights
+  INPUT_PARAMETER_LIGHT_EMISSION_G,
+  INPUT_PARAMETER_LIGHT_EMISSION_B,
+
+  NUM_INPUT_PARAMETERS
+};
+
+struct InputEvent
+{
+  unsigned int   frame; // Frame index since the start of the recording.
+  double         time;  // Seconds since the start of the recording.
+  InputEventType type;
+  int            x;
+  int            y;
+  float          value;
+};
+
+
+class InputTrace
+{
+public:
+  InputTrace();
+
+  void startRecording();
+  bool isRecording() const;
+  void nextFrame(); // Call once per rendered frame while recording.
+  void record(const InputEventType type, const int x, const int y, const float value);
+
+  bool save(std::string const& filename);
+  bool load(std::string const& filename);
+
+  std::vector<InputEvent> const& getEvents() const;
+
+private:
+  bool                    m_isRecording;
+  unsigned int            m_frame;
+  Timer                   m_timer;
+  std::vector<InputEvent> m_events;
+};
+
+
+// Per frame measurements of a trace replay.
+struct ReplayFrame
+{
+  double       seconds;    // Time from applying the frame's events until the next frame begins. Includes rendering and presenting.
+  unsigned int events;     // Number of events applied at the begin of this frame.
+  unsigned int iteration;  // Iteration index the renderer reached in this frame.
+  bool         restarted;  // The accumulation restarted in this frame.
+};
+
+// Feeds the events of a trace back frame by frame.
+// Frame locked replays deliver the events of recorded frame N in replayed frame N, independent of the rendering speed.
+// That makes the number of rendered iterations between interactions reproducible, which is what the restart statistics measure.
+// Realtime replays deliver the events at their recorded time instead, which matches the user experience on the recording machine.
+class InputReplay
+{
+public:
+  InputReplay(std::vector<InputEvent> const& events, const bool realtime);
+
+  bool isFinished() const;
+
+  // Ends the previous frame and returns the events to apply in the next one.
+  // The iteration index and the restart counter are the renderer's state after the previous frame.
+  void nextFrame(const unsigned int iterationIndex, const unsigned int restarts, std::vector<InputEvent>& events);
+
+  std::string getReport() const;
+  bool saveFrames(std::string const& filename) const;
+
+  std::vector<ReplayFrame> const& getFrames() const;
+
+private:
+  std::vector<InputEvent> m_events;
+  bool                    m_realtime;
+  size_t                  m_next;       // Index of the next event to deliver.
+  unsigned int            m_frame;      // Current replay frame.
+  unsigned int            m_lastFrame;  // Recorded frame of the end event.
+  double                  m_lastTime;   // Recorded time of the end event.
+  bool                    m_isFinished;
+
+  Timer        m_timer;      // Replay time for the realtime mode.
+  Timer        m_timerFrame; // Frame time.
+  unsigned int m_restarts;   // Restart counter at the begin of the current frame.
+
+  std::vector<ReplayFrame>  m_frames;
+  std::vector<unsigned int> m_samplesBetweenRestarts; // Iterations accumulated before each restart interrupted them.
+};
+
+#endif // INPUT_TRACE_H
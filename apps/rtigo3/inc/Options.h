@@ -47,6 +47,9 @@ public:
   bool        getOptimize() const;
   std::string getSystem() const;
   std::string getScene() const;
+  std::string getRecord() const;
+  std::string getReplay() const;
+  bool        getRealtime() const;
 
 private:
   void printUsage(std::string const& argv);
@@ -58,6 +61,9 @@ private:
   bool        m_optimize;
   std::string m_filenameSystem;
   std::string m_filenameScene;
+  std::string m_filenameRecord;
+  std::string m_filenameReplay;
+  bool        m_realtime;
 };
 
 #endif // OPTIONS_H
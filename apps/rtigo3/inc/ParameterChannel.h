@@ -0,0 +1,123 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef PARAMETER_CHANNEL_H
+#define PARAMETER_CHANNEL_H
+
+#include <cuda_runtime.h> // float3
+
+#include "inc/DeviceState.h"
+#include "inc/MaterialGUI.h"
+
+#include "shaders/camera_definition.h"
+#include "shaders/light_definition.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Single producer, multi consumer channel of the GUI edits to the renderer.
+// The producer (GUI) collects edits and publishes them as an immutable, versioned snapshot. Each consumer (device) picks up
+// the latest snapshot once per frame together with the changes against the snapshot it picked up before, so any number
+// of edits between two frames are coalesced into one upload. Neither side blocks the other: the latest snapshot is an
+// atomic pointer and retired snapshots are only deleted when no consumer holds them (hazard pointers).
+
+// One consumer slot per bit of the devicesMask.
+#define MAX_PARAMETER_CONSUMERS 32
+
+// Immutable after publish(). Unchanged sections are shared with the previous snapshot.
+struct ParameterSnapshot
+{
+  unsigned int version; // Increments with every publish(). Version 0 is the empty initial snapshot.
+
+  std::shared_ptr<const DeviceState>                   state; // nullptr until the first setState().
+  std::shared_ptr<const std::vector<CameraDefinition>> cameras;
+  std::shared_ptr<const std::vector<LightDefinition>>  lights;
+  std::shared_ptr<const std::vector<MaterialGUI>>      materials;
+};
+
+// Changes of the latest snapshot against the one the consumer acquired before.
+struct ParameterDiff
+{
+  const ParameterSnapshot* snapshot; // Stays valid until the next acquire() of the same consumer.
+
+  bool             isDirtyState;
+  std::vector<int> cameras;   // Indices of the changed entries.
+  std::vector<int> lights;
+  std::vector<int> materials;
+};
+
+class ParameterChannel
+{
+public:
+  ParameterChannel();
+  ~ParameterChannel();
+
+  // Producer side. Only one thread. The edits become visible with the next publish().
+  void setState(DeviceState const& state);
+  void setCameras(std::vector<CameraDefinition> const& cameras);
+  void setCamera(const int id, CameraDefinition const& camera);
+  void setLights(std::vector<LightDefinition> const& lights);
+  void setLight(const int id, LightDefinition const& light);
+  void setMaterials(std::vector<MaterialGUI> const& materials);
+  void setMaterial(const int id, MaterialGUI const& material);
+
+  bool publish(); // Returns false when there was nothing to publish.
+
+  unsigned int getVersion() const; // Version of the latest published snapshot.
+
+  // Consumer side. Each consumer index in [0, MAX_PARAMETER_CONSUMERS) must only be used by one thread at a time.
+  // Returns false when the latest snapshot is the one the consumer acquired before. A consumer which never acquired
+  // a snapshot gets every entry as changed.
+  bool acquire(const int consumer, ParameterDiff& diff);
+
+private:
+  void reclaim();
+
+  struct Consumer
+  {
+    std::atomic<const ParameterSnapshot*> acquired;  // The snapshot of the last diff. The next diff is calculated against it.
+    std::atomic<const ParameterSnapshot*> acquiring; // Protects the latest snapshot while acquire() validates it.
+  };
+
+  std::atomic<const ParameterSnapshot*> m_latest;
+  Consumer                              m_consumers[MAX_PARAMETER_CONSUMERS];
+
+  // Producer only.
+  std::vector<const ParameterSnapshot*> m_retired; // Published snapshots which are not the latest anymore.
+
+  // The pending edits since the last publish(). nullptr means the section is unchanged.
+  std::shared_ptr<DeviceState>                   m_state;
+  std::shared_ptr<std::vector<CameraDefinition>> m_cameras;
+  std::shared_ptr<std::vector<LightDefinition>>  m_lights;
+  std::shared_ptr<std::vector<MaterialGUI>>      m_materials;
+};
+
+#endif // PARAMETER_CHANNEL_H
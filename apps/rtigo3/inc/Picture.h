@@ -110,15 +110,27 @@ public:
   // DEBUG Function to generate all 14 texture targets with RGBA8 images.
   void generateRGBA8(unsigned int width, unsigned int height, unsigned int depth, const unsigned int flags);
 
+  // Host residency. The pixel data is only needed until the devices created their textures.
+  // release() deletes it when the picture can be loaded from its source file again. reload() does that.
+  bool release();
+  bool reload();
+  bool isResident() const;
+  size_t getSizeInBytes() const; // Pixel data of all images and levels. 0 while released.
+
 private:
   void mirrorX(unsigned int index);
   void mirrorY(unsigned int index);
+  void generateMipmaps(unsigned int index); // Box filtered mipmap chain for a 2D image loaded without mipmaps.
   
   void clearImages(); // Delete all pixel data, all Image pointers and clear the m_images vector.
 
 private:
   bool m_isCube;                              // Track if the picture is a cube map.
   std::vector< std::vector<Image*> > m_images;
+
+  std::string  m_filename;   // Source of reload(). Empty when the images were not only created by load().
+  unsigned int m_flags;
+  bool         m_isResident;
 };
 
 #endif // PICTURE_H
@@ -0,0 +1,242 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef PIPELINE_KEY_H
+#define PIPELINE_KEY_H
+
+#include <cuda_runtime.h>
+
+#include "shaders/function_indices.h"
+#include "shaders/material_definition.h"
+
+#include <map>
+#include <tuple>
+#include <vector>
+
+// Specialized pipelines are cached by key. Each lens shader, AOV mask and material and light combination selected in the GUI
+// compiles another pipeline. Above this count, the least recently activated specialized pipeline is destroyed.
+#define PIPELINE_CACHE_SIZE 8
+
+// Identifies one compiled OptixPipeline.
+// A generic pipeline contains all program groups and reads every SystemData field at runtime.
+// A specialized pipeline only contains the program groups the current scene and settings can reach
+// and has the constant SystemData fields lensShader and aovMask bound as compile time values.
+// The path lengths stay runtime values. They change with every GUI edit and would compile a pipeline per value.
+struct PipelineKey
+{
+  int          strategy;      // RendererStrategy. Selects the ray generation program.
+  int          miss;          // 0 = black no light, 1 = constant white, 2 = spherical HDR env map.
+  int          generic;       // 1 = all program groups, no bound values. All other fields below are ignored then.
+  int          lensShader; // LensShader index bound into the ray generation program.
+  unsigned int maskBSDF;   // Bit (1 << FunctionIndex) is set when any material uses that BXDF.
+  unsigned int maskLights; // Bit (1 << LightType) is set when any light in the scene is of that type.
+  int          cutout;     // 1 when any material uses a cutout opacity texture.
+  unsigned int aovMask;    // Bound SystemData::aovMask.
+};
+
+
+inline bool operator<(PipelineKey const& lhs, PipelineKey const& rhs)
+{
+  return std::tie(lhs.strategy, lhs.miss, lhs.generic, lhs.lensShader, lhs.maskBSDF, lhs.maskLights, lhs.cutout, lhs.aovMask) <
+         std::tie(rhs.strategy, rhs.miss, rhs.generic, rhs.lensShader, rhs.maskBSDF, rhs.maskLights, rhs.cutout, rhs.aovMask);
+}
+
+inline bool operator==(PipelineKey const& lhs, PipelineKey const& rhs)
+{
+  return !(lhs < rhs) && !(rhs < lhs);
+}
+
+inline bool operator!=(PipelineKey const& lhs, PipelineKey const& rhs)
+{
+  return !(lhs == rhs);
+}
+
+
+// The generic key has all scene dependent fields cleared so that there is exactly one generic pipeline per strategy and miss shader.
+inline PipelineKey makeGenericPipelineKey(const int strategy, const int miss)
+{
+  PipelineKey key;
+
+  key.strategy   = strategy;
+  key.miss       = miss;
+  key.generic    = 1;
+  key.lensShader = 0;
+  key.maskBSDF   = 0;
+  key.maskLights = 0;
+  key.cutout     = 0;
+  key.aovMask    = 0;
+
+  return key;
+}
+
+// Start of a specialized key. The scene usage is accumulated with the addMaterial/addLight functions below.
+inline PipelineKey makeSpecializedPipelineKey(const int strategy, const int miss, const int lensShader, const unsigned int aovMask)
+{
+  PipelineKey key = makeGenericPipelineKey(strategy, miss);
+
+  key.generic    = 0;
+  key.lensShader = lensShader;
+  key.aovMask    = aovMask;
+
+  return key;
+}
+
+inline void addMaterialToPipelineKey(PipelineKey& key, const int indexBSDF, const bool cutout)
+{
+  if (0 <= indexBSDF && indexBSDF < NUM_BSDF_INDICES)
+  {
+    key.maskBSDF |= 1u << indexBSDF;
+  }
+  if (cutout)
+  {
+    key.cutout = 1;
+  }
+}
+
+inline void addLightToPipelineKey(PipelineKey& key, const int lightType)
+{
+  if (0 <= lightType && lightType < 32)
+  {
+    key.maskLights |= 1u << lightType;
+  }
+}
+
+// The specialized key of the current device settings, materials and lights.
+inline PipelineKey derivePipelineKey(const int strategy, const int miss, const int lensShader, const unsigned int aovMask,
+                                     std::vector<MaterialDefinition> const& materials, std::vector<int> const& lightTypes)
+{
+  PipelineKey key = makeSpecializedPipelineKey(strategy, miss, lensShader, aovMask);
+
+  for (MaterialDefinition const& material : materials)
+  {
+    addMaterialToPipelineKey(key, material.indexBSDF, material.textureCutout != 0);
+  }
+
+  for (const int lightType : lightTypes)
+  {
+    addLightToPipelineKey(key, lightType);
+  }
+
+  return key;
+}
+
+
+// Program group selection. The callable SBT indices stay fixed (see closesthit.cu),
+// only the program groups behind unused indices are not compiled into a specialized pipeline.
+inline bool usesLensShader(PipelineKey const& key, const int lensShader)
+{
+  return key.generic || key.lensShader == lensShader;
+}
+
+inline bool usesLightType(PipelineKey const& key, const int lightType)
+{
+  return key.generic || (key.maskLights & (1u << lightType)) != 0;
+}
+
+inline bool usesBSDF(PipelineKey const& key, const int indexBSDF)
+{
+  return key.generic || (key.maskBSDF & (1u << indexBSDF)) != 0;
+}
+
+inline bool usesCutout(PipelineKey const& key)
+{
+  return key.generic || key.cutout != 0;
+}
+
+
+// Returns true when a pipeline compiled for the "available" key renders the "required" settings correctly.
+// Bound values must match exactly, the available program groups must be a superset of the required ones.
+inline bool isPipelineCompatible(PipelineKey const& available, PipelineKey const& required)
+{
+  if (available.strategy != required.strategy || available.miss != required.miss)
+  {
+    return false;
+  }
+  if (available.generic)
+  {
+    return true;
+  }
+  if (required.generic)
+  {
+    return false;
+  }
+  return available.lensShader == required.lensShader &&
+         available.aovMask    == required.aovMask &&
+         (required.maskBSDF   & ~available.maskBSDF)   == 0 &&
+         (required.maskLights & ~available.maskLights) == 0 &&
+         (!required.cutout || available.cutout);
+}
+
+// The pipeline to render the required settings with right now: the exact one when it's cached,
+// else the active one when it's compatible, else the generic one. The caller compiles the required one when that differs.
+template <typename T>
+inline PipelineKey selectPipelineKey(std::map<PipelineKey, T> const& pipelines, PipelineKey const& active, PipelineKey const& required,
+                                     PipelineKey const& generic)
+{
+  if (pipelines.find(required) != pipelines.end())
+  {
+    return required;
+  }
+  if (isPipelineCompatible(active, required))
+  {
+    return active;
+  }
+  return generic;
+}
+
+// Returns true and the least recently used specialized pipeline when the cache holds more than capacity pipelines.
+// T::lastUse is the activation counter of the pipeline. Generic pipelines and the active one are never evicted.
+template <typename T>
+inline bool selectPipelineEviction(std::map<PipelineKey, T> const& pipelines, PipelineKey const& active, const size_t capacity,
+                                   PipelineKey& evict)
+{
+  if (pipelines.size() <= capacity)
+  {
+    return false;
+  }
+
+  bool found = false;
+
+  for (typename std::map<PipelineKey, T>::const_iterator it = pipelines.begin(); it != pipelines.end(); ++it)
+  {
+    if (it->first.generic || it->first == active)
+    {
+      continue;
+    }
+    if (!found || it->second.lastUse < pipelines.find(evict)->second.lastUse)
+    {
+      evict = it->first;
+      found = true;
+    }
+  }
+  return found;
+}
+
+#endif // PIPELINE_KEY_H
@@ -68,6 +68,9 @@ public:
 
   void setResolution(const int w, const int h);
   void setTonemapper(TonemapperGUI const& tm);
+  void setTimeView(const bool enable);
+
+  bool mapWindowToImage(const int x, const int y, float& u, float& v) const;
 
 private:
   void checkInfoLog(const char *msg, GLuint object);
@@ -90,6 +93,8 @@ private:
   GLubyte m_deviceLUID[GL_LUID_SIZE_EXT]; // 8 bytes identifier.
   GLint   m_nodeMask;                     // Node mask used together with the LUID to identify OpenGL device uniquely.
 
+  float m_blitRect[4]; // x0, y0, x1, y1 of the displayed image in window coordinates with origin at the bottom left.
+
   GLuint m_hdrTexture;
   GLuint m_pbo;
 
@@ -106,6 +111,7 @@ private:
 
   GLint m_locSamplerHDR;
   GLint m_locSamplerColorRamp;
+  GLint m_locTimeView;
 
   // Rasterizer side of the TonemapperGUI data
   GLint m_locInvGamma;
@@ -32,11 +32,13 @@
 #define RAYTRACER_H
 
 #include "inc/Device.h"
+#include "inc/HostBVH.h"
 #include "inc/MaterialGUI.h"
 #include "inc/Picture.h"
 #include "inc/SceneGraph.h"
 #include "inc/Texture.h"
 #include "inc/NVMLImpl.h"
+#include "inc/ParameterChannel.h"
 
 #include "shaders/system_data.h"
 
@@ -62,15 +64,30 @@ public:
   bool enablePeerAccess();   // Calculates peer-to-peer access bit matrix in m_peerConnections and the m_peerIslands. Returns false when more than one island is found!
   void disablePeerAccess();  // Clear the peer-to-peer islands. Afterwards each device is its own island.
   void synchronize();        // Needed for the benchmark to wait for all asynchronous rendering to have finished.
+  virtual void getTimeViewHost(std::vector<float>& cycles, std::vector<unsigned int>& ids); // Merged time view buffers of all active devices.
+  virtual void getAovHost(const int index, std::vector<unsigned char>& aov); // Merged AovIndex buffer of all active devices.
+  void getBufferCacheStatistics(std::vector<BufferCacheStatistics>& statistics) const; // One entry per active device.
+  void trimBufferCaches();
+
+  // Batched ray queries against the current scene. Results are closest hits unless QUERY_FLAG_ANY_HIT is set on a ray.
+  // Host arrays, streamed in chunks over all active devices. Without active devices the built host BVH answers the queries, without one all rays miss.
+  void traceRays(std::vector<QueryRay> const& rays, std::vector<QueryHit>& hits, HostBVH const* bvhHost = nullptr);
+  void traceRays(CUdeviceptr rays, CUdeviceptr hits, const unsigned int count, const int indexDevice = 0); // Device arrays on the given active device, asynchronous.
 
   virtual void initTextures(std::map<std::string, Picture*> const& mapOfPictures);
   virtual void initCameras(std::vector<CameraDefinition> const& cameras);
   virtual void initLights(std::vector<LightDefinition> const& lights);
   virtual void initMaterials(std::vector<MaterialGUI> const& materialsGUI);
   virtual void initScene(std::shared_ptr<sg::Group> root, const unsigned int numGeometries);
+  virtual void updateScene(std::shared_ptr<sg::Group> root, const unsigned int numGeometries, SceneDiff const& diff); // Incremental hot reload.
   virtual void initState(DeviceState const& state);
+  // Multi-view rendering. Replaces all cameras because each view references its own. Also used to update the view cameras.
+  virtual void initViews(std::vector<CameraDefinition> const& cameras, std::vector<ViewDefinition> const& views);
+  void setViewsSequential(const bool sequential); // One launch per view instead of a single launch for all views.
+  void setGraphs(const bool enable); // Replay each device's iteration as a captured CUDA graph.
 
   // Update functions should be replaced with NOP functions in a derived batch renderer because the device functions are fully asynchronous then.
+  // They only record the edits, the devices pick them up with the next render().
   virtual void updateCamera(const int idCamera, CameraDefinition const& camera);
   virtual void updateLight(const int idLight, LightDefinition const& light);
   virtual void updateMaterial(const int idMaterial, MaterialGUI const& src);
@@ -81,6 +98,10 @@ public:
   virtual void updateDisplayTexture() = 0;
   virtual const void* getOutputBufferHost() = 0;
 
+protected:
+  void applyParameters();       // Uploads the coalesced edits to all devices. Called at the begin of render() and before readbacks.
+  void acknowledgeParameters(); // Marks the sections uploaded by the init functions as known to all devices.
+
 private:
   bool activeNVLINK(const int home, const int peer) const;
   int findActiveDevice(const unsigned int domain, const unsigned int bus, const unsigned int device) const;
@@ -104,6 +125,8 @@ public:
   std::vector<unsigned int>       m_peerConnections; // Bitfield indicating peer-to-peer access between devices. Indexing is m_peerConnections[home] & (1 << peer)
   std::vector< std::vector<int> > m_islands;         // Vector with vector of device indices (not ordinals) building a peer-to-peer island.
 
+  ParameterChannel m_parameters; // GUI edits to the devices. Consumer index == device index.
+
   NVMLImpl m_nvml;
 };
 
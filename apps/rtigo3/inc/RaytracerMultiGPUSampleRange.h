@@ -0,0 +1,62 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+ 
+#ifndef RAYTRACER_MULTI_GPU_SAMPLE_RANGE_H
+#define RAYTRACER_MULTI_GPU_SAMPLE_RANGE_H
+
+#include "inc/Raytracer.h"
+
+#include "inc/DeviceMultiGPUSampleRange.h"
+
+class RaytracerMultiGPUSampleRange : public Raytracer
+{
+public:
+  RaytracerMultiGPUSampleRange(const int devicesMask,
+                               const int miss,
+                               const int interop,
+                               const unsigned int tex,
+                               const unsigned int pbo);
+
+  unsigned int render();
+  void updateDisplayTexture();
+  const void* getOutputBufferHost();
+
+  // Every device renders all pixels. The AOVs and the time view come from the first device which starts at sample 0.
+  void getTimeViewHost(std::vector<float>& cycles, std::vector<unsigned int>& ids);
+  void getAovHost(const int index, std::vector<unsigned char>& aov);
+
+private:
+  unsigned int getSampleCount() const; // Merged samples per pixel after m_iterationIndex launches.
+
+private:
+  std::vector<float4> m_bufferHost; // The merged image.
+};
+
+#endif // RAYTRACER_MULTI_GPU_SAMPLE_RANGE_H
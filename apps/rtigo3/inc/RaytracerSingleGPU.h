@@ -47,6 +47,13 @@ public:
   unsigned int render();
   void updateDisplayTexture();
   const void* getOutputBufferHost();
+
+protected:
+  // Derived single GPU strategies create their own device type.
+  RaytracerSingleGPU(RendererStrategy strategy,
+                     const int interop,
+                     const unsigned int tex,
+                     const unsigned int pbo);
 };
 
 #endif // RAYTRACER_SINGLE_GPU_H
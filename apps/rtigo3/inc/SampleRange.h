@@ -0,0 +1,60 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef SAMPLE_RANGE_H
+#define SAMPLE_RANGE_H
+
+#include <cuda_runtime.h> // float4
+
+#include <cstddef>
+#include <vector>
+
+// Host side helpers for the sample range partitioned multi-GPU strategy.
+// Each device renders the full frame for a disjoint range of global sample indices. The random number seeds only depend
+// on the pixel and the global sample index, so the merged result is independent of the number of devices.
+
+struct SampleRange
+{
+  unsigned int begin; // First global sample index.
+  unsigned int end;   // One past the last global sample index.
+};
+
+// Evenly splits the samples per pixel. The ranges of all count devices are disjoint and cover [0, samplesPerPixel).
+// The range of index 0 starts at sample 0 and is the biggest one.
+SampleRange getSampleRange(const unsigned int samplesPerPixel, const int count, const int index);
+
+// Number of samples accumulated in a device's buffer after iterationIndex launches.
+unsigned int getSampleCount(SampleRange const& range, const unsigned int iterationIndex);
+
+// dst[i] = sum(sources[d][i] * counts[d]) / sum(counts). The sources are the per device running averages.
+// Devices without samples are ignored. dst is cleared when there are no samples at all.
+void mergeSampleRanges(float4* dst, std::vector<const float4*> const& sources, std::vector<unsigned int> const& counts, const size_t numPixels);
+
+#endif // SAMPLE_RANGE_H
@@ -0,0 +1,93 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef SCENE_DIFF_H
+#define SCENE_DIFF_H
+
+#include <cuda_runtime.h>
+
+#include "inc/MaterialGUI.h"
+#include "inc/SceneGraph.h"
+
+#include "shaders/light_definition.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Host side comparison of two loaded scene states for the hot reload of the scene and system description files.
+// The result lists the minimal device updates.
+
+// One flattened geometry instance. The order matches Device::traverseNode(), so the index is the device instance ID.
+struct SceneInstance
+{
+  unsigned int idGeometry;
+  int          idMaterial;
+  int          idLight;
+  float        matrix[12]; // Concatenated object to world transformation.
+};
+
+struct SceneDescription
+{
+  std::vector<MaterialGUI>     materials;
+  std::vector<LightDefinition> lights;
+  std::vector<SceneInstance>   instances;
+};
+
+struct SceneDiff
+{
+  SceneDiff()
+  : materialsResized(false)
+  , lightsResized(false)
+  , instancesChanged(false)
+  {
+  }
+
+  bool                      materialsResized;  // The number of materials changed. Needs initMaterials().
+  std::vector<int>          materials;         // Otherwise the indices of the materials with changed parameters for updateMaterial().
+  bool                      lightsResized;     // The number of lights changed. Needs initLights().
+  std::vector<int>          lights;            // Otherwise the indices of the changed lights for updateLight().
+  bool                      instancesChanged;  // Instances were added, removed or got a different geometry, material or light. Needs a TLAS and SBT rebuild.
+  std::vector<unsigned int> instancesMoved;    // Otherwise the instance IDs with a changed transformation only. A TLAS refit is enough.
+  std::vector<unsigned int> geometriesAdded;   // Geometry IDs only referenced by the new scene. Need a GAS build.
+  std::vector<unsigned int> geometriesRemoved; // Geometry IDs only referenced by the old scene. Their GAS can be freed.
+};
+
+// Appends the leaf instances of the scene graph below root in device traversal order.
+void flattenScene(std::shared_ptr<sg::Node> root, std::vector<SceneInstance>& instances);
+
+SceneDiff diffScenes(SceneDescription const& before, SceneDescription const& after);
+
+bool isEmpty(SceneDiff const& diff);
+
+// One line summary for the console, e.g. "materials 2, lights 0, instances 1 moved, geometries +0 -0".
+std::string formatSceneDiff(SceneDiff const& diff);
+
+#endif // SCENE_DIFF_H
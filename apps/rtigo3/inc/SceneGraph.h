@@ -39,6 +39,7 @@
 #include "shaders/vector_math.h"
 
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace sg
@@ -73,7 +74,7 @@ namespace sg
   {
   public:
     Triangles(const unsigned int id);
-    //~Triangles();
+    ~Triangles(); // Deletes the host cache file.
 
     sg::NodeType getType() const;
 
@@ -84,14 +85,29 @@ namespace sg
     void createParallelogram(float3 const& position, float3 const& vecU, float3 const& vecV, float3 const& normal);
 
     void setAttributes(std::vector<TriangleAttributes> const& attributes);
+    void setAttributes(std::vector<TriangleAttributes>&& attributes); // Takes over the storage, no copy.
     std::vector<TriangleAttributes> const& getAttributes() const;
     
     void setIndices(std::vector<unsigned int> const&);
+    void setIndices(std::vector<unsigned int>&& indices);
     std::vector<unsigned int> const& getIndices() const;
 
+    // Host residency. The device uploads and the host BVH read the arrays above. Afterwards they are not needed anymore.
+    // releaseHost() writes the arrays to filenameCache once, then frees them. reloadHost() reads them back on demand.
+    // Returns false when the cache file can't be written or read. The geometry stays resident then.
+    bool releaseHost(std::string const& filenameCache);
+    bool reloadHost();
+    bool isHostResident() const;
+    size_t getHostSizeInBytes() const; // Size of the arrays, also while released.
+
   private:
     std::vector<TriangleAttributes> m_attributes;
     std::vector<unsigned int>       m_indices; // If m_indices.size() == 0, m_attributes are independent primitives.
+
+    bool        m_isHostResident;
+    size_t      m_numAttributes;  // Array sizes while released.
+    size_t      m_numIndices;
+    std::string m_filenameCache;  // Empty until the first releaseHost(). The set*() functions invalidate it.
   };
 
 
@@ -0,0 +1,154 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef SCENE_INTERPRETER_H
+#define SCENE_INTERPRETER_H
+
+#include <cuda_runtime.h>
+
+#include "inc/SceneGraph.h"
+
+#include <dp/math/Matmnt.h>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+enum KeywordScene
+{
+  KS_ALBEDO,
+  KS_ROUGHNESS,
+  KS_ABSORPTION,
+  KS_ABSORPTION_SCALE,
+  KS_IOR,
+  KS_THINWALLED,
+  KS_MATERIAL,
+  KS_IDENTITY,
+  KS_PUSH,
+  KS_POP,
+  KS_ROTATE,
+  KS_SCALE,
+  KS_TRANSLATE,
+  KS_MODEL
+};
+
+enum SceneModelType
+{
+  SMT_PLANE,
+  SMT_BOX,
+  SMT_SPHERE,
+  SMT_TORUS,
+  SMT_ASSIMP,
+  SMT_GLTF,
+  SMT_UNKNOWN // Ignored, like unknown model keywords always were.
+};
+
+// One statement of the scene description with its arguments, as read by the lexer.
+struct SceneCommand
+{
+  KeywordScene   keyword;
+  SceneModelType model;     // KS_MODEL only.
+  float          values[4]; // Vector and scalar arguments. KS_ROTATE: axis and angle in degrees.
+  unsigned int   tess[3];   // KS_MODEL: tessU, tessV and the plane's upAxis.
+  std::string    reference; // KS_MATERIAL and KS_MODEL: material reference name.
+  std::string    name;      // KS_MATERIAL: BSDF name. KS_MODEL assimp and gltf: filename.
+};
+
+// Material definition with the material parameters current at its position in the scene description.
+struct SceneMaterial
+{
+  std::string reference;
+  std::string name;
+  float3      albedo;
+  float2      roughness;
+  float3      absorptionColor;
+  float       absorptionScale;
+  float       ior;
+  bool        thinwalled;
+};
+
+// Model statement with the transformation current at its position in the scene description.
+struct SceneModel
+{
+  SceneModelType   type;
+  unsigned int     tess[3];
+  float            params[2];    // Sphere: theta. Torus: inner and outer radius.
+  std::string      reference;    // Material reference name.
+  std::string      filename;     // assimp and gltf models.
+  size_t           numMaterials; // Number of materials defined before this model.
+  dp::math::Mat44f matrix;       // Object to world.
+};
+
+// The host scene the interpreter appends to and the loaders for the parts which must run in scene description order.
+// The ID counters and maps are shared with the callbacks, which append their own nodes.
+struct SceneTarget
+{
+  std::shared_ptr<sg::Group>                     scene;
+  std::vector< std::shared_ptr<sg::Triangles> >* geometries;
+  std::map<std::string, unsigned int>*           mapGeometries;
+  std::map<std::string, int> const*              mapMaterialReferences; // Updated by createMaterial.
+  unsigned int*                                  idGeometry;
+  unsigned int*                                  idInstance;
+
+  std::function<void(SceneMaterial const&)>                     createMaterial;
+  std::function<std::shared_ptr<sg::Group>(SceneModel const&)> createModel; // assimp and gltf models.
+};
+
+
+// Staged interpreter of the scene description files.
+// lex() tokenizes the file into a command stream. resolve() runs the matrix stack and the material parameter state over it
+// and leaves the materials and models with their final parameters. expand() appends them to the scene.
+// Only the ID assignment in expand() is sequential. The runtime generated geometries and the instances are built by worker threads
+// afterwards, so the resulting scene graph is identical for any number of threads.
+class SceneInterpreter
+{
+public:
+  SceneInterpreter();
+
+  bool lex(std::string const& filename);
+  void resolve();
+  bool expand(SceneTarget& target, const unsigned int numThreads);
+
+  std::vector<SceneCommand> const&  getCommands() const;
+  std::vector<SceneMaterial> const& getMaterials() const;
+  std::vector<SceneModel> const&    getModels() const;
+
+private:
+  std::map<std::string, KeywordScene> m_mapKeywordScene;
+
+  std::vector<SceneCommand>  m_commands;
+  std::vector<SceneMaterial> m_materials;
+  std::vector<SceneModel>    m_models;
+};
+
+#endif // SCENE_INTERPRETER_H
@@ -36,79 +36,11 @@
 #include <cuda_runtime.h>
 
 #include "inc/Picture.h"
+#include "inc/TextureConversion.h"
 
 #include <string>
 #include <vector>
 
-// Bitfield encoding of the texture channels.
-// These are used to remap user format and user data to the internal format.
-// Each four bits hold the channel index of red, green, blue, alpha, and luminance. 
-// (encoding >> ENC_*_SHIFT) & ENC_MASK gives the channel index if the result is less than 4.
-// That encoding allows to automatically swap red and blue, map luminance to RGB (not the other way round though!),
-// fill in alpha with input data or force it to one if required.
-// 49 remapper functions take care to convert the data types including fixed-point adjustments.
-
-#define ENC_MASK    0xF
-
-#define ENC_RED_SHIFT   0
-#define ENC_RED_0       ( 0u << ENC_RED_SHIFT)
-#define ENC_RED_1       ( 1u << ENC_RED_SHIFT)
-#define ENC_RED_2       ( 2u << ENC_RED_SHIFT)
-#define ENC_RED_3       ( 3u << ENC_RED_SHIFT)
-#define ENC_RED_NONE    (15u << ENC_RED_SHIFT)
-
-#define ENC_GREEN_SHIFT 4
-#define ENC_GREEN_0     ( 0u << ENC_GREEN_SHIFT)
-#define ENC_GREEN_1     ( 1u << ENC_GREEN_SHIFT)
-#define ENC_GREEN_2     ( 2u << ENC_GREEN_SHIFT)
-#define ENC_GREEN_3     ( 3u << ENC_GREEN_SHIFT)
-#define ENC_GREEN_NONE  (15u << ENC_GREEN_SHIFT)
-
-#define ENC_BLUE_SHIFT  8
-#define ENC_BLUE_0      ( 0u << ENC_BLUE_SHIFT)
-#define ENC_BLUE_1      ( 1u << ENC_BLUE_SHIFT)
-#define ENC_BLUE_2      ( 2u << ENC_BLUE_SHIFT)
-#define ENC_BLUE_3      ( 3u << ENC_BLUE_SHIFT)
-#define ENC_BLUE_NONE   (15u << ENC_BLUE_SHIFT)
-
-#define ENC_ALPHA_SHIFT 12
-#define ENC_ALPHA_0     ( 0u << ENC_ALPHA_SHIFT)
-#define ENC_ALPHA_1     ( 1u << ENC_ALPHA_SHIFT)
-#define ENC_ALPHA_2     ( 2u << ENC_ALPHA_SHIFT)
-#define ENC_ALPHA_3     ( 3u << ENC_ALPHA_SHIFT)
-#define ENC_ALPHA_NONE  (15u << ENC_ALPHA_SHIFT)
-
-#define ENC_LUM_SHIFT   16
-#define ENC_LUM_0       ( 0u << ENC_LUM_SHIFT)
-#define ENC_LUM_1       ( 1u << ENC_LUM_SHIFT)
-#define ENC_LUM_2       ( 2u << ENC_LUM_SHIFT)
-#define ENC_LUM_3       ( 3u << ENC_LUM_SHIFT)
-#define ENC_LUM_NONE    (15u << ENC_LUM_SHIFT)
-
-#define ENC_CHANNELS_SHIFT 20
-#define ENC_CHANNELS_1     (1u << ENC_CHANNELS_SHIFT)
-#define ENC_CHANNELS_2     (2u << ENC_CHANNELS_SHIFT)
-#define ENC_CHANNELS_3     (3u << ENC_CHANNELS_SHIFT)
-#define ENC_CHANNELS_4     (4u << ENC_CHANNELS_SHIFT)
-
-#define ENC_TYPE_SHIFT          24
-// These are indices into the remapper table.
-#define ENC_TYPE_CHAR           ( 0u << ENC_TYPE_SHIFT)
-#define ENC_TYPE_UNSIGNED_CHAR  ( 1u << ENC_TYPE_SHIFT)
-#define ENC_TYPE_SHORT          ( 2u << ENC_TYPE_SHIFT)
-#define ENC_TYPE_UNSIGNED_SHORT ( 3u << ENC_TYPE_SHIFT)
-#define ENC_TYPE_INT            ( 4u << ENC_TYPE_SHIFT)
-#define ENC_TYPE_UNSIGNED_INT   ( 5u << ENC_TYPE_SHIFT)
-#define ENC_TYPE_FLOAT          ( 6u << ENC_TYPE_SHIFT)
-#define ENC_TYPE_UNDEFINED      (15u << ENC_TYPE_SHIFT)
-
-// Flags to indicate that special handling is required.
-#define ENC_MISC_SHIFT  28
-#define ENC_FIXED_POINT (1u << ENC_MISC_SHIFT)
-#define ENC_ALPHA_ONE   (2u << ENC_MISC_SHIFT)
-// Highest bit set means invalid encoding.
-#define ENC_INVALID     (8u << ENC_MISC_SHIFT)
-
 
 class Texture
 {
@@ -126,6 +58,7 @@ public:
   void setNormalizedCoords(bool normalized);
   void setMaxAnisotropy(unsigned int aniso);
   void setMipmapLevelBiasMinMax(float bias, float minimum, float maximum);
+  void setEnvFormat(const int format); // EnvFormat of the spherical environment texture. Only used with IMAGE_FLAG_ENV.
  
   bool create(const Picture* picture, const unsigned int flags);
   bool update(const Picture* picture);
@@ -158,6 +91,8 @@ private:
   bool updateCube(const Picture* picture);
   bool updateEnv(const Picture* picture);
 
+  const void* convertEnv(const float* rgba, const size_t count, std::vector<unsigned int>& buffer) const;
+
 private:
   unsigned int m_width;
   unsigned int m_height;
@@ -183,6 +118,7 @@ private:
   CUdeviceptr m_d_envCDF_U;
   CUdeviceptr m_d_envCDF_V;
   float       m_integral;
+  int         m_envFormat;
 };
 
 #endif // TEXTURE_H
@@ -0,0 +1,121 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef TEXTURE_CONVERSION_H
+#define TEXTURE_CONVERSION_H
+
+#include <cstddef>
+#include <vector>
+
+// Bitfield encoding of the texture channels.
+// These are used to remap user format and user data to the internal format.
+// Each four bits hold the channel index of red, green, blue, alpha, and luminance. 
+// (encoding >> ENC_*_SHIFT) & ENC_MASK gives the channel index if the result is less than 4.
+// That encoding allows to automatically swap red and blue, map luminance to RGB (not the other way round though!),
+// fill in alpha with input data or force it to one if required.
+// 49 remapper functions take care to convert the data types including fixed-point adjustments.
+
+#define ENC_MASK    0xF
+
+#define ENC_RED_SHIFT   0
+#define ENC_RED_0       ( 0u << ENC_RED_SHIFT)
+#define ENC_RED_1       ( 1u << ENC_RED_SHIFT)
+#define ENC_RED_2       ( 2u << ENC_RED_SHIFT)
+#define ENC_RED_3       ( 3u << ENC_RED_SHIFT)
+#define ENC_RED_NONE    (15u << ENC_RED_SHIFT)
+
+#define ENC_GREEN_SHIFT 4
+#define ENC_GREEN_0     ( 0u << ENC_GREEN_SHIFT)
+#define ENC_GREEN_1     ( 1u << ENC_GREEN_SHIFT)
+#define ENC_GREEN_2     ( 2u << ENC_GREEN_SHIFT)
+#define ENC_GREEN_3     ( 3u << ENC_GREEN_SHIFT)
+#define ENC_GREEN_NONE  (15u << ENC_GREEN_SHIFT)
+
+#define ENC_BLUE_SHIFT  8
+#define ENC_BLUE_0      ( 0u << ENC_BLUE_SHIFT)
+#define ENC_BLUE_1      ( 1u << ENC_BLUE_SHIFT)
+#define ENC_BLUE_2      ( 2u << ENC_BLUE_SHIFT)
+#define ENC_BLUE_3      ( 3u << ENC_BLUE_SHIFT)
+#define ENC_BLUE_NONE   (15u << ENC_BLUE_SHIFT)
+
+#define ENC_ALPHA_SHIFT 12
+#define ENC_ALPHA_0     ( 0u << ENC_ALPHA_SHIFT)
+#define ENC_ALPHA_1     ( 1u << ENC_ALPHA_SHIFT)
+#define ENC_ALPHA_2     ( 2u << ENC_ALPHA_SHIFT)
+#define ENC_ALPHA_3     ( 3u << ENC_ALPHA_SHIFT)
+#define ENC_ALPHA_NONE  (15u << ENC_ALPHA_SHIFT)
+
+#define ENC_LUM_SHIFT   16
+#define ENC_LUM_0       ( 0u << ENC_LUM_SHIFT)
+#define ENC_LUM_1       ( 1u << ENC_LUM_SHIFT)
+#define ENC_LUM_2       ( 2u << ENC_LUM_SHIFT)
+#define ENC_LUM_3       ( 3u << ENC_LUM_SHIFT)
+#define ENC_LUM_NONE    (15u << ENC_LUM_SHIFT)
+
+#define ENC_CHANNELS_SHIFT 20
+#define ENC_CHANNELS_1     (1u << ENC_CHANNELS_SHIFT)
+#define ENC_CHANNELS_2     (2u << ENC_CHANNELS_SHIFT)
+#define ENC_CHANNELS_3     (3u << ENC_CHANNELS_SHIFT)
+#define ENC_CHANNELS_4     (4u << ENC_CHANNELS_SHIFT)
+
+#define ENC_TYPE_SHIFT          24
+// These are indices into the remapper table.
+#define ENC_TYPE_CHAR           ( 0u << ENC_TYPE_SHIFT)
+#define ENC_TYPE_UNSIGNED_CHAR  ( 1u << ENC_TYPE_SHIFT)
+#define ENC_TYPE_SHORT          ( 2u << ENC_TYPE_SHIFT)
+#define ENC_TYPE_UNSIGNED_SHORT ( 3u << ENC_TYPE_SHIFT)
+#define ENC_TYPE_INT            ( 4u << ENC_TYPE_SHIFT)
+#define ENC_TYPE_UNSIGNED_INT   ( 5u << ENC_TYPE_SHIFT)
+#define ENC_TYPE_FLOAT          ( 6u << ENC_TYPE_SHIFT)
+#define ENC_TYPE_UNDEFINED      (15u << ENC_TYPE_SHIFT)
+
+// Flags to indicate that special handling is required.
+#define ENC_MISC_SHIFT  28
+#define ENC_FIXED_POINT (1u << ENC_MISC_SHIFT)
+#define ENC_ALPHA_ONE   (2u << ENC_MISC_SHIFT)
+// Highest bit set means invalid encoding.
+#define ENC_INVALID     (8u << ENC_MISC_SHIFT)
+
+
+// Host side texel conversions and environment CDF generation used by the Texture class.
+// These don't touch the CUDA driver, so the host benchmarks can run them without a device.
+
+// Bytes per texel of the given encoding.
+unsigned int getElementSize(const unsigned int deviceEncoding);
+
+// Converts elements texels of any loaded image into a texture format supported by CUDA (1, 2, 4 channels only).
+void convertTexels(void* dst, unsigned int deviceEncoding, const void* src, unsigned int hostEncoding, size_t elements);
+
+// Builds the normalized row CDFs ((width + 1) * height) and the marginal CDF (height + 1) for the importance sampling
+// of a spherical RGBA32F environment. Returns the integral over the sphere used in the light sampling.
+float calculateSphericalCDF(const float* rgba, const unsigned int width, const unsigned int height,
+                            std::vector<float>& cdfU, std::vector<float>& cdfV);
+
+#endif // TEXTURE_CONVERSION_H
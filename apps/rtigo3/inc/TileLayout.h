@@ -0,0 +1,50 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef TILE_LAYOUT_HOST_H
+#define TILE_LAYOUT_HOST_H
+
+#include <cuda_runtime.h> // float4, int2
+
+#include <cstddef>
+
+// Host side conversions between the linear and the tile ordered accumulation layout of shaders/tile_layout.h.
+// tileSize must be power-of-two values. The linear buffers have resolution.x * resolution.y pixels.
+
+// Number of float4 elements of a tile ordered buffer covering the resolution, including the padding of the partial edge tiles.
+size_t getTiledBufferSize(const int2 resolution, const int2 tileSize);
+
+// Copies the tile ordered src into the linear dst. The padding pixels are skipped.
+void detileHost(float4* dst, const float4* src, const int2 resolution, const int2 tileSize);
+
+// Copies the linear src into the tile ordered dst. The padding pixels of dst are not written.
+void retileHost(float4* dst, const float4* src, const int2 resolution, const int2 tileSize);
+
+#endif // TILE_LAYOUT_HOST_H
@@ -0,0 +1,87 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef TIME_VIEW_H
+#define TIME_VIEW_H
+
+#include <string>
+#include <vector>
+
+// Host side aggregation of the per pixel clock cycles measured by the ray generation programs when the time view is enabled.
+
+struct TimeViewTile
+{
+  int    x;      // Tile coordinates in tiles, not pixels.
+  int    y;
+  double cycles; // Average cycles per pixel inside this tile.
+};
+
+struct TimeViewGroup
+{
+  int          id;     // Material index or instance ID. -1 collects all primary ray misses.
+  unsigned int pixels; // Number of pixels whose primary hit was this material or instance.
+  double       cycles; // Average cycles per pixel of this group.
+};
+
+struct TimeViewReport
+{
+  int    width;
+  int    height;
+  int    tileWidth;
+  int    tileHeight;
+  double minimum;  // Per pixel cycles.
+  double maximum;
+  double average;
+  double binWidth; // The histogram bins are linear over [minimum, maximum].
+
+  std::vector<unsigned int>  histogram;
+  std::vector<TimeViewTile>  tiles;     // The most expensive tiles, sorted by descending average cycles.
+  std::vector<TimeViewGroup> materials; // Sorted by descending average cycles.
+  std::vector<TimeViewGroup> instances; // Sorted by descending average cycles.
+};
+
+// Adds the resolution sized time view buffers of one device to the accumulated host buffers.
+// Devices only write the pixels they rendered and leave the others zero, so summing merges all multi-GPU strategies.
+void accumulateTimeView(std::vector<float>& cycles, std::vector<unsigned int>& ids,
+                        std::vector<float> const& cyclesDevice, std::vector<unsigned int> const& idsDevice);
+
+// cycles holds width * height entries. ids is optional (empty) and holds two entries per pixel: instance ID + 1, material index + 1. Zero means miss.
+// Returns false for inconsistent input sizes.
+bool analyzeTimeView(std::vector<float> const& cycles, std::vector<unsigned int> const& ids,
+                     const int width, const int height,
+                     const int tileWidth, const int tileHeight,
+                     const int numBins, const int numTiles,
+                     TimeViewReport& report);
+
+// Writes the summary, histogram, top tiles, per material and per instance sections as comma separated values.
+// materialNames is optional and used for the material column when the index is inside its range. Names are quoted per RFC 4180 when needed.
+std::string formatTimeViewCSV(TimeViewReport const& report, std::vector<std::string> const& materialNames);
+
+#endif // TIME_VIEW_H
@@ -0,0 +1,63 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef VIEW_LAYOUT_H
+#define VIEW_LAYOUT_H
+
+#include <cuda_runtime.h>
+
+#include "shaders/camera_definition.h"
+
+#include <vector>
+
+// Multi-view layouts tiling the output buffer. All views are rendered with a single launch.
+enum ViewLayout
+{
+  VIEW_LAYOUT_SINGLE, // The interactive camera covers the whole resolution. No views.
+  VIEW_LAYOUT_STEREO, // Left and right eye side by side.
+  VIEW_LAYOUT_CUBE,   // Six 90 degrees faces (+x, -x, +y, -y, +z, -z) from the camera position in a 3x2 atlas. Meant for the pinhole lens shader.
+  VIEW_LAYOUT_GRID,   // Thumbnail sheet of grid.x * grid.y views orbiting the center of interest.
+
+  VIEW_LAYOUT_COUNT
+};
+
+// Splits the resolution into view rectangles and derives one camera per view from the interactive camera.
+// cameras[0] is the interactive camera itself, the views reference the cameras 1 to N.
+// The views cover the whole resolution. Their sizes differ by a pixel when the resolution isn't evenly divisible.
+// Too small resolutions result in no views.
+void createViewLayout(const int layout,
+                      const int2 grid,
+                      const int2 resolution,
+                      CameraDefinition const& camera,
+                      const float3 center,
+                      std::vector<CameraDefinition>& cameras,
+                      std::vector<ViewDefinition>& views);
+
+#endif // VIEW_LAYOUT_H
@@ -0,0 +1,48 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef WAVEFRONT_QUEUE_HOST_H
+#define WAVEFRONT_QUEUE_HOST_H
+
+#include "shaders/wavefront_queue.h"
+
+// Host implementation of the wavefront hit compaction and sort by shading key.
+// Runs the same functions of shaders/wavefront_queue.h as the wavefront_histogram, wavefront_offsets and wavefront_scatter kernels,
+// with all count ray queue slots in a single block. That makes the result stable. Used to validate the device queues.
+
+// keys contains one shading key per ray queue slot, WAVEFRONT_KEY_NONE for ended paths. The histogram and cursors of counters must be zero.
+// Writes the slots with a key into sortedQueue, grouped by ascending key, and returns the number of hits.
+unsigned int sortWavefrontQueue(const unsigned int* keys, const unsigned int count, WavefrontCounters& counters, unsigned int* sortedQueue);
+
+// True when sortedQueue contains each slot with a key exactly once and inside the range of its key.
+// The order inside a range depends on the device atomics and is not compared.
+bool isSortedWavefrontQueue(const unsigned int* keys, const unsigned int count, const unsigned int* sortedQueue, const unsigned int numHits);
+
+#endif // WAVEFRONT_QUEUE_HOST_H
@@ -0,0 +1,107 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef ADAPTIVE_ROULETTE_H
+#define ADAPTIVE_ROULETTE_H
+
+#include "config.h"
+#include "vector_math.h"
+
+// Adaptive Russian roulette and splitting for the ray generation program. The host turns the gathered statistics into the cache.
+// The expected radiance of the path continuation is learned per image tile and path depth. Paths whose expected contribution
+// falls below a weight window around the tile's pixel estimate are terminated with Russian roulette, paths above it are split.
+// "Adjoint-Driven Russian Roulette and Splitting in Light Transport Simulation" - Vorba and Krivanek. SIGGRAPH 2016
+
+// The cache has one entry per ROULETTE_TILE_SIZE squared pixels and path depth.
+#define ROULETTE_TILE_SHIFT 5
+#define ROULETTE_TILE_SIZE  (1 << ROULETTE_TILE_SHIFT)
+// Number of path depths with their own cache entry. Deeper paths use the last one.
+#define ROULETTE_DEPTHS 8
+
+// Ratio between the upper and the lower bound of the weight window.
+#define ROULETTE_WINDOW 5.0f
+// Limits of the factors returned by rouletteFactor().
+#define ROULETTE_MIN_SURVIVAL 0.05f
+#define ROULETTE_MAX_SPLIT    4.0f
+// Minimum number of recorded samples before a cache entry is used. Invalid entries fall back to the fixed pathLengths rule.
+#define ROULETTE_MIN_SAMPLES 16.0f
+
+
+// Number of tiles in x and y direction covering the resolution.
+__forceinline__ __host__ __device__ int2 rouletteTiles(const int2 resolution)
+{
+  return make_int2((resolution.x + ROULETTE_TILE_SIZE - 1) >> ROULETTE_TILE_SHIFT,
+                   (resolution.y + ROULETTE_TILE_SIZE - 1) >> ROULETTE_TILE_SHIFT);
+}
+
+// Cache index of the first depth of the tile containing the pixel.
+__forceinline__ __host__ __device__ int rouletteIndex(const int2 tiles, const unsigned int x, const unsigned int y)
+{
+  return ((y >> ROULETTE_TILE_SHIFT) * tiles.x + (x >> ROULETTE_TILE_SHIFT)) * ROULETTE_DEPTHS;
+}
+
+// Survival probability (< 1.0f), split factor (> 1.0f) or 1.0f when the path continues unchanged.
+// expected is the throughput luminance times the cached radiance of the continuation, reference the tile's pixel estimate.
+// Both must be valid, reference > 0.0f. The window [lower, upper] has its center at the reference, so the results
+// move the path weight back to the reference, which is the constant-weight efficiency optimum for the pixel estimate.
+__forceinline__ __host__ __device__ float rouletteFactor(const float expected, const float reference)
+{
+  const float ratio = expected / reference;
+  const float lower = 2.0f / (1.0f + ROULETTE_WINDOW);
+  const float upper = ROULETTE_WINDOW * lower;
+
+  if (ratio < lower)
+  {
+    return fmaxf(ratio, ROULETTE_MIN_SURVIVAL);
+  }
+  if (upper < ratio)
+  {
+    return fminf(ratio, ROULETTE_MAX_SPLIT);
+  }
+  return 1.0f;
+}
+
+// Integer number of branches with the expectation factor, for factor >= 1.0f. u is a uniform random number in [0, 1).
+// Each branch needs the weight 1.0f / factor to keep the estimate unbiased.
+__forceinline__ __host__ __device__ int rouletteBranches(const float factor, const float u)
+{
+  const float n = floorf(factor);
+
+  return int(n) + ((u < factor - n) ? 1 : 0);
+}
+
+// Cache entry from the accumulated statistics. .x = sum of the continuation radiance over the throughput, .y = number of samples.
+// Returns -1.0f while there are not enough samples.
+__forceinline__ __host__ __device__ float rouletteCacheEntry(float2 const& stats)
+{
+  return (ROULETTE_MIN_SAMPLES <= stats.y) ? stats.x / stats.y : -1.0f;
+}
+
+#endif // ADAPTIVE_ROULETTE_H
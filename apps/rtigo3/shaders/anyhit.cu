@@ -37,11 +37,32 @@
 #include "material_definition.h"
 #include "shader_common.h"
 #include "random_number_generators.h"
+#include "ray_cone.h"
 
 
 extern "C" __constant__ SystemData sysData;
 
 
+// Mipmap level of the cutout opacity texture at the current intersection, with the cone width at the intersection distance.
+__forceinline__ __device__ float getCutoutMipLevel(MaterialDefinition const& material, PerRayData const* thePrd,
+                                                   TriangleAttributes const& attr0, TriangleAttributes const& attr1, TriangleAttributes const& attr2)
+{
+  const float4* mW = optixGetInstanceTransformFromHandle(optixGetTransformListHandle(0)); // Object to world 3x4 matrix.
+
+  const float3 v1 = attr1.vertex - attr0.vertex;
+  const float3 v2 = attr2.vertex - attr0.vertex;
+
+  // Matrix3x4 * vector.
+  const float3 e1 = make_float3(dot(make_float3(mW[0]), v1), dot(make_float3(mW[1]), v1), dot(make_float3(mW[2]), v1));
+  const float3 e2 = make_float3(dot(make_float3(mW[0]), v2), dot(make_float3(mW[1]), v2), dot(make_float3(mW[2]), v2));
+
+  const float lod = rayConeLod(e1, e2, make_float2(attr1.texcoord - attr0.texcoord), make_float2(attr2.texcoord - attr0.texcoord),
+                               optixGetWorldRayDirection(), rayConeWidth(thePrd->cone, optixGetRayTmax()));
+
+  return rayConeMipLevel(lod, material.textureLod.y);
+}
+
+
 // One anyhit program for the radiance ray for all materials with cutout opacity!
 extern "C" __global__ void __anyhit__radiance_cutout()
 {
@@ -63,14 +84,18 @@ extern "C" __global__ void __anyhit__radiance_cutout()
 
     const float  alpha = 1.0f - theBarycentrics.x - theBarycentrics.y;
 
-    const float3 texcoord = attributes[tri.x].texcoord * alpha +
-                            attributes[tri.y].texcoord * theBarycentrics.x +
-                            attributes[tri.z].texcoord * theBarycentrics.y;
+    TriangleAttributes const& attr0 = attributes[tri.x];
+    TriangleAttributes const& attr1 = attributes[tri.y];
+    TriangleAttributes const& attr2 = attributes[tri.z];
 
-    const float opacity = intensity(make_float3(tex2D<float4>(material.textureCutout, texcoord.x, texcoord.y)));
+    const float3 texcoord = attr0.texcoord * alpha +
+                            attr1.texcoord * theBarycentrics.x +
+                            attr2.texcoord * theBarycentrics.y;
 
     PerRayData* thePrd = mergePointer(optixGetPayload_0(), optixGetPayload_1());
 
+    const float opacity = intensity(make_float3(tex2DLod<float4>(material.textureCutout, texcoord.x, texcoord.y, getCutoutMipLevel(material, thePrd, attr0, attr1, attr2))));
+
     // Stochastic alpha test to get an alpha blend effect.
     if (opacity < 1.0f && opacity <= rng(thePrd->seed)) // No need to calculate an expensive random number if the test is going to fail anyway.
     {
@@ -97,6 +122,8 @@ extern "C" __global__ void __anyhit__shadow_cutout()
 
   MaterialDefinition const& material = sysData.materialDefinitions[theData->materialIndex];
 
+  PerRayData* thePrd = mergePointer(optixGetPayload_0(), optixGetPayload_1());
+
   float opacity = 1.0f;
 
   if (material.textureCutout != 0)
@@ -110,14 +137,16 @@ extern "C" __global__ void __anyhit__shadow_cutout()
     const float2 theBarycentrics = optixGetTriangleBarycentrics(); // beta and gamma
     const float  alpha = 1.0f - theBarycentrics.x - theBarycentrics.y;
 
-    const float3 texcoord = attributes[tri.x].texcoord * alpha +
-                            attributes[tri.y].texcoord * theBarycentrics.x +
-                            attributes[tri.z].texcoord * theBarycentrics.y;
+    TriangleAttributes const& attr0 = attributes[tri.x];
+    TriangleAttributes const& attr1 = attributes[tri.y];
+    TriangleAttributes const& attr2 = attributes[tri.z];
 
-    opacity = intensity(make_float3(tex2D<float4>(material.textureCutout, texcoord.x, texcoord.y)));
-  }
+    const float3 texcoord = attr0.texcoord * alpha +
+                            attr1.texcoord * theBarycentrics.x +
+                            attr2.texcoord * theBarycentrics.y;
 
-  PerRayData* thePrd = mergePointer(optixGetPayload_0(), optixGetPayload_1());
+    opacity = intensity(make_float3(tex2DLod<float4>(material.textureCutout, texcoord.x, texcoord.y, getCutoutMipLevel(material, thePrd, attr0, attr1, attr2))));
+  }
 
   // Stochastic alpha test to get an alpha blend effect.
   if (opacity < 1.0f && opacity <= rng(thePrd->seed)) // No need to calculate an expensive random number if the test is going to fail anyway.
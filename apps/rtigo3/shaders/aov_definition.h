@@ -0,0 +1,62 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef AOV_DEFINITION_H
+#define AOV_DEFINITION_H
+
+// Arbitrary output variables (AOVs) written by the path tracer launch next to the beauty output.
+// Each AOV is enabled individually by its bit in SystemData::aovMask. Specialized pipelines bind the mask,
+// so the code of disabled AOVs is eliminated at compile time.
+// All AOV buffers are resolution sized. Pixels not rendered by a device stay zero on that device.
+enum AovIndex
+{
+  AOV_INDEX_DEPTH     = 0, // float,  distance along the primary ray to the first hit. 0.0f on miss. Not accumulated, first sample only.
+  AOV_INDEX_NORMAL    = 1, // half4,  world space shading normal of the first hit, facing the viewer. Accumulated.
+  AOV_INDEX_ALBEDO    = 2, // half4,  albedo including the albedo texture of the first hit. Accumulated.
+  AOV_INDEX_INSTANCE  = 3, // uint32, instance ID + 1 of the first hit, 0 on miss. First sample only.
+  AOV_INDEX_MATERIAL  = 4, // uint32, material index + 1 of the first hit, 0 on miss. First sample only.
+  AOV_INDEX_PRIMITIVE = 5, // uint32, triangle index + 1 of the first hit, 0 on miss. First sample only.
+  AOV_INDEX_DIRECT    = 6, // float4, radiance gathered at the first hit (emission and next event estimation). Accumulated.
+                           //         Stays fp32 because fp16 running averages stall after about thousand samples. Indirect is beauty - direct.
+  NUM_AOVS            = 7
+};
+
+#define AOV_DEPTH     (1u << AOV_INDEX_DEPTH)
+#define AOV_NORMAL    (1u << AOV_INDEX_NORMAL)
+#define AOV_ALBEDO    (1u << AOV_INDEX_ALBEDO)
+#define AOV_INSTANCE  (1u << AOV_INDEX_INSTANCE)
+#define AOV_MATERIAL  (1u << AOV_INDEX_MATERIAL)
+#define AOV_PRIMITIVE (1u << AOV_INDEX_PRIMITIVE)
+#define AOV_DIRECT    (1u << AOV_INDEX_DIRECT)
+
+// Any AOV which needs the primary hit information from the closesthit program.
+#define AOV_MASK_PRIMARY_HIT (AOV_DEPTH | AOV_NORMAL | AOV_ALBEDO | AOV_INSTANCE | AOV_MATERIAL | AOV_PRIMITIVE)
+
+#endif // AOV_DEFINITION_H
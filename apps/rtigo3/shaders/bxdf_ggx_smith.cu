@@ -34,9 +34,7 @@
 #include "material_definition.h"
 #include "shader_common.h"
 #include "random_number_generators.h"
-
-// "Microfacet Models for Refraction through Rough Surfaces" - Walter, Marschner, Li, Torrance. 2007
-// "Understanding the Masking-Shadowing Function in Microfacet-Based BRDFs" - Eric Heitz
+#include "microfacet.h"
 
 // This function evaluates a Fresnel dielectric function when the transmitting cosine ("cost")
 // is unknown and the incident index of refraction is assumed to be 1.0f.
@@ -70,114 +68,30 @@ __forceinline__ __device__ float evaluateFresnelDielectric(const float et, const
 }
 
 
-// Optimized version to calculate D and PDF reusing shared calculations.
-__forceinline__ __device__ float2 distribution_d_pdf(const float ax, const float ay, float3 const& wm)
-{
-  if (DENOMINATOR_EPSILON < wm.z) // Heaviside function: X_plus(wm * wg). (wm is in tangent space.)
-  {
-    const float cosThetaSqr = wm.z * wm.z;
-    const float tanThetaSqr = (1.0f - cosThetaSqr) / cosThetaSqr;
-
-    const float phiM    = atan2f(wm.y, wm.x);
-    const float cosPhiM = cosf(phiM);
-    const float sinPhiM = sinf(phiM);
-
-    const float term = 1.0f + tanThetaSqr * ((cosPhiM * cosPhiM) / (ax * ax) + (sinPhiM * sinPhiM) / (ay * ay));
-
-    const float d   = 1.0f / (M_PIf * ax * ay * cosThetaSqr * cosThetaSqr * term * term); // Heitz, Formula (85)
-    const float pdf = d * wm.z; // PDF with respect to the half-direction.
-      
-    return make_float2(d, pdf);
-  }
-  return make_float2(0.0f);
-}
+// ########## BRDF GGX with Smith shadowing
 
-// Return a sample direction in local tangent space coordinates.
-__forceinline__ __device__ float3 distribution_sample(const float ax, const float ay, const float u1, const float u2)
+extern "C" __device__ void __direct_callable__sample_brdf_ggx_smith(MaterialDefinition const& material, State const& state, PerRayData* prd)
 {
-  // Made isotropic to ay. Output vector scales .x accordingly.
-  const float theta    = atanf(ay * sqrtf(u1) / sqrtf(1.0f - u1)); // Walter, Formula (35).
-  const float phi      = 2.0f * M_PIf * u2;                        // Walter, Formula (36).
-  const float sinTheta = sinf(theta);
-  return normalize(make_float3(cosf(phi) * sinTheta * ax / ay,     // Heitz, Formula (77)
-                               sinf(phi) * sinTheta,
-                               cosf(theta)));
-}
+  const TBN tangentSpace(state.tangent, state.normal); // Tangent space transformation, handles anisotropic rotation. 
 
-// "Microfacet Models for Refraction through Rough Surfaces" - Walter, Marschner, Li, Torrance.
-// PERF Using this because it's faster than the approximation below.
-__forceinline__ __device__ float smith_G1(const float alpha, float3 const& w, float3 const& wm)
-{
-  const float w_wm = dot(w, wm);
-  if (w_wm * w.z <= 0.0f) // X_plus(v * m / v * n) from Walter, Formula (34). // PERF Checking the sign with a multiplication here.
+  const float3 wo = tangentSpace.transformToLocal(prd->wo);
+
+  if (wo.z <= 0.0f)
   {
-    return 0.0f;
+    prd->flags |= FLAG_TERMINATE;
+    return;
   }
-  const float cosThetaSqr = w.z * w.z;
-  const float sinThetaSqr = 1.0f - cosThetaSqr;
-  //const float tanTheta = (0.0f < sinThetaSqr) ? sqrtf(sinThetaSqr) / w.z : 0.0f; // PERF Remove the sqrtf() by calculating tanThetaSqr here
-  //const float invA = alpha * tanTheta;                                           // because this is squared below: invASqr = alpha * alpha * tanThetaSqr;
-  //const float lambda = (-1.0f + sqrtf(1.0f + invA * invA)) * 0.5f; // Heitz, Formula (86)
-  //return 1.0f / (1.0f + lambda);                                   // Heitz, below Formula (69)
-  const float tanThetaSqr = (0.0f < sinThetaSqr) ? sinThetaSqr / cosThetaSqr : 0.0f;
-  const float invASqr = alpha * alpha * tanThetaSqr;                                           
-  return 2.0f / (1.0f + sqrtf(1.0f + invASqr));                     // Optimized version is Walter, Formula (34)
-}
-
-// Approximation from "Microfacet Models for Refraction through Rough Surfaces" - Walter, Marschner, Li, Torrance.
-//__forceinline__ __device__ float smith_G1(const float alpha, float3 const& w, float3 const& wm)
-//{
-//  const float w_wm = optix::dot(w, wm);
-//  if (w_wm * w.z <= 0.0f) // X_plus(v * m / v * n) from Walter, Formula (34). // PERF Checking the sign with a multiplication here.
-//  {
-//    return 0.0f;
-//  }
-//  const float t        = 1.0f - w.z * w.z; 
-//  const float tanTheta = (0.0f < t) ? sqrtf(t) / w.z : 0.0f;
-//  if (tanTheta == 0.0f)
-//  {
-//    return 1.0f;
-//  }
-//  const float a = 1.0f / (tanTheta * alpha);
-//  if (1.6f <= a)
-//  {
-//    return 1.0f;
-//  }
-//  const float aSqr = a * a;
-//  return (3.535f * a + 2.181f * aSqr) / (1.0f + 2.276f * a + 2.577f * aSqr); // Walter, Formula (27) used for Heitz, Formula (83)
-//}
-
-__forceinline__ __device__ float distribution_G(const float ax, const float ay, float3 const& wo, float3 const& wi, float3 const& wm)
-{
-  float phi   = atan2f(wo.y, wo.x);
-  float c     = cosf(phi);
-  float s     = sinf(phi);
-  float alpha = sqrtf(c * c * ax * ax + s * s * ay * ay); // Heitz, Formula (80) for wo
-
-  const float g = smith_G1(alpha, wo, wm);
-
-  phi   = atan2f(wi.y, wi.x);
-  c     = cosf(phi);
-  s     = sinf(phi);
-  alpha = sqrtf(c * c * ax * ax + s * s * ay * ay); // Heitz, Formula (80) for wi.
-
-  return g * smith_G1(alpha, wi, wm);
-}
-
-// ########## BRDF GGX with Smith shadowing
 
-extern "C" __device__ void __direct_callable__sample_brdf_ggx_smith(MaterialDefinition const& material, State const& state, PerRayData* prd)
-{
-  // Sample a microfacet normal in local space, which effectively is a tangent space coordinate.
+  // Sample a microfacet normal visible from wo in local space, which effectively is a tangent space coordinate.
+  // No samples are wasted on back-facing microfacets, which matters most at grazing angles.
   const float2 sample = rng2(prd->seed);
 
-  const float3 wm = distribution_sample(material.roughness.x, 
-                                        material.roughness.y, 
-                                        sample.x,
-                                        sample.y);
+  const float3 wm = distribution_sample_visible(material.roughness.x, 
+                                                material.roughness.y, 
+                                                wo,
+                                                sample.x,
+                                                sample.y);
 
-  const TBN tangentSpace(state.tangent, state.normal); // Tangent space transformation, handles anisotropic rotation. 
-  
   const float3 wh = tangentSpace.transformToWorld(wm); // wh is the microfacet normal in world space coordinates!
  
   prd->wi = reflect(-prd->wo, wh);
@@ -188,35 +102,28 @@ extern "C" __device__ void __direct_callable__sample_brdf_ggx_smith(MaterialDefi
     return;
   }
 
-  const float3 wo = tangentSpace.transformToLocal(prd->wo);
   const float3 wi = tangentSpace.transformToLocal(prd->wi);
 
-  const float wi_wh = dot(prd->wi, wh);
-
-  if (wo.z <= 0.0f || wi.z <= 0.0f || wi_wh <= 0.0f) 
+  if (wi.z <= 0.0f || dot(prd->wi, wh) <= 0.0f) // Reflected below the shading normal hemisphere.
   {
     prd->flags |= FLAG_TERMINATE;
     return;
   }
 
-  const float2 D_PDF = distribution_d_pdf(material.roughness.x,
-                                          material.roughness.y,
-                                          wm);
-  if (D_PDF.y <= 0.0f)
+  const float G1 = distribution_G1(material.roughness.x, material.roughness.y, wo, wm);
+  if (G1 <= 0.0f)
   {
     prd->flags |= FLAG_TERMINATE;
     return;
   }
 
-  const float G = distribution_G(material.roughness.x,
-                                 material.roughness.y,
-                                 wo, wi, wm);
-    
+  const float G = G1 * distribution_G1(material.roughness.x, material.roughness.y, wi, wm);
+
   // Watch out: PBRT2 puts the factor 1.0f / (4.0f * cosThetaH) into the pdf() functions.
   //            This is the density function with respect to the light vector.
-  prd->pdf = D_PDF.y / (4.0f * wi_wh);
-  //prd->f_over_pdf = state.albedo * (fabsf(dot(prd->wi, state->normal)) * D_PDF.x * G / (4.0f * wo.z * wi.z * prd->pdf));
-  prd->f_over_pdf = state.albedo * (G * D_PDF.x * wi_wh / (D_PDF.y * wo.z)); // Optimized version with all factors canceled out.
+  prd->pdf = distribution_pdf_reflection(material.roughness.x, material.roughness.y, wo, wm);
+  // f * cos(wi) / pdf = (D * G / (4 * wo.z * wi.z)) * wi.z / (G1(wo) * D / (4 * wo.z)). Everything except the masking of wi cancels out.
+  prd->f_over_pdf = state.albedo * (G / G1);
 
   prd->flags |= FLAG_DIFFUSE; // Can handle direct lighting.
 }
@@ -243,19 +150,19 @@ extern "C" __device__ float4 __direct_callable__eval_brdf_ggx_smith(MaterialDefi
 
   wm = normalize(wm);
 
-  const float2 D_PDF = distribution_d_pdf(material.roughness.x,
-                                          material.roughness.y,
-                                          wm);
+  const float D = distribution_d(material.roughness.x,
+                                 material.roughness.y,
+                                 wm);
 
   const float G = distribution_G(material.roughness.x,
                                  material.roughness.y,
                                  wo, wi, wm);
 
-  const float3 f = state.albedo * (D_PDF.x * G / (4.0f * wo.z * wi.z));
+  const float3 f = state.albedo * (D * G / (4.0f * wo.z * wi.z));
   
   // Watch out: PBRT2 puts the factor 1.0f / (4.0f * cosThetaH) into the pdf() functions.
-  //            This is the density function with respect to the light vector.
-  const float pdf = D_PDF.y / (4.0f * dot(wi, wm));
+  //            This is the density function with respect to the light vector, matching the visible normal sampling.
+  const float pdf = distribution_pdf_reflection(material.roughness.x, material.roughness.y, wo, wm);
 
   return make_float4(f, pdf);
 }
@@ -275,16 +182,20 @@ extern "C" __device__ void __direct_callable__sample_bsdf_ggx_smith(MaterialDefi
                   ? prd->absorption_ior.w / prd->ior.x 
                   : prd->ior.y / prd->absorption_ior.w;
   
-  // Sample a microfacet normal in local space, which effectively is a tangent space coordinate.
+  const TBN tangentSpace(state.tangent, state.normal); // Tangent space transformation, handles anisotropic rotation. 
+
+  float3 wo = tangentSpace.transformToLocal(prd->wo);
+  wo.z = fmaxf(wo.z, DENOMINATOR_EPSILON); // The shading normal can face away from wo. Sample with the view direction on the horizon then.
+
+  // Sample a microfacet normal visible from wo in local space, which effectively is a tangent space coordinate.
   const float2 sample = rng2(prd->seed);
 
-  const float3 wm = distribution_sample(material.roughness.x, 
-                                        material.roughness.y, 
-                                        sample.x,
-                                        sample.y);
+  const float3 wm = distribution_sample_visible(material.roughness.x, 
+                                                material.roughness.y, 
+                                                normalize(wo),
+                                                sample.x,
+                                                sample.y);
 
-  const TBN tangentSpace(state.tangent, state.normal); // Tangent space transformation, handles anisotropic rotation. 
-  
   const float3 wh = tangentSpace.transformToWorld(wm); // wh is the microfacet normal in world space coordinates!
 
 
@@ -313,8 +224,19 @@ extern "C" __device__ void __direct_callable__sample_bsdf_ggx_smith(MaterialDefi
     prd->flags |= FLAG_TRANSMISSION;
   }
 
+  // With visible normal sampling the sample weight is the masking of the outgoing direction. Heitz 2018, Formula (19).
+  // Thin-walled transmission mirrors the reflection, so it has the same masking as R.
+  const float3 wi = tangentSpace.transformToLocal((prd->flags & FLAG_THINWALLED) ? R : prd->wi);
+
+  const float G1 = distribution_G1(material.roughness.x, material.roughness.y, wi, wm);
+  if (G1 <= 0.0f)
+  {
+    prd->flags |= FLAG_TERMINATE;
+    return;
+  }
+
   // No Fresnel factor here. The probability to pick one or the other side took care of that.
-  prd->f_over_pdf = state.albedo;
+  prd->f_over_pdf = state.albedo * G1;
   prd->pdf        = 1.0f; // Not 0.0f to make sure the path is not terminated. Otherwise unused for specular events.
 }
 
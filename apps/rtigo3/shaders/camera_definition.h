@@ -39,4 +39,13 @@ struct CameraDefinition
   float3 W;
 };
 
+// A rectangular region of the output buffer rendered with its own camera.
+// All views are rendered in a single launch, the launch depth selects the view.
+struct ViewDefinition
+{
+  int2 origin;   // Lower left pixel of the view inside the output buffer.
+  int2 size;     // Resolution of the view. Views can have different sizes.
+  int  idCamera; // Index into the SystemData cameraDefinitions.
+};
+
 #endif // CAMERA_DEFINITION_H
@@ -36,6 +36,8 @@
 #include "function_indices.h"
 #include "material_definition.h"
 #include "light_definition.h"
+#include "light_parallelogram.h"
+#include "ray_cone.h"
 #include "shader_common.h"
 #include "random_number_generators.h"
 
@@ -122,6 +124,17 @@ __forceinline__ __device__ float3 transformNormal(const float4* m, float3 const&
   return r;
 }
 
+// Texture independent ray cone LOD of the hit triangle. mW is the object to world transform.
+__forceinline__ __device__ float getRayConeLod(const float4* mW,
+                                               TriangleAttributes const& attr0, TriangleAttributes const& attr1, TriangleAttributes const& attr2,
+                                               float3 const& direction, const float width)
+{
+  const float3 e1 = transformVector(mW, attr1.vertex - attr0.vertex);
+  const float3 e2 = transformVector(mW, attr2.vertex - attr0.vertex);
+
+  return rayConeLod(e1, e2, make_float2(attr1.texcoord - attr0.texcoord), make_float2(attr2.texcoord - attr0.texcoord), direction, width);
+}
+
 
 extern "C" __global__ void __closesthit__radiance()
 {
@@ -162,11 +175,27 @@ extern "C" __global__ void __closesthit__radiance()
   // Get the current rtPayload pointer from the unsigned int payload registers p0 and p1.
   PerRayData* thePrd = mergePointer(optixGetPayload_0(), optixGetPayload_1());
 
+  // Time view and AOVs record the primary hit's instance and material. Only the primary hit finds idHit.x == 0.
+  const bool isPrimaryHit = (sysData.timeView || (sysData.aovMask & AOV_MASK_PRIMARY_HIT)) && thePrd->idHit.x == 0;
+  
+  if (isPrimaryHit)
+  {
+    thePrd->idHit        = make_uint2(optixGetInstanceId() + 1, theData->materialIndex + 1);
+    thePrd->aovPrimitive = thePrimitiveIndex + 1;
+  }
+
   thePrd->distance = optixGetRayTmax(); // Return the current path segment distance, needed for absorption calculations in the integrator.
+
+  if (isPrimaryHit && (sysData.aovMask & AOV_DEPTH))
+  {
+    thePrd->aovDepth = thePrd->distance;
+  }
   
   //thePrd->pos = optixGetWorldRayOrigin() + optixGetWorldRayDirection() * optixGetRayTmax();
   thePrd->pos += thePrd->wi * thePrd->distance; // DEBUG Check which version is more efficient.
 
+  thePrd->cone.x = rayConeWidth(thePrd->cone, thePrd->distance); // The ray cone width at the hit point.
+
   // Explicitly include edge-on cases as frontface condition!
   // Keeps the material stack from overflowing at silhouettes.
   // Prevents that silhouettes of thin-walled materials use the backface material.
@@ -182,6 +211,11 @@ extern "C" __global__ void __closesthit__radiance()
     state.normal    = -state.normal;
     // Explicitly DO NOT recalculate the frontface condition!
   }
+
+  if (isPrimaryHit && (sysData.aovMask & AOV_NORMAL))
+  {
+    thePrd->aovNormal = state.normal;
+  }
   
   thePrd->radiance = make_float3(0.0f);
 
@@ -197,7 +231,8 @@ extern "C" __global__ void __closesthit__radiance()
       float3 emission = light.emission;
 
 #if USE_NEXT_EVENT_ESTIMATION
-      const float lightPdf = (thePrd->distance * thePrd->distance) / (light.area * cosTheta); // This assumes the light.area is greater than zero.
+      // The pdf of the light sample strategy the previous hit point used for this light.
+      const float lightPdf = lightParallelogramPdf(light, optixGetWorldRayOrigin(), thePrd->distance, cosTheta);
 
       // If it's an implicit light hit from a diffuse scattering event and the light emission was not returning a zero pdf (e.g. backface or edge on).
       if ((thePrd->flags & FLAG_DIFFUSE) && DENOMINATOR_EPSILON < lightPdf)
@@ -215,6 +250,22 @@ extern "C" __global__ void __closesthit__radiance()
     }
   }
 
+  if (thePrd->flags & FLAG_WAVEFRONT)
+  {
+    // The wavefront trace launch only records the surface interaction. The material sorted shading launch evaluates it.
+    WavefrontHit& hit = sysData.wavefront->hits[optixGetLaunchIndex().x];
+
+    hit.pos           = thePrd->pos;
+    hit.normalGeo     = state.normalGeo;
+    hit.normal        = state.normal;
+    hit.tangent       = state.tangent;
+    hit.texcoord      = state.texcoord;
+    hit.lod           = getRayConeLod(objectToWorld, attr0, attr1, attr2, thePrd->wi, thePrd->cone.x);
+    hit.materialIndex = theData->materialIndex;
+    hit.flags         = thePrd->flags & FLAG_FRONTFACE;
+    return;
+  }
+
   // Start fresh with the next BSDF sample. (Either of these values remaining zero is an end-of-path condition.)
   // The pdf of the previous evene was needed for the emission calculation above.
   thePrd->f_over_pdf = make_float3(0.0f);
@@ -226,12 +277,19 @@ extern "C" __global__ void __closesthit__radiance()
 
   if (material.textureAlbedo != 0)
   {
-    const float3 texColor = make_float3(tex2D<float4>(material.textureAlbedo, state.texcoord.x, state.texcoord.y));
+    const float lod = getRayConeLod(objectToWorld, attr0, attr1, attr2, thePrd->wi, thePrd->cone.x);
+
+    const float3 texColor = make_float3(tex2DLod<float4>(material.textureAlbedo, state.texcoord.x, state.texcoord.y, rayConeMipLevel(lod, material.textureLod.x)));
 
     // Modulate the incoming color with the texture.
     state.albedo *= texColor;               // linear color, resp. if the texture has been uint8 and readmode set to use sRGB, then sRGB.
     //state.albedo *= powf(texColor, 2.2f); // sRGB gamma correction done manually.
   }
+
+  if (isPrimaryHit && (sysData.aovMask & AOV_ALBEDO)) // Lights keep the black albedo because they returned above.
+  {
+    thePrd->aovAlbedo = state.albedo;
+  }
  
   // Only the last diffuse hit is tracked for multiple importance sampling of implicit light hits.
   thePrd->flags = (thePrd->flags & ~FLAG_DIFFUSE) | FLAG_HIT | material.flags; // FLAG_THINWALLED can be set directly from the material.
@@ -241,6 +299,9 @@ extern "C" __global__ void __closesthit__radiance()
 
   optixDirectCall<void, MaterialDefinition const&, State const&, PerRayData*>(indexBSDF, material, state, thePrd);
 
+  // The continued path and the shadow ray start with the cone width at this hit.
+  thePrd->cone.y = rayConeScatter(thePrd->cone.y, (thePrd->flags & FLAG_DIFFUSE) != 0);
+
 #if USE_NEXT_EVENT_ESTIMATION
   // Direct lighting if the sampled BSDF was diffuse and any light is in the scene.
   const int numLights = sysData.numLights;
@@ -30,9 +30,11 @@
 #include "config.h"
 
 #include "compositor_data.h"
+#include "tile_layout.h"
 #include "vector_math.h"
 
 // Compositor kernel to copy the tiles in the texelBuffer into the final outputBuffer location.
+// This also detiles the tile ordered accumulation layout. Each block reads whole tiles then.
 extern "C" __global__ void compositor(CompositorData* args)
 {
   const unsigned int xLaunch = blockIdx.x * blockDim.x + threadIdx.x;
@@ -57,7 +59,11 @@ extern "C" __global__ void compositor(CompositorData* args)
       float4       *dst = reinterpret_cast<float4*>(args->outputBuffer);
 
       // The src location needs to be calculated with the original launch width, because gridDim.x * blockDim.x migth be different.
-      dst[yLaunch * args->resolution.x + xPixel] = src[yLaunch * args->launchWidth + xLaunch]; // Copy one float4 per launch index.
+      const unsigned int indexTexel = (args->accumulationLayout == ACCUMULATION_LAYOUT_TILED)
+                                    ? tiledIndex(xLaunch, yLaunch, args->launchWidth >> args->tileShift.x, args->tileShift)
+                                    : yLaunch * args->launchWidth + xLaunch;
+
+      dst[yLaunch * args->resolution.x + xPixel] = src[indexTexel]; // Copy one float4 per launch index.
     }
   }
 }
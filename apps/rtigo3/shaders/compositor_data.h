@@ -47,6 +47,7 @@ struct CompositorData
   int launchWidth;  // The orignal launch width. Needed to calculate the source data index. The compositor launch gridDim.x * blockDim.x might be different!
   int deviceCount;  // Number of devices doing the rendering.
   int deviceIndex;  // Device index to be able to distinguish the individual devices in a multi-GPU environment.
+  int accumulationLayout; // ACCUMULATION_LAYOUT_* of the tileBuffer. The outputBuffer is always linear.
 };
 
 #endif // COMPOSITOR_DATA_H
@@ -47,6 +47,14 @@
 // If both anisotropic roughness values fall below this threshold, the BSDF switches to specular.
 #define MICROFACET_MIN_ROUGHNESS 0.0014142f
 
+// Parallelogram lights whose edges are orthogonal within this relative tolerance are treated as rectangles.
+#define LIGHT_RECTANGLE_EPSILON 1.0e-4f
+// Rectangle lights subtending an estimated solid angle (in steradians) above this threshold are sampled by solid angle instead of area.
+#define LIGHT_SOLID_ANGLE_THRESHOLD 0.1f
+
+// Minimum ray cone spread angle (in radians) after diffuse or glossy interactions. Selects coarser texture LODs on indirect hits.
+#define RAY_CONE_DIFFUSE_SPREAD 0.05f
+
 // 0 == Brute force path tracing without next event estimation (direct lighting). // Debug setting to compare lighting results.
 // 1 == Next event estimation per path vertex (direct lighting) and using MIS with power heuristic. // Default.
 #define USE_NEXT_EVENT_ESTIMATION 1
@@ -55,10 +63,6 @@
 // 1 == All debug features enabled. Code generated with full debug info. (Really only for debugging, big performance hit!)
 #define USE_DEBUG_EXCEPTIONS 0
 
-// 0 == Disable clock() usage and time view display.
-// 1 == Enable clock() usage and time view display.
-#define USE_TIME_VIEW 0
-
 #define INTEROP_MODE_OFF 0
 #define INTEROP_MODE_TEX 1
 #define INTEROP_MODE_PBO 2
@@ -0,0 +1,98 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef ENV_FORMAT_DEFINITION_H
+#define ENV_FORMAT_DEFINITION_H
+
+#include "vector_math.h"
+
+// Device formats of the spherical environment texture. The importance sampling CDFs are always built from the RGBA32F source data.
+enum EnvFormat
+{
+  ENV_FORMAT_RGBA32F = 0, // float4, 16 bytes per texel. Hardware filtered.
+  ENV_FORMAT_RGBA16F = 1, // half4,   8 bytes per texel. Hardware filtered. Radiance above 65504 is clamped.
+  ENV_FORMAT_RGB9E5  = 2, // uint32,  4 bytes per texel. 9 bit mantissas with a shared 5 bit exponent, bilinear filtered in the shader.
+  NUM_ENV_FORMATS    = 3
+};
+
+// Shared exponent layout as in GL_EXT_texture_shared_exponent: red in bits [0, 8], green [9, 17], blue [18, 26], exponent [27, 31].
+#define RGB9E5_MANTISSA_BITS 9
+#define RGB9E5_EXPONENT_BIAS 15
+#define RGB9E5_MAX_VALUE     65408.0f // (2^9 - 1) / 2^9 * 2^(31 - 15)
+
+__forceinline__ __host__ __device__ float3 decodeRGB9E5(const unsigned int rgb9e5)
+{
+  const float scale = ldexpf(1.0f, int(rgb9e5 >> 27) - RGB9E5_EXPONENT_BIAS - RGB9E5_MANTISSA_BITS);
+
+  return make_float3(float( rgb9e5        & 0x1FF) * scale,
+                     float((rgb9e5 >>  9) & 0x1FF) * scale,
+                     float((rgb9e5 >> 18) & 0x1FF) * scale);
+}
+
+#if defined(__CUDACC__)
+
+// Integer textures only support point sampling. This matches the hardware bilinear filter with the texel centers at +0.5.
+// The wrap and clamp address modes of the texture object still apply to the four point samples.
+__forceinline__ __device__ float3 sampleRGB9E5(cudaTextureObject_t tex, const unsigned int width, const unsigned int height, const float u, const float v)
+{
+  const float x = u * float(width)  - 0.5f;
+  const float y = v * float(height) - 0.5f;
+
+  const float x0 = floorf(x);
+  const float y0 = floorf(y);
+
+  const float invWidth  = 1.0f / float(width);
+  const float invHeight = 1.0f / float(height);
+
+  const float u0 = (x0 + 0.5f) * invWidth;
+  const float v0 = (y0 + 0.5f) * invHeight;
+  const float u1 = u0 + invWidth;
+  const float v1 = v0 + invHeight;
+
+  const float3 c00 = decodeRGB9E5(tex2D<unsigned int>(tex, u0, v0));
+  const float3 c10 = decodeRGB9E5(tex2D<unsigned int>(tex, u1, v0));
+  const float3 c01 = decodeRGB9E5(tex2D<unsigned int>(tex, u0, v1));
+  const float3 c11 = decodeRGB9E5(tex2D<unsigned int>(tex, u1, v1));
+
+  return bilerp(c00, c10, c01, c11, x - x0, y - y0);
+}
+
+__forceinline__ __device__ float3 sampleEnvironment(cudaTextureObject_t tex, const int format, const unsigned int width, const unsigned int height, const float u, const float v)
+{
+  if (format == ENV_FORMAT_RGB9E5)
+  {
+    return sampleRGB9E5(tex, width, height, u, v);
+  }
+  return make_float3(tex2D<float4>(tex, u, v)); // RGBA32F and RGBA16F.
+}
+
+#endif // __CUDACC__
+
+#endif // ENV_FORMAT_DEFINITION_H
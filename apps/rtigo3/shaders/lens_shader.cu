@@ -32,29 +32,33 @@
 
 #include "system_data.h"
 #include "shader_common.h"
+#include "ray_cone.h"
 
 extern "C" __constant__ SystemData sysData;
 
 // Note that all these lens shaders return the primary ray origin and direction in world space!
+// The screen is the resolution of the rendered view and the pixel is relative to the view's origin.
 
-extern "C" __device__ LensRay __direct_callable__pinhole(const float2 screen, const float2 pixel, const float2 sample)
+extern "C" __device__ LensRay __direct_callable__pinhole(const float2 screen, const float2 pixel, const float2 sample, const int idCamera)
 {
   const float2 fragment = pixel + sample;                    // Jitter the sub-pixel location
   const float2 ndc      = (fragment / screen) * 2.0f - 1.0f; // Normalized device coordinates in range [-1, 1].
 
-  const CameraDefinition camera = sysData.cameraDefinitions[0];
+  const CameraDefinition camera = sysData.cameraDefinitions[idCamera];
   
   LensRay ray;
 
-  ray.org = camera.P;
-  ray.dir = normalize(camera.U * ndc.x +
-                      camera.V * ndc.y +
-                      camera.W);
+  ray.org    = camera.P;
+  ray.dir    = normalize(camera.U * ndc.x +
+                         camera.V * ndc.y +
+                         camera.W);
+  ray.spread = rayConeSpreadPinhole(camera.V, camera.W, screen.y);
+
   return ray;
 }
 
 
-extern "C" __device__ LensRay __direct_callable__fisheye(const float2 screen, const float2 pixel, const float2 sample)
+extern "C" __device__ LensRay __direct_callable__fisheye(const float2 screen, const float2 pixel, const float2 sample, const int idCamera)
 {
   const float2 fragment = pixel + sample; // x, y
   
@@ -63,7 +67,7 @@ extern "C" __device__ LensRay __direct_callable__fisheye(const float2 screen, co
   const float2 uv     = (fragment - center) / length(center); // uv components are in the range [0, 1]. Both 1 in the corners of the image!
   const float z       = cosf(length(uv) * 0.7071067812f * 0.5f * M_PIf); // Scale by 1.0f / sqrtf(2.0f) to get length into the range [0, 1]
 
-  const CameraDefinition camera = sysData.cameraDefinitions[0];
+  const CameraDefinition camera = sysData.cameraDefinitions[idCamera];
 
   const float3 U = normalize(camera.U);
   const float3 V = normalize(camera.V);
@@ -71,14 +75,15 @@ extern "C" __device__ LensRay __direct_callable__fisheye(const float2 screen, co
 
   LensRay ray;
 
-  ray.org = camera.P;
-  ray.dir = normalize(uv.x * U + uv.y * V + z * W);
+  ray.org    = camera.P;
+  ray.dir    = normalize(uv.x * U + uv.y * V + z * W);
+  ray.spread = 0.7071067812f * 0.5f * M_PIf / length(center); // Angle per pixel of the fisheye projection.
 
   return ray;
 }
 
 
-extern "C" __device__ LensRay __direct_callable__sphere(const float2 screen, const float2 pixel, const float2 sample)
+extern "C" __device__ LensRay __direct_callable__sphere(const float2 screen, const float2 pixel, const float2 sample, const int idCamera)
 {
   const float2 uv = (pixel + sample) / screen; // "texture coordinates"
 
@@ -92,7 +97,7 @@ extern "C" __device__ LensRay __direct_callable__sphere(const float2 screen, con
                                -cosf(theta),
                                -cosf(phi) * sinTheta);
 
-  const CameraDefinition camera = sysData.cameraDefinitions[0];
+  const CameraDefinition camera = sysData.cameraDefinitions[idCamera];
 
   const float3 U = normalize(camera.U);
   const float3 V = normalize(camera.V);
@@ -100,8 +105,9 @@ extern "C" __device__ LensRay __direct_callable__sphere(const float2 screen, con
 
   LensRay ray;
 
-  ray.org = camera.P;
-  ray.dir = normalize(v.x * U + v.y * V + v.z * W);
+  ray.org    = camera.P;
+  ray.dir    = normalize(v.x * U + v.y * V + v.z * W);
+  ray.spread = M_PIf / screen.y; // Latitude angle per pixel.
 
   return ray;
 }
@@ -0,0 +1,170 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef LIGHT_PARALLELOGRAM_H
+#define LIGHT_PARALLELOGRAM_H
+
+#include "config.h"
+#include "vector_math.h"
+
+#include "light_definition.h"
+
+// Sampling strategies for the LIGHT_PARALLELOGRAM area light. The closest hit program needs the same pdf for the implicit light hit MIS weight.
+//
+// Rectangles which subtend a big solid angle from the shading point are sampled uniformly inside that solid angle.
+// "An Area-Preserving Parametrization for Spherical Rectangles" - Urena, Fajardo, King. 2013
+// Everything else (small or distant lights, sheared parallelograms) is sampled uniformly by area.
+
+struct SphericalRectangle
+{
+  float3 origin; // Shading point.
+  float3 x;      // Local reference system. x and y are along the rectangle edges, z points away from the rectangle.
+  float3 y;
+  float3 z;
+  float  x0;     // Rectangle bounds in the local reference system. The rectangle lies in the plane z == z0 < 0.
+  float  y0;
+  float  x1;
+  float  y1;
+  float  z0;
+  float  b0;
+  float  b1;
+  float  k;
+  float  S;      // Solid angle subtended by the rectangle.
+};
+
+// Urena 2013, Algorithm 1. The rectangle is given by a corner s and the edge vectors ex and ey.
+__forceinline__ __host__ __device__ void sphericalRectangleInit(SphericalRectangle& sq, float3 const& s, float3 const& ex, float3 const& ey, float3 const& o)
+{
+  const float exl = length(ex);
+  const float eyl = length(ey);
+
+  sq.origin = o;
+  sq.x = ex / exl;
+  sq.y = ey / eyl;
+  sq.z = cross(sq.x, sq.y);
+
+  const float3 d = s - o;
+
+  sq.z0 = dot(d, sq.z);
+  if (0.0f < sq.z0) // Flip z to make it point against the rectangle.
+  {
+    sq.z  = -sq.z;
+    sq.z0 = -sq.z0;
+  }
+  sq.x0 = dot(d, sq.x);
+  sq.y0 = dot(d, sq.y);
+  sq.x1 = sq.x0 + exl;
+  sq.y1 = sq.y0 + eyl;
+
+  // Normals of the four planes through the origin and the rectangle edges.
+  // Only the non-zero components are needed, the other ones follow from the rectangle's axis alignment.
+  const float3 n0 = normalize(make_float3(0.0f, sq.z0, -sq.y0));
+  const float3 n1 = normalize(make_float3(-sq.z0, 0.0f, sq.x1));
+  const float3 n2 = normalize(make_float3(0.0f, -sq.z0, sq.y1));
+  const float3 n3 = normalize(make_float3(sq.z0, 0.0f, -sq.x0));
+
+  // Internal angles of the spherical rectangle.
+  const float g0 = acosf(clamp(-n0.z * n1.z, -1.0f, 1.0f));
+  const float g1 = acosf(clamp(-n1.z * n2.z, -1.0f, 1.0f));
+  const float g2 = acosf(clamp(-n2.z * n3.z, -1.0f, 1.0f));
+  const float g3 = acosf(clamp(-n3.z * n0.z, -1.0f, 1.0f));
+
+  sq.b0 = n0.z;
+  sq.b1 = n2.z;
+  sq.k  = 2.0f * M_PIf - g2 - g3;
+  sq.S  = g0 + g1 - sq.k;
+}
+
+// Urena 2013, Algorithm 2. Returns the world position of the sample on the rectangle.
+__forceinline__ __host__ __device__ float3 sphericalRectangleSample(SphericalRectangle const& sq, const float u, const float v)
+{
+  // Compute cu, the cosine of the angle between the sample plane and the x-axis.
+  const float au = u * sq.S + sq.k;
+  const float fu = (cosf(au) * sq.b0 - sq.b1) / sinf(au);
+  float cu = copysignf(1.0f, fu) / sqrtf(fu * fu + sq.b0 * sq.b0);
+  cu = clamp(cu, -1.0f, 1.0f);
+
+  // Compute xu, the x coordinate of the sample plane.
+  float xu = -(cu * sq.z0) / fmaxf(sqrtf(1.0f - cu * cu), DENOMINATOR_EPSILON);
+  xu = clamp(xu, sq.x0, sq.x1);
+
+  // Compute yv, the y coordinate of the sample. Clamped like xu, shading points at grazing angles next to the light
+  // lose enough precision in hv to land samples outside the rectangle otherwise.
+  const float dd  = sqrtf(xu * xu + sq.z0 * sq.z0);
+  const float h0  = sq.y0 / sqrtf(dd * dd + sq.y0 * sq.y0);
+  const float h1  = sq.y1 / sqrtf(dd * dd + sq.y1 * sq.y1);
+  const float hv  = h0 + v * (h1 - h0);
+  const float hv2 = hv * hv;
+  const float yv  = clamp((hv2 < 1.0f - DENOMINATOR_EPSILON) ? (hv * dd) / sqrtf(1.0f - hv2) : sq.y1, sq.y0, sq.y1);
+
+  return sq.origin + xu * sq.x + yv * sq.y + sq.z0 * sq.z;
+}
+
+// Solid angle sampling is only worth its cost (and only numerically robust in single precision)
+// when the light subtends a big solid angle. Deterministic in the light and the shading point,
+// so that the light sample and the implicit light hit agree on the strategy and its pdf.
+__forceinline__ __host__ __device__ bool useSolidAngleSampling(LightDefinition const& light, float3 const& point)
+{
+  const float lenU = length(light.vecU);
+  const float lenV = length(light.vecV);
+
+  // Only rectangles. Sheared parallelograms fall back to area sampling.
+  if (LIGHT_RECTANGLE_EPSILON * lenU * lenV < fabsf(dot(light.vecU, light.vecV)))
+  {
+    return false;
+  }
+
+  // Estimate the subtended solid angle from the light center. Overestimates near the light, which is intended.
+  const float3 d = light.position + 0.5f * (light.vecU + light.vecV) - point;
+  const float  distanceSqr = fmaxf(dot(d, d), DENOMINATOR_EPSILON);
+  const float  cosTheta    = fabsf(dot(d, light.normal)) * (1.0f / sqrtf(distanceSqr));
+
+  return LIGHT_SOLID_ANGLE_THRESHOLD * distanceSqr < light.area * cosTheta;
+}
+
+// Solid angle pdf of the light sample strategy used at point for a sample on the light 
+// at the given distance and cosine to the light normal. 
+__forceinline__ __host__ __device__ float lightParallelogramPdf(LightDefinition const& light, float3 const& point, const float distance, const float cosTheta)
+{
+  if (useSolidAngleSampling(light, point))
+  {
+    SphericalRectangle sq;
+
+    sphericalRectangleInit(sq, light.position, light.vecU, light.vecV, point);
+
+    if (DENOMINATOR_EPSILON < sq.S)
+    {
+      return 1.0f / sq.S;
+    }
+  }
+  return (distance * distance) / (light.area * cosTheta); // Assumes light.area != 0.0f.
+}
+
+#endif // LIGHT_PARALLELOGRAM_H
@@ -31,6 +31,8 @@
 #include <optix.h>
 
 #include "system_data.h"
+#include "env_format_definition.h"
+#include "light_parallelogram.h"
 
 #include "shader_common.h"
 
@@ -150,7 +152,7 @@ extern "C" __device__ LightSample __direct_callable__light_env_sphere(LightDefin
   // Note that environment lights do not set the light sample position!
   lightSample.distance = RT_DEFAULT_MAX; // Environment light.
 
-  const float3 emission = make_float3(tex2D<float4>(sysData.envTexture, u, v));
+  const float3 emission = sampleEnvironment(sysData.envTexture, sysData.envFormat, sysData.envWidth, sysData.envHeight, u, v);
   // Explicit light sample. The returned emission must be scaled by the inverse probability to select this light.
   lightSample.emission = emission * sysData.numLights;
   // For simplicity we pretend that we perfectly importance-sampled the actual texture-filtered environment map
@@ -167,7 +169,32 @@ extern "C" __device__ LightSample __direct_callable__light_parallelogram(LightDe
 
   lightSample.pdf = 0.0f; // Default return, invalid light sample (backface, edge on, or too near to the surface)
 
-  lightSample.position  = light.position + light.vecU * sample.x + light.vecV * sample.y; // The light sample position in world coordinates.
+  // Only emit light on the front side. Checked upfront because the solid angle sampling works from both sides.
+  if (dot(point - light.position, light.normal) <= 0.0f)
+  {
+    return lightSample;
+  }
+
+  float pdfSolidAngle = 0.0f; // Stays zero when sampling by area.
+
+  if (useSolidAngleSampling(light, point))
+  {
+    SphericalRectangle sq;
+
+    sphericalRectangleInit(sq, light.position, light.vecU, light.vecV, point);
+
+    if (DENOMINATOR_EPSILON < sq.S)
+    {
+      lightSample.position = sphericalRectangleSample(sq, sample.x, sample.y);
+      pdfSolidAngle = 1.0f / sq.S;
+    }
+  }
+  
+  if (pdfSolidAngle == 0.0f)
+  {
+    lightSample.position = light.position + light.vecU * sample.x + light.vecV * sample.y; // The light sample position in world coordinates.
+  }
+
   lightSample.direction = lightSample.position - point; // Sample direction from surface point to light sample position.
   lightSample.distance  = length(lightSample.direction);
   if (DENOMINATOR_EPSILON < lightSample.distance)
@@ -179,7 +206,8 @@ extern "C" __device__ LightSample __direct_callable__light_parallelogram(LightDe
     {
       // Explicit light sample, must scale the emission by inverse probabilty to hit this light.
       lightSample.emission = light.emission * float(sysData.numLights); 
-      lightSample.pdf      = (lightSample.distance * lightSample.distance) / (light.area * cosTheta); // Solid angle pdf. Assumes light.area != 0.0f.
+      // Solid angle pdf. The area pdf assumes light.area != 0.0f.
+      lightSample.pdf = (0.0f < pdfSolidAngle) ? pdfSolidAngle : (lightSample.distance * lightSample.distance) / (light.area * cosTheta);
     }
   }
 
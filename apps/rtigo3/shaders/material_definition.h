@@ -40,6 +40,7 @@ struct MaterialDefinition
   cudaTextureObject_t textureAlbedo;
   cudaTextureObject_t textureCutout;
   float2              roughness;
+  float2              textureLod; // 0.5f * log2f(width * height) of the albedo (.x) and cutout (.y) texture LOD 0. Offsets the ray cone LOD.
   
   // 4 byte alignment.
   FunctionIndex indexBSDF;  // BSDF index to use in the closest hit program
@@ -50,9 +51,9 @@ struct MaterialDefinition
 
   // Manual padding to 16-byte alignment goes here.
   int pad0;
-  //int pad1;
+  int pad1;
+  int pad2;
   //int pad3;
-  //int pad4;
 };
 
 #endif // MATERIAL_DEFINITION_H
@@ -0,0 +1,143 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef MICROFACET_H
+#define MICROFACET_H
+
+#include "config.h"
+#include "vector_math.h"
+
+// Anisotropic GGX distribution with Smith masking-shadowing and its visible normal sampling for the GGX BxDFs.
+// All vectors are in the local tangent space with the normal along z and the roughness ax along the tangent x.
+
+// "Microfacet Models for Refraction through Rough Surfaces" - Walter, Marschner, Li, Torrance. 2007
+// "Understanding the Masking-Shadowing Function in Microfacet-Based BRDFs" - Eric Heitz. 2014
+// "Sampling the GGX Distribution of Visible Normals" - Eric Heitz. 2018
+
+__forceinline__ __host__ __device__ float distribution_d(const float ax, const float ay, float3 const& wm)
+{
+  if (DENOMINATOR_EPSILON < wm.z) // Heaviside function: X_plus(wm * wg). (wm is in tangent space.)
+  {
+    // Heitz 2014, Formula (85) with tan^2 * cos^2(phi) = x^2 / z^2 and tan^2 * sin^2(phi) = y^2 / z^2.
+    const float x = wm.x / ax;
+    const float y = wm.y / ay;
+    const float term = x * x + y * y + wm.z * wm.z;
+
+    return 1.0f / (M_PIf * ax * ay * term * term);
+  }
+  return 0.0f;
+}
+
+// "Microfacet Models for Refraction through Rough Surfaces" - Walter, Marschner, Li, Torrance.
+// PERF Using this because it's faster than the approximation in Walter, Formula (27).
+__forceinline__ __host__ __device__ float smith_G1(const float alpha, float3 const& w, float3 const& wm)
+{
+  const float w_wm = dot(w, wm);
+  if (w_wm * w.z <= 0.0f) // X_plus(v * m / v * n) from Walter, Formula (34). // PERF Checking the sign with a multiplication here.
+  {
+    return 0.0f;
+  }
+  const float cosThetaSqr = w.z * w.z;
+  const float sinThetaSqr = 1.0f - cosThetaSqr;
+  const float tanThetaSqr = (0.0f < sinThetaSqr) ? sinThetaSqr / cosThetaSqr : 0.0f;
+  const float invASqr = alpha * alpha * tanThetaSqr;
+  return 2.0f / (1.0f + sqrtf(1.0f + invASqr)); // Optimized version is Walter, Formula (34)
+}
+
+// Roughness projected onto the direction w. Heitz 2014, Formula (80).
+__forceinline__ __host__ __device__ float distribution_alpha(const float ax, const float ay, float3 const& w)
+{
+  const float lenSqr = w.x * w.x + w.y * w.y;
+  if (lenSqr <= 0.0f)
+  {
+    return ax; // Along the normal the projected roughness doesn't matter, tan(theta) is zero.
+  }
+  return sqrtf((w.x * w.x * ax * ax + w.y * w.y * ay * ay) / lenSqr); // cos^2(phi) * ax^2 + sin^2(phi) * ay^2
+}
+
+__forceinline__ __host__ __device__ float distribution_G1(const float ax, const float ay, float3 const& w, float3 const& wm)
+{
+  return smith_G1(distribution_alpha(ax, ay, w), w, wm);
+}
+
+// Separable masking-shadowing.
+__forceinline__ __host__ __device__ float distribution_G(const float ax, const float ay, float3 const& wo, float3 const& wi, float3 const& wm)
+{
+  return distribution_G1(ax, ay, wo, wm) * distribution_G1(ax, ay, wi, wm);
+}
+
+// Samples a microfacet normal from the distribution of normals visible from wo. Heitz 2018, Listing 1.
+// wo.z must be positive. Unlike sampling the full distribution, the result never faces away from wo.
+__forceinline__ __host__ __device__ float3 distribution_sample_visible(const float ax, const float ay, float3 const& wo, const float u1, const float u2)
+{
+  // Stretch the view direction to the hemisphere configuration.
+  const float3 vh = normalize(make_float3(ax * wo.x, ay * wo.y, wo.z));
+
+  // Orthonormal basis around vh.
+  const float lenSqr = vh.x * vh.x + vh.y * vh.y;
+  const float3 t1 = (0.0f < lenSqr) ? make_float3(-vh.y, vh.x, 0.0f) / sqrtf(lenSqr) : make_float3(1.0f, 0.0f, 0.0f);
+  const float3 t2 = cross(vh, t1);
+
+  // Uniform disk sample, warped to the projected area of the visible hemisphere.
+  const float r   = sqrtf(u1);
+  const float phi = 2.0f * M_PIf * u2;
+  const float p1  = r * cosf(phi);
+  const float s   = 0.5f * (1.0f + vh.z);
+  const float p2  = (1.0f - s) * sqrtf(fmaxf(0.0f, 1.0f - p1 * p1)) + s * r * sinf(phi);
+
+  // Reproject onto the hemisphere and unstretch.
+  const float3 nh = p1 * t1 + p2 * t2 + sqrtf(fmaxf(0.0f, 1.0f - p1 * p1 - p2 * p2)) * vh;
+
+  return normalize(make_float3(ax * nh.x, ay * nh.y, fmaxf(DENOMINATOR_EPSILON, nh.z)));
+}
+
+// Density of distribution_sample_visible() with respect to the microfacet normal. Heitz 2018, Formula (3).
+__forceinline__ __host__ __device__ float distribution_pdf_visible(const float ax, const float ay, float3 const& wo, float3 const& wm)
+{
+  const float wo_wm = dot(wo, wm);
+  if (wo.z <= 0.0f || wo_wm <= 0.0f)
+  {
+    return 0.0f;
+  }
+  return distribution_G1(ax, ay, wo, wm) * wo_wm * distribution_d(ax, ay, wm) / wo.z;
+}
+
+// Density of the reflected direction wi = reflect(-wo, wm) with respect to the solid angle, including the 1 / (4 * dot(wo, wm)) Jacobian.
+// This is what the GGX BRDF returns from its eval program for MIS.
+__forceinline__ __host__ __device__ float distribution_pdf_reflection(const float ax, const float ay, float3 const& wo, float3 const& wm)
+{
+  if (wo.z <= 0.0f || dot(wo, wm) <= 0.0f)
+  {
+    return 0.0f;
+  }
+  return distribution_G1(ax, ay, wo, wm) * distribution_d(ax, ay, wm) / (4.0f * wo.z);
+}
+
+#endif // MICROFACET_H
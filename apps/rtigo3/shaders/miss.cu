@@ -32,6 +32,7 @@
 
 #include "per_ray_data.h"
 #include "light_definition.h"
+#include "env_format_definition.h"
 #include "shader_common.h"
 #include "system_data.h"
 
@@ -78,7 +79,7 @@ extern "C" __global__ void __miss__env_sphere()
   const float theta = acosf(-R.y);     // theta == 0.0f is south pole, theta == M_PIf is north pole.
   const float v     = theta * M_1_PIf; // Texture is with origin at lower left, v == 0.0f is south pole.
 
-  const float3 emission = make_float3(tex2D<float4>(sysData.envTexture, u, v));
+  const float3 emission = sampleEnvironment(sysData.envTexture, sysData.envFormat, sysData.envWidth, sysData.envHeight, u, v);
 
 #if USE_NEXT_EVENT_ESTIMATION
   float weightMIS = 1.0f;
@@ -61,6 +61,9 @@
 // Set if the material stack is not empty.
 #define FLAG_VOLUME                 0x00001000
 
+// Set by the wavefront trace launch. The closesthit program stores the surface interaction in sysData.wavefront->hits instead of shading it.
+#define FLAG_WAVEFRONT              0x00002000
+
 // Highest bit set means terminate path.
 #define FLAG_TERMINATE              0x80000000
 
@@ -88,6 +91,8 @@ struct PerRayData
   
   // 8-byte alignment
   float2 ior;            // .x = IOR the ray currently is inside, .y = the IOR of the surrounding volume. The IOR of the current material is in absorption_ior.w!
+  uint2  idHit;          // Time view and AOVs only: .x = instance ID + 1, .y = material index + 1 of the first hit. 0 means miss.
+  float2 cone;           // Ray cone for the texture LOD. .x = width at the ray origin, resp. at the hit after the closesthit program, .y = spread angle.
   
   // 4-byte alignment
   float3 pos;            // Current surface hit point or volume sample point, in world space
@@ -107,6 +112,13 @@ struct PerRayData
   float  opacity;        // Cutout opacity result.
 
   unsigned int seed;     // Random number generator input.
+
+  // First hit data for the AOVs. Only written when the corresponding AOV is enabled.
+  float3       aovNormal;
+  float3       aovAlbedo;
+  float3       aovDirect;
+  float        aovDepth;
+  unsigned int aovPrimitive;
 };
 
 
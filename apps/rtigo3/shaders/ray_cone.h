@@ -0,0 +1,89 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef RAY_CONE_H
+#define RAY_CONE_H
+
+#include "config.h"
+#include "vector_math.h"
+
+// Ray cones for the texture level of detail selection. The lens shaders start the cones, the hit programs widen them.
+// A cone is tracked as float2 with .x = cone width at the ray origin and .y = spread angle in radians.
+// "Texture Level of Detail Strategies for Real-Time Ray Tracing" - Akenine-Moeller et al. Ray Tracing Gems. 2019
+// "Improved Shader and Texture Level of Detail Using Ray Cones" - Akenine-Moeller et al. JCGT. 2021
+
+// Cone width after travelling the given distance.
+__forceinline__ __host__ __device__ float rayConeWidth(float2 const& cone, const float distance)
+{
+  return cone.x + cone.y * distance;
+}
+
+// Spread angle of the continued path after a surface interaction.
+// Specular reflections and refractions keep the spread, which ignores the surface curvature.
+// Diffuse and glossy interactions widen the cone to at least RAY_CONE_DIFFUSE_SPREAD.
+__forceinline__ __host__ __device__ float rayConeScatter(const float spread, const bool isDiffuse)
+{
+  return (isDiffuse) ? fmaxf(spread, RAY_CONE_DIFFUSE_SPREAD) : spread;
+}
+
+// Texture independent LOD of the cone footprint on a triangle. Akenine-Moeller 2019, Equation (34).
+// e1, e2 are the world space triangle edges, uv1, uv2 the matching texture coordinate edges.
+// The direction is the normalized ray direction, width the cone width at the hit.
+// Returns -RT_DEFAULT_MAX for degenerate footprints which then select the LOD 0.
+__forceinline__ __host__ __device__ float rayConeLod(float3 const& e1, float3 const& e2, float2 const& uv1, float2 const& uv2,
+                                                     float3 const& direction, const float width)
+{
+  const float3 n  = cross(e1, e2);
+  const float  pa = length(n);                                // Twice the world space triangle area.
+  const float  ta = fabsf(uv1.x * uv2.y - uv2.x * uv1.y);     // Twice the texture space triangle area in normalized texture coordinates.
+
+  if (pa <= 0.0f || ta <= 0.0f || width <= 0.0f)
+  {
+    return -RT_DEFAULT_MAX;
+  }
+
+  const float cosTheta = fmaxf(fabsf(dot(direction, n)) / pa, DENOMINATOR_EPSILON);
+
+  return 0.5f * log2f(ta / pa) + log2f(width / cosTheta);
+}
+
+// Mipmap level for a texture. textureLod is 0.5f * log2f(width * height) of the texture's LOD 0.
+__forceinline__ __host__ __device__ float rayConeMipLevel(const float lod, const float textureLod)
+{
+  return fmaxf(lod + textureLod, 0.0f);
+}
+
+// Spread angle of the pinhole camera's primary rays. V is the half height of the image plane at distance length(W).
+__forceinline__ __host__ __device__ float rayConeSpreadPinhole(float3 const& V, float3 const& W, const float screenHeight)
+{
+  return atanf(2.0f * length(V) / (length(W) * screenHeight));
+}
+
+#endif // RAY_CONE_H
@@ -0,0 +1,97 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+#include <optix.h>
+
+#include "function_indices.h"
+#include "ray_query_data.h"
+
+extern "C" __constant__ QueryParameters queryParameters;
+
+// The hit results are returned directly in the payload registers:
+// p0 = t, p1 = instance ID, p2 = primitive index, p3 = u, p4 = v
+
+extern "C" __global__ void __raygen__ray_query()
+{
+  const unsigned int index = optixGetLaunchIndex().x;
+
+  if (queryParameters.count <= index)
+  {
+    return;
+  }
+
+  const QueryRay ray = queryParameters.rays[index];
+
+  unsigned int p0 = __float_as_uint(-1.0f);
+  unsigned int p1 = QUERY_MISS;
+  unsigned int p2 = QUERY_MISS;
+  unsigned int p3 = 0;
+  unsigned int p4 = 0;
+
+  // Cutout opacity is evaluated by any hit programs which are not part of the query pipeline. All geometry is opaque here.
+  unsigned int flags = OPTIX_RAY_FLAG_DISABLE_ANYHIT;
+  if (ray.flags & QUERY_FLAG_ANY_HIT)
+  {
+    flags |= OPTIX_RAY_FLAG_TERMINATE_ON_FIRST_HIT;
+  }
+
+  // The SBT offset and stride match the instance sbtOffset layout of the renderer, which reserves NUM_RAYTYPES records per instance.
+  optixTrace(queryParameters.topObject,
+             make_float3(ray.origin[0], ray.origin[1], ray.origin[2]),
+             make_float3(ray.direction[0], ray.direction[1], ray.direction[2]),
+             ray.tmin, ray.tmax, 0.0f,
+             OptixVisibilityMask(ray.mask & 0xFF), flags,
+             0, NUM_RAYTYPES, 0,
+             p0, p1, p2, p3, p4);
+
+  QueryHit hit;
+
+  hit.t         = __uint_as_float(p0);
+  hit.instance  = p1;
+  hit.primitive = p2;
+  hit.u         = __uint_as_float(p3);
+  hit.v         = __uint_as_float(p4);
+
+  queryParameters.hits[index] = hit;
+}
+
+
+extern "C" __global__ void __closesthit__ray_query()
+{
+  const float2 barycentrics = optixGetTriangleBarycentrics();
+
+  optixSetPayload_0(__float_as_uint(optixGetRayTmax()));
+  optixSetPayload_1(optixGetInstanceId());
+  optixSetPayload_2(optixGetPrimitiveIndex());
+  optixSetPayload_3(__float_as_uint(barycentrics.x));
+  optixSetPayload_4(__float_as_uint(barycentrics.y));
+}
+
+// The query pipeline uses a miss record without program. The payload registers keep their miss values when nothing is hit.
@@ -0,0 +1,70 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef RAY_QUERY_DATA_H
+#define RAY_QUERY_DATA_H
+
+// Batched ray queries against the loaded scene, independent of the path tracer.
+// Plain data only, so that the host fallback can use these structures without CUDA or OptiX headers.
+
+#define QUERY_FLAG_NONE     0u
+#define QUERY_FLAG_ANY_HIT  1u // Occlusion test. Terminates on the first hit found which isn't necessarily the closest.
+
+#define QUERY_MISS 0xFFFFFFFFu // QueryHit::instance of rays which didn't hit anything.
+
+struct QueryRay
+{
+  float        origin[3];
+  float        tmin;
+  float        direction[3];
+  float        tmax;
+  unsigned int mask;  // Visibility mask. All instances use 0xFF, so 0 disables the ray.
+  unsigned int flags; // QUERY_FLAG_*
+};
+
+struct QueryHit
+{
+  float        t;         // Hit distance in units of the ray direction. -1.0f on miss.
+  unsigned int instance;  // Instance ID of the hit, same as optixGetInstanceId() in the renderer. QUERY_MISS on miss.
+  unsigned int primitive; // Triangle index inside the geometry.
+  float        u;         // Barycentric coordinates of the second and third triangle vertex.
+  float        v;
+};
+
+// Launch parameters of the ray query pipeline.
+struct QueryParameters
+{
+  unsigned long long topObject; // OptixTraversableHandle
+  const QueryRay*    rays;
+  QueryHit*          hits;
+  unsigned int       count;
+};
+
+#endif // RAY_QUERY_DATA_H
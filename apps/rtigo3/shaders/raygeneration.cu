@@ -34,12 +34,37 @@
 #include "per_ray_data.h"
 #include "shader_common.h"
 #include "random_number_generators.h"
+#include "adaptive_roulette.h"
+#include "tile_layout.h"
+
+#include <cuda_fp16.h>
 
 
 extern "C" __constant__ SystemData sysData;
 
 
-__forceinline__ __device__ float3 integrator(PerRayData& prd)
+// Adds the continuation radiance over the throughput of the path depths [first, last] to the roulette statistics.
+// contribution holds the radiance luminance gathered per depth, weight the throughput luminance at the start of each depth.
+__forceinline__ __device__ void recordRouletteStats(const int indexCache, const int first, const int last,
+                                                    const float* contribution, const float* weight)
+{
+  float tail = 0.0f;
+
+  for (int i = ROULETTE_DEPTHS - 1; first <= i; --i)
+  {
+    tail += contribution[i];
+
+    if (i <= last && 0.0f < weight[i])
+    {
+      atomicAdd(&sysData.rouletteStats[indexCache + i].x, tail / weight[i]);
+      atomicAdd(&sysData.rouletteStats[indexCache + i].y, 1.0f);
+    }
+  }
+}
+
+
+// indexCache is the roulette cache index of the pixel's tile. record enables the statistics for this sample.
+__forceinline__ __device__ float3 integrator(PerRayData& prd, const int indexCache, const bool record)
 {
   // This renderer supports nested volumes. Four levels is plenty enough for most cases.
   // The absorption coefficient and IOR of the volume the ray is currently inside.
@@ -58,91 +83,224 @@ __forceinline__ __device__ float3 integrator(PerRayData& prd)
   prd.sigma_t        = make_float3(0.0f);                   // No extinction.
   prd.flags          = 0;
 
-  while (depth < sysData.pathLengths.y)
+  // Adaptive Russian roulette and splitting.
+  const bool  adaptive  = (sysData.rouletteMode != 0);
+  const float reference = (adaptive) ? sysData.rouletteCache[indexCache] : -1.0f; // Expected radiance of the pixel.
+
+  float contribution[ROULETTE_DEPTHS]; // Radiance luminance gathered per depth. Deeper paths add to the last entry.
+  float weight[ROULETTE_DEPTHS];       // Throughput luminance at the start of each depth.
+  int   reached = 0;                   // The deepest depth of the current branch with a valid weight.
+
+  if (adaptive)
   {
-    prd.wo        = -prd.wi;            // Direction to observer.
-    prd.ior       = make_float2(1.0f);  // Reset the volume IORs.
-    prd.distance  = RT_DEFAULT_MAX;     // Shoot the next ray with maximum length.
-    prd.flags    &= FLAG_CLEAR_MASK;    // Clear all non-persistent flags. In this demo only the last diffuse surface interaction stays.
+    for (int i = 0; i < ROULETTE_DEPTHS; ++i)
+    {
+      contribution[i] = 0.0f;
+    }
+  }
 
-    // Special case for volume handling.
-    if (MATERIAL_STACK_FIRST <= stackIdx) // Inside a volume?
+  // A split path continues with the current branch and replays the remaining ones from this saved state afterwards.
+  // Only one split can be pending. The branches retrace the same ray and differ in the light and BSDF samples at its hit.
+  int    splitCount = 0;  // Remaining branches.
+  int    splitDepth = 0;  // The depth of the saved ray.
+  float3 splitPos;
+  float3 splitWi;
+  float3 splitThroughput;
+  float2 splitCone;
+  float  splitPdf;
+  unsigned int splitFlags;
+  int    splitStackIdx;
+  float4 splitStack[MATERIAL_STACK_SIZE];
+
+  while (true) // Once per branch.
+  {
+    while (depth < sysData.pathLengths.y)
     {
-      prd.flags  |= FLAG_VOLUME;                            // Indicate that we're inside a volume. => At least absorption calculation needs to happen.
-      prd.sigma_t = make_float3(absorptionStack[stackIdx]); // There is only volume absorption in this demo, no volume scattering.
-      prd.ior.x   = absorptionStack[stackIdx].w;            // The IOR of the volume we're inside. Needed for eta calculations in transparent materials.
-      if (MATERIAL_STACK_FIRST <= stackIdx - 1)
+      if (adaptive && depth < ROULETTE_DEPTHS)
       {
-        prd.ior.y = absorptionStack[stackIdx - 1].w; // The IOR of the surrounding volume.
+        weight[depth] = luminance(throughput);
+        reached       = depth;
       }
-    }
 
-    // Put payload pointer into two unsigned integers. Actually const, but that's not what optixTrace() expects.
-    uint2 payload = splitPointer(&prd);
+      prd.wo        = -prd.wi;            // Direction to observer.
+      prd.ior       = make_float2(1.0f);  // Reset the volume IORs.
+      prd.distance  = RT_DEFAULT_MAX;     // Shoot the next ray with maximum length.
+      prd.flags    &= FLAG_CLEAR_MASK;    // Clear all non-persistent flags. In this demo only the last diffuse surface interaction stays.
 
-    // Note that the primary rays (or volume scattering miss cases) wouldn't normally offset the ray t_min by sysSceneEpsilon. Keep it simple here.
-    optixTrace(sysData.topObject,
-               prd.pos, prd.wi, // origin, direction
-               sysData.sceneEpsilon, prd.distance, 0.0f, // tmin, tmax, time
-               OptixVisibilityMask(0xFF), OPTIX_RAY_FLAG_NONE, 
-               RAYTYPE_RADIANCE, NUM_RAYTYPES, RAYTYPE_RADIANCE,
-               payload.x, payload.y);
+      // Special case for volume handling.
+      if (MATERIAL_STACK_FIRST <= stackIdx) // Inside a volume?
+      {
+        prd.flags  |= FLAG_VOLUME;                            // Indicate that we're inside a volume. => At least absorption calculation needs to happen.
+        prd.sigma_t = make_float3(absorptionStack[stackIdx]); // There is only volume absorption in this demo, no volume scattering.
+        prd.ior.x   = absorptionStack[stackIdx].w;            // The IOR of the volume we're inside. Needed for eta calculations in transparent materials.
+        if (MATERIAL_STACK_FIRST <= stackIdx - 1)
+        {
+          prd.ior.y = absorptionStack[stackIdx - 1].w; // The IOR of the surrounding volume.
+        }
+      }
 
-    // This renderer supports nested volumes.
-    if (prd.flags & FLAG_VOLUME) // We're inside a volume?
-    {
-      // We're inside a volume. Calculate the extinction along the current path segment in any case.
-      // The transmittance along the current path segment inside a volume needs to attenuate the ray throughput with the extinction
-      // before it modulates the radiance of the hitpoint.
-      throughput *= expf(-prd.distance * prd.sigma_t);
-    }
+      // Put payload pointer into two unsigned integers. Actually const, but that's not what optixTrace() expects.
+      uint2 payload = splitPointer(&prd);
 
-    radiance += throughput * prd.radiance;
+      // Note that the primary rays (or volume scattering miss cases) wouldn't normally offset the ray t_min by sysSceneEpsilon. Keep it simple here.
+      optixTrace(sysData.topObject,
+                 prd.pos, prd.wi, // origin, direction
+                 sysData.sceneEpsilon, prd.distance, 0.0f, // tmin, tmax, time
+                 OptixVisibilityMask(0xFF), OPTIX_RAY_FLAG_NONE, 
+                 RAYTYPE_RADIANCE, NUM_RAYTYPES, RAYTYPE_RADIANCE,
+                 payload.x, payload.y);
 
-    // Path termination by miss shader or sample() routines.
-    // If terminate is true, f_over_pdf and pdf might be undefined.
-    if ((prd.flags & FLAG_TERMINATE) || prd.pdf <= 0.0f || isNull(prd.f_over_pdf))
-    {
-      break;
-    }
+      // This renderer supports nested volumes.
+      if (prd.flags & FLAG_VOLUME) // We're inside a volume?
+      {
+        // We're inside a volume. Calculate the extinction along the current path segment in any case.
+        // The transmittance along the current path segment inside a volume needs to attenuate the ray throughput with the extinction
+        // before it modulates the radiance of the hitpoint.
+        throughput *= expf(-prd.distance * prd.sigma_t);
+      }
 
-    // PERF f_over_pdf already contains the proper throughput adjustment for diffuse materials: f * (fabsf(dot(prd.wi, state.normal)) / prd.pdf);
-    throughput *= prd.f_over_pdf;
+      radiance += throughput * prd.radiance;
 
-    // Unbiased Russian Roulette path termination.
-    if (sysData.pathLengths.x <= depth) // Start termination after a minimum number of bounces.
-    {
-      const float probability = fmaxf(throughput); // DEBUG Other options: // intensity(throughput); // fminf(0.5f, intensity(throughput));
-      if (probability < rng(prd.seed)) // Paths with lower probability to continue are terminated earlier.
+      if (adaptive)
+      {
+        contribution[min(depth, ROULETTE_DEPTHS - 1)] += luminance(throughput * prd.radiance);
+      }
+
+      if (depth == 0 && (sysData.aovMask & AOV_DIRECT)) // Everything gathered at the primary hit is direct lighting.
+      {
+        prd.aovDirect = radiance;
+      }
+
+      // Path termination by miss shader or sample() routines.
+      // If terminate is true, f_over_pdf and pdf might be undefined.
+      if ((prd.flags & FLAG_TERMINATE) || prd.pdf <= 0.0f || isNull(prd.f_over_pdf))
       {
         break;
       }
-      throughput /= probability; // Path isn't terminated. Adjust the throughput so that the average is right again.
-    }
 
-    // Adjust the material volume stack if the geometry is not thin-walled but a border between two volumes and
-    // the outgoing ray direction was a transmission.
-    if ((prd.flags & (FLAG_THINWALLED | FLAG_TRANSMISSION)) == FLAG_TRANSMISSION)
-    {
-      // Transmission.
-      if (prd.flags & FLAG_FRONTFACE) // Entered a new volume?
+      // PERF f_over_pdf already contains the proper throughput adjustment for diffuse materials: f * (fabsf(dot(prd.wi, state.normal)) / prd.pdf);
+      throughput *= prd.f_over_pdf;
+
+      // Expected radiance of the next path segment relative to the pixel estimate. Negative when the cache entries aren't valid yet.
+      const float expected = (0.0f < reference) ? sysData.rouletteCache[indexCache + min(depth + 1, ROULETTE_DEPTHS - 1)] : -1.0f;
+
+      int branches = 1;
+
+      if (0.0f <= expected)
       {
-        // Push the entered material's volume properties onto the volume stack.
-        //rtAssert((stackIdx < MATERIAL_STACK_LAST), 1); // Overflow?
-        stackIdx = min(stackIdx + 1, MATERIAL_STACK_LAST);
+        const float factor = rouletteFactor(luminance(throughput) * expected, reference);
+
+        if (factor < 1.0f)
+        {
+          // Russian Roulette with the adaptive survival probability, still only after the minimum number of bounces.
+          if (sysData.pathLengths.x <= depth)
+          {
+            if (factor < rng(prd.seed))
+            {
+              break;
+            }
+            throughput /= factor;
+          }
+        }
+        else if (1.0f < factor && splitCount == 0 && depth + 1 < min(sysData.pathLengths.y, ROULETTE_DEPTHS))
+        {
+          // Splitting. All branches get the weight 1.0f / factor and the number of branches matches factor on average.
+          branches = rouletteBranches(factor, rng(prd.seed));
+          throughput /= factor;
+        }
+      }
+      // Unbiased Russian Roulette path termination.
+      else if (sysData.pathLengths.x <= depth) // Start termination after a minimum number of bounces.
+      {
+        const float probability = fmaxf(throughput); // DEBUG Other options: // intensity(throughput); // fminf(0.5f, intensity(throughput));
+        if (probability < rng(prd.seed)) // Paths with lower probability to continue are terminated earlier.
+        {
+          break;
+        }
+        throughput /= probability; // Path isn't terminated. Adjust the throughput so that the average is right again.
+      }
 
-        absorptionStack[stackIdx] = prd.absorption_ior;
+      // Adjust the material volume stack if the geometry is not thin-walled but a border between two volumes and
+      // the outgoing ray direction was a transmission.
+      if ((prd.flags & (FLAG_THINWALLED | FLAG_TRANSMISSION)) == FLAG_TRANSMISSION)
+      {
+        // Transmission.
+        if (prd.flags & FLAG_FRONTFACE) // Entered a new volume?
+        {
+          // Push the entered material's volume properties onto the volume stack.
+          //rtAssert((stackIdx < MATERIAL_STACK_LAST), 1); // Overflow?
+          stackIdx = min(stackIdx + 1, MATERIAL_STACK_LAST);
+
+          absorptionStack[stackIdx] = prd.absorption_ior;
+        }
+        else // Exited the current volume?
+        {
+          // Pop the top of stack material volume.
+          // This assert fires and is intended because I tuned the frontface checks so that there are more exits than enters at silhouettes.
+          //rtAssert((MATERIAL_STACK_EMPTY < stackIdx), 0); // Underflow?
+          stackIdx = max(stackIdx - 1, MATERIAL_STACK_EMPTY);
+        }
       }
-      else // Exited the current volume?
+
+      ++depth; // Next path segment.
+
+      if (1 < branches) // Save the next ray for the remaining branches.
+      {
+        splitCount      = branches - 1;
+        splitDepth      = depth;
+        splitPos        = prd.pos;
+        splitWi         = prd.wi;
+        splitThroughput = throughput;
+        splitCone       = prd.cone;
+        splitPdf        = prd.pdf;
+        splitFlags      = prd.flags;
+        splitStackIdx   = stackIdx;
+        for (int i = MATERIAL_STACK_FIRST; i <= stackIdx; ++i)
+        {
+          splitStack[i] = absorptionStack[i];
+        }
+      }
+    }
+
+    if (!adaptive)
+    {
+      break;
+    }
+
+    if (splitCount == 0) // Last branch. All depths up to the end of this branch have their complete continuation now.
+    {
+      if (record)
       {
-        // Pop the top of stack material volume.
-        // This assert fires and is intended because I tuned the frontface checks so that there are more exits than enters at silhouettes.
-        //rtAssert((MATERIAL_STACK_EMPTY < stackIdx), 0); // Underflow?
-        stackIdx = max(stackIdx - 1, MATERIAL_STACK_EMPTY);
+        recordRouletteStats(indexCache, 0, reached, contribution, weight);
       }
+      break;
     }
 
-    ++depth; // Next path segment.
+    // The depths from splitDepth on are finished for this branch. The shared depths before receive the branch's radiance.
+    if (record)
+    {
+      recordRouletteStats(indexCache, splitDepth, reached, contribution, weight);
+    }
+    for (int i = splitDepth; i < ROULETTE_DEPTHS; ++i)
+    {
+      contribution[splitDepth - 1] += contribution[i];
+      contribution[i] = 0.0f;
+    }
+
+    // Continue with the next branch.
+    --splitCount;
+    depth      = splitDepth;
+    throughput = splitThroughput;
+    prd.pos    = splitPos;
+    prd.wi     = splitWi;
+    prd.cone   = splitCone;
+    prd.pdf    = splitPdf;
+    prd.flags  = splitFlags;
+    stackIdx   = splitStackIdx;
+    for (int i = MATERIAL_STACK_FIRST; i <= stackIdx; ++i)
+    {
+      absorptionStack[i] = splitStack[i];
+    }
   }
   
   return radiance;
@@ -164,17 +322,124 @@ __forceinline__ __device__ unsigned int distribute(const uint2 launchIndex)
 }
 
 
+// Accumulates the clock cycles spent on this pixel into the resolution sized timeBuffer, stores the primary hit IDs into the idBuffer
+// and returns the scaled cost for the color ramp display in the output alpha channel.
+// Each device only writes the pixels it rendered, the host sums the per device buffers which are cleared on allocation.
+__forceinline__ __device__ float timeView(const unsigned int indexPixel, const long long clockBegin, const uint2 idHit)
+{
+  float* cycles = reinterpret_cast<float*>(sysData.timeBuffer);
+
+  float cost = float(clock64() - clockBegin);
+
+  if (0 < sysData.iterationIndex)
+  {
+    cost = lerp(cycles[indexPixel], cost, 1.0f / float(sysData.iterationIndex + 1));
+  }
+  cycles[indexPixel] = cost;
+
+  reinterpret_cast<uint2*>(sysData.idBuffer)[indexPixel] = idHit; // Primary hit of the most recent sample.
+
+  return cost * sysData.clockScale;
+}
+
+
+__forceinline__ __device__ ushort4 packHalf4(const float3 v)
+{
+  return make_ushort4(__half_as_ushort(__float2half_rn(v.x)),
+                      __half_as_ushort(__float2half_rn(v.y)),
+                      __half_as_ushort(__float2half_rn(v.z)),
+                      __half_as_ushort(__float2half_rn(1.0f)));
+}
+
+__forceinline__ __device__ float3 unpackHalf4(const ushort4 v)
+{
+  return make_float3(__half2float(__ushort_as_half(v.x)),
+                     __half2float(__ushort_as_half(v.y)),
+                     __half2float(__ushort_as_half(v.z)));
+}
+
+__forceinline__ __device__ void initAovs(PerRayData& prd)
+{
+  if (sysData.aovMask)
+  {
+    prd.aovNormal    = make_float3(0.0f);
+    prd.aovAlbedo    = make_float3(0.0f);
+    prd.aovDirect    = make_float3(0.0f);
+    prd.aovDepth     = 0.0f;
+    prd.aovPrimitive = 0;
+  }
+}
+
+// Writes the enabled AOVs of this sample. Uses the same progressive accumulation as the beauty output.
+// Depth and IDs are not meant to be filtered and only keep the first sample.
+// Each bit test is a compile time constant in specialized pipelines.
+__forceinline__ __device__ void writeAovs(const unsigned int indexPixel, PerRayData const& prd)
+{
+  const bool  first  = (sysData.iterationIndex == 0);
+  const float weight = 1.0f / float(sysData.iterationIndex + 1);
+
+  if ((sysData.aovMask & AOV_DEPTH) && first)
+  {
+    reinterpret_cast<float*>(sysData.aovBuffers[AOV_INDEX_DEPTH])[indexPixel] = prd.aovDepth;
+  }
+  if (sysData.aovMask & AOV_NORMAL)
+  {
+    ushort4* buffer = reinterpret_cast<ushort4*>(sysData.aovBuffers[AOV_INDEX_NORMAL]);
+    buffer[indexPixel] = packHalf4((first) ? prd.aovNormal : lerp(unpackHalf4(buffer[indexPixel]), prd.aovNormal, weight));
+  }
+  if (sysData.aovMask & AOV_ALBEDO)
+  {
+    ushort4* buffer = reinterpret_cast<ushort4*>(sysData.aovBuffers[AOV_INDEX_ALBEDO]);
+    buffer[indexPixel] = packHalf4((first) ? prd.aovAlbedo : lerp(unpackHalf4(buffer[indexPixel]), prd.aovAlbedo, weight));
+  }
+  if ((sysData.aovMask & AOV_INSTANCE) && first)
+  {
+    reinterpret_cast<unsigned int*>(sysData.aovBuffers[AOV_INDEX_INSTANCE])[indexPixel] = prd.idHit.x;
+  }
+  if ((sysData.aovMask & AOV_MATERIAL) && first)
+  {
+    reinterpret_cast<unsigned int*>(sysData.aovBuffers[AOV_INDEX_MATERIAL])[indexPixel] = prd.idHit.y;
+  }
+  if ((sysData.aovMask & AOV_PRIMITIVE) && first)
+  {
+    reinterpret_cast<unsigned int*>(sysData.aovBuffers[AOV_INDEX_PRIMITIVE])[indexPixel] = prd.aovPrimitive;
+  }
+  if (sysData.aovMask & AOV_DIRECT)
+  {
+    float4* buffer = reinterpret_cast<float4*>(sysData.aovBuffers[AOV_INDEX_DIRECT]);
+    const float3 direct = (first) ? prd.aovDirect : lerp(make_float3(buffer[indexPixel]), prd.aovDirect, weight);
+    buffer[indexPixel] = make_float4(direct, 1.0f);
+  }
+}
+
+
 extern "C" __global__ void __raygen__path_tracer()
 {
-#if USE_TIME_VIEW
-  clock_t clockBegin = clock();
-#endif
+  const long long clockBegin = (sysData.timeView) ? clock64() : 0;
 
   const uint2 theLaunchIndex = make_uint2(optixGetLaunchIndex());
   
   unsigned int launchColumn = theLaunchIndex.x;
 
-  if (1 < sysData.deviceCount) // Multi-GPU distribution required?
+  float2 screen   = make_float2(sysData.resolution); // == theLaunchDim for rendering strategy RS_SINGLE_GPU.
+  int2   origin   = make_int2(0, 0);
+  int    idCamera = 0;
+
+  if (0 < sysData.numViews) // Multi-view rendering? The launch depth selects the view. Each device renders whole views.
+  {
+    const ViewDefinition view = sysData.viewDefinitions[sysData.viewOffset + optixGetLaunchIndex().z * sysData.deviceCount];
+
+    // The launch is sized to the biggest view.
+    if (view.size.x <= theLaunchIndex.x || view.size.y <= theLaunchIndex.y)
+    {
+      return;
+    }
+
+    screen   = make_float2(view.size);
+    origin   = view.origin;
+    idCamera = view.idCamera;
+  }
+  else if (1 < sysData.deviceCount) // Multi-GPU distribution required?
   {
     launchColumn = distribute(theLaunchIndex); // Calculate mapping from launch index to pixel index.
     if (sysData.resolution.x <= launchColumn)  // Check if the launchColumn is outside the resolution.
@@ -185,25 +450,32 @@ extern "C" __global__ void __raygen__path_tracer()
 
   PerRayData prd;
 
-  const uint2 theLaunchDim = make_uint2(optixGetLaunchDimensions()); // For multi-GPU tiling this is (resolution + deviceCount - 1) / deviceCount.
+  // Linear index of the output buffer pixel. The view origin is zero in single view rendering.
+  const unsigned int indexPixel = (theLaunchIndex.y + origin.y) * sysData.resolution.x + launchColumn + origin.x;
 
-  // Initialize the random number generator seed from the linear pixel index and the iteration index.
-  const unsigned int seedIndex = theLaunchDim.x * theLaunchIndex.y + launchColumn * sysData.deviceCount + sysData.deviceIndex;
-  prd.seed = tea<4>(seedIndex, sysData.iterationIndex); // PERF This template really generates a lot of instructions.
+  // Initialize the random number generator seed from the linear pixel index and the global sample index.
+  // Neither depends on the device count or the device which renders the pixel, so all strategies produce the same image.
+  prd.seed = tea<4>(indexPixel, sysData.sampleOffset + sysData.iterationIndex); // PERF This template really generates a lot of instructions.
 
   // Decoupling the pixel coordinates from the screen size will allow for partial rendering algorithms.
-  // Resolution is the actual full rendering resolution and for the single GPU strategy, theLaunchDim == resolution.
-  const float2 screen = make_float2(sysData.resolution); // == theLaunchDim for rendering strategy RS_SINGLE_GPU.
+  // The screen is the full rendering resolution, or the view resolution in multi-view rendering.
   const float2 pixel  = make_float2(launchColumn, theLaunchIndex.y);
   const float2 sample = rng2(prd.seed); // Random per pixel jitter.
 
   // Lens shaders
-  const LensRay ray = optixDirectCall<LensRay, const float2, const float2, const float2>(sysData.lensShader, screen, pixel, sample);
+  const LensRay ray = optixDirectCall<LensRay, const float2, const float2, const float2, const int>(sysData.lensShader, screen, pixel, sample, idCamera);
+
+  prd.pos   = ray.org;
+  prd.wi    = ray.dir;
+  prd.cone  = make_float2(0.0f, ray.spread); // Pinpoint ray origin.
+  prd.idHit = make_uint2(0, 0); // Only written by the closesthit program when the time view or the AOVs are enabled.
+  initAovs(prd);
 
-  prd.pos = ray.org;
-  prd.wi  = ray.dir;
+  // The roulette cache tiles the resolution. Only every fourth pixel records statistics to keep the atomic contention low.
+  const uint2 pixelCache = make_uint2(launchColumn + origin.x, theLaunchIndex.y + origin.y);
+  const int   indexCache = (sysData.rouletteMode) ? rouletteIndex(sysData.rouletteTiles, pixelCache.x, pixelCache.y) : 0;
 
-  float3 radiance = integrator(prd);
+  float3 radiance = integrator(prd, indexCache, ((pixelCache.x | pixelCache.y) & 1) == 0);
 
 #if USE_DEBUG_EXCEPTIONS
   // DEBUG Highlight numerical errors.
@@ -228,42 +500,36 @@ extern "C" __global__ void __raygen__path_tracer()
     // The outputBuffer is a CUdeviceptr to allow different formats.
     // DAR FIXME Implement half4 support.
     float4* buffer = reinterpret_cast<float4*>(sysData.outputBuffer);
-    // Note that the launch dimension is independent of resolution in some rendering strategies.
-    const unsigned int index = theLaunchIndex.y * sysData.resolution.x + launchColumn;
 
-#if USE_TIME_VIEW
-    clock_t clockEnd = clock(); 
-    const float alpha = (clockEnd - clockBegin) * sysData.clockScale;
+    float alpha = 1.0f; // Alpha stays 1.0f unless the time view is enabled.
 
-    float4 result = make_float4(radiance, alpha);
-
-    if (0 < sysData.iterationIndex)
+    if (sysData.timeView)
     {
-      const float4 dst = buffer[index]; // RGBA32F
-      result = lerp(dst, result, 1.0f / float(sysData.iterationIndex + 1)); // Accumulate the alpha as well.
+      alpha = timeView(indexPixel, clockBegin, prd.idHit);
     }
-    // iterationIndex 0 will fill the buffer.
-    // If this isn't done separately, the result of the lerp() above is undefined, e.g. dst could be NaN.
-    buffer[index] = result;
-#else
+
+    writeAovs(indexPixel, prd);
+
+    // Only the accumulation can be tile ordered. The seed and the other resolution sized buffers always use the linear index.
+    const unsigned int indexOutput = (sysData.accumulationLayout == ACCUMULATION_LAYOUT_TILED)
+                                   ? tiledIndex(pixelCache.x, pixelCache.y, tileCount(sysData.resolution, sysData.tileShift).x, sysData.tileShift)
+                                   : indexPixel;
+
     if (0 < sysData.iterationIndex)
     {
-      const float4 dst = buffer[index]; // RGBA32F
-      radiance = lerp(make_float3(dst), radiance, 1.0f / float(sysData.iterationIndex + 1)); // Only accumulate the radiance, alpha stays 1.0f.
+      const float4 dst = buffer[indexOutput]; // RGBA32F
+      radiance = lerp(make_float3(dst), radiance, 1.0f / float(sysData.iterationIndex + 1)); // Only accumulate the radiance. The time view alpha is accumulated in timeBuffer.
     }
     // iterationIndex 0 will fill the buffer.
     // If this isn't done separately, the result of the lerp() above is undefined, e.g. dst could be NaN.
-    buffer[index] = make_float4(radiance, 1.0f);
-#endif
+    buffer[indexOutput] = make_float4(radiance, alpha);
   }
 }
 
 
 extern "C" __global__ void __raygen__path_tracer_local_copy()
 {
-#if USE_TIME_VIEW
-  clock_t clockBegin = clock();
-#endif
+  const long long clockBegin = (sysData.timeView) ? clock64() : 0;
 
   const uint2 theLaunchIndex = make_uint2(optixGetLaunchIndex());
   
@@ -282,9 +548,11 @@ extern "C" __global__ void __raygen__path_tracer_local_copy()
 
   const uint2 theLaunchDim = make_uint2(optixGetLaunchDimensions()); // For multi-GPU tiling this is (resolution + deviceCount - 1) / deviceCount.
 
-  // Initialize the random number generator seed from some unique pixel index and the iteration index.
-  const unsigned int seedIndex = theLaunchDim.x * theLaunchIndex.y + launchColumn * sysData.deviceCount + sysData.deviceIndex;
-  prd.seed = tea<4>(seedIndex, sysData.iterationIndex); // PERF This template really generates a lot of instructions.
+  // Linear index of the pixel in the resolution sized buffers.
+  const unsigned int indexPixel = theLaunchIndex.y * sysData.resolution.x + launchColumn;
+
+  // Device count invariant seeding from the pixel and the global sample index like in __raygen__path_tracer.
+  prd.seed = tea<4>(indexPixel, sysData.sampleOffset + sysData.iterationIndex); // PERF This template really generates a lot of instructions.
 
   // Decoupling the pixel coordinates from the screen size will allow for partial rendering algorithms.
   // Resolution is the actual full rendering resolution and for the single GPU strategy, theLaunchDim == resolution.
@@ -293,12 +561,17 @@ extern "C" __global__ void __raygen__path_tracer_local_copy()
   const float2 sample = rng2(prd.seed); // Random per pixel jitter.
 
   // Lens shaders
-  const LensRay ray = optixDirectCall<LensRay, const float2, const float2, const float2>(sysData.lensShader, screen, pixel, sample);
+  const LensRay ray = optixDirectCall<LensRay, const float2, const float2, const float2, const int>(sysData.lensShader, screen, pixel, sample, 0); // Multi-view rendering is not supported by this strategy.
 
-  prd.pos = ray.org;
-  prd.wi  = ray.dir;
+  prd.pos   = ray.org;
+  prd.wi    = ray.dir;
+  prd.cone  = make_float2(0.0f, ray.spread); // Pinpoint ray origin.
+  prd.idHit = make_uint2(0, 0); // Only written by the closesthit program when the time view or the AOVs are enabled.
+  initAovs(prd);
 
-  float3 radiance = integrator(prd);
+  const int indexCache = (sysData.rouletteMode) ? rouletteIndex(sysData.rouletteTiles, launchColumn, theLaunchIndex.y) : 0;
+
+  float3 radiance = integrator(prd, indexCache, ((launchColumn | theLaunchIndex.y) & 1) == 0);
 
 #if USE_DEBUG_EXCEPTIONS
   // DEBUG Highlight numerical errors.
@@ -324,28 +597,28 @@ extern "C" __global__ void __raygen__path_tracer_local_copy()
     float4* buffer = reinterpret_cast<float4*>(sysData.texelBuffer); // This is a per device launch sized buffer in this renderer strategy.
 
     // This renderer write the results into individual launch sized local buffers and composites them in a separate native CUDA kernel.
-    const unsigned int index = theLaunchIndex.y * theLaunchDim.x + theLaunchIndex.x;
-
-#if USE_TIME_VIEW
-    clock_t clockEnd = clock(); 
-    const float alpha = (clockEnd - clockBegin) * sysData.clockScale;
+    // The launch width is a multiple of the tile width, so the launch tiles of the tiled layout are exactly the image tiles this device owns.
+    const unsigned int index = (sysData.accumulationLayout == ACCUMULATION_LAYOUT_TILED)
+                             ? tiledIndex(theLaunchIndex.x, theLaunchIndex.y, theLaunchDim.x >> sysData.tileShift.x, sysData.tileShift)
+                             : theLaunchIndex.y * theLaunchDim.x + theLaunchIndex.x;
 
-    float4 result = make_float4(radiance, alpha);
+    float alpha = 1.0f; // Alpha stays 1.0f unless the time view is enabled.
 
-    if (0 < sysData.iterationIndex)
+    if (sysData.timeView)
     {
-      const float4 dst = buffer[index]; // RGBA32F
-      result = lerp(dst, result, 1.0f / float(sysData.iterationIndex + 1)); // Accumulate the alpha as well.
+      // The time view buffers are resolution sized in all strategies, so this uses the pixel index, not the texel index.
+      alpha = timeView(indexPixel, clockBegin, prd.idHit);
     }
-    buffer[index] = result;
-#else
+
+    // The AOV buffers are resolution sized as well.
+    writeAovs(indexPixel, prd);
+
     if (0 < sysData.iterationIndex)
     {
       const float4 dst = buffer[index]; // RGBA32F
-      radiance = lerp(make_float3(dst), radiance, 1.0f / float(sysData.iterationIndex + 1)); // Only accumulate the radiance, alpha stays 1.0f.
+      radiance = lerp(make_float3(dst), radiance, 1.0f / float(sysData.iterationIndex + 1)); // Only accumulate the radiance. The time view alpha is accumulated in timeBuffer.
     }
-    buffer[index] = make_float4(radiance, 1.0f);
-#endif
+    buffer[index] = make_float4(radiance, alpha);
   }
 }
 
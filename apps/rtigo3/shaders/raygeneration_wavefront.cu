@@ -0,0 +1,391 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+#include <optix.h>
+
+#include "system_data.h"
+#include "per_ray_data.h"
+#include "function_indices.h"
+#include "material_definition.h"
+#include "light_definition.h"
+#include "shader_common.h"
+#include "random_number_generators.h"
+#include "ray_cone.h"
+#include "wavefront_definition.h"
+
+
+extern "C" __constant__ SystemData sysData;
+
+// Ray generation programs of the wavefront strategy. They implement the same path tracer as the integrator() in raygeneration.cu,
+// split into one launch per step. The path state lives in the sysData.wavefront buffers between the launches.
+// All launches are sized to the number of paths and read the actual queue sizes from the device counters.
+
+
+// Sets the volume related PerRayData fields from the path's nested material stack like the integrator does before each optixTrace().
+__forceinline__ __device__ void loadVolume(WavefrontData const& wf, const unsigned int indexPath, PerRayData& prd)
+{
+  prd.ior     = make_float2(1.0f);
+  prd.sigma_t = make_float3(0.0f);
+
+  const int stackIdx = wf.stackIndex[indexPath];
+
+  if (MATERIAL_STACK_FIRST <= stackIdx) // Inside a volume?
+  {
+    const float4 top = wf.absorptionStack[stackIdx * wf.capacity + indexPath];
+
+    prd.flags  |= FLAG_VOLUME;
+    prd.sigma_t = make_float3(top);
+    prd.ior.x   = top.w;
+    if (MATERIAL_STACK_FIRST <= stackIdx - 1)
+    {
+      prd.ior.y = wf.absorptionStack[(stackIdx - 1) * wf.capacity + indexPath].w;
+    }
+  }
+}
+
+
+// Launched with the resolution. Initializes one path per pixel and fills the first ray queue.
+extern "C" __global__ void __raygen__wavefront_generate()
+{
+  WavefrontData const& wf = *sysData.wavefront;
+
+  const uint2 theLaunchIndex = make_uint2(optixGetLaunchIndex());
+
+  const unsigned int indexPath = theLaunchIndex.y * sysData.resolution.x + theLaunchIndex.x; // The linear pixel index.
+
+  // Same seed and primary ray as the __raygen__path_tracer.
+  unsigned int seed = tea<4>(indexPath, sysData.sampleOffset + sysData.iterationIndex);
+
+  const float2 screen = make_float2(sysData.resolution);
+  const float2 pixel  = make_float2(theLaunchIndex);
+  const float2 sample = rng2(seed);
+
+  const LensRay ray = optixDirectCall<LensRay, const float2, const float2, const float2, const int>(sysData.lensShader, screen, pixel, sample, 0); // Multi-view rendering is not supported by this strategy.
+
+  wf.position[indexPath]   = make_float4(ray.org, 0.0f);
+  wf.direction[indexPath]  = make_float4(ray.dir, ray.spread);
+  wf.throughput[indexPath] = make_float4(1.0f, 1.0f, 1.0f, 0.0f); // Pinpoint ray origin, the ray cone width is zero.
+  wf.radiance[indexPath]   = make_float4(0.0f);
+  wf.stackIndex[indexPath] = MATERIAL_STACK_EMPTY; // Assumes that the primary ray starts in vacuum.
+  wf.flags[indexPath]      = 0;
+  wf.seed[indexPath]       = seed;
+
+  wf.rayQueue[0][indexPath] = indexPath; // The wavefront_reset kernel set the queue size to the number of paths.
+}
+
+
+// Traces the queued rays. Misses and light hits add their emission and end the path.
+// All other hits are stored by the closesthit program and get a shading key for the sort.
+extern "C" __global__ void __raygen__wavefront_trace()
+{
+  WavefrontData const& wf = *sysData.wavefront;
+
+  const unsigned int slot   = optixGetLaunchIndex().x;
+  const unsigned int parity = wf.counters->parity;
+
+  if (wf.counters->rays[parity] <= slot)
+  {
+    return;
+  }
+
+  const unsigned int indexPath = wf.rayQueue[parity][slot];
+
+  const float4 position  = wf.position[indexPath];
+  const float4 direction = wf.direction[indexPath];
+
+  float4 throughput = wf.throughput[indexPath];
+
+  PerRayData prd;
+
+  prd.pos      = make_float3(position);
+  prd.pdf      = position.w;
+  prd.wi       = make_float3(direction);
+  prd.wo       = -prd.wi;
+  prd.cone     = make_float2(throughput.w, direction.w);
+  prd.distance = RT_DEFAULT_MAX;
+  prd.flags    = wf.flags[indexPath] | FLAG_WAVEFRONT;
+  prd.seed     = wf.seed[indexPath];
+  prd.idHit    = make_uint2(1, 1); // Not a primary hit for the closesthit program. The time view and AOVs aren't written by this strategy.
+
+  loadVolume(wf, indexPath, prd);
+
+  uint2 payload = splitPointer(&prd);
+
+  optixTrace(sysData.topObject,
+             prd.pos, prd.wi, // origin, direction
+             sysData.sceneEpsilon, prd.distance, 0.0f, // tmin, tmax, time
+             OptixVisibilityMask(0xFF), OPTIX_RAY_FLAG_NONE, 
+             RAYTYPE_RADIANCE, NUM_RAYTYPES, RAYTYPE_RADIANCE,
+             payload.x, payload.y);
+
+  if (prd.flags & FLAG_VOLUME)
+  {
+    throughput *= make_float4(expf(-prd.distance * prd.sigma_t), 1.0f);
+  }
+
+  if (prd.flags & FLAG_TERMINATE) // Missed or hit a light.
+  {
+    wf.radiance[indexPath] += make_float4(make_float3(throughput) * prd.radiance, 0.0f);
+    wf.hitKeys[slot] = WAVEFRONT_KEY_NONE;
+    return;
+  }
+
+  throughput.w = prd.cone.x; // The closesthit program advanced the ray cone width to the hit.
+
+  wf.throughput[indexPath] = throughput;
+  wf.seed[indexPath]       = prd.seed; // The cutout opacity anyhit program consumes random numbers.
+
+  WavefrontHit& hit = wf.hits[slot];
+
+  hit.indexPath = indexPath;
+
+  wf.hitKeys[slot] = sysData.materialDefinitions[hit.materialIndex].indexBSDF;
+}
+
+
+// Launched over the hits sorted by BSDF, so that the threads of a warp mostly call the same direct callables.
+// Samples the BSDF, queues the next event estimation shadow ray, and queues the continued path for the next bounce.
+extern "C" __global__ void __raygen__wavefront_shade()
+{
+  WavefrontData const& wf = *sysData.wavefront;
+
+  WavefrontCounters* counters = wf.counters;
+
+  const unsigned int index = optixGetLaunchIndex().x;
+
+  if (counters->hits <= index)
+  {
+    return;
+  }
+
+  WavefrontHit const& hit = wf.hits[wf.sortedQueue[index]];
+
+  const unsigned int indexPath = hit.indexPath;
+
+  PerRayData prd;
+
+  prd.absorption_ior = make_float4(0.0f, 0.0f, 0.0f, 1.0f); // Only written by transmissive BSDFs.
+  const float4 direction = wf.direction[indexPath];
+
+  prd.pos            = hit.pos;
+  prd.wo             = -make_float3(direction);
+  prd.radiance       = make_float3(0.0f);
+  prd.flags          = hit.flags;
+  prd.f_over_pdf     = make_float3(0.0f);
+  prd.pdf            = 0.0f;
+  prd.seed           = wf.seed[indexPath];
+
+  loadVolume(wf, indexPath, prd);
+
+  State state;
+
+  state.normalGeo = hit.normalGeo;
+  state.tangent   = hit.tangent;
+  state.normal    = hit.normal;
+  state.texcoord  = hit.texcoord;
+
+  MaterialDefinition const& material = sysData.materialDefinitions[hit.materialIndex];
+
+  state.albedo = material.albedo;
+
+  if (material.textureAlbedo != 0)
+  {
+    const float3 texColor = make_float3(tex2DLod<float4>(material.textureAlbedo, state.texcoord.x, state.texcoord.y, rayConeMipLevel(hit.lod, material.textureLod.x)));
+
+    state.albedo *= texColor;
+  }
+
+  prd.flags |= FLAG_HIT | material.flags;
+
+  const int indexBSDF = NUM_LENS_SHADERS + NUM_LIGHT_TYPES + material.indexBSDF * 2;
+
+  optixDirectCall<void, MaterialDefinition const&, State const&, PerRayData*>(indexBSDF, material, state, &prd);
+
+  const float4 throughputCone = wf.throughput[indexPath];
+
+  float3 throughput = make_float3(throughputCone);
+
+  // The continued path and the shadow ray start with the cone width at this hit.
+  const float2 cone = make_float2(throughputCone.w, rayConeScatter(direction.w, (prd.flags & FLAG_DIFFUSE) != 0));
+
+#if USE_NEXT_EVENT_ESTIMATION
+  // Direct lighting like in the __closesthit__radiance program, but the shadow ray is queued instead of traced.
+  const int numLights = sysData.numLights;
+  if ((prd.flags & FLAG_DIFFUSE) && 0 < numLights)
+  {
+    const float2 sample = rng2(prd.seed);
+
+    const int indexLight = (1 < numLights) ? clamp(static_cast<int>(floorf(rng(prd.seed) * numLights)), 0, numLights - 1) : 0;
+    
+    LightDefinition const& light = sysData.lightDefinitions[indexLight];
+    
+    const int indexCallable = NUM_LENS_SHADERS + light.type;
+
+    LightSample lightSample = optixDirectCall<LightSample, LightDefinition const&, const float3, const float2>(indexCallable, light, prd.pos, sample);
+
+    if (0.0f < lightSample.pdf)
+    {
+      const float4 bsdf_pdf = optixDirectCall<float4, MaterialDefinition const&, State const&, PerRayData*, const float3>(indexBSDF + 1, material, state, &prd, lightSample.direction);
+
+      if (0.0f < bsdf_pdf.w && isNotNull(make_float3(bsdf_pdf)))
+      {
+        if (prd.flags & FLAG_VOLUME)
+        {
+          lightSample.emission *= expf(-lightSample.distance * prd.sigma_t);
+        }
+
+        const float weightMis = powerHeuristic(lightSample.pdf, bsdf_pdf.w);
+
+        // PERF All shading threads append to the same counter.
+        WavefrontShadowRay& ray = wf.shadowQueue[wavefrontIncrement(&counters->shadows, 1)];
+
+        ray.origin    = prd.pos;
+        ray.direction = lightSample.direction;
+        ray.distance  = lightSample.distance;
+        ray.cone      = cone;
+        ray.radiance  = throughput * make_float3(bsdf_pdf) * lightSample.emission * (weightMis * dot(lightSample.direction, state.normal) / lightSample.pdf);
+        ray.seed      = prd.seed;
+        ray.indexPath = indexPath;
+      }
+    }
+  }
+#endif // USE_NEXT_EVENT_ESTIMATION
+
+  // Path termination by the sample() routines or the maximum path length.
+  const int depth = counters->depth;
+
+  if ((prd.flags & FLAG_TERMINATE) || prd.pdf <= 0.0f || isNull(prd.f_over_pdf) || sysData.pathLengths.y <= depth + 1)
+  {
+    return;
+  }
+
+  throughput *= prd.f_over_pdf;
+
+  // Unbiased Russian Roulette path termination.
+  if (sysData.pathLengths.x <= depth)
+  {
+    const float probability = fmaxf(throughput);
+    if (probability < rng(prd.seed))
+    {
+      return;
+    }
+    throughput /= probability;
+  }
+
+  // Adjust the material volume stack on transmissions through a border between two volumes.
+  if ((prd.flags & (FLAG_THINWALLED | FLAG_TRANSMISSION)) == FLAG_TRANSMISSION)
+  {
+    int stackIdx = wf.stackIndex[indexPath];
+
+    if (prd.flags & FLAG_FRONTFACE) // Entered a new volume?
+    {
+      stackIdx = min(stackIdx + 1, MATERIAL_STACK_LAST);
+
+      wf.absorptionStack[stackIdx * wf.capacity + indexPath] = prd.absorption_ior;
+    }
+    else // Exited the current volume?
+    {
+      stackIdx = max(stackIdx - 1, MATERIAL_STACK_EMPTY);
+    }
+
+    wf.stackIndex[indexPath] = stackIdx;
+  }
+
+  wf.position[indexPath]   = make_float4(prd.pos, prd.pdf);
+  wf.direction[indexPath]  = make_float4(prd.wi, cone.y);
+  wf.throughput[indexPath] = make_float4(throughput, cone.x);
+  wf.flags[indexPath]      = prd.flags & FLAG_CLEAR_MASK;
+  wf.seed[indexPath]       = prd.seed;
+
+  const unsigned int next = counters->parity ^ 1;
+
+  wf.rayQueue[next][wavefrontIncrement(&counters->rays[next], 1)] = indexPath;
+}
+
+
+// Traces the queued shadow rays and adds the contribution of the visible light samples.
+extern "C" __global__ void __raygen__wavefront_shadow()
+{
+  WavefrontData const& wf = *sysData.wavefront;
+
+  const unsigned int index = optixGetLaunchIndex().x;
+
+  if (wf.counters->shadows <= index)
+  {
+    return;
+  }
+
+  WavefrontShadowRay const& ray = wf.shadowQueue[index];
+
+  PerRayData prd;
+
+  prd.flags = 0;
+  prd.cone  = ray.cone;
+  prd.seed  = ray.seed;
+
+  uint2 payload = splitPointer(&prd);
+
+  optixTrace(sysData.topObject,
+             ray.origin, ray.direction, // origin, direction
+             sysData.sceneEpsilon, ray.distance - sysData.sceneEpsilon, 0.0f, // tmin, tmax, time
+             OptixVisibilityMask(0xFF), OPTIX_RAY_FLAG_DISABLE_CLOSESTHIT, // The shadow ray type only uses anyhit programs.
+             RAYTYPE_SHADOW, NUM_RAYTYPES, RAYTYPE_SHADOW,
+             payload.x, payload.y);
+
+  if ((prd.flags & FLAG_SHADOW) == 0)
+  {
+    // Each path queues at most one shadow ray per bounce, so there are no concurrent writes.
+    wf.radiance[ray.indexPath] += make_float4(ray.radiance, 0.0f);
+  }
+}
+
+
+// Launched with the resolution after the last bounce. Accumulates the path radiance into the output buffer like the __raygen__path_tracer.
+extern "C" __global__ void __raygen__wavefront_resolve()
+{
+  const uint2 theLaunchIndex = make_uint2(optixGetLaunchIndex());
+
+  const unsigned int indexPixel = theLaunchIndex.y * sysData.resolution.x + theLaunchIndex.x;
+
+  float3 radiance = make_float3(sysData.wavefront->radiance[indexPixel]);
+
+  // NaN values will never go away. Filter them out before they can arrive in the output buffer.
+  if (!(isnan(radiance.x) || isnan(radiance.y) || isnan(radiance.z)))
+  {
+    float4* buffer = reinterpret_cast<float4*>(sysData.outputBuffer);
+
+    if (0 < sysData.iterationIndex)
+    {
+      const float4 dst = buffer[indexPixel]; // RGBA32F
+      radiance = lerp(make_float3(dst), radiance, 1.0f / float(sysData.iterationIndex + 1));
+    }
+    buffer[indexPixel] = make_float4(radiance, 1.0f);
+  }
+}
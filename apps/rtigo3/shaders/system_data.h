@@ -31,10 +31,12 @@
 #ifndef SYSTEM_DATA_H
 #define SYSTEM_DATA_H
 
+#include "aov_definition.h"
 #include "camera_definition.h"
 #include "light_definition.h"
 #include "material_definition.h"
 #include "vertex_attributes.h"
+#include "wavefront_definition.h"
 
 
 struct SystemData
@@ -52,10 +54,21 @@ struct SystemData
   // These buffers are used differently among the rendering strategies.
   CUdeviceptr         tileBuffer;
   CUdeviceptr         texelBuffer;
-
-  CameraDefinition*   cameraDefinitions; // Currently only one camera in the array. (Allows camera motion blur in the future.)
+  // Runtime time view buffers. Always sized to the resolution. Only written when timeView != 0.
+  CUdeviceptr         timeBuffer; // float per pixel, accumulated clock cycles of the ray generation program.
+  CUdeviceptr         idBuffer;   // uint2 per pixel, .x = instance ID + 1, .y = material index + 1 of the primary hit. 0 means miss.
+  // Resolution sized AOV buffers in the formats listed in aov_definition.h. Only allocated when the aovMask bit is set.
+  CUdeviceptr         aovBuffers[NUM_AOVS];
+
+  CameraDefinition*   cameraDefinitions; // Camera 0 is the interactive camera. Multi-view rendering adds one camera per view.
+  ViewDefinition*     viewDefinitions;   // numViews entries. nullptr when rendering a single view covering the whole resolution.
   LightDefinition*    lightDefinitions;
   MaterialDefinition* materialDefinitions;
+  WavefrontData*      wavefront;         // Path state and queues of the wavefront strategy. nullptr for all other strategies.
+
+  // Adaptive Russian roulette and splitting. Only allocated when rouletteMode != 0. See adaptive_roulette.h.
+  float*  rouletteCache; // rouletteTiles.x * rouletteTiles.y * ROULETTE_DEPTHS expected continuation radiance entries. Negative means invalid.
+  float2* rouletteStats; // Same layout. .x = accumulated continuation radiance over throughput, .y = number of samples. Read back by the host.
 
   cudaTextureObject_t envTexture;
 
@@ -66,24 +79,34 @@ struct SystemData
   int2 tileSize;    // Example: make_int2(8, 4) for 8x4 tiles. Must be a power of two to make the division a right-shift.
   int2 tileShift;   // Example: make_int2(3, 2) for the integer division by tile size. That actually makes the tileSize redundant. 
   int2 pathLengths; // .x = min path length before Russian Roulette kicks in, .y = maximum path length
+  int2 rouletteTiles; // Number of ROULETTE_TILE_SIZE tiles covering the resolution.
 
   // 4 byte alignment 
   int deviceCount;   // Number of devices doing the rendering.
   int deviceIndex;   // Device index to be able to distinguish the individual devices in a multi-GPU environment.
   int iterationIndex;
+  int sampleOffset;  // Global sample index of iterationIndex 0. Only the sample range multi-GPU strategy starts devices at different samples.
   int samplesSqrt;
 
   float sceneEpsilon;
   float clockScale;
 
   int lensShader; // Camera type.
+  int timeView;   // When != 0 the ray generation programs measure the per pixel clock cycles into timeBuffer and idBuffer.
+  int rouletteMode; // 0 = fixed Russian roulette after pathLengths.x, 1 = adaptive roulette and splitting with the rouletteCache.
+  int accumulationLayout; // ACCUMULATION_LAYOUT_* of the outputBuffer (zero copy) or texelBuffer (local copy). See tile_layout.h.
+
+  unsigned int aovMask; // AOV_* bits of the enabled AOV buffers. Bound value in specialized pipelines.
 
   int numCameras;
+  int numViews;   // 0 means single view rendering.
+  int viewOffset; // Index of the first view rendered by this device or launch. Views are distributed over the devices by launch depth.
   int numMaterials;
   int numLights;
 
   unsigned int envWidth; // The original size of the environment texture.
   unsigned int envHeight;
+  int          envFormat; // EnvFormat of envTexture. RGB9E5 is filtered in the shaders.
   float        envIntegral;
   float        envRotation;
 };
@@ -104,6 +127,7 @@ struct LensRay
 {
   float3 org;
   float3 dir;
+  float  spread; // Ray cone spread angle of one pixel, for the texture LOD.
 };
 
 #endif // SYSTEM_DATA_H
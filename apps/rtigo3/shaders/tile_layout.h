@@ -0,0 +1,61 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef TILE_LAYOUT_H
+#define TILE_LAYOUT_H
+
+#include "config.h"
+#include "vector_math.h"
+
+// Memory layouts of the accumulation buffers, shared by the ray generation programs, the compositor kernel and the host side detiling.
+// The tiled layout stores the pixels of one tileSize block contiguously, so the warps of a launch, which cover small 2D blocks
+// of launch indices, write whole cache lines. That matters most where the writes leave the device: zero-copy PCIe transfers.
+// The tiles are ordered row by row, the pixels inside a tile as well. Partial tiles at the right and bottom edges are padded.
+#define ACCUMULATION_LAYOUT_LINEAR 0
+#define ACCUMULATION_LAYOUT_TILED  1
+
+
+// Number of tiles in x and y direction covering the size. tileShift is log2 of the power-of-two tile size.
+__forceinline__ __host__ __device__ int2 tileCount(const int2 size, const int2 tileShift)
+{
+  return make_int2((size.x + (1 << tileShift.x) - 1) >> tileShift.x,
+                   (size.y + (1 << tileShift.y) - 1) >> tileShift.y);
+}
+
+// Index of the pixel x, y in a tile ordered buffer with tilesX tiles per row.
+__forceinline__ __host__ __device__ unsigned int tiledIndex(const unsigned int x, const unsigned int y, const unsigned int tilesX, const int2 tileShift)
+{
+  const unsigned int tile = (y >> tileShift.y) * tilesX + (x >> tileShift.x);
+  const unsigned int row  = (tile << tileShift.y) + (y & ((1u << tileShift.y) - 1));
+
+  return (row << tileShift.x) + (x & ((1u << tileShift.x) - 1));
+}
+
+#endif // TILE_LAYOUT_H
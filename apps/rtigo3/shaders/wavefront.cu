@@ -0,0 +1,111 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+
+#include "wavefront_definition.h"
+
+// Native CUDA kernels of the wavefront strategy. They run between the OptiX launches of each bounce.
+// The hit compaction and sort by shading key is a counting sort over the ray queue slots:
+// wavefront_histogram counts the keys, wavefront_offsets scans them, and wavefront_scatter writes the sorted queue.
+// Each block aggregates its keys in shared memory first, so there are only WAVEFRONT_NUM_KEYS global atomics per block.
+
+// Single thread. Starts the iteration.
+extern "C" __global__ void wavefront_reset(WavefrontData* args)
+{
+  wavefrontReset(args->counters, args->capacity);
+}
+
+extern "C" __global__ void wavefront_histogram(WavefrontData* args)
+{
+  __shared__ unsigned int counts[WAVEFRONT_NUM_KEYS];
+
+  WavefrontCounters* counters = args->counters;
+
+  if (threadIdx.x < WAVEFRONT_NUM_KEYS)
+  {
+    counts[threadIdx.x] = 0;
+  }
+  __syncthreads();
+
+  const unsigned int slot = blockIdx.x * blockDim.x + threadIdx.x;
+
+  if (slot < counters->rays[counters->parity])
+  {
+    wavefrontCountKey(counts, args->hitKeys[slot]);
+  }
+  __syncthreads();
+
+  if (threadIdx.x < WAVEFRONT_NUM_KEYS)
+  {
+    wavefrontAddHistogram(counters, counts, threadIdx.x);
+  }
+}
+
+// Single thread. Exclusive prefix sum of the WAVEFRONT_NUM_KEYS histogram entries.
+extern "C" __global__ void wavefront_offsets(WavefrontData* args)
+{
+  wavefrontSortOffsets(args->counters);
+}
+
+extern "C" __global__ void wavefront_scatter(WavefrontData* args)
+{
+  __shared__ unsigned int counts[WAVEFRONT_NUM_KEYS];
+  __shared__ unsigned int bases[WAVEFRONT_NUM_KEYS];
+
+  WavefrontCounters* counters = args->counters;
+
+  if (threadIdx.x < WAVEFRONT_NUM_KEYS)
+  {
+    counts[threadIdx.x] = 0;
+  }
+  __syncthreads();
+
+  const unsigned int slot = blockIdx.x * blockDim.x + threadIdx.x;
+
+  const unsigned int key  = (slot < counters->rays[counters->parity]) ? args->hitKeys[slot] : WAVEFRONT_KEY_NONE;
+  const unsigned int rank = wavefrontCountKey(counts, key);
+  __syncthreads();
+
+  if (threadIdx.x < WAVEFRONT_NUM_KEYS)
+  {
+    bases[threadIdx.x] = wavefrontReserve(counters, counts, threadIdx.x);
+  }
+  __syncthreads();
+
+  if (key < WAVEFRONT_NUM_KEYS)
+  {
+    args->sortedQueue[bases[key] + rank] = slot;
+  }
+}
+
+// Single thread. Swaps the ray queues after the shadow rays of a bounce have been traced.
+extern "C" __global__ void wavefront_advance(WavefrontData* args)
+{
+  wavefrontAdvance(args->counters);
+}
@@ -0,0 +1,89 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef WAVEFRONT_DEFINITION_H
+#define WAVEFRONT_DEFINITION_H
+
+#include "wavefront_queue.h"
+
+// Device buffers of the wavefront path tracer strategy.
+// Each bounce traces all queued rays, sorts the hits by BSDF, shades them, and traces the resulting shadow rays, each step in its own launch.
+
+// Surface interaction stored by the closesthit program in the trace launch. Indexed by the ray queue slot.
+struct WavefrontHit
+{
+  float3 pos;       // World space hit point.
+  float3 normalGeo; // World space normals, tangent and texture coordinates. Already flipped to the side looked at.
+  float3 normal;
+  float3 tangent;
+  float3 texcoord;
+  float  lod;       // Texture independent ray cone LOD. See ray_cone.h.
+
+  int          materialIndex;
+  unsigned int flags;     // FLAG_FRONTFACE
+  unsigned int indexPath; // Written by the trace ray generation program after the closesthit program.
+};
+
+// Next event estimation ray. The radiance is added to the path when the light sample is visible.
+struct WavefrontShadowRay
+{
+  float3       origin;
+  float3       direction;
+  float        distance;  // Distance to the light sample. The sceneEpsilon is applied on both ends of the ray.
+  float3       radiance;  // Light sample contribution, already multiplied with the path throughput, BSDF and MIS weight.
+  float2       cone;      // Ray cone for the cutout opacity texture LOD.
+  unsigned int seed;      // Random number generator state for the stochastic cutout opacity.
+  unsigned int indexPath;
+};
+
+struct WavefrontData
+{
+  // Path state as structure of arrays. One path per pixel, indexed by the linear pixel index.
+  float4*       position;        // .xyz = origin of the next ray, .w = pdf of the last BSDF sample for MIS of implicit light hits.
+  float4*       direction;       // .xyz = direction of the next ray, .w = its ray cone spread angle.
+  float4*       throughput;      // .xyz = path throughput, .w = ray cone width at the origin of the next ray.
+  float4*       radiance;        // .xyz = radiance gathered by the path in the current iteration.
+  float4*       absorptionStack; // MATERIAL_STACK_SIZE levels of capacity entries. .xyz = absorption coefficient, .w = IOR.
+  int*          stackIndex;      // Top of the nested material stack. MATERIAL_STACK_EMPTY when in vacuum.
+  unsigned int* flags;           // Flags persistent along the path. Only FLAG_DIFFUSE of the last surface interaction.
+  unsigned int* seed;            // Random number generator state.
+
+  // Queues. The ray queues contain path indices, the sorted queue contains ray queue slots.
+  unsigned int*       rayQueue[2];
+  WavefrontHit*       hits;        // One entry per ray queue slot.
+  unsigned int*       hitKeys;     // Shading key per ray queue slot. WAVEFRONT_KEY_NONE when the path ended.
+  unsigned int*       sortedQueue; // Slots of the hits compacted and sorted by key.
+  WavefrontShadowRay* shadowQueue; // Shadow rays of the current bounce.
+  WavefrontCounters*  counters;
+
+  unsigned int capacity; // Number of paths, the resolution.x * resolution.y.
+};
+
+#endif // WAVEFRONT_DEFINITION_H
@@ -0,0 +1,154 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#ifndef WAVEFRONT_QUEUE_H
+#define WAVEFRONT_QUEUE_H
+
+// Queue bookkeeping of the wavefront path tracer which is shared between the CUDA kernels in wavefront.cu,
+// the OptiX programs in raygeneration_wavefront.cu and the host implementation in WavefrontQueue.cpp.
+// Plain data and functions only, so that the host side doesn't need CUDA headers to compile this.
+
+#include "function_indices.h"
+
+#if defined(__CUDACC__)
+#define WAVEFRONT_FUNC __forceinline__ __host__ __device__
+#else
+#define WAVEFRONT_FUNC inline
+#endif
+
+// One shading queue per BSDF index. The shading launch processes the hits sorted by this key,
+// so that neighbouring threads call the same BSDF direct callables.
+#define WAVEFRONT_NUM_KEYS NUM_BSDF_INDICES
+
+// Key of ray queue slots whose path ended in the trace launch. These are dropped by the compaction.
+#define WAVEFRONT_KEY_NONE 0xFFFFFFFFu
+
+// Threads per block of the native wavefront kernels. Each block aggregates its keys in shared memory.
+#define WAVEFRONT_BLOCK_SIZE 256
+
+struct WavefrontCounters
+{
+  unsigned long long traced; // Radiance and shadow rays traced since the buffers were allocated.
+
+  unsigned int parity;   // Index of the ray queue read by the current bounce. The shading launch appends to the other one.
+  int          depth;    // Path segment index of the current bounce. Primary rays are 0.
+  unsigned int rays[2];  // Ray queue sizes.
+  unsigned int hits;     // Sorted queue size. The number of paths which need shading in the current bounce.
+  unsigned int shadows;  // Shadow ray queue size.
+
+  unsigned int histogram[WAVEFRONT_NUM_KEYS]; // Hits per key.
+  unsigned int cursors[WAVEFRONT_NUM_KEYS];   // Exclusive prefix sum of the histogram. Advanced while scattering into the sorted queue.
+};
+
+
+// Returns the previous value. Atomic on the device, where the counters live in global or shared memory.
+WAVEFRONT_FUNC unsigned int wavefrontIncrement(unsigned int* counter, const unsigned int value)
+{
+#if defined(__CUDA_ARCH__)
+  return atomicAdd(counter, value);
+#else
+  const unsigned int previous = *counter;
+  *counter += value;
+  return previous;
+#endif
+}
+
+// Counts one key into counts and returns its rank among the keys counted so far. WAVEFRONT_KEY_NONE is not counted.
+WAVEFRONT_FUNC unsigned int wavefrontCountKey(unsigned int* counts, const unsigned int key)
+{
+  return (key < WAVEFRONT_NUM_KEYS) ? wavefrontIncrement(&counts[key], 1) : 0;
+}
+
+// Adds the per key counts of one block to the histogram.
+WAVEFRONT_FUNC void wavefrontAddHistogram(WavefrontCounters* counters, const unsigned int* counts, const unsigned int key)
+{
+  if (counts[key] != 0)
+  {
+    wavefrontIncrement(&counters->histogram[key], counts[key]);
+  }
+}
+
+// Exclusive prefix sum over the histogram. Sets the start of each key's range in the sorted queue and the total number of hits.
+WAVEFRONT_FUNC void wavefrontSortOffsets(WavefrontCounters* counters)
+{
+  unsigned int sum = 0;
+
+  for (unsigned int key = 0; key < WAVEFRONT_NUM_KEYS; ++key)
+  {
+    counters->cursors[key] = sum;
+    sum += counters->histogram[key];
+  }
+
+  counters->hits = sum;
+}
+
+// Reserves the range for the counts[key] entries of one block inside that key's range of the sorted queue. Returns the first index.
+WAVEFRONT_FUNC unsigned int wavefrontReserve(WavefrontCounters* counters, const unsigned int* counts, const unsigned int key)
+{
+  return wavefrontIncrement(&counters->cursors[key], counts[key]);
+}
+
+// Starts an iteration with all numPaths paths in the first ray queue.
+WAVEFRONT_FUNC void wavefrontReset(WavefrontCounters* counters, const unsigned int numPaths)
+{
+  counters->parity  = 0;
+  counters->depth   = 0;
+  counters->rays[0] = numPaths;
+  counters->rays[1] = 0;
+  counters->hits    = 0;
+  counters->shadows = 0;
+
+  for (unsigned int key = 0; key < WAVEFRONT_NUM_KEYS; ++key)
+  {
+    counters->histogram[key] = 0;
+    counters->cursors[key]   = 0;
+  }
+}
+
+// Ends a bounce. The queue the shading launch appended to becomes the input of the next trace launch.
+WAVEFRONT_FUNC void wavefrontAdvance(WavefrontCounters* counters)
+{
+  counters->traced += counters->rays[counters->parity] + counters->shadows;
+
+  counters->parity ^= 1;
+  counters->depth  += 1;
+
+  counters->rays[counters->parity ^ 1] = 0;
+  counters->hits    = 0;
+  counters->shadows = 0;
+
+  for (unsigned int key = 0; key < WAVEFRONT_NUM_KEYS; ++key)
+  {
+    counters->histogram[key] = 0;
+    counters->cursors[key]   = 0;
+  }
+}
+
+#endif // WAVEFRONT_QUEUE_H
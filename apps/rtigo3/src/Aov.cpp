@@ -0,0 +1,317 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/Aov.h"
+
+#include "shaders/vector_math.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+
+size_t getAovElementSize(const int index)
+{
+  switch (index)
+  {
+    case AOV_INDEX_DEPTH:
+    case AOV_INDEX_INSTANCE:
+    case AOV_INDEX_MATERIAL:
+    case AOV_INDEX_PRIMITIVE:
+      return 4;
+    case AOV_INDEX_NORMAL:
+    case AOV_INDEX_ALBEDO:
+      return 8; // half4
+    case AOV_INDEX_DIRECT:
+      return 16; // float4
+  }
+  return 0;
+}
+
+
+const char* getAovOptionName(const int index)
+{
+  static const char* names[NUM_AOVS] =
+  {
+    "aovDepth",
+    "aovNormal",
+    "aovAlbedo",
+    "aovInstanceId",
+    "aovMaterialId",
+    "aovPrimitiveId",
+    "aovDirect"
+  };
+
+  return (0 <= index && index < NUM_AOVS) ? names[index] : "";
+}
+
+
+int findAovIndex(std::string const& optionName)
+{
+  for (int i = 0; i < NUM_AOVS; ++i)
+  {
+    if (optionName == getAovOptionName(i))
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+
+void accumulateAov(std::vector<unsigned char>& aov, std::vector<unsigned char> const& aovDevice)
+{
+  if (aov.size() != aovDevice.size())
+  {
+    // First device defines the layout.
+    aov = aovDevice;
+    return;
+  }
+
+  for (size_t i = 0; i < aov.size(); ++i)
+  {
+    aov[i] |= aovDevice[i];
+  }
+}
+
+
+void getAovChannels(const unsigned int aovMask,
+                    const float4* beauty,
+                    std::vector<unsigned char> const* aovs,
+                    const size_t numPixels,
+                    std::vector<float4>& indirect,
+                    std::vector<ExrChannel>& channels)
+{
+  channels.clear();
+
+  const char* namesRGBA[4] = { "R", "G", "B", "A" };
+  for (int c = 0; c < 4; ++c)
+  {
+    channels.push_back({ namesRGBA[c], EXR_PIXEL_FLOAT, reinterpret_cast<const float*>(beauty) + c, sizeof(float4) });
+  }
+
+  if (aovMask & AOV_DEPTH)
+  {
+    channels.push_back({ "Z", EXR_PIXEL_FLOAT, aovs[AOV_INDEX_DEPTH].data(), sizeof(float) });
+  }
+  if (aovMask & AOV_NORMAL)
+  {
+    const unsigned short* normal = reinterpret_cast<const unsigned short*>(aovs[AOV_INDEX_NORMAL].data());
+
+    channels.push_back({ "normal.X", EXR_PIXEL_HALF, normal,     sizeof(ushort4) });
+    channels.push_back({ "normal.Y", EXR_PIXEL_HALF, normal + 1, sizeof(ushort4) });
+    channels.push_back({ "normal.Z", EXR_PIXEL_HALF, normal + 2, sizeof(ushort4) });
+  }
+  if (aovMask & AOV_ALBEDO)
+  {
+    const unsigned short* albedo = reinterpret_cast<const unsigned short*>(aovs[AOV_INDEX_ALBEDO].data());
+
+    channels.push_back({ "albedo.R", EXR_PIXEL_HALF, albedo,     sizeof(ushort4) });
+    channels.push_back({ "albedo.G", EXR_PIXEL_HALF, albedo + 1, sizeof(ushort4) });
+    channels.push_back({ "albedo.B", EXR_PIXEL_HALF, albedo + 2, sizeof(ushort4) });
+  }
+  if (aovMask & AOV_INSTANCE)
+  {
+    channels.push_back({ "instanceId", EXR_PIXEL_UINT, aovs[AOV_INDEX_INSTANCE].data(), sizeof(unsigned int) });
+  }
+  if (aovMask & AOV_MATERIAL)
+  {
+    channels.push_back({ "materialId", EXR_PIXEL_UINT, aovs[AOV_INDEX_MATERIAL].data(), sizeof(unsigned int) });
+  }
+  if (aovMask & AOV_PRIMITIVE)
+  {
+    channels.push_back({ "primitiveId", EXR_PIXEL_UINT, aovs[AOV_INDEX_PRIMITIVE].data(), sizeof(unsigned int) });
+  }
+  if (aovMask & AOV_DIRECT)
+  {
+    const float4* direct = reinterpret_cast<const float4*>(aovs[AOV_INDEX_DIRECT].data());
+
+    indirect.resize(numPixels);
+    for (size_t i = 0; i < numPixels; ++i)
+    {
+      indirect[i] = make_float4(fmaxf(make_float3(0.0f), make_float3(beauty[i]) - make_float3(direct[i])), 1.0f);
+    }
+
+    const char* namesRGB[3] = { "R", "G", "B" };
+    for (int c = 0; c < 3; ++c)
+    {
+      channels.push_back({ std::string("direct.")   + namesRGB[c], EXR_PIXEL_FLOAT, reinterpret_cast<const float*>(direct) + c,          sizeof(float4) });
+      channels.push_back({ std::string("indirect.") + namesRGB[c], EXR_PIXEL_FLOAT, reinterpret_cast<const float*>(indirect.data()) + c, sizeof(float4) });
+    }
+  }
+}
+
+
+// OpenEXR is little-endian. All supported platforms are as well, so values are written as they are in memory.
+template <typename T>
+static void append(std::vector<char>& data, const T value)
+{
+  const char* bytes = reinterpret_cast<const char*>(&value);
+  data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+static void appendString(std::vector<char>& data, const char* str)
+{
+  data.insert(data.end(), str, str + strlen(str) + 1); // Including the terminating null.
+}
+
+static void appendAttribute(std::vector<char>& data, const char* name, const char* type, std::vector<char> const& value)
+{
+  appendString(data, name);
+  appendString(data, type);
+  append(data, static_cast<int32_t>(value.size()));
+  data.insert(data.end(), value.begin(), value.end());
+}
+
+static size_t getExrPixelSize(const ExrPixelType type)
+{
+  return (type == EXR_PIXEL_HALF) ? 2 : 4;
+}
+
+
+bool saveEXR(std::string const& filename, const int width, const int height, std::vector<ExrChannel> const& channels)
+{
+  if (width <= 0 || height <= 0 || channels.empty())
+  {
+    return false;
+  }
+
+  // The channel list attribute and the pixel data must be sorted by channel name.
+  std::vector<ExrChannel> sorted(channels);
+  std::sort(sorted.begin(), sorted.end(), [](ExrChannel const& a, ExrChannel const& b)
+  {
+    return a.name < b.name;
+  });
+
+  std::vector<char> header;
+
+  append(header, static_cast<int32_t>(20000630)); // Magic number.
+  append(header, static_cast<int32_t>(2));        // Version 2, single-part scanline file.
+
+  std::vector<char> value;
+
+  for (const auto& channel : sorted)
+  {
+    appendString(value, channel.name.c_str());
+    append(value, static_cast<int32_t>(channel.type));
+    append(value, static_cast<uint8_t>(0)); // pLinear
+    append(value, static_cast<uint8_t>(0)); // reserved
+    append(value, static_cast<uint8_t>(0));
+    append(value, static_cast<uint8_t>(0));
+    append(value, static_cast<int32_t>(1)); // xSampling
+    append(value, static_cast<int32_t>(1)); // ySampling
+  }
+  value.push_back(0);
+  appendAttribute(header, "channels", "chlist", value);
+
+  value.clear();
+  value.push_back(0); // NO_COMPRESSION
+  appendAttribute(header, "compression", "compression", value);
+
+  value.clear();
+  append(value, static_cast<int32_t>(0));
+  append(value, static_cast<int32_t>(0));
+  append(value, static_cast<int32_t>(width - 1));
+  append(value, static_cast<int32_t>(height - 1));
+  appendAttribute(header, "dataWindow", "box2i", value);
+  appendAttribute(header, "displayWindow", "box2i", value);
+
+  value.clear();
+  value.push_back(0); // INCREASING_Y
+  appendAttribute(header, "lineOrder", "lineOrder", value);
+
+  value.clear();
+  append(value, 1.0f);
+  appendAttribute(header, "pixelAspectRatio", "float", value);
+
+  value.clear();
+  append(value, 0.0f);
+  append(value, 0.0f);
+  appendAttribute(header, "screenWindowCenter", "v2f", value);
+
+  value.clear();
+  append(value, 1.0f);
+  appendAttribute(header, "screenWindowWidth", "float", value);
+
+  header.push_back(0); // End of header.
+
+  // One scanline per chunk without compression. Each chunk is the y-coordinate, the data size, and all channels of that line one after another.
+  size_t bytesPerLine = 0;
+  for (const auto& channel : sorted)
+  {
+    bytesPerLine += getExrPixelSize(channel.type) * size_t(width);
+  }
+
+  const uint64_t offsetFirstLine = uint64_t(header.size()) + sizeof(uint64_t) * uint64_t(height);
+  const uint64_t sizeChunk       = sizeof(int32_t) * 2 + uint64_t(bytesPerLine);
+
+  for (int y = 0; y < height; ++y)
+  {
+    append(header, offsetFirstLine + uint64_t(y) * sizeChunk);
+  }
+
+  std::ofstream stream(filename, std::ios::binary);
+  if (!stream)
+  {
+    std::cerr << "ERROR: saveEXR() Failed to open file " << filename << '\n';
+    return false;
+  }
+
+  stream.write(header.data(), header.size());
+
+  std::vector<char> line;
+  line.reserve(size_t(sizeChunk));
+
+  for (int y = 0; y < height; ++y)
+  {
+    line.clear();
+
+    append(line, static_cast<int32_t>(y));
+    append(line, static_cast<int32_t>(bytesPerLine));
+
+    const size_t row = size_t(height - 1 - y); // EXR scanline 0 is the top of the image.
+
+    for (const auto& channel : sorted)
+    {
+      const size_t size = getExrPixelSize(channel.type);
+      const char*  src  = reinterpret_cast<const char*>(channel.data) + row * size_t(width) * channel.stride;
+
+      for (int x = 0; x < width; ++x)
+      {
+        line.insert(line.end(), src, src + size);
+        src += channel.stride;
+      }
+    }
+
+    stream.write(line.data(), line.size());
+  }
+
+  return !stream.fail();
+}
@@ -27,26 +27,101 @@
  */
 
 #include "inc/Application.h"
+#include "inc/Aov.h"
+#include "inc/EnvFormat.h"
 #include "inc/Parser.h"
+#include "inc/RayQuery.h"
 
 #include "inc/RaytracerSingleGPU.h"
 #include "inc/RaytracerMultiGPUZeroCopy.h"
 #include "inc/RaytracerMultiGPUPeerAccess.h"
 #include "inc/RaytracerMultiGPULocalCopy.h"
+#include "inc/RaytracerMultiGPUSampleRange.h"
+#include "inc/RaytracerWavefront.h"
+#include "inc/TimeView.h"
+
+#include "shaders/tile_layout.h"
 
 #include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <sstream>
-#include <stack>
+#include <stdexcept>
+#include <thread>
 #include <memory>
 
+#include <sys/stat.h>
+
+#if defined(_WIN32)
+#if !defined WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif
+#if !defined NOMINMAX
+#define NOMINMAX 1
+#endif
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "Psapi.lib")
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include <dp/math/Batch.h>
 #include <dp/math/Matmnt.h>
 
 #include "inc/CheckMacros.h"
 
 #include "inc/MyAssert.h"
 
+
+// Last modification time of a file for the hot reload. Returns 0 when the file doesn't exist.
+static long long getFileTime(std::string const& filename)
+{
+#if defined(_WIN32)
+  struct _stat64 status;
+  if (_stat64(filename.c_str(), &status) != 0)
+#else
+  struct stat status;
+  if (stat(filename.c_str(), &status) != 0)
+#endif
+  {
+    return 0;
+  }
+  return static_cast<long long>(status.st_mtime);
+}
+
+// Current and peak resident set size of this process in bytes. Zero when unknown.
+static void getMemoryUsage(size_t& current, size_t& peak)
+{
+  current = 0;
+  peak    = 0;
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+  {
+    current = counters.WorkingSetSize;
+    peak    = counters.PeakWorkingSetSize;
+  }
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0)
+  {
+    peak = static_cast<size_t>(usage.ru_maxrss) * 1024; // Kilobytes under Linux.
+  }
+  std::ifstream statm("/proc/self/statm");
+  size_t pagesTotal    = 0;
+  size_t pagesResident = 0;
+  if (statm >> pagesTotal >> pagesResident)
+  {
+    current = pagesResident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  }
+#endif
+}
+
+
 Application::Application(GLFWwindow* window, Options const& options)
 : m_window(window)
 , m_isValid(false)
@@ -59,8 +134,12 @@ Application::Application(GLFWwindow* window, Options const& options)
 , m_devicesMask(255)
 , m_light(0)
 , m_miss(1)
+, m_envFormat(ENV_FORMAT_RGBA32F)
 , m_interop(0)
 , m_present(false)
+, m_hotReload(false)
+, m_hostResidency(false)
+, m_prefixHostCache("./rtigo3_cache_")
 , m_presentNext(true)
 , m_presentAtSecond(1.0)
 , m_previousComplete(false)
@@ -69,31 +148,30 @@ Application::Application(GLFWwindow* window, Options const& options)
 , m_epsilonFactor(500.0f)
 , m_environmentRotation(0.0f)
 , m_clockFactor(1000.0f)
+, m_specialize(false)
+, m_timeView(false)
+, m_roulette(false)
+, m_tiledAccumulation(false)
+, m_aovMask(0)
+, m_bvhBenchmark(false)
+, m_viewLayout(VIEW_LAYOUT_SINGLE)
+, m_viewsSequential(false)
+, m_graphs(true)
 , m_mouseSpeedRatio(10.0f)
 , m_idGroup(0)
 , m_idInstance(0)
 , m_idGeometry(0)
+, m_sizeHostBVH(0)
+, m_picked(-1)
+, m_timeFileSystem(0)
+, m_timeFileScene(0)
+, m_iterationIndex(0)
+, m_restarts(0)
 {
   try
   {
     m_timer.restart();
     
-    // Initialize the top-level keywords of the scene description for faster search.
-    m_mapKeywordScene["albedo"]          = KS_ALBEDO;
-    m_mapKeywordScene["roughness"]       = KS_ROUGHNESS;
-    m_mapKeywordScene["absorption"]      = KS_ABSORPTION;
-    m_mapKeywordScene["absorptionScale"] = KS_ABSORPTION_SCALE;
-    m_mapKeywordScene["ior"]             = KS_IOR;
-    m_mapKeywordScene["thinwalled"]      = KS_THINWALLED;
-    m_mapKeywordScene["material"]        = KS_MATERIAL;
-    m_mapKeywordScene["identity"]        = KS_IDENTITY;
-    m_mapKeywordScene["push"]            = KS_PUSH;
-    m_mapKeywordScene["pop"]             = KS_POP;
-    m_mapKeywordScene["rotate"]          = KS_ROTATE;
-    m_mapKeywordScene["scale"]           = KS_SCALE;
-    m_mapKeywordScene["translate"]       = KS_TRANSLATE;
-    m_mapKeywordScene["model"]           = KS_MODEL;
-    
     const double timeConstructor = m_timer.getTime();
     
     // Gobal commandline parameters:
@@ -102,11 +180,15 @@ Application::Application(GLFWwindow* window, Options const& options)
     m_mode     = std::max(0, options.getMode());
     m_optimize = options.getOptimize();
 
+    m_filenameRecord = options.getRecord();
+    m_filenameReplay = options.getReplay();
+
     // Initialize the system options to minimum defaults to work, but require useful settings inside the system options file.
     // The minumum path length values will generate useful direct lighting results, but transmissions will be mostly black.
     m_resolution  = make_int2(1, 1);
     m_tileSize    = make_int2(8, 8);
     m_pathLengths = make_int2(0, 2);
+    m_viewGrid    = make_int2(4, 4);
 
     m_prefixScreenshot = std::string("./img"); // Default to current working directory and prefix "img".
 
@@ -122,14 +204,20 @@ Application::Application(GLFWwindow* window, Options const& options)
     m_tonemapperGUI.brightness      = 1.0f;
 
     // System wide parameters are loaded from this file to keep the number of command line options small.
-    const std::string filenameSystem = options.getSystem();
-    if (!loadSystemDescription(filenameSystem))
+    m_filenameSystem = options.getSystem();
+    if (!loadSystemDescription(m_filenameSystem))
     {
-      std::cerr << "ERROR: Application() failed to load system description file " << filenameSystem << '\n';
+      std::cerr << "ERROR: Application() failed to load system description file " << m_filenameSystem << '\n';
       MY_ASSERT(!"Failed to load system description");
       return; // m_isValid == false.
     }
 
+    if (m_viewLayout != VIEW_LAYOUT_SINGLE && (m_strategy == RS_INTERACTIVE_MULTI_GPU_LOCAL_COPY || m_strategy == RS_WAVEFRONT_SINGLE_GPU))
+    {
+      std::cerr << "WARNING: Application() viewLayout is not supported by the local copy and wavefront strategies. Rendering a single view.\n";
+      m_viewLayout = VIEW_LAYOUT_SINGLE;
+    }
+
     // The user interface is part of the main application.
     // Setup ImGui binding.
     ImGui::CreateContext();
@@ -207,6 +295,7 @@ Application::Application(GLFWwindow* window, Options const& options)
     // the proper vertex attributes for display and the PBO size in case of interop.
     m_rasterizer->setResolution(m_resolution.x, m_resolution.y); 
     m_rasterizer->setTonemapper(m_tonemapperGUI);
+    m_rasterizer->setTimeView(m_timeView);
 
     const unsigned int tex = m_rasterizer->getTextureObject();
     const unsigned int pbo = m_rasterizer->getPixelBufferObject();
@@ -231,6 +320,14 @@ Application::Application(GLFWwindow* window, Options const& options)
       case RS_INTERACTIVE_MULTI_GPU_LOCAL_COPY:
         m_raytracer = std::make_unique<RaytracerMultiGPULocalCopy>(m_devicesMask, m_miss, m_interop, tex, pbo);
         break;
+
+      case RS_MULTI_GPU_SAMPLE_RANGE:
+        m_raytracer = std::make_unique<RaytracerMultiGPUSampleRange>(m_devicesMask, m_miss, m_interop, tex, pbo);
+        break;
+
+      case RS_WAVEFRONT_SINGLE_GPU:
+        m_raytracer = std::make_unique<RaytracerWavefront>(m_devicesMask, m_miss, m_interop, tex, pbo);
+        break;
     }
 
     // If the raytracer could not be initialized correctly, return and leave Application invalid.
@@ -279,14 +376,7 @@ Application::Application(GLFWwindow* window, Options const& options)
       }
     }
 
-    m_state.resolution    = m_resolution;
-    m_state.tileSize      = m_tileSize;
-    m_state.pathLengths   = m_pathLengths;
-    m_state.samplesSqrt   = m_samplesSqrt;
-    m_state.lensShader    = m_lensShader;
-    m_state.epsilonFactor = m_epsilonFactor;
-    m_state.envRotation   = m_environmentRotation;
-    m_state.clockFactor   = m_clockFactor;
+    updateDeviceState();
 
     // Sync the state with the default GUI data.
     m_raytracer->initState(m_state);
@@ -301,10 +391,10 @@ Application::Application(GLFWwindow* window, Options const& options)
     createLights();
     
     // Load the scene description file and generate the host side scene.
-    const std::string filenameScene = options.getScene();
-    if (!loadSceneDescription(filenameScene))
+    m_filenameScene = options.getScene();
+    if (!loadSceneDescription(m_filenameScene))
     {
-      std::cerr << "ERROR: Application() failed to load scene description file " << filenameScene << '\n';
+      std::cerr << "ERROR: Application() failed to load scene description file " << m_filenameScene << '\n';
       MY_ASSERT(!"Failed to load scene description");
       return;
     }
@@ -319,19 +409,71 @@ Application::Application(GLFWwindow* window, Options const& options)
     m_raytracer->initLights(m_lights);
     m_raytracer->initMaterials(m_materialsGUI);
     m_raytracer->initScene(m_scene, m_idGeometry); // m_idGeometry is the number of geometries in the scene.
+    m_raytracer->setViewsSequential(m_viewsSequential);
+    m_raytracer->setGraphs(m_graphs);
+    if (m_viewLayout != VIEW_LAYOUT_SINGLE)
+    {
+      updateViews();
+    }
     
     const double timeRenderer = m_timer.getTime();
 
+    initHostBVH(); // Picking, focus and framing queries. The BVH build runs in the background unless it's benchmarked.
+    if (m_bvhBenchmark)
+    {
+      m_futureHostBVH.wait();
+    }
+
+    // All devices uploaded the data and the host BVH works on its own triangle copies.
+    if (m_hostResidency)
+    {
+      releaseHostData();
+    }
+
+    const double timeHostBVH = m_timer.getTime();
+
     // Print out hiow long the initialization of each module took.
-    std::cout << "Application(): " << timeRenderer - timeConstructor   << " seconds overall\n";
+    std::cout << "Application(): " << timeHostBVH - timeConstructor    << " seconds overall\n";
     std::cout << "{\n";
     std::cout << "  GUI        = " << timeGUI        - timeConstructor << " seconds\n";
     std::cout << "  Rasterizer = " << timeRasterizer - timeGUI         << " seconds\n";
     std::cout << "  Raytracer  = " << timeRaytracer  - timeRasterizer  << " seconds\n";
     std::cout << "  Scene      = " << timeScene      - timeRaytracer   << " seconds\n";
     std::cout << "  Renderer   = " << timeRenderer   - timeScene       << " seconds\n";
+    std::cout << "  HostBVH    = " << timeHostBVH    - timeRenderer    << " seconds\n";
     std::cout << "}\n";
 
+    size_t memoryCurrent;
+    size_t memoryPeak;
+
+    getMemoryUsage(memoryCurrent, memoryPeak);
+    std::cout << "Application(): host memory current = " << memoryCurrent / (1024 * 1024) << " MB, peak = " << memoryPeak / (1024 * 1024) << " MB\n";
+
+    if (m_bvhBenchmark)
+    {
+      benchmarkHostBVH();
+    }
+
+    m_timeFileSystem = getFileTime(m_filenameSystem);
+    m_timeFileScene  = getFileTime(m_filenameScene);
+    m_timerHotReload.restart();
+
+    if (!m_filenameReplay.empty())
+    {
+      InputTrace trace;
+
+      if (!trace.load(m_filenameReplay))
+      {
+        std::cerr << "ERROR: Application() failed to load input trace " << m_filenameReplay << '\n';
+        return; // m_isValid == false.
+      }
+      m_inputReplay.reset(new InputReplay(trace.getEvents(), options.getRealtime()));
+    }
+    else if (!m_filenameRecord.empty())
+    {
+      m_inputTrace.startRecording();
+    }
+
     restartRendering(); // Trigger a new rendering.
 
     m_isValid = true;
@@ -345,6 +487,16 @@ Application::Application(GLFWwindow* window, Options const& options)
 
 Application::~Application()
 {
+  if (m_futureHostBVH.valid())
+  {
+    m_futureHostBVH.wait(); // The background build must not outlive m_hostBVH.
+  }
+
+  if (m_inputTrace.isRecording() && m_inputTrace.save(m_filenameRecord))
+  {
+    std::cout << m_filenameRecord << '\n'; // Print out the filename to indicate success.
+  }
+
   for (std::map<std::string, Picture*>::const_iterator it =  m_mapPictures.begin(); it != m_mapPictures.end(); ++it)
   {
     delete it->second;
@@ -379,6 +531,8 @@ void Application::restartRendering()
   m_presentAtSecond  = 1.0;
   
   m_previousComplete = false;
+
+  ++m_restarts;
   
   m_timer.restart();
 }
@@ -391,18 +545,32 @@ bool Application::render()
 
   try
   {
+    if (m_hotReload && m_mode == 0)
+    {
+      checkHotReload();
+    }
+
     CameraDefinition camera;
 
     const bool cameraChanged = m_camera.getFrustum(camera.P, camera.U, camera.V, camera.W);
     if (cameraChanged)
     {
       m_cameras[0] = camera;
-      m_raytracer->updateCamera(0, camera);
+      if (m_viewLayout != VIEW_LAYOUT_SINGLE)
+      {
+        updateViews(); // The view cameras follow the interactive camera.
+      }
+      else
+      {
+        m_raytracer->updateCamera(0, camera);
+      }
 
       restartRendering();
     }
 
     const unsigned int iterationIndex = m_raytracer->render();
+
+    m_iterationIndex = iterationIndex;
     
     // When the renderer has completed all iterations, change the GUI title bar to green.
     const bool complete = ((unsigned int)(m_samplesSqrt * m_samplesSqrt) <= iterationIndex);
@@ -418,7 +586,8 @@ bool Application::render()
     
     // When benchmark is enabled, exit the application when the requested samples per pixel have ben rendered.
     // Actually this render() function is not called when m_mode == 1 but keep the finish here to exit on exceptions.
-    finish = ((m_mode == 1) && complete);
+    // An input trace replay ends the application when all its frames have been replayed.
+    finish = ((m_mode == 1) && complete) || (m_inputReplay && m_inputReplay->isFinished());
     
     // Only update the texture when a restart happened, one second passed to reduce required bandwidth, or the rendering is newly complete.
     if (m_presentNext || flush)
@@ -509,6 +678,131 @@ void Application::benchmark()
 #endif
 
     screenshot(true);
+
+    if (m_aovMask != 0)
+    {
+      saveAovs();
+    }
+
+    if (!m_views.empty()) // Measure the same views rendered the other way, single launch vs. one launch per view.
+    {
+      m_raytracer->setViewsSequential(!m_viewsSequential);
+
+      iterationIndex = 0;
+
+      m_timer.restart();
+
+      while (iterationIndex < spp)
+      {
+        iterationIndex = m_raytracer->render();
+      }
+
+      m_raytracer->synchronize();
+
+      const double secondsOther = m_timer.getTime();
+
+      m_raytracer->setViewsSequential(m_viewsSequential);
+
+      const double fpsSingle     = double(spp) / ((m_viewsSequential) ? secondsOther : seconds);
+      const double fpsSequential = double(spp) / ((m_viewsSequential) ? seconds : secondsOther);
+
+      std::ostringstream views;
+      views.precision(3);
+      views << std::fixed << m_views.size() << " views: single launch = " << fpsSingle << " fps, sequential launches = " << fpsSequential << " fps, gain = " << fpsSingle / fpsSequential << "x";
+      std::cout << views.str() << '\n';
+    }
+
+    // Measure the host time per iteration of the same rendering with and without the captured CUDA graphs.
+    // Most noticeable at low resolutions where the launch overhead dominates.
+    double secondsGraphs[2]; // [0] = direct launches, [1] = graph replays.
+
+    for (int i = 0; i < 2; ++i)
+    {
+      m_raytracer->setGraphs(i != 0);
+
+      iterationIndex = 0;
+
+      m_timer.restart();
+
+      while (iterationIndex < spp)
+      {
+        iterationIndex = m_raytracer->render();
+      }
+
+      m_raytracer->synchronize();
+
+      secondsGraphs[i] = m_timer.getTime();
+    }
+
+    m_raytracer->setGraphs(m_graphs);
+
+    std::ostringstream graphs;
+    graphs.precision(3);
+    graphs << std::fixed << "CUDA graphs: direct launches = " << secondsGraphs[0] * 1000.0 / double(spp) << " ms, graph replays = " << secondsGraphs[1] * 1000.0 / double(spp) << " ms per iteration, gain = " << secondsGraphs[0] / secondsGraphs[1] << "x";
+    std::cout << graphs.str() << '\n';
+
+    if (m_strategy == RS_WAVEFRONT_SINGLE_GPU) // Measure the same rendering with the megakernel and the wavefront launches.
+    {
+      RaytracerWavefront* raytracer = static_cast<RaytracerWavefront*>(m_raytracer.get());
+
+      double secondsWavefront[2]; // [0] = megakernel, [1] = wavefront.
+      unsigned long long rays = 0;
+
+      for (int i = 0; i < 2; ++i)
+      {
+        raytracer->setWavefront(i != 0);
+
+        iterationIndex = 0;
+
+        const unsigned long long raysBegin = raytracer->getRayCount(); // Synchronizes.
+
+        m_timer.restart();
+
+        while (iterationIndex < spp)
+        {
+          iterationIndex = m_raytracer->render();
+        }
+
+        m_raytracer->synchronize();
+
+        secondsWavefront[i] = m_timer.getTime();
+
+        rays = raytracer->getRayCount() - raysBegin;
+      }
+
+      // The megakernel doesn't count its rays. Both render the same paths, so the wavefront count is used for both rates.
+      const double mrays = double(rays) * 1.0e-6;
+
+      std::ostringstream wavefront;
+      wavefront.precision(3);
+      wavefront << std::fixed << "Wavefront: megakernel = " << mrays / secondsWavefront[0] << " Mrays/s, wavefront = " << mrays / secondsWavefront[1] << " Mrays/s, gain = " << secondsWavefront[0] / secondsWavefront[1] << "x";
+      std::cout << wavefront.str() << '\n';
+    }
+  }
+  catch (std::exception const& e)
+  {
+    std::cerr << e.what() << '\n';
+  }
+}
+
+
+// Replay an input trace without GUI and display. Same per frame work as the interactive main loop otherwise.
+// Each frame waits for the renderer, so the frame times contain the rendering and not just the launch overhead.
+void Application::replay()
+{
+  try
+  {
+    while (!m_inputReplay->isFinished())
+    {
+      replayInputEvents();
+
+      if (m_inputReplay->isFinished() || render()) // render() returns true on exceptions.
+      {
+        break;
+      }
+
+      m_raytracer->synchronize();
+    }
   }
   catch (std::exception const& e)
   {
@@ -541,7 +835,7 @@ void Application::guiRender()
 void Application::createPictures()
 {
   // DAR HACK Load some hardcoded Pictures referenced by the materials.   
-  unsigned int flags = IMAGE_FLAG_2D; // Load only the LOD into memory.
+  unsigned int flags = IMAGE_FLAG_2D | IMAGE_FLAG_MIPMAP; // Material textures are sampled at the ray cone LOD. Missing mipmaps are generated.
 
   Picture* picture = new Picture();
   picture->load(std::string("./NVIDIA_Logo.jpg"), flags);
@@ -553,7 +847,7 @@ void Application::createPictures()
 
   if (m_miss == 2 && !m_environment.empty())
   {
-    flags |= IMAGE_FLAG_ENV; // Special case for the spherical environment.
+    flags = IMAGE_FLAG_2D | IMAGE_FLAG_ENV; // Special case for the spherical environment. Load only the LOD 0 into memory.
     picture = new Picture();
     picture->load(m_environment, flags);
     m_mapPictures[std::string("environment")] = picture;
@@ -659,13 +953,23 @@ void Application::createLights()
 
     m_mapMaterialReferences[reference] = indexMaterial;
 
-    // Create the Triangles for this parallelogram light.
-    m_mapGeometries[reference] = m_idGeometry;
-    
-    std::shared_ptr<sg::Triangles> geometry(new sg::Triangles(m_idGeometry++));
-    geometry->createParallelogram(light.position, light.vecU, light.vecV, light.normal);
+    // Create the Triangles for this parallelogram light. Scene hot reloads reuse it. The light option itself is not reloaded.
+    std::shared_ptr<sg::Triangles> geometry;
 
-    m_geometries.push_back(geometry);
+    std::map<std::string, unsigned int>::const_iterator itg = m_mapGeometries.find(reference);
+    if (itg == m_mapGeometries.end())
+    {
+      m_mapGeometries[reference] = m_idGeometry;
+
+      geometry = std::make_shared<sg::Triangles>(m_idGeometry++);
+      geometry->createParallelogram(light.position, light.vecU, light.vecV, light.normal);
+
+      m_geometries.push_back(geometry);
+    }
+    else
+    {
+      geometry = m_geometries[itg->second];
+    }
 
     std::shared_ptr<sg::Instance> instance(new sg::Instance(m_idInstance++));
     // instance->setTransform(trafo); // Instance default matrix is identity.
@@ -698,6 +1002,24 @@ void Application::guiEventHandler()
   {
     MY_VERIFY( screenshot(false) );
   }
+  if (ImGui::IsKeyPressed('A', false) && m_aovMask != 0) // Key A: Save the linear output buffer and the enabled AOVs into a multi-layer *.exr file.
+  {
+    MY_VERIFY( saveAovs() );
+  }
+  if (ImGui::IsKeyPressed('T', false) && m_timeView) // Key T: Save the time view cycles into a *.hdr file and its statistics into a *.csv file.
+  {
+    MY_VERIFY( saveTimeView() );
+  }
+  if (ImGui::IsKeyPressed('F', false)) // Key F: Frame the selected instance, or the whole scene when nothing is selected.
+  {
+    inputEvent(INPUT_EVENT_FRAME, 0, 0, 0.0f);
+  }
+
+  if (m_inputReplay) // The input trace controls the camera during a replay. Mouse interactions are ignored.
+  {
+    replayInputEvents();
+    return;
+  }
 
   const ImVec2 mousePosition = ImGui::GetMousePos(); // Mouse coordinate window client rect.
   const int x = int(mousePosition.x);
@@ -708,24 +1030,32 @@ void Application::guiEventHandler()
     case GUI_STATE_NONE:
       if (!io.WantCaptureMouse) // Only allow camera interactions to begin when interacting with the GUI.
       {
-        if (ImGui::IsMouseDown(0)) // LMB down event?
+        if (ImGui::IsMouseDoubleClicked(0)) // LMB double click? Focus on the surface under the cursor.
         {
-          m_camera.setBaseCoordinates(x, y);
+          inputEvent(INPUT_EVENT_FOCUS, x, y, 0.0f);
+        }
+        else if (io.KeyCtrl && ImGui::IsMouseClicked(0)) // Ctrl+LMB click? Select the instance under the cursor, or nothing.
+        {
+          inputEvent(INPUT_EVENT_SELECT, x, y, 0.0f);
+        }
+        else if (ImGui::IsMouseDown(0) && !io.KeyCtrl) // LMB down event?
+        {
+          inputEvent(INPUT_EVENT_BASE, x, y, 0.0f);
           m_guiState = GUI_STATE_ORBIT;
         }
         else if (ImGui::IsMouseDown(1)) // RMB down event?
         {
-          m_camera.setBaseCoordinates(x, y);
+          inputEvent(INPUT_EVENT_BASE, x, y, 0.0f);
           m_guiState = GUI_STATE_DOLLY;
         }
         else if (ImGui::IsMouseDown(2)) // MMB down event?
         {
-          m_camera.setBaseCoordinates(x, y);
+          inputEvent(INPUT_EVENT_BASE, x, y, 0.0f);
           m_guiState = GUI_STATE_PAN;
         }
         else if (io.MouseWheel != 0.0f) // Mouse wheel zoom.
         {
-          m_camera.zoom(io.MouseWheel);
+          inputEvent(INPUT_EVENT_ZOOM, 0, 0, io.MouseWheel);
         }
       }
       break;
@@ -737,7 +1067,7 @@ void Application::guiEventHandler()
       }
       else
       {
-        m_camera.orbit(x, y);
+        inputEvent(INPUT_EVENT_ORBIT, x, y, 0.0f);
       }
       break;
 
@@ -748,7 +1078,7 @@ void Application::guiEventHandler()
       }
       else
       {
-        m_camera.dolly(x, y);
+        inputEvent(INPUT_EVENT_DOLLY, x, y, 0.0f);
       }
       break;
 
@@ -759,265 +1089,1157 @@ void Application::guiEventHandler()
       }
       else
       {
-        m_camera.pan(x, y);
+        inputEvent(INPUT_EVENT_PAN, x, y, 0.0f);
       }
       break;
   }
+
+  m_inputTrace.nextFrame();
 }
 
 
-void Application::guiWindow()
+// Record the interaction when recording an input trace and apply it.
+bool Application::inputEvent(const InputEventType type, const int x, const int y, const float value)
 {
-  if (!m_isVisibleGUI || m_mode == 1) // Use SPACE to toggle the display of the GUI window.
-  {
-    return;
-  }
+  m_inputTrace.record(type, x, y, value);
+
+  InputEvent event;
+
+  event.frame = 0;
+  event.time  = 0.0;
+  event.type  = type;
+  event.x     = x;
+  event.y     = y;
+  event.value = value;
 
+  return applyInputEvent(event);
+}
+
+bool Application::inputEventChanged(const InputParameter first, const int index, const float* current, const float* edited, const int count)
+{
   bool refresh = false;
 
-  ImGui::SetNextWindowSize(ImVec2(200, 200), ImGuiSetCond_FirstUseEver);
+  for (int i = 0; i < count; ++i)
+  {
+    if (edited[i] != current[i])
+    {
+      refresh |= inputEvent(INPUT_EVENT_PARAMETER, first + i, index, edited[i]);
+    }
+  }
+  return refresh;
+}
 
-  ImGuiWindowFlags window_flags = 0;
-  if (!ImGui::Begin("rtigo3", nullptr, window_flags)) // No bool flag to omit the close button.
+// Camera changes restart the accumulation in render(). Only parameter edits return true.
+bool Application::applyInputEvent(InputEvent const& event)
+{
+  switch (event.type)
   {
-    // Early out if the window is collapsed, as an optimization.
-    ImGui::End();
-    return;
+    case INPUT_EVENT_BASE:
+      m_camera.setBaseCoordinates(event.x, event.y);
+      break;
+
+    case INPUT_EVENT_ORBIT:
+      m_camera.orbit(event.x, event.y);
+      break;
+
+    case INPUT_EVENT_DOLLY:
+      m_camera.dolly(event.x, event.y);
+      break;
+
+    case INPUT_EVENT_PAN:
+      m_camera.pan(event.x, event.y);
+      break;
+
+    case INPUT_EVENT_ZOOM:
+      m_camera.zoom(event.value);
+      break;
+
+    case INPUT_EVENT_FOCUS:
+      pick(event.x, event.y, true);
+      break;
+
+    case INPUT_EVENT_SELECT:
+      m_picked = pick(event.x, event.y, false);
+      break;
+
+    case INPUT_EVENT_FRAME:
+      frameBounds(true);
+      break;
+
+    case INPUT_EVENT_PARAMETER:
+      return applyParameter(static_cast<InputParameter>(event.x), event.y, event.value);
+
+    case INPUT_EVENT_END:
+      break;
   }
+  return false;
+}
 
-  ImGui::PushItemWidth(-120); // Right-aligned, keep pixels for the labels.
+// Sets a GUI parameter like the widgets in guiWindow() and updates the renderer.
+// Applies the same limits as the widgets, because replayed traces don't pass through them.
+bool Application::applyParameter(const InputParameter parameter, const int index, const float value)
+{
+  const int  integer = static_cast<int>(value);
+  const bool enable  = (value != 0.0f);
 
-  if (ImGui::CollapsingHeader("System"))
+  bool isDirtyState = false; // m_state changed.
+  bool refresh      = false;
+
+  switch (parameter)
   {
-    if (ImGui::DragFloat("Mouse Ratio", &m_mouseSpeedRatio, 0.1f, 0.1f, 1000.0f, "%.1f"))
-    {
+    case INPUT_PARAMETER_MOUSE_RATIO:
+      m_mouseSpeedRatio = std::max(0.1f, value);
       m_camera.setSpeedRatio(m_mouseSpeedRatio);
-    }
-    if (ImGui::Checkbox("Present", &m_present))
-    {
-      // No action needed, happens automatically.
-    }
-    if (ImGui::Combo("Camera", (int*) &m_lensShader, "Pinhole\0Fisheye\0Spherical\0\0"))
-    {
+      break;
+
+    case INPUT_PARAMETER_PRESENT:
+      m_present = enable; // No action needed, happens automatically.
+      break;
+
+    case INPUT_PARAMETER_LENS_SHADER:
+      m_lensShader = static_cast<LensShader>(clamp(integer, 0, NUM_LENS_SHADERS - 1));
       m_state.lensShader = m_lensShader;
-      m_raytracer->updateState(m_state);
-      refresh = true;
-    }
-    if (ImGui::InputInt2("Resolution", &m_resolution.x, ImGuiInputTextFlags_EnterReturnsTrue)) // This requires RETURN to apply a new value.
-    {
-      m_resolution.x = std::max(1, m_resolution.x);
-      m_resolution.y = std::max(1, m_resolution.y);
+      isDirtyState = true;
+      break;
 
+    case INPUT_PARAMETER_RESOLUTION_X:
+    case INPUT_PARAMETER_RESOLUTION_Y:
+      if (parameter == INPUT_PARAMETER_RESOLUTION_X)
+      {
+        m_resolution.x = std::max(1, integer);
+      }
+      else
+      {
+        m_resolution.y = std::max(1, integer);
+      }
       m_camera.setResolution(m_resolution.x, m_resolution.y);
       m_rasterizer->setResolution(m_resolution.x, m_resolution.y);
       m_state.resolution = m_resolution;
-      m_raytracer->updateState(m_state);
+      if (m_viewLayout != VIEW_LAYOUT_SINGLE)
+      {
+        updateViews(); // The view rectangles depend on the resolution.
+      }
+      isDirtyState = true;
+      break;
+
+    case INPUT_PARAMETER_VIEW_LAYOUT:
+      m_viewLayout = clamp(integer, 0, VIEW_LAYOUT_COUNT - 1);
+      updateViews();
       refresh = true;
-    }
-    // bool ImGui::InputInt(const char* label, int* v, int step, int step_fast, ImGuiInputTextFlags extra_flags)
-    if (ImGui::InputInt("SamplesSqrt", &m_samplesSqrt, 0, 0, ImGuiInputTextFlags_EnterReturnsTrue))
-    {
-      m_samplesSqrt = clamp(m_samplesSqrt, 1, 256); // Samples per pixel are squares in the range [1, 65536].
-      m_state.samplesSqrt = m_samplesSqrt;
-      m_raytracer->updateState(m_state);
+      break;
+
+    case INPUT_PARAMETER_VIEW_GRID_X:
+    case INPUT_PARAMETER_VIEW_GRID_Y:
+      if (parameter == INPUT_PARAMETER_VIEW_GRID_X)
+      {
+        m_viewGrid.x = clamp(integer, 1, 64);
+      }
+      else
+      {
+        m_viewGrid.y = clamp(integer, 1, 64);
+      }
+      updateViews();
       refresh = true;
-    }
-    if (ImGui::DragInt2("Path Lengths", &m_pathLengths.x, 1.0f, 0, 100))
-    {
-      m_state.pathLengths = m_pathLengths;
-      m_raytracer->updateState(m_state);
+      break;
+
+    case INPUT_PARAMETER_VIEWS_SEQUENTIAL:
+      m_viewsSequential = enable;
+      m_raytracer->setViewsSequential(m_viewsSequential);
       refresh = true;
-    }
-    if (ImGui::DragFloat("Scene Epsilon", &m_epsilonFactor, 1.0f, 0.0f, 10000.0f))
-    {
-      m_state.epsilonFactor = m_epsilonFactor;
-      m_raytracer->updateState(m_state);
+      break;
+
+    case INPUT_PARAMETER_GRAPHS:
+      m_graphs = enable;
+      m_raytracer->setGraphs(m_graphs);
       refresh = true;
-    }
-    if (ImGui::DragFloat("Env Rotation", &m_environmentRotation, 0.001f, 0.0f, 1.0f))
-    {
+      break;
+
+    case INPUT_PARAMETER_SAMPLES_SQRT:
+      m_samplesSqrt = clamp(integer, 1, 256); // Samples per pixel are squares in the range [1, 65536].
+      m_state.samplesSqrt = m_samplesSqrt;
+      isDirtyState = true;
+      break;
+
+    case INPUT_PARAMETER_PATH_LENGTH_MIN:
+      m_pathLengths.x = clamp(integer, 0, 100);
+      m_state.pathLengths = m_pathLengths;
+      isDirtyState = true;
+      break;
+
+    case INPUT_PARAMETER_PATH_LENGTH_MAX:
+      m_pathLengths.y = clamp(integer, 0, 100);
+      m_state.pathLengths = m_pathLengths;
+      isDirtyState = true;
+      break;
+
+    case INPUT_PARAMETER_ROULETTE:
+      m_roulette = enable;
+      m_state.roulette = (m_roulette) ? 1 : 0;
+      isDirtyState = true;
+      break;
+
+    case INPUT_PARAMETER_TILED_ACCUMULATION:
+      m_tiledAccumulation = enable;
+      m_state.accumulationLayout = (m_tiledAccumulation) ? ACCUMULATION_LAYOUT_TILED : ACCUMULATION_LAYOUT_LINEAR;
+      isDirtyState = true;
+      break;
+
+    case INPUT_PARAMETER_EPSILON_FACTOR:
+      m_epsilonFactor = std::max(0.0f, value);
+      m_state.epsilonFactor = m_epsilonFactor;
+      isDirtyState = true;
+      break;
+
+    case INPUT_PARAMETER_ENV_ROTATION:
+      m_environmentRotation = value;
       m_state.envRotation = m_environmentRotation;
-      m_raytracer->updateState(m_state);
+      isDirtyState = true;
+      break;
+
+    case INPUT_PARAMETER_SPECIALIZE:
+      m_specialize = enable;
+      m_state.specialize = (m_specialize) ? 1 : 0;
+      isDirtyState = true;
+      break;
+
+    case INPUT_PARAMETER_TIME_VIEW:
+      m_timeView = enable;
+      m_state.timeView = (m_timeView) ? 1 : 0;
+      m_rasterizer->setTimeView(m_timeView);
+      isDirtyState = true;
+      break;
+
+    case INPUT_PARAMETER_CLOCK_FACTOR:
+      m_clockFactor = std::max(0.0f, value);
+      m_state.clockFactor = m_clockFactor;
+      isDirtyState = true;
+      break;
+
+    case INPUT_PARAMETER_AOV_MASK:
+      m_aovMask = static_cast<unsigned int>(integer) & ((1u << NUM_AOVS) - 1);
+      m_state.aovMask = m_aovMask;
+      isDirtyState = true;
+      break;
+
+    case INPUT_PARAMETER_BALANCE_R:
+    case INPUT_PARAMETER_BALANCE_G:
+    case INPUT_PARAMETER_BALANCE_B:
+      m_tonemapperGUI.colorBalance[parameter - INPUT_PARAMETER_BALANCE_R] = value;
+      m_rasterizer->setTonemapper(m_tonemapperGUI); // This doesn't need a refresh.
+      break;
+
+    case INPUT_PARAMETER_GAMMA:
+      m_tonemapperGUI.gamma = std::max(0.01f, value); // Must not get 0.0f
+      m_rasterizer->setTonemapper(m_tonemapperGUI);
+      break;
+
+    case INPUT_PARAMETER_WHITE_POINT:
+      m_tonemapperGUI.whitePoint = std::max(0.01f, value); // Must not get 0.0f
+      m_rasterizer->setTonemapper(m_tonemapperGUI);
+      break;
+
+    case INPUT_PARAMETER_BURN_HIGHLIGHTS:
+      m_tonemapperGUI.burnHighlights = value;
+      m_rasterizer->setTonemapper(m_tonemapperGUI);
+      break;
+
+    case INPUT_PARAMETER_CRUSH_BLACKS:
+      m_tonemapperGUI.crushBlacks = value;
+      m_rasterizer->setTonemapper(m_tonemapperGUI);
+      break;
+
+    case INPUT_PARAMETER_SATURATION:
+      m_tonemapperGUI.saturation = value;
+      m_rasterizer->setTonemapper(m_tonemapperGUI);
+      break;
+
+    case INPUT_PARAMETER_BRIGHTNESS:
+      m_tonemapperGUI.brightness = value;
+      m_rasterizer->setTonemapper(m_tonemapperGUI);
+      break;
+
+    case INPUT_PARAMETER_MATERIAL_BXDF:
+    case INPUT_PARAMETER_MATERIAL_ALBEDO_R:
+    case INPUT_PARAMETER_MATERIAL_ALBEDO_G:
+    case INPUT_PARAMETER_MATERIAL_ALBEDO_B:
+    case INPUT_PARAMETER_MATERIAL_ALBEDO_TEXTURE:
+    case INPUT_PARAMETER_MATERIAL_CUTOUT_TEXTURE:
+    case INPUT_PARAMETER_MATERIAL_THINWALLED:
+    case INPUT_PARAMETER_MATERIAL_ABSORPTION_R:
+    case INPUT_PARAMETER_MATERIAL_ABSORPTION_G:
+    case INPUT_PARAMETER_MATERIAL_ABSORPTION_B:
+    case INPUT_PARAMETER_MATERIAL_ABSORPTION_SCALE:
+    case INPUT_PARAMETER_MATERIAL_IOR:
+    case INPUT_PARAMETER_MATERIAL_ROUGHNESS_X:
+    case INPUT_PARAMETER_MATERIAL_ROUGHNESS_Y:
+    {
+      if (index < 0 || static_cast<int>(m_materialsGUI.size()) <= index)
+      {
+        return false; // A trace recorded with a different scene.
+      }
+
+      MaterialGUI& materialGUI = m_materialsGUI[index];
+
+      switch (parameter)
+      {
+        case INPUT_PARAMETER_MATERIAL_BXDF:
+          materialGUI.indexBSDF = static_cast<FunctionIndex>(clamp(integer, 0, NUM_BSDF_INDICES - 1));
+          break;
+        case INPUT_PARAMETER_MATERIAL_ALBEDO_R:
+          materialGUI.albedo.x = value;
+          break;
+        case INPUT_PARAMETER_MATERIAL_ALBEDO_G:
+          materialGUI.albedo.y = value;
+          break;
+        case INPUT_PARAMETER_MATERIAL_ALBEDO_B:
+          materialGUI.albedo.z = value;
+          break;
+        case INPUT_PARAMETER_MATERIAL_ALBEDO_TEXTURE:
+          materialGUI.useAlbedoTexture = enable;
+          break;
+        case INPUT_PARAMETER_MATERIAL_CUTOUT_TEXTURE:
+          materialGUI.useCutoutTexture = enable;
+          break;
+        case INPUT_PARAMETER_MATERIAL_THINWALLED:
+          materialGUI.thinwalled = enable;
+          break;
+        case INPUT_PARAMETER_MATERIAL_ABSORPTION_R:
+          materialGUI.absorptionColor.x = value;
+          break;
+        case INPUT_PARAMETER_MATERIAL_ABSORPTION_G:
+          materialGUI.absorptionColor.y = value;
+          break;
+        case INPUT_PARAMETER_MATERIAL_ABSORPTION_B:
+          materialGUI.absorptionColor.z = value;
+          break;
+        case INPUT_PARAMETER_MATERIAL_ABSORPTION_SCALE:
+          materialGUI.absorptionScale = value;
+          break;
+        case INPUT_PARAMETER_MATERIAL_IOR:
+          materialGUI.ior = value;
+          break;
+        case INPUT_PARAMETER_MATERIAL_ROUGHNESS_X:
+          // Clamp the microfacet roughness to working values minimum values.
+          // FIXME When both roughness values fall below that threshold, use INDEX_BSDF_SPECULAR_REFLECTION instead.
+          materialGUI.roughness.x = std::max(MICROFACET_MIN_ROUGHNESS, value);
+          break;
+        case INPUT_PARAMETER_MATERIAL_ROUGHNESS_Y:
+          materialGUI.roughness.y = std::max(MICROFACET_MIN_ROUGHNESS, value);
+          break;
+        default:
+          break;
+      }
+
+      m_raytracer->updateMaterial(index, materialGUI);
       refresh = true;
+      break;
     }
-#if USE_TIME_VIEW
-    if (ImGui::DragFloat("Clock Factor", &m_clockFactor, 1.0f, 0.0f, 1000000.0f, "%.0f"))
+
+    case INPUT_PARAMETER_LIGHT_EMISSION_R:
+    case INPUT_PARAMETER_LIGHT_EMISSION_G:
+    case INPUT_PARAMETER_LIGHT_EMISSION_B:
     {
-      m_state.clockFactor = m_clockFactor;
-      m_raytracer->updateState(m_state);
+      // Only the emission of the rectangle lights in the scene can be edited.
+      if (index < 0 || static_cast<int>(m_lights.size()) <= index || m_lights[index].type != LIGHT_PARALLELOGRAM)
+      {
+        return false;
+      }
+
+      LightDefinition& light = m_lights[index];
+
+      if (parameter == INPUT_PARAMETER_LIGHT_EMISSION_R)
+      {
+        light.emission.x = std::max(0.0f, value);
+      }
+      else if (parameter == INPUT_PARAMETER_LIGHT_EMISSION_G)
+      {
+        light.emission.y = std::max(0.0f, value);
+      }
+      else
+      {
+        light.emission.z = std::max(0.0f, value);
+      }
+
+      m_raytracer->updateLight(index, light);
       refresh = true;
+      break;
     }
-#endif
+
+    default:
+      break;
+  }
+
+  if (isDirtyState)
+  {
+    m_raytracer->updateState(m_state);
+    refresh = true;
   }
 
-#if !USE_TIME_VIEW
-  if (ImGui::CollapsingHeader("Tonemapper"))
+  return refresh;
+}
+
+// Apply the events of the next replay frame. The statistics are printed and saved once the trace has been replayed completely.
+void Application::replayInputEvents()
+{
+  if (m_inputReplay->isFinished())
   {
-    bool changed = false;
-    if (ImGui::ColorEdit3("Balance", (float*) &m_tonemapperGUI.colorBalance))
+    return;
+  }
+
+  std::vector<InputEvent> events;
+
+  m_inputReplay->nextFrame(m_iterationIndex, m_restarts, events);
+
+  bool refresh = false;
+
+  for (InputEvent const& event : events)
+  {
+    refresh |= applyInputEvent(event);
+  }
+
+  // Like guiWindow(), all parameter edits of a frame restart the accumulation once.
+  if (refresh)
+  {
+    restartRendering();
+  }
+
+  if (m_inputReplay->isFinished())
+  {
+    std::cout << m_inputReplay->getReport();
+
+    const std::string filename = m_filenameReplay + std::string(".csv");
+    if (m_inputReplay->saveFrames(filename))
     {
-      changed = true;
+      std::cout << filename << '\n'; // Print out the filename to indicate success.
     }
-    if (ImGui::DragFloat("Gamma", &m_tonemapperGUI.gamma, 0.01f, 0.01f, 10.0f)) // Must not get 0.0f
+  }
+}
+
+
+void Application::guiWindow()
+{
+  if (!m_isVisibleGUI || m_mode == 1) // Use SPACE to toggle the display of the GUI window.
+  {
+    return;
+  }
+
+  bool refresh = false;
+
+  ImGui::SetNextWindowSize(ImVec2(200, 200), ImGuiSetCond_FirstUseEver);
+
+  ImGuiWindowFlags window_flags = 0;
+  if (!ImGui::Begin("rtigo3", nullptr, window_flags)) // No bool flag to omit the close button.
+  {
+    // Early out if the window is collapsed, as an optimization.
+    ImGui::End();
+    return;
+  }
+
+  ImGui::PushItemWidth(-120); // Right-aligned, keep pixels for the labels.
+
+  // The widgets edit copies of the parameters. inputEvent() records the edits into an input trace and applies them with applyParameter().
+  if (ImGui::CollapsingHeader("System"))
+  {
+    float mouseSpeedRatio = m_mouseSpeedRatio;
+    if (ImGui::DragFloat("Mouse Ratio", &mouseSpeedRatio, 0.1f, 0.1f, 1000.0f, "%.1f"))
     {
-      changed = true;
+      refresh |= inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_MOUSE_RATIO, 0, mouseSpeedRatio);
     }
-    if (ImGui::DragFloat("White Point", &m_tonemapperGUI.whitePoint, 0.01f, 0.01f, 255.0f, "%.2f", 2.0f)) // Must not get 0.0f
+    bool present = m_present;
+    if (ImGui::Checkbox("Present", &present))
     {
-      changed = true;
+      refresh |= inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_PRESENT, 0, (present) ? 1.0f : 0.0f);
     }
-    if (ImGui::DragFloat("Burn Lights", &m_tonemapperGUI.burnHighlights, 0.01f, 0.0f, 10.0f, "%.2f"))
+    int lensShader = m_lensShader;
+    if (ImGui::Combo("Camera", &lensShader, "Pinhole\0Fisheye\0Spherical\0\0"))
     {
-      changed = true;
+      refresh |= inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_LENS_SHADER, 0, float(lensShader));
     }
-    if (ImGui::DragFloat("Crush Blacks", &m_tonemapperGUI.crushBlacks, 0.01f, 0.0f, 1.0f, "%.2f"))
+    int2 resolution = m_resolution;
+    if (ImGui::InputInt2("Resolution", &resolution.x, ImGuiInputTextFlags_EnterReturnsTrue)) // This requires RETURN to apply a new value.
     {
-      changed = true;
+      if (resolution.x != m_resolution.x)
+      {
+        refresh |= inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_RESOLUTION_X, 0, float(resolution.x));
+      }
+      if (resolution.y != m_resolution.y)
+      {
+        refresh |= inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_RESOLUTION_Y, 0, float(resolution.y));
+      }
     }
-    if (ImGui::DragFloat("Saturation", &m_tonemapperGUI.saturation, 0.01f, 0.0f, 10.0f, "%.2f"))
+    if (m_strategy != RS_INTERACTIVE_MULTI_GPU_LOCAL_COPY && m_strategy != RS_WAVEFRONT_SINGLE_GPU)
     {
-      changed = true;
+      int viewLayout = m_viewLayout;
+      if (ImGui::Combo("Views", &viewLayout, "Single\0Stereo\0Cube Map\0Grid\0\0"))
+      {
+        refresh |= inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_VIEW_LAYOUT, 0, float(viewLayout));
+      }
+      if (m_viewLayout == VIEW_LAYOUT_GRID)
+      {
+        int2 viewGrid = m_viewGrid;
+        if (ImGui::InputInt2("View Grid", &viewGrid.x, ImGuiInputTextFlags_EnterReturnsTrue))
+        {
+          if (viewGrid.x != m_viewGrid.x)
+          {
+            refresh |= inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_VIEW_GRID_X, 0, float(viewGrid.x));
+          }
+          if (viewGrid.y != m_viewGrid.y)
+          {
+            refresh |= inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_VIEW_GRID_Y, 0, float(viewGrid.y));
+          }
+        }
+      }
+      if (m_viewLayout != VIEW_LAYOUT_SINGLE)
+      {
+        bool viewsSequential = m_viewsSequential;
+        if (ImGui::Checkbox("Sequential Views", &viewsSequential))
+        {
+          refresh |= inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_VIEWS_SEQUENTIAL, 0, (viewsSequential) ? 1.0f : 0.0f);
+        }
+      }
     }
-    if (ImGui::DragFloat("Brightness", &m_tonemapperGUI.brightness, 0.01f, 0.0f, 100.0f, "%.2f", 2.0f))
+    bool graphs = m_graphs;
+    if (ImGui::Checkbox("CUDA Graphs", &graphs))
     {
-      changed = true;
+      refresh |= inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_GRAPHS, 0, (graphs) ? 1.0f : 0.0f);
     }
-    if (changed)
+    // bool ImGui::InputInt(const char* label, int* v, int step, int step_fast, ImGuiInputTextFlags extra_flags)
+    int samplesSqrt = m_samplesSqrt;
+    if (ImGui::InputInt("SamplesSqrt", &samplesSqrt, 0, 0, ImGuiInputTextFlags_EnterReturnsTrue))
     {
-      m_rasterizer->setTonemapper(m_tonemapperGUI); // This doesn't need a refresh.
+      refresh |= inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_SAMPLES_SQRT, 0, float(samplesSqrt));
+    }
+    int2 pathLengths = m_pathLengths;
+    if (ImGui::DragInt2("Path Lengths", &pathLengths.x, 1.0f, 0, 100))
+    {
+      if (pathLengths.x != m_pathLengths.x)
+      {
+        refresh |= inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_PATH_LENGTH_MIN, 0, float(pathLengths.x));
+      }
+      if (pathLengths.y != m_pathLengths.y)
+      {
+        refresh |= inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_PATH_LENGTH_MAX, 0, float(pathLengths.y));
+      }
+    }
+    bool roulette = m_roulette;
+    if (ImGui::Checkbox("Adaptive Roulette", &roulette))
+    {
+      refresh |= inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_ROULETTE, 0, (roulette) ? 1.0f : 0.0f);
+    }
+    if (m_strategy == RS_INTERACTIVE_MULTI_GPU_ZERO_COPY || m_strategy == RS_INTERACTIVE_MULTI_GPU_LOCAL_COPY)
+    {
+      bool tiledAccumulation = m_tiledAccumulation;
+      if (ImGui::Checkbox("Tiled Accumulation", &tiledAccumulation))
+      {
+        refresh |= inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_TILED_ACCUMULATION, 0, (tiledAccumulation) ? 1.0f : 0.0f);
+      }
+    }
+    float epsilonFactor = m_epsilonFactor;
+    if (ImGui::DragFloat("Scene Epsilon", &epsilonFactor, 1.0f, 0.0f, 10000.0f))
+    {
+      refresh |= inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_EPSILON_FACTOR, 0, epsilonFactor);
+    }
+    float environmentRotation = m_environmentRotation;
+    if (ImGui::DragFloat("Env Rotation", &environmentRotation, 0.001f, 0.0f, 1.0f))
+    {
+      refresh |= inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_ENV_ROTATION, 0, environmentRotation);
+    }
+    bool specialize = m_specialize;
+    if (ImGui::Checkbox("Specialize", &specialize))
+    {
+      refresh |= inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_SPECIALIZE, 0, (specialize) ? 1.0f : 0.0f);
+    }
+    bool timeView = m_timeView;
+    if (ImGui::Checkbox("Time View", &timeView))
+    {
+      refresh |= inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_TIME_VIEW, 0, (timeView) ? 1.0f : 0.0f);
+    }
+    if (m_timeView)
+    {
+      float clockFactor = m_clockFactor;
+      if (ImGui::DragFloat("Clock Factor", &clockFactor, 1.0f, 0.0f, 1000000.0f, "%.0f"))
+      {
+        refresh |= inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_CLOCK_FACTOR, 0, clockFactor);
+      }
+    }
+    if (ImGui::TreeNode("AOVs"))
+    {
+      unsigned int aovMask = m_aovMask;
+
+      ImGui::CheckboxFlags("Depth", &aovMask, AOV_DEPTH);
+      ImGui::CheckboxFlags("Normal", &aovMask, AOV_NORMAL);
+      ImGui::CheckboxFlags("Albedo", &aovMask, AOV_ALBEDO);
+      ImGui::CheckboxFlags("Instance ID", &aovMask, AOV_INSTANCE);
+      ImGui::CheckboxFlags("Material ID", &aovMask, AOV_MATERIAL);
+      ImGui::CheckboxFlags("Primitive ID", &aovMask, AOV_PRIMITIVE);
+      ImGui::CheckboxFlags("Direct/Indirect", &aovMask, AOV_DIRECT);
+
+      if (aovMask != m_aovMask)
+      {
+        refresh |= inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_AOV_MASK, 0, float(aovMask)); // Exact, the mask has NUM_AOVS bits.
+      }
+      ImGui::TreePop();
+    }
+    if (ImGui::TreeNode("Buffer Cache"))
+    {
+      std::vector<BufferCacheStatistics> statistics;
+
+      m_raytracer->getBufferCacheStatistics(statistics);
+
+      for (size_t i = 0; i < statistics.size(); ++i)
+      {
+        BufferCacheStatistics const& s = statistics[i];
+
+        const float mib = 1.0f / (1024.0f * 1024.0f);
+
+        ImGui::Text("Device %d", m_raytracer->m_activeDevices[i]->m_ordinal);
+        ImGui::Text("  hits %u, misses %u, evictions %u", (unsigned int) s.hits, (unsigned int) s.misses, (unsigned int) s.evictions);
+        ImGui::Text("  in use %.1f MiB, cached %.1f MiB, high-water %.1f MiB", float(s.bytesInUse) * mib, float(s.bytesCached) * mib, float(s.bytesHighWater) * mib);
+      }
+      if (ImGui::Button("Trim"))
+      {
+        m_raytracer->trimBufferCaches(); // Doesn't change the rendered image.
+      }
+      ImGui::TreePop();
+    }
+  }
+
+  if (!m_timeView && ImGui::CollapsingHeader("Tonemapper"))
+  {
+    // The tonemapper parameters don't need a refresh.
+    float colorBalance[3] = { m_tonemapperGUI.colorBalance[0], m_tonemapperGUI.colorBalance[1], m_tonemapperGUI.colorBalance[2] };
+    if (ImGui::ColorEdit3("Balance", colorBalance))
+    {
+      for (int i = 0; i < 3; ++i)
+      {
+        if (colorBalance[i] != m_tonemapperGUI.colorBalance[i])
+        {
+          inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_BALANCE_R + i, 0, colorBalance[i]);
+        }
+      }
+    }
+    float gamma = m_tonemapperGUI.gamma;
+    if (ImGui::DragFloat("Gamma", &gamma, 0.01f, 0.01f, 10.0f)) // Must not get 0.0f
+    {
+      inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_GAMMA, 0, gamma);
+    }
+    float whitePoint = m_tonemapperGUI.whitePoint;
+    if (ImGui::DragFloat("White Point", &whitePoint, 0.01f, 0.01f, 255.0f, "%.2f", 2.0f)) // Must not get 0.0f
+    {
+      inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_WHITE_POINT, 0, whitePoint);
+    }
+    float burnHighlights = m_tonemapperGUI.burnHighlights;
+    if (ImGui::DragFloat("Burn Lights", &burnHighlights, 0.01f, 0.0f, 10.0f, "%.2f"))
+    {
+      inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_BURN_HIGHLIGHTS, 0, burnHighlights);
+    }
+    float crushBlacks = m_tonemapperGUI.crushBlacks;
+    if (ImGui::DragFloat("Crush Blacks", &crushBlacks, 0.01f, 0.0f, 1.0f, "%.2f"))
+    {
+      inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_CRUSH_BLACKS, 0, crushBlacks);
+    }
+    float saturation = m_tonemapperGUI.saturation;
+    if (ImGui::DragFloat("Saturation", &saturation, 0.01f, 0.0f, 10.0f, "%.2f"))
+    {
+      inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_SATURATION, 0, saturation);
+    }
+    float brightness = m_tonemapperGUI.brightness;
+    if (ImGui::DragFloat("Brightness", &brightness, 0.01f, 0.0f, 100.0f, "%.2f", 2.0f))
+    {
+      inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_BRIGHTNESS, 0, brightness);
+    }
+  }
+  if (ImGui::CollapsingHeader("Materials"))
+  {
+    for (int i = 0; i < static_cast<int>(m_materialsGUI.size()); ++i)
+    {
+      MaterialGUI const& materialGUI = m_materialsGUI[i];
+
+      if (ImGui::TreeNode((void*)(intptr_t) i, "%s", m_materialsGUI[i].name.c_str()))
+      {
+        MaterialGUI edit = materialGUI;
+
+        if (ImGui::Combo("BxDF Type", (int*) &edit.indexBSDF, "BRDF Diffuse\0BRDF Specular\0BSDF Specular\0BRDF GGX Smith\0BSDF GGX Smith\0\0"))
+        {
+          refresh |= inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_MATERIAL_BXDF, i, float(edit.indexBSDF));
+        }
+        if (ImGui::ColorEdit3("Albedo", (float*) &edit.albedo))
+        {
+          refresh |= inputEventChanged(INPUT_PARAMETER_MATERIAL_ALBEDO_R, i, &materialGUI.albedo.x, &edit.albedo.x, 3);
+        }
+        if (ImGui::Checkbox("Use Albedo Texture", &edit.useAlbedoTexture))
+        {
+          refresh |= inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_MATERIAL_ALBEDO_TEXTURE, i, (edit.useAlbedoTexture) ? 1.0f : 0.0f);
+        }
+        if (ImGui::Checkbox("Use Cutout Texture", &edit.useCutoutTexture))
+        {
+          refresh |= inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_MATERIAL_CUTOUT_TEXTURE, i, (edit.useCutoutTexture) ? 1.0f : 0.0f);
+        }
+        if (ImGui::Checkbox("Thin-Walled", &edit.thinwalled)) // Set this to true when using cutout opacity!
+        {
+          refresh |= inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_MATERIAL_THINWALLED, i, (edit.thinwalled) ? 1.0f : 0.0f);
+        }	
+        // Only show material parameters for the BxDFs which are affected by IOR and volume absorption.
+        if (materialGUI.indexBSDF == INDEX_BSDF_SPECULAR ||
+            materialGUI.indexBSDF == INDEX_BSDF_GGX_SMITH)
+        {
+          if (ImGui::ColorEdit3("Absorption", (float*) &edit.absorptionColor)) 
+          {
+            refresh |= inputEventChanged(INPUT_PARAMETER_MATERIAL_ABSORPTION_R, i, &materialGUI.absorptionColor.x, &edit.absorptionColor.x, 3);
+          }
+          if (ImGui::DragFloat("Absorption Scale", &edit.absorptionScale, 0.01f, 0.0f, 1000.0f, "%.2f"))
+          {
+            refresh |= inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_MATERIAL_ABSORPTION_SCALE, i, edit.absorptionScale);
+          }
+          if (ImGui::DragFloat("IOR", &edit.ior, 0.01f, 0.0f, 10.0f, "%.2f"))
+          {
+            refresh |= inputEvent(INPUT_EVENT_PARAMETER, INPUT_PARAMETER_MATERIAL_IOR, i, edit.ior);
+          }
+        }
+        // Only show material parameters for the BxDFs which are affected by roughness.
+        if (materialGUI.indexBSDF == INDEX_BRDF_GGX_SMITH ||
+            materialGUI.indexBSDF == INDEX_BSDF_GGX_SMITH)
+        {
+          if (ImGui::DragFloat2("Roughness", reinterpret_cast<float*>(&edit.roughness), 0.001f, 0.0f, 1.0f, "%.3f"))
+          {
+            // applyParameter() clamps the roughness to MICROFACET_MIN_ROUGHNESS.
+            refresh |= inputEventChanged(INPUT_PARAMETER_MATERIAL_ROUGHNESS_X, i, &materialGUI.roughness.x, &edit.roughness.x, 2);
+          }
+        }
+        ImGui::TreePop();
+      }
+    }
+  }
+  if (ImGui::CollapsingHeader("Picking"))
+  {
+    if (!isReadyHostBVH())
+    {
+      ImGui::Text("Building host BVH...");
     }
+    else if (m_picked < 0)
+    {
+      ImGui::Text("Ctrl+LMB selects an instance.");
+    }
+    else
+    {
+      InstanceData const& data = m_pickInstances[m_picked];
+
+      ImGui::Text("Instance %d", m_picked);
+      ImGui::Text("Geometry %u", data.idGeometry);
+      if (0 <= data.idMaterial && data.idMaterial < static_cast<int>(m_materialsGUI.size()))
+      {
+        ImGui::Text("Material %s", m_materialsGUI[data.idMaterial].name.c_str());
+      }
+      if (0 <= data.idLight)
+      {
+        ImGui::Text("Light %d", data.idLight);
+      }
+    }
+    if (ImGui::Button("Frame Selection"))
+    {
+      frameBounds(true);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Frame Scene"))
+    {
+      frameBounds(false);
+    }
+  }
+  if (ImGui::CollapsingHeader("Lights"))
+  {
+    for (int i = 0; i < static_cast<int>(m_lights.size()); ++i)
+    {
+      LightDefinition const& light = m_lights[i];
+
+      // Allow to change the emission (radiant exitance in Watt/m^2 of the rectangle lights in the scene.
+      if (light.type == LIGHT_PARALLELOGRAM)
+      {
+        if (ImGui::TreeNode((void*)(intptr_t) i, "Light %d", i))
+        {
+          float3 emission = light.emission;
+          if (ImGui::DragFloat3("Emission", (float*) &emission, 0.1f, 0.0f, 10000.0f, "%.1f"))
+          {
+            refresh |= inputEventChanged(INPUT_PARAMETER_LIGHT_EMISSION_R, i, &light.emission.x, &emission.x, 3);
+          }
+          ImGui::TreePop();
+        }
+      }
+    }
+  }
+
+  ImGui::PopItemWidth();
+
+  ImGui::End();
+
+  if (refresh)
+  {
+    restartRendering();
+  }
+}
+
+void Application::guiRenderingIndicator(const bool isRendering)
+{
+  // NVIDIA Green when rendering is complete.
+  float r = 0.462745f;
+  float g = 0.72549f;
+  float b = 0.0f;
+  
+  if (isRendering)
+  {
+    // Neutral grey while rendering.
+    r = 1.0f;
+    g = 1.0f;
+    b = 1.0f;
+  }
+
+  ImGuiStyle& style = ImGui::GetStyle();
+
+  // Use the GUI window title bar color as rendering indicator. Green when rendering is completed.
+  style.Colors[ImGuiCol_TitleBg]          = ImVec4(r * 0.6f, g * 0.6f, b * 0.6f, 0.6f);
+  style.Colors[ImGuiCol_TitleBgCollapsed] = ImVec4(r * 0.4f, g * 0.4f, b * 0.4f, 0.4f);
+  style.Colors[ImGuiCol_TitleBgActive]    = ImVec4(r * 0.8f, g * 0.8f, b * 0.8f, 0.8f);
+}
+
+
+void Application::initHostBVH()
+{
+  m_hostBVH.clearInstances();
+  m_pickInstances.clear();
+  m_picked = -1;
+
+  // Each geometry is only converted once. Free the meshes of geometries a hot reload removed.
+  m_hostMeshes.resize(m_geometries.size(), -1);
+  for (size_t id = 0; id < m_hostMeshes.size(); ++id)
+  {
+    if (m_geometries[id] == nullptr && m_hostMeshes[id] != -1)
+    {
+      m_hostBVH.removeMesh(m_hostMeshes[id]);
+      m_hostMeshes[id] = -1;
+    }
+  }
+
+  const float matrix[12] = { 1.0f, 0.0f, 0.0f, 0.0f,
+                             0.0f, 1.0f, 0.0f, 0.0f,
+                             0.0f, 0.0f, 1.0f, 0.0f };
+
+  InstanceData data(~0u, -1, -1);
+
+  traverseHostBVH(m_scene, matrix, data);
+
+  m_sizeHostBVH = m_hostBVH.getMemoryUsage();
+
+  // The build only works on the triangle copies inside m_hostBVH. Picking is disabled until it has finished.
+  HostBVH* bvh = &m_hostBVH;
+  m_futureHostBVH = std::async(std::launch::async, [bvh]() { bvh->build(); });
+}
+
+// Must match Device::traverseNode() so that the host BVH instance indices are the device instance IDs.
+void Application::traverseHostBVH(std::shared_ptr<sg::Node> node, const float matrix[12], InstanceData data)
+{
+  switch (node->getType())
+  {
+    case sg::NodeType::NT_GROUP:
+    {
+      std::shared_ptr<sg::Group> group = std::dynamic_pointer_cast<sg::Group>(node);
+
+      for (size_t i = 0; i < group->getNumChildren(); ++i)
+      {
+        traverseHostBVH(group->getChild(i), matrix, data);
+      }
+    }
+    break;
+
+    case sg::NodeType::NT_INSTANCE:
+    {
+      std::shared_ptr<sg::Instance> instance = std::dynamic_pointer_cast<sg::Instance>(node);
+
+      float trafo[12];
+      dp::math::concatenateMatrices(matrix, instance->getTransform(), trafo, 1);
+
+      if (0 <= instance->getMaterial())
+      {
+        data.idMaterial = instance->getMaterial();
+      }
+      if (0 <= instance->getLight())
+      {
+        data.idLight = instance->getLight();
+      }
+
+      traverseHostBVH(instance->getChild(), trafo, data);
+    }
+    break;
+
+    case sg::NodeType::NT_TRIANGLES:
+    {
+      std::shared_ptr<sg::Triangles> geometry = std::dynamic_pointer_cast<sg::Triangles>(node);
+
+      data.idGeometry = geometry->getId();
+      MY_ASSERT(data.idGeometry < m_hostMeshes.size());
+
+      int& mesh = m_hostMeshes[data.idGeometry];
+
+      // Only geometries which were released before they got instanced need their cache file.
+      // Without it the instance is kept for the device instance ID mapping but can't be picked.
+      const bool isReleased = !geometry->isHostResident();
+      if (mesh == -1 && isReleased && !geometry->reloadHost())
+      {
+        std::cerr << "WARNING: traverseHostBVH() geometry " << data.idGeometry << " can't be picked.\n";
+        mesh = -2; // Warn only once. addInstance() marks negative meshes invalid.
+      }
+      else if (mesh == -1)
+      {
+        std::vector<TriangleAttributes> const& attributes = geometry->getAttributes();
+        std::vector<unsigned int>              independent;
+
+        // Only independent triangles need generated indices. Don't copy the existing ones.
+        if (geometry->getIndices().empty())
+        {
+          independent.resize(attributes.size() - attributes.size() % 3);
+          for (size_t i = 0; i < independent.size(); ++i)
+          {
+            independent[i] = static_cast<unsigned int>(i);
+          }
+        }
+        std::vector<unsigned int> const& indices = (geometry->getIndices().empty()) ? independent : geometry->getIndices();
+
+        // The vertex position is the first field of the TriangleAttributes.
+        mesh = m_hostBVH.addMesh(reinterpret_cast<const float*>(attributes.data()), sizeof(TriangleAttributes), attributes.size(), indices.data(), indices.size());
+
+        if (isReleased)
+        {
+          geometry->releaseHost(std::string()); // The cache file exists already.
+        }
+      }
+
+      m_hostBVH.addInstance(mesh, matrix);
+      m_pickInstances.push_back(data);
+    }
+    break;
+  }
+}
+
+bool Application::isReadyHostBVH()
+{
+  return m_futureHostBVH.valid() && m_futureHostBVH.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+// Host implementation of the lens shaders for the pixel under the window coordinate (x, y).
+bool Application::getPickRay(const int x, const int y, BvhRay& ray) const
+{
+  float u;
+  float v;
+
+  if (!m_rasterizer->mapWindowToImage(x, y, u, v))
+  {
+    return false; // Outside the displayed image.
+  }
+
+  const CameraDefinition& camera = m_cameras[0]; // The current camera, updated inside render().
+
+  const float2 screen   = make_float2(float(m_resolution.x), float(m_resolution.y));
+  const float2 fragment = make_float2(u, v) * screen;
+
+  float3 direction;
+
+  switch (m_lensShader)
+  {
+    case LENS_SHADER_PINHOLE:
+    default:
+    {
+      const float2 ndc = (fragment / screen) * 2.0f - 1.0f;
+
+      direction = normalize(camera.U * ndc.x + camera.V * ndc.y + camera.W);
+    }
+    break;
+
+    case LENS_SHADER_FISHEYE:
+    {
+      const float2 center = screen * 0.5f;
+      const float2 uv     = (fragment - center) / length(center);
+      const float  z      = cosf(length(uv) * 0.7071067812f * 0.5f * M_PIf);
+
+      direction = normalize(uv.x * normalize(camera.U) + uv.y * normalize(camera.V) + z * normalize(camera.W));
+    }
+    break;
+
+    case LENS_SHADER_SPHERE:
+    {
+      const float phi   = u * 2.0f * M_PIf;
+      const float theta = v * M_PIf;
+
+      const float sinTheta = sinf(theta);
+
+      const float3 d = make_float3(-sinf(phi) * sinTheta, -cosf(theta), -cosf(phi) * sinTheta);
+
+      direction = normalize(d.x * normalize(camera.U) + d.y * normalize(camera.V) + d.z * normalize(camera.W));
+    }
+    break;
+  }
+
+  ray.org[0] = camera.P.x;
+  ray.org[1] = camera.P.y;
+  ray.org[2] = camera.P.z;
+  ray.dir[0] = direction.x;
+  ray.dir[1] = direction.y;
+  ray.dir[2] = direction.z;
+  ray.tmin   = 0.0f;
+  ray.tmax   = RT_DEFAULT_MAX;
+
+  return true;
+}
+
+// Returns the instance index under the window coordinate (x, y) or -1.
+// With focus == true the center of interest is moved to the depth of the hit, keeping the camera position fixed.
+int Application::pick(const int x, const int y, const bool focus)
+{
+  BvhRay ray;
+
+  if (!isReadyHostBVH() || !getPickRay(x, y, ray))
+  {
+    return -1;
+  }
+
+  BvhHit hit;
+
+  if (!m_hostBVH.intersect(ray, hit))
+  {
+    return -1;
+  }
+
+  if (focus)
+  {
+    const float3 direction = make_float3(ray.dir[0], ray.dir[1], ray.dir[2]);
+
+    m_camera.setFocusDistance(hit.t * dot(direction, normalize(m_cameras[0].W)));
+  }
+
+  return hit.instance;
+}
+
+void Application::frameBounds(const bool selection)
+{
+  if (!isReadyHostBVH())
+  {
+    return;
+  }
+
+  BvhAabb box;
+
+  const bool valid = (selection && 0 <= m_picked) ? m_hostBVH.getInstanceBounds(m_picked, box) : m_hostBVH.getBounds(box);
+  if (valid)
+  {
+    m_camera.frame(make_float3(box.lo[0], box.lo[1], box.lo[2]), make_float3(box.hi[0], box.hi[1], box.hi[2]));
   }
-#endif // !USE_TIME_VIEW
-  if (ImGui::CollapsingHeader("Materials"))
+}
+
+// Shoots one pinhole camera ray per pixel of the current resolution through the host BVH and
+// compares a subset of the results against the brute force intersection of all triangles.
+void Application::benchmarkHostBVH()
+{
+  m_futureHostBVH.wait();
+
+  CameraDefinition camera;
+  m_camera.getFrustum(camera.P, camera.U, camera.V, camera.W, true);
+
+  std::vector<BvhRay> rays(size_t(m_resolution.x) * size_t(m_resolution.y));
+
+  for (int y = 0; y < m_resolution.y; ++y)
   {
-    for (int i = 0; i < static_cast<int>(m_materialsGUI.size()); ++i)
+    for (int x = 0; x < m_resolution.x; ++x)
     {
-      bool changed = false;
+      const float2 ndc = make_float2((float(x) + 0.5f) / float(m_resolution.x), (float(y) + 0.5f) / float(m_resolution.y)) * 2.0f - 1.0f;
+      const float3 dir = normalize(camera.U * ndc.x + camera.V * ndc.y + camera.W);
+
+      BvhRay& ray = rays[size_t(y) * size_t(m_resolution.x) + size_t(x)];
+
+      ray.org[0] = camera.P.x;
+      ray.org[1] = camera.P.y;
+      ray.org[2] = camera.P.z;
+      ray.dir[0] = dir.x;
+      ray.dir[1] = dir.y;
+      ray.dir[2] = dir.z;
+      ray.tmin   = 0.0f;
+      ray.tmax   = RT_DEFAULT_MAX;
+    }
+  }
 
-      MaterialGUI& materialGUI = m_materialsGUI[i];
+  std::vector<BvhHit> hits(rays.size());
 
-      if (ImGui::TreeNode((void*)(intptr_t) i, "%s", m_materialsGUI[i].name.c_str()))
-      {
+  size_t numHits = 0;
 
-        if (ImGui::Combo("BxDF Type", (int*) &materialGUI.indexBSDF, "BRDF Diffuse\0BRDF Specular\0BSDF Specular\0BRDF GGX Smith\0BSDF GGX Smith\0\0"))
-        {
-          changed = true;
-        }
-        if (ImGui::ColorEdit3("Albedo", (float*) &materialGUI.albedo))
-        {
-          changed = true;
-        }
-        if (ImGui::Checkbox("Use Albedo Texture", &materialGUI.useAlbedoTexture))
-        {
-          changed = true;
-        }
-        if (ImGui::Checkbox("Use Cutout Texture", &materialGUI.useCutoutTexture))
-        {
-          changed = true;
-        }
-        if (ImGui::Checkbox("Thin-Walled", &materialGUI.thinwalled)) // Set this to true when using cutout opacity!
-        {
-          changed = true;
-        }	
-        // Only show material parameters for the BxDFs which are affected by IOR and volume absorption.
-        if (materialGUI.indexBSDF == INDEX_BSDF_SPECULAR ||
-            materialGUI.indexBSDF == INDEX_BSDF_GGX_SMITH)
-        {
-          if (ImGui::ColorEdit3("Absorption", (float*) &materialGUI.absorptionColor)) 
-          {
-            changed = true;
-          }
-          if (ImGui::DragFloat("Absorption Scale", &materialGUI.absorptionScale, 0.01f, 0.0f, 1000.0f, "%.2f"))
-          {
-            changed = true;
-          }
-          if (ImGui::DragFloat("IOR", &materialGUI.ior, 0.01f, 0.0f, 10.0f, "%.2f"))
-          {
-            changed = true;
-          }
-        }
-        // Only show material parameters for the BxDFs which are affected by roughness.
-        if (materialGUI.indexBSDF == INDEX_BRDF_GGX_SMITH ||
-            materialGUI.indexBSDF == INDEX_BSDF_GGX_SMITH)
-        {
-          if (ImGui::DragFloat2("Roughness", reinterpret_cast<float*>(&materialGUI.roughness), 0.001f, 0.0f, 1.0f, "%.3f"))
-          {
-            // Clamp the microfacet roughness to working values minimum values.
-            // FIXME When both roughness values fall below that threshold, use INDEX_BSDF_SPECULAR_REFLECTION instead.
-            if (materialGUI.roughness.x < MICROFACET_MIN_ROUGHNESS)
-            {
-              materialGUI.roughness.x = MICROFACET_MIN_ROUGHNESS;
-            }
-            if (materialGUI.roughness.y < MICROFACET_MIN_ROUGHNESS)
-            {
-              materialGUI.roughness.y = MICROFACET_MIN_ROUGHNESS;
-            }
-            changed = true;
-          }
-        }
+  Timer timer;
 
-        if (changed)
-        {
-          m_raytracer->updateMaterial(i, materialGUI);
-          refresh = true;
-        }
-        ImGui::TreePop();
-      }
-    }
+  timer.restart();
+  for (size_t i = 0; i < rays.size(); ++i)
+  {
+    numHits += (m_hostBVH.intersect(rays[i], hits[i])) ? 1 : 0;
   }
-  if (ImGui::CollapsingHeader("Lights"))
+  const double timeTraversal = timer.getTime();
+
+  // Same rays through the batched ray query API, once with the host fallback and once on the GPUs.
+  std::vector<QueryRay> queries(rays.size());
+
+  for (size_t i = 0; i < rays.size(); ++i)
   {
-    for (int i = 0; i < static_cast<int>(m_lights.size()); ++i)
-    {
-      LightDefinition& light = m_lights[i];
+    QueryRay& query = queries[i];
 
-      // Allow to change the emission (radiant exitance in Watt/m^2 of the rectangle lights in the scene.
-      if (light.type == LIGHT_PARALLELOGRAM)
-      {
-        if (ImGui::TreeNode((void*)(intptr_t) i, "Light %d", i))
-        {
-          if (ImGui::DragFloat3("Emission", (float*) &light.emission, 0.1f, 0.0f, 10000.0f, "%.1f"))
-          {
-            m_raytracer->updateLight(i, light);
-            refresh = true;
-          }
-          ImGui::TreePop();
-        }
-      }
-    }
+    memcpy(query.origin,    rays[i].org, sizeof(float) * 3);
+    memcpy(query.direction, rays[i].dir, sizeof(float) * 3);
+    query.tmin  = rays[i].tmin;
+    query.tmax  = rays[i].tmax;
+    query.mask  = 0xFF;
+    query.flags = QUERY_FLAG_NONE;
   }
 
-  ImGui::PopItemWidth();
+  std::vector<QueryHit> hitsHost(queries.size());
 
-  ImGui::End();
+  timer.restart();
+  traceRaysHost(m_hostBVH, queries.data(), hitsHost.data(), queries.size());
+  const double timeQueryHost = timer.getTime();
 
-  if (refresh)
+  std::vector<QueryHit> hitsDevice;
+
+  m_raytracer->traceRays(queries, hitsDevice, &m_hostBVH); // Warmup, creates the query pipeline.
+  timer.restart();
+  m_raytracer->traceRays(queries, hitsDevice, &m_hostBVH);
+  const double timeQueryDevice = timer.getTime();
+
+  // Different intersection routines, only count disagreements which are not due to precision at triangle edges.
+  size_t numQueryMismatches = 0;
+
+  for (size_t i = 0; i < queries.size(); ++i)
   {
-    restartRendering();
+    if (hitsHost[i].instance != hitsDevice[i].instance ||
+        (hitsHost[i].instance != QUERY_MISS && 1.0e-3f * hitsHost[i].t < fabsf(hitsHost[i].t - hitsDevice[i].t)))
+    {
+      ++numQueryMismatches;
+    }
   }
+
+  std::ostringstream stream;
+  stream.precision(3);
+  stream << std::fixed;
+  stream << "HostBVH: " << m_hostBVH.getNumInstances() << " instances, " << m_hostBVH.getNumTriangles() << " triangles, "
+         << m_hostBVH.getMemoryUsage() / (1024 * 1024) << " MB\n";
+  stream << "{\n";
+  stream << "  Traversal  = " << rays.size() << " rays, " << numHits << " hits, " << double(rays.size()) / (timeTraversal * 1.0e6) << " Mrays/s\n";
+  stream << "  QueryHost  = " << double(queries.size()) / (timeQueryHost * 1.0e6) << " Mrays/s\n";
+  stream << "  QueryGPU   = " << double(queries.size()) / (timeQueryDevice * 1.0e6) << " Mrays/s including transfers, " << numQueryMismatches << " mismatches against the host\n";
+  stream << "}\n";
+  std::cout << stream.str();
 }
 
-void Application::guiRenderingIndicator(const bool isRendering)
+
+// Regenerates the view rectangles and view cameras from the interactive camera m_cameras[0].
+void Application::updateViews()
 {
-  // NVIDIA Green when rendering is complete.
-  float r = 0.462745f;
-  float g = 0.72549f;
-  float b = 0.0f;
-  
-  if (isRendering)
-  {
-    // Neutral grey while rendering.
-    r = 1.0f;
-    g = 1.0f;
-    b = 1.0f;
-  }
+  std::vector<CameraDefinition> cameras;
 
-  ImGuiStyle& style = ImGui::GetStyle();
+  createViewLayout(m_viewLayout, m_viewGrid, m_resolution, m_cameras[0], m_camera.m_center, cameras, m_views);
 
-  // Use the GUI window title bar color as rendering indicator. Green when rendering is completed.
-  style.Colors[ImGuiCol_TitleBg]          = ImVec4(r * 0.6f, g * 0.6f, b * 0.6f, 0.6f);
-  style.Colors[ImGuiCol_TitleBgCollapsed] = ImVec4(r * 0.4f, g * 0.4f, b * 0.4f, 0.4f);
-  style.Colors[ImGuiCol_TitleBgActive]    = ImVec4(r * 0.8f, g * 0.8f, b * 0.8f, 0.8f);
+  m_cameras.swap(cameras);
+
+  m_raytracer->initViews(m_cameras, m_views);
 }
 
 
@@ -1082,6 +2304,25 @@ bool Application::loadSystemDescription(std::string const& filename)
         MY_ASSERT(tokenType == PTT_VAL);
         m_present = (atoi(token.c_str()) != 0);
       }
+      else if (token == "hotReload")
+      {
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_hotReload = (atoi(token.c_str()) != 0);
+      }
+      else if (token == "hostResidency")
+      {
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_hostResidency = (atoi(token.c_str()) != 0);
+      }
+      else if (token == "hostCache")
+      {
+        tokenType = parser.getNextToken(token); // Needs to be a filename in quotation marks.
+        MY_ASSERT(tokenType == PTT_STRING);
+        convertPath(token);
+        m_prefixHostCache = token;
+      }
       else if (token == "resolution")
       {
         tokenType = parser.getNextToken(token);
@@ -1131,6 +2372,12 @@ bool Application::loadSystemDescription(std::string const& filename)
         convertPath(token);
         m_environment = token;
       }
+      else if (token == "envFormat")
+      {
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_envFormat = std::min(std::max(0, atoi(token.c_str())), NUM_ENV_FORMATS - 1);
+      }
       else  if (token == "envRotation")
       {
         tokenType = parser.getNextToken(token);
@@ -1182,6 +2429,107 @@ bool Application::loadSystemDescription(std::string const& filename)
           m_lensShader = LENS_SHADER_PINHOLE;
         }
       }
+      else if (token == "specialize")
+      {
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_specialize = (atoi(token.c_str()) != 0);
+      }
+      else if (token == "timeView")
+      {
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_timeView = (atoi(token.c_str()) != 0);
+      }
+      else if (token == "roulette")
+      {
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_roulette = (atoi(token.c_str()) != 0);
+      }
+      else if (token == "tiledAccumulation")
+      {
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_tiledAccumulation = (atoi(token.c_str()) != 0);
+      }
+      else if (findAovIndex(token) >= 0) // "aovDepth", "aovNormal", "aovAlbedo", "aovInstanceId", "aovMaterialId", "aovPrimitiveId", "aovDirect"
+      {
+        const unsigned int bit = 1u << findAovIndex(token);
+
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_aovMask = (atoi(token.c_str()) != 0) ? (m_aovMask | bit) : (m_aovMask & ~bit);
+      }
+      else if (token == "accelPolicy")
+      {
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_accelPolicy.mode = atoi(token.c_str());
+      }
+      else if (token == "accelBudget") // In MiB.
+      {
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_accelPolicy.budget = size_t(std::max(0, atoi(token.c_str()))) << 20;
+      }
+      else if (token == "accelFastTrace")
+      {
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_accelPolicy.fastTraceTriangles = (unsigned int) std::max(0, atoi(token.c_str()));
+      }
+      else if (token == "accelCompaction")
+      {
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_accelPolicy.compactionTriangles = (unsigned int) std::max(0, atoi(token.c_str()));
+      }
+      else if (token == "accelReserve")
+      {
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_accelPolicy.reserve = std::min(std::max(0.0f, (float) atof(token.c_str())), 1.0f);
+      }
+      else if (token == "accelUpdate")
+      {
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_accelPolicy.allowUpdate = (atoi(token.c_str()) != 0) ? 1 : 0;
+      }
+      else if (token == "bvhBenchmark")
+      {
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_bvhBenchmark = (atoi(token.c_str()) != 0);
+      }
+      else if (token == "viewLayout")
+      {
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_viewLayout = clamp(atoi(token.c_str()), 0, VIEW_LAYOUT_COUNT - 1);
+      }
+      else if (token == "viewGrid")
+      {
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_viewGrid.x = clamp(atoi(token.c_str()), 1, 64);
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_viewGrid.y = clamp(atoi(token.c_str()), 1, 64);
+      }
+      else if (token == "viewSequential")
+      {
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_viewsSequential = (atoi(token.c_str()) != 0);
+      }
+      else if (token == "graphs")
+      {
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        m_graphs = (atoi(token.c_str()) != 0);
+      }
       else if (token == "center")
       {
         tokenType = parser.getNextToken(token);
@@ -1285,6 +2633,9 @@ bool Application::saveSystemDescription()
   description << "devicesMask " << m_devicesMask << '\n';
   description << "interop " << m_interop << '\n';
   description << "present " << ((m_present) ? "1" : "0") << '\n';
+  description << "hotReload " << ((m_hotReload) ? "1" : "0") << '\n';
+  description << "hostResidency " << ((m_hostResidency) ? "1" : "0") << '\n';
+  description << "hostCache \"" << m_prefixHostCache << "\"\n";
   description << "resolution " << m_resolution.x << " " << m_resolution.y << '\n';
   description << "tileSize " << m_tileSize.x << " " << m_tileSize.y << '\n';
   description << "samplesSqrt " << m_samplesSqrt << '\n';
@@ -1293,12 +2644,32 @@ bool Application::saveSystemDescription()
   {
     description << "envMap \"" << m_environment << "\"\n";
   }
+  description << "envFormat " << m_envFormat << '\n';
   description << "envRotation " << m_environmentRotation << '\n';
+  description << "timeView " << ((m_timeView) ? "1" : "0") << '\n';
   description << "clockFactor " << m_clockFactor << '\n';
+  for (int i = 0; i < NUM_AOVS; ++i)
+  {
+    description << getAovOptionName(i) << " " << (((m_aovMask >> i) & 1u) ? "1" : "0") << '\n';
+  }
   description << "light " << m_light << '\n';
   description << "pathLengths " << m_pathLengths.x << " " << m_pathLengths.y << '\n';
+  description << "roulette " << ((m_roulette) ? "1" : "0") << '\n';
+  description << "tiledAccumulation " << ((m_tiledAccumulation) ? "1" : "0") << '\n';
   description << "epsilonFactor " << m_epsilonFactor << '\n';
   description << "lensShader " << m_lensShader << '\n';
+  description << "specialize " << ((m_specialize) ? "1" : "0") << '\n';
+  description << "accelPolicy " << m_accelPolicy.mode << '\n';
+  description << "accelBudget " << (m_accelPolicy.budget >> 20) << '\n';
+  description << "accelFastTrace " << m_accelPolicy.fastTraceTriangles << '\n';
+  description << "accelCompaction " << m_accelPolicy.compactionTriangles << '\n';
+  description << "accelReserve " << m_accelPolicy.reserve << '\n';
+  description << "accelUpdate " << m_accelPolicy.allowUpdate << '\n';
+  description << "bvhBenchmark " << ((m_bvhBenchmark) ? "1" : "0") << '\n';
+  description << "viewLayout " << m_viewLayout << '\n';
+  description << "viewGrid " << m_viewGrid.x << " " << m_viewGrid.y << '\n';
+  description << "viewSequential " << ((m_viewsSequential) ? "1" : "0") << '\n';
+  description << "graphs " << ((m_graphs) ? "1" : "0") << '\n';
   description << "center " << m_camera.m_center.x << " " << m_camera.m_center.y << " " << m_camera.m_center.z << '\n';
   description << "camera " << m_camera.m_phi << " " << m_camera.m_theta << " " << m_camera.m_fov << " " << m_camera.m_distance << '\n';
   if (!m_prefixScreenshot.empty())
@@ -1322,538 +2693,364 @@ bool Application::saveSystemDescription()
   return success;
 }
 
-void Application::appendInstance(std::shared_ptr<sg::Group>& group,
-                                 std::shared_ptr<sg::Triangles> geometry, 
-                                 dp::math::Mat44f const& matrix, 
-                                 std::string const& reference, 
-                                 unsigned int& idInstance)
+void Application::createMaterial(SceneMaterial const& material)
+{
+  // Create this material in the GUI.
+  const int indexMaterial = static_cast<int>(m_materialsGUI.size());
+
+  MaterialGUI materialGUI;
+
+  materialGUI.name = material.reference;
+
+  materialGUI.indexBSDF = INDEX_BRDF_DIFFUSE; // Set a default BSDF. // Base direct callable index for the BXDFs.
+  // Handle all cases to get the correct error.
+  // DAR FIXME Put these into a std::map and do a fined here.
+  if (material.name == std::string("brdf_diffuse"))
+  {
+    materialGUI.indexBSDF = INDEX_BRDF_DIFFUSE;
+  }
+  else if (material.name == std::string("brdf_specular"))
+  {
+    materialGUI.indexBSDF = INDEX_BRDF_SPECULAR;
+  }
+  else if (material.name == std::string("bsdf_specular"))
+  {
+    materialGUI.indexBSDF = INDEX_BSDF_SPECULAR;
+  }
+  else if (material.name == std::string("brdf_ggx_smith"))
+  {
+    materialGUI.indexBSDF = INDEX_BRDF_GGX_SMITH;
+  }
+  else if (material.name == std::string("bsdf_ggx_smith"))
+  {
+    materialGUI.indexBSDF = INDEX_BSDF_GGX_SMITH;
+  }
+  else
+  {
+    std::cerr << "WARNING: loadSceneDescription() unknown material " << material.name << '\n';
+  }
+
+  materialGUI.albedo           = material.albedo;
+  materialGUI.roughness        = material.roughness;
+  materialGUI.absorptionColor  = material.absorptionColor;
+  materialGUI.absorptionScale  = material.absorptionScale;
+  materialGUI.ior              = material.ior;
+  materialGUI.thinwalled       = material.thinwalled;
+  materialGUI.useAlbedoTexture = false;
+  materialGUI.useCutoutTexture = false;
+
+  m_materialsGUI.push_back(materialGUI); // at indexMaterial.
+
+  m_mapMaterialReferences[material.reference] = indexMaterial; // FIXME Change this to a full blown material system later.
+}
+
+
+bool Application::loadSceneDescription(std::string const& filename)
 {
-  // nvpro-pipeline matrices are row-major multiplied from the right, means the translation is in the last row. Transpose!
-  const float trafo[12] =
+  // FIXME Add a mechanism to specify albedo textures per material and make that resetable or add a push/pop mechanism for materials.
+  // E.g. special case filename "none" which translates to empty filename, which switches off albedo textures.
+  // Get rid of the single hardcoded texture and the toggle.
+
+  SceneInterpreter interpreter;
+
+  if (!interpreter.lex(filename))
+  {
+    return false;
+  }
+
+  interpreter.resolve();
+
+  SceneTarget target;
+
+  target.scene                 = m_scene;
+  target.geometries            = &m_geometries;
+  target.mapGeometries         = &m_mapGeometries;
+  target.mapMaterialReferences = &m_mapMaterialReferences;
+  target.idGeometry            = &m_idGeometry;
+  target.idInstance            = &m_idInstance;
+
+  target.createMaterial = [this](SceneMaterial const& material)
+  {
+    createMaterial(material);
+  };
+
+  target.createModel = [this](SceneModel const& model)
   {
-    matrix[0][0], matrix[1][0], matrix[2][0], matrix[3][0], 
-    matrix[0][1], matrix[1][1], matrix[2][1], matrix[3][1], 
-    matrix[0][2], matrix[1][2], matrix[2][2], matrix[3][2]
+    std::string filenameModel = model.filename;
+    convertPath(filenameModel);
+
+    return (model.type == SMT_ASSIMP) ? createASSIMP(filenameModel) : createGLTF(filenameModel);
   };
 
-  MY_ASSERT(matrix[0][3] == 0.0f && 
-            matrix[1][3] == 0.0f && 
-            matrix[2][3] == 0.0f && 
-            matrix[3][3] == 1.0f);
+  // The runtime generated geometries and their instances are built on all CPU cores.
+  if (!interpreter.expand(target, std::max(1u, std::thread::hardware_concurrency())))
+  {
+    return false;
+  }
+
+  std::cout << "loadSceneDescription(): m_idGroup = " << m_idGroup << ", m_idInstance = " << m_idInstance << ", m_idGeometry = " << m_idGeometry << '\n';
+
+  return true;
+}
+
+
+void Application::updateDeviceState()
+{
+  m_state.resolution    = m_resolution;
+  m_state.tileSize      = m_tileSize;
+  m_state.pathLengths   = m_pathLengths;
+  m_state.samplesSqrt   = m_samplesSqrt;
+  m_state.lensShader    = m_lensShader;
+  m_state.epsilonFactor = m_epsilonFactor;
+  m_state.envRotation   = m_environmentRotation;
+  m_state.envFormat     = m_envFormat;
+  m_state.clockFactor   = m_clockFactor;
+  m_state.specialize    = (m_specialize) ? 1 : 0;
+  m_state.timeView      = (m_timeView) ? 1 : 0;
+  m_state.roulette      = (m_roulette) ? 1 : 0;
+  m_state.accumulationLayout = (m_tiledAccumulation) ? ACCUMULATION_LAYOUT_TILED : ACCUMULATION_LAYOUT_LINEAR;
+  m_state.accelPolicy   = m_accelPolicy;
+  m_state.aovMask       = m_aovMask;
+}
+
+
+void Application::checkHotReload()
+{
+  if (m_timerHotReload.getTime() < 0.5)
+  {
+    return;
+  }
+  m_timerHotReload.restart();
+
+  // Editors often write files in multiple steps. A failed parse keeps the current state and the next change is picked up again.
+  const long long timeSystem = getFileTime(m_filenameSystem);
+  if (timeSystem != 0 && timeSystem != m_timeFileSystem)
+  {
+    m_timeFileSystem = timeSystem;
+    reloadSystemDescription();
+  }
+
+  const long long timeScene = getFileTime(m_filenameScene);
+  if (timeScene != 0 && timeScene != m_timeFileScene)
+  {
+    m_timeFileScene = timeScene;
+    reloadScene();
+  }
+}
+
+
+// Options which select the devices, the OpenGL interop or build the lights only take effect on the next start.
+// Everything else is applied through the same paths as the GUI.
+bool Application::reloadSystemDescription()
+{
+  const int         strategy    = m_strategy;
+  const int         devicesMask = m_devicesMask;
+  const int         interop     = m_interop;
+  const int         light       = m_light;
+  const int         miss        = m_miss;
+  const std::string environment = m_environment;
+  const int         envFormat   = m_envFormat;
+  const int2        resolution  = m_resolution;
+
+  if (!loadSystemDescription(m_filenameSystem))
+  {
+    return false;
+  }
+
+  if (m_strategy != strategy || m_devicesMask != devicesMask || m_interop != interop ||
+      m_light != light || m_miss != miss || m_environment != environment || m_envFormat != envFormat)
+  {
+    std::cerr << "WARNING: reloadSystemDescription() strategy, devicesMask, interop, light, miss, envMap and envFormat changes need a restart.\n";
 
-  std::shared_ptr<sg::Instance> instance(new sg::Instance(idInstance++));
-  instance->setTransform(trafo);
-  instance->setChild(geometry);
+    m_strategy    = strategy;
+    m_devicesMask = devicesMask;
+    m_interop     = interop;
+    m_light       = light;
+    m_miss        = miss;
+    m_environment = environment;
+    m_envFormat   = envFormat;
+  }
 
-  int indexMaterial = -1;
-  std::map<std::string, int>::const_iterator itm = m_mapMaterialReferences.find(reference);
-  if (itm != m_mapMaterialReferences.end())
+  if (m_viewLayout != VIEW_LAYOUT_SINGLE && (m_strategy == RS_INTERACTIVE_MULTI_GPU_LOCAL_COPY || m_strategy == RS_WAVEFRONT_SINGLE_GPU))
   {
-    indexMaterial = itm->second;
+    m_viewLayout = VIEW_LAYOUT_SINGLE;
   }
-  else
-  {
-    std::cerr << "WARNING: appendInstance() No material found for " << reference << ". Trying default.\n";
 
-    std::map<std::string, int>::const_iterator itmd = m_mapMaterialReferences.find(std::string("default"));
-    if (itmd != m_mapMaterialReferences.end())
-    {
-      indexMaterial = itmd->second;
-    }
-    else 
-    {
-      std::cerr << "ERROR: appendInstance() No default material found\n";
-    }
+  if (m_resolution != resolution)
+  {
+    m_camera.setResolution(m_resolution.x, m_resolution.y);
+    m_rasterizer->setResolution(m_resolution.x, m_resolution.y);
   }
 
-  instance->setMaterial(indexMaterial);
+  m_camera.setSpeedRatio(m_mouseSpeedRatio);
+  m_rasterizer->setTonemapper(m_tonemapperGUI);
+  m_rasterizer->setTimeView(m_timeView);
 
-  group->addChild(instance);
+  // Device::setState() only touches what changed.
+  updateDeviceState();
+  m_raytracer->updateState(m_state);
+
+  m_raytracer->setViewsSequential(m_viewsSequential);
+  m_raytracer->setGraphs(m_graphs);
+  updateViews();
+
+  std::cout << "reloadSystemDescription(): " << m_filenameSystem << '\n';
+
+  restartRendering();
+  return true;
 }
 
 
-bool Application::loadSceneDescription(std::string const& filename)
+// Parses the scene description again into fresh host containers and only sends the differences to the devices.
+// Geometries with the same construction parameters keep their geometry ID and with that their GAS.
+bool Application::reloadScene()
 {
-  Parser parser;
+  SceneDescription before;
 
-  if (!parser.load(filename))
-  {
-    std::cerr << "ERROR: loadSceneDescription() failed in loadString(" << filename << ")\n";
-    return false;
-  }
+  before.materials = m_materialsGUI;
+  before.lights    = m_lights;
+  flattenScene(m_scene, before.instances);
 
-  ParserTokenType tokenType;
-  std::string token;
+  // Everything the parser changes, to be able to roll back on errors.
+  const std::shared_ptr<sg::Group>                          scene                 = m_scene;
+  const std::vector<MaterialGUI>                            materialsGUI          = m_materialsGUI;
+  const std::vector<LightDefinition>                        lights                = m_lights;
+  const std::map<std::string, int>                          mapMaterialReferences = m_mapMaterialReferences;
+  const std::map<std::string, std::shared_ptr<sg::Group> > mapGroups             = m_mapGroups;
+  const std::vector< std::shared_ptr<sg::Triangles> >       geometries            = m_geometries;
+  const std::map<std::string, unsigned int>                 mapGeometries         = m_mapGeometries;
+  const unsigned int                                        idGeometry            = m_idGeometry;
 
-  // Reusing some math routines from the NVIDIA nvpro-pipeline https://github.com/nvpro-pipeline/pipeline
-  // Note that matrices in the nvpro-pipeline are defined row-major but are multiplied from the right,
-  // which means the order of transformations is simply from left to right matrix, means first matrix is applied first,
-  // but puts the translation into the last row elements (12 to 14).
-
-  std::stack<dp::math::Mat44f> stackMatrix;
-  std::stack<dp::math::Mat44f> stackInverse;      // DAR FIXME This will become important for arbitrary mesh lights.
-  std::stack<dp::math::Quatf>  stackOrientation;
-
-  // Initialize all current transformations with identity.
-  dp::math::Mat44f curMatrix(dp::math::cIdentity44f);      // object to world
-  dp::math::Mat44f curInverse(dp::math::cIdentity44f);     // world to object
-  dp::math::Quatf  curOrientation(0.0f, 0.0f, 0.0f, 1.0f); // object to world
-
-  // Material parameters.
-  float3 curAlbedo          = make_float3(1.0f);
-  float2 curRoughness       = make_float2(0.1f);
-  float3 curAbsorptionColor = make_float3(1.0f);
-  float  curAbsorptionScale = 0.0f; // 0.0f means off.
-  float  curIOR             = 1.5f;
-  bool   curThinwalled      = false;
-  
-  // FIXME Add a mechanism to specify albedo textures per material and make that resetable or add a push/pop mechanism for materials.
-  // E.g. special case filename "none" which translates to empty filename, which switches off albedo textures.
-  // Get rid of the single hardcoded texture and the toggle.
+  m_materialsGUI.clear();
+  m_lights.clear();
+  m_mapMaterialReferences.clear();
+  m_mapGroups.clear(); // Models are imported again because their material indices can change.
 
-  while ((tokenType = parser.getNextToken(token)) != PTT_EOF)
-  {
-    if (tokenType == PTT_UNKNOWN)
-    {
-      std::cerr << "ERROR: loadSceneDescription() " << filename << " (" << parser.getLine() << "): Unknown token type.\n";
-      MY_ASSERT(!"Unknown token type.");
-      return false;
-    }
+  m_scene = std::make_shared<sg::Group>(m_idGroup++);
 
-    if (tokenType == PTT_ID) 
-    {
-      std::map<std::string, KeywordScene>::const_iterator it = m_mapKeywordScene.find(token);
-      if (it == m_mapKeywordScene.end())
-      {
-        std::cerr << "loadSceneDescription(): Unknown token " << token << " ignored.\n";
-        // MY_ASSERT(!"loadSceneDescription(): Unknown token ignored.");
-        continue; // Just keep getting the next token until a known keyword is found.
-      }
+  createLights();
 
-      const KeywordScene keyword = it->second;
+  SceneDescription after;
 
-      switch (keyword)
-      {
-        case KS_ALBEDO:
-          tokenType = parser.getNextToken(token);
-          MY_ASSERT(tokenType == PTT_VAL);
-          curAlbedo.x = (float) atof(token.c_str());
-          tokenType = parser.getNextToken(token);
-          MY_ASSERT(tokenType == PTT_VAL);
-          curAlbedo.y = (float) atof(token.c_str());
-          tokenType = parser.getNextToken(token);
-          MY_ASSERT(tokenType == PTT_VAL);
-          curAlbedo.z = (float) atof(token.c_str());
-          break;
+  const bool success = loadSceneDescription(m_filenameScene);
+  if (success)
+  {
+    after.materials = m_materialsGUI;
+    after.lights    = m_lights;
+    flattenScene(m_scene, after.instances);
+  }
 
-        case KS_ROUGHNESS:
-          tokenType = parser.getNextToken(token);
-          MY_ASSERT(tokenType == PTT_VAL);
-          curRoughness.x = (float) atof(token.c_str());
-          tokenType = parser.getNextToken(token);
-          MY_ASSERT(tokenType == PTT_VAL);
-          curRoughness.y = (float) atof(token.c_str());
-          break;
+  if (!success || after.materials.empty() || after.instances.empty()) // The device code needs at least one material and one instance.
+  {
+    std::cerr << "ERROR: reloadScene() failed to load " << m_filenameScene << ". Keeping the current scene.\n";
 
-        case KS_ABSORPTION: // For convenience this is an absoption color used to calculate the absorption coefficient.
-          tokenType = parser.getNextToken(token);
-          MY_ASSERT(tokenType == PTT_VAL);
-          curAbsorptionColor.x = (float) atof(token.c_str());
-          tokenType = parser.getNextToken(token);
-          MY_ASSERT(tokenType == PTT_VAL);
-          curAbsorptionColor.y = (float) atof(token.c_str());
-          tokenType = parser.getNextToken(token);
-          MY_ASSERT(tokenType == PTT_VAL);
-          curAbsorptionColor.z = (float) atof(token.c_str());
-          break;
+    m_scene                 = scene;
+    m_materialsGUI          = materialsGUI;
+    m_lights                = lights;
+    m_mapMaterialReferences = mapMaterialReferences;
+    m_mapGroups             = mapGroups;
+    m_geometries            = geometries;
+    m_mapGeometries         = mapGeometries;
+    m_idGeometry            = idGeometry;
+    return false;
+  }
 
-        case KS_ABSORPTION_SCALE:
-          tokenType = parser.getNextToken(token);
-          MY_ASSERT(tokenType == PTT_VAL);
-          curAbsorptionScale = (float) atof(token.c_str());
-          break;
+  const SceneDiff diff = diffScenes(before, after);
 
-        case KS_IOR:
-          tokenType = parser.getNextToken(token);
-          MY_ASSERT(tokenType == PTT_VAL);
-          curIOR = (float) atof(token.c_str());
-          break;
+  std::cout << "reloadScene(): " << formatSceneDiff(diff) << '\n';
 
-        case KS_THINWALLED:
-          tokenType = parser.getNextToken(token);
-          MY_ASSERT(tokenType == PTT_VAL);
-          curThinwalled = (atoi(token.c_str()) != 0);
-          break;
+  if (isEmpty(diff))
+  {
+    return true;
+  }
 
-        case KS_MATERIAL:
-          {
-            std::string nameMaterialReference;
-            tokenType = parser.getNextToken(nameMaterialReference); // Internal material name. If there are duplicates the last name wins.
-            //MY_ASSERT(tokenType == PTT_ID); // Allow any type of identifier, including strings and numbers.
-
-            std::string nameMaterial;
-            tokenType = parser.getNextToken(nameMaterial); // The actual material name.
-            //MY_ASSERT(tokenType == PTT_ID); // Allow any type of identifier, including strings and numbers.
-
-            // Create this material in the GUI.
-            const int indexMaterial = static_cast<int>(m_materialsGUI.size());
-
-            MaterialGUI materialGUI;
-
-            materialGUI.name = nameMaterialReference;
-
-            materialGUI.indexBSDF = INDEX_BRDF_DIFFUSE; // Set a default BSDF. // Base direct callable index for the BXDFs.
-            // Handle all cases to get the correct error.
-            // DAR FIXME Put these into a std::map and do a fined here.
-            if (nameMaterial == std::string("brdf_diffuse"))
-            {
-              materialGUI.indexBSDF = INDEX_BRDF_DIFFUSE;
-            }
-            else if (nameMaterial == std::string("brdf_specular"))
-            {
-              materialGUI.indexBSDF = INDEX_BRDF_SPECULAR;
-            }
-            else if (nameMaterial == std::string("bsdf_specular"))
-            {
-              materialGUI.indexBSDF = INDEX_BSDF_SPECULAR;
-            }
-            else if (nameMaterial == std::string("brdf_ggx_smith"))
-            {
-              materialGUI.indexBSDF = INDEX_BRDF_GGX_SMITH;
-            }
-            else if (nameMaterial == std::string("bsdf_ggx_smith"))
-            {
-              materialGUI.indexBSDF = INDEX_BSDF_GGX_SMITH;
-            }
-            else
-            {
-              std::cerr << "WARNING: loadSceneDescription() unknown material " << nameMaterial << '\n';
-            }
-
-            materialGUI.albedo           = curAlbedo;
-            materialGUI.roughness        = curRoughness;
-            materialGUI.absorptionColor  = curAbsorptionColor;
-            materialGUI.absorptionScale  = curAbsorptionScale;
-            materialGUI.ior              = curIOR;
-            materialGUI.thinwalled       = curThinwalled;
-            materialGUI.useAlbedoTexture = false;
-            materialGUI.useCutoutTexture = false;
-
-            m_materialsGUI.push_back(materialGUI); // at indexMaterial.
-
-            m_mapMaterialReferences[nameMaterialReference] = indexMaterial; // FIXME Change this to a full blown material system later.
-          }
-          break;
+  // Release the host geometries which are not referenced anymore. Their IDs are not reused.
+  for (const unsigned int id : diff.geometriesRemoved)
+  {
+    m_geometries[id].reset();
+  }
+  for (std::map<std::string, unsigned int>::iterator it = m_mapGeometries.begin(); it != m_mapGeometries.end(); )
+  {
+    it = (m_geometries[it->second] == nullptr) ? m_mapGeometries.erase(it) : std::next(it);
+  }
 
-        case KS_IDENTITY:
-          curMatrix      = dp::math::cIdentity44f;
-          curInverse     = dp::math::cIdentity44f;
-          curOrientation = dp::math::Quatf(0.0f, 0.0f, 0.0f, 1.0f); // identity orientation
-          break;
+  if (diff.lightsResized)
+  {
+    m_raytracer->initLights(m_lights);
+  }
+  for (const int id : diff.lights)
+  {
+    m_raytracer->updateLight(id, m_lights[id]);
+  }
 
-        case KS_PUSH:
-          stackMatrix.push(curMatrix);
-          stackInverse.push(curInverse);
-          stackOrientation.push(curOrientation);
-          break;
+  // Materials first, the hit records of a rebuilt scene depend on their cutout textures.
+  if (diff.materialsResized)
+  {
+    m_raytracer->initMaterials(m_materialsGUI);
+  }
+  for (const int id : diff.materials)
+  {
+    m_raytracer->updateMaterial(id, m_materialsGUI[id]);
+  }
 
-        case KS_POP:
-          if (!stackMatrix.empty())
-          {
-            MY_ASSERT(!stackInverse.empty());
-            MY_ASSERT(!stackOrientation.empty());
-            curMatrix = stackMatrix.top();
-            stackMatrix.pop();
-            curInverse = stackInverse.top();
-            stackInverse.pop();
-            curOrientation = stackOrientation.top();
-            stackOrientation.pop();
-          }
-          else
-          {
-            std::cerr << "ERROR: loadSceneDescription() pop on empty stack. Resetting to identity.\n";
-            curMatrix      = dp::math::cIdentity44f;
-            curInverse     = dp::math::cIdentity44f;
-            curOrientation = dp::math::Quatf(0.0f, 0.0f, 0.0f, 1.0f); // identity orientation
-          }
-          break;
+  if (diff.instancesChanged || !diff.instancesMoved.empty())
+  {
+    // The devices only build the added geometries, which the parser just created on the host.
+    m_raytracer->updateScene(m_scene, m_idGeometry, diff);
 
-        case KS_ROTATE:
-          {
-            dp::math::Vec3f axis;
-
-            tokenType = parser.getNextToken(token);
-            MY_ASSERT(tokenType == PTT_VAL);
-            axis[0] = (float) atof(token.c_str());
-            tokenType = parser.getNextToken(token);
-            MY_ASSERT(tokenType == PTT_VAL);
-            axis[1] = (float) atof(token.c_str());
-            tokenType = parser.getNextToken(token);
-            MY_ASSERT(tokenType == PTT_VAL);
-            axis[2] = (float) atof(token.c_str());
-            axis.normalize();
-
-            tokenType = parser.getNextToken(token);
-            MY_ASSERT(tokenType == PTT_VAL);
-            const float angle = dp::math::degToRad((float) atof(token.c_str()));
-
-            dp::math::Quatf rotation(axis, angle);
-            curOrientation *= rotation;
-        
-            dp::math::Mat44f matrix(rotation, dp::math::Vec3f(0.0f, 0.0f, 0.0f)); // Zero translation to get a Mat44f back. 
-            curMatrix *= matrix; // DEBUG No need for the local matrix variable.
-        
-            // Inverse. Opposite order of matrix multiplications to make M * M^-1 = I.
-            dp::math::Quatf rotationInv(axis, -angle);
-            dp::math::Mat44f matrixInv(rotationInv, dp::math::Vec3f(0.0f, 0.0f, 0.0f)); // Zero translation to get a Mat44f back. 
-            curInverse = matrixInv * curInverse; // DEBUG No need for the local matrixInv variable.
-          }
-          break;
+    if (m_futureHostBVH.valid())
+    {
+      m_futureHostBVH.wait();
+    }
+    initHostBVH(); // Only converts the added geometries.
 
-        case KS_SCALE:
-          {
-            dp::math::Mat44f scaling(dp::math::cIdentity44f);
-
-            tokenType = parser.getNextToken(token);
-            MY_ASSERT(tokenType == PTT_VAL);
-            scaling[0][0] = (float) atof(token.c_str());
-            tokenType = parser.getNextToken(token);
-            MY_ASSERT(tokenType == PTT_VAL);
-            scaling[1][1] = (float) atof(token.c_str());
-            tokenType = parser.getNextToken(token);
-            MY_ASSERT(tokenType == PTT_VAL);
-            scaling[2][2] = (float) atof(token.c_str());
-
-            curMatrix *= scaling;
-
-            // Inverse. // DEBUG Requires scalings to not contain zeros.
-            scaling[0][0] = 1.0f / scaling[0][0];
-            scaling[1][1] = 1.0f / scaling[1][1];
-            scaling[2][2] = 1.0f / scaling[2][2];
-
-            curInverse = scaling * curInverse;
-          }
-          break;
+    if (m_hostResidency)
+    {
+      releaseHostData(); // Only writes the cache files of the added geometries.
+    }
+  }
 
-        case KS_TRANSLATE:
-          {
-            dp::math::Mat44f translation(dp::math::cIdentity44f);
-        
-            // Translation is in the third row in dp::math::Mat44f.
-            tokenType = parser.getNextToken(token);
-            MY_ASSERT(tokenType == PTT_VAL);
-            translation[3][0] = (float) atof(token.c_str());
-            tokenType = parser.getNextToken(token);
-            MY_ASSERT(tokenType == PTT_VAL);
-            translation[3][1] = (float) atof(token.c_str());
-            tokenType = parser.getNextToken(token);
-            MY_ASSERT(tokenType == PTT_VAL);
-            translation[3][2] = (float) atof(token.c_str());
-
-            curMatrix *= translation;
-
-            translation[3][0] = -translation[3][0];
-            translation[3][1] = -translation[3][1];
-            translation[3][2] = -translation[3][2];
-
-            curInverse = translation * curInverse;
-          }
-          break;
+  restartRendering();
+  return true;
+}
 
-        case KS_MODEL:
-          tokenType = parser.getNextToken(token);
-          MY_ASSERT(tokenType == PTT_ID);
-       
-          if (token == "plane")
-          {
-            tokenType = parser.getNextToken(token);
-            MY_ASSERT(tokenType == PTT_VAL);
-            const unsigned int tessU = atoi(token.c_str());
-
-            tokenType = parser.getNextToken(token);
-            MY_ASSERT(tokenType == PTT_VAL);
-            const unsigned int tessV = atoi(token.c_str());
-
-            tokenType = parser.getNextToken(token);
-            MY_ASSERT(tokenType == PTT_VAL);
-            const unsigned int upAxis = atoi(token.c_str());
-
-            std::string nameMaterialReference;
-            tokenType = parser.getNextToken(nameMaterialReference);
-                    
-            std::ostringstream keyGeometry;
-            keyGeometry << "plane_" << tessU << "_" << tessV << "_" << upAxis;
-
-            std::shared_ptr<sg::Triangles> geometry;
-
-            std::map<std::string, unsigned int>::const_iterator itg = m_mapGeometries.find(keyGeometry.str());
-            if (itg == m_mapGeometries.end())
-            {
-              m_mapGeometries[keyGeometry.str()] = m_idGeometry; // PERF Equal to static_cast<unsigned int>(m_geometries.size());
-
-              geometry = std::make_shared<sg::Triangles>(m_idGeometry++);
-              geometry->createPlane(tessU, tessV, upAxis);
-
-              m_geometries.push_back(geometry);
-            }
-            else
-            {
-              geometry = m_geometries[itg->second];
-            }
-
-            appendInstance(m_scene, geometry, curMatrix, nameMaterialReference, m_idInstance);
-          }
-          else if (token == "box")
-          {
-            std::string nameMaterialReference;
-            tokenType = parser.getNextToken(nameMaterialReference);
-          
-            // FIXME Implement tessellation. Must be a single value to get even distributions across edges.
-            std::string keyGeometry("box_1_1");
-
-            std::shared_ptr<sg::Triangles> geometry;
-
-            std::map<std::string, unsigned int>::const_iterator itg = m_mapGeometries.find(keyGeometry);
-            if (itg == m_mapGeometries.end())
-            {
-              m_mapGeometries[keyGeometry] = m_idGeometry;
-
-              geometry = std::make_shared<sg::Triangles>(m_idGeometry++);
-              geometry->createBox();
-
-              m_geometries.push_back(geometry);
-            }
-            else
-            {
-              geometry = m_geometries[itg->second];
-            }
-
-            appendInstance(m_scene, geometry, curMatrix, nameMaterialReference, m_idInstance);
-          }
-          else if (token == "sphere")
-          {
-            tokenType = parser.getNextToken(token);
-            MY_ASSERT(tokenType == PTT_VAL);
-            const unsigned int tessU = atoi(token.c_str());
-
-            tokenType = parser.getNextToken(token);
-            MY_ASSERT(tokenType == PTT_VAL);
-            const unsigned int tessV = atoi(token.c_str());
-
-            // Theta is in the range [0.0f, 1.0f] and 1.0f means closed sphere, smaller values open the noth pole.
-            tokenType = parser.getNextToken(token);
-            MY_ASSERT(tokenType == PTT_VAL);
-            const float theta = float(atof(token.c_str()));
-
-            std::string nameMaterialReference;
-            tokenType = parser.getNextToken(nameMaterialReference);
-                    
-            std::ostringstream keyGeometry;
-            keyGeometry << "sphere_" << tessU << "_" << tessV << "_" << theta;
-
-            std::shared_ptr<sg::Triangles> geometry;
-
-            std::map<std::string, unsigned int>::const_iterator itg = m_mapGeometries.find(keyGeometry.str());
-            if (itg == m_mapGeometries.end())
-            {
-              m_mapGeometries[keyGeometry.str()] = m_idGeometry;
-
-              geometry = std::make_shared<sg::Triangles>(m_idGeometry++);
-              geometry->createSphere(tessU, tessV, 1.0f, theta * M_PIf);
-
-              m_geometries.push_back(geometry);
-            }
-            else
-            {
-              geometry = m_geometries[itg->second];
-            }
-
-            appendInstance(m_scene, geometry, curMatrix, nameMaterialReference, m_idInstance);
-          }
-          else if (token == "torus")
-          {
-            tokenType = parser.getNextToken(token);
-            MY_ASSERT(tokenType == PTT_VAL);
-            const unsigned int tessU = atoi(token.c_str());
-
-            tokenType = parser.getNextToken(token);
-            MY_ASSERT(tokenType == PTT_VAL);
-            const unsigned int tessV = atoi(token.c_str());
-
-            tokenType = parser.getNextToken(token);
-            MY_ASSERT(tokenType == PTT_VAL);
-            const float innerRadius = float(atof(token.c_str()));
-
-            tokenType = parser.getNextToken(token);
-            MY_ASSERT(tokenType == PTT_VAL);
-            const float outerRadius = float(atof(token.c_str()));
-
-            std::string nameMaterialReference;
-            tokenType = parser.getNextToken(nameMaterialReference);
-                    
-            std::ostringstream keyGeometry;
-            keyGeometry << "torus_" << tessU << "_" << tessV << "_" << innerRadius << "_" << outerRadius;
-
-            std::shared_ptr<sg::Triangles> geometry;
-
-            std::map<std::string, unsigned int>::const_iterator itg = m_mapGeometries.find(keyGeometry.str());
-            if (itg == m_mapGeometries.end())
-            {
-              m_mapGeometries[keyGeometry.str()] = m_idGeometry;
-
-              geometry = std::make_shared<sg::Triangles>(m_idGeometry++);
-              geometry->createTorus(tessU, tessV, innerRadius, outerRadius);
-
-              m_geometries.push_back(geometry);
-            }
-            else
-            {
-              geometry = m_geometries[itg->second];
-            }
-
-            appendInstance(m_scene, geometry, curMatrix, nameMaterialReference, m_idInstance);
-          }
-          else if (token == "assimp")
-          {
-            std::string filenameModel;
-            tokenType = parser.getNextToken(filenameModel); // Needs to be a path in quotation marks.
-            MY_ASSERT(tokenType == PTT_STRING);
-            convertPath(filenameModel);
-
-            std::shared_ptr<sg::Group> model = createASSIMP(filenameModel);
-
-            // nvpro-pipeline matrices are row-major multiplied from the right, means the translation is in the last row. Transpose!
-            const float trafo[12] =
-            {
-              curMatrix[0][0], curMatrix[1][0], curMatrix[2][0], curMatrix[3][0], 
-              curMatrix[0][1], curMatrix[1][1], curMatrix[2][1], curMatrix[3][1], 
-              curMatrix[0][2], curMatrix[1][2], curMatrix[2][2], curMatrix[3][2]
-            };
-
-            MY_ASSERT(curMatrix[0][3] == 0.0f && 
-                      curMatrix[1][3] == 0.0f && 
-                      curMatrix[2][3] == 0.0f && 
-                      curMatrix[3][3] == 1.0f);
-
-            std::shared_ptr<sg::Instance> instance(new sg::Instance(m_idInstance++));
-            instance->setTransform(trafo);
-            instance->setChild(model);
-
-            m_scene->addChild(instance);
-          }
-          break;
 
-        default:
-          std::cerr << "ERROR: loadSceneDescription() Unexpected KeywordScene value " << keyword << " ignored.\n";
-          MY_ASSERT(!"ERROR: loadSceneDescription() Unexpected KeywordScene value");
-          break;
+void Application::releaseHostData()
+{
+  size_t sizeGeometry = 0;
+  size_t sizePictures = 0;
+
+  for (std::shared_ptr<sg::Triangles> const& geometry : m_geometries)
+  {
+    if (geometry != nullptr && geometry->isHostResident())
+    {
+      std::ostringstream filename;
+      filename << m_prefixHostCache << geometry->getId() << ".bin";
+
+      const size_t size = geometry->getHostSizeInBytes();
+      if (geometry->releaseHost(filename.str()))
+      {
+        sizeGeometry += size;
       }
     }
   }
 
-  std::cout << "loadSceneDescription(): m_idGroup = " << m_idGroup << ", m_idInstance = " << m_idInstance << ", m_idGeometry = " << m_idGeometry << '\n';
+  // Only initTextures() reads the pictures.
+  for (std::map<std::string, Picture*>::const_iterator it = m_mapPictures.begin(); it != m_mapPictures.end(); ++it)
+  {
+    const size_t size = it->second->getSizeInBytes();
+    if (it->second->isResident() && it->second->release())
+    {
+      sizePictures += size;
+    }
+  }
 
-  return true;
+  size_t memoryCurrent;
+  size_t memoryPeak;
+
+  getMemoryUsage(memoryCurrent, memoryPeak);
+  std::cout << "releaseHostData(): geometry = " << sizeGeometry / (1024 * 1024) << " MB, pictures = " << sizePictures / (1024 * 1024)
+            << " MB, host BVH triangle copies = " << m_sizeHostBVH / (1024 * 1024) << " MB, host memory current = " << memoryCurrent / (1024 * 1024) << " MB, peak = " << memoryPeak / (1024 * 1024) << " MB\n";
 }
 
 
@@ -1991,36 +3188,6 @@ std::string Application::getDateTime()
 }
 
 
-static void updateAABB(float3& minimum, float3& maximum, float3 const& v)
-{
-  if (v.x < minimum.x)
-  {
-    minimum.x = v.x;
-  }
-  else if (maximum.x < v.x)
-  {
-    maximum.x = v.x;
-  }
-
-  if (v.y < minimum.y)
-  {
-    minimum.y = v.y;
-  }
-  else if (maximum.y < v.y)
-  {
-    maximum.y = v.y;
-  }
-
-  if (v.z < minimum.z)
-  {
-    minimum.z = v.z;
-  }
-  else if (maximum.z < v.z)
-  {
-    maximum.z = v.z;
-  }
-}
-
 //static void calculateTexcoordsSpherical(std::vector<InterleavedHost>& attributes, std::vector<unsigned int> const& indices)
 //{
 //  dp::math::Vec3f center(0.0f, 0.0f, 0.0f);
@@ -2124,89 +3291,6 @@ static void updateAABB(float3& minimum, float3& maximum, float3 const& v)
 //}
 
 
-// Calculate (geometry) tangents with the global tangent direction aligned to the biggest AABB extend of this part.
-void Application::calculateTangents(std::vector<TriangleAttributes>& attributes, std::vector<unsigned int> const& indices)
-{
-  MY_ASSERT(3 <= indices.size());
-
-  // Initialize with the first vertex to be able to use else-if comparisons in updateAABB().
-  float3 aabbLo = attributes[indices[0]].vertex;
-  float3 aabbHi = attributes[indices[0]].vertex;
-
-  // Build an axis aligned bounding box.
-  for (size_t i = 0; i < indices.size(); i += 3)
-  {
-    unsigned int i0 = indices[i    ];
-    unsigned int i1 = indices[i + 1];
-    unsigned int i2 = indices[i + 2];
-
-    updateAABB(aabbLo, aabbHi, attributes[i0].vertex);
-    updateAABB(aabbLo, aabbHi, attributes[i1].vertex);
-    updateAABB(aabbLo, aabbHi, attributes[i2].vertex);
-  }
-
-  // Get the longest extend and use that as general tangent direction.
-  const float3 extents = aabbHi - aabbLo;
-  
-  float f = extents.x;
-  int maxComponent = 0;
-
-  if (f < extents.y)
-  {
-    f = extents.y;
-    maxComponent = 1;
-  }
-  if (f < extents.z)
-  {
-    maxComponent = 2;
-  }
-
-  float3 direction;
-  float3 bidirection;
-
-  switch (maxComponent)
-  {
-  case 0: // x-axis
-  default:
-    direction   = make_float3(1.0f, 0.0f, 0.0f);
-    bidirection = make_float3(0.0f, 1.0f, 0.0f);
-    break;
-  case 1: // y-axis // DEBUG It might make sense to keep these directions aligned to the global coordinate system. Use the same coordinates as for z-axis then.
-    direction   = make_float3(0.0f, 1.0f, 0.0f); 
-    bidirection = make_float3(0.0f, 0.0f, -1.0f);
-    break;
-  case 2: // z-axis
-    direction   = make_float3(0.0f, 0.0f, -1.0f);
-    bidirection = make_float3(0.0f, 1.0f,  0.0f);
-    break;
-  }
-
-  // Build an ortho-normal basis with the existing normal.
-  for (size_t i = 0; i < attributes.size(); ++i)
-  {
-    float3 tangent   = direction;
-    float3 bitangent = bidirection;
-    // float3 normal    = attributes[i].normal;
-    float3 normal;
-    normal.x = attributes[i].normal.x;
-    normal.y = attributes[i].normal.y;
-    normal.z = attributes[i].normal.z;
-
-    if (0.001f < 1.0f - fabsf(dot(normal, tangent)))
-    {
-      bitangent = normalize(cross(normal, tangent));
-      tangent   = normalize(cross(bitangent, normal));
-    }
-    else // Normal and tangent direction too collinear.
-    {
-      MY_ASSERT(0.001f < 1.0f - fabsf(dot(bitangent, normal)));
-      tangent   = normalize(cross(bitangent, normal));
-      //bitangent = normalize(cross(normal, tangent));
-    }
-    attributes[i].tangent = tangent;
-  }
-}
-
 bool Application::screenshot(const bool tonemap)
 {
   ILboolean hasImage = false;
@@ -2238,42 +3322,7 @@ bool Application::screenshot(const bool tonemap)
     {
       uchar3* dst = reinterpret_cast<uchar3*>(ilGetData());
 
-      const float  invGamma       = 1.0f / m_tonemapperGUI.gamma;
-      const float3 colorBalance   = make_float3(m_tonemapperGUI.colorBalance[0], m_tonemapperGUI.colorBalance[1], m_tonemapperGUI.colorBalance[2]);
-      const float  invWhitePoint  = m_tonemapperGUI.brightness / m_tonemapperGUI.whitePoint;
-      const float  burnHighlights = m_tonemapperGUI.burnHighlights;
-      const float  crushBlacks    = m_tonemapperGUI.crushBlacks + m_tonemapperGUI.crushBlacks + 1.0f;
-      const float  saturation     = m_tonemapperGUI.saturation;
-
-      for (int y = 0; y < m_resolution.y; ++y)
-      {
-        for (int x = 0; x < m_resolution.x; ++x)
-        {
-          const int idx = y * m_resolution.x + x;
-
-          // Tonemapper. // PERF Add a native CUDA kernel doing this.
-          float3 hdrColor = make_float3(bufferHost[idx]);
-          float3 ldrColor = invWhitePoint * colorBalance * hdrColor;
-          ldrColor       *= ((ldrColor * burnHighlights) + 1.0f) / (ldrColor + 1.0f);
-          
-          float luminance = dot(ldrColor, make_float3(0.3f, 0.59f, 0.11f));
-          ldrColor = lerp(make_float3(luminance), ldrColor, saturation); // This can generate negative values for saturation > 1.0f!
-          ldrColor = fmaxf(make_float3(0.0f), ldrColor); // Prevent negative values.
-
-          luminance = dot(ldrColor, make_float3(0.3f, 0.59f, 0.11f));
-          if (luminance < 1.0f)
-          {
-            const float3 crushed = powf(ldrColor, crushBlacks);
-            ldrColor = lerp(crushed, ldrColor, sqrtf(luminance));
-            ldrColor = fmaxf(make_float3(0.0f), ldrColor); // Prevent negative values.
-          }
-          ldrColor = clamp(powf(ldrColor, invGamma), 0.0f, 1.0f); // Saturate, clamp to range [0.0f, 1.0f].
-
-          dst[idx] = make_uchar3((unsigned char) (ldrColor.x * 255.0f),
-                                 (unsigned char) (ldrColor.y * 255.0f),
-                                 (unsigned char) (ldrColor.z * 255.0f));
-        }
-      }
+      tonemap(m_tonemapperGUI, bufferHost, dst, size_t(m_resolution.x) * size_t(m_resolution.y));
       hasImage = true;
     }
   }
@@ -2317,6 +3366,135 @@ bool Application::screenshot(const bool tonemap)
 }
 
 
+bool Application::saveTimeView()
+{
+  std::vector<float>        cycles;
+  std::vector<unsigned int> ids;
+
+  m_raytracer->getTimeViewHost(cycles, ids);
+
+  TimeViewReport report;
+
+  if (!analyzeTimeView(cycles, ids, m_resolution.x, m_resolution.y, m_tileSize.x, m_tileSize.y, 32, 16, report))
+  {
+    std::cerr << "ERROR: saveTimeView() No time view data available\n";
+    return false;
+  }
+
+  std::vector<std::string> materialNames;
+  for (size_t i = 0; i < m_materialsGUI.size(); ++i)
+  {
+    materialNames.push_back(m_materialsGUI[i].name);
+  }
+
+  const int spp = m_samplesSqrt * m_samplesSqrt;
+
+  std::ostringstream path;
+   
+  path << m_prefixScreenshot << "_time_" << spp << "spp_" << getDateTime();
+
+  std::string filename = path.str() + ".csv";
+  convertPath(filename);
+
+  if (!saveString(filename, formatTimeViewCSV(report, materialNames)))
+  {
+    return false;
+  }
+  std::cout << filename << '\n';
+
+  // Store the raw cycles per pixel as grayscale float image. The *.hdr format needs RGB.
+  unsigned int imageID;
+
+  ilGenImages(1, (ILuint *) &imageID);
+
+  ilBindImage(imageID);
+  ilActiveImage(0);
+  ilActiveFace(0);
+
+  ilDisable(IL_ORIGIN_SET);
+
+  bool success = false;
+
+  if (ilTexImage(m_resolution.x, m_resolution.y, 1, 3, IL_RGB, IL_FLOAT, nullptr))
+  {
+    float3* dst = reinterpret_cast<float3*>(ilGetData());
+
+    for (size_t i = 0; i < cycles.size(); ++i)
+    {
+      dst[i] = make_float3(cycles[i]);
+    }
+
+    ilEnable(IL_FILE_OVERWRITE);
+
+    filename = path.str() + ".hdr";
+    convertPath(filename);
+
+    success = (ilSaveImage((const ILstring) filename.c_str()) != 0);
+  }
+
+  if (success)
+  {
+    std::cout << filename << '\n';
+  }
+  else
+  {
+    ILenum error = ilGetError();
+    std::cerr << "ERROR: saveTimeView() failed with IL error " << error << '\n';
+
+    while (ilGetError() != IL_NO_ERROR) // Clean up errors.
+    {
+    }
+  }
+
+  ilDeleteImages(1, &imageID);
+
+  return success;
+}
+
+
+// Writes the linear beauty output and all enabled AOVs as layers of one uncompressed *.exr file.
+bool Application::saveAovs()
+{
+  const int    width     = m_resolution.x;
+  const size_t numPixels = size_t(m_resolution.x) * size_t(m_resolution.y);
+
+  const float4* beauty = reinterpret_cast<const float4*>(m_raytracer->getOutputBufferHost());
+
+  std::vector<unsigned char> aovs[NUM_AOVS];
+  std::vector<float4>        indirect;
+
+  for (int i = 0; i < NUM_AOVS; ++i)
+  {
+    if (m_aovMask & (1u << i))
+    {
+      m_raytracer->getAovHost(i, aovs[i]);
+    }
+  }
+
+  std::vector<ExrChannel> channels;
+
+  getAovChannels(m_aovMask, beauty, aovs, numPixels, indirect, channels);
+
+  const int spp = m_samplesSqrt * m_samplesSqrt;
+
+  std::ostringstream path;
+
+  path << m_prefixScreenshot << "_" << spp << "spp_" << getDateTime() << "_aov.exr";
+
+  std::string filename = path.str();
+  convertPath(filename);
+
+  if (!saveEXR(filename, width, m_resolution.y, channels))
+  {
+    std::cerr << "ERROR: saveAovs() failed to write " << filename << '\n';
+    return false;
+  }
+
+  std::cout << filename << '\n';
+  return true;
+}
+
+
 // Convert between slashes and backslashes in paths depending on the operating system
 void Application::convertPath(std::string& path)
 {
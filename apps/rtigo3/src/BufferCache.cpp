@@ -0,0 +1,214 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/BufferCache.h"
+
+#include "inc/CheckMacros.h"
+#include "inc/MyAssert.h"
+
+#include <algorithm>
+#include <iostream>
+
+
+// All blocks are multiples of this. cuMemAlloc() returns 256 byte aligned addresses anyway.
+#define BUFFER_CACHE_GRANULARITY 256
+
+
+BufferCache::BufferCache()
+: m_tick(0)
+, m_isPending(false)
+{
+}
+
+BufferCache::~BufferCache()
+{
+  MY_ASSERT(m_blocksInUse.empty());
+
+  trim();
+}
+
+size_t BufferCache::getSizeClass(const size_t size)
+{
+  size_t sizeClass = (std::max(size, size_t(1)) + BUFFER_CACHE_GRANULARITY - 1) & ~size_t(BUFFER_CACHE_GRANULARITY - 1);
+
+  // Four size classes per power of two limit the unused tail of a block to less than 25 percent.
+  size_t power = BUFFER_CACHE_GRANULARITY;
+  while (power * 2 <= sizeClass)
+  {
+    power *= 2;
+  }
+
+  const size_t step = std::max(power / 4, size_t(BUFFER_CACHE_GRANULARITY));
+
+  sizeClass = (sizeClass + step - 1) / step * step;
+
+  return sizeClass;
+}
+
+CUdeviceptr BufferCache::alloc(const size_t size)
+{
+  const size_t sizeClass = getSizeClass(size);
+
+  CUdeviceptr ptr = 0;
+
+  std::map<size_t, std::vector<CachedBlock> >::iterator it = m_bins.find(sizeClass);
+  if (it != m_bins.end())
+  {
+    // Take the most recently freed block, which is the most likely one to be still resident in the caches.
+    ptr = it->second.back().ptr;
+    it->second.pop_back();
+    if (it->second.empty())
+    {
+      m_bins.erase(it);
+    }
+
+    m_statistics.bytesCached -= sizeClass;
+    ++m_statistics.hits;
+
+    if (m_isPending)
+    {
+      // The previous owner of the block might still be in flight on any stream of this context.
+      CU_CHECK( cuCtxSynchronize() );
+      m_isPending = false;
+    }
+  }
+  else
+  {
+    evict(sizeClass);
+
+    CUresult status = cuMemAlloc(&ptr, sizeClass);
+    if (status == CUDA_ERROR_OUT_OF_MEMORY && !m_bins.empty())
+    {
+      trim(); // Retry with all cached memory given back to the driver.
+
+      status = cuMemAlloc(&ptr, sizeClass);
+    }
+    CU_CHECK( status );
+
+    ++m_statistics.misses;
+  }
+
+  m_blocksInUse[ptr] = sizeClass;
+
+  m_statistics.bytesInUse    += sizeClass;
+  m_statistics.bytesHighWater = std::max(m_statistics.bytesHighWater, m_statistics.bytesInUse);
+
+  return ptr;
+}
+
+void BufferCache::free(const CUdeviceptr ptr)
+{
+  if (ptr == 0)
+  {
+    return;
+  }
+
+  std::map<CUdeviceptr, size_t>::iterator it = m_blocksInUse.find(ptr);
+  if (it == m_blocksInUse.end())
+  {
+    std::cerr << "ERROR: BufferCache::free() unknown pointer\n";
+    MY_ASSERT(!"BufferCache::free() unknown pointer");
+    return;
+  }
+
+  const size_t sizeClass = it->second;
+
+  m_blocksInUse.erase(it);
+
+  CachedBlock block;
+
+  block.ptr  = ptr;
+  block.tick = m_tick++;
+
+  m_bins[sizeClass].push_back(block);
+
+  m_statistics.bytesInUse  -= sizeClass;
+  m_statistics.bytesCached += sizeClass;
+
+  m_isPending = true;
+}
+
+void BufferCache::trim()
+{
+  for (std::map<size_t, std::vector<CachedBlock> >::const_iterator it = m_bins.begin(); it != m_bins.end(); ++it)
+  {
+    for (CachedBlock const& block : it->second)
+    {
+      CU_CHECK_NO_THROW( cuMemFree(block.ptr) );
+      ++m_statistics.evictions;
+    }
+  }
+  m_bins.clear();
+
+  m_statistics.bytesCached    = 0;
+  m_statistics.bytesHighWater = m_statistics.bytesInUse;
+
+  m_isPending = false; // cuMemFree() synchronizes.
+}
+
+BufferCacheStatistics const& BufferCache::getStatistics() const
+{
+  return m_statistics;
+}
+
+void BufferCache::evict(const size_t bytesRequired)
+{
+  // A new block which raises the high-water mark itself doesn't require an eviction.
+  const size_t bytesLimit = std::max(m_statistics.bytesHighWater, m_statistics.bytesInUse + bytesRequired);
+
+  while (!m_bins.empty() && bytesLimit < m_statistics.bytesInUse + m_statistics.bytesCached + bytesRequired)
+  {
+    // Find the least recently freed block. There are only a few dozen cached blocks.
+    std::map<size_t, std::vector<CachedBlock> >::const_iterator itOldest = m_bins.begin();
+    for (std::map<size_t, std::vector<CachedBlock> >::const_iterator it = m_bins.begin(); it != m_bins.end(); ++it)
+    {
+      if (it->second.front().tick < itOldest->second.front().tick)
+      {
+        itOldest = it;
+      }
+    }
+    release(itOldest->first);
+  }
+}
+
+void BufferCache::release(const size_t sizeClass)
+{
+  std::map<size_t, std::vector<CachedBlock> >::iterator it = m_bins.find(sizeClass);
+  MY_ASSERT(it != m_bins.end());
+
+  CU_CHECK( cuMemFree(it->second.front().ptr) );
+
+  it->second.erase(it->second.begin());
+  if (it->second.empty())
+  {
+    m_bins.erase(it);
+  }
+
+  m_statistics.bytesCached -= sizeClass;
+  ++m_statistics.evictions;
+}
@@ -174,6 +174,20 @@ void Camera::zoom(float x)
   m_changed = true;
 }
 
+void Camera::frame(const float3& lo, const float3& hi)
+{
+  m_center = (lo + hi) * 0.5f;
+
+  const float radius = fmaxf(0.5f * length(hi - lo), 0.001f); // Bounding sphere of the box.
+
+  // m_fov is the vertical field of view. Use the smaller of the two half angles to fit the sphere in both directions.
+  const float tanFovHalf = tanf((m_fov * 0.5f) * M_PIf / 180.0f);
+  const float angleHalf  = fminf(atanf(tanFovHalf), atanf(tanFovHalf * m_aspect));
+
+  m_distance = radius / sinf(angleHalf);
+  m_changed  = true;
+}
+
 float Camera::getAspectRatio() const
 {
   return m_aspect;
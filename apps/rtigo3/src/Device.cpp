@@ -28,7 +28,14 @@
 
 #include "inc/Device.h"
 
+#include "inc/Aov.h"
 #include "inc/CheckMacros.h"
+#include "inc/EnvFormat.h"
+
+#include "shaders/adaptive_roulette.h"
+#include "shaders/tile_layout.h"
+
+#include <dp/math/Batch.h>
 
 #ifdef _WIN32
 #if !defined WIN32_LEAN_AND_MEAN
@@ -44,11 +51,20 @@
 #endif
 
 #include <algorithm>
+#include <chrono>
+#include <cstddef>
 #include <fstream>
 #include <iostream>
 #include <mutex>
 #include <string.h>
 
+// Stream capture modes and the per-stream capture API exist since CUDA 10.1. Older toolkits always launch directly.
+#if 10010 <= CUDA_VERSION
+#define USE_ITERATION_GRAPH 1
+#else
+#define USE_ITERATION_GRAPH 0
+#endif
+
 #ifdef _WIN32
 // Original code from optix_stubs.h
 static void* optixLoadWindowsDll(void)
@@ -274,9 +290,19 @@ Device::Device(const RendererStrategy strategy,
   m_systemData.outputBuffer        = 0; // Deferred allocation. Only done in render() of the derived Device classes to allow for different memory spaces!
   m_systemData.tileBuffer          = 0; // For the final frame tiled renderer the intermediate buffer is only tileSize.
   m_systemData.texelBuffer         = 0; // For the final frame tiled renderer. Contains the accumulated result of the current tile.
+  m_systemData.timeBuffer          = 0; // Only allocated while the time view is enabled.
+  m_systemData.idBuffer            = 0;
+  for (int i = 0; i < NUM_AOVS; ++i)
+  {
+    m_systemData.aovBuffers[i] = 0; // Only allocated while the AOV is enabled.
+  }
   m_systemData.cameraDefinitions   = nullptr;
+  m_systemData.viewDefinitions     = nullptr;
   m_systemData.lightDefinitions    = nullptr;
   m_systemData.materialDefinitions = nullptr;
+  m_systemData.wavefront           = nullptr;
+  m_systemData.rouletteCache       = nullptr; // Only allocated while the adaptive roulette is enabled.
+  m_systemData.rouletteStats       = nullptr;
   m_systemData.envTexture          = 0;
   m_systemData.envCDF_U            = nullptr;
   m_systemData.envCDF_V            = nullptr;
@@ -284,23 +310,69 @@ Device::Device(const RendererStrategy strategy,
   m_systemData.tileSize            = make_int2(8, 8); // Default value for multi-GPU tiling. Must be power-of-two values. (8x8 covers either 8x4 or 4x8 internal 2D warp shapes.)
   m_systemData.tileShift           = make_int2(3, 3); // The right-shift for the division by tileSize. 
   m_systemData.pathLengths         = make_int2(2, 5); // min, max
+  m_systemData.rouletteTiles       = make_int2(0, 0);
   m_systemData.deviceCount         = m_count; // The number of active devices.
   m_systemData.deviceIndex         = m_index; // This allows to distinguish multiple devices.
   m_systemData.iterationIndex      = 0;
+  m_systemData.sampleOffset        = 0;
   m_systemData.samplesSqrt         = 0; // Invalid value! Enforces that there is at least one setState() call before rendering.
   m_systemData.sceneEpsilon        = 500.0f * SCENE_EPSILON_SCALE;
   m_systemData.clockScale          = 1000.0f * CLOCK_FACTOR_SCALE;
   m_systemData.lensShader          = 0;
+  m_systemData.timeView            = 0;
+  m_systemData.rouletteMode        = 0;
+  m_systemData.accumulationLayout  = ACCUMULATION_LAYOUT_LINEAR;
+  m_systemData.aovMask             = 0;
   m_systemData.numCameras          = 0;
+  m_systemData.numViews            = 0;
+  m_systemData.viewOffset          = m_index; // Each device starts with its own view.
   m_systemData.numLights           = 0;
   m_systemData.numMaterials        = 0;
   m_systemData.envWidth            = 0;
   m_systemData.envHeight           = 0;
   m_systemData.envIntegral         = 1.0f;
+  m_systemData.envFormat           = ENV_FORMAT_RGBA32F;
   m_systemData.envRotation         = 0.0f;
 
   m_isDirtyOutputBuffer = true; // First render call initializes it. This is done in the derived render() functions.
 
+  m_pipeline         = nullptr;
+  m_pipelineUseCount = 0;
+  m_specialize       = false; // Only the generic pipeline until setState() enables the specialization.
+  m_isDirtyPipeline  = false;
+
+  m_d_sbtRecordGeometryInstanceData = nullptr;
+
+  m_d_ias          = 0;
+  m_allowUpdateIAS = false;
+
+  m_envFormat = ENV_FORMAT_RGBA32F;
+
+  m_accelBudgetTotal     = 0;
+  m_accelBudgetRemaining = 0;
+
+  m_h_viewOffsets   = nullptr;
+  m_viewLaunch      = make_int2(0, 0);
+  m_viewsSequential = false;
+
+  m_useGraphs     = (USE_ITERATION_GRAPH != 0);
+  m_isDirtyGraph  = true;
+  m_graph         = nullptr;
+  m_graphExec     = nullptr;
+  m_graphPipeline = nullptr;
+  m_graphSbt      = {};
+  m_graphWidth    = 0;
+  m_graphHeight   = 0;
+  CU_CHECK( cuMemAllocHost(reinterpret_cast<void**>(&m_h_iterationIndex), sizeof(unsigned int)) );
+  *m_h_iterationIndex = 0;
+
+  m_queryPipeline      = nullptr;
+  m_querySbt           = {};
+  m_d_queryRecords     = 0;
+  m_queryNumHitRecords = 0;
+  m_d_queryParameters  = nullptr;
+  m_querySlot          = 0;
+
   m_moduleFilenames.resize(NUM_MODULE_IDENTIFIERS);
 
   // Starting with OptiX SDK 7.5.0 and CUDA 11.7 either PTX or OptiX IR input can be used to create modules.
@@ -317,6 +389,10 @@ Device::Device(const RendererStrategy strategy,
   m_moduleFilenames[MODULE_ID_BXDF_DIFFUSE]   = std::string("./rtigo3_core/bxdf_diffuse.optixir");
   m_moduleFilenames[MODULE_ID_BXDF_SPECULAR]  = std::string("./rtigo3_core/bxdf_specular.optixir");
   m_moduleFilenames[MODULE_ID_BXDF_GGX_SMITH] = std::string("./rtigo3_core/bxdf_ggx_smith.optixir");
+
+  m_moduleFilenames[MODULE_ID_RAYGENERATION_WAVEFRONT] = std::string("./rtigo3_core/raygeneration_wavefront.optixir");
+
+  m_queryModuleFilename = std::string("./rtigo3_core/ray_query.optixir");
 #else
   m_moduleFilenames[MODULE_ID_RAYGENERATION]  = std::string("./rtigo3_core/raygeneration.ptx");
   m_moduleFilenames[MODULE_ID_EXCEPTION]      = std::string("./rtigo3_core/exception.ptx");
@@ -328,6 +404,10 @@ Device::Device(const RendererStrategy strategy,
   m_moduleFilenames[MODULE_ID_BXDF_DIFFUSE]   = std::string("./rtigo3_core/bxdf_diffuse.ptx");
   m_moduleFilenames[MODULE_ID_BXDF_SPECULAR]  = std::string("./rtigo3_core/bxdf_specular.ptx");
   m_moduleFilenames[MODULE_ID_BXDF_GGX_SMITH] = std::string("./rtigo3_core/bxdf_ggx_smith.ptx");
+
+  m_moduleFilenames[MODULE_ID_RAYGENERATION_WAVEFRONT] = std::string("./rtigo3_core/raygeneration_wavefront.ptx");
+
+  m_queryModuleFilename = std::string("./rtigo3_core/ray_query.ptx");
 #endif
 
   initPipeline();
@@ -339,6 +419,37 @@ Device::~Device()
   CU_CHECK_NO_THROW( cuCtxSetCurrent(m_cudaContext) ); // Activate this CUDA context. Not using activate() because this needs a no-throw check.
   CU_CHECK_NO_THROW( cuCtxSynchronize() );             // Make sure everthing running on this CUDA context has finished.
 
+  // Wait for a background pipeline compilation which still accesses this device.
+  if (m_futurePipeline.valid())
+  {
+    try
+    {
+      m_futurePipeline.get();
+    }
+    catch (std::exception const& e)
+    {
+      std::cerr << e.what() << '\n';
+    }
+    if (m_pipelineDataPending.pipeline != nullptr)
+    {
+      OPTIX_CHECK_NO_THROW( m_api.optixPipelineDestroy(m_pipelineDataPending.pipeline) );
+    }
+  }
+
+  if (m_graphExec != nullptr)
+  {
+    CU_CHECK_NO_THROW( cuGraphExecDestroy(m_graphExec) );
+  }
+  if (m_graph != nullptr)
+  {
+    CU_CHECK_NO_THROW( cuGraphDestroy(m_graph) );
+  }
+  CU_CHECK_NO_THROW( cuMemFreeHost(m_h_iterationIndex) );
+  if (m_h_viewOffsets != nullptr)
+  {
+    CU_CHECK_NO_THROW( cuMemFreeHost(m_h_viewOffsets) );
+  }
+
   delete m_textureEnv; // Allowed to be nullptr.
   delete m_textureCutout;
   delete m_textureAlbedo;
@@ -348,28 +459,60 @@ Device::~Device()
   // The m_systemData.outputBuffer is allocated in different ways in the derived Device classes. Must be destroyed in their destructors.
   //CU_CHECK_NO_THROW( cuMemFree(m_systemData.outputBuffer) );
 
-  CU_CHECK_NO_THROW( cuMemFree(m_systemData.tileBuffer) );
-  CU_CHECK_NO_THROW( cuMemFree(m_systemData.texelBuffer) );
+  m_bufferCache.free(m_systemData.tileBuffer);
+  m_bufferCache.free(m_systemData.texelBuffer);
+  m_bufferCache.free(m_systemData.timeBuffer);
+  m_bufferCache.free(m_systemData.idBuffer);
+  for (int i = 0; i < NUM_AOVS; ++i)
+  {
+    m_bufferCache.free(m_systemData.aovBuffers[i]);
+  }
+  m_bufferCache.free(reinterpret_cast<CUdeviceptr>(m_systemData.rouletteCache));
+  m_bufferCache.free(reinterpret_cast<CUdeviceptr>(m_systemData.rouletteStats));
 
   CU_CHECK_NO_THROW( cuMemFree(reinterpret_cast<CUdeviceptr>(m_systemData.cameraDefinitions)) );
+  CU_CHECK_NO_THROW( cuMemFree(reinterpret_cast<CUdeviceptr>(m_systemData.viewDefinitions)) );
   CU_CHECK_NO_THROW( cuMemFree(reinterpret_cast<CUdeviceptr>(m_systemData.lightDefinitions)) );
   CU_CHECK_NO_THROW( cuMemFree(reinterpret_cast<CUdeviceptr>(m_systemData.materialDefinitions)) );
 
   for (size_t i = 0; i < m_geometryData.size(); ++i)
   {
-    CU_CHECK_NO_THROW( cuMemFree(m_geometryData[i].d_attributes) ); // DAR FIXME Move these into an arena allocator.
-    CU_CHECK_NO_THROW( cuMemFree(m_geometryData[i].d_indices) );
-    CU_CHECK_NO_THROW( cuMemFree(m_geometryData[i].d_gas) );
+    m_bufferCache.free(m_geometryData[i].d_attributes);
+    m_bufferCache.free(m_geometryData[i].d_indices);
+    m_bufferCache.free(m_geometryData[i].d_gas);
   }
 
-  CU_CHECK_NO_THROW( cuMemFree(m_d_ias) );
+  m_bufferCache.free(m_d_ias);
+
+  m_bufferCache.free(reinterpret_cast<CUdeviceptr>(m_d_sbtRecordGeometryInstanceData)); // This holds all SBT records with istance data (hitgroup).
+  m_bufferCache.free(m_d_sbtRecordHeaders);                                             // This holds all SBT records without instance data.
 
-  CU_CHECK_NO_THROW( cuMemFree(reinterpret_cast<CUdeviceptr>(m_d_sbtRecordGeometryInstanceData)) ); // This holds all SBT records with istance data (hitgroup).
-  CU_CHECK_NO_THROW( cuMemFree(m_d_sbtRecordHeaders) );                                             // This holds all SBT records without instance data.
+  for (auto& it : m_pipelines)
+  {
+    OPTIX_CHECK_NO_THROW( m_api.optixPipelineDestroy(it.second.pipeline) );
+  }
 
-  OPTIX_CHECK_NO_THROW( m_api.optixPipelineDestroy(m_pipeline) );
+  for (QuerySlot& slot : m_querySlots)
+  {
+    CU_CHECK_NO_THROW( cuMemFree(slot.d_rays) );
+    CU_CHECK_NO_THROW( cuMemFree(slot.d_hits) );
+    CU_CHECK_NO_THROW( cuMemFreeHost(slot.h_rays) );
+    CU_CHECK_NO_THROW( cuMemFreeHost(slot.h_hits) );
+    if (slot.event != nullptr)
+    {
+      CU_CHECK_NO_THROW( cuEventDestroy(slot.event) );
+    }
+  }
+  m_bufferCache.free(m_d_queryRecords);
+  CU_CHECK_NO_THROW( cuMemFree(reinterpret_cast<CUdeviceptr>(m_d_queryParameters)) );
+  if (m_queryPipeline != nullptr)
+  {
+    OPTIX_CHECK_NO_THROW( m_api.optixPipelineDestroy(m_queryPipeline) );
+  }
   OPTIX_CHECK_NO_THROW(m_api.optixDeviceContextDestroy(m_optixContext) );
 
+  m_bufferCache.trim(); // The cached blocks must be released before the context is destroyed.
+
   CU_CHECK_NO_THROW( cuStreamDestroy(m_cudaStream) );
   CU_CHECK_NO_THROW( cuCtxDestroy(m_cudaContext) );
 }
@@ -560,6 +703,46 @@ void Device::initPipeline()
 {
   MY_ASSERT(NUM_RAYTYPES == 2); // The following code only works for two raytypes.
 
+  // The generic pipeline contains all program groups and is always available.
+  // It's used until a specialized pipeline for the current scene and settings has been compiled in the background.
+  m_pipelineKeyGeneric = makeGenericPipelineKey(m_strategy, m_miss);
+
+  createPipeline(m_pipelineKeyGeneric, m_pipelines[m_pipelineKeyGeneric]);
+
+  // Set up the fixed portion of the Shader Binding Table (SBT)
+
+  // Put all SbtRecordHeader types in one CUdeviceptr.
+  const int numHeaders = LAST_HEADER_ID - PGID_RAYGENERATION + 1;
+
+  m_d_sbtRecordHeaders = m_bufferCache.alloc(sizeof(SbtRecordHeader) * numHeaders);
+
+  // Setup the OptixShaderBindingTable.
+
+  m_sbt.raygenRecord            = m_d_sbtRecordHeaders + sizeof(SbtRecordHeader) * PGID_RAYGENERATION;
+
+  m_sbt.exceptionRecord         = m_d_sbtRecordHeaders + sizeof(SbtRecordHeader) * PGID_EXCEPTION;
+
+  m_sbt.missRecordBase          = m_d_sbtRecordHeaders + sizeof(SbtRecordHeader) * PGID_MISS_RADIANCE;
+  m_sbt.missRecordStrideInBytes = (unsigned int) sizeof(SbtRecordHeader);
+  m_sbt.missRecordCount         = NUM_RAYTYPES;
+
+  // These are going to be setup after the RenderGraph has been built!
+  //m_sbt.hitgroupRecordBase          = reinterpret_cast<CUdeviceptr>(m_d_sbtRecordGeometryInstanceData);
+  //m_sbt.hitgroupRecordStrideInBytes = (unsigned int) sizeof(SbtRecordGeometryInstanceData);
+  //m_sbt.hitgroupRecordCount         = NUM_RAYTYPES * numInstances;
+
+  m_sbt.callablesRecordBase          = m_d_sbtRecordHeaders + sizeof(SbtRecordHeader) * FIRST_DIRECT_CALLABLE_ID;
+  m_sbt.callablesRecordStrideInBytes = (unsigned int) sizeof(SbtRecordHeader);
+  m_sbt.callablesRecordCount         = LAST_DIRECT_CALLABLE_ID - FIRST_DIRECT_CALLABLE_ID + 1;
+
+  activatePipeline(m_pipelineKeyGeneric);
+}
+
+
+// This runs on the application thread for the generic pipeline and on a background thread for specialized pipelines.
+// It must only read members which are constant after the constructor and only write into the given data.
+void Device::createPipeline(PipelineKey const& key, PipelineData& data)
+{
   OptixModuleCompileOptions mco = {};
 
   mco.maxRegisterCount = OPTIX_COMPILE_DEFAULT_MAX_REGISTER_COUNT;
@@ -576,6 +759,29 @@ void Device::initPipeline()
 #endif
 #endif
 
+#if (OPTIX_VERSION >= 70200)
+  // Specialized pipelines replace the loads of constant SystemData fields with compile time values.
+  // This turns the lens shader direct call into a known callable. The bound aovMask removes all code of disabled AOVs.
+  const int          lensShader = key.lensShader;
+  const unsigned int aovMask    = key.aovMask;
+
+  OptixModuleCompileBoundValueEntry boundValues[2] = {};
+
+  boundValues[0].pipelineParamOffsetInBytes = offsetof(SystemData, lensShader);
+  boundValues[0].sizeInBytes                = sizeof(int);
+  boundValues[0].boundValuePtr              = &lensShader;
+
+  boundValues[1].pipelineParamOffsetInBytes = offsetof(SystemData, aovMask);
+  boundValues[1].sizeInBytes                = sizeof(unsigned int);
+  boundValues[1].boundValuePtr              = &aovMask;
+
+  if (!key.generic)
+  {
+    mco.boundValues    = boundValues;
+    mco.numBoundValues = 2;
+  }
+#endif
+
   OptixPipelineCompileOptions pco = {};
 
   pco.usesMotionBlur        = 0;
@@ -597,12 +803,83 @@ void Device::initPipeline()
   pco.usesPrimitiveTypeFlags = OPTIX_PRIMITIVE_TYPE_FLAGS_TRIANGLE; // New in OptiX 7.1.0.
 #endif
 
+  // Which modules and program groups are reachable with this key.
+  std::vector<bool> usedModules(NUM_MODULE_IDENTIFIERS, true);
+
+  usedModules[MODULE_ID_BXDF_DIFFUSE]   = usesBSDF(key, INDEX_BRDF_DIFFUSE);
+  usedModules[MODULE_ID_BXDF_GGX_SMITH] = usesBSDF(key, INDEX_BRDF_GGX_SMITH) || usesBSDF(key, INDEX_BSDF_GGX_SMITH);
+
+  usedModules[MODULE_ID_RAYGENERATION_WAVEFRONT] = (m_strategy == RS_WAVEFRONT_SINGLE_GPU);
+
+  std::vector<bool> usedGroups(NUM_PROGRAM_GROUP_IDS, true);
+
+  usedGroups[PGID_LENS_PINHOLE]           = usesLensShader(key, LENS_SHADER_PINHOLE);
+  usedGroups[PGID_LENS_FISHEYE]           = usesLensShader(key, LENS_SHADER_FISHEYE);
+  usedGroups[PGID_LENS_SPHERE]            = usesLensShader(key, LENS_SHADER_SPHERE);
+  usedGroups[PGID_LIGHT_ENV]              = usesLightType(key, LIGHT_ENVIRONMENT);
+  usedGroups[PGID_LIGHT_AREA]             = usesLightType(key, LIGHT_PARALLELOGRAM);
+  usedGroups[PGID_BRDF_DIFFUSE_SAMPLE]    = usesBSDF(key, INDEX_BRDF_DIFFUSE);
+  usedGroups[PGID_BRDF_DIFFUSE_EVAL]      = usesBSDF(key, INDEX_BRDF_DIFFUSE);
+  usedGroups[PGID_BRDF_SPECULAR_SAMPLE]   = usesBSDF(key, INDEX_BRDF_SPECULAR);
+  usedGroups[PGID_BRDF_SPECULAR_EVAL]     = usesBSDF(key, INDEX_BRDF_SPECULAR);
+  usedGroups[PGID_BSDF_SPECULAR_SAMPLE]   = usesBSDF(key, INDEX_BSDF_SPECULAR);
+  usedGroups[PGID_BSDF_SPECULAR_EVAL]     = usesBSDF(key, INDEX_BSDF_SPECULAR);
+  usedGroups[PGID_BRDF_GGX_SMITH_SAMPLE]  = usesBSDF(key, INDEX_BRDF_GGX_SMITH);
+  usedGroups[PGID_BRDF_GGX_SMITH_EVAL]    = usesBSDF(key, INDEX_BRDF_GGX_SMITH);
+  usedGroups[PGID_BSDF_GGX_SMITH_SAMPLE]  = usesBSDF(key, INDEX_BSDF_GGX_SMITH);
+  usedGroups[PGID_BSDF_GGX_SMITH_EVAL]    = usesBSDF(key, INDEX_BSDF_GGX_SMITH);
+  usedGroups[PGID_HIT_RADIANCE_CUTOUT]    = usesCutout(key);
+  usedGroups[PGID_HIT_SHADOW_CUTOUT]      = usesCutout(key);
+  usedGroups[PGID_WAVEFRONT_GENERATE]     = usedModules[MODULE_ID_RAYGENERATION_WAVEFRONT];
+  usedGroups[PGID_WAVEFRONT_TRACE]        = usedModules[MODULE_ID_RAYGENERATION_WAVEFRONT];
+  usedGroups[PGID_WAVEFRONT_SHADE]        = usedModules[MODULE_ID_RAYGENERATION_WAVEFRONT];
+  usedGroups[PGID_WAVEFRONT_SHADOW]       = usedModules[MODULE_ID_RAYGENERATION_WAVEFRONT];
+  usedGroups[PGID_WAVEFRONT_RESOLVE]      = usedModules[MODULE_ID_RAYGENERATION_WAVEFRONT];
+
+  // The specular BSDF eval and the GGX BSDF eval are both using the black eval_brdf_specular program.
+  usedModules[MODULE_ID_BXDF_SPECULAR] = usedGroups[PGID_BRDF_SPECULAR_SAMPLE] || usedGroups[PGID_BSDF_SPECULAR_SAMPLE] || usedGroups[PGID_BSDF_GGX_SMITH_EVAL];
+
   // Each source file results in one OptixModule.
-  std::vector<OptixModule> modules(NUM_MODULE_IDENTIFIERS);
+  std::vector<OptixModule>       modules(NUM_MODULE_IDENTIFIERS, nullptr);
+  std::vector<OptixProgramGroup> usedProgramGroups; // Sized when the reachable program groups are known.
+
+  // After all required optixSbtRecordPackHeader, optixProgramGroupGetStackSize, and optixPipelineCreate
+  // calls have been done, the OptixProgramGroup and OptixModule objects can be destroyed.
+  // This also happens when an OPTIX_CHECK throws. updatePipeline() survives failed background compilations,
+  // so these would leak with every failed specialization otherwise. The caller destroys data.pipeline.
+  struct ProgramRelease
+  {
+    OptixFunctionTable const&       api;
+    std::vector<OptixModule>&       modules;
+    std::vector<OptixProgramGroup>& programGroups;
+
+    ~ProgramRelease()
+    {
+      for (auto pg : programGroups)
+      {
+        if (pg != nullptr)
+        {
+          OPTIX_CHECK_NO_THROW( api.optixProgramGroupDestroy(pg) );
+        }
+      }
+      for (auto m : modules)
+      {
+        if (m != nullptr)
+        {
+          OPTIX_CHECK_NO_THROW( api.optixModuleDestroy(m) );
+        }
+      }
+    }
+  } release = { m_api, modules, usedProgramGroups };
 
-  // Create all modules:
+  // Create all required modules:
   for (size_t i = 0; i < m_moduleFilenames.size(); ++i)
   {
+    if (!usedModules[i])
+    {
+      continue;
+    }
+
     // Since OptiX 7.5.0 the program input can either be *.ptx source code or *.optixir binary code.
     // The module filenames are automatically switched between *.ptx or *.optixir extension based on the definition of USE_OPTIX_IR
     std::vector<char> programData = readData(m_moduleFilenames[i]);
@@ -625,13 +902,15 @@ void Device::initPipeline()
     case RS_INTERACTIVE_SINGLE_GPU:
     case RS_INTERACTIVE_MULTI_GPU_ZERO_COPY:
     case RS_INTERACTIVE_MULTI_GPU_PEER_ACCESS:
+    case RS_MULTI_GPU_SAMPLE_RANGE:
+    case RS_WAVEFRONT_SINGLE_GPU: // The megakernel path tracer for comparisons.
       pgd->raygen.entryFunctionName = "__raygen__path_tracer";
       break;
     case RS_INTERACTIVE_MULTI_GPU_LOCAL_COPY:
       pgd->raygen.entryFunctionName = "__raygen__path_tracer_local_copy";
       break;
     default:
-      std::cerr << "ERROR: initPipeline() unexpected RendererStrategy.\n";
+      std::cerr << "ERROR: createPipeline() unexpected RendererStrategy.\n";
       pgd->raygen.entryFunctionName = "__raygen__path_tracer";
       break;
   }
@@ -762,6 +1041,37 @@ void Device::initPipeline()
   pgd->callables.moduleDC            = modules[MODULE_ID_BXDF_SPECULAR];
   pgd->callables.entryFunctionNameDC = "__direct_callable__eval_brdf_specular"; // black
 
+  // Wavefront strategy
+  pgd = &programGroupDescriptions[PGID_WAVEFRONT_GENERATE];
+  pgd->kind  = OPTIX_PROGRAM_GROUP_KIND_RAYGEN;
+  pgd->flags = OPTIX_PROGRAM_GROUP_FLAGS_NONE;
+  pgd->raygen.module            = modules[MODULE_ID_RAYGENERATION_WAVEFRONT];
+  pgd->raygen.entryFunctionName = "__raygen__wavefront_generate";
+
+  pgd = &programGroupDescriptions[PGID_WAVEFRONT_TRACE];
+  pgd->kind  = OPTIX_PROGRAM_GROUP_KIND_RAYGEN;
+  pgd->flags = OPTIX_PROGRAM_GROUP_FLAGS_NONE;
+  pgd->raygen.module            = modules[MODULE_ID_RAYGENERATION_WAVEFRONT];
+  pgd->raygen.entryFunctionName = "__raygen__wavefront_trace";
+
+  pgd = &programGroupDescriptions[PGID_WAVEFRONT_SHADE];
+  pgd->kind  = OPTIX_PROGRAM_GROUP_KIND_RAYGEN;
+  pgd->flags = OPTIX_PROGRAM_GROUP_FLAGS_NONE;
+  pgd->raygen.module            = modules[MODULE_ID_RAYGENERATION_WAVEFRONT];
+  pgd->raygen.entryFunctionName = "__raygen__wavefront_shade";
+
+  pgd = &programGroupDescriptions[PGID_WAVEFRONT_SHADOW];
+  pgd->kind  = OPTIX_PROGRAM_GROUP_KIND_RAYGEN;
+  pgd->flags = OPTIX_PROGRAM_GROUP_FLAGS_NONE;
+  pgd->raygen.module            = modules[MODULE_ID_RAYGENERATION_WAVEFRONT];
+  pgd->raygen.entryFunctionName = "__raygen__wavefront_shadow";
+
+  pgd = &programGroupDescriptions[PGID_WAVEFRONT_RESOLVE];
+  pgd->kind  = OPTIX_PROGRAM_GROUP_KIND_RAYGEN;
+  pgd->flags = OPTIX_PROGRAM_GROUP_FLAGS_NONE;
+  pgd->raygen.module            = modules[MODULE_ID_RAYGENERATION_WAVEFRONT];
+  pgd->raygen.entryFunctionName = "__raygen__wavefront_resolve";
+
   // HitGroups are using SbtRecordGeometryInstanceData and will be put into a separate CUDA memory block.
   pgd = &programGroupDescriptions[PGID_HIT_RADIANCE];
   pgd->kind  = OPTIX_PROGRAM_GROUP_KIND_HITGROUP;
@@ -791,9 +1101,29 @@ void Device::initPipeline()
 
   OptixProgramGroupOptions pgo = {}; // This is a just placeholder.
 
-  std::vector<OptixProgramGroup> programGroups(programGroupDescriptions.size());
+  // Only create the program groups reachable with this key. The unused entries in programGroups stay nullptr.
+  std::vector<OptixProgramGroupDesc> usedDescriptions;
+  std::vector<int>                   usedIds;
+
+  for (int i = 0; i < NUM_PROGRAM_GROUP_IDS; ++i)
+  {
+    if (usedGroups[i])
+    {
+      usedDescriptions.push_back(programGroupDescriptions[i]);
+      usedIds.push_back(i);
+    }
+  }
+
+  usedProgramGroups.resize(usedDescriptions.size(), nullptr);
   
-  OPTIX_CHECK( m_api.optixProgramGroupCreate(m_optixContext, programGroupDescriptions.data(), (unsigned int) programGroupDescriptions.size(), &pgo, nullptr, nullptr, programGroups.data()) );
+  OPTIX_CHECK( m_api.optixProgramGroupCreate(m_optixContext, usedDescriptions.data(), (unsigned int) usedDescriptions.size(), &pgo, nullptr, nullptr, usedProgramGroups.data()) );
+
+  std::vector<OptixProgramGroup> programGroups(NUM_PROGRAM_GROUP_IDS, nullptr);
+
+  for (size_t i = 0; i < usedIds.size(); ++i)
+  {
+    programGroups[usedIds[i]] = usedProgramGroups[i];
+  }
 
   OptixPipelineLinkOptions plo = {};
 
@@ -812,12 +1142,12 @@ void Device::initPipeline()
   plo.overrideUsesMotionBlur = 0; // Does not exist in OptiX 7.1.0.
 #endif
 
-  OPTIX_CHECK( m_api.optixPipelineCreate(m_optixContext, &pco, &plo, programGroups.data(), (unsigned int) programGroups.size(), nullptr, nullptr, &m_pipeline) );
+  OPTIX_CHECK( m_api.optixPipelineCreate(m_optixContext, &pco, &plo, usedProgramGroups.data(), (unsigned int) usedProgramGroups.size(), nullptr, nullptr, &data.pipeline) );
 
   // STACK SIZES
   OptixStackSizes ssp = {}; // Whole pipeline.
 
-  for (auto pg: programGroups)
+  for (auto pg: usedProgramGroups)
   {
     OptixStackSizes ss;
 
@@ -843,67 +1173,181 @@ void Device::initPipeline()
                                        std::min(1u, plo.maxTraceDepth) * std::max(cssCHOrMSPlusCCTree, ssp.cssAH + ssp.cssIS);
   unsigned int maxTraversableGraphDepth = 2;
 
-  OPTIX_CHECK( m_api.optixPipelineSetStackSize(m_pipeline, directCallableStackSizeFromTraversal, directCallableStackSizeFromState, continuationStackSize, maxTraversableGraphDepth) );
+  OPTIX_CHECK( m_api.optixPipelineSetStackSize(data.pipeline, directCallableStackSizeFromTraversal, directCallableStackSizeFromState, continuationStackSize, maxTraversableGraphDepth) );
 
-  // Set up the fixed portion of the Shader Binding Table (SBT)
+  // Pack the SbtRecordHeaders which are uploaded into m_d_sbtRecordHeaders when this pipeline gets activated.
+  const int numHeaders = LAST_HEADER_ID - PGID_RAYGENERATION + 1;
 
-  // Put all SbtRecordHeader types in one CUdeviceptr.
-  const int numHeaders = LAST_DIRECT_CALLABLE_ID - PGID_RAYGENERATION + 1;
+  data.headers.resize(numHeaders);
 
-  std::vector<SbtRecordHeader> sbtRecordHeaders(numHeaders);
+  // The callable indices are fixed inside the shaders. Unused callables keep their SBT slot
+  // and get the header of the bound lens shader program, which is never called through these slots.
+  OptixProgramGroup pgFallback = programGroups[PGID_LENS_PINHOLE + key.lensShader];
+  MY_ASSERT(pgFallback != nullptr);
 
   for (int i = 0; i < numHeaders; ++i)
   {
-    OPTIX_CHECK( m_api.optixSbtRecordPackHeader(programGroups[PGID_RAYGENERATION + i], &sbtRecordHeaders[i]) );
-  }
+    OptixProgramGroup pg = programGroups[PGID_RAYGENERATION + i];
 
-  CU_CHECK( cuMemAlloc(&m_d_sbtRecordHeaders, sizeof(SbtRecordHeader) * numHeaders) );
-  CU_CHECK( cuMemcpyHtoDAsync(m_d_sbtRecordHeaders, sbtRecordHeaders.data(), sizeof(SbtRecordHeader) * numHeaders, m_cudaStream) );
+    OPTIX_CHECK( m_api.optixSbtRecordPackHeader((pg != nullptr) ? pg : pgFallback, &data.headers[i]) );
+  }
 
   // Hit groups for radiance and shadow rays. These will be initialized later per instance.
   // This just provides the headers with the program group indices.
+  // Without cutout materials the cutout hit groups are not compiled and the opaque ones are used instead.
+  OPTIX_CHECK( m_api.optixSbtRecordPackHeader(programGroups[PGID_HIT_RADIANCE], &data.hitRadiance) );
+  OPTIX_CHECK( m_api.optixSbtRecordPackHeader(programGroups[PGID_HIT_SHADOW],   &data.hitShadow) );
+
+  OPTIX_CHECK( m_api.optixSbtRecordPackHeader(programGroups[(usesCutout(key)) ? PGID_HIT_RADIANCE_CUTOUT : PGID_HIT_RADIANCE], &data.hitRadianceCutout) );
+  OPTIX_CHECK( m_api.optixSbtRecordPackHeader(programGroups[(usesCutout(key)) ? PGID_HIT_SHADOW_CUTOUT   : PGID_HIT_SHADOW],   &data.hitShadowCutout) );
+}
+
+
+void Device::activatePipeline(PipelineKey const& key)
+{
+  std::map<PipelineKey, PipelineData>::iterator it = m_pipelines.find(key);
+  MY_ASSERT(it != m_pipelines.end());
+
+  PipelineData& data = it->second;
+
+  data.lastUse = ++m_pipelineUseCount;
+
+  m_pipeline          = data.pipeline;
+  m_pipelineKeyActive = key;
+
+  // The SBT uploads are ordered behind all previous launches in m_cudaStream.
+  CU_CHECK( cuMemcpyHtoDAsync(m_d_sbtRecordHeaders, data.headers.data(), sizeof(SbtRecordHeader) * data.headers.size(), m_cudaStream) );
 
   // Note that the SBT record data field is uninitialized after these!
   // These are stored to be able to initialize the SBT hitGroup with the respective opaque and cutout shaders.
-  OPTIX_CHECK( m_api.optixSbtRecordPackHeader(programGroups[PGID_HIT_RADIANCE],        &m_sbtRecordHitRadiance) );
-  OPTIX_CHECK( m_api.optixSbtRecordPackHeader(programGroups[PGID_HIT_SHADOW],          &m_sbtRecordHitShadow) );
+  memcpy(m_sbtRecordHitRadiance.header,       data.hitRadiance.header,       OPTIX_SBT_RECORD_HEADER_SIZE);
+  memcpy(m_sbtRecordHitShadow.header,         data.hitShadow.header,         OPTIX_SBT_RECORD_HEADER_SIZE);
+  memcpy(m_sbtRecordHitRadianceCutout.header, data.hitRadianceCutout.header, OPTIX_SBT_RECORD_HEADER_SIZE);
+  memcpy(m_sbtRecordHitShadowCutout.header,   data.hitShadowCutout.header,   OPTIX_SBT_RECORD_HEADER_SIZE);
 
-  OPTIX_CHECK( m_api.optixSbtRecordPackHeader(programGroups[PGID_HIT_RADIANCE_CUTOUT], &m_sbtRecordHitRadianceCutout) );
-  OPTIX_CHECK( m_api.optixSbtRecordPackHeader(programGroups[PGID_HIT_SHADOW_CUTOUT],   &m_sbtRecordHitShadowCutout) );
+  // The hit records only exist after initScene(). createHitGroupRecords() picks up the headers above then.
+  const unsigned int numInstances = static_cast<unsigned int>(m_instanceData.size());
 
-  // Setup the OptixShaderBindingTable.
+  if (m_sbtRecordGeometryInstanceData.size() != NUM_RAYTYPES * numInstances || numInstances == 0)
+  {
+    return;
+  }
 
-  m_sbt.raygenRecord            = m_d_sbtRecordHeaders + sizeof(SbtRecordHeader) * PGID_RAYGENERATION;
+  for (unsigned int i = 0; i < numInstances; ++i)
+  {
+    const int idx = i * NUM_RAYTYPES; // idx == radiance ray, idx + 1 == shadow ray
 
-  m_sbt.exceptionRecord         = m_d_sbtRecordHeaders + sizeof(SbtRecordHeader) * PGID_EXCEPTION;
+    if (m_materials[m_instanceData[i].idMaterial].textureCutout == 0)
+    {
+      memcpy(m_sbtRecordGeometryInstanceData[idx    ].header, m_sbtRecordHitRadiance.header, OPTIX_SBT_RECORD_HEADER_SIZE);
+      memcpy(m_sbtRecordGeometryInstanceData[idx + 1].header, m_sbtRecordHitShadow.header,   OPTIX_SBT_RECORD_HEADER_SIZE);
+    }
+    else
+    {
+      memcpy(m_sbtRecordGeometryInstanceData[idx    ].header, m_sbtRecordHitRadianceCutout.header, OPTIX_SBT_RECORD_HEADER_SIZE);
+      memcpy(m_sbtRecordGeometryInstanceData[idx + 1].header, m_sbtRecordHitShadowCutout.header,   OPTIX_SBT_RECORD_HEADER_SIZE);
+    }
+  }
 
-  m_sbt.missRecordBase          = m_d_sbtRecordHeaders + sizeof(SbtRecordHeader) * PGID_MISS_RADIANCE;
-  m_sbt.missRecordStrideInBytes = (unsigned int) sizeof(SbtRecordHeader);
-  m_sbt.missRecordCount         = NUM_RAYTYPES;
+  CU_CHECK( cuMemcpyHtoDAsync(reinterpret_cast<CUdeviceptr>(m_d_sbtRecordGeometryInstanceData), m_sbtRecordGeometryInstanceData.data(), sizeof(SbtRecordGeometryInstanceData) * NUM_RAYTYPES * numInstances, m_cudaStream) );
+}
 
-  // These are going to be setup after the RenderGraph has been built!
-  //m_sbt.hitgroupRecordBase          = reinterpret_cast<CUdeviceptr>(m_d_sbtRecordGeometryInstanceData);
-  //m_sbt.hitgroupRecordStrideInBytes = (unsigned int) sizeof(SbtRecordGeometryInstanceData);
-  //m_sbt.hitgroupRecordCount         = NUM_RAYTYPES * numInstances;
 
-  m_sbt.callablesRecordBase          = m_d_sbtRecordHeaders + sizeof(SbtRecordHeader) * FIRST_DIRECT_CALLABLE_ID;
-  m_sbt.callablesRecordStrideInBytes = (unsigned int) sizeof(SbtRecordHeader);
-  m_sbt.callablesRecordCount         = LAST_DIRECT_CALLABLE_ID - FIRST_DIRECT_CALLABLE_ID + 1;
+// Destroys the least recently used specialized pipelines above PIPELINE_CACHE_SIZE.
+void Device::evictPipelines()
+{
+  PipelineKey key;
 
-  // After all required optixSbtRecordPackHeader, optixProgramGroupGetStackSize, and optixPipelineCreate
-  // calls have been done, the OptixProgramGroup and OptixModule objects can be destroyed.
-  for (auto pg: programGroups)
+  while (selectPipelineEviction(m_pipelines, m_pipelineKeyActive, PIPELINE_CACHE_SIZE, key))
+  {
+    std::map<PipelineKey, PipelineData>::iterator it = m_pipelines.find(key);
+
+    // The previous launches or the captured iteration graph can still reference a pipeline which was active before.
+    if (it->second.pipeline == m_graphPipeline)
+    {
+      destroyIterationGraph();
+      m_graphPipeline = nullptr;
+    }
+    synchronizeStream();
+
+    OPTIX_CHECK( m_api.optixPipelineDestroy(it->second.pipeline) );
+
+    m_pipelines.erase(it);
+  }
+}
+
+
+// Selects the pipeline for the current settings. 
+// Specialized pipelines are compiled on a background thread while the generic or a compatible cached pipeline keeps rendering.
+void Device::updatePipeline()
+{
+  bool changed = m_isDirtyPipeline;
+
+  // Harvest a finished background compilation.
+  if (m_futurePipeline.valid() && m_futurePipeline.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+  {
+    try
+    {
+      m_futurePipeline.get();
+
+      m_pipelineDataPending.lastUse = m_pipelineUseCount;
+
+      m_pipelines[m_pipelineKeyPending] = m_pipelineDataPending;
+    }
+    catch (std::exception const& e)
+    {
+      std::cerr << "WARNING: updatePipeline() specialization failed, using the generic pipeline: " << e.what() << '\n';
+      if (m_pipelineDataPending.pipeline != nullptr)
+      {
+        OPTIX_CHECK_NO_THROW( m_api.optixPipelineDestroy(m_pipelineDataPending.pipeline) );
+      }
+      m_specialize = false; // Don't try again.
+    }
+    m_pipelineDataPending = PipelineData();
+
+    changed = true;
+  }
+
+  if (!changed)
   {
-    OPTIX_CHECK( m_api.optixProgramGroupDestroy(pg) );
+    return;
   }
 
-  for (auto m : modules)
+  m_isDirtyPipeline = false;
+
+  const PipelineKey key = (m_specialize) ? derivePipelineKey(m_strategy, m_miss, m_systemData.lensShader, m_systemData.aovMask, m_materials, m_lightTypes)
+                                          : m_pipelineKeyGeneric;
+
+  const PipelineKey keyActivate = selectPipelineKey(m_pipelines, m_pipelineKeyActive, key, m_pipelineKeyGeneric);
+
+  if (keyActivate != m_pipelineKeyActive)
+  {
+    activatePipeline(keyActivate);
+  }
+
+  evictPipelines();
+
+  // Start compiling the missing specialized pipeline. If another one is still compiling, this is reevaluated when that finished.
+  if (keyActivate != key && !m_futurePipeline.valid())
   {
-    OPTIX_CHECK(m_api.optixModuleDestroy(m));
+    m_pipelineKeyPending = key;
+
+    m_futurePipeline = std::async(std::launch::async, [this, key]()
+    {
+      CU_CHECK( cuCtxSetCurrent(m_cudaContext) ); // The current CUDA context is per thread.
+
+      createPipeline(key, m_pipelineDataPending);
+    });
   }
 }
 
 
+// Offset from the texture independent ray cone LOD to the mipmap level of this texture.
+static float getTextureLod(Texture const* texture)
+{
+  return 0.5f * log2f(float(texture->getWidth()) * float(texture->getHeight()));
+}
+
 // FIXME Hardcocded textures. => See nvlink_shared which supports textures per material.
 void Device::initTextures(std::map<std::string, Picture*> const& mapOfPictures)
 {
@@ -918,15 +1362,21 @@ void Device::initTextures(std::map<std::string, Picture*> const& mapOfPictures)
 
   std::map<std::string, Picture*>::const_iterator itEnv = mapOfPictures.find(std::string("environment"));
 
+  // The material textures are sampled at the ray cone LOD with trilinear filtering.
   m_textureAlbedo = new Texture();
-  m_textureAlbedo->create(itAlbedo->second, IMAGE_FLAG_2D);
+  m_textureAlbedo->setFilterMode(CU_TR_FILTER_MODE_LINEAR, CU_TR_FILTER_MODE_LINEAR);
+  m_textureAlbedo->setMipmapLevelBiasMinMax(0.0f, 0.0f, float(itAlbedo->second->getNumberOfLevels(0) - 1));
+  m_textureAlbedo->create(itAlbedo->second, IMAGE_FLAG_2D | IMAGE_FLAG_MIPMAP);
 
   m_textureCutout = new Texture();
-  m_textureCutout->create(itCutout->second, IMAGE_FLAG_2D);
+  m_textureCutout->setFilterMode(CU_TR_FILTER_MODE_LINEAR, CU_TR_FILTER_MODE_LINEAR);
+  m_textureCutout->setMipmapLevelBiasMinMax(0.0f, 0.0f, float(itCutout->second->getNumberOfLevels(0) - 1));
+  m_textureCutout->create(itCutout->second, IMAGE_FLAG_2D | IMAGE_FLAG_MIPMAP);
 
   if (itEnv != mapOfPictures.end())
   {
     m_textureEnv = new Texture();
+    m_textureEnv->setEnvFormat(m_envFormat);
     m_textureEnv->create(itEnv->second, IMAGE_FLAG_2D | IMAGE_FLAG_ENV);
 
     m_systemData.envTexture  = m_textureEnv->getTextureObject();
@@ -935,6 +1385,14 @@ void Device::initTextures(std::map<std::string, Picture*> const& mapOfPictures)
     m_systemData.envWidth    = m_textureEnv->getWidth();
     m_systemData.envHeight   = m_textureEnv->getHeight();
     m_systemData.envIntegral = m_textureEnv->getIntegral();
+    m_systemData.envFormat   = m_envFormat;
+
+    const size_t numTexels = size_t(m_systemData.envWidth) * size_t(m_systemData.envHeight);
+    const size_t sizeBytes = numTexels * getEnvFormatElementSize(m_envFormat);
+
+    std::cout << "initTextures() device = " << m_ordinal << ": environment " << m_systemData.envWidth << " x " << m_systemData.envHeight
+              << " " << getEnvFormatName(m_envFormat) << " = " << (sizeBytes >> 10) << " KiB, saved "
+              << ((numTexels * getEnvFormatElementSize(ENV_FORMAT_RGBA32F) - sizeBytes) >> 10) << " KiB\n";
   }
 }
 
@@ -963,6 +1421,68 @@ void Device::initCameras(std::vector<CameraDefinition> const& cameras)
   m_isDirtySystemData = true;  // Trigger full update of the device system data on the next launch.
 }
 
+void Device::initViews(std::vector<ViewDefinition> const& views)
+{
+  activateContext();
+  synchronizeStream();
+
+  const int numViews = static_cast<int>(views.size());
+
+  // The local copy strategy composites launch sized per device buffers which don't know about views.
+  // The wavefront strategy has one path per pixel of the resolution.
+  MY_ASSERT(numViews == 0 || (m_strategy != RS_INTERACTIVE_MULTI_GPU_LOCAL_COPY && m_strategy != RS_WAVEFRONT_SINGLE_GPU));
+
+  if (m_systemData.numViews != numViews)
+  {
+    CU_CHECK( cuMemFree(reinterpret_cast<CUdeviceptr>(m_systemData.viewDefinitions)) );
+    m_systemData.viewDefinitions = nullptr;
+
+    if (0 < numViews)
+    {
+      CU_CHECK( cuMemAlloc(reinterpret_cast<CUdeviceptr*>(&m_systemData.viewDefinitions), sizeof(ViewDefinition) * numViews) );
+    }
+  }
+
+  m_views = views;
+  m_viewLaunch = make_int2(0, 0);
+
+  for (ViewDefinition const& view : m_views)
+  {
+    MY_ASSERT(0 <= view.idCamera && view.idCamera < m_systemData.numCameras); // initCameras() must have been called with the view cameras before.
+    MY_ASSERT(0 <= view.origin.x && view.origin.x + view.size.x <= m_systemData.resolution.x &&
+              0 <= view.origin.y && view.origin.y + view.size.y <= m_systemData.resolution.y);
+
+    m_viewLaunch.x = std::max(m_viewLaunch.x, view.size.x);
+    m_viewLaunch.y = std::max(m_viewLaunch.y, view.size.y);
+  }
+
+  // The device at index i renders the views i, i + count, i + 2 * count, ...
+  // Pinned, because the uploads of these offsets are captured into the iteration graph.
+  if (m_systemData.numViews != numViews || m_h_viewOffsets == nullptr)
+  {
+    if (m_h_viewOffsets != nullptr)
+    {
+      CU_CHECK( cuMemFreeHost(m_h_viewOffsets) );
+    }
+    CU_CHECK( cuMemAllocHost(reinterpret_cast<void**>(&m_h_viewOffsets), sizeof(int) * (numViews + 1)) );
+  }
+  for (int i = 0; i < numViews; ++i)
+  {
+    m_h_viewOffsets[i] = i;
+  }
+  m_h_viewOffsets[numViews] = m_index; // Restores the viewOffset after the sequential launches.
+
+  if (0 < numViews)
+  {
+    CU_CHECK( cuMemcpyHtoDAsync(reinterpret_cast<CUdeviceptr>(m_systemData.viewDefinitions), m_views.data(), sizeof(ViewDefinition) * numViews, m_cudaStream) );
+  }
+  m_systemData.numViews   = numViews;
+  m_systemData.viewOffset = m_index;
+
+  m_isDirtySystemData = true;
+  m_isDirtyGraph      = true; // The number and size of the launches changed.
+}
+
 void Device::initLights(std::vector<LightDefinition> const& lights)
 {
   activateContext();
@@ -992,7 +1512,15 @@ void Device::initLights(std::vector<LightDefinition> const& lights)
     m_systemData.numLights = numLights;
   }
 
+  // The light sampling callables in specialized pipelines depend on the light types in the scene.
+  m_lightTypes.resize(numLights);
+  for (int i = 0; i < numLights; ++i)
+  {
+    m_lightTypes[i] = lights[i].type;
+  }
+
   m_isDirtySystemData = true;  // Trigger full update of the device system data on the next launch.
+  m_isDirtyPipeline   = true;
 }
 
 void Device::initMaterials(std::vector<MaterialGUI> const& materialsGUI)
@@ -1028,6 +1556,7 @@ void Device::initMaterials(std::vector<MaterialGUI> const& materialsGUI)
 
     material.textureAlbedo = (materialGUI.useAlbedoTexture) ? m_textureAlbedo->getTextureObject() : 0;
     material.textureCutout = (materialGUI.useCutoutTexture) ? m_textureCutout->getTextureObject() : 0;
+    material.textureLod    = make_float2(getTextureLod(m_textureAlbedo), getTextureLod(m_textureCutout));
     material.roughness     = materialGUI.roughness;
     material.indexBSDF     = materialGUI.indexBSDF;
     material.albedo        = materialGUI.albedo;
@@ -1050,6 +1579,7 @@ void Device::initMaterials(std::vector<MaterialGUI> const& materialsGUI)
   CU_CHECK( cuMemcpyHtoDAsync(reinterpret_cast<CUdeviceptr>(m_systemData.materialDefinitions), m_materials.data(), sizeof(MaterialDefinition) * numMaterials, m_cudaStream) );
 
   m_isDirtySystemData = true;  // Trigger full update of the device system data on the next launch.
+  m_isDirtyPipeline   = true;  // The BXDF and cutout usage might have changed.
 }
 
 void Device::initScene(std::shared_ptr<sg::Group> root, const unsigned int numGeometries)
@@ -1059,6 +1589,18 @@ void Device::initScene(std::shared_ptr<sg::Group> root, const unsigned int numGe
 
   m_geometryData.resize(numGeometries);
 
+  // The acceleration structure build policy needs to know how often each GAS is instanced before building it.
+  m_geometryReferences.assign(numGeometries, 0);
+  countGeometryReferences(root);
+
+  size_t memoryFree  = 0;
+  size_t memoryTotal = 0;
+
+  CU_CHECK( cuMemGetInfo(&memoryFree, &memoryTotal) );
+
+  m_accelBudgetTotal     = (m_accelPolicy.budget != 0) ? std::min(m_accelPolicy.budget, memoryFree) : memoryFree;
+  m_accelBudgetRemaining = m_accelBudgetTotal;
+
   float matrix[12];
 
   // Set the affine matrix to identity by default.
@@ -1077,11 +1619,226 @@ void Device::initScene(std::shared_ptr<sg::Group> root, const unsigned int numGe
 }
 
 
-void Device::updateCamera(const int idCamera, CameraDefinition const& camera)
+// Hot reload. Geometries which are still referenced keep their GAS, only the added ones are built.
+// Changed transformations alone refit the TLAS when it allows updates, everything else rebuilds the TLAS and the hit records.
+void Device::updateScene(std::shared_ptr<sg::Group> root, const unsigned int numGeometries, SceneDiff const& diff)
 {
+  const bool rebuild = diff.instancesChanged || !diff.geometriesAdded.empty() || !diff.geometriesRemoved.empty();
+
+  if (!rebuild && diff.instancesMoved.empty())
+  {
+    return;
+  }
+
   activateContext();
   synchronizeStream();
 
+  for (const unsigned int idGeometry : diff.geometriesRemoved)
+  {
+    MY_ASSERT(idGeometry < m_geometryData.size());
+
+    GeometryData& geometryData = m_geometryData[idGeometry];
+
+    // Hot reloads remove and add geometry in bursts. The cache hands these blocks to the next createGeometry() calls.
+    m_bufferCache.free(geometryData.d_attributes);
+    m_bufferCache.free(geometryData.d_indices);
+    m_bufferCache.free(geometryData.d_gas);
+
+    geometryData = GeometryData(); // traversable == 0 builds the GAS again if this ID ever comes back.
+  }
+
+  m_geometryData.resize(numGeometries);
+
+  m_geometryReferences.assign(numGeometries, 0);
+  countGeometryReferences(root);
+
+  float matrix[12];
+
+  memset(matrix, 0, sizeof(float) * 12);
+  matrix[ 0] = 1.0f;
+  matrix[ 5] = 1.0f;
+  matrix[10] = 1.0f;
+
+  InstanceData data(~0u, -1, -1);
+
+  // Only the added geometries are built by createGeometry() in here.
+  m_instances.clear();
+  m_instanceData.clear();
+
+  traverseNode(root, matrix, data);
+
+  if (!rebuild && m_allowUpdateIAS)
+  {
+    updateTLAS();
+  }
+  else
+  {
+    m_bufferCache.free(m_d_ias);
+    m_d_ias = 0;
+
+    createTLAS();
+  }
+
+  if (rebuild)
+  {
+    m_bufferCache.free(reinterpret_cast<CUdeviceptr>(m_d_sbtRecordGeometryInstanceData));
+    m_d_sbtRecordGeometryInstanceData = nullptr;
+
+    createHitGroupRecords();
+  }
+
+  m_isDirtySystemData = true; // The topObject handle can change.
+}
+
+
+void Device::setViewsSequential(const bool sequential)
+{
+  m_viewsSequential = sequential;
+  m_isDirtyGraph    = true;
+}
+
+void Device::setGraphs(const bool enable)
+{
+  m_useGraphs = enable && (USE_ITERATION_GRAPH != 0);
+}
+
+void Device::launch(const unsigned int width, const unsigned int height)
+{
+  if (m_systemData.numViews == 0)
+  {
+    OPTIX_CHECK( m_api.optixLaunch(m_pipeline, m_cudaStream, reinterpret_cast<CUdeviceptr>(m_d_systemData), sizeof(SystemData), &m_sbt, width, height, /* depth */ 1) );
+    return;
+  }
+
+  // Whole views are distributed over the devices. Devices without a view have nothing to do.
+  if (m_systemData.numViews <= m_index)
+  {
+    return;
+  }
+  const unsigned int depth = (m_systemData.numViews - m_index + m_count - 1) / m_count;
+
+  if (!m_viewsSequential)
+  {
+    // PERF Small views alone don't fill the GPU. A single launch over all views does.
+    OPTIX_CHECK( m_api.optixLaunch(m_pipeline, m_cudaStream, reinterpret_cast<CUdeviceptr>(m_d_systemData), sizeof(SystemData), &m_sbt, m_viewLaunch.x, m_viewLaunch.y, depth) );
+    return;
+  }
+
+  // One launch per view, each sized to its view. Stream ordered, so the viewOffset updates don't need a synchronization.
+  for (unsigned int i = 0; i < depth; ++i)
+  {
+    const int indexView = m_index + i * m_count;
+
+    CU_CHECK( cuMemcpyHtoDAsync(reinterpret_cast<CUdeviceptr>(&m_d_systemData->viewOffset), &m_h_viewOffsets[indexView], sizeof(int), m_cudaStream) );
+    OPTIX_CHECK( m_api.optixLaunch(m_pipeline, m_cudaStream, reinterpret_cast<CUdeviceptr>(m_d_systemData), sizeof(SystemData), &m_sbt, m_views[indexView].size.x, m_views[indexView].size.y, /* depth */ 1) );
+  }
+  CU_CHECK( cuMemcpyHtoDAsync(reinterpret_cast<CUdeviceptr>(&m_d_systemData->viewOffset), &m_h_viewOffsets[m_systemData.numViews], sizeof(int), m_cudaStream) );
+}
+
+void Device::launchIteration(const unsigned int width, const unsigned int height)
+{
+  // The caller synchronized the stream, so no previous upload reads the pinned iterationIndex anymore.
+  *m_h_iterationIndex = m_systemData.iterationIndex;
+
+  updateRouletteCache(); // Outside of the captured graph. The launches read the cache through the SystemData pointer.
+
+#if USE_ITERATION_GRAPH
+  if (m_useGraphs)
+  {
+    // optixLaunch() bakes the pipeline, the SBT and the launch dimensions into the captured node.
+    // Everything else is read from device memory at replay time, so camera, material or SystemData changes don't need a recapture.
+    if (m_isDirtyGraph ||
+        m_graphPipeline != m_pipeline ||
+        memcmp(&m_graphSbt, &m_sbt, sizeof(OptixShaderBindingTable)) != 0 ||
+        m_graphWidth  != width ||
+        m_graphHeight != height)
+    {
+      captureIteration(width, height);
+    }
+
+    if (m_graphExec != nullptr)
+    {
+      CU_CHECK( cuGraphLaunch(m_graphExec, m_cudaStream) );
+      return;
+    }
+  }
+#endif
+
+  CU_CHECK( cuMemcpyHtoDAsync(reinterpret_cast<CUdeviceptr>(&m_d_systemData->iterationIndex), m_h_iterationIndex, sizeof(unsigned int), m_cudaStream) );
+  launch(width, height);
+}
+
+void Device::captureIteration(const unsigned int width, const unsigned int height)
+{
+#if USE_ITERATION_GRAPH
+  destroyIterationGraph();
+
+  m_isDirtyGraph  = false;
+  m_graphPipeline = m_pipeline;
+  m_graphSbt      = m_sbt;
+  m_graphWidth    = width;
+  m_graphHeight   = height;
+
+  CU_CHECK( cuStreamBeginCapture(m_cudaStream, CU_STREAM_CAPTURE_MODE_THREAD_LOCAL) );
+
+  bool captured = true;
+  try
+  {
+    // Nothing is executed while capturing. The stream only records the same sequence the direct path issues.
+    CU_CHECK( cuMemcpyHtoDAsync(reinterpret_cast<CUdeviceptr>(&m_d_systemData->iterationIndex), m_h_iterationIndex, sizeof(unsigned int), m_cudaStream) );
+    launch(width, height);
+  }
+  catch (std::exception const& e)
+  {
+    std::cerr << e.what() << '\n';
+    captured = false;
+  }
+
+  // Always end the capture, otherwise the stream stays unusable.
+  CUgraph graph = nullptr;
+  
+  const CUresult result = cuStreamEndCapture(m_cudaStream, &graph);
+  if (result == CUDA_SUCCESS && captured)
+  {
+    m_graph = graph;
+#if 12000 <= CUDA_VERSION
+    CU_CHECK( cuGraphInstantiate(&m_graphExec, m_graph, 0) );
+#else
+    CU_CHECK( cuGraphInstantiate(&m_graphExec, m_graph, nullptr, nullptr, 0) );
+#endif
+    return;
+  }
+
+  if (graph != nullptr)
+  {
+    CU_CHECK( cuGraphDestroy(graph) );
+  }
+  
+  std::cerr << "WARNING: captureIteration() failed on device " << m_ordinal << ". Falling back to direct launches.\n";
+  m_useGraphs = false;
+#endif
+}
+
+void Device::destroyIterationGraph()
+{
+  if (m_graphExec != nullptr)
+  {
+    CU_CHECK( cuGraphExecDestroy(m_graphExec) );
+    m_graphExec = nullptr;
+  }
+  if (m_graph != nullptr)
+  {
+    CU_CHECK( cuGraphDestroy(m_graph) );
+    m_graph = nullptr;
+  }
+}
+
+// The update functions don't synchronize. The copies are ordered behind the previous launch in the stream
+// and the pageable host sources are staged before the calls return.
+void Device::updateCamera(const int idCamera, CameraDefinition const& camera)
+{
+  activateContext();
+
   MY_ASSERT(idCamera < m_systemData.numCameras);
   CU_CHECK( cuMemcpyHtoDAsync(reinterpret_cast<CUdeviceptr>(&m_systemData.cameraDefinitions[idCamera]), &camera, sizeof(CameraDefinition), m_cudaStream) );
 }
@@ -1089,7 +1846,6 @@ void Device::updateCamera(const int idCamera, CameraDefinition const& camera)
 void Device::updateLight(const int idLight, LightDefinition const& light)
 {
   activateContext();
-  synchronizeStream();
 
   MY_ASSERT(idLight < m_systemData.numLights);
   CU_CHECK( cuMemcpyHtoDAsync(reinterpret_cast<CUdeviceptr>(&m_systemData.lightDefinitions[idLight]), &light, sizeof(LightDefinition), m_cudaStream) );
@@ -1098,7 +1854,6 @@ void Device::updateLight(const int idLight, LightDefinition const& light)
 void Device::updateMaterial(const int idMaterial, MaterialGUI const& materialGUI)
 {
   activateContext();
-  synchronizeStream();
 
   MY_ASSERT(idMaterial < m_materials.size());
   MaterialDefinition& material = m_materials[idMaterial];  // MaterialDefinition on the host in device layout.
@@ -1108,8 +1863,16 @@ void Device::updateMaterial(const int idMaterial, MaterialGUI const& materialGUI
 
   const bool changeShader = (material.textureCutout != 0) != materialGUI.useCutoutTexture; // Cutout state wil be toggled?
 
+  // Specialized pipelines only contain the BXDF and cutout programs used by the materials.
+  // A pipeline which doesn't support the new material anymore is replaced before the next launch inside updatePipeline().
+  if (changeShader || material.indexBSDF != materialGUI.indexBSDF)
+  {
+    m_isDirtyPipeline = true;
+  }
+
   material.textureAlbedo = (materialGUI.useAlbedoTexture) ? m_textureAlbedo->getTextureObject() : 0;
   material.textureCutout = (materialGUI.useCutoutTexture) ? m_textureCutout->getTextureObject() : 0;
+  material.textureLod    = make_float2(getTextureLod(m_textureAlbedo), getTextureLod(m_textureCutout));
   material.roughness     = materialGUI.roughness;
   material.indexBSDF     = materialGUI.indexBSDF;
   material.albedo        = materialGUI.albedo;
@@ -1164,6 +1927,29 @@ void Device::updateMaterial(const int idMaterial, MaterialGUI const& materialGUI
   }
 }
 
+void Device::applyParameters(ParameterDiff const& diff)
+{
+  ParameterSnapshot const& snapshot = *diff.snapshot;
+
+  // The state goes first, it can reallocate the buffers and needs to synchronize for that.
+  if (diff.isDirtyState)
+  {
+    setState(*snapshot.state);
+  }
+  for (const int id : diff.cameras)
+  {
+    updateCamera(id, (*snapshot.cameras)[id]);
+  }
+  for (const int id : diff.lights)
+  {
+    updateLight(id, (*snapshot.lights)[id]);
+  }
+  for (const int id : diff.materials)
+  {
+    updateMaterial(id, (*snapshot.materials)[id]);
+  }
+}
+
 
 static int2 calculateTileShift(const int2 tileSize)
 {
@@ -1190,12 +1976,19 @@ void Device::setState(DeviceState const& state)
   activateContext();
   synchronizeStream();
 
+  bool isDirtyTimeView = false;
+  bool isDirtyAovs     = false;
+  bool isDirtyRoulette = false;
+
   if (m_systemData.resolution != state.resolution)
   {
     m_systemData.resolution = state.resolution;
 
     m_isDirtyOutputBuffer = true;
     m_isDirtySystemData   = true;
+    isDirtyTimeView       = true;
+    isDirtyAovs           = true;
+    isDirtyRoulette       = true;
   }
 
   if (m_systemData.tileSize != state.tileSize)
@@ -1203,6 +1996,61 @@ void Device::setState(DeviceState const& state)
     m_systemData.tileSize  = state.tileSize;
     m_systemData.tileShift = calculateTileShift(m_systemData.tileSize);
     m_isDirtySystemData = true;
+    isDirtyTimeView     = true; // The pixel ownership among devices changed. Stale cycles of other tiles must not survive.
+    isDirtyAovs         = true;
+
+    if (m_systemData.accumulationLayout == ACCUMULATION_LAYOUT_TILED)
+    {
+      m_isDirtyOutputBuffer = true; // The tiles and their padding changed.
+    }
+  }
+
+  // The other strategies display or merge their outputBuffer directly and have no detiling step.
+  const int accumulationLayout = (m_strategy == RS_INTERACTIVE_MULTI_GPU_ZERO_COPY || m_strategy == RS_INTERACTIVE_MULTI_GPU_LOCAL_COPY)
+                               ? state.accumulationLayout : ACCUMULATION_LAYOUT_LINEAR;
+
+  if (m_systemData.accumulationLayout != accumulationLayout)
+  {
+    m_systemData.accumulationLayout = accumulationLayout;
+    m_isDirtyOutputBuffer = true; // The tiled buffers are padded to whole tiles.
+    m_isDirtySystemData   = true;
+  }
+
+  if (m_systemData.timeView != state.timeView)
+  {
+    m_systemData.timeView = state.timeView;
+    m_isDirtySystemData = true;
+    isDirtyTimeView     = true;
+  }
+
+  if (isDirtyTimeView)
+  {
+    updateTimeViewBuffers();
+  }
+
+  if (m_systemData.aovMask != state.aovMask)
+  {
+    m_systemData.aovMask = state.aovMask;
+    m_isDirtySystemData = true;
+    m_isDirtyPipeline   = true; // Bound value in specialized pipelines.
+    isDirtyAovs         = true;
+  }
+
+  if (isDirtyAovs)
+  {
+    updateAovBuffers();
+  }
+
+  if (m_systemData.rouletteMode != state.roulette)
+  {
+    m_systemData.rouletteMode = state.roulette;
+    m_isDirtySystemData = true;
+    isDirtyRoulette     = true;
+  }
+
+  if (isDirtyRoulette)
+  {
+    updateRouletteBuffers();
   }
 
   if (m_systemData.samplesSqrt != state.samplesSqrt)
@@ -1215,6 +2063,7 @@ void Device::setState(DeviceState const& state)
   {
     m_systemData.lensShader = state.lensShader;
     m_isDirtySystemData = true;
+    m_isDirtyPipeline   = true; // Bound value in specialized pipelines.
   }
 
   if (m_systemData.pathLengths != state.pathLengths)
@@ -1222,6 +2071,15 @@ void Device::setState(DeviceState const& state)
     m_systemData.pathLengths = state.pathLengths;
     m_isDirtySystemData = true;
   }
+
+  m_accelPolicy = state.accelPolicy; // Only used by the next initScene().
+  m_envFormat   = state.envFormat;   // Only used by initTextures().
+
+  if (m_specialize != (state.specialize != 0))
+  {
+    m_specialize      = (state.specialize != 0);
+    m_isDirtyPipeline = true;
+  }
   
   if (m_systemData.sceneEpsilon != state.epsilonFactor * SCENE_EPSILON_SCALE)
   {
@@ -1236,40 +2094,433 @@ void Device::setState(DeviceState const& state)
     m_isDirtySystemData = true;
   }
 
-#if USE_TIME_VIEW
   if (m_systemData.clockScale != state.clockFactor * CLOCK_FACTOR_SCALE)
   {
     m_systemData.clockScale = state.clockFactor * CLOCK_FACTOR_SCALE;
     m_isDirtySystemData = true;
   }
+}
+
+
+// The time view buffers are resolution sized on all devices and in all rendering strategies.
+// Each device only writes the pixels it renders and the rest stays zero, so the host can simply sum the device buffers.
+void Device::updateTimeViewBuffers()
+{
+  m_bufferCache.free(m_systemData.timeBuffer); // Freeing a null pointer is fine.
+  m_bufferCache.free(m_systemData.idBuffer);
+
+  m_systemData.timeBuffer = 0;
+  m_systemData.idBuffer   = 0;
+
+  if (m_systemData.timeView)
+  {
+    const size_t numPixels = size_t(m_systemData.resolution.x) * size_t(m_systemData.resolution.y);
+
+    m_systemData.timeBuffer = m_bufferCache.alloc(sizeof(float) * numPixels);
+    m_systemData.idBuffer   = m_bufferCache.alloc(sizeof(uint2) * numPixels);
+
+    CU_CHECK( cuMemsetD32(m_systemData.timeBuffer, 0, numPixels) );
+    CU_CHECK( cuMemsetD32(m_systemData.idBuffer, 0, numPixels * 2) );
+  }
+
+  m_isDirtySystemData = true;
+}
+
+
+void Device::getTimeViewHost(std::vector<float>& cycles, std::vector<unsigned int>& ids)
+{
+  const size_t numPixels = size_t(m_systemData.resolution.x) * size_t(m_systemData.resolution.y);
+
+  cycles.resize(numPixels);
+  ids.resize(numPixels * 2);
+
+  if (!m_systemData.timeView || m_systemData.timeBuffer == 0)
+  {
+    std::fill(cycles.begin(), cycles.end(), 0.0f);
+    std::fill(ids.begin(), ids.end(), 0u);
+    return;
+  }
+
+  activateContext();
+  synchronizeStream(); // Wait for the current launch to finish.
+
+  CU_CHECK( cuMemcpyDtoH(cycles.data(), m_systemData.timeBuffer, sizeof(float) * numPixels) );
+  CU_CHECK( cuMemcpyDtoH(ids.data(), m_systemData.idBuffer, sizeof(unsigned int) * 2 * numPixels) );
+}
+
+
+BufferCacheStatistics const& Device::getBufferCacheStatistics() const
+{
+  return m_bufferCache.getStatistics();
+}
+
+void Device::trimBufferCache()
+{
+  activateContext();
+  synchronizeStream();
+
+  m_bufferCache.trim();
+}
+
+
+// Same ownership rules as the time view buffers. Callers need to restart the accumulation.
+void Device::updateAovBuffers()
+{
+  const size_t numPixels = size_t(m_systemData.resolution.x) * size_t(m_systemData.resolution.y);
+
+  for (int i = 0; i < NUM_AOVS; ++i)
+  {
+    m_bufferCache.free(m_systemData.aovBuffers[i]);
+    m_systemData.aovBuffers[i] = 0;
+
+    if (m_systemData.aovMask & (1u << i))
+    {
+      const size_t size = getAovElementSize(i) * numPixels;
+
+      m_systemData.aovBuffers[i] = m_bufferCache.alloc(size);
+      CU_CHECK( cuMemsetD8(m_systemData.aovBuffers[i], 0, size) );
+    }
+  }
+
+  m_isDirtySystemData = true;
+}
+
+
+// The roulette cache and statistics are per device and only hold the tiles of the pixels this device renders.
+// Callers need to restart the accumulation, the cache is relearned from iterationIndex 0.
+void Device::updateRouletteBuffers()
+{
+  m_bufferCache.free(reinterpret_cast<CUdeviceptr>(m_systemData.rouletteCache));
+  m_bufferCache.free(reinterpret_cast<CUdeviceptr>(m_systemData.rouletteStats));
+
+  m_systemData.rouletteCache = nullptr;
+  m_systemData.rouletteStats = nullptr;
+  m_systemData.rouletteTiles = make_int2(0, 0);
+
+  m_rouletteStats.clear();
+  m_rouletteCache.clear();
+
+  if (m_systemData.rouletteMode)
+  {
+    m_systemData.rouletteTiles = rouletteTiles(m_systemData.resolution);
+
+    const size_t numEntries = size_t(m_systemData.rouletteTiles.x) * size_t(m_systemData.rouletteTiles.y) * ROULETTE_DEPTHS;
+
+    m_systemData.rouletteCache = reinterpret_cast<float*>(m_bufferCache.alloc(sizeof(float) * numEntries));
+    m_systemData.rouletteStats = reinterpret_cast<float2*>(m_bufferCache.alloc(sizeof(float2) * numEntries));
+
+    m_rouletteStats.resize(numEntries);
+    m_rouletteCache.resize(numEntries);
+  }
+
+  m_isDirtySystemData = true;
+}
+
+
+// Rebuilds the roulette cache from the statistics of all previous iterations at power-of-two iteration indices.
+// Restarting the accumulation clears the statistics and invalidates the cache, which falls back to the fixed rule until enough samples arrived.
+// Called with the stream synchronized.
+void Device::updateRouletteCache()
+{
+  if (!m_systemData.rouletteMode)
+  {
+    return;
+  }
+
+  const unsigned int iterationIndex = m_systemData.iterationIndex;
+
+  if (iterationIndex == 0)
+  {
+    std::fill(m_rouletteCache.begin(), m_rouletteCache.end(), -1.0f);
+
+    CU_CHECK( cuMemsetD32Async(reinterpret_cast<CUdeviceptr>(m_systemData.rouletteStats), 0, m_rouletteStats.size() * 2, m_cudaStream) );
+  }
+  else if ((iterationIndex & (iterationIndex - 1)) == 0)
+  {
+    CU_CHECK( cuMemcpyDtoH(m_rouletteStats.data(), reinterpret_cast<CUdeviceptr>(m_systemData.rouletteStats), sizeof(float2) * m_rouletteStats.size()) );
+
+    for (size_t i = 0; i < m_rouletteStats.size(); ++i)
+    {
+      m_rouletteCache[i] = rouletteCacheEntry(m_rouletteStats[i]);
+    }
+  }
+  else
+  {
+    return;
+  }
+
+  CU_CHECK( cuMemcpyHtoDAsync(reinterpret_cast<CUdeviceptr>(m_systemData.rouletteCache), m_rouletteCache.data(), sizeof(float) * m_rouletteCache.size(), m_cudaStream) );
+}
+
+
+void Device::getAovHost(const int index, std::vector<unsigned char>& aov)
+{
+  MY_ASSERT(0 <= index && index < NUM_AOVS);
+
+  const size_t size = getAovElementSize(index) * size_t(m_systemData.resolution.x) * size_t(m_systemData.resolution.y);
+
+  aov.resize(size);
+
+  if (m_systemData.aovBuffers[index] == 0)
+  {
+    std::fill(aov.begin(), aov.end(), static_cast<unsigned char>(0));
+    return;
+  }
+
+  activateContext();
+  synchronizeStream(); // Wait for the current launch to finish.
+
+  CU_CHECK( cuMemcpyDtoH(aov.data(), m_systemData.aovBuffers[index], size) );
+}
+
+
+// The ray query pipeline only contains a raygeneration program reading the rays from a buffer and a closest hit program
+// returning the hit information in the payload registers. It traces against the same TLAS as the renderer.
+void Device::initQueryPipeline()
+{
+  OptixModuleCompileOptions mco = {};
+
+  mco.maxRegisterCount = OPTIX_COMPILE_DEFAULT_MAX_REGISTER_COUNT;
+  mco.optLevel         = OPTIX_COMPILE_OPTIMIZATION_LEVEL_3;
+#if (OPTIX_VERSION >= 70400)
+  mco.debugLevel = OPTIX_COMPILE_DEBUG_LEVEL_MINIMAL; 
+#else
+  mco.debugLevel = OPTIX_COMPILE_DEBUG_LEVEL_LINEINFO;
+#endif
+
+  OptixPipelineCompileOptions pco = {};
+
+  pco.usesMotionBlur        = 0;
+  pco.traversableGraphFlags = OPTIX_TRAVERSABLE_GRAPH_FLAG_ALLOW_SINGLE_LEVEL_INSTANCING;
+  pco.numPayloadValues      = 5; // t, instance ID, primitive index, barycentrics.
+  pco.numAttributeValues    = 2;
+  pco.exceptionFlags        = OPTIX_EXCEPTION_FLAG_NONE;
+  pco.pipelineLaunchParamsVariableName = "queryParameters";
+#if (OPTIX_VERSION != 70000)
+  pco.usesPrimitiveTypeFlags = OPTIX_PRIMITIVE_TYPE_FLAGS_TRIANGLE;
 #endif
+
+  std::vector<char> programData = readData(m_queryModuleFilename);
+
+  OptixModule module = nullptr;
+
+  OPTIX_CHECK( m_api.optixModuleCreateFromPTX(m_optixContext, &mco, &pco, programData.data(), programData.size(), nullptr, nullptr, &module) );
+
+  OptixProgramGroupDesc programGroupDescriptions[3];
+  memset(programGroupDescriptions, 0, sizeof(OptixProgramGroupDesc) * 3);
+
+  OptixProgramGroupDesc* pgd;
+
+  pgd = &programGroupDescriptions[0];
+  pgd->kind  = OPTIX_PROGRAM_GROUP_KIND_RAYGEN;
+  pgd->flags = OPTIX_PROGRAM_GROUP_FLAGS_NONE;
+  pgd->raygen.module            = module;
+  pgd->raygen.entryFunctionName = "__raygen__ray_query";
+
+  pgd = &programGroupDescriptions[1];
+  pgd->kind  = OPTIX_PROGRAM_GROUP_KIND_MISS;
+  pgd->flags = OPTIX_PROGRAM_GROUP_FLAGS_NONE;
+  pgd->miss.module            = nullptr;
+  pgd->miss.entryFunctionName = nullptr; // The payload is initialized with the miss values.
+
+  pgd = &programGroupDescriptions[2];
+  pgd->kind  = OPTIX_PROGRAM_GROUP_KIND_HITGROUP;
+  pgd->flags = OPTIX_PROGRAM_GROUP_FLAGS_NONE;
+  pgd->hitgroup.moduleCH            = module;
+  pgd->hitgroup.entryFunctionNameCH = "__closesthit__ray_query";
+
+  OptixProgramGroupOptions pgo = {};
+
+  OptixProgramGroup programGroups[3];
+
+  OPTIX_CHECK( m_api.optixProgramGroupCreate(m_optixContext, programGroupDescriptions, 3, &pgo, nullptr, nullptr, programGroups) );
+
+  OptixPipelineLinkOptions plo = {};
+
+  plo.maxTraceDepth = 1;
+#if (OPTIX_VERSION >= 70400)
+  plo.debugLevel = OPTIX_COMPILE_DEBUG_LEVEL_MINIMAL; 
+#else
+  plo.debugLevel = OPTIX_COMPILE_DEBUG_LEVEL_LINEINFO;
+#endif
+#if (OPTIX_VERSION == 70000)
+  plo.overrideUsesMotionBlur = 0;
+#endif
+
+  OPTIX_CHECK( m_api.optixPipelineCreate(m_optixContext, &pco, &plo, programGroups, 3, nullptr, nullptr, &m_queryPipeline) );
+
+  OptixStackSizes ssp = {};
+
+  for (int i = 0; i < 3; ++i)
+  {
+    OptixStackSizes ss;
+
+    OPTIX_CHECK( m_api.optixProgramGroupGetStackSize(programGroups[i], &ss) );
+
+    ssp.cssRG = std::max(ssp.cssRG, ss.cssRG);
+    ssp.cssMS = std::max(ssp.cssMS, ss.cssMS);
+    ssp.cssCH = std::max(ssp.cssCH, ss.cssCH);
+    ssp.cssAH = std::max(ssp.cssAH, ss.cssAH);
+    ssp.cssIS = std::max(ssp.cssIS, ss.cssIS);
+  }
+
+  // maxTraceDepth == 1, no callables.
+  const unsigned int continuationStackSize = ssp.cssRG + std::max(std::max(ssp.cssCH, ssp.cssMS), ssp.cssAH + ssp.cssIS);
+
+  OPTIX_CHECK( m_api.optixPipelineSetStackSize(m_queryPipeline, 0, 0, continuationStackSize, 2) );
+
+  for (int i = 0; i < 3; ++i)
+  {
+    OPTIX_CHECK( m_api.optixSbtRecordPackHeader(programGroups[i], &m_queryHeaders[i]) );
+    OPTIX_CHECK( m_api.optixProgramGroupDestroy(programGroups[i]) );
+  }
+
+  OPTIX_CHECK( m_api.optixModuleDestroy(module) );
+
+  CU_CHECK( cuMemAlloc(reinterpret_cast<CUdeviceptr*>(&m_d_queryParameters), sizeof(QueryParameters)) );
 }
 
-// This is only overloaded by the derived DeviceMultiGPULocalCopy class.
-void Device::compositor(Device* /* other */)
+// The TLAS instances address the hit records with sbtOffset = instance ID * NUM_RAYTYPES.
+// The query SBT mirrors that layout with the same closest hit program in every record.
+void Device::updateQueryRecords()
+{
+  const unsigned int numHitRecords = NUM_RAYTYPES * std::max(1u, static_cast<unsigned int>(m_instances.size()));
+
+  if (m_d_queryRecords != 0 && m_queryNumHitRecords == numHitRecords)
+  {
+    return;
+  }
+
+  std::vector<SbtRecordHeader> records(2 + numHitRecords, m_queryHeaders[2]);
+
+  records[0] = m_queryHeaders[0];
+  records[1] = m_queryHeaders[1];
+
+  synchronizeStream(); // The old records could still be in use by a previous query launch.
+
+  m_bufferCache.free(m_d_queryRecords);
+  m_d_queryRecords = m_bufferCache.alloc(sizeof(SbtRecordHeader) * records.size());
+  CU_CHECK( cuMemcpyHtoDAsync(m_d_queryRecords, records.data(), sizeof(SbtRecordHeader) * records.size(), m_cudaStream) );
+
+  m_queryNumHitRecords = numHitRecords;
+
+  m_querySbt = {};
+
+  m_querySbt.raygenRecord = m_d_queryRecords;
+
+  m_querySbt.missRecordBase          = m_d_queryRecords + sizeof(SbtRecordHeader);
+  m_querySbt.missRecordStrideInBytes = (unsigned int) sizeof(SbtRecordHeader);
+  m_querySbt.missRecordCount         = 1;
+
+  m_querySbt.hitgroupRecordBase          = m_d_queryRecords + sizeof(SbtRecordHeader) * 2;
+  m_querySbt.hitgroupRecordStrideInBytes = (unsigned int) sizeof(SbtRecordHeader);
+  m_querySbt.hitgroupRecordCount         = numHitRecords;
+}
+
+void Device::traceRays(CUdeviceptr rays, CUdeviceptr hits, const unsigned int count)
+{
+  activateContext();
+
+  if (m_queryPipeline == nullptr)
+  {
+    initQueryPipeline();
+  }
+  updateQueryRecords();
+
+  // The launch dimension is limited to 2^30.
+  const unsigned int maxLaunch = 1u << 30;
+
+  for (unsigned int offset = 0; offset < count; offset += maxLaunch)
+  {
+    const unsigned int launch = std::min(count - offset, maxLaunch);
+
+    QueryParameters parameters;
+
+    parameters.topObject = m_systemData.topObject; // A null handle results in misses.
+    parameters.rays      = reinterpret_cast<const QueryRay*>(rays) + offset;
+    parameters.hits      = reinterpret_cast<QueryHit*>(hits) + offset;
+    parameters.count     = launch;
+
+    // Ordered behind the previous launch in the same stream, so one parameter block is enough.
+    CU_CHECK( cuMemcpyHtoDAsync(reinterpret_cast<CUdeviceptr>(m_d_queryParameters), &parameters, sizeof(QueryParameters), m_cudaStream) );
+
+    OPTIX_CHECK( m_api.optixLaunch(m_queryPipeline, m_cudaStream, reinterpret_cast<CUdeviceptr>(m_d_queryParameters), sizeof(QueryParameters), &m_querySbt, launch, 1, 1) );
+  }
+}
+
+// PERF While the GPU works on one slot, the host copies the rays of the next chunk into the other slot's pinned memory.
+void Device::submitRays(const QueryRay* rays, QueryHit* hits, const unsigned int count)
 {
+  activateContext();
+
+  QuerySlot& slot = m_querySlots[m_querySlot];
+
+  m_querySlot ^= 1;
+
+  retireQuerySlot(slot);
+
+  if (slot.capacity < count)
+  {
+    CU_CHECK( cuMemFree(slot.d_rays) );
+    CU_CHECK( cuMemFree(slot.d_hits) );
+    CU_CHECK( cuMemFreeHost(slot.h_rays) );
+    CU_CHECK( cuMemFreeHost(slot.h_hits) );
+
+    CU_CHECK( cuMemAlloc(&slot.d_rays, sizeof(QueryRay) * count) );
+    CU_CHECK( cuMemAlloc(&slot.d_hits, sizeof(QueryHit) * count) );
+    CU_CHECK( cuMemAllocHost(reinterpret_cast<void**>(&slot.h_rays), sizeof(QueryRay) * count) );
+    CU_CHECK( cuMemAllocHost(reinterpret_cast<void**>(&slot.h_hits), sizeof(QueryHit) * count) );
+
+    slot.capacity = count;
+  }
+  if (slot.event == nullptr)
+  {
+    CU_CHECK( cuEventCreate(&slot.event, CU_EVENT_DISABLE_TIMING) );
+  }
+
+  memcpy(slot.h_rays, rays, sizeof(QueryRay) * count);
+
+  CU_CHECK( cuMemcpyHtoDAsync(slot.d_rays, slot.h_rays, sizeof(QueryRay) * count, m_cudaStream) );
+
+  traceRays(slot.d_rays, slot.d_hits, count);
+
+  CU_CHECK( cuMemcpyDtoHAsync(slot.h_hits, slot.d_hits, sizeof(QueryHit) * count, m_cudaStream) );
+  CU_CHECK( cuEventRecord(slot.event, m_cudaStream) );
+
+  slot.dst   = hits;
+  slot.count = count;
 }
 
+void Device::retireQuerySlot(QuerySlot& slot)
+{
+  if (slot.dst == nullptr)
+  {
+    return;
+  }
+
+  CU_CHECK( cuEventSynchronize(slot.event) );
+
+  memcpy(slot.dst, slot.h_hits, sizeof(QueryHit) * slot.count);
 
-// m = a * b;
-static void multiplyMatrix(float* m, const float* a, const float* b)
+  slot.dst   = nullptr;
+  slot.count = 0;
+}
+
+void Device::finishRays()
+{
+  activateContext();
+
+  // The slot of the next submission is the older one.
+  retireQuerySlot(m_querySlots[m_querySlot]);
+  retireQuerySlot(m_querySlots[m_querySlot ^ 1]);
+}
+
+// This is only overloaded by the derived DeviceMultiGPULocalCopy class.
+void Device::compositor(Device* /* other */)
 {
-  m[ 0] = a[0] * b[0] + a[1] * b[4] + a[ 2] * b[ 8]; // + a[3] * 0
-  m[ 1] = a[0] * b[1] + a[1] * b[5] + a[ 2] * b[ 9]; // + a[3] * 0
-  m[ 2] = a[0] * b[2] + a[1] * b[6] + a[ 2] * b[10]; // + a[3] * 0
-  m[ 3] = a[0] * b[3] + a[1] * b[7] + a[ 2] * b[11] + a[3]; // * 1
-  
-  m[ 4] = a[4] * b[0] + a[5] * b[4] + a[ 6] * b[ 8]; // + a[7] * 0
-  m[ 5] = a[4] * b[1] + a[5] * b[5] + a[ 6] * b[ 9]; // + a[7] * 0
-  m[ 6] = a[4] * b[2] + a[5] * b[6] + a[ 6] * b[10]; // + a[7] * 0
-  m[ 7] = a[4] * b[3] + a[5] * b[7] + a[ 6] * b[11] + a[7]; // * 1
-
-  m[ 8] = a[8] * b[0] + a[9] * b[4] + a[10] * b[ 8]; // + a[11] * 0
-  m[ 9] = a[8] * b[1] + a[9] * b[5] + a[10] * b[ 9]; // + a[11] * 0
-  m[10] = a[8] * b[2] + a[9] * b[6] + a[10] * b[10]; // + a[11] * 0
-  m[11] = a[8] * b[3] + a[9] * b[7] + a[10] * b[11] + a[11]; // * 1
 }
 
+
 void Device::traverseNode(std::shared_ptr<sg::Node> node, float matrix[12], InstanceData data)
 {
   switch (node->getType())
@@ -1291,7 +2542,7 @@ void Device::traverseNode(std::shared_ptr<sg::Node> node, float matrix[12], Inst
 
       // Concatenate the transformations along the path.
       float trafo[12];
-      multiplyMatrix(trafo, matrix, instance->getTransform());
+      dp::math::concatenateMatrices(matrix, instance->getTransform(), trafo, 1);
 
       int idMaterial = instance->getMaterial();
       if (0 <= idMaterial)
@@ -1320,6 +2571,65 @@ void Device::traverseNode(std::shared_ptr<sg::Node> node, float matrix[12], Inst
   }
 }
 
+void Device::countGeometryReferences(std::shared_ptr<sg::Node> node)
+{
+  switch (node->getType())
+  {
+    case sg::NodeType::NT_GROUP:
+    {
+      std::shared_ptr<sg::Group> group = std::dynamic_pointer_cast<sg::Group>(node);
+
+      for (size_t i = 0; i < group->getNumChildren(); ++i)
+      {
+        countGeometryReferences(group->getChild(i));
+      }
+    }
+    break;
+
+    case sg::NodeType::NT_INSTANCE:
+    {
+      std::shared_ptr<sg::Instance> instance = std::dynamic_pointer_cast<sg::Instance>(node);
+
+      countGeometryReferences(instance->getChild());
+    }
+    break;
+
+    case sg::NodeType::NT_TRIANGLES:
+    {
+      std::shared_ptr<sg::Triangles> geometry = std::dynamic_pointer_cast<sg::Triangles>(node);
+
+      const unsigned int idGeometry = geometry->getId();
+      MY_ASSERT(idGeometry < m_geometryReferences.size());
+
+      ++m_geometryReferences[idGeometry];
+    }
+    break;
+  }
+}
+
+static unsigned int getAccelBuildFlags(AccelDecision const& decision)
+{
+  unsigned int flags = OPTIX_BUILD_FLAG_NONE;
+
+  if (decision.fastTrace)
+  {
+    flags |= OPTIX_BUILD_FLAG_PREFER_FAST_TRACE;
+  }
+  if (decision.fastBuild)
+  {
+    flags |= OPTIX_BUILD_FLAG_PREFER_FAST_BUILD;
+  }
+  if (decision.compaction)
+  {
+    flags |= OPTIX_BUILD_FLAG_ALLOW_COMPACTION;
+  }
+  if (decision.allowUpdate)
+  {
+    flags |= OPTIX_BUILD_FLAG_ALLOW_UPDATE;
+  }
+  return flags;
+}
+
 unsigned int Device::createGeometry(std::shared_ptr<sg::Triangles> geometry)
 {
   const unsigned int idGeometry = geometry->getId();
@@ -1336,17 +2646,15 @@ unsigned int Device::createGeometry(std::shared_ptr<sg::Triangles> geometry)
 
   const size_t attributesSizeInBytes = sizeof(TriangleAttributes) * attributes.size();
 
-  CUdeviceptr d_attributes;
-
+  // The persistent geometry and GAS buffers come from the buffer cache as well, so the GAS churn of hot reloads reuses the blocks.
+  // The size classes waste less than 25% of a block. The acceleration structure budget accounts the requested sizes.
   // DAR FIXME This all needs some Buffer class which maintains CUdeviceptr per Device, supporting separate allocations and peer-to-peer on multiple islands.
-  CU_CHECK( cuMemAlloc(&d_attributes, attributesSizeInBytes) );
+  CUdeviceptr d_attributes = m_bufferCache.alloc(attributesSizeInBytes);
   CU_CHECK( cuMemcpyHtoDAsync(d_attributes, attributes.data(), attributesSizeInBytes, m_cudaStream) );
 
   const size_t indicesSizeInBytes = sizeof(int) * indices.size();
 
-  CUdeviceptr d_indices;
-
-  CU_CHECK( cuMemAlloc(&d_indices, indicesSizeInBytes) );
+  CUdeviceptr d_indices = m_bufferCache.alloc(indicesSizeInBytes);
   CU_CHECK( cuMemcpyHtoDAsync(d_indices, indices.data(), indicesSizeInBytes, m_cudaStream) );
 
   OptixBuildInput buildInput = {};
@@ -1375,28 +2683,111 @@ unsigned int Device::createGeometry(std::shared_ptr<sg::Triangles> geometry)
   accelBuildOptions.operation  = OPTIX_BUILD_OPERATION_BUILD;
 
   OptixAccelBufferSizes accelBufferSizes;
+
+  AccelDecision decision; // Defaults to OPTIX_BUILD_FLAG_NONE.
+
+  if (m_accelPolicy.mode != 0)
+  {
+    // Query the memory requirements of both build preferences. ALLOW_UPDATE is included when requested because it enlarges the GAS.
+    AccelDecision candidate;
+
+    candidate.compaction  = true;
+    candidate.allowUpdate = (m_accelPolicy.allowUpdate != 0);
+
+    AccelRequest request;
+
+    request.numTriangles    = indices.size() / 3;
+    request.numInstances    = m_geometryReferences[idGeometry];
+    request.budgetTotal     = m_accelBudgetTotal;
+    request.budgetRemaining = m_accelBudgetRemaining;
+
+    candidate.fastTrace = true;
+    accelBuildOptions.buildFlags = getAccelBuildFlags(candidate);
+    OPTIX_CHECK( m_api.optixAccelComputeMemoryUsage(m_optixContext, &accelBuildOptions, &buildInput, 1, &accelBufferSizes) );
+    request.sizeFastTrace = accelBufferSizes.outputSizeInBytes + accelBufferSizes.tempSizeInBytes;
+
+    candidate.fastTrace = false;
+    candidate.fastBuild = true;
+    accelBuildOptions.buildFlags = getAccelBuildFlags(candidate);
+    OPTIX_CHECK( m_api.optixAccelComputeMemoryUsage(m_optixContext, &accelBuildOptions, &buildInput, 1, &accelBufferSizes) );
+    request.sizeFastBuild = accelBufferSizes.outputSizeInBytes + accelBufferSizes.tempSizeInBytes;
+
+    // The attributes and indices are already allocated. decideAccelBuild() picks the smallest configuration when nothing is left.
+    consumeAccelBudget(request.budgetRemaining, attributesSizeInBytes + indicesSizeInBytes);
+
+    decision = decideAccelBuild(m_accelPolicy, request);
+
+    accelBuildOptions.buildFlags = getAccelBuildFlags(decision);
+  }
   
   OPTIX_CHECK( m_api.optixAccelComputeMemoryUsage(m_optixContext, &accelBuildOptions, &buildInput, 1, &accelBufferSizes) );
 
-  CUdeviceptr d_gas; // This holds the acceleration structure.
+  CUdeviceptr d_gas = m_bufferCache.alloc(accelBufferSizes.outputSizeInBytes); // This holds the acceleration structure.
 
-  CU_CHECK( cuMemAlloc(&d_gas, accelBufferSizes.outputSizeInBytes) );
+  CUdeviceptr d_tmp = m_bufferCache.alloc(accelBufferSizes.tempSizeInBytes); // Allocate the temp buffer last to reduce VRAM fragmentation.
 
-  CUdeviceptr d_tmp;
+  OptixTraversableHandle traversableHandle = 0; // This is the handle which gets returned.
 
-  CU_CHECK( cuMemAlloc(&d_tmp, accelBufferSizes.tempSizeInBytes) ); // Allocate the temp buffer last to reduce VRAM fragmentation.
+  OptixAccelEmitDesc accelEmit = {};
 
-  OptixTraversableHandle traversableHandle = 0; // This is the handle which gets returned.
+  if (decision.compaction)
+  {
+    accelEmit.result = m_bufferCache.alloc(sizeof(size_t));
+    accelEmit.type = OPTIX_PROPERTY_TYPE_COMPACTED_SIZE;
+  }
 
   OPTIX_CHECK( m_api.optixAccelBuild(m_optixContext, m_cudaStream, 
                                      &accelBuildOptions, &buildInput, 1,
                                      d_tmp, accelBufferSizes.tempSizeInBytes,
                                      d_gas, accelBufferSizes.outputSizeInBytes, 
-                                     &traversableHandle, nullptr, 0) );
+                                     &traversableHandle,
+                                     (decision.compaction) ? &accelEmit : nullptr,
+                                     (decision.compaction) ? 1 : 0) );
 
   CU_CHECK( cuStreamSynchronize(m_cudaStream) );
 
-  CU_CHECK( cuMemFree(d_tmp) );
+  m_bufferCache.free(d_tmp);
+
+  size_t sizeGAS = accelBufferSizes.outputSizeInBytes;
+
+  if (decision.compaction)
+  {
+    size_t sizeCompact;
+
+    CU_CHECK( cuMemcpyDtoH(&sizeCompact, accelEmit.result, sizeof(size_t)) ); // Synchronous.
+    m_bufferCache.free(accelEmit.result);
+
+    // Compact the AS only when possible.
+    if (sizeCompact < accelBufferSizes.outputSizeInBytes)
+    {
+      CUdeviceptr d_gasCompact = m_bufferCache.alloc(sizeCompact);
+
+      OPTIX_CHECK( m_api.optixAccelCompact(m_optixContext, m_cudaStream, traversableHandle, d_gasCompact, sizeCompact, &traversableHandle) );
+
+      CU_CHECK( cuStreamSynchronize(m_cudaStream) ); // Must finish accessing the d_gas source before it can be freed.
+
+      m_bufferCache.free(d_gas);
+
+      d_gas   = d_gasCompact;
+      sizeGAS = sizeCompact;
+    }
+  }
+
+  if (m_accelPolicy.mode != 0)
+  {
+    const bool isExhausted = (m_accelBudgetRemaining == 0);
+
+    if (!consumeAccelBudget(m_accelBudgetRemaining, attributesSizeInBytes + indicesSizeInBytes + sizeGAS) && !isExhausted)
+    {
+      std::cerr << "WARNING: createGeometry() device = " << m_ordinal << ", geometry = " << idGeometry << " exhausted the acceleration structure budget.\n";
+    }
+
+    std::cout << "createGeometry() device = " << m_ordinal << ", geometry = " << idGeometry
+              << ": triangles = " << indices.size() / 3 << ", instances = " << m_geometryReferences[idGeometry]
+              << ", flags =" << ((decision.fastTrace) ? " FAST_TRACE" : "") << ((decision.fastBuild) ? " FAST_BUILD" : "")
+              << ((decision.compaction) ? " COMPACTION" : "") << ((decision.allowUpdate) ? " ALLOW_UPDATE" : "")
+              << ", GAS = " << sizeGAS << ", budget remaining = " << m_accelBudgetRemaining << " (" << decision.reason << ")\n";
+  }
   
   // Track the GeometryData to be able to set them in the SBT record GeometryInstanceData and free them on exit.
   // FIXME Move this to the top and use the fields directly.
@@ -1436,11 +2827,9 @@ void Device::createInstance(const OptixTraversableHandle traversable, float matr
 void Device::createTLAS()
 {
   // Construct the TLAS by attaching all flattened instances.
-  CUdeviceptr d_instances;
-  
   const size_t instancesSizeInBytes = sizeof(OptixInstance) * m_instances.size();
 
-  CU_CHECK( cuMemAlloc(&d_instances, instancesSizeInBytes) ); // This will fail with CUDA_ERROR_INVALID_VALUE if m_instances is empty.
+  CUdeviceptr d_instances = m_bufferCache.alloc(instancesSizeInBytes);
   CU_CHECK( cuMemcpyHtoDAsync(d_instances, m_instances.data(), instancesSizeInBytes, m_cudaStream) );
 
   OptixBuildInput instanceInput = {};
@@ -1449,20 +2838,21 @@ void Device::createTLAS()
   instanceInput.instanceArray.instances    = d_instances;
   instanceInput.instanceArray.numInstances = static_cast<unsigned int>(m_instances.size());
 
+  // The accelUpdate policy option also allows refitting the TLAS when only instance transformations change on a hot reload.
+  m_allowUpdateIAS = (m_accelPolicy.allowUpdate != 0);
+
   OptixAccelBuildOptions accelBuildOptions = {};
 
-  accelBuildOptions.buildFlags = OPTIX_BUILD_FLAG_NONE;
+  accelBuildOptions.buildFlags = (m_allowUpdateIAS) ? OPTIX_BUILD_FLAG_ALLOW_UPDATE : OPTIX_BUILD_FLAG_NONE;
   accelBuildOptions.operation  = OPTIX_BUILD_OPERATION_BUILD;
   
   OptixAccelBufferSizes accelBufferSizes;
 
   OPTIX_CHECK( m_api.optixAccelComputeMemoryUsage(m_optixContext, &accelBuildOptions, &instanceInput, 1, &accelBufferSizes) );
 
-  CU_CHECK( cuMemAlloc(&m_d_ias, accelBufferSizes.outputSizeInBytes) ); // This contains the top-level acceleration structure.
+  m_d_ias = m_bufferCache.alloc(accelBufferSizes.outputSizeInBytes); // This contains the top-level acceleration structure.
 
-  CUdeviceptr d_tmp;
-  
-  CU_CHECK( cuMemAlloc(&d_tmp, accelBufferSizes.tempSizeInBytes) ); // Allocate the temp buffer last to reduce VRAM fragmentation.
+  CUdeviceptr d_tmp = m_bufferCache.alloc(accelBufferSizes.tempSizeInBytes); // Allocate the temp buffer last to reduce VRAM fragmentation.
 
   OPTIX_CHECK( m_api.optixAccelBuild(m_optixContext, m_cudaStream,
                                      &accelBuildOptions, &instanceInput, 1,
@@ -1472,9 +2862,49 @@ void Device::createTLAS()
 
   CU_CHECK( cuStreamSynchronize(m_cudaStream) );
 
-  CU_CHECK( cuMemFree(d_tmp) );
+  m_bufferCache.free(d_tmp);
+
+  m_bufferCache.free(d_instances); // Don't need the instances anymore.
+}
+
+
+// Refit the TLAS in place with the new instance transformations. The instance count and traversables must not have changed.
+void Device::updateTLAS()
+{
+  MY_ASSERT(m_allowUpdateIAS && m_d_ias != 0);
+
+  const size_t instancesSizeInBytes = sizeof(OptixInstance) * m_instances.size();
+
+  CUdeviceptr d_instances = m_bufferCache.alloc(instancesSizeInBytes);
+  CU_CHECK( cuMemcpyHtoDAsync(d_instances, m_instances.data(), instancesSizeInBytes, m_cudaStream) );
+
+  OptixBuildInput instanceInput = {};
+
+  instanceInput.type = OPTIX_BUILD_INPUT_TYPE_INSTANCES;
+  instanceInput.instanceArray.instances    = d_instances;
+  instanceInput.instanceArray.numInstances = static_cast<unsigned int>(m_instances.size());
+
+  OptixAccelBuildOptions accelBuildOptions = {};
+
+  accelBuildOptions.buildFlags = OPTIX_BUILD_FLAG_ALLOW_UPDATE; // Must match the initial build.
+  accelBuildOptions.operation  = OPTIX_BUILD_OPERATION_UPDATE;
+  
+  OptixAccelBufferSizes accelBufferSizes;
+
+  OPTIX_CHECK( m_api.optixAccelComputeMemoryUsage(m_optixContext, &accelBuildOptions, &instanceInput, 1, &accelBufferSizes) );
+
+  CUdeviceptr d_tmp = m_bufferCache.alloc(accelBufferSizes.tempUpdateSizeInBytes);
+
+  OPTIX_CHECK( m_api.optixAccelBuild(m_optixContext, m_cudaStream,
+                                     &accelBuildOptions, &instanceInput, 1,
+                                     d_tmp,   accelBufferSizes.tempUpdateSizeInBytes,
+                                     m_d_ias, accelBufferSizes.outputSizeInBytes,
+                                     &m_systemData.topObject, nullptr, 0));
+
+  CU_CHECK( cuStreamSynchronize(m_cudaStream) );
 
-  CU_CHECK( cuMemFree(d_instances) ); // Don't need the instances anymore.
+  m_bufferCache.free(d_tmp);
+  m_bufferCache.free(d_instances);
 }
 
 
@@ -1512,7 +2942,7 @@ void Device::createHitGroupRecords()
     m_sbtRecordGeometryInstanceData[idx + 1].data.lightIndex    = data.idLight;
   }
 
-  CU_CHECK( cuMemAlloc(reinterpret_cast<CUdeviceptr*>(&m_d_sbtRecordGeometryInstanceData), sizeof(SbtRecordGeometryInstanceData) * NUM_RAYTYPES * numInstances) );
+  m_d_sbtRecordGeometryInstanceData = reinterpret_cast<SbtRecordGeometryInstanceData*>(m_bufferCache.alloc(sizeof(SbtRecordGeometryInstanceData) * NUM_RAYTYPES * numInstances));
   CU_CHECK( cuMemcpyHtoDAsync(reinterpret_cast<CUdeviceptr>(m_d_sbtRecordGeometryInstanceData), m_sbtRecordGeometryInstanceData.data(), sizeof(SbtRecordGeometryInstanceData) * NUM_RAYTYPES * numInstances, m_cudaStream) );
 
   m_sbt.hitgroupRecordBase          = reinterpret_cast<CUdeviceptr>(m_d_sbtRecordGeometryInstanceData);
@@ -31,6 +31,7 @@
 #include "inc/CheckMacros.h"
 
 #include "shaders/compositor_data.h"
+#include "shaders/tile_layout.h"
 
 #include <GL/glew.h>
 #if defined( _WIN32 )
@@ -71,8 +72,8 @@ DeviceMultiGPULocalCopy::~DeviceMultiGPULocalCopy()
 
   if (m_ownsSharedBuffer)
   {
-    CU_CHECK_NO_THROW( cuMemFree(m_systemData.outputBuffer) ); 
-    CU_CHECK_NO_THROW( cuMemFree(m_d_compositorData) );
+    m_bufferCache.free(m_systemData.outputBuffer); 
+    m_bufferCache.free(m_d_compositorData);
   }
 
   CU_CHECK_NO_THROW( cuModuleUnload(m_moduleCompositor) );
@@ -93,6 +94,19 @@ void DeviceMultiGPULocalCopy::setState(DeviceState const& state)
   Device::setState(state); // Call the base class to track the state.
 }
 
+// Number of float4 elements of the launch sized texelBuffer and tileBuffer.
+// The launch width is a multiple of the tile width, the tile ordered layout also pads the height to whole tiles.
+size_t DeviceMultiGPULocalCopy::getTexelCount() const
+{
+  int height = m_systemData.resolution.y;
+
+  if (m_systemData.accumulationLayout == ACCUMULATION_LAYOUT_TILED)
+  {
+    height = tileCount(m_systemData.resolution, m_systemData.tileShift).y << m_systemData.tileShift.y;
+  }
+  return size_t(m_launchWidth) * height;
+}
+
 void DeviceMultiGPULocalCopy::activateContext()
 {
   CU_CHECK( cuCtxSetCurrent(m_cudaContext) ); 
@@ -109,6 +123,8 @@ void DeviceMultiGPULocalCopy::render(const unsigned int iterationIndex, void** b
 
   m_systemData.iterationIndex = iterationIndex;
 
+  updatePipeline(); // Switch to the best available pipeline for the current settings before the launch.
+
   if (m_isDirtyOutputBuffer)
   {
     MY_ASSERT(buffer != nullptr);
@@ -120,16 +136,17 @@ void DeviceMultiGPULocalCopy::render(const unsigned int iterationIndex, void** b
       // These are synchronous.
       // Note that this requires that all other devices have finished accessing this buffer, but that is automatically the case
       // after calling Device::setState() which is the only place which can change the resolution.
-      CU_CHECK( cuMemFree(m_systemData.outputBuffer) );
-      CU_CHECK( cuMemAlloc(&m_systemData.outputBuffer, sizeof(float4) * m_systemData.resolution.x * m_systemData.resolution.y) );
+      m_bufferCache.free(m_systemData.outputBuffer);
+      m_systemData.outputBuffer = m_bufferCache.alloc(sizeof(float4) * m_systemData.resolution.x * m_systemData.resolution.y);
 
       *buffer = reinterpret_cast<void*>(m_systemData.outputBuffer); // Set the pointer, so that other devices don't allocate it. It's not shared!
 
       // This is a temporary buffer on the primary board which is used by the compositor. The texelBuffer needs to stay intact for the accumulation.
-      CU_CHECK( cuMemFree(m_systemData.tileBuffer) );
-      CU_CHECK( cuMemAlloc(&m_systemData.tileBuffer, sizeof(float4) * m_launchWidth * m_systemData.resolution.y) );
+      m_bufferCache.free(m_systemData.tileBuffer);
+      m_systemData.tileBuffer = m_bufferCache.alloc(sizeof(float4) * getTexelCount());
 
-      CU_CHECK( cuMemAlloc(&m_d_compositorData, sizeof(CompositorData)) );
+      m_bufferCache.free(m_d_compositorData);
+      m_d_compositorData = m_bufferCache.alloc(sizeof(CompositorData));
 
       m_ownsSharedBuffer = true; // Indicate which device owns the m_systemData.outputBuffer so that only that frees it again.
 
@@ -161,8 +178,8 @@ void DeviceMultiGPULocalCopy::render(const unsigned int iterationIndex, void** b
       }
     }
     // Allocate a GPU local buffer in the per-device launch size. This is where the accumulation happens.
-    CU_CHECK( cuMemFree(m_systemData.texelBuffer) );
-    CU_CHECK( cuMemAlloc(&m_systemData.texelBuffer, sizeof(float4) * m_launchWidth * m_systemData.resolution.y) );
+    m_bufferCache.free(m_systemData.texelBuffer);
+    m_systemData.texelBuffer = m_bufferCache.alloc(sizeof(float4) * getTexelCount());
 
     m_isDirtyOutputBuffer = false; // Buffer is allocated with new size.
     m_isDirtySystemData   = true;  // Now the sysData on the device needs to be updated, and that needs a sync!
@@ -175,16 +192,13 @@ void DeviceMultiGPULocalCopy::render(const unsigned int iterationIndex, void** b
     CU_CHECK( cuMemcpyHtoDAsync(reinterpret_cast<CUdeviceptr>(m_d_systemData), &m_systemData, sizeof(SystemData), m_cudaStream) );
     m_isDirtySystemData = false;
   }
-  else // Just copy the new iterationIndex.
+  else // launchIteration() uploads the new iterationIndex.
   {
     synchronizeStream();
-
-    // FIXME Then for really asynchronous copies of the iteration indices multiple source pointers are required. Good that I know the number of iterations upfront!
-    CU_CHECK( cuMemcpyHtoDAsync(reinterpret_cast<CUdeviceptr>(&m_d_systemData->iterationIndex), &m_systemData.iterationIndex, sizeof(unsigned int), m_cudaStream) );
   }
 
   // Note the launch width per device to render in tiles.
-  OPTIX_CHECK( m_api.optixLaunch(m_pipeline, m_cudaStream, reinterpret_cast<CUdeviceptr>(m_d_systemData), sizeof(SystemData), &m_sbt, m_launchWidth, m_systemData.resolution.y, /* depth */ 1) );
+  launchIteration(m_launchWidth, m_systemData.resolution.y);
 }
 
 
@@ -283,7 +297,7 @@ void DeviceMultiGPULocalCopy::compositor(Device* other)
     activateContext();
 
     CU_CHECK( cuMemcpyDtoDAsync(m_systemData.tileBuffer, m_systemData.texelBuffer,
-                                sizeof(float4) * m_launchWidth * m_systemData.resolution.y, m_cudaStream) );
+                                sizeof(float4) * getTexelCount(), m_cudaStream) );
   }
   else
   {
@@ -294,7 +308,7 @@ void DeviceMultiGPULocalCopy::compositor(Device* other)
     activateContext();
 
     CU_CHECK( cuMemcpyPeerAsync(m_systemData.tileBuffer, m_cudaContext, other->m_systemData.texelBuffer, other->m_cudaContext,
-                                sizeof(float4) * m_launchWidth * m_systemData.resolution.y, m_cudaStream) );
+                                sizeof(float4) * getTexelCount(), m_cudaStream) );
   }
 
   CompositorData compositorData; // DAR FIXME This needs to be persistent per Device to allow async copies!
@@ -307,6 +321,7 @@ void DeviceMultiGPULocalCopy::compositor(Device* other)
   compositorData.launchWidth  = m_launchWidth;
   compositorData.deviceCount  = m_systemData.deviceCount;
   compositorData.deviceIndex  = other->m_systemData.deviceIndex; // This is the only value which changes per device. 
+  compositorData.accumulationLayout = m_systemData.accumulationLayout;
 
   // Need a synchronous copy here to not overwrite or delete the compositorData above.
   CU_CHECK( cuMemcpyHtoD(m_d_compositorData, &compositorData, sizeof(CompositorData)) );
@@ -65,7 +65,7 @@ DeviceMultiGPUPeerAccess::~DeviceMultiGPUPeerAccess()
 
   if (m_ownsSharedBuffer) // This destruction order requires that all other devices cannot touch this shared buffer anymore.
   {
-    CU_CHECK_NO_THROW( cuMemFree(m_systemData.outputBuffer) ); 
+    m_bufferCache.free(m_systemData.outputBuffer); 
   }
 }
 
@@ -100,6 +100,8 @@ void DeviceMultiGPUPeerAccess::render(const unsigned int iterationIndex, void**
 
   m_systemData.iterationIndex = iterationIndex;
 
+  updatePipeline(); // Switch to the best available pipeline for the current settings before the launch.
+
   if (m_isDirtyOutputBuffer)
   {
     synchronizeStream();
@@ -115,8 +117,8 @@ void DeviceMultiGPUPeerAccess::render(const unsigned int iterationIndex, void**
       // Note that this requires that all other devices have finished accessing this buffer, but that is automatically the case
       // when calling Device::setState() which is the only place which can change the resolution.
       // Peer-to-peer access is not possible on the PBO. We need this staging buffer for rendering.
-      CU_CHECK( cuMemFree(m_systemData.outputBuffer) );
-      CU_CHECK( cuMemAlloc(&m_systemData.outputBuffer, sizeof(float4) * m_systemData.resolution.x * m_systemData.resolution.y) );
+      m_bufferCache.free(m_systemData.outputBuffer);
+      m_systemData.outputBuffer = m_bufferCache.alloc(sizeof(float4) * m_systemData.resolution.x * m_systemData.resolution.y);
 
       *buffer = reinterpret_cast<void*>(m_systemData.outputBuffer); // Make the shared pointer known to the peer devices.
 
@@ -166,16 +168,13 @@ void DeviceMultiGPUPeerAccess::render(const unsigned int iterationIndex, void**
     CU_CHECK( cuMemcpyHtoDAsync(reinterpret_cast<CUdeviceptr>(m_d_systemData), &m_systemData, sizeof(SystemData), m_cudaStream) );
     m_isDirtySystemData = false;
   }
-  else // Just copy the new iterationIndex.
+  else // launchIteration() uploads the new iterationIndex.
   {
     synchronizeStream(); // FIXME For some render strategy "final frame" there should be no synchronizeStream() at all here.
-
-    // DAR FIXME Then for really asynchronous copies of the iteration indices multiple source pointers are required. Good that I know the number of iterations upfront!
-    CU_CHECK( cuMemcpyHtoDAsync(reinterpret_cast<CUdeviceptr>(&m_d_systemData->iterationIndex), &m_systemData.iterationIndex, sizeof(unsigned int), m_cudaStream) );
   }
 
   // Note the launch width per device to render in tiles.
-  OPTIX_CHECK( m_api.optixLaunch(m_pipeline, m_cudaStream, reinterpret_cast<CUdeviceptr>(m_d_systemData), sizeof(SystemData), &m_sbt, m_launchWidth, m_systemData.resolution.y, /* depth */ 1) );
+  launchIteration(m_launchWidth, m_systemData.resolution.y);
 }
 
 
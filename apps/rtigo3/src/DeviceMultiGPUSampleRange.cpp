@@ -0,0 +1,160 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/DeviceMultiGPUSampleRange.h"
+
+#include "inc/CheckMacros.h"
+
+#include <GL/glew.h>
+#if defined( _WIN32 )
+#include <GL/wglew.h>
+#endif
+
+#include <string.h>
+
+// The merged image is built on the host, so this strategy never registers OpenGL resources with CUDA.
+DeviceMultiGPUSampleRange::DeviceMultiGPUSampleRange(const RendererStrategy strategy,
+                                                     const int ordinal,
+                                                     const int index,
+                                                     const int count,
+                                                     const int miss,
+                                                     const int /* interop */,
+                                                     const unsigned int tex,
+                                                     const unsigned int pbo)
+: Device(strategy, ordinal, 0, 1, miss, INTEROP_MODE_OFF, tex, pbo) // Full frame rendering like a single GPU.
+, m_rangeIndex(index)
+, m_rangeCount(count)
+{
+  m_range.begin = 0;
+  m_range.end   = 0;
+}
+
+DeviceMultiGPUSampleRange::~DeviceMultiGPUSampleRange()
+{
+  CU_CHECK_NO_THROW( cuCtxSetCurrent(m_cudaContext) );
+  CU_CHECK_NO_THROW( cuCtxSynchronize() );
+
+  m_bufferCache.free(m_systemData.outputBuffer); 
+}
+
+void DeviceMultiGPUSampleRange::setState(DeviceState const& state)
+{
+  const unsigned int samplesPerPixel = static_cast<unsigned int>(state.samplesSqrt * state.samplesSqrt);
+
+  m_range = ::getSampleRange(samplesPerPixel, m_rangeCount, m_rangeIndex);
+
+  if (m_systemData.sampleOffset != static_cast<int>(m_range.begin))
+  {
+    m_systemData.sampleOffset = static_cast<int>(m_range.begin);
+    m_isDirtySystemData = true;
+  }
+
+  Device::setState(state); // Call the base class to track the state.
+}
+
+void DeviceMultiGPUSampleRange::activateContext()
+{
+  CU_CHECK( cuCtxSetCurrent(m_cudaContext) ); 
+}
+
+void DeviceMultiGPUSampleRange::synchronizeStream()
+{
+  CU_CHECK( cuStreamSynchronize(m_cudaStream) );
+}
+
+void DeviceMultiGPUSampleRange::render(const unsigned int iterationIndex, void** /* buffer */)
+{
+  activateContext();
+
+  // The raytracer only calls this while the device has samples left in its range.
+  MY_ASSERT(iterationIndex < m_range.end - m_range.begin);
+
+  m_systemData.iterationIndex = iterationIndex;
+
+  updatePipeline(); // Switch to the best available pipeline for the current settings before the launch.
+
+  if (m_isDirtyOutputBuffer)
+  {
+    m_bufferHost.resize(m_systemData.resolution.x * m_systemData.resolution.y);
+
+    // Every device accumulates the full resolution in GPU local memory.
+    m_bufferCache.free(m_systemData.outputBuffer);
+    m_systemData.outputBuffer = m_bufferCache.alloc(sizeof(float4) * m_systemData.resolution.x * m_systemData.resolution.y);
+
+    m_isDirtyOutputBuffer = false; // Buffer is allocated with new size.
+    m_isDirtySystemData   = true;  // Now the sysData on the device needs to be updated, and that needs a sync!
+  }
+
+  if (m_isDirtySystemData) // Update the whole SystemData block because more than the iterationIndex changed. This normally means a GUI interaction. Just sync.
+  {
+    synchronizeStream();
+
+    CU_CHECK( cuMemcpyHtoDAsync(reinterpret_cast<CUdeviceptr>(m_d_systemData), &m_systemData, sizeof(SystemData), m_cudaStream) );
+    m_isDirtySystemData = false;
+  }
+  else // launchIteration() uploads the new iterationIndex.
+  {
+    synchronizeStream();
+  }
+
+  launchIteration(m_systemData.resolution.x, m_systemData.resolution.y);
+}
+
+// A single device range is the whole image.
+void DeviceMultiGPUSampleRange::updateDisplayTexture()
+{
+  updateDisplayTexture(reinterpret_cast<const float4*>(getOutputBufferHost()));
+}
+
+void DeviceMultiGPUSampleRange::updateDisplayTexture(const float4* data)
+{
+  MY_ASSERT(m_tex != 0);
+
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, m_tex);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, (GLsizei) m_systemData.resolution.x, (GLsizei) m_systemData.resolution.y, 0, GL_RGBA, GL_FLOAT, data); // RGBA32F from host buffer data.
+}
+
+// The accumulation of this device only. RaytracerMultiGPUSampleRange merges these.
+const void* DeviceMultiGPUSampleRange::getOutputBufferHost()
+{
+  activateContext();
+
+  MY_ASSERT(!m_isDirtyOutputBuffer);
+
+  CU_CHECK( cuMemcpyDtoHAsync(m_bufferHost.data(), m_systemData.outputBuffer, sizeof(float4) * m_systemData.resolution.x * m_systemData.resolution.y, m_cudaStream) );
+
+  synchronizeStream(); // Wait for the buffer to arrive on the host.
+
+  return m_bufferHost.data();
+}
+
+SampleRange DeviceMultiGPUSampleRange::getSampleRange() const
+{
+  return m_range;
+}
@@ -29,6 +29,9 @@
 #include "inc/DeviceMultiGPUZeroCopy.h"
 
 #include "inc/CheckMacros.h"
+#include "inc/TileLayout.h"
+
+#include "shaders/tile_layout.h"
 
 #include <GL/glew.h>
 #if defined( _WIN32 )
@@ -95,14 +98,26 @@ void DeviceMultiGPUZeroCopy::render(const unsigned int iterationIndex, void** bu
 
   m_systemData.iterationIndex = iterationIndex;
 
+  updatePipeline(); // Switch to the best available pipeline for the current settings before the launch.
+
   if (m_isDirtyOutputBuffer)
   {
     MY_ASSERT(buffer != nullptr);
     if (*buffer == nullptr) // The first device called handles the reallocation of the shared pinned memory buffer.
     {
+      // The tile ordered accumulation is padded to whole tiles and detiled into the host buffer on the way to the display or the caller.
+      size_t numElements = m_systemData.resolution.x * m_systemData.resolution.y;
+
+      m_bufferHost.clear();
+      if (m_systemData.accumulationLayout == ACCUMULATION_LAYOUT_TILED)
+      {
+        m_bufferHost.resize(numElements);
+        numElements = getTiledBufferSize(m_systemData.resolution, m_systemData.tileSize);
+      }
+
       // Allocate zero-copy pinned memory on the host.
       CU_CHECK( cuMemFreeHost(reinterpret_cast<void*>(m_systemData.outputBuffer)) );
-      CU_CHECK( cuMemHostAlloc(reinterpret_cast<void**>(&m_systemData.outputBuffer), sizeof(float4) * m_systemData.resolution.x * m_systemData.resolution.y, CU_MEMHOSTALLOC_PORTABLE | CU_MEMHOSTALLOC_DEVICEMAP) );
+      CU_CHECK( cuMemHostAlloc(reinterpret_cast<void**>(&m_systemData.outputBuffer), sizeof(float4) * numElements, CU_MEMHOSTALLOC_PORTABLE | CU_MEMHOSTALLOC_DEVICEMAP) );
       
       *buffer = reinterpret_cast<void*>(m_systemData.outputBuffer); // Fill the shared buffer pointer.
 
@@ -127,31 +142,26 @@ void DeviceMultiGPUZeroCopy::render(const unsigned int iterationIndex, void** bu
     CU_CHECK( cuMemcpyHtoDAsync(reinterpret_cast<CUdeviceptr>(m_d_systemData), &m_systemData, sizeof(SystemData), m_cudaStream) );
     m_isDirtySystemData = false;
   }
-  else // Just copy the new iterationIndex.
+  else // launchIteration() uploads the new iterationIndex.
   {
     synchronizeStream(); // FIXME For some render strategy "final frame" there should be no synchronizeStream() at all here.
-
-    // FIXME Then for really asynchronous copies of the iteration indices multiple source pointers are required. Good that I know the number of iterations upfront!
-    CU_CHECK( cuMemcpyHtoDAsync(reinterpret_cast<CUdeviceptr>(&m_d_systemData->iterationIndex), &m_systemData.iterationIndex, sizeof(unsigned int), m_cudaStream) );
   }
 
   // Note the launch width per device to render in tiles.
-  OPTIX_CHECK( m_api.optixLaunch(m_pipeline, m_cudaStream, reinterpret_cast<CUdeviceptr>(m_d_systemData), sizeof(SystemData), &m_sbt, m_launchWidth, m_systemData.resolution.y, /* depth */ 1) );
+  launchIteration(m_launchWidth, m_systemData.resolution.y);
 }
 
 void DeviceMultiGPUZeroCopy::updateDisplayTexture()
 {
-  // All other devices have been synced by the RaytracerMultiGPUZeroCopy caller.
-  activateContext();
-  synchronizeStream(); // Wait for the buffer to arrive on the host. 
-  
-  MY_ASSERT(!m_isDirtyOutputBuffer && m_ownsSharedBuffer && m_tex != 0);
+  MY_ASSERT(m_tex != 0);
+
+  const void* data = getOutputBufferHost(); // Waits for the buffer on the host and detiles the tile ordered layout.
 
   glActiveTexture(GL_TEXTURE0);
   glBindTexture(GL_TEXTURE_2D, m_tex);
 
   // RGBA32F from shared pinned memory host buffer data.
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, (GLsizei) m_systemData.resolution.x, (GLsizei) m_systemData.resolution.y, 0, GL_RGBA, GL_FLOAT, reinterpret_cast<GLvoid*>(m_systemData.outputBuffer));
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, (GLsizei) m_systemData.resolution.x, (GLsizei) m_systemData.resolution.y, 0, GL_RGBA, GL_FLOAT, data);
 }
 
 const void* DeviceMultiGPUZeroCopy::getOutputBufferHost()
@@ -162,5 +172,12 @@ const void* DeviceMultiGPUZeroCopy::getOutputBufferHost()
 
   MY_ASSERT(!m_isDirtyOutputBuffer && m_ownsSharedBuffer);
 
+  if (m_systemData.accumulationLayout == ACCUMULATION_LAYOUT_TILED)
+  {
+    detileHost(m_bufferHost.data(), reinterpret_cast<const float4*>(m_systemData.outputBuffer), m_systemData.resolution, m_systemData.tileSize);
+
+    return m_bufferHost.data();
+  }
+
   return reinterpret_cast<void*>(m_systemData.outputBuffer); // This buffer is in pinned memory on the host. Just return it.
 }
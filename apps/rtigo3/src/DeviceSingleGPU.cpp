@@ -74,10 +74,10 @@ DeviceSingleGPU::~DeviceSingleGPU()
   switch (m_interop)
   {
     case INTEROP_MODE_OFF:
-      CU_CHECK_NO_THROW( cuMemFree(m_systemData.outputBuffer) ); 
+      m_bufferCache.free(m_systemData.outputBuffer); 
       break;
     case INTEROP_MODE_TEX:
-      CU_CHECK_NO_THROW( cuMemFree(m_systemData.outputBuffer) ); 
+      m_bufferCache.free(m_systemData.outputBuffer); 
       CU_CHECK_NO_THROW( cuGraphicsUnregisterResource(m_cudaGraphicsResource) );
       break;
     case INTEROP_MODE_PBO:
@@ -104,6 +104,8 @@ void DeviceSingleGPU::render(const unsigned int iterationIndex, void** /* buffer
 
   m_systemData.iterationIndex = iterationIndex;
 
+  updatePipeline(); // Switch to the best available pipeline for the current settings before the launch.
+
   if (m_isDirtyOutputBuffer)
   {
     // Required for getOutputBufferHost() which is still called in the screenshot() function.
@@ -112,13 +114,13 @@ void DeviceSingleGPU::render(const unsigned int iterationIndex, void** /* buffer
     switch (m_interop)
     {
       case INTEROP_MODE_OFF:
-        CU_CHECK( cuMemFree(m_systemData.outputBuffer) );
-        CU_CHECK( cuMemAlloc(reinterpret_cast<CUdeviceptr*>(&m_systemData.outputBuffer), sizeof(float4) * m_systemData.resolution.x * m_systemData.resolution.y) );
+        m_bufferCache.free(m_systemData.outputBuffer);
+        m_systemData.outputBuffer = m_bufferCache.alloc(sizeof(float4) * m_systemData.resolution.x * m_systemData.resolution.y);
         break;
 
       case INTEROP_MODE_TEX:
-        CU_CHECK( cuMemFree(m_systemData.outputBuffer) );
-        CU_CHECK( cuMemAlloc(reinterpret_cast<CUdeviceptr*>(&m_systemData.outputBuffer), sizeof(float4) * m_systemData.resolution.x * m_systemData.resolution.y) );
+        m_bufferCache.free(m_systemData.outputBuffer);
+        m_systemData.outputBuffer = m_bufferCache.alloc(sizeof(float4) * m_systemData.resolution.x * m_systemData.resolution.y);
         // Resize the target texture as well for the cuMemcpy3D.
         CU_CHECK( cuGraphicsUnregisterResource(m_cudaGraphicsResource) );
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, (GLsizei) m_systemData.resolution.x, (GLsizei) m_systemData.resolution.y, 0, GL_RGBA, GL_FLOAT, (GLvoid*) m_bufferHost.data()); // RGBA32F
@@ -146,19 +148,16 @@ void DeviceSingleGPU::render(const unsigned int iterationIndex, void** /* buffer
     CU_CHECK( cuMemcpyHtoDAsync(reinterpret_cast<CUdeviceptr>(m_d_systemData), &m_systemData, sizeof(SystemData), m_cudaStream) );
     m_isDirtySystemData = false;
   }
-  else // Just copy the new iterationIndex.
+  else // launchIteration() uploads the new iterationIndex.
   {
     synchronizeStream(); // FIXME For some render strategy "final frame" there should be no synchronizeStream() at all here.
-
-    // FIXME Then for really asynchronous copies of the iteration indices multiple source pointers are required. Good that I know the number of iterations upfront!
-    CU_CHECK( cuMemcpyHtoDAsync(reinterpret_cast<CUdeviceptr>(&m_d_systemData->iterationIndex), &m_systemData.iterationIndex, sizeof(unsigned int), m_cudaStream) );
   }
 
   switch (m_interop)
   {
     case INTEROP_MODE_OFF:
     case INTEROP_MODE_TEX:
-      OPTIX_CHECK( m_api.optixLaunch(m_pipeline, m_cudaStream, reinterpret_cast<CUdeviceptr>(m_d_systemData), sizeof(SystemData), &m_sbt, m_systemData.resolution.x, m_systemData.resolution.y, /* depth */ 1) );
+      launchIteration(m_systemData.resolution.x, m_systemData.resolution.y);
       break;
 
     case INTEROP_MODE_PBO: // Rendering directly into the PBO.
@@ -170,7 +169,7 @@ void DeviceSingleGPU::render(const unsigned int iterationIndex, void** /* buffer
         CU_CHECK( cuGraphicsResourceGetMappedPointer(&m_systemData.outputBuffer, &size, m_cudaGraphicsResource) ); // The pointer can change on every map!
         CU_CHECK( cuMemcpyHtoDAsync(reinterpret_cast<CUdeviceptr>(&m_d_systemData->outputBuffer), &m_systemData.outputBuffer, sizeof(void*), m_cudaStream) ); // This will render directly into the PBO.
 
-        OPTIX_CHECK( m_api.optixLaunch(m_pipeline, m_cudaStream, reinterpret_cast<CUdeviceptr>(m_d_systemData), sizeof(SystemData), &m_sbt, m_systemData.resolution.x, m_systemData.resolution.y, /* depth */ 1) );
+        launchIteration(m_systemData.resolution.x, m_systemData.resolution.y);
       
         CU_CHECK( cuGraphicsUnmapResources(1, &m_cudaGraphicsResource, m_cudaStream) ); // This is an implicit cuSynchronizeStream().
       }
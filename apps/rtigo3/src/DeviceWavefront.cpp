@@ -0,0 +1,309 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/DeviceWavefront.h"
+
+#include "inc/CheckMacros.h"
+#include "inc/WavefrontQueue.h"
+
+#include "shaders/per_ray_data.h"
+
+#include <iostream>
+#include <string.h>
+#include <vector>
+
+
+// Suballocations inside the single wavefront buffer start at this alignment.
+static size_t alignWavefront(const size_t offset)
+{
+  return (offset + 255) & ~static_cast<size_t>(255);
+}
+
+
+DeviceWavefront::DeviceWavefront(const RendererStrategy strategy,
+                                 const int ordinal,
+                                 const int index,
+                                 const int count,
+                                 const int miss,
+                                 const int interop,
+                                 const unsigned int tex,
+                                 const unsigned int pbo)
+: DeviceSingleGPU(strategy, ordinal, index, count, miss, interop, tex, pbo)
+, m_useWavefront(true)
+, m_wavefrontCapacity(0)
+, m_d_wavefrontBuffer(0)
+, m_d_wavefront(nullptr)
+{
+  memset(&m_wavefront, 0, sizeof(WavefrontData));
+
+  CU_CHECK( cuModuleLoad(&m_moduleWavefront, "./rtigo3_core/wavefront.ptx") );
+  CU_CHECK( cuModuleGetFunction(&m_functionReset,     m_moduleWavefront, "wavefront_reset") );
+  CU_CHECK( cuModuleGetFunction(&m_functionHistogram, m_moduleWavefront, "wavefront_histogram") );
+  CU_CHECK( cuModuleGetFunction(&m_functionOffsets,   m_moduleWavefront, "wavefront_offsets") );
+  CU_CHECK( cuModuleGetFunction(&m_functionScatter,   m_moduleWavefront, "wavefront_scatter") );
+  CU_CHECK( cuModuleGetFunction(&m_functionAdvance,   m_moduleWavefront, "wavefront_advance") );
+
+  CU_CHECK( cuMemAlloc(reinterpret_cast<CUdeviceptr*>(&m_d_wavefront), sizeof(WavefrontData)) );
+}
+
+DeviceWavefront::~DeviceWavefront()
+{
+  CU_CHECK_NO_THROW( cuCtxSynchronize() );
+
+  m_bufferCache.free(m_d_wavefrontBuffer);
+  CU_CHECK_NO_THROW( cuMemFree(reinterpret_cast<CUdeviceptr>(m_d_wavefront)) );
+  CU_CHECK_NO_THROW( cuModuleUnload(m_moduleWavefront) );
+}
+
+
+void DeviceWavefront::setState(DeviceState const& state)
+{
+  // The number of bounce launches is baked into the captured iteration graph.
+  if (m_systemData.pathLengths.y != state.pathLengths.y)
+  {
+    m_isDirtyGraph = true;
+  }
+
+  Device::setState(state);
+}
+
+void DeviceWavefront::setWavefront(const bool enable)
+{
+  if (m_useWavefront != enable)
+  {
+    m_useWavefront = enable;
+    m_isDirtyGraph = true;
+  }
+}
+
+unsigned long long DeviceWavefront::getRayCount()
+{
+  if (m_wavefrontCapacity == 0)
+  {
+    return 0;
+  }
+
+  synchronizeStream();
+
+  unsigned long long traced = 0;
+
+  CU_CHECK( cuMemcpyDtoH(&traced, reinterpret_cast<CUdeviceptr>(&m_wavefront.counters->traced), sizeof(unsigned long long)) );
+
+  return traced;
+}
+
+void DeviceWavefront::render(const unsigned int iterationIndex, void** buffer)
+{
+  updateWavefrontBuffers();
+
+  DeviceSingleGPU::render(iterationIndex, buffer);
+}
+
+
+void DeviceWavefront::updateWavefrontBuffers()
+{
+  const unsigned int capacity = m_systemData.resolution.x * m_systemData.resolution.y;
+
+  if (m_wavefrontCapacity == capacity)
+  {
+    return;
+  }
+
+  synchronizeStream();
+
+  // Carve all arrays out of one allocation. There are no queue arrays for partial sizes,
+  // every queue can hold all paths because all launches are sized to the capacity.
+  size_t offsets[14];
+  size_t size = 0;
+
+  const size_t sizes[14] =
+  {
+    sizeof(float4) * capacity,                       // position
+    sizeof(float4) * capacity,                       // direction
+    sizeof(float4) * capacity,                       // throughput
+    sizeof(float4) * capacity,                       // radiance
+    sizeof(float4) * capacity * MATERIAL_STACK_SIZE, // absorptionStack
+    sizeof(int) * capacity,                          // stackIndex
+    sizeof(unsigned int) * capacity,                 // flags
+    sizeof(unsigned int) * capacity,                 // seed
+    sizeof(unsigned int) * capacity,                 // rayQueue[0]
+    sizeof(unsigned int) * capacity,                 // rayQueue[1]
+    sizeof(WavefrontHit) * capacity,                 // hits
+    sizeof(unsigned int) * capacity * 2,             // hitKeys, sortedQueue
+    sizeof(WavefrontShadowRay) * capacity,           // shadowQueue
+    sizeof(WavefrontCounters)                        // counters
+  };
+
+  for (int i = 0; i < 14; ++i)
+  {
+    offsets[i] = size;
+    size = alignWavefront(size + sizes[i]);
+  }
+
+  m_bufferCache.free(m_d_wavefrontBuffer);
+  m_d_wavefrontBuffer = 0;
+  m_wavefrontCapacity = 0;
+
+  m_d_wavefrontBuffer = m_bufferCache.alloc(size);
+  CU_CHECK( cuMemsetD8(m_d_wavefrontBuffer + offsets[13], 0, sizeof(WavefrontCounters)) ); // The traced ray count is only reset here.
+
+  char* base = reinterpret_cast<char*>(m_d_wavefrontBuffer);
+
+  m_wavefront.position        = reinterpret_cast<float4*>(base + offsets[0]);
+  m_wavefront.direction       = reinterpret_cast<float4*>(base + offsets[1]);
+  m_wavefront.throughput      = reinterpret_cast<float4*>(base + offsets[2]);
+  m_wavefront.radiance        = reinterpret_cast<float4*>(base + offsets[3]);
+  m_wavefront.absorptionStack = reinterpret_cast<float4*>(base + offsets[4]);
+  m_wavefront.stackIndex      = reinterpret_cast<int*>(base + offsets[5]);
+  m_wavefront.flags           = reinterpret_cast<unsigned int*>(base + offsets[6]);
+  m_wavefront.seed            = reinterpret_cast<unsigned int*>(base + offsets[7]);
+  m_wavefront.rayQueue[0]     = reinterpret_cast<unsigned int*>(base + offsets[8]);
+  m_wavefront.rayQueue[1]     = reinterpret_cast<unsigned int*>(base + offsets[9]);
+  m_wavefront.hits            = reinterpret_cast<WavefrontHit*>(base + offsets[10]);
+  m_wavefront.hitKeys         = reinterpret_cast<unsigned int*>(base + offsets[11]);
+  m_wavefront.sortedQueue     = m_wavefront.hitKeys + capacity;
+  m_wavefront.shadowQueue     = reinterpret_cast<WavefrontShadowRay*>(base + offsets[12]);
+  m_wavefront.counters        = reinterpret_cast<WavefrontCounters*>(base + offsets[13]);
+  m_wavefront.capacity        = capacity;
+
+  CU_CHECK( cuMemcpyHtoD(reinterpret_cast<CUdeviceptr>(m_d_wavefront), &m_wavefront, sizeof(WavefrontData)) );
+
+  m_wavefrontCapacity = capacity;
+
+  m_systemData.wavefront = m_d_wavefront; // The pointer never changes, but the sysData on the device still needs it once.
+
+  m_isDirtySystemData = true;
+  m_isDirtyGraph      = true; // The launch sizes of the bounce steps changed.
+}
+
+
+void DeviceWavefront::launchKernel(CUfunction function, const unsigned int numBlocks, const unsigned int numThreads)
+{
+  void* args[1] = { &m_d_wavefront };
+
+  CU_CHECK( cuLaunchKernel(function,        // CUfunction f,
+                           numBlocks,       // unsigned int gridDimX,
+                           1,               // unsigned int gridDimY,
+                           1,               // unsigned int gridDimZ,
+                           numThreads,      // unsigned int blockDimX,
+                           1,               // unsigned int blockDimY,
+                           1,               // unsigned int blockDimZ,
+                           0,               // unsigned int sharedMemBytes,
+                           m_cudaStream,    // CUstream hStream,
+                           args,            // void **kernelParams,
+                           nullptr) );      // void **extra
+}
+
+void DeviceWavefront::launchProgram(const int id, const unsigned int width, const unsigned int height)
+{
+  // Same SBT with a different raygeneration record. The program group headers are in the PGID order.
+  OptixShaderBindingTable sbt = m_sbt;
+
+  sbt.raygenRecord = m_d_sbtRecordHeaders + sizeof(SbtRecordHeader) * id;
+
+  OPTIX_CHECK( m_api.optixLaunch(m_pipeline, m_cudaStream, reinterpret_cast<CUdeviceptr>(m_d_systemData), sizeof(SystemData), &sbt, width, height, /* depth */ 1) );
+}
+
+void DeviceWavefront::launch(const unsigned int width, const unsigned int height)
+{
+  if (!m_useWavefront)
+  {
+    Device::launch(width, height);
+    return;
+  }
+
+  MY_ASSERT(m_systemData.numViews == 0 && m_wavefrontCapacity == width * height);
+
+  // PERF There is no host synchronization between the bounces.
+  // All launches are sized to the capacity and the programs and kernels return early for slots beyond the current queue sizes.
+  // That keeps the whole sequence capturable in the iteration graph.
+  const unsigned int numBlocks = (m_wavefrontCapacity + WAVEFRONT_BLOCK_SIZE - 1) / WAVEFRONT_BLOCK_SIZE;
+
+  launchKernel(m_functionReset, 1, 1);
+  launchProgram(PGID_WAVEFRONT_GENERATE, width, height);
+
+  for (int depth = 0; depth < m_systemData.pathLengths.y; ++depth)
+  {
+    launchProgram(PGID_WAVEFRONT_TRACE, m_wavefrontCapacity, 1);
+
+    launchKernel(m_functionHistogram, numBlocks, WAVEFRONT_BLOCK_SIZE);
+    launchKernel(m_functionOffsets,   1,         1);
+    launchKernel(m_functionScatter,   numBlocks, WAVEFRONT_BLOCK_SIZE);
+
+#if USE_DEBUG_EXCEPTIONS
+    if (depth == 0)
+    {
+      validateQueues();
+    }
+#endif
+
+    launchProgram(PGID_WAVEFRONT_SHADE,  m_wavefrontCapacity, 1);
+    launchProgram(PGID_WAVEFRONT_SHADOW, m_wavefrontCapacity, 1);
+
+    launchKernel(m_functionAdvance, 1, 1);
+  }
+
+  launchProgram(PGID_WAVEFRONT_RESOLVE, width, height);
+}
+
+// Compares the sorted queue of the current bounce against the keys. Debug only, this synchronizes.
+void DeviceWavefront::validateQueues()
+{
+  CUstreamCaptureStatus status = CU_STREAM_CAPTURE_STATUS_NONE;
+
+  CU_CHECK( cuStreamIsCapturing(m_cudaStream, &status) );
+  if (status != CU_STREAM_CAPTURE_STATUS_NONE)
+  {
+    return; // Nothing has been executed while capturing. The direct launches of the next iteration check the queues.
+  }
+
+  synchronizeStream();
+
+  WavefrontCounters counters;
+
+  CU_CHECK( cuMemcpyDtoH(&counters, reinterpret_cast<CUdeviceptr>(m_wavefront.counters), sizeof(WavefrontCounters)) );
+
+  const unsigned int count = counters.rays[counters.parity];
+
+  std::vector<unsigned int> keys(count);
+  std::vector<unsigned int> sortedQueue(counters.hits);
+
+  if (count != 0)
+  {
+    CU_CHECK( cuMemcpyDtoH(keys.data(), reinterpret_cast<CUdeviceptr>(m_wavefront.hitKeys), sizeof(unsigned int) * count) );
+  }
+  if (counters.hits != 0)
+  {
+    CU_CHECK( cuMemcpyDtoH(sortedQueue.data(), reinterpret_cast<CUdeviceptr>(m_wavefront.sortedQueue), sizeof(unsigned int) * counters.hits) );
+  }
+
+  if (!isSortedWavefrontQueue(keys.data(), count, sortedQueue.data(), counters.hits))
+  {
+    std::cerr << "ERROR: validateQueues() wavefront queue of " << count << " rays is not sorted by BSDF.\n";
+  }
+}
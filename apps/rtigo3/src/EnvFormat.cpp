@@ -0,0 +1,277 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/EnvFormat.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && 2 <= _M_IX86_FP)
+#define USE_ENV_SSE 1
+#include <emmintrin.h>
+#else
+#define USE_ENV_SSE 0
+#endif
+
+
+static const unsigned int HALF_MAX_INPUT   = 0x477FEFFF; // Largest float which rounds to 65504.0f.
+static const unsigned int HALF_MIN_NORMAL  = 0x38800000; // 2^-14, smaller values are half denormals.
+static const unsigned int HALF_DENORM_BIAS = 0x3F000000; // 0.5f, aligns the denormal mantissa so that the FPU does the rounding.
+
+
+size_t getEnvFormatElementSize(const int format)
+{
+  switch (format)
+  {
+    case ENV_FORMAT_RGBA32F:
+      return 16;
+    case ENV_FORMAT_RGBA16F:
+      return 8;
+    case ENV_FORMAT_RGB9E5:
+      return 4;
+  }
+  return 0;
+}
+
+
+const char* getEnvFormatName(const int format)
+{
+  static const char* names[NUM_ENV_FORMATS] =
+  {
+    "RGBA32F",
+    "RGBA16F",
+    "RGB9E5"
+  };
+
+  return (0 <= format && format < NUM_ENV_FORMATS) ? names[format] : "";
+}
+
+
+unsigned short floatToHalf(const float f)
+{
+  unsigned int bits;
+  memcpy(&bits, &f, sizeof(float));
+
+  const unsigned int sign = (bits >> 16) & 0x8000;
+  const unsigned int a    = bits & 0x7FFFFFFF;
+
+  unsigned int h;
+
+  if (0x7F800000 < a) // NaN
+  {
+    h = 0x7E00;
+  }
+  else if (HALF_MAX_INPUT < a) // Includes infinity.
+  {
+    h = 0x7BFF;
+  }
+  else if (a < HALF_MIN_NORMAL)
+  {
+    float denorm;
+    memcpy(&denorm, &a, sizeof(float));
+    denorm += 0.5f;
+
+    unsigned int denormBits;
+    memcpy(&denormBits, &denorm, sizeof(float));
+    h = denormBits - HALF_DENORM_BIAS;
+  }
+  else
+  {
+    // Rebias the exponent and round the 13 dropped mantissa bits to nearest even.
+    h = (a + 0xC8000FFF + ((a >> 13) & 1)) >> 13;
+  }
+
+  return static_cast<unsigned short>(h | sign);
+}
+
+
+// The scale 2^-(exponent - bias - mantissa bits) to get the 9 bit mantissas from the linear values. Always a normal float.
+static float getRGB9E5Scale(const int exponentShared)
+{
+  const unsigned int bits = static_cast<unsigned int>(127 + RGB9E5_EXPONENT_BIAS + RGB9E5_MANTISSA_BITS - exponentShared) << 23;
+
+  float scale;
+  memcpy(&scale, &bits, sizeof(float));
+  return scale;
+}
+
+unsigned int encodeRGB9E5(const float r, const float g, const float b)
+{
+  // The comparisons map NaN to zero.
+  const float rc = (0.0f < r) ? std::min(r, RGB9E5_MAX_VALUE) : 0.0f;
+  const float gc = (0.0f < g) ? std::min(g, RGB9E5_MAX_VALUE) : 0.0f;
+  const float bc = (0.0f < b) ? std::min(b, RGB9E5_MAX_VALUE) : 0.0f;
+
+  const float maxRGB = std::max(rc, std::max(gc, bc));
+
+  unsigned int bits;
+  memcpy(&bits, &maxRGB, sizeof(float));
+
+  // floor(log2(maxRGB)) from the exponent bits. Zero and denormals give -127 which is clamped to the smallest shared exponent.
+  const int exponent = std::max(-RGB9E5_EXPONENT_BIAS - 1, int(bits >> 23) - 127);
+
+  int   exponentShared = exponent + 1 + RGB9E5_EXPONENT_BIAS;
+  float scale          = getRGB9E5Scale(exponentShared);
+
+  if (int(maxRGB * scale + 0.5f) == (1 << RGB9E5_MANTISSA_BITS)) // Rounding overflowed the mantissa.
+  {
+    ++exponentShared;
+    scale *= 0.5f;
+  }
+
+  const unsigned int rm = static_cast<unsigned int>(rc * scale + 0.5f);
+  const unsigned int gm = static_cast<unsigned int>(gc * scale + 0.5f);
+  const unsigned int bm = static_cast<unsigned int>(bc * scale + 0.5f);
+
+  return rm | (gm << 9) | (bm << 18) | (static_cast<unsigned int>(exponentShared) << 27);
+}
+
+
+#if USE_ENV_SSE
+
+static __m128i select(const __m128i mask, const __m128i a, const __m128i b)
+{
+  return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// Same operations as floatToHalf() on the four floats. Returns the halfs in the lower 16 bits of each 32 bit lane.
+static __m128i floatToHalf4(const __m128 f)
+{
+  const __m128i bits = _mm_castps_si128(f);
+
+  const __m128i sign = _mm_and_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(0x8000));
+  const __m128i a    = _mm_and_si128(bits, _mm_set1_epi32(0x7FFFFFFF));
+
+  const __m128i odd    = _mm_and_si128(_mm_srli_epi32(a, 13), _mm_set1_epi32(1));
+  const __m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(a, _mm_set1_epi32(int(0xC8000FFF))), odd), 13);
+
+  const __m128i denorm = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(a), _mm_set1_ps(0.5f))), _mm_set1_epi32(HALF_DENORM_BIAS));
+
+  // Signed comparisons are fine, a has no sign bit.
+  __m128i h = select(_mm_cmplt_epi32(a, _mm_set1_epi32(HALF_MIN_NORMAL)), denorm, normal);
+  h = select(_mm_cmpgt_epi32(a, _mm_set1_epi32(HALF_MAX_INPUT)), _mm_set1_epi32(0x7BFF), h);
+  h = select(_mm_cmpgt_epi32(a, _mm_set1_epi32(0x7F800000)),     _mm_set1_epi32(0x7E00), h);
+
+  return _mm_or_si128(h, sign);
+}
+
+// SSE2 has no unsigned saturation from 32 to 16 bits. Sign extending the lower 16 bits makes the signed pack exact.
+static __m128i packHalf8(const __m128i lo, const __m128i hi)
+{
+  return _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(lo, 16), 16), _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16));
+}
+
+static __m128 getRGB9E5Scale4(const __m128i exponentShared)
+{
+  return _mm_castsi128_ps(_mm_slli_epi32(_mm_sub_epi32(_mm_set1_epi32(127 + RGB9E5_EXPONENT_BIAS + RGB9E5_MANTISSA_BITS), exponentShared), 23));
+}
+
+static __m128i roundMantissa4(const __m128 c, const __m128 scale)
+{
+  return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(c, scale), _mm_set1_ps(0.5f)));
+}
+
+#endif // USE_ENV_SSE
+
+
+void convertToRGBA16F(unsigned short* dst, const float* rgba, const size_t count)
+{
+  size_t i = 0;
+
+#if USE_ENV_SSE
+  for (; i + 2 <= count; i += 2) // Two RGBA texels per iteration fill one 128 bit store.
+  {
+    const __m128i lo = floatToHalf4(_mm_loadu_ps(rgba + i * 4));
+    const __m128i hi = floatToHalf4(_mm_loadu_ps(rgba + i * 4 + 4));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), packHalf8(lo, hi));
+  }
+#endif
+
+  for (; i < count; ++i)
+  {
+    for (size_t c = 0; c < 4; ++c)
+    {
+      dst[i * 4 + c] = floatToHalf(rgba[i * 4 + c]);
+    }
+  }
+}
+
+
+void convertToRGB9E5(unsigned int* dst, const float* rgba, const size_t count)
+{
+  size_t i = 0;
+
+#if USE_ENV_SSE
+  const __m128 zero     = _mm_setzero_ps();
+  const __m128 maxValue = _mm_set1_ps(RGB9E5_MAX_VALUE);
+
+  for (; i + 4 <= count; i += 4) // Four texels per iteration, transposed to RGB component vectors.
+  {
+    __m128 r = _mm_loadu_ps(rgba + i * 4);
+    __m128 g = _mm_loadu_ps(rgba + i * 4 + 4);
+    __m128 b = _mm_loadu_ps(rgba + i * 4 + 8);
+    __m128 a = _mm_loadu_ps(rgba + i * 4 + 12);
+
+    _MM_TRANSPOSE4_PS(r, g, b, a);
+
+    // maxps returns the second operand when the first is NaN.
+    r = _mm_min_ps(_mm_max_ps(r, zero), maxValue);
+    g = _mm_min_ps(_mm_max_ps(g, zero), maxValue);
+    b = _mm_min_ps(_mm_max_ps(b, zero), maxValue);
+
+    const __m128 maxRGB = _mm_max_ps(r, _mm_max_ps(g, b));
+
+    // SSE2 has no integer max. The exponent clamp is a compare and select.
+    const __m128i minExponent = _mm_set1_epi32(-RGB9E5_EXPONENT_BIAS - 1);
+
+    __m128i exponent = _mm_sub_epi32(_mm_srli_epi32(_mm_castps_si128(maxRGB), 23), _mm_set1_epi32(127));
+    exponent = select(_mm_cmpgt_epi32(exponent, minExponent), exponent, minExponent);
+
+    __m128i exponentShared = _mm_add_epi32(exponent, _mm_set1_epi32(1 + RGB9E5_EXPONENT_BIAS));
+
+    const __m128i overflow = _mm_cmpeq_epi32(roundMantissa4(maxRGB, getRGB9E5Scale4(exponentShared)), _mm_set1_epi32(1 << RGB9E5_MANTISSA_BITS));
+
+    exponentShared = _mm_sub_epi32(exponentShared, overflow); // The mask is -1 where the mantissa overflowed.
+
+    const __m128 scale = getRGB9E5Scale4(exponentShared);
+
+    __m128i result = _mm_slli_epi32(exponentShared, 27);
+    result = _mm_or_si128(result, roundMantissa4(r, scale));
+    result = _mm_or_si128(result, _mm_slli_epi32(roundMantissa4(g, scale), 9));
+    result = _mm_or_si128(result, _mm_slli_epi32(roundMantissa4(b, scale), 18));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), result);
+  }
+#endif
+
+  for (; i < count; ++i)
+  {
+    dst[i] = encodeRGB9E5(rgba[i * 4], rgba[i * 4 + 1], rgba[i * 4 + 2]);
+  }
+}
@@ -0,0 +1,295 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/Application.h"
+
+#include <algorithm>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "inc/MyAssert.h"
+
+
+// Row-major 3x4 affine matrices: result = a * b, so b is applied first.
+static void multiplyTransforms(const float a[12], const float b[12], float result[12])
+{
+  for (int row = 0; row < 3; ++row)
+  {
+    for (int col = 0; col < 4; ++col)
+    {
+      result[row * 4 + col] = a[row * 4    ] * b[col    ] +
+                              a[row * 4 + 1] * b[col + 4] +
+                              a[row * 4 + 2] * b[col + 8] +
+                              ((col == 3) ? a[row * 4 + 3] : 0.0f);
+    }
+  }
+}
+
+std::shared_ptr<sg::Group> Application::createGLTF(std::string const& filename)
+{
+  std::map< std::string, std::shared_ptr<sg::Group> >::const_iterator itGroup = m_mapGroups.find(filename);
+  if (itGroup != m_mapGroups.end())
+  {
+    return itGroup->second; // Full model instancing under an Instance node.
+  }
+
+  // Generate a Group node in any case. It will not have children when the file loading fails. 
+  std::shared_ptr<sg::Group> group(new sg::Group(m_idGroup++));
+  m_mapGroups[filename] = group; // Allow instancing of this whole model (to fail again quicker next time).
+
+  GltfLoader loader;
+
+  if (!loader.load(filename))
+  {
+    std::cerr << "ERROR: createGLTF() could not load " << filename << '\n';
+    return group;
+  }
+
+  // Flat list of all triangle primitives. Each becomes one Triangles geometry.
+  std::vector<GltfPrimitive> primitives;
+  std::vector<size_t>        firstPrimitive; // Per mesh index into primitives.
+
+  for (size_t i = 0; i < loader.m_meshes.size(); ++i)
+  {
+    firstPrimitive.push_back(primitives.size());
+    primitives.insert(primitives.end(), loader.m_meshes[i].primitives.begin(), loader.m_meshes[i].primitives.end());
+  }
+
+  std::vector< std::vector<TriangleAttributes> > attributes(primitives.size());
+  std::vector< std::vector<unsigned int> >       indices(primitives.size());
+  std::vector<char>                              isValid(primitives.size(), 0);
+
+  // Read the primitives in parallel. The loader only reads from the mapped buffers.
+  const size_t numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+  std::vector< std::future<void> > futures;
+  for (size_t t = 0; t < std::min(numThreads, primitives.size()); ++t)
+  {
+    futures.push_back(std::async(std::launch::async, [&loader, &primitives, &attributes, &indices, &isValid, t, numThreads]()
+    {
+      for (size_t i = t; i < primitives.size(); i += numThreads)
+      {
+        if (loader.readPrimitive(primitives[i], attributes[i], indices[i]) && 3 <= indices[i].size())
+        {
+          if (primitives[i].tangent < 0)
+          {
+            calculateTangents(attributes[i], indices[i]); // Only touches the arrays.
+          }
+          isValid[i] = 1;
+        }
+      }
+    }));
+  }
+  for (size_t i = 0; i < futures.size(); ++i)
+  {
+    futures[i].get();
+  }
+
+  // The geometry IDs are assigned in primitive order, independent of the thread scheduling.
+  std::vector< std::shared_ptr<sg::Triangles> > geometries(primitives.size());
+
+  for (size_t i = 0; i < primitives.size(); ++i)
+  {
+    if (!isValid[i])
+    {
+      std::cerr << "WARNING: createGLTF() skipped invalid primitive " << i << " in " << filename << '\n';
+      continue;
+    }
+
+    std::shared_ptr<sg::Triangles> geometry(new sg::Triangles(m_idGeometry++));
+
+    geometry->setAttributes(std::move(attributes[i]));
+    geometry->setIndices(std::move(indices[i]));
+
+    m_geometries.push_back(geometry);
+    geometries[i] = geometry;
+  }
+
+  // One Group per glTF mesh with an Instance per primitive carrying its material.
+  // All nodes and EXT_mesh_gpu_instancing instances reference these groups, so no geometry is duplicated.
+  std::vector< std::shared_ptr<sg::Group> > meshGroups(loader.m_meshes.size());
+
+  for (size_t i = 0; i < loader.m_meshes.size(); ++i)
+  {
+    meshGroups[i] = std::shared_ptr<sg::Group>(new sg::Group(m_idGroup++));
+
+    for (size_t j = 0; j < loader.m_meshes[i].primitives.size(); ++j)
+    {
+      std::shared_ptr<sg::Triangles> geometry = geometries[firstPrimitive[i] + j];
+      if (!geometry)
+      {
+        continue;
+      }
+
+      const float identity[12] =
+      {
+        1.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 1.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f
+      };
+
+      std::shared_ptr<sg::Instance> instance(new sg::Instance(m_idInstance++));
+
+      instance->setTransform(identity);
+      instance->setChild(geometry);
+
+      // Same material reference resolution as the ASSIMP loader. The glTF material name selects the material.
+      const int indexMaterialGLTF = loader.m_meshes[i].primitives[j].material;
+
+      const bool hasMaterial = (0 <= indexMaterialGLTF && indexMaterialGLTF < static_cast<int>(loader.m_materials.size()));
+
+      std::string nameMaterialReference;
+      if (hasMaterial)
+      {
+        nameMaterialReference = loader.m_materials[indexMaterialGLTF].name;
+      }
+
+      int indexMaterial = -1;
+      std::map<std::string, int>::const_iterator itm = m_mapMaterialReferences.find(nameMaterialReference);
+      if (hasMaterial && itm != m_mapMaterialReferences.end())
+      {
+        indexMaterial = itm->second;
+
+        // The materials had been created with default albedo colors.
+        // Change it to the base color of the glTF material.
+        m_materialsGUI[indexMaterial].albedo = loader.m_materials[indexMaterialGLTF].baseColor;
+      }
+      else
+      {
+        std::cerr << "WARNING: createGLTF() No material found for " << nameMaterialReference << ". Trying default.\n";
+
+        std::map<std::string, int>::const_iterator itmd = m_mapMaterialReferences.find(std::string("default"));
+        if (itmd != m_mapMaterialReferences.end())
+        {
+          indexMaterial = itmd->second;
+        }
+        else 
+        {
+          std::cerr << "ERROR: createGLTF() No default material found\n";
+        }
+      }
+      instance->setMaterial(indexMaterial);
+
+      meshGroups[i]->addChild(instance);
+    }
+  }
+
+  std::vector<bool> isVisited(loader.m_nodes.size(), false);
+
+  for (size_t i = 0; i < loader.m_roots.size(); ++i)
+  {
+    const int indexNode = loader.m_roots[i];
+
+    std::shared_ptr<sg::Group> child = traverseGLTF(loader, indexNode, meshGroups, isVisited);
+
+    // The node transformations are applied inside traverseGLTF(). The roots only need an identity Instance.
+    const float identity[12] =
+    {
+      1.0f, 0.0f, 0.0f, 0.0f,
+      0.0f, 1.0f, 0.0f, 0.0f,
+      0.0f, 0.0f, 1.0f, 0.0f
+    };
+
+    std::shared_ptr<sg::Instance> instance(new sg::Instance(m_idInstance++));
+
+    instance->setTransform(identity);
+    instance->setChild(child);
+
+    group->addChild(instance);
+  }
+
+  std::cout << "createGLTF() " << filename << ": " << primitives.size() << " primitives, " << loader.m_nodes.size() << " nodes\n";
+
+  return group;
+}
+
+
+// Same structure as traverseScene(): The Group of a node holds Instances with the node's transformation for its children and its mesh.
+std::shared_ptr<sg::Group> Application::traverseGLTF(GltfLoader const& loader, const int indexNode, std::vector< std::shared_ptr<sg::Group> > const& meshGroups, std::vector<bool>& isVisited)
+{
+  std::shared_ptr<sg::Group> group(new sg::Group(m_idGroup++));
+
+  // glTF nodes form strict trees. Stop at cycles or shared nodes in invalid files.
+  if (isVisited[indexNode])
+  {
+    std::cerr << "WARNING: traverseGLTF() node " << indexNode << " is referenced more than once. Ignored.\n";
+    return group;
+  }
+  isVisited[indexNode] = true;
+
+  GltfNode const& node = loader.m_nodes[indexNode];
+
+  for (size_t i = 0; i < node.children.size(); ++i)
+  {
+    std::shared_ptr<sg::Group> child = traverseGLTF(loader, node.children[i], meshGroups, isVisited);
+
+    std::shared_ptr<sg::Instance> instance(new sg::Instance(m_idInstance++));
+
+    instance->setTransform(node.matrix);
+    instance->setChild(child);
+
+    group->addChild(instance);
+  }
+
+  if (0 <= node.mesh && node.mesh < static_cast<int>(meshGroups.size()))
+  {
+    if (node.instances.empty())
+    {
+      std::shared_ptr<sg::Instance> instance(new sg::Instance(m_idInstance++));
+
+      instance->setTransform(node.matrix);
+      instance->setChild(meshGroups[node.mesh]);
+
+      group->addChild(instance);
+    }
+    else
+    {
+      // EXT_mesh_gpu_instancing: One Instance per transform, all sharing the mesh Group.
+      // The instance transforms are in the local space of the node.
+      const size_t count = node.instances.size() / 12;
+
+      for (size_t i = 0; i < count; ++i)
+      {
+        float trafo[12];
+
+        multiplyTransforms(node.matrix, &node.instances[i * 12], trafo);
+
+        std::shared_ptr<sg::Instance> instance(new sg::Instance(m_idInstance++));
+
+        instance->setTransform(trafo);
+        instance->setChild(meshGroups[node.mesh]);
+
+        group->addChild(instance);
+      }
+    }
+  }
+
+  return group;
+}
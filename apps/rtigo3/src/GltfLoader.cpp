@@ -0,0 +1,1496 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/GltfLoader.h"
+
+#include "shaders/vector_math.h"
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+
+MappedFile::MappedFile()
+: m_data(nullptr)
+, m_size(0)
+#if defined(_WIN32)
+, m_file(INVALID_HANDLE_VALUE)
+, m_mapping(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+  close();
+}
+
+bool MappedFile::open(std::string const& filename)
+{
+  close();
+
+#if defined(_WIN32)
+  m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (m_file == INVALID_HANDLE_VALUE)
+  {
+    return false;
+  }
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+  {
+    close();
+    return false;
+  }
+
+  m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (m_mapping == nullptr)
+  {
+    close();
+    return false;
+  }
+
+  m_data = static_cast<const unsigned char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+  if (m_data == nullptr)
+  {
+    close();
+    return false;
+  }
+  m_size = static_cast<size_t>(size.QuadPart);
+#else
+  const int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    return false;
+  }
+
+  struct stat status;
+  if (fstat(fd, &status) != 0 || status.st_size <= 0)
+  {
+    ::close(fd);
+    return false;
+  }
+
+  void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd); // The mapping keeps its own reference to the file.
+
+  if (data == MAP_FAILED)
+  {
+    return false;
+  }
+  m_data = static_cast<const unsigned char*>(data);
+  m_size = static_cast<size_t>(status.st_size);
+#endif
+  return true;
+}
+
+void MappedFile::close()
+{
+#if defined(_WIN32)
+  if (m_data != nullptr)
+  {
+    UnmapViewOfFile(m_data);
+  }
+  if (m_mapping != nullptr)
+  {
+    CloseHandle(m_mapping);
+    m_mapping = nullptr;
+  }
+  if (m_file != INVALID_HANDLE_VALUE)
+  {
+    CloseHandle(m_file);
+    m_file = INVALID_HANDLE_VALUE;
+  }
+#else
+  if (m_data != nullptr)
+  {
+    munmap(const_cast<unsigned char*>(m_data), m_size);
+  }
+#endif
+  m_data = nullptr;
+  m_size = 0;
+}
+
+const unsigned char* MappedFile::getData() const
+{
+  return m_data;
+}
+
+size_t MappedFile::getSize() const
+{
+  return m_size;
+}
+
+
+// Minimal JSON DOM for the glTF description. The binary data is never part of it.
+namespace
+{
+  enum JsonType
+  {
+    JSON_NULL,
+    JSON_BOOL,
+    JSON_NUMBER,
+    JSON_STRING,
+    JSON_ARRAY,
+    JSON_OBJECT
+  };
+
+  struct JsonValue
+  {
+    JsonValue()
+    : type(JSON_NULL)
+    , number(0.0)
+    {
+    }
+
+    const JsonValue* find(const char* key) const
+    {
+      if (type == JSON_OBJECT)
+      {
+        for (size_t i = 0; i < members.size(); ++i)
+        {
+          if (members[i].first == key)
+          {
+            return &members[i].second;
+          }
+        }
+      }
+      return nullptr;
+    }
+
+    int getInt(const char* key, const int defaultValue) const
+    {
+      const JsonValue* value = find(key);
+      return (value != nullptr && value->type == JSON_NUMBER) ? static_cast<int>(value->number) : defaultValue;
+    }
+
+    size_t getSize(const char* key, const size_t defaultValue) const
+    {
+      const JsonValue* value = find(key);
+      return (value != nullptr && value->type == JSON_NUMBER && 0.0 <= value->number) ? static_cast<size_t>(value->number) : defaultValue;
+    }
+
+    // Fills up to count floats of an array member. Returns false when the member doesn't exist.
+    bool getFloats(const char* key, float* values, const size_t count) const
+    {
+      const JsonValue* value = find(key);
+      if (value == nullptr || value->type != JSON_ARRAY)
+      {
+        return false;
+      }
+      for (size_t i = 0; i < count && i < value->elements.size(); ++i)
+      {
+        values[i] = static_cast<float>(value->elements[i].number);
+      }
+      return true;
+    }
+
+    JsonType    type;
+    double      number; // JSON_NUMBER and JSON_BOOL
+    std::string string;
+
+    std::vector<JsonValue>                             elements;
+    std::vector< std::pair<std::string, JsonValue> > members;
+  };
+
+  class JsonParser
+  {
+  public:
+    JsonParser(const char* text, const size_t length)
+    : m_cur(text)
+    , m_end(text + length)
+    , m_depth(0)
+    {
+    }
+
+    bool parse(JsonValue& value)
+    {
+      if (!parseValue(value))
+      {
+        return false;
+      }
+      skipWhitespace();
+      // GLB pads the JSON chunk with spaces, .gltf files may end with a zero byte.
+      while (m_cur < m_end && *m_cur == '\0')
+      {
+        ++m_cur;
+      }
+      return m_cur == m_end;
+    }
+
+  private:
+    void skipWhitespace()
+    {
+      while (m_cur < m_end && (*m_cur == ' ' || *m_cur == '\t' || *m_cur == '\n' || *m_cur == '\r'))
+      {
+        ++m_cur;
+      }
+    }
+
+    bool match(const char* literal)
+    {
+      const size_t length = strlen(literal);
+      if (static_cast<size_t>(m_end - m_cur) < length || strncmp(m_cur, literal, length) != 0)
+      {
+        return false;
+      }
+      m_cur += length;
+      return true;
+    }
+
+    bool parseValue(JsonValue& value)
+    {
+      skipWhitespace();
+      if (m_cur == m_end || 64 < m_depth) // The glTF structure is shallow. Limits the recursion on malformed input.
+      {
+        return false;
+      }
+
+      switch (*m_cur)
+      {
+        case '{':
+          return parseObject(value);
+        case '[':
+          return parseArray(value);
+        case '"':
+          value.type = JSON_STRING;
+          return parseString(value.string);
+        case 't':
+          value.type   = JSON_BOOL;
+          value.number = 1.0;
+          return match("true");
+        case 'f':
+          value.type   = JSON_BOOL;
+          value.number = 0.0;
+          return match("false");
+        case 'n':
+          value.type = JSON_NULL;
+          return match("null");
+        default:
+          return parseNumber(value);
+      }
+    }
+
+    bool parseNumber(JsonValue& value)
+    {
+      char buffer[64];
+      size_t length = 0;
+
+      while (m_cur < m_end && length < sizeof(buffer) - 1 && (isdigit(static_cast<unsigned char>(*m_cur)) || *m_cur == '-' || *m_cur == '+' || *m_cur == '.' || *m_cur == 'e' || *m_cur == 'E'))
+      {
+        buffer[length++] = *m_cur++;
+      }
+      buffer[length] = '\0';
+
+      char* end = nullptr;
+      value.type   = JSON_NUMBER;
+      value.number = strtod(buffer, &end); // The mapped text is not zero terminated, so strtod() only sees the copy.
+
+      return (0 < length && end == buffer + length);
+    }
+
+    static void appendUTF8(std::string& string, const unsigned int code)
+    {
+      if (code < 0x80)
+      {
+        string += static_cast<char>(code);
+      }
+      else if (code < 0x800)
+      {
+        string += static_cast<char>(0xC0 | (code >> 6));
+        string += static_cast<char>(0x80 | (code & 0x3F));
+      }
+      else if (code < 0x10000)
+      {
+        string += static_cast<char>(0xE0 | (code >> 12));
+        string += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        string += static_cast<char>(0x80 | (code & 0x3F));
+      }
+      else
+      {
+        string += static_cast<char>(0xF0 | (code >> 18));
+        string += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        string += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        string += static_cast<char>(0x80 | (code & 0x3F));
+      }
+    }
+
+    bool parseHex4(unsigned int& code)
+    {
+      if (m_end - m_cur < 4)
+      {
+        return false;
+      }
+      code = 0;
+      for (int i = 0; i < 4; ++i)
+      {
+        const char c = *m_cur++;
+        code <<= 4;
+        if ('0' <= c && c <= '9')
+        {
+          code |= c - '0';
+        }
+        else if ('a' <= c && c <= 'f')
+        {
+          code |= c - 'a' + 10;
+        }
+        else if ('A' <= c && c <= 'F')
+        {
+          code |= c - 'A' + 10;
+        }
+        else
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+
+    bool parseString(std::string& string)
+    {
+      ++m_cur; // '"'
+
+      while (m_cur < m_end && *m_cur != '"')
+      {
+        if (*m_cur != '\\')
+        {
+          string += *m_cur++;
+          continue;
+        }
+
+        if (++m_cur == m_end)
+        {
+          return false;
+        }
+
+        const char c = *m_cur++;
+        switch (c)
+        {
+          case '"':
+          case '\\':
+          case '/':
+            string += c;
+            break;
+          case 'b':
+            string += '\b';
+            break;
+          case 'f':
+            string += '\f';
+            break;
+          case 'n':
+            string += '\n';
+            break;
+          case 'r':
+            string += '\r';
+            break;
+          case 't':
+            string += '\t';
+            break;
+          case 'u':
+            {
+              unsigned int code;
+              if (!parseHex4(code))
+              {
+                return false;
+              }
+              // Surrogate pair.
+              if (0xD800 <= code && code < 0xDC00 && 2 <= m_end - m_cur && m_cur[0] == '\\' && m_cur[1] == 'u')
+              {
+                m_cur += 2;
+                unsigned int low;
+                if (!parseHex4(low))
+                {
+                  return false;
+                }
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+              }
+              appendUTF8(string, code);
+            }
+            break;
+          default:
+            return false;
+        }
+      }
+
+      if (m_cur == m_end)
+      {
+        return false;
+      }
+      ++m_cur; // '"'
+      return true;
+    }
+
+    bool parseArray(JsonValue& value)
+    {
+      ++m_cur; // '['
+      ++m_depth;
+
+      value.type = JSON_ARRAY;
+
+      skipWhitespace();
+      if (m_cur < m_end && *m_cur == ']')
+      {
+        ++m_cur;
+        --m_depth;
+        return true;
+      }
+
+      while (true)
+      {
+        value.elements.push_back(JsonValue());
+        if (!parseValue(value.elements.back()))
+        {
+          return false;
+        }
+        skipWhitespace();
+        if (m_cur == m_end)
+        {
+          return false;
+        }
+        if (*m_cur == ',')
+        {
+          ++m_cur;
+          continue;
+        }
+        if (*m_cur == ']')
+        {
+          ++m_cur;
+          --m_depth;
+          return true;
+        }
+        return false;
+      }
+    }
+
+    bool parseObject(JsonValue& value)
+    {
+      ++m_cur; // '{'
+      ++m_depth;
+
+      value.type = JSON_OBJECT;
+
+      skipWhitespace();
+      if (m_cur < m_end && *m_cur == '}')
+      {
+        ++m_cur;
+        --m_depth;
+        return true;
+      }
+
+      while (true)
+      {
+        skipWhitespace();
+        if (m_cur == m_end || *m_cur != '"')
+        {
+          return false;
+        }
+
+        value.members.push_back(std::pair<std::string, JsonValue>());
+        if (!parseString(value.members.back().first))
+        {
+          return false;
+        }
+        skipWhitespace();
+        if (m_cur == m_end || *m_cur != ':')
+        {
+          return false;
+        }
+        ++m_cur;
+        if (!parseValue(value.members.back().second))
+        {
+          return false;
+        }
+        skipWhitespace();
+        if (m_cur == m_end)
+        {
+          return false;
+        }
+        if (*m_cur == ',')
+        {
+          ++m_cur;
+          continue;
+        }
+        if (*m_cur == '}')
+        {
+          ++m_cur;
+          --m_depth;
+          return true;
+        }
+        return false;
+      }
+    }
+
+    const char* m_cur;
+    const char* m_end;
+    int         m_depth;
+  };
+} // namespace
+
+
+// glTF constants.
+#define GLTF_BYTE           5120
+#define GLTF_UNSIGNED_BYTE  5121
+#define GLTF_SHORT          5122
+#define GLTF_UNSIGNED_SHORT 5123
+#define GLTF_UNSIGNED_INT   5125
+#define GLTF_FLOAT          5126
+
+#define GLB_MAGIC      0x46546C67 // "glTF"
+#define GLB_CHUNK_JSON 0x4E4F534A
+#define GLB_CHUNK_BIN  0x004E4942
+
+
+static size_t getComponentSize(const int componentType)
+{
+  switch (componentType)
+  {
+    case GLTF_BYTE:
+    case GLTF_UNSIGNED_BYTE:
+      return 1;
+    case GLTF_SHORT:
+    case GLTF_UNSIGNED_SHORT:
+      return 2;
+    case GLTF_UNSIGNED_INT:
+    case GLTF_FLOAT:
+      return 4;
+  }
+  return 0;
+}
+
+static int getNumComponents(std::string const& type)
+{
+  if (type == "SCALAR")
+  {
+    return 1;
+  }
+  if (type == "VEC2")
+  {
+    return 2;
+  }
+  if (type == "VEC3")
+  {
+    return 3;
+  }
+  if (type == "VEC4" || type == "MAT2")
+  {
+    return 4;
+  }
+  if (type == "MAT3")
+  {
+    return 9;
+  }
+  if (type == "MAT4")
+  {
+    return 16;
+  }
+  return 0;
+}
+
+// Converts n components of one element. The mapped data has no alignment guarantees, so everything goes through memcpy().
+static void readComponents(const unsigned char* src, const int componentType, const bool normalized, const int n, float* dst)
+{
+  for (int i = 0; i < n; ++i)
+  {
+    switch (componentType)
+    {
+      case GLTF_FLOAT:
+        memcpy(&dst[i], src + i * 4, sizeof(float));
+        break;
+      case GLTF_BYTE:
+        {
+          const float c = static_cast<float>(static_cast<signed char>(src[i]));
+          dst[i] = (normalized) ? fmaxf(c / 127.0f, -1.0f) : c;
+        }
+        break;
+      case GLTF_UNSIGNED_BYTE:
+        {
+          const float c = static_cast<float>(src[i]);
+          dst[i] = (normalized) ? c / 255.0f : c;
+        }
+        break;
+      case GLTF_SHORT:
+        {
+          short s;
+          memcpy(&s, src + i * 2, sizeof(short));
+          const float c = static_cast<float>(s);
+          dst[i] = (normalized) ? fmaxf(c / 32767.0f, -1.0f) : c;
+        }
+        break;
+      case GLTF_UNSIGNED_SHORT:
+        {
+          unsigned short s;
+          memcpy(&s, src + i * 2, sizeof(unsigned short));
+          const float c = static_cast<float>(s);
+          dst[i] = (normalized) ? c / 65535.0f : c;
+        }
+        break;
+      case GLTF_UNSIGNED_INT:
+        {
+          unsigned int u;
+          memcpy(&u, src + i * 4, sizeof(unsigned int));
+          dst[i] = static_cast<float>(u);
+        }
+        break;
+    }
+  }
+}
+
+static unsigned int readIndex(const unsigned char* src, const int componentType)
+{
+  switch (componentType)
+  {
+    case GLTF_UNSIGNED_BYTE:
+      return src[0];
+    case GLTF_UNSIGNED_SHORT:
+      {
+        unsigned short s;
+        memcpy(&s, src, sizeof(unsigned short));
+        return s;
+      }
+    case GLTF_UNSIGNED_INT:
+      {
+        unsigned int u;
+        memcpy(&u, src, sizeof(unsigned int));
+        return u;
+      }
+  }
+  return ~0u;
+}
+
+// Row-major 3x4 matrix of translation * rotation * scale. The quaternion is (x, y, z, w).
+static void composeTRS(const float t[3], const float q[4], const float s[3], float m[12])
+{
+  const float x = q[0];
+  const float y = q[1];
+  const float z = q[2];
+  const float w = q[3];
+
+  m[ 0] = (1.0f - 2.0f * (y * y + z * z)) * s[0];
+  m[ 1] = (       2.0f * (x * y - z * w)) * s[1];
+  m[ 2] = (       2.0f * (x * z + y * w)) * s[2];
+  m[ 3] = t[0];
+
+  m[ 4] = (       2.0f * (x * y + z * w)) * s[0];
+  m[ 5] = (1.0f - 2.0f * (x * x + z * z)) * s[1];
+  m[ 6] = (       2.0f * (y * z - x * w)) * s[2];
+  m[ 7] = t[1];
+
+  m[ 8] = (       2.0f * (x * z - y * w)) * s[0];
+  m[ 9] = (       2.0f * (y * z + x * w)) * s[1];
+  m[10] = (1.0f - 2.0f * (x * x + y * y)) * s[2];
+  m[11] = t[2];
+}
+
+static bool decodeBase64(const char* src, const size_t length, std::vector<unsigned char>& data)
+{
+  unsigned int bits  = 0;
+  int          count = 0;
+
+  data.clear();
+  data.reserve(length / 4 * 3);
+
+  for (size_t i = 0; i < length; ++i)
+  {
+    const char c = src[i];
+    unsigned int v;
+
+    if ('A' <= c && c <= 'Z')
+    {
+      v = c - 'A';
+    }
+    else if ('a' <= c && c <= 'z')
+    {
+      v = c - 'a' + 26;
+    }
+    else if ('0' <= c && c <= '9')
+    {
+      v = c - '0' + 52;
+    }
+    else if (c == '+')
+    {
+      v = 62;
+    }
+    else if (c == '/')
+    {
+      v = 63;
+    }
+    else if (c == '=')
+    {
+      break;
+    }
+    else
+    {
+      return false;
+    }
+
+    bits = (bits << 6) | v;
+    count += 6;
+    if (8 <= count)
+    {
+      count -= 8;
+      data.push_back(static_cast<unsigned char>((bits >> count) & 0xFF));
+    }
+  }
+  return true;
+}
+
+// Relative buffer URIs are percent encoded.
+static std::string decodeURI(std::string const& uri)
+{
+  std::string result;
+
+  for (size_t i = 0; i < uri.size(); ++i)
+  {
+    if (uri[i] == '%' && i + 2 < uri.size())
+    {
+      result += static_cast<char>(strtol(uri.substr(i + 1, 2).c_str(), nullptr, 16));
+      i += 2;
+    }
+    else
+    {
+      result += uri[i];
+    }
+  }
+  return result;
+}
+
+// Smooth vertex normals weighted by the triangle areas.
+static void calculateNormals(std::vector<TriangleAttributes>& attributes, std::vector<unsigned int> const& indices)
+{
+  for (size_t i = 0; i < attributes.size(); ++i)
+  {
+    attributes[i].normal = make_float3(0.0f, 0.0f, 0.0f);
+  }
+
+  for (size_t i = 0; i + 2 < indices.size(); i += 3)
+  {
+    TriangleAttributes& a0 = attributes[indices[i    ]];
+    TriangleAttributes& a1 = attributes[indices[i + 1]];
+    TriangleAttributes& a2 = attributes[indices[i + 2]];
+
+    const float3 n = cross(a1.vertex - a0.vertex, a2.vertex - a0.vertex);
+
+    a0.normal += n;
+    a1.normal += n;
+    a2.normal += n;
+  }
+
+  for (size_t i = 0; i < attributes.size(); ++i)
+  {
+    const float len = length(attributes[i].normal);
+
+    attributes[i].normal = (0.0f < len) ? attributes[i].normal / len : make_float3(0.0f, 0.0f, 1.0f);
+  }
+}
+
+
+GltfLoader::GltfLoader()
+{
+}
+
+GltfLoader::~GltfLoader()
+{
+}
+
+bool GltfLoader::load(std::string const& filename)
+{
+  std::unique_ptr<MappedFile> file(new MappedFile());
+
+  if (!file->open(filename))
+  {
+    std::cerr << "ERROR: GltfLoader::load() could not map " << filename << '\n';
+    return false;
+  }
+
+  // External buffers are relative to the model file.
+  std::string path;
+
+  const std::string::size_type last = filename.find_last_of("/\\");
+  if (last != std::string::npos)
+  {
+    path = filename.substr(0, last + 1);
+  }
+
+  const unsigned char* data = file->getData();
+  const size_t         size = file->getSize();
+
+  const char*          json     = reinterpret_cast<const char*>(data);
+  size_t               length   = size;
+  const unsigned char* chunkBIN = nullptr;
+  size_t               sizeBIN  = 0;
+
+  unsigned int header[3] = { 0, 0, 0 }; // magic, version, length
+
+  if (12 <= size)
+  {
+    memcpy(header, data, sizeof(header));
+  }
+
+  if (header[0] == GLB_MAGIC)
+  {
+    if (header[1] != 2 || size < header[2])
+    {
+      std::cerr << "ERROR: GltfLoader::load() invalid GLB header in " << filename << '\n';
+      return false;
+    }
+
+    json   = nullptr;
+    length = 0;
+
+    // Chunks of 8 bytes header (length, type) and 4 byte aligned data. The JSON chunk must be the first.
+    size_t offset = 12;
+    while (offset + 8 <= header[2])
+    {
+      unsigned int chunk[2];
+      memcpy(chunk, data + offset, sizeof(chunk));
+      offset += 8;
+
+      if (header[2] - offset < chunk[0])
+      {
+        std::cerr << "ERROR: GltfLoader::load() truncated GLB chunk in " << filename << '\n';
+        return false;
+      }
+
+      if (chunk[1] == GLB_CHUNK_JSON && json == nullptr)
+      {
+        json   = reinterpret_cast<const char*>(data + offset);
+        length = chunk[0];
+      }
+      else if (chunk[1] == GLB_CHUNK_BIN && chunkBIN == nullptr)
+      {
+        chunkBIN = data + offset;
+        sizeBIN  = chunk[0];
+      }
+      offset += (chunk[0] + 3) & ~3u;
+    }
+
+    if (json == nullptr)
+    {
+      std::cerr << "ERROR: GltfLoader::load() no JSON chunk in " << filename << '\n';
+      return false;
+    }
+  }
+
+  m_files.push_back(std::move(file)); // The BIN chunk stays mapped.
+
+  if (!parse(json, length, path, chunkBIN, sizeBIN))
+  {
+    std::cerr << "ERROR: GltfLoader::load() failed to parse " << filename << '\n';
+    return false;
+  }
+  return true;
+}
+
+
+bool GltfLoader::parse(const char* json, const size_t length, std::string const& path, const unsigned char* chunkBIN, const size_t sizeBIN)
+{
+  JsonValue root;
+
+  JsonParser parser(json, length);
+  if (!parser.parse(root) || root.type != JSON_OBJECT)
+  {
+    std::cerr << "ERROR: GltfLoader::parse() invalid JSON\n";
+    return false;
+  }
+
+  const JsonValue* asset = root.find("asset");
+  if (asset == nullptr || asset->find("version") == nullptr || asset->find("version")->string.compare(0, 1, "2") != 0)
+  {
+    std::cerr << "ERROR: GltfLoader::parse() only glTF 2.0 is supported\n";
+    return false;
+  }
+
+  const JsonValue* required = root.find("extensionsRequired");
+  if (required != nullptr)
+  {
+    for (size_t i = 0; i < required->elements.size(); ++i)
+    {
+      if (required->elements[i].string != "EXT_mesh_gpu_instancing")
+      {
+        std::cerr << "ERROR: GltfLoader::parse() unsupported required extension " << required->elements[i].string << '\n';
+        return false;
+      }
+    }
+  }
+
+  const JsonValue* buffers = root.find("buffers");
+  if (buffers != nullptr)
+  {
+    for (size_t i = 0; i < buffers->elements.size(); ++i)
+    {
+      JsonValue const& b = buffers->elements[i];
+
+      const size_t byteLength = b.getSize("byteLength", 0);
+
+      Buffer buffer;
+
+      const JsonValue* uri = b.find("uri");
+      if (uri == nullptr) // The GLB binary chunk.
+      {
+        if (i != 0 || chunkBIN == nullptr || sizeBIN < byteLength)
+        {
+          std::cerr << "ERROR: GltfLoader::parse() buffer " << i << " has no data\n";
+          return false;
+        }
+        buffer.data = chunkBIN;
+        buffer.size = byteLength;
+      }
+      else if (uri->string.compare(0, 5, "data:") == 0)
+      {
+        const std::string::size_type comma = uri->string.find(";base64,");
+        if (comma == std::string::npos)
+        {
+          std::cerr << "ERROR: GltfLoader::parse() buffer " << i << " data URI is not base64\n";
+          return false;
+        }
+
+        m_decoded.push_back(std::vector<unsigned char>());
+        if (!decodeBase64(uri->string.c_str() + comma + 8, uri->string.size() - comma - 8, m_decoded.back()) || m_decoded.back().size() < byteLength)
+        {
+          std::cerr << "ERROR: GltfLoader::parse() buffer " << i << " invalid base64 data\n";
+          return false;
+        }
+        buffer.data = m_decoded.back().data();
+        buffer.size = byteLength;
+      }
+      else
+      {
+        std::unique_ptr<MappedFile> file(new MappedFile());
+
+        const std::string filename = path + decodeURI(uri->string);
+        if (!file->open(filename) || file->getSize() < byteLength)
+        {
+          std::cerr << "ERROR: GltfLoader::parse() could not map buffer " << filename << '\n';
+          return false;
+        }
+        buffer.data = file->getData();
+        buffer.size = byteLength;
+
+        m_files.push_back(std::move(file));
+      }
+
+      m_buffers.push_back(buffer);
+    }
+  }
+
+  const JsonValue* bufferViews = root.find("bufferViews");
+  if (bufferViews != nullptr)
+  {
+    for (size_t i = 0; i < bufferViews->elements.size(); ++i)
+    {
+      JsonValue const& v = bufferViews->elements[i];
+
+      BufferView view;
+
+      view.buffer = v.getInt("buffer", -1);
+      view.offset = v.getSize("byteOffset", 0);
+      view.length = v.getSize("byteLength", 0);
+      view.stride = v.getSize("byteStride", 0);
+
+      if (view.buffer < 0 || static_cast<int>(m_buffers.size()) <= view.buffer ||
+          m_buffers[view.buffer].size < view.offset || m_buffers[view.buffer].size - view.offset < view.length)
+      {
+        std::cerr << "ERROR: GltfLoader::parse() bufferView " << i << " out of bounds\n";
+        return false;
+      }
+      m_bufferViews.push_back(view);
+    }
+  }
+
+  const JsonValue* accessors = root.find("accessors");
+  if (accessors != nullptr)
+  {
+    for (size_t i = 0; i < accessors->elements.size(); ++i)
+    {
+      JsonValue const& a = accessors->elements[i];
+
+      Accessor accessor;
+
+      accessor.bufferView    = a.getInt("bufferView", -1);
+      accessor.offset        = a.getSize("byteOffset", 0);
+      accessor.count         = a.getSize("count", 0);
+      accessor.componentType = a.getInt("componentType", 0);
+      accessor.numComponents = 0;
+      accessor.normalized    = false;
+
+      const JsonValue* type = a.find("type");
+      if (type != nullptr)
+      {
+        accessor.numComponents = getNumComponents(type->string);
+      }
+      const JsonValue* normalized = a.find("normalized");
+      if (normalized != nullptr)
+      {
+        accessor.normalized = (normalized->number != 0.0);
+      }
+      if (a.find("sparse") != nullptr)
+      {
+        std::cerr << "WARNING: GltfLoader::parse() sparse accessor " << i << " is read without its sparse values\n";
+      }
+
+      m_accessors.push_back(accessor);
+    }
+  }
+
+  const JsonValue* materials = root.find("materials");
+  if (materials != nullptr)
+  {
+    for (size_t i = 0; i < materials->elements.size(); ++i)
+    {
+      JsonValue const& m = materials->elements[i];
+
+      GltfMaterial material;
+
+      const JsonValue* name = m.find("name");
+      if (name != nullptr)
+      {
+        material.name = name->string;
+      }
+
+      float color[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+      const JsonValue* pbr = m.find("pbrMetallicRoughness");
+      if (pbr != nullptr)
+      {
+        pbr->getFloats("baseColorFactor", color, 4);
+      }
+      material.baseColor = make_float3(color[0], color[1], color[2]);
+
+      m_materials.push_back(material);
+    }
+  }
+
+  const JsonValue* meshes = root.find("meshes");
+  if (meshes != nullptr)
+  {
+    for (size_t i = 0; i < meshes->elements.size(); ++i)
+    {
+      GltfMesh mesh;
+
+      const JsonValue* primitives = meshes->elements[i].find("primitives");
+      if (primitives != nullptr)
+      {
+        for (size_t j = 0; j < primitives->elements.size(); ++j)
+        {
+          JsonValue const& p = primitives->elements[j];
+
+          GltfPrimitive primitive;
+
+          primitive.position = -1;
+          primitive.normal   = -1;
+          primitive.tangent  = -1;
+          primitive.texcoord = -1;
+          primitive.indices  = p.getInt("indices", -1);
+          primitive.mode     = p.getInt("mode", 4);
+          primitive.material = p.getInt("material", -1);
+
+          const JsonValue* attributes = p.find("attributes");
+          if (attributes != nullptr)
+          {
+            primitive.position = attributes->getInt("POSITION",   -1);
+            primitive.normal   = attributes->getInt("NORMAL",     -1);
+            primitive.tangent  = attributes->getInt("TANGENT",    -1);
+            primitive.texcoord = attributes->getInt("TEXCOORD_0", -1);
+          }
+
+          if (primitive.mode < 4 || 6 < primitive.mode)
+          {
+            continue; // Points and lines.
+          }
+          mesh.primitives.push_back(primitive);
+        }
+      }
+      m_meshes.push_back(mesh);
+    }
+  }
+
+  const JsonValue* nodes = root.find("nodes");
+  if (nodes != nullptr)
+  {
+    for (size_t i = 0; i < nodes->elements.size(); ++i)
+    {
+      JsonValue const& n = nodes->elements[i];
+
+      GltfNode node;
+
+      const JsonValue* name = n.find("name");
+      if (name != nullptr)
+      {
+        node.name = name->string;
+      }
+
+      node.mesh = n.getInt("mesh", -1);
+
+      float m[16];
+      if (n.getFloats("matrix", m, 16))
+      {
+        // glTF matrices are column-major.
+        for (int row = 0; row < 3; ++row)
+        {
+          for (int col = 0; col < 4; ++col)
+          {
+            node.matrix[row * 4 + col] = m[col * 4 + row];
+          }
+        }
+      }
+      else
+      {
+        float t[3] = { 0.0f, 0.0f, 0.0f };
+        float r[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        float s[3] = { 1.0f, 1.0f, 1.0f };
+
+        n.getFloats("translation", t, 3);
+        n.getFloats("rotation",    r, 4);
+        n.getFloats("scale",       s, 3);
+
+        composeTRS(t, r, s, node.matrix);
+      }
+
+      const JsonValue* children = n.find("children");
+      if (children != nullptr)
+      {
+        for (size_t j = 0; j < children->elements.size(); ++j)
+        {
+          const int child = static_cast<int>(children->elements[j].number);
+          if (child < 0 || static_cast<int>(nodes->elements.size()) <= child)
+          {
+            std::cerr << "ERROR: GltfLoader::parse() node " << i << " has an invalid child\n";
+            return false;
+          }
+          node.children.push_back(child);
+        }
+      }
+
+      const JsonValue* extensions = n.find("extensions");
+      const JsonValue* instancing = (extensions != nullptr) ? extensions->find("EXT_mesh_gpu_instancing") : nullptr;
+      const JsonValue* attributes = (instancing != nullptr) ? instancing->find("attributes") : nullptr;
+      if (attributes != nullptr && 0 <= node.mesh)
+      {
+        std::vector<float> translations;
+        std::vector<float> rotations;
+        std::vector<float> scales;
+
+        if (!readFloats(attributes->getInt("TRANSLATION", -1), 3, translations) ||
+            !readFloats(attributes->getInt("ROTATION",    -1), 4, rotations) ||
+            !readFloats(attributes->getInt("SCALE",       -1), 3, scales))
+        {
+          std::cerr << "ERROR: GltfLoader::parse() node " << i << " has invalid EXT_mesh_gpu_instancing attributes\n";
+          return false;
+        }
+
+        // All attributes have the same count. Missing ones are empty.
+        const size_t count = std::max(translations.size() / 3, std::max(rotations.size() / 4, scales.size() / 3));
+
+        node.instances.resize(count * 12);
+
+        for (size_t j = 0; j < count; ++j)
+        {
+          const float t[3] = { 0.0f, 0.0f, 0.0f };
+          const float r[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+          const float s[3] = { 1.0f, 1.0f, 1.0f };
+
+          composeTRS((j * 3 < translations.size()) ? &translations[j * 3] : t,
+                     (j * 4 < rotations.size())    ? &rotations[j * 4]    : r,
+                     (j * 3 < scales.size())       ? &scales[j * 3]       : s,
+                     &node.instances[j * 12]);
+        }
+      }
+
+      m_nodes.push_back(node);
+    }
+  }
+
+  // Without a scene the root nodes are all nodes which are nobody's child.
+  const JsonValue* scenes = root.find("scenes");
+  const int        scene  = root.getInt("scene", 0);
+
+  if (scenes != nullptr && 0 <= scene && scene < static_cast<int>(scenes->elements.size()))
+  {
+    const JsonValue* roots = scenes->elements[scene].find("nodes");
+    if (roots != nullptr)
+    {
+      for (size_t i = 0; i < roots->elements.size(); ++i)
+      {
+        const int index = static_cast<int>(roots->elements[i].number);
+        if (0 <= index && index < static_cast<int>(m_nodes.size()))
+        {
+          m_roots.push_back(index);
+        }
+      }
+    }
+  }
+  else
+  {
+    std::vector<bool> isChild(m_nodes.size(), false);
+
+    for (size_t i = 0; i < m_nodes.size(); ++i)
+    {
+      for (size_t j = 0; j < m_nodes[i].children.size(); ++j)
+      {
+        isChild[m_nodes[i].children[j]] = true;
+      }
+    }
+    for (size_t i = 0; i < m_nodes.size(); ++i)
+    {
+      if (!isChild[i])
+      {
+        m_roots.push_back(static_cast<int>(i));
+      }
+    }
+  }
+
+  return true;
+}
+
+
+const unsigned char* GltfLoader::getElements(Accessor const& accessor, size_t& stride) const
+{
+  if (accessor.bufferView < 0 || static_cast<int>(m_bufferViews.size()) <= accessor.bufferView)
+  {
+    return nullptr;
+  }
+
+  BufferView const& view = m_bufferViews[accessor.bufferView];
+
+  const size_t elementSize = getComponentSize(accessor.componentType) * accessor.numComponents;
+
+  stride = (view.stride != 0) ? view.stride : elementSize;
+
+  if (elementSize == 0 || stride < elementSize)
+  {
+    return nullptr;
+  }
+  // The last element must end inside the buffer view.
+  if (accessor.count != 0 &&
+      (view.length < accessor.offset || view.length - accessor.offset < elementSize || (view.length - accessor.offset - elementSize) / stride < accessor.count - 1))
+  {
+    return nullptr;
+  }
+
+  return m_buffers[view.buffer].data + view.offset + accessor.offset;
+}
+
+bool GltfLoader::readFloats(const int indexAccessor, const int numComponents, std::vector<float>& values) const
+{
+  values.clear();
+
+  if (indexAccessor < 0)
+  {
+    return true; // Optional attribute.
+  }
+  if (static_cast<int>(m_accessors.size()) <= indexAccessor || m_accessors[indexAccessor].numComponents != numComponents)
+  {
+    return false;
+  }
+
+  Accessor const& accessor = m_accessors[indexAccessor];
+
+  size_t stride = 0;
+  const unsigned char* src = getElements(accessor, stride);
+  if (src == nullptr)
+  {
+    return false;
+  }
+
+  values.resize(accessor.count * numComponents);
+
+  for (size_t i = 0; i < accessor.count; ++i)
+  {
+    readComponents(src + i * stride, accessor.componentType, accessor.normalized, numComponents, &values[i * numComponents]);
+  }
+  return true;
+}
+
+
+bool GltfLoader::readPrimitive(GltfPrimitive const& primitive, std::vector<TriangleAttributes>& attributes, std::vector<unsigned int>& indices) const
+{
+  attributes.clear();
+  indices.clear();
+
+  if (primitive.position < 0 || static_cast<int>(m_accessors.size()) <= primitive.position)
+  {
+    return false;
+  }
+
+  Accessor const& positions = m_accessors[primitive.position];
+
+  size_t stride = 0;
+  const unsigned char* src = getElements(positions, stride);
+  if (src == nullptr || positions.numComponents != 3)
+  {
+    return false;
+  }
+
+  const size_t numVertices = positions.count;
+
+  attributes.resize(numVertices);
+
+  // Each attribute is read by its own stride straight from the mapped buffer into its TriangleAttributes field.
+  for (size_t i = 0; i < numVertices; ++i)
+  {
+    readComponents(src + i * stride, positions.componentType, positions.normalized, 3, &attributes[i].vertex.x);
+
+    attributes[i].tangent  = make_float3(0.0f, 0.0f, 0.0f);
+    attributes[i].normal   = make_float3(0.0f, 0.0f, 0.0f);
+    attributes[i].texcoord = make_float3(0.0f, 0.0f, 0.0f);
+  }
+
+  const int optional[3]   = { primitive.normal, primitive.tangent, primitive.texcoord };
+  const int components[3] = { 3, 4, 2 };
+
+  for (int k = 0; k < 3; ++k)
+  {
+    if (optional[k] < 0)
+    {
+      continue;
+    }
+    if (static_cast<int>(m_accessors.size()) <= optional[k])
+    {
+      return false;
+    }
+
+    Accessor const& accessor = m_accessors[optional[k]];
+
+    src = getElements(accessor, stride);
+    if (src == nullptr || accessor.count != numVertices || accessor.numComponents != components[k])
+    {
+      return false;
+    }
+
+    for (size_t i = 0; i < numVertices; ++i)
+    {
+      float value[4];
+
+      readComponents(src + i * stride, accessor.componentType, accessor.normalized, components[k], value);
+
+      switch (k)
+      {
+        case 0:
+          attributes[i].normal = make_float3(value[0], value[1], value[2]);
+          break;
+        case 1:
+          attributes[i].tangent = make_float3(value[0], value[1], value[2]); // .w is the bitangent sign.
+          break;
+        case 2:
+          attributes[i].texcoord = make_float3(value[0], 1.0f - value[1], 0.0f); // glTF has the texture origin at the top left.
+          break;
+      }
+    }
+  }
+
+  // Vertex indices of the primitive in its own topology.
+  std::vector<unsigned int> vertices;
+
+  if (0 <= primitive.indices)
+  {
+    if (static_cast<int>(m_accessors.size()) <= primitive.indices)
+    {
+      return false;
+    }
+
+    Accessor const& accessor = m_accessors[primitive.indices];
+
+    src = getElements(accessor, stride);
+    if (src == nullptr || accessor.numComponents != 1 || accessor.componentType == GLTF_FLOAT)
+    {
+      return false;
+    }
+
+    vertices.resize(accessor.count);
+    for (size_t i = 0; i < accessor.count; ++i)
+    {
+      vertices[i] = readIndex(src + i * stride, accessor.componentType);
+      if (numVertices <= vertices[i])
+      {
+        return false;
+      }
+    }
+  }
+  else
+  {
+    vertices.resize(numVertices);
+    for (size_t i = 0; i < numVertices; ++i)
+    {
+      vertices[i] = static_cast<unsigned int>(i);
+    }
+  }
+
+  switch (primitive.mode)
+  {
+    case 4: // TRIANGLES
+      vertices.resize(vertices.size() - vertices.size() % 3);
+      indices.swap(vertices);
+      break;
+
+    case 5: // TRIANGLE_STRIP, every other triangle flips its winding.
+      indices.reserve((2 < vertices.size()) ? (vertices.size() - 2) * 3 : 0);
+      for (size_t i = 2; i < vertices.size(); ++i)
+      {
+        indices.push_back(vertices[i - 2]);
+        indices.push_back(vertices[(i & 1) ? i : i - 1]);
+        indices.push_back(vertices[(i & 1) ? i - 1 : i]);
+      }
+      break;
+
+    case 6: // TRIANGLE_FAN
+      indices.reserve((2 < vertices.size()) ? (vertices.size() - 2) * 3 : 0);
+      for (size_t i = 2; i < vertices.size(); ++i)
+      {
+        indices.push_back(vertices[0]);
+        indices.push_back(vertices[i - 1]);
+        indices.push_back(vertices[i]);
+      }
+      break;
+
+    default:
+      return false;
+  }
+
+  if (primitive.normal < 0 && !indices.empty())
+  {
+    calculateNormals(attributes, indices);
+  }
+
+  return true;
+}
@@ -0,0 +1,991 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/HostBVH.h"
+#include "inc/MyAssert.h"
+
+#include <dp/math/Batch.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <limits>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && 2 <= _M_IX86_FP)
+#define USE_BVH_SSE 1
+#include <xmmintrin.h>
+#else
+#define USE_BVH_SSE 0
+#endif
+
+
+static const int BVH_BINS            = 16;
+static const int BVH_MAX_DEPTH       = 48;    // Beyond this depth only median splits are used which bounds the traversal stack.
+static const int BVH_STACK_SIZE      = 256;   // A node pushes at most 3 more entries than it pops: 3 * (BVH_MAX_DEPTH + 16 median levels for 2^32 primitives) + 1.
+static const int BVH_PARALLEL_SIZE   = 32768; // Subtrees with at least this many primitives are built asynchronously.
+static const int BVH_PARALLEL_DEPTH  = 3;     // Limits the number of concurrent tasks to 4^3.
+
+static const float BVH_INFINITY = std::numeric_limits<float>::infinity();
+
+
+static void initAabb(BvhAabb& box)
+{
+  for (int i = 0; i < 3; ++i)
+  {
+    box.lo[i] =  BVH_INFINITY;
+    box.hi[i] = -BVH_INFINITY;
+  }
+}
+
+static void growAabb(BvhAabb& box, const float p[3])
+{
+  for (int i = 0; i < 3; ++i)
+  {
+    box.lo[i] = std::min(box.lo[i], p[i]);
+    box.hi[i] = std::max(box.hi[i], p[i]);
+  }
+}
+
+static void growAabb(BvhAabb& box, BvhAabb const& other)
+{
+  for (int i = 0; i < 3; ++i)
+  {
+    box.lo[i] = std::min(box.lo[i], other.lo[i]);
+    box.hi[i] = std::max(box.hi[i], other.hi[i]);
+  }
+}
+
+static bool isEmptyAabb(BvhAabb const& box)
+{
+  return box.hi[0] < box.lo[0] || box.hi[1] < box.lo[1] || box.hi[2] < box.lo[2];
+}
+
+static float getHalfArea(BvhAabb const& box)
+{
+  if (isEmptyAabb(box))
+  {
+    return 0.0f;
+  }
+  const float x = box.hi[0] - box.lo[0];
+  const float y = box.hi[1] - box.lo[1];
+  const float z = box.hi[2] - box.lo[2];
+  return x * y + y * z + z * x;
+}
+
+static void transformPoint(const float m[12], const float p[3], float r[3])
+{
+  r[0] = m[0] * p[0] + m[1] * p[1] + m[ 2] * p[2] + m[ 3];
+  r[1] = m[4] * p[0] + m[5] * p[1] + m[ 6] * p[2] + m[ 7];
+  r[2] = m[8] * p[0] + m[9] * p[1] + m[10] * p[2] + m[11];
+}
+
+static void transformVector(const float m[12], const float v[3], float r[3])
+{
+  r[0] = m[0] * v[0] + m[1] * v[1] + m[ 2] * v[2];
+  r[1] = m[4] * v[0] + m[5] * v[1] + m[ 6] * v[2];
+  r[2] = m[8] * v[0] + m[9] * v[1] + m[10] * v[2];
+}
+
+// Inverse of an affine row-major 3x4 matrix. Returns false for singular matrices.
+static bool invertMatrix(const float m[12], float r[12])
+{
+  const float c00 = m[5] * m[10] - m[6] * m[9];
+  const float c01 = m[6] * m[ 8] - m[4] * m[10];
+  const float c02 = m[4] * m[ 9] - m[5] * m[8];
+
+  const float det = m[0] * c00 + m[1] * c01 + m[2] * c02;
+
+  if (std::fabs(det) < 1.0e-20f)
+  {
+    return false;
+  }
+
+  const float invDet = 1.0f / det;
+
+  r[ 0] = c00 * invDet;
+  r[ 1] = (m[2] * m[9] - m[1] * m[10]) * invDet;
+  r[ 2] = (m[1] * m[6] - m[2] * m[ 5]) * invDet;
+  r[ 4] = c01 * invDet;
+  r[ 5] = (m[0] * m[10] - m[2] * m[8]) * invDet;
+  r[ 6] = (m[2] * m[ 4] - m[0] * m[6]) * invDet;
+  r[ 8] = c02 * invDet;
+  r[ 9] = (m[1] * m[8] - m[0] * m[9]) * invDet;
+  r[10] = (m[0] * m[5] - m[1] * m[4]) * invDet;
+
+  // Translation: -R^-1 * t
+  r[ 3] = -(r[0] * m[3] + r[1] * m[7] + r[ 2] * m[11]);
+  r[ 7] = -(r[4] * m[3] + r[5] * m[7] + r[ 6] * m[11]);
+  r[11] = -(r[8] * m[3] + r[9] * m[7] + r[10] * m[11]);
+
+  return true;
+}
+
+
+// Primitive reference used during the build.
+// PERF The bounds and centroid are partitioned together with the index to keep the memory accesses of the binning passes linear.
+struct BvhReference
+{
+  BvhAabb      box;
+  float        centroid[3];
+  unsigned int index;
+};
+
+// Builds a 4-wide BVH over primitive bounding boxes. Returns the primitive indices in leaf order, each leaf references a contiguous range.
+class Bvh4Builder
+{
+public:
+  Bvh4Builder(std::vector<BvhAabb> const& boxes, const int leafSize)
+  : m_leafSize(leafSize)
+  {
+    m_references.resize(boxes.size());
+    for (size_t i = 0; i < boxes.size(); ++i)
+    {
+      BvhReference& reference = m_references[i];
+
+      reference.box = boxes[i];
+      for (int j = 0; j < 3; ++j)
+      {
+        reference.centroid[j] = 0.5f * (boxes[i].lo[j] + boxes[i].hi[j]);
+      }
+      reference.index = static_cast<unsigned int>(i);
+    }
+  }
+
+  void build(std::vector<BvhNode4>& nodes, std::vector<unsigned int>& indices)
+  {
+    nodes.clear();
+    if (m_references.empty())
+    {
+      BvhNode4 root;
+      initNode(root);
+      nodes.push_back(root); // An empty root is never entered.
+    }
+    else
+    {
+      buildNode(0, m_references.size(), 0, nodes);
+    }
+
+    indices.resize(m_references.size());
+    for (size_t i = 0; i < m_references.size(); ++i)
+    {
+      indices[i] = m_references[i].index;
+    }
+  }
+
+private:
+  static void initNode(BvhNode4& node)
+  {
+    for (int i = 0; i < 4; ++i)
+    {
+      for (int j = 0; j < 3; ++j)
+      {
+        node.lo[j][i] = BVH_INFINITY;
+        node.hi[j][i] = BVH_INFINITY;
+      }
+      node.child[i] = -1;
+      node.count[i] = 0;
+    }
+  }
+
+  BvhAabb getBounds(const size_t begin, const size_t end) const
+  {
+    BvhAabb box;
+    initAabb(box);
+    for (size_t i = begin; i < end; ++i)
+    {
+      growAabb(box, m_references[i].box);
+    }
+    return box;
+  }
+
+  size_t splitMedian(const size_t begin, const size_t end, const int axis)
+  {
+    const size_t mid = begin + (end - begin) / 2;
+
+    std::nth_element(m_references.begin() + begin, m_references.begin() + mid, m_references.begin() + end, [axis](BvhReference const& a, BvhReference const& b)
+    {
+      return a.centroid[axis] < b.centroid[axis];
+    });
+    return mid;
+  }
+
+  // Binned SAH split. Returns the partition point inside (begin, end).
+  size_t split(const size_t begin, const size_t end, const int depth)
+  {
+    BvhAabb centroidBounds;
+    initAabb(centroidBounds);
+    for (size_t i = begin; i < end; ++i)
+    {
+      growAabb(centroidBounds, m_references[i].centroid);
+    }
+
+    int axisLargest = 0;
+    for (int axis = 1; axis < 3; ++axis)
+    {
+      if (centroidBounds.hi[axisLargest] - centroidBounds.lo[axisLargest] < centroidBounds.hi[axis] - centroidBounds.lo[axis])
+      {
+        axisLargest = axis;
+      }
+    }
+
+    if (BVH_MAX_DEPTH <= depth)
+    {
+      return splitMedian(begin, end, axisLargest);
+    }
+
+    float bestCost = BVH_INFINITY;
+    int   bestAxis = -1;
+    int   bestBin  = 0;
+
+    float scales[3];
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      const float extent = centroidBounds.hi[axis] - centroidBounds.lo[axis];
+      scales[axis] = (0.0f < extent) ? float(BVH_BINS) / extent : 0.0f;
+    }
+
+    // Bin all three axes in a single pass over the primitives.
+    BvhAabb      bins[3][BVH_BINS];
+    unsigned int counts[3][BVH_BINS];
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      for (int b = 0; b < BVH_BINS; ++b)
+      {
+        initAabb(bins[axis][b]);
+        counts[axis][b] = 0;
+      }
+    }
+
+    for (size_t i = begin; i < end; ++i)
+    {
+      BvhReference const& reference = m_references[i];
+
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        const int b = std::min(int((reference.centroid[axis] - centroidBounds.lo[axis]) * scales[axis]), BVH_BINS - 1);
+
+        growAabb(bins[axis][b], reference.box);
+        ++counts[axis][b];
+      }
+    }
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      if (scales[axis] == 0.0f)
+      {
+        continue;
+      }
+
+      // Sweep from the right to get the suffix areas, then from the left to evaluate the costs.
+      float        areaRight[BVH_BINS];
+      unsigned int countRight[BVH_BINS];
+
+      BvhAabb      box;
+      unsigned int count = 0;
+
+      initAabb(box);
+      for (int b = BVH_BINS - 1; 0 < b; --b)
+      {
+        growAabb(box, bins[axis][b]);
+        count += counts[axis][b];
+        areaRight[b]  = getHalfArea(box);
+        countRight[b] = count;
+      }
+
+      initAabb(box);
+      count = 0;
+      for (int b = 0; b < BVH_BINS - 1; ++b)
+      {
+        growAabb(box, bins[axis][b]);
+        count += counts[axis][b];
+
+        const float cost = getHalfArea(box) * float(count) + areaRight[b + 1] * float(countRight[b + 1]);
+        if (0 < count && 0 < countRight[b + 1] && cost < bestCost)
+        {
+          bestCost = cost;
+          bestAxis = axis;
+          bestBin  = b;
+        }
+      }
+    }
+
+    if (bestAxis < 0) // All centroids are identical.
+    {
+      return begin + (end - begin) / 2;
+    }
+
+    const float lo    = centroidBounds.lo[bestAxis];
+    const float scale = scales[bestAxis];
+
+    std::vector<BvhReference>::iterator it = std::partition(m_references.begin() + begin, m_references.begin() + end, [bestAxis, bestBin, lo, scale](BvhReference const& reference)
+    {
+      return std::min(int((reference.centroid[bestAxis] - lo) * scale), BVH_BINS - 1) <= bestBin;
+    });
+
+    const size_t mid = size_t(it - m_references.begin());
+    if (mid == begin || mid == end)
+    {
+      return splitMedian(begin, end, axisLargest);
+    }
+    return mid;
+  }
+
+  int buildNode(const size_t begin, const size_t end, const int depth, std::vector<BvhNode4>& nodes)
+  {
+    // Split the range up to three times to get four children.
+    size_t ranges[4][2] = { { begin, end } };
+    int    numRanges    = 1;
+
+    while (numRanges < 4)
+    {
+      int largest = -1;
+      for (int i = 0; i < numRanges; ++i)
+      {
+        const size_t count = ranges[i][1] - ranges[i][0];
+        if (size_t(m_leafSize) < count && (largest < 0 || ranges[largest][1] - ranges[largest][0] < count))
+        {
+          largest = i;
+        }
+      }
+      if (largest < 0)
+      {
+        break;
+      }
+      const size_t mid = split(ranges[largest][0], ranges[largest][1], depth);
+
+      ranges[numRanges][0] = mid;
+      ranges[numRanges][1] = ranges[largest][1];
+      ranges[largest][1]   = mid;
+      ++numRanges;
+    }
+
+    const int indexNode = static_cast<int>(nodes.size());
+    {
+      BvhNode4 node;
+      initNode(node);
+      nodes.push_back(node);
+    }
+
+    std::future< std::vector<BvhNode4> > futures[4];
+
+    for (int i = 0; i < numRanges; ++i)
+    {
+      const size_t childBegin = ranges[i][0];
+      const size_t childEnd   = ranges[i][1];
+
+      const BvhAabb box = getBounds(childBegin, childEnd);
+      for (int j = 0; j < 3; ++j)
+      {
+        nodes[indexNode].lo[j][i] = box.lo[j];
+        nodes[indexNode].hi[j][i] = box.hi[j];
+      }
+
+      if (childEnd - childBegin <= size_t(m_leafSize))
+      {
+        nodes[indexNode].child[i] = static_cast<int>(childBegin);
+        nodes[indexNode].count[i] = static_cast<int>(childEnd - childBegin);
+      }
+      else if (BVH_PARALLEL_SIZE <= childEnd - childBegin && depth < BVH_PARALLEL_DEPTH)
+      {
+        // The child ranges are disjoint, so the asynchronous builds can partition the shared reference array concurrently.
+        futures[i] = std::async(std::launch::async, [this, childBegin, childEnd, depth]()
+        {
+          std::vector<BvhNode4> subtree;
+          buildNode(childBegin, childEnd, depth + 1, subtree);
+          return subtree;
+        });
+      }
+      else
+      {
+        const int indexChild = buildNode(childBegin, childEnd, depth + 1, nodes);
+        nodes[indexNode].child[i] = indexChild;
+      }
+    }
+
+    // Append the asynchronously built subtrees and relocate their inner node indices.
+    for (int i = 0; i < numRanges; ++i)
+    {
+      if (futures[i].valid())
+      {
+        std::vector<BvhNode4> subtree = futures[i].get();
+
+        const int offset = static_cast<int>(nodes.size());
+        for (size_t n = 0; n < subtree.size(); ++n)
+        {
+          BvhNode4& node = subtree[n];
+          for (int c = 0; c < 4; ++c)
+          {
+            if (node.count[c] == 0 && 0 <= node.child[c])
+            {
+              node.child[c] += offset;
+            }
+          }
+        }
+        nodes.insert(nodes.end(), subtree.begin(), subtree.end());
+        nodes[indexNode].child[i] = offset; // The subtree root is its first node.
+      }
+    }
+
+    return indexNode;
+  }
+
+private:
+  std::vector<BvhReference> m_references;
+  int                       m_leafSize;
+};
+
+
+static inline float safeDirection(const float d)
+{
+  return (1.0e-20f < fabsf(d)) ? d : copysignf(1.0e-20f, d);
+}
+
+// Closest hit traversal of a 4-wide BVH. The leaf functor returns true when it shortened tmax.
+template <typename LeafFunctor>
+static bool traverseBvh4(std::vector<BvhNode4> const& nodes, const float org[3], const float dir[3], const float tmin, float& tmax, LeafFunctor const& leaf)
+{
+  // Zero direction components would produce 0 * inf = NaN in the slab test for origins exactly on a box plane.
+  const float invDir[3] = { 1.0f / safeDirection(dir[0]), 1.0f / safeDirection(dir[1]), 1.0f / safeDirection(dir[2]) };
+
+#if USE_BVH_SSE
+  const __m128 ox = _mm_set1_ps(org[0]);
+  const __m128 oy = _mm_set1_ps(org[1]);
+  const __m128 oz = _mm_set1_ps(org[2]);
+  const __m128 ix = _mm_set1_ps(invDir[0]);
+  const __m128 iy = _mm_set1_ps(invDir[1]);
+  const __m128 iz = _mm_set1_ps(invDir[2]);
+  const __m128 t0 = _mm_set1_ps(tmin);
+#endif
+
+  int stack[BVH_STACK_SIZE];
+  int top = 0;
+
+  stack[top++] = 0;
+
+  bool isHit = false;
+
+  while (0 < top)
+  {
+    BvhNode4 const& node = nodes[stack[--top]];
+
+    float tEntry[4];
+    int   mask = 0;
+
+#if USE_BVH_SSE
+    const __m128 lx = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.lo[0]), ox), ix);
+    const __m128 hx = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.hi[0]), ox), ix);
+    const __m128 ly = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.lo[1]), oy), iy);
+    const __m128 hy = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.hi[1]), oy), iy);
+    const __m128 lz = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.lo[2]), oz), iz);
+    const __m128 hz = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node.hi[2]), oz), iz);
+
+    const __m128 tNear = _mm_max_ps(_mm_max_ps(_mm_min_ps(lx, hx), _mm_min_ps(ly, hy)), _mm_max_ps(_mm_min_ps(lz, hz), t0));
+    const __m128 tFar  = _mm_min_ps(_mm_min_ps(_mm_max_ps(lx, hx), _mm_max_ps(ly, hy)), _mm_min_ps(_mm_max_ps(lz, hz), _mm_set1_ps(tmax)));
+
+    mask = _mm_movemask_ps(_mm_cmple_ps(tNear, tFar));
+    _mm_storeu_ps(tEntry, tNear);
+#else
+    for (int i = 0; i < 4; ++i)
+    {
+      float tNear = tmin;
+      float tFar  = tmax;
+      for (int j = 0; j < 3; ++j)
+      {
+        const float l = (node.lo[j][i] - org[j]) * invDir[j];
+        const float h = (node.hi[j][i] - org[j]) * invDir[j];
+        tNear = std::max(tNear, std::min(l, h));
+        tFar  = std::min(tFar,  std::max(l, h));
+      }
+      tEntry[i] = tNear;
+      if (tNear <= tFar)
+      {
+        mask |= 1 << i;
+      }
+    }
+#endif
+
+    // Collect the hit children sorted by entry distance.
+    int order[4];
+    int numHits = 0;
+
+    for (int i = 0; i < 4; ++i)
+    {
+      if ((mask & (1 << i)) && 0 <= node.child[i])
+      {
+        int j = numHits++;
+        while (0 < j && tEntry[i] < tEntry[order[j - 1]])
+        {
+          order[j] = order[j - 1];
+          --j;
+        }
+        order[j] = i;
+      }
+    }
+
+    // Leaves are intersected right away in front to back order, inner nodes are pushed back to front.
+    for (int k = 0; k < numHits; ++k)
+    {
+      const int i = order[k];
+      if (node.count[i] != 0 && tEntry[i] <= tmax)
+      {
+        isHit |= leaf(node.child[i], node.count[i], tmax);
+      }
+    }
+    for (int k = numHits - 1; 0 <= k; --k)
+    {
+      const int i = order[k];
+      if (node.count[i] == 0)
+      {
+        MY_ASSERT(top < BVH_STACK_SIZE);
+        stack[top++] = node.child[i];
+      }
+    }
+  }
+
+  return isHit;
+}
+
+
+// Moeller-Trumbore, double sided.
+static bool intersectTriangle(BvhTriangle const& tri, const float org[3], const float dir[3], const float tmin, float& t, float& u, float& v)
+{
+  const float p[3] = { dir[1] * tri.e2[2] - dir[2] * tri.e2[1],
+                       dir[2] * tri.e2[0] - dir[0] * tri.e2[2],
+                       dir[0] * tri.e2[1] - dir[1] * tri.e2[0] };
+
+  const float det = tri.e1[0] * p[0] + tri.e1[1] * p[1] + tri.e1[2] * p[2];
+  if (std::fabs(det) < 1.0e-20f)
+  {
+    return false;
+  }
+  const float invDet = 1.0f / det;
+
+  const float s[3] = { org[0] - tri.v0[0], org[1] - tri.v0[1], org[2] - tri.v0[2] };
+
+  const float b1 = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * invDet;
+  if (b1 < 0.0f || 1.0f < b1)
+  {
+    return false;
+  }
+
+  const float q[3] = { s[1] * tri.e1[2] - s[2] * tri.e1[1],
+                       s[2] * tri.e1[0] - s[0] * tri.e1[2],
+                       s[0] * tri.e1[1] - s[1] * tri.e1[0] };
+
+  const float b2 = (dir[0] * q[0] + dir[1] * q[1] + dir[2] * q[2]) * invDet;
+  if (b2 < 0.0f || 1.0f < b1 + b2)
+  {
+    return false;
+  }
+
+  const float d = (tri.e2[0] * q[0] + tri.e2[1] * q[1] + tri.e2[2] * q[2]) * invDet;
+  if (d < tmin || t <= d)
+  {
+    return false;
+  }
+
+  t = d;
+  u = b1;
+  v = b2;
+  return true;
+}
+
+
+static void buildMesh(BvhMesh& mesh)
+{
+  std::vector<BvhAabb> boxes(mesh.triangles.size());
+
+  initAabb(mesh.bounds);
+  for (size_t i = 0; i < mesh.triangles.size(); ++i)
+  {
+    BvhTriangle const& tri = mesh.triangles[i];
+
+    const float v1[3] = { tri.v0[0] + tri.e1[0], tri.v0[1] + tri.e1[1], tri.v0[2] + tri.e1[2] };
+    const float v2[3] = { tri.v0[0] + tri.e2[0], tri.v0[1] + tri.e2[1], tri.v0[2] + tri.e2[2] };
+
+    initAabb(boxes[i]);
+    growAabb(boxes[i], tri.v0);
+    growAabb(boxes[i], v1);
+    growAabb(boxes[i], v2);
+
+    growAabb(mesh.bounds, boxes[i]);
+  }
+
+  std::vector<unsigned int> indices;
+
+  Bvh4Builder builder(boxes, 4);
+  builder.build(mesh.nodes, indices);
+
+  // Reorder the triangles to the leaf order.
+  std::vector<BvhTriangle> triangles(mesh.triangles.size());
+  for (size_t i = 0; i < indices.size(); ++i)
+  {
+    triangles[i] = mesh.triangles[indices[i]];
+  }
+  mesh.triangles.swap(triangles);
+  mesh.primitives.swap(indices);
+}
+
+
+HostBVH::HostBVH()
+: m_isBuilt(false)
+{
+  initAabb(m_bounds);
+}
+
+void HostBVH::clear()
+{
+  m_meshes.clear();
+  m_instances.clear();
+  m_order.clear();
+  m_nodes.clear();
+  initAabb(m_bounds);
+  m_isBuilt = false;
+}
+
+void HostBVH::clearInstances()
+{
+  m_instances.clear();
+  m_order.clear();
+  m_nodes.clear();
+  initAabb(m_bounds);
+  m_isBuilt = false;
+}
+
+int HostBVH::addMesh(const float* positions, const size_t strideInBytes, const size_t numVertices, const unsigned int* indices, const size_t numIndices)
+{
+  BvhMesh mesh;
+
+  const size_t numTriangles = numIndices / 3;
+
+  mesh.triangles.reserve(numTriangles);
+
+  const unsigned char* base = reinterpret_cast<const unsigned char*>(positions);
+
+  for (size_t i = 0; i < numTriangles; ++i)
+  {
+    const unsigned int i0 = indices[i * 3    ];
+    const unsigned int i1 = indices[i * 3 + 1];
+    const unsigned int i2 = indices[i * 3 + 2];
+
+    if (numVertices <= i0 || numVertices <= i1 || numVertices <= i2)
+    {
+      continue; // Ignore invalid triangles. Keeps the primitive index mapping consistent because primitives stores the original index.
+    }
+
+    const float* p0 = reinterpret_cast<const float*>(base + i0 * strideInBytes);
+    const float* p1 = reinterpret_cast<const float*>(base + i1 * strideInBytes);
+    const float* p2 = reinterpret_cast<const float*>(base + i2 * strideInBytes);
+
+    BvhTriangle tri;
+    for (int j = 0; j < 3; ++j)
+    {
+      tri.v0[j] = p0[j];
+      tri.e1[j] = p1[j] - p0[j];
+      tri.e2[j] = p2[j] - p0[j];
+    }
+    mesh.triangles.push_back(tri);
+    mesh.primitives.push_back(static_cast<unsigned int>(i));
+  }
+
+  m_meshes.push_back(mesh);
+  m_isBuilt = false;
+
+  return static_cast<int>(m_meshes.size()) - 1;
+}
+
+int HostBVH::addInstance(const int mesh, const float matrix[12])
+{
+  BvhInstance instance;
+
+  instance.mesh = mesh;
+  memcpy(instance.matrix, matrix, sizeof(float) * 12);
+  instance.valid = invertMatrix(matrix, instance.inverse);
+  initAabb(instance.bounds);
+
+  m_instances.push_back(instance);
+  m_isBuilt = false;
+
+  return static_cast<int>(m_instances.size()) - 1;
+}
+
+void HostBVH::removeMesh(const int mesh)
+{
+  if (0 <= mesh && mesh < int(m_meshes.size()))
+  {
+    m_meshes[mesh] = BvhMesh(); // Empty meshes are invalid in build().
+    m_meshes[mesh].isBuilt = true;
+    initAabb(m_meshes[mesh].bounds);
+    m_isBuilt = false;
+  }
+}
+
+void HostBVH::build()
+{
+  // Build the new mesh BVHs in parallel. Each mesh builder additionally parallelizes its own big subtrees.
+  std::vector<size_t> pending;
+  for (size_t i = 0; i < m_meshes.size(); ++i)
+  {
+    if (!m_meshes[i].isBuilt)
+    {
+      pending.push_back(i);
+    }
+  }
+
+  const size_t numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+  std::vector< std::future<void> > futures;
+  for (size_t t = 0; t < std::min(numThreads, pending.size()); ++t)
+  {
+    futures.push_back(std::async(std::launch::async, [this, t, numThreads, &pending]()
+    {
+      for (size_t j = t; j < pending.size(); j += numThreads)
+      {
+        BvhMesh& mesh = m_meshes[pending[j]];
+
+        // The mesh primitives were filled in addMesh() with the original triangle indices. buildMesh() replaces them with the leaf order.
+        std::vector<unsigned int> original;
+        original.swap(mesh.primitives);
+
+        buildMesh(mesh);
+
+        for (size_t p = 0; p < mesh.primitives.size(); ++p)
+        {
+          mesh.primitives[p] = original[mesh.primitives[p]];
+        }
+        mesh.isBuilt = true;
+      }
+    }));
+  }
+  for (size_t i = 0; i < futures.size(); ++i)
+  {
+    futures[i].get();
+  }
+
+  // World space instance bounds from the eight transformed corners of the mesh bounds.
+  std::vector<BvhAabb> boxes(m_instances.size());
+
+  initAabb(m_bounds);
+  m_order.clear();
+
+  for (size_t i = 0; i < m_instances.size(); ++i)
+  {
+    BvhInstance& instance = m_instances[i];
+
+    initAabb(instance.bounds);
+
+    if (instance.mesh < 0 || int(m_meshes.size()) <= instance.mesh || m_meshes[instance.mesh].triangles.empty())
+    {
+      instance.valid = false;
+    }
+    if (instance.valid)
+    {
+      BvhAabb const& box = m_meshes[instance.mesh].bounds;
+
+      float corners[8][3];
+      for (int c = 0; c < 8; ++c)
+      {
+        corners[c][0] = (c & 1) ? box.hi[0] : box.lo[0];
+        corners[c][1] = (c & 2) ? box.hi[1] : box.lo[1];
+        corners[c][2] = (c & 4) ? box.hi[2] : box.lo[2];
+      }
+      dp::math::calculateBounds(instance.matrix, corners[0], sizeof(float) * 3, 8, instance.bounds.lo, instance.bounds.hi);
+      growAabb(m_bounds, instance.bounds);
+
+      boxes[m_order.size()] = instance.bounds;
+      m_order.push_back(static_cast<unsigned int>(i));
+    }
+  }
+  boxes.resize(m_order.size());
+
+  // The top-level builder returns indices into boxes, map them back to the instance indices afterwards.
+  std::vector<unsigned int> indices;
+
+  Bvh4Builder builder(boxes, 2);
+  builder.build(m_nodes, indices);
+
+  for (size_t i = 0; i < indices.size(); ++i)
+  {
+    indices[i] = m_order[indices[i]];
+  }
+  m_order.swap(indices);
+
+  m_isBuilt = true;
+}
+
+bool HostBVH::intersectInstance(BvhInstance const& instance, BvhRay const& ray, float& tmax, BvhHit& hit, const bool bruteForce) const
+{
+  // The object space direction is not normalized, so the ray parameter t is identical in both spaces.
+  float org[3];
+  float dir[3];
+
+  transformPoint(instance.inverse, ray.org, org);
+  transformVector(instance.inverse, ray.dir, dir);
+
+  BvhMesh const& mesh = m_meshes[instance.mesh];
+
+  float        u = 0.0f;
+  float        v = 0.0f;
+  unsigned int primitive = 0;
+
+  bool isHit = false;
+
+  if (bruteForce)
+  {
+    for (size_t i = 0; i < mesh.triangles.size(); ++i)
+    {
+      if (intersectTriangle(mesh.triangles[i], org, dir, ray.tmin, tmax, u, v))
+      {
+        primitive = static_cast<unsigned int>(i);
+        isHit = true;
+      }
+    }
+  }
+  else
+  {
+    isHit = traverseBvh4(mesh.nodes, org, dir, ray.tmin, tmax, [&](const int first, const int count, float& t)
+    {
+      bool isHitLeaf = false;
+      for (int i = first; i < first + count; ++i)
+      {
+        if (intersectTriangle(mesh.triangles[i], org, dir, ray.tmin, t, u, v))
+        {
+          primitive = static_cast<unsigned int>(i);
+          isHitLeaf = true;
+        }
+      }
+      return isHitLeaf;
+    });
+  }
+
+  if (isHit)
+  {
+    hit.t         = tmax;
+    hit.primitive = mesh.primitives[primitive];
+    hit.u         = u;
+    hit.v         = v;
+  }
+  return isHit;
+}
+
+bool HostBVH::intersect(BvhRay const& ray, BvhHit& hit) const
+{
+  hit.t        = ray.tmax;
+  hit.instance = -1;
+
+  if (!m_isBuilt || m_order.empty())
+  {
+    return false;
+  }
+
+  float tmax = ray.tmax;
+
+  return traverseBvh4(m_nodes, ray.org, ray.dir, ray.tmin, tmax, [&](const int first, const int count, float& t)
+  {
+    bool isHitLeaf = false;
+    for (int i = first; i < first + count; ++i)
+    {
+      const unsigned int index = m_order[i];
+      if (intersectInstance(m_instances[index], ray, t, hit, false))
+      {
+        hit.instance = static_cast<int>(index);
+        isHitLeaf = true;
+      }
+    }
+    return isHitLeaf;
+  });
+}
+
+bool HostBVH::intersectBruteForce(BvhRay const& ray, BvhHit& hit) const
+{
+  hit.t        = ray.tmax;
+  hit.instance = -1;
+
+  float tmax = ray.tmax;
+
+  for (size_t i = 0; i < m_instances.size(); ++i)
+  {
+    BvhInstance const& instance = m_instances[i];
+
+    if (instance.valid && 0 <= instance.mesh && instance.mesh < int(m_meshes.size()) &&
+        intersectInstance(instance, ray, tmax, hit, true))
+    {
+      hit.instance = static_cast<int>(i);
+    }
+  }
+  return 0 <= hit.instance;
+}
+
+bool HostBVH::getBounds(BvhAabb& bounds) const
+{
+  bounds = m_bounds;
+  return m_isBuilt && !isEmptyAabb(m_bounds);
+}
+
+bool HostBVH::getInstanceBounds(const int instance, BvhAabb& bounds) const
+{
+  if (!m_isBuilt || instance < 0 || int(m_instances.size()) <= instance || !m_instances[instance].valid)
+  {
+    return false;
+  }
+  bounds = m_instances[instance].bounds;
+  return true;
+}
+
+size_t HostBVH::getNumInstances() const
+{
+  return m_instances.size();
+}
+
+size_t HostBVH::getMemoryUsage() const
+{
+  size_t bytes = m_meshes.capacity() * sizeof(BvhMesh) + m_instances.capacity() * sizeof(BvhInstance) +
+                 m_order.capacity() * sizeof(unsigned int) + m_nodes.capacity() * sizeof(BvhNode4);
+
+  for (BvhMesh const& mesh : m_meshes)
+  {
+    bytes += mesh.triangles.capacity() * sizeof(BvhTriangle) + mesh.primitives.capacity() * sizeof(unsigned int) + mesh.nodes.capacity() * sizeof(BvhNode4);
+  }
+  return bytes;
+}
+
+size_t HostBVH::getNumTriangles() const
+{
+  size_t count = 0;
+  for (size_t i = 0; i < m_instances.size(); ++i)
+  {
+    if (0 <= m_instances[i].mesh && m_instances[i].mesh < int(m_meshes.size()))
+    {
+      count += m_meshes[m_instances[i].mesh].triangles.size();
+    }
+  }
+  return count;
+}
@@ -0,0 +1,395 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/InputTrace.h"
+
+#include "inc/Parser.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "inc/MyAssert.h"
+
+
+// Keywords of the trace file. Indexed by InputEventType.
+static const char* g_inputEventNames[] =
+{
+  "base",
+  "orbit",
+  "dolly",
+  "pan",
+  "zoom",
+  "focus",
+  "select",
+  "frame",
+  "parameter",
+  "end"
+};
+
+
+InputTrace::InputTrace()
+: m_isRecording(false)
+, m_frame(0)
+{
+}
+
+void InputTrace::startRecording()
+{
+  m_events.clear();
+
+  m_frame       = 0;
+  m_isRecording = true;
+
+  m_timer.restart();
+}
+
+bool InputTrace::isRecording() const
+{
+  return m_isRecording;
+}
+
+void InputTrace::nextFrame()
+{
+  if (m_isRecording)
+  {
+    ++m_frame;
+  }
+}
+
+void InputTrace::record(const InputEventType type, const int x, const int y, const float value)
+{
+  if (m_isRecording)
+  {
+    InputEvent event;
+
+    event.frame = m_frame;
+    event.time  = m_timer.getTime();
+    event.type  = type;
+    event.x     = x;
+    event.y     = y;
+    event.value = value;
+
+    m_events.push_back(event);
+  }
+}
+
+bool InputTrace::save(std::string const& filename)
+{
+  if (m_isRecording)
+  {
+    record(INPUT_EVENT_END, 0, 0, 0.0f);
+    m_isRecording = false;
+  }
+
+  std::ofstream stream(filename);
+
+  if (!stream)
+  {
+    std::cerr << "ERROR: InputTrace::save() Failed to open file " << filename << '\n';
+    return false;
+  }
+
+  // The trace uses the same syntax as the system and scene description files.
+  // Times are written in microseconds resolution, the values with enough digits to load the identical float again.
+  stream << "# rtigo3 input trace: <event> <frame> <seconds> <x> <y> <value>\n";
+  for (InputEvent const& event : m_events)
+  {
+    stream << g_inputEventNames[event.type] << ' ' << event.frame << ' ';
+    stream.setf(std::ios_base::fixed, std::ios_base::floatfield);
+    stream.precision(6);
+    stream << event.time << ' ' << event.x << ' ' << event.y << ' ';
+    stream.unsetf(std::ios_base::floatfield);
+    stream.precision(9);
+    stream << event.value << '\n';
+  }
+
+  if (stream.fail())
+  {
+    std::cerr << "ERROR: InputTrace::save() Failed to write file " << filename << '\n';
+    return false;
+  }
+  return true;
+}
+
+bool InputTrace::load(std::string const& filename)
+{
+  Parser parser;
+
+  if (!parser.load(filename))
+  {
+    return false;
+  }
+
+  m_events.clear();
+  m_isRecording = false;
+
+  ParserTokenType tokenType;
+  std::string token;
+
+  while ((tokenType = parser.getNextToken(token)) != PTT_EOF)
+  {
+    if (tokenType != PTT_ID)
+    {
+      std::cerr << "ERROR: InputTrace::load() " << filename << " (" << parser.getLine() << "): Expected an event name.\n";
+      return false;
+    }
+
+    const int numTypes = int(sizeof(g_inputEventNames) / sizeof(g_inputEventNames[0]));
+
+    int type = 0;
+    while (type < numTypes && token != g_inputEventNames[type])
+    {
+      ++type;
+    }
+    if (type == numTypes)
+    {
+      std::cerr << "ERROR: InputTrace::load() " << filename << " (" << parser.getLine() << "): Unknown event " << token << '\n';
+      return false;
+    }
+
+    double values[5];
+    for (int i = 0; i < 5; ++i)
+    {
+      tokenType = parser.getNextToken(token);
+      if (tokenType != PTT_VAL)
+      {
+        std::cerr << "ERROR: InputTrace::load() " << filename << " (" << parser.getLine() << "): Expected five values.\n";
+        return false;
+      }
+      values[i] = atof(token.c_str());
+    }
+
+    InputEvent event;
+
+    event.frame = static_cast<unsigned int>(values[0]);
+    event.time  = values[1];
+    event.type  = static_cast<InputEventType>(type);
+    event.x     = static_cast<int>(values[2]);
+    event.y     = static_cast<int>(values[3]);
+    event.value = static_cast<float>(values[4]);
+
+    if (event.type == INPUT_EVENT_PARAMETER && (event.x < 0 || NUM_INPUT_PARAMETERS <= event.x))
+    {
+      std::cerr << "ERROR: InputTrace::load() " << filename << " (" << parser.getLine() << "): Unknown parameter " << event.x << '\n';
+      return false;
+    }
+
+    m_events.push_back(event);
+  }
+
+  if (m_events.empty() || m_events.back().type != INPUT_EVENT_END)
+  {
+    std::cerr << "ERROR: InputTrace::load() " << filename << ": Trace doesn't end with an end event.\n";
+    return false;
+  }
+  return true;
+}
+
+std::vector<InputEvent> const& InputTrace::getEvents() const
+{
+  return m_events;
+}
+
+
+InputReplay::InputReplay(std::vector<InputEvent> const& events, const bool realtime)
+: m_events(events)
+, m_realtime(realtime)
+, m_next(0)
+, m_frame(0)
+, m_lastFrame(0)
+, m_lastTime(0.0)
+, m_isFinished(false)
+, m_restarts(0)
+{
+  // InputTrace::load() guarantees the end event, but traces built in code might not have one.
+  for (InputEvent const& event : m_events)
+  {
+    m_lastFrame = std::max(m_lastFrame, event.frame);
+    m_lastTime  = std::max(m_lastTime, event.time);
+  }
+}
+
+bool InputReplay::isFinished() const
+{
+  return m_isFinished;
+}
+
+void InputReplay::nextFrame(const unsigned int iterationIndex, const unsigned int restarts, std::vector<InputEvent>& events)
+{
+  events.clear();
+
+  if (m_isFinished)
+  {
+    return;
+  }
+
+  if (m_frame == 0)
+  {
+    m_timer.restart();
+  }
+  else // End the previous frame.
+  {
+    ReplayFrame& frame = m_frames.back();
+
+    frame.seconds   = m_timerFrame.getTime();
+    frame.iteration = iterationIndex;
+    frame.restarted = (restarts != m_restarts);
+
+    // The frame before the restarted one holds the number of iterations the interaction interrupted.
+    if (frame.restarted && 2 <= m_frames.size())
+    {
+      m_samplesBetweenRestarts.push_back(m_frames[m_frames.size() - 2].iteration);
+    }
+  }
+  m_restarts = restarts;
+
+  const bool isDone = (m_realtime) ? (m_next == m_events.size() && m_lastTime <= m_timer.getTime())
+                                   : (m_lastFrame < m_frame);
+  if (isDone)
+  {
+    m_isFinished = true;
+    return;
+  }
+
+  const double time = m_timer.getTime();
+
+  while (m_next < m_events.size() && ((m_realtime) ? m_events[m_next].time <= time : m_events[m_next].frame <= m_frame))
+  {
+    if (m_events[m_next].type != INPUT_EVENT_END)
+    {
+      events.push_back(m_events[m_next]);
+    }
+    ++m_next;
+  }
+
+  ReplayFrame frame;
+
+  frame.seconds   = 0.0;
+  frame.events    = static_cast<unsigned int>(events.size());
+  frame.iteration = 0;
+  frame.restarted = false;
+
+  m_frames.push_back(frame);
+
+  ++m_frame;
+
+  m_timerFrame.restart();
+}
+
+// Nearest rank percentile of an unsorted copy.
+static double percentile(std::vector<double> values, const double p)
+{
+  if (values.empty())
+  {
+    return 0.0;
+  }
+  std::sort(values.begin(), values.end());
+
+  const size_t index = std::min(values.size() - 1, static_cast<size_t>(p * double(values.size())));
+  return values[index];
+}
+
+std::string InputReplay::getReport() const
+{
+  std::vector<double> all;
+  std::vector<double> interactions;
+
+  double seconds = 0.0;
+
+  // The last frame is still open while the replay runs.
+  const size_t count = (m_isFinished) ? m_frames.size() : m_frames.size() - std::min(m_frames.size(), size_t(1));
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    all.push_back(m_frames[i].seconds * 1000.0);
+    if (0 < m_frames[i].events)
+    {
+      interactions.push_back(m_frames[i].seconds * 1000.0);
+    }
+    seconds += m_frames[i].seconds;
+  }
+
+  unsigned int minSamples = 0;
+  unsigned int maxSamples = 0;
+  double       sumSamples = 0.0;
+  if (!m_samplesBetweenRestarts.empty())
+  {
+    minSamples = *std::min_element(m_samplesBetweenRestarts.begin(), m_samplesBetweenRestarts.end());
+    maxSamples = *std::max_element(m_samplesBetweenRestarts.begin(), m_samplesBetweenRestarts.end());
+    for (const unsigned int s : m_samplesBetweenRestarts)
+    {
+      sumSamples += double(s);
+    }
+  }
+
+  std::ostringstream stream;
+
+  stream.precision(3);
+  stream << std::fixed;
+  stream << "replay (" << ((m_realtime) ? "realtime" : "frame locked") << "): " << count << " frames in " << seconds << " s = "
+         << ((0.0 < seconds) ? double(count) / seconds : 0.0) << " fps\n";
+  stream << "  frame ms:       median " << percentile(all, 0.5) << ", p95 " << percentile(all, 0.95) << ", max " << percentile(all, 1.0) << '\n';
+  stream << "  interaction ms: median " << percentile(interactions, 0.5) << ", p95 " << percentile(interactions, 0.95) << ", max " << percentile(interactions, 1.0)
+         << " (" << interactions.size() << " frames)\n";
+  stream << "  restarts " << m_samplesBetweenRestarts.size() << ", samples between restarts: mean "
+         << ((m_samplesBetweenRestarts.empty()) ? 0.0 : sumSamples / double(m_samplesBetweenRestarts.size()))
+         << ", min " << minSamples << ", max " << maxSamples
+         << ", final " << ((0 < count) ? m_frames[count - 1].iteration : 0) << '\n';
+
+  return stream.str();
+}
+
+bool InputReplay::saveFrames(std::string const& filename) const
+{
+  std::ofstream stream(filename);
+
+  if (!stream)
+  {
+    std::cerr << "ERROR: InputReplay::saveFrames() Failed to open file " << filename << '\n';
+    return false;
+  }
+
+  stream << "frame,milliseconds,events,iteration,restarted\n";
+  stream.precision(3);
+  for (size_t i = 0; i < m_frames.size(); ++i)
+  {
+    ReplayFrame const& frame = m_frames[i];
+
+    stream << i << ',' << std::fixed << frame.seconds * 1000.0 << ',' << frame.events << ',' << frame.iteration << ',' << ((frame.restarted) ? 1 : 0) << '\n';
+  }
+
+  return !stream.fail();
+}
+
+std::vector<ReplayFrame> const& InputReplay::getFrames() const
+{
+  return m_frames;
+}
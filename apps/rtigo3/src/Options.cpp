@@ -35,6 +35,7 @@ Options::Options()
 , m_height(512)
 , m_mode(0)
 , m_optimize(false)
+, m_realtime(false)
 {
 }
 
@@ -107,6 +108,30 @@ bool Options::parseCommandLine(int argc, char *argv[])
       }
       m_filenameScene = std::string(argv[++i]);
     }
+    else if (arg == "-r" || arg == "--record")
+    {
+      if (i == argc - 1)
+      { 
+        std::cerr << "Option '" << arg << "' requires additional argument.\n";
+        printUsage(argv[0]);
+        return false;
+      }
+      m_filenameRecord = std::string(argv[++i]);
+    }
+    else if (arg == "-p" || arg == "--replay")
+    {
+      if (i == argc - 1)
+      { 
+        std::cerr << "Option '" << arg << "' requires additional argument.\n";
+        printUsage(argv[0]);
+        return false;
+      }
+      m_filenameReplay = std::string(argv[++i]);
+    }
+    else if (arg == "-t" || arg == "--realtime")
+    {
+      m_realtime = true;
+    }
     else
     {
       std::cerr << "Unknown option '" << arg << "'\n";
@@ -129,6 +154,13 @@ bool Options::parseCommandLine(int argc, char *argv[])
     return false;
   }
 
+  if (m_mode == 2 && m_filenameReplay.empty())
+  {
+    std::cerr << "ERROR: Options::parseCommandLine() Replay mode 2 requires an input trace filename.\n";
+    printUsage(argv[0]);
+    return false;
+  }
+
   return true;
 }
 
@@ -162,6 +194,21 @@ std::string Options::getScene() const
   return m_filenameScene;
 }
 
+std::string Options::getRecord() const
+{
+  return m_filenameRecord;
+}
+
+std::string Options::getReplay() const
+{
+  return m_filenameReplay;
+}
+
+bool Options::getRealtime() const
+{
+  return m_realtime;
+}
+
 
 void Options::printUsage(std::string const& argv0)
 {
@@ -171,10 +218,13 @@ void Options::printUsage(std::string const& argv0)
     "   ? | help | --help       Print this usage message and exit.\n"
     "  -w | --width <int>       Width of the client window  (512) \n"
     "  -h | --height <int>      Height of the client window (512)\n"
-    "  -m | --mode <int>        0 = interactive, 1 == benchmark (0)\n"
+    "  -m | --mode <int>        0 = interactive, 1 == benchmark, 2 == replay without GUI (0)\n"
     "  -o | --optimize          Optimize the assimp scene graph (false)\n"
     "  -s | --system <filename> Filename for system options (empty).\n"
     "  -d | --desc   <filename> Filename for scene description (empty).\n"
+    "  -r | --record <filename> Record the camera interactions into an input trace file (empty).\n"
+    "  -p | --replay <filename> Replay an input trace file and print its latency statistics (empty).\n"
+    "  -t | --realtime          Replay at the recorded timing instead of frame by frame (false).\n"
   "App Keystrokes:\n"
   "  SPACE  Toggles GUI display.\n";
 }
@@ -0,0 +1,296 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/ParameterChannel.h"
+
+#include "inc/CheckMacros.h"
+
+
+// Only the values the devices upload are compared. The names of the materials and the padding of the lights are not.
+static bool isEqual(CameraDefinition const& a, CameraDefinition const& b)
+{
+  return a.P.x == b.P.x && a.P.y == b.P.y && a.P.z == b.P.z &&
+         a.U.x == b.U.x && a.U.y == b.U.y && a.U.z == b.U.z &&
+         a.V.x == b.V.x && a.V.y == b.V.y && a.V.z == b.V.z &&
+         a.W.x == b.W.x && a.W.y == b.W.y && a.W.z == b.W.z;
+}
+
+static bool isEqual(float3 const& a, float3 const& b)
+{
+  return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+static bool isEqual(LightDefinition const& a, LightDefinition const& b)
+{
+  return a.type == b.type && isEqual(a.position, b.position) && isEqual(a.vecU, b.vecU) && isEqual(a.vecV, b.vecV) &&
+         isEqual(a.normal, b.normal) && a.area == b.area && isEqual(a.emission, b.emission);
+}
+
+static bool isEqual(MaterialGUI const& a, MaterialGUI const& b)
+{
+  return a.indexBSDF == b.indexBSDF && isEqual(a.albedo, b.albedo) && isEqual(a.absorptionColor, b.absorptionColor) &&
+         a.absorptionScale == b.absorptionScale && a.roughness.x == b.roughness.x && a.roughness.y == b.roughness.y &&
+         a.ior == b.ior && a.thinwalled == b.thinwalled && a.useAlbedoTexture == b.useAlbedoTexture && a.useCutoutTexture == b.useCutoutTexture;
+}
+
+// Appends the indices of the entries in current which are new or differ from previous.
+template <typename T>
+static void diffSection(std::vector<T> const* previous, std::vector<T> const& current, std::vector<int>& changed)
+{
+  for (size_t i = 0; i < current.size(); ++i)
+  {
+    if (previous == nullptr || previous->size() <= i || !isEqual((*previous)[i], current[i]))
+    {
+      changed.push_back(static_cast<int>(i));
+    }
+  }
+}
+
+// Copy-on-write of a section for the edits until the next publish().
+template <typename T>
+static std::vector<T>& editSection(std::shared_ptr<std::vector<T>>& pending, std::shared_ptr<const std::vector<T>> const& published)
+{
+  if (!pending)
+  {
+    pending = std::make_shared<std::vector<T>>(*published);
+  }
+  return *pending;
+}
+
+
+ParameterChannel::ParameterChannel()
+{
+  ParameterSnapshot* snapshot = new ParameterSnapshot;
+
+  snapshot->version   = 0;
+  snapshot->cameras   = std::make_shared<std::vector<CameraDefinition>>();
+  snapshot->lights    = std::make_shared<std::vector<LightDefinition>>();
+  snapshot->materials = std::make_shared<std::vector<MaterialGUI>>();
+
+  m_latest.store(snapshot);
+
+  for (int i = 0; i < MAX_PARAMETER_CONSUMERS; ++i)
+  {
+    m_consumers[i].acquired.store(nullptr);
+    m_consumers[i].acquiring.store(nullptr);
+  }
+}
+
+ParameterChannel::~ParameterChannel()
+{
+  // All consumers must be done.
+  for (const ParameterSnapshot* snapshot : m_retired)
+  {
+    delete snapshot;
+  }
+  delete m_latest.load();
+}
+
+
+void ParameterChannel::setState(DeviceState const& state)
+{
+  m_state = std::make_shared<DeviceState>(state);
+}
+
+void ParameterChannel::setCameras(std::vector<CameraDefinition> const& cameras)
+{
+  m_cameras = std::make_shared<std::vector<CameraDefinition>>(cameras);
+}
+
+void ParameterChannel::setCamera(const int id, CameraDefinition const& camera)
+{
+  std::vector<CameraDefinition>& cameras = editSection(m_cameras, m_latest.load()->cameras);
+
+  MY_ASSERT(0 <= id && id < static_cast<int>(cameras.size()));
+  cameras[id] = camera;
+}
+
+void ParameterChannel::setLights(std::vector<LightDefinition> const& lights)
+{
+  m_lights = std::make_shared<std::vector<LightDefinition>>(lights);
+}
+
+void ParameterChannel::setLight(const int id, LightDefinition const& light)
+{
+  std::vector<LightDefinition>& lights = editSection(m_lights, m_latest.load()->lights);
+
+  MY_ASSERT(0 <= id && id < static_cast<int>(lights.size()));
+  lights[id] = light;
+}
+
+void ParameterChannel::setMaterials(std::vector<MaterialGUI> const& materials)
+{
+  m_materials = std::make_shared<std::vector<MaterialGUI>>(materials);
+}
+
+void ParameterChannel::setMaterial(const int id, MaterialGUI const& material)
+{
+  std::vector<MaterialGUI>& materials = editSection(m_materials, m_latest.load()->materials);
+
+  MY_ASSERT(0 <= id && id < static_cast<int>(materials.size()));
+  materials[id] = material;
+}
+
+
+bool ParameterChannel::publish()
+{
+  if (!m_state && !m_cameras && !m_lights && !m_materials)
+  {
+    return false;
+  }
+
+  const ParameterSnapshot* previous = m_latest.load();
+
+  ParameterSnapshot* snapshot = new ParameterSnapshot(*previous); // Shares all sections.
+
+  snapshot->version = previous->version + 1;
+
+  if (m_state)
+  {
+    snapshot->state = m_state;
+  }
+  if (m_cameras)
+  {
+    snapshot->cameras = m_cameras;
+  }
+  if (m_lights)
+  {
+    snapshot->lights = m_lights;
+  }
+  if (m_materials)
+  {
+    snapshot->materials = m_materials;
+  }
+
+  // Further edits must not change the published sections.
+  m_state.reset();
+  m_cameras.reset();
+  m_lights.reset();
+  m_materials.reset();
+
+  m_latest.store(snapshot);
+
+  m_retired.push_back(previous);
+  reclaim();
+
+  return true;
+}
+
+unsigned int ParameterChannel::getVersion() const
+{
+  return m_latest.load()->version;
+}
+
+
+// Deletes the retired snapshots no consumer holds anymore.
+// The consumers publish their hazard before they validate it against m_latest, and m_latest is stored before this scan,
+// so a snapshot which is not found here can't be picked up by any consumer later.
+void ParameterChannel::reclaim()
+{
+  size_t count = 0;
+
+  for (const ParameterSnapshot* snapshot : m_retired)
+  {
+    bool isHeld = false;
+
+    for (int i = 0; i < MAX_PARAMETER_CONSUMERS && !isHeld; ++i)
+    {
+      isHeld = (m_consumers[i].acquired.load() == snapshot || m_consumers[i].acquiring.load() == snapshot);
+    }
+
+    if (isHeld)
+    {
+      m_retired[count++] = snapshot;
+    }
+    else
+    {
+      delete snapshot;
+    }
+  }
+
+  m_retired.resize(count);
+}
+
+
+bool ParameterChannel::acquire(const int consumer, ParameterDiff& diff)
+{
+  MY_ASSERT(0 <= consumer && consumer < MAX_PARAMETER_CONSUMERS);
+
+  Consumer& slot = m_consumers[consumer];
+
+  const ParameterSnapshot* previous = slot.acquired.load(std::memory_order_relaxed); // Only written by this consumer.
+  const ParameterSnapshot* latest   = m_latest.load();
+
+  if (latest == previous)
+  {
+    return false;
+  }
+
+  // Retry until the protected snapshot is still the latest one after publishing the hazard.
+  // Otherwise the producer could have retired and deleted it in between. This only repeats while the producer publishes.
+  for (;;)
+  {
+    slot.acquiring.store(latest);
+
+    const ParameterSnapshot* check = m_latest.load();
+    if (check == latest)
+    {
+      break;
+    }
+    latest = check;
+  }
+
+  diff.snapshot     = latest;
+  diff.isDirtyState = false;
+  diff.cameras.clear();
+  diff.lights.clear();
+  diff.materials.clear();
+
+  if (latest->state && (previous == nullptr || latest->state != previous->state))
+  {
+    diff.isDirtyState = true;
+  }
+  if (previous == nullptr || latest->cameras != previous->cameras)
+  {
+    diffSection((previous) ? previous->cameras.get() : nullptr, *latest->cameras, diff.cameras);
+  }
+  if (previous == nullptr || latest->lights != previous->lights)
+  {
+    diffSection((previous) ? previous->lights.get() : nullptr, *latest->lights, diff.lights);
+  }
+  if (previous == nullptr || latest->materials != previous->materials)
+  {
+    diffSection((previous) ? previous->materials.get() : nullptr, *latest->materials, diff.materials);
+  }
+
+  // The acquired snapshot stays protected until the next acquire(). Only then the previous one can be reclaimed.
+  slot.acquired.store(latest);
+  slot.acquiring.store(nullptr);
+
+  return true;
+}
@@ -36,6 +36,7 @@
 #include <cctype>
 #include <cstring>
 #include <iostream>
+#include <type_traits>
 
 #include "inc/MyAssert.h"
 
@@ -115,6 +116,36 @@ Image::~Image()
   }
 }
 
+// 2x2 box filter of one 2D mipmap level into the next. Odd extents clamp the last row and column.
+template<typename T>
+static void downsample(T* dst, const unsigned int dstWidth, const unsigned int dstHeight,
+                       const T* src, const unsigned int srcWidth, const unsigned int srcHeight,
+                       const unsigned int numComponents)
+{
+  for (unsigned int y = 0; y < dstHeight; ++y)
+  {
+    const unsigned int y0 = std::min(y * 2,     srcHeight - 1);
+    const unsigned int y1 = std::min(y * 2 + 1, srcHeight - 1);
+
+    for (unsigned int x = 0; x < dstWidth; ++x)
+    {
+      const unsigned int x0 = std::min(x * 2,     srcWidth - 1);
+      const unsigned int x1 = std::min(x * 2 + 1, srcWidth - 1);
+
+      for (unsigned int c = 0; c < numComponents; ++c)
+      {
+        const float sum = float(src[(y0 * srcWidth + x0) * numComponents + c]) +
+                          float(src[(y0 * srcWidth + x1) * numComponents + c]) +
+                          float(src[(y1 * srcWidth + x0) * numComponents + c]) +
+                          float(src[(y1 * srcWidth + x1) * numComponents + c]);
+
+        // Integer types round to nearest.
+        dst[(y * dstWidth + x) * numComponents + c] = (std::is_integral<T>::value) ? T(sum * 0.25f + 0.5f) : T(sum * 0.25f);
+      }
+    }
+  }
+}
+
 static int determineFace(int i, bool isCubemapDDS)
 {
   int face = i;
@@ -138,6 +169,8 @@ static int determineFace(int i, bool isCubemapDDS)
 
 Picture::Picture()
 : m_isCube(false)
+, m_flags(0)
+, m_isResident(true)
 {
 }
 
@@ -501,6 +534,12 @@ bool Picture::load(std::string const& filename, const unsigned int flags)
           // All others are flipped by DevIL because I set the origin to lower left. Handle DDS images the same?
           mirrorX(index); // reverse rows 
         }
+
+        // Plain 2D images requested with mipmaps get the missing mipmap chain generated.
+        if ((flags & IMAGE_FLAG_MIPMAP) && (flags & IMAGE_FLAG_2D) && (flags & (IMAGE_FLAG_LAYER | IMAGE_FLAG_ENV)) == 0 && !m_isCube)
+        {
+          generateMipmaps(index);
+        }
       }
     }
     success = true;
@@ -514,18 +553,64 @@ bool Picture::load(std::string const& filename, const unsigned int flags)
   // Free all resources associated with the DevIL image
   ilDeleteImages(1, &imageID);
   MY_ASSERT(IL_NO_ERROR == ilGetError());
+
+  // After the addImages() calls above which invalidate the source.
+  m_filename   = (success) ? filename : std::string();
+  m_flags      = flags;
+  m_isResident = true;
   
   return success;
 }
 
+bool Picture::release()
+{
+  if (m_filename.empty())
+  {
+    return false; // Generated or modified images can't be loaded again.
+  }
+  clearImages();
+  m_isResident = false;
+  return true;
+}
+
+bool Picture::reload()
+{
+  if (m_isResident)
+  {
+    return true;
+  }
+  return load(m_filename, m_flags);
+}
+
+bool Picture::isResident() const
+{
+  return m_isResident;
+}
+
+size_t Picture::getSizeInBytes() const
+{
+  size_t size = 0;
+  for (size_t i = 0; i < m_images.size(); ++i)
+  {
+    for (size_t lod = 0; lod < m_images[i].size(); ++lod)
+    {
+      size += m_images[i][lod]->m_nob;
+    }
+  }
+  return size;
+}
+
 void Picture::clear()
 {
   m_images.clear();
+  m_filename.clear();
 }
 
 // Append a new empty vector of images. Returns the new image index.
 unsigned int Picture::addImages()
 {
+  m_filename.clear(); // The images don't match the source file anymore.
+
   const unsigned int index = static_cast<unsigned int>(m_images.size());
 
   m_images.push_back(std::vector<Image*>()); // Append a new empty vector of image pointers. Each vector holds a mipmap chain.
@@ -539,6 +624,8 @@ unsigned int Picture::addImages(const void* pixels,
                                 const int format, const int type,
                                 std::vector<const void*> const& mipmaps, const unsigned int flags)
 {
+  m_filename.clear();
+
   const unsigned int index = static_cast<unsigned int>(m_images.size());
 
   m_images.push_back(std::vector<Image*>()); // Append a new empty vector of image pointers.
@@ -580,6 +667,8 @@ unsigned int Picture::addLevel(const unsigned int index, const void* pixels,
   MY_ASSERT(pixels != nullptr);
   MY_ASSERT((0 < width) && (0 < height) && (0 < depth));
 
+  m_filename.clear();
+
   Image* image = new Image(width, height, depth, format, type);
 
   image->m_pixels = new unsigned char[image->m_nob];
@@ -655,6 +744,55 @@ void Picture::mirrorY(unsigned int index)
 }
 
 
+void Picture::generateMipmaps(unsigned int index)
+{
+  MY_ASSERT(index < m_images.size());
+
+  if (m_images[index].size() != 1 || m_images[index][0]->m_depth != 1) // Already mipmapped, or not a 2D image.
+  {
+    return;
+  }
+
+  while (true)
+  {
+    const Image* src = m_images[index].back();
+
+    if (src->m_width == 1 && src->m_height == 1)
+    {
+      break;
+    }
+
+    Image* dst = new Image(std::max(1u, src->m_width >> 1), std::max(1u, src->m_height >> 1), 1, src->m_format, src->m_type);
+
+    dst->m_pixels = new unsigned char[dst->m_nob];
+
+    const unsigned int numComponents = numberOfComponents(src->m_format);
+
+    switch (src->m_type)
+    {
+      case IL_UNSIGNED_BYTE:
+        downsample(dst->m_pixels, dst->m_width, dst->m_height, src->m_pixels, src->m_width, src->m_height, numComponents);
+        break;
+
+      case IL_UNSIGNED_SHORT:
+        downsample(reinterpret_cast<unsigned short*>(dst->m_pixels), dst->m_width, dst->m_height,
+                   reinterpret_cast<const unsigned short*>(src->m_pixels), src->m_width, src->m_height, numComponents);
+        break;
+
+      case IL_FLOAT:
+        downsample(reinterpret_cast<float*>(dst->m_pixels), dst->m_width, dst->m_height,
+                   reinterpret_cast<const float*>(src->m_pixels), src->m_width, src->m_height, numComponents);
+        break;
+
+      default: // Signed and 32-bit integer images stay without mipmaps.
+        delete dst;
+        return;
+    }
+
+    m_images[index].push_back(dst);
+  }
+}
+
 // DEBUG
 void Picture::generateRGBA8(unsigned int width, unsigned int height, unsigned int depth, const unsigned int flags)
 {
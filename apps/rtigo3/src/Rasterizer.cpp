@@ -35,7 +35,6 @@
 #include <iostream>
 #include <string.h>
 
-#if USE_TIME_VIEW
 static bool generateColorRamp(const std::vector<ColorRampElement>& definition, int size, float *ramp)
 {
   if (definition.size() < 1 || !size || !ramp) 
@@ -116,7 +115,6 @@ static bool generateColorRamp(const std::vector<ColorRampElement>& definition, i
   }
   return true;
 }
-#endif
 
 
 Rasterizer::Rasterizer(const int w, const int h, const int interop)
@@ -138,6 +136,7 @@ Rasterizer::Rasterizer(const int w, const int h, const int interop)
 , m_locSamplerHDR(-1)
 , m_colorRampTexture(0)
 , m_locSamplerColorRamp(-1)
+, m_locTimeView(-1)
 , m_locInvGamma(-1)
 , m_locColorBalance(-1)
 , m_locInvWhitePoint(-1)
@@ -145,6 +144,11 @@ Rasterizer::Rasterizer(const int w, const int h, const int interop)
 , m_locCrushBlacks(-1)
 , m_locSaturation(-1)
 {
+  m_blitRect[0] = 0.0f;
+  m_blitRect[1] = 0.0f;
+  m_blitRect[2] = 0.0f;
+  m_blitRect[3] = 0.0f;
+
   for (int i = 0; i < 8; ++i)
   {
     memset(m_deviceUUID[0], 0, sizeof(m_deviceUUID[0]));
@@ -295,8 +299,7 @@ Rasterizer::Rasterizer(const int w, const int h, const int interop)
   updateProjectionMatrix();
   updateVertexAttributes();
 
-#if USE_TIME_VIEW
-  // Generate the color ramp definition vector.
+  // Generate the color ramp definition vector. Always done to allow switching the time view at runtime.
   std::vector<ColorRampElement> colorRampDefinition;
   
   ColorRampElement cre;
@@ -349,16 +352,13 @@ Rasterizer::Rasterizer(const int w, const int h, const int interop)
 
     glActiveTexture(GL_TEXTURE0);
   }
-#endif
 }
 
 Rasterizer::~Rasterizer()
 {
   glDeleteTextures(1, &m_hdrTexture);
 
-#if USE_TIME_VIEW
   glDeleteTextures(1, &m_colorRampTexture);
-#endif
   
   if (m_interop)
   {
@@ -459,7 +459,6 @@ void Rasterizer::setResolution(const int w, const int h)
 
 void Rasterizer::setTonemapper(TonemapperGUI const& tm)
 {
-#if !USE_TIME_VIEW
   glUseProgram(m_glslProgram);
 
   glUniform1f(m_locInvGamma, 1.0f / tm.gamma);
@@ -470,7 +469,33 @@ void Rasterizer::setTonemapper(TonemapperGUI const& tm)
   glUniform1f(m_locSaturation, tm.saturation);
 
   glUseProgram(0);
-#endif
+}
+
+// Window coordinates have the origin at the top left like the mouse position.
+// Returns the normalized image coordinates with the origin at the bottom left like the launch index, false when outside the image.
+bool Rasterizer::mapWindowToImage(const int x, const int y, float& u, float& v) const
+{
+  const float w = m_blitRect[2] - m_blitRect[0];
+  const float h = m_blitRect[3] - m_blitRect[1];
+
+  if (w <= 0.0f || h <= 0.0f)
+  {
+    return false;
+  }
+
+  u = (float(x) + 0.5f - m_blitRect[0]) / w;
+  v = (float(m_height - y) - 0.5f - m_blitRect[1]) / h;
+
+  return (0.0f <= u && u < 1.0f && 0.0f <= v && v < 1.0f);
+}
+
+void Rasterizer::setTimeView(const bool enable)
+{
+  glUseProgram(m_glslProgram);
+
+  glUniform1i(m_locTimeView, (enable) ? 1 : 0);
+
+  glUseProgram(0);
 }
 
 
@@ -535,22 +560,12 @@ void Rasterizer::initGLSL()
     "}\n";
 
 
-#if USE_TIME_VIEW
+  // The time view shows the clock cycles the device stored in the alpha channel with a color ramp instead of the tonemapped radiance.
   static const std::string fsSource =
     "#version 330\n"
     "uniform sampler2D samplerHDR;\n"
     "uniform sampler1D samplerColorRamp;\n"
-    "in vec2 varTexCoord;\n"
-    "layout(location = 0, index = 0) out vec4 outColor;\n"
-    "void main()\n"
-    "{\n"
-    "  float alpha = texture(samplerHDR, varTexCoord).a;\n"
-    "  outColor = texture(samplerColorRamp, alpha);\n"
-    "}\n";
-#else
-  static const std::string fsSource =
-    "#version 330\n"
-    "uniform sampler2D samplerHDR;\n"
+    "uniform int   timeView;\n"
     "uniform vec3  colorBalance;\n"
     "uniform float invWhitePoint;\n"
     "uniform float burnHighlights;\n"
@@ -561,8 +576,13 @@ void Rasterizer::initGLSL()
     "layout(location = 0, index = 0) out vec4 outColor;\n"
     "void main()\n"
     "{\n"
-    "  vec3 hdrColor = texture(samplerHDR, varTexCoord).rgb;\n"
-    "  vec3 ldrColor = invWhitePoint * colorBalance * hdrColor;\n"
+    "  vec4 hdr = texture(samplerHDR, varTexCoord);\n"
+    "  if (timeView != 0)\n"
+    "  {\n"
+    "    outColor = texture(samplerColorRamp, hdr.a);\n"
+    "    return;\n"
+    "  }\n"
+    "  vec3 ldrColor = invWhitePoint * colorBalance * hdr.rgb;\n"
     "  ldrColor *= (ldrColor * burnHighlights + 1.0) / (ldrColor + 1.0);\n"
     "  float luminance = dot(ldrColor, vec3(0.3, 0.59, 0.11));\n"
     "  ldrColor = max(mix(vec3(luminance), ldrColor, saturation), 0.0);\n"
@@ -574,7 +594,6 @@ void Rasterizer::initGLSL()
     "  ldrColor = pow(ldrColor, vec3(invGamma));\n"
     "  outColor = vec4(ldrColor, 1.0);\n"
     "}\n";
-#endif
 
   GLint vsCompiled = 0;
   GLint fsCompiled = 0;
@@ -642,11 +661,14 @@ void Rasterizer::initGLSL()
       MY_ASSERT(m_locSamplerHDR  != -1);
       glUniform1i(m_locSamplerHDR, 0); // The rasterizer uses texture image unit 0 to display the HDR image.
 
-#if USE_TIME_VIEW
       m_locSamplerColorRamp = glGetUniformLocation(m_glslProgram, "samplerColorRamp");
       MY_ASSERT(m_locSamplerColorRamp != -1);
-      glUniform1i(m_locSamplerColorRamp, 1); // The rasterizer uses texture image unit 1 for the color ramp when USE_TIME_VIEW is enabled.
-#else
+      glUniform1i(m_locSamplerColorRamp, 1); // The rasterizer uses texture image unit 1 for the color ramp of the time view.
+
+      m_locTimeView = glGetUniformLocation(m_glslProgram, "timeView");
+      MY_ASSERT(m_locTimeView != -1);
+      glUniform1i(m_locTimeView, 0); // Tonemapped radiance by default.
+
       m_locInvGamma       = glGetUniformLocation(m_glslProgram, "invGamma");
       m_locColorBalance   = glGetUniformLocation(m_glslProgram, "colorBalance");
       m_locInvWhitePoint  = glGetUniformLocation(m_glslProgram, "invWhitePoint");
@@ -668,7 +690,6 @@ void Rasterizer::initGLSL()
       glUniform1f(m_locBurnHighlights, 1.0f);
       glUniform1f(m_locCrushBlacks, 1.0f);
       glUniform1f(m_locSaturation, 1.0f);
-#endif
 
       glUseProgram(0);
     }
@@ -802,6 +823,12 @@ void Rasterizer::updateVertexAttributes()
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   }
 
+  // Remember the blit rectangle to map window coordinates back to the image.
+  m_blitRect[0] = x0;
+  m_blitRect[1] = y0;
+  m_blitRect[2] = x1;
+  m_blitRect[3] = y1;
+
   // Update the vertex attributes with the new texture blit screen space coordinates.
   const float attributes[16] = 
   {
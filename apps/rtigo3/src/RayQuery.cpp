@@ -0,0 +1,113 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/RayQuery.h"
+
+#include <algorithm>
+#include <future>
+#include <thread>
+#include <vector>
+
+
+static void traceRaysHostRange(HostBVH const& bvh, const QueryRay* rays, QueryHit* hits, const size_t begin, const size_t end)
+{
+  for (size_t i = begin; i < end; ++i)
+  {
+    QueryRay const& query = rays[i];
+    QueryHit&       hit   = hits[i];
+
+    hit.t         = -1.0f;
+    hit.instance  = QUERY_MISS;
+    hit.primitive = QUERY_MISS;
+    hit.u         = 0.0f;
+    hit.v         = 0.0f;
+
+    // All instances use the visibility mask 255 on the device, so only a zero ray mask can reject them.
+    if ((query.mask & 0xFF) == 0)
+    {
+      continue;
+    }
+
+    BvhRay ray;
+
+    ray.org[0] = query.origin[0];
+    ray.org[1] = query.origin[1];
+    ray.org[2] = query.origin[2];
+    ray.dir[0] = query.direction[0];
+    ray.dir[1] = query.direction[1];
+    ray.dir[2] = query.direction[2];
+    ray.tmin   = query.tmin;
+    ray.tmax   = query.tmax;
+
+    BvhHit result;
+
+    if (bvh.intersect(ray, result))
+    {
+      hit.t         = result.t;
+      hit.instance  = static_cast<unsigned int>(result.instance);
+      hit.primitive = result.primitive;
+      hit.u         = result.u;
+      hit.v         = result.v;
+    }
+  }
+}
+
+void traceRaysHost(HostBVH const& bvh, const QueryRay* rays, QueryHit* hits, const size_t count)
+{
+  const size_t blockSize = 4096; // Rays per task. Small enough to balance incoherent rays.
+
+  const size_t numBlocks  = (count + blockSize - 1) / blockSize;
+  const size_t numThreads = std::min(numBlocks, static_cast<size_t>(std::max(1u, std::thread::hardware_concurrency())));
+
+  if (numThreads <= 1)
+  {
+    traceRaysHostRange(bvh, rays, hits, 0, count);
+    return;
+  }
+
+  // Each thread processes every numThreads-th block.
+  std::vector< std::future<void> > futures;
+
+  for (size_t t = 0; t < numThreads; ++t)
+  {
+    futures.push_back(std::async(std::launch::async, [&bvh, rays, hits, count, blockSize, numBlocks, numThreads, t]()
+    {
+      for (size_t block = t; block < numBlocks; block += numThreads)
+      {
+        const size_t begin = block * blockSize;
+
+        traceRaysHostRange(bvh, rays, hits, begin, std::min(begin + blockSize, count));
+      }
+    }));
+  }
+
+  for (auto& f : futures)
+  {
+    f.get();
+  }
+}
@@ -28,7 +28,10 @@
 
 #include "inc/Raytracer.h"
 
+#include "inc/Aov.h"
 #include "inc/CheckMacros.h"
+#include "inc/RayQuery.h"
+#include "inc/TimeView.h"
 
 #include <algorithm>
 #include <fstream>
@@ -383,6 +386,109 @@ void Raytracer::synchronize()
   }
 }
 
+void Raytracer::getTimeViewHost(std::vector<float>& cycles, std::vector<unsigned int>& ids)
+{
+  applyParameters(); // The caller expects the current resolution.
+
+  cycles.clear();
+  ids.clear();
+
+  std::vector<float>        cyclesDevice;
+  std::vector<unsigned int> idsDevice;
+
+  for (size_t i = 0; i < m_activeDevices.size(); ++i)
+  {
+    m_activeDevices[i]->getTimeViewHost(cyclesDevice, idsDevice);
+    accumulateTimeView(cycles, ids, cyclesDevice, idsDevice);
+  }
+}
+
+void Raytracer::getAovHost(const int index, std::vector<unsigned char>& aov)
+{
+  applyParameters(); // The caller expects the current resolution.
+
+  aov.clear();
+
+  std::vector<unsigned char> aovDevice;
+
+  for (size_t i = 0; i < m_activeDevices.size(); ++i)
+  {
+    m_activeDevices[i]->getAovHost(index, aovDevice);
+    accumulateAov(aov, aovDevice);
+  }
+}
+
+void Raytracer::getBufferCacheStatistics(std::vector<BufferCacheStatistics>& statistics) const
+{
+  statistics.resize(m_activeDevices.size());
+
+  for (size_t i = 0; i < m_activeDevices.size(); ++i)
+  {
+    statistics[i] = m_activeDevices[i]->getBufferCacheStatistics();
+  }
+}
+
+void Raytracer::trimBufferCaches()
+{
+  for (size_t i = 0; i < m_activeDevices.size(); ++i)
+  {
+    m_activeDevices[i]->trimBufferCache();
+  }
+}
+
+// Number of rays per submission. Large enough to saturate a GPU, small enough to overlap the copies.
+#define QUERY_CHUNK_SIZE (1u << 20)
+
+void Raytracer::traceRays(std::vector<QueryRay> const& rays, std::vector<QueryHit>& hits, HostBVH const* bvhHost)
+{
+  hits.resize(rays.size());
+
+  if (rays.empty())
+  {
+    return;
+  }
+
+  if (m_activeDevices.empty())
+  {
+    if (bvhHost)
+    {
+      traceRaysHost(*bvhHost, rays.data(), hits.data(), rays.size());
+    }
+    else
+    {
+      // The resized hits are zero, which would read as a hit of instance 0 at t = 0.
+      const QueryHit miss = { -1.0f, QUERY_MISS, QUERY_MISS, 0.0f, 0.0f };
+
+      std::fill(hits.begin(), hits.end(), miss);
+    }
+    return;
+  }
+
+  // Round-robin the chunks over the devices. Each device double-buffers its submissions internally.
+  size_t indexDevice = 0;
+
+  for (size_t offset = 0; offset < rays.size(); offset += QUERY_CHUNK_SIZE)
+  {
+    const unsigned int count = static_cast<unsigned int>(std::min(rays.size() - offset, static_cast<size_t>(QUERY_CHUNK_SIZE)));
+
+    m_activeDevices[indexDevice]->submitRays(rays.data() + offset, hits.data() + offset, count);
+
+    indexDevice = (indexDevice + 1) % m_activeDevices.size();
+  }
+
+  for (size_t i = 0; i < m_activeDevices.size(); ++i)
+  {
+    m_activeDevices[i]->finishRays();
+  }
+}
+
+void Raytracer::traceRays(CUdeviceptr rays, CUdeviceptr hits, const unsigned int count, const int indexDevice)
+{
+  MY_ASSERT(0 <= indexDevice && indexDevice < static_cast<int>(m_activeDevices.size()));
+
+  m_activeDevices[indexDevice]->traceRays(rays, hits, count);
+}
+
 // HACK Hardcocded textures.
 void Raytracer::initTextures(std::map<std::string, Picture*> const& mapOfPictures)
 {
@@ -392,83 +498,171 @@ void Raytracer::initTextures(std::map<std::string, Picture*> const& mapOfPicture
   }
 }
 
+// The init functions upload directly. The pending edits are applied before to keep their order,
+// afterwards the new section is marked as known to all devices so that it isn't uploaded again.
 void Raytracer::initCameras(std::vector<CameraDefinition> const& cameras)
 {
+  applyParameters();
+
   for (size_t i = 0; i < m_activeDevices.size(); ++i)
   {
     m_activeDevices[i]->initCameras(cameras);
   }
+
+  m_parameters.setCameras(cameras);
+  acknowledgeParameters();
 }
 
 void Raytracer::initLights(std::vector<LightDefinition> const& lights)
 {
+  applyParameters();
+
   for (size_t i = 0; i < m_activeDevices.size(); ++i)
   {
     m_activeDevices[i]->initLights(lights);
   }
+
+  m_parameters.setLights(lights);
+  acknowledgeParameters();
 }
 
 void Raytracer::initMaterials(std::vector<MaterialGUI> const& materialsGUI)
 {
+  applyParameters();
+
   for (size_t i = 0; i < m_activeDevices.size(); ++i)
   {
     m_activeDevices[i]->initMaterials(materialsGUI);
   }
+
+  m_parameters.setMaterials(materialsGUI);
+  acknowledgeParameters();
 }
 
 // Traverse the SceneGraph and store Groups, Instances and Triangles nodes in the raytracer representation.
 void Raytracer::initScene(std::shared_ptr<sg::Group> root, const unsigned int numGeometries)
 {
+  applyParameters(); // The hit records depend on the cutout state of the materials.
+
   for (size_t i = 0; i < m_activeDevices.size(); ++i)
   {
     m_activeDevices[i]->initScene(root, numGeometries);
   }
 }
 
+void Raytracer::updateScene(std::shared_ptr<sg::Group> root, const unsigned int numGeometries, SceneDiff const& diff)
+{
+  applyParameters(); // The hit records depend on the cutout state of the materials.
+
+  for (size_t i = 0; i < m_activeDevices.size(); ++i)
+  {
+    m_activeDevices[i]->updateScene(root, numGeometries, diff);
+  }
+  m_iterationIndex = 0; // Restart accumulation.
+}
+
 void Raytracer::initState(DeviceState const& state)
 {
+  applyParameters();
+
   m_samplesPerPixel = (unsigned int)(state.samplesSqrt * state.samplesSqrt);
 
   for (size_t i = 0; i < m_activeDevices.size(); ++i)
   {
     m_activeDevices[i]->setState(state);
   }
+
+  m_parameters.setState(state);
+  acknowledgeParameters();
 }
 
-void Raytracer::updateCamera(const int idCamera, CameraDefinition const& camera)
+void Raytracer::initViews(std::vector<CameraDefinition> const& cameras, std::vector<ViewDefinition> const& views)
 {
+  applyParameters();
+
   for (size_t i = 0; i < m_activeDevices.size(); ++i)
   {
-    m_activeDevices[i]->updateCamera(idCamera, camera);
+    m_activeDevices[i]->initCameras(cameras);
+    m_activeDevices[i]->initViews(views);
   }
+
+  m_parameters.setCameras(cameras);
+  acknowledgeParameters();
+
   m_iterationIndex = 0; // Restart accumulation.
 }
 
-void Raytracer::updateLight(const int idLight, LightDefinition const& light)
+void Raytracer::setViewsSequential(const bool sequential)
 {
   for (size_t i = 0; i < m_activeDevices.size(); ++i)
   {
-    m_activeDevices[i]->updateLight(idLight, light);
+    m_activeDevices[i]->setViewsSequential(sequential);
   }
   m_iterationIndex = 0; // Restart accumulation.
 }
 
-void Raytracer::updateMaterial(const int idMaterial, MaterialGUI const& materialGUI)
+void Raytracer::setGraphs(const bool enable)
 {
   for (size_t i = 0; i < m_activeDevices.size(); ++i)
   {
-    m_activeDevices[i]->updateMaterial(idMaterial, materialGUI);
+    m_activeDevices[i]->setGraphs(enable);
   }
   m_iterationIndex = 0; // Restart accumulation.
 }
 
+// The update functions only record the edit in the parameter channel. Nothing touches the devices here,
+// all edits until the next render() are coalesced and uploaded with one diff per device in applyParameters().
+void Raytracer::updateCamera(const int idCamera, CameraDefinition const& camera)
+{
+  m_parameters.setCamera(idCamera, camera);
+  m_iterationIndex = 0; // Restart accumulation.
+}
+
+void Raytracer::updateLight(const int idLight, LightDefinition const& light)
+{
+  m_parameters.setLight(idLight, light);
+  m_iterationIndex = 0; // Restart accumulation.
+}
+
+void Raytracer::updateMaterial(const int idMaterial, MaterialGUI const& materialGUI)
+{
+  m_parameters.setMaterial(idMaterial, materialGUI);
+  m_iterationIndex = 0; // Restart accumulation.
+}
+
 void Raytracer::updateState(DeviceState const& state)
 {
   m_samplesPerPixel = (unsigned int)(state.samplesSqrt * state.samplesSqrt);
 
+  m_parameters.setState(state);
+  m_iterationIndex = 0; // Restart accumulation.
+}
+
+// Publishes the pending edits and lets each device upload its changes against the snapshot it applied before.
+// Called once per frame at the begin of render() and before the direct upload and readback paths.
+void Raytracer::applyParameters()
+{
+  m_parameters.publish();
+
+  ParameterDiff diff;
+
   for (size_t i = 0; i < m_activeDevices.size(); ++i)
   {
-    m_activeDevices[i]->setState(state);
+    if (m_parameters.acquire(static_cast<int>(i), diff))
+    {
+      m_activeDevices[i]->applyParameters(diff);
+    }
+  }
+}
+
+void Raytracer::acknowledgeParameters()
+{
+  m_parameters.publish();
+
+  ParameterDiff diff;
+
+  for (size_t i = 0; i < m_activeDevices.size(); ++i)
+  {
+    m_parameters.acquire(static_cast<int>(i), diff);
   }
-  m_iterationIndex = 0; // Restart accumulation.
 }
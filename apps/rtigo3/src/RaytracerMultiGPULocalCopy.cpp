@@ -100,6 +100,8 @@ RaytracerMultiGPULocalCopy::~RaytracerMultiGPULocalCopy()
 // Returns the count of renderered iterations (m_iterationIndex after it has been incremented.
 unsigned int RaytracerMultiGPULocalCopy::render()
 {
+  applyParameters(); // Upload the GUI edits since the last frame.
+
   // Continue manual accumulation rendering if the samples per pixel have not been reached.
   if (m_iterationIndex < m_samplesPerPixel)
   {
@@ -153,6 +155,8 @@ void RaytracerMultiGPULocalCopy::updateDisplayTexture()
 
 const void* RaytracerMultiGPULocalCopy::getOutputBufferHost()
 {
+  applyParameters(); // The caller expects the current resolution.
+
   // Same initial steps to fill the outputBuffer on the primary device as in updateDisplayTexture() 
   const int index = (m_deviceOGL != -1) ? m_deviceOGL : 0; // Destination device.
 
@@ -101,6 +101,8 @@ RaytracerMultiGPUPeerAccess::~RaytracerMultiGPUPeerAccess()
 // Returns the count of renderered iterations (m_iterationIndex after it has been incremented.
 unsigned int RaytracerMultiGPUPeerAccess::render()
 {
+  applyParameters(); // Upload the GUI edits since the last frame.
+
   // Continue manual accumulation rendering if the samples per pixel have not been reached.
   if (m_iterationIndex < m_samplesPerPixel)
   {
@@ -149,6 +151,8 @@ void RaytracerMultiGPUPeerAccess::updateDisplayTexture()
 
 const void* RaytracerMultiGPUPeerAccess::getOutputBufferHost()
 {
+  applyParameters(); // The caller expects the current resolution.
+
   // Sync all devices before getting the buffer from the device owning the shared buffer.
   for (size_t i = 0; i < m_activeDevices.size(); ++i)
   {
@@ -0,0 +1,176 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/RaytracerMultiGPUSampleRange.h"
+
+#include "inc/CheckMacros.h"
+
+#include <algorithm>
+#include <iostream>
+
+RaytracerMultiGPUSampleRange::RaytracerMultiGPUSampleRange(const int devicesMask,
+                                                           const int miss,
+                                                           const int interop,
+                                                           const unsigned int tex,
+                                                           const unsigned int pbo)
+: Raytracer(RS_MULTI_GPU_SAMPLE_RANGE, interop, tex, pbo)
+{
+  int count   = 0; // Need to determine the number of active devices first to have it available as constructor argument.
+  int ordinal = 0;
+  while (ordinal < m_visibleDevices) // Don't try to enable more devices than visible.
+  {
+    unsigned int mask = (1 << ordinal);
+    if (devicesMask & mask)
+    {
+      // Track which and how many devices have actually been enabled.
+      m_activeDevicesMask |= mask; 
+      ++count;
+    }
+    ++ordinal;
+  }
+
+  if (interop != INTEROP_MODE_OFF)
+  {
+    std::cerr << "WARNING: RaytracerMultiGPUSampleRange() merges the devices on the host. OpenGL interop is not used.\n";
+  }
+
+  ordinal = 0;
+  while (ordinal < m_visibleDevices)
+  {
+    unsigned int mask = (1 << ordinal);
+    if (m_activeDevicesMask & mask)
+    {
+      const int index = static_cast<int>(m_activeDevices.size());
+
+      DeviceMultiGPUSampleRange* device = new DeviceMultiGPUSampleRange(m_strategy, ordinal, index, count, miss, interop, tex, pbo);
+
+      m_activeDevices.push_back(device);
+
+      std::cout << "RaytracerMultiGPUSampleRange() Using device " << ordinal << ": " << device->m_deviceName << '\n';
+    }
+    ++ordinal;
+  }
+
+  // No peer-to-peer access required. Each device only reads and writes its own buffers.
+
+  m_isValid = !m_activeDevices.empty();
+}
+
+
+unsigned int RaytracerMultiGPUSampleRange::getSampleCount() const
+{
+  unsigned int samples = 0;
+
+  for (size_t i = 0; i < m_activeDevices.size(); ++i)
+  {
+    samples += ::getSampleCount(static_cast<const DeviceMultiGPUSampleRange*>(m_activeDevices[i])->getSampleRange(), m_iterationIndex);
+  }
+  return samples;
+}
+
+
+// m_iterationIndex counts the launches per device. Devices with shorter ranges stop earlier.
+// Returns the merged samples per pixel which reaches m_samplesPerPixel when all ranges are done.
+unsigned int RaytracerMultiGPUSampleRange::render()
+{
+  applyParameters(); // Upload the GUI edits since the last frame.
+
+  unsigned int samples = getSampleCount();
+
+  if (samples < m_samplesPerPixel)
+  {
+    for (size_t i = 0; i < m_activeDevices.size(); ++i)
+    {
+      const SampleRange range = static_cast<DeviceMultiGPUSampleRange*>(m_activeDevices[i])->getSampleRange();
+
+      if (m_iterationIndex < range.end - range.begin)
+      {
+        m_activeDevices[i]->render(m_iterationIndex, nullptr); // Local accumulation index. The device adds its sample range offset.
+      }
+    }
+
+    ++m_iterationIndex;
+
+    samples = getSampleCount();
+  }  
+  return samples;
+}
+
+
+void RaytracerMultiGPUSampleRange::updateDisplayTexture()
+{
+  const float4* data = reinterpret_cast<const float4*>(getOutputBufferHost());
+
+  static_cast<DeviceMultiGPUSampleRange*>(m_activeDevices[0])->updateDisplayTexture(data);
+}
+
+
+// Merges the per device accumulations weighted by their sample counts. Devices which haven't rendered yet are skipped.
+const void* RaytracerMultiGPUSampleRange::getOutputBufferHost()
+{
+  applyParameters(); // The caller expects the current resolution.
+
+  std::vector<const float4*> sources;
+  std::vector<unsigned int>  counts;
+
+  for (size_t i = 0; i < m_activeDevices.size(); ++i)
+  {
+    const unsigned int count = ::getSampleCount(static_cast<const DeviceMultiGPUSampleRange*>(m_activeDevices[i])->getSampleRange(), m_iterationIndex);
+
+    if (count != 0)
+    {
+      sources.push_back(reinterpret_cast<const float4*>(m_activeDevices[i]->getOutputBufferHost())); // Synchronous.
+      counts.push_back(count);
+    }
+  }
+
+  const int2 resolution = m_activeDevices[0]->m_systemData.resolution;
+
+  const size_t numPixels = size_t(resolution.x) * size_t(resolution.y);
+
+  m_bufferHost.resize(numPixels);
+
+  mergeSampleRanges(m_bufferHost.data(), sources, counts, numPixels);
+
+  return m_bufferHost.data();
+}
+
+
+void RaytracerMultiGPUSampleRange::getTimeViewHost(std::vector<float>& cycles, std::vector<unsigned int>& ids)
+{
+  applyParameters(); // The caller expects the current resolution.
+
+  m_activeDevices[0]->getTimeViewHost(cycles, ids);
+}
+
+void RaytracerMultiGPUSampleRange::getAovHost(const int index, std::vector<unsigned char>& aov)
+{
+  applyParameters(); // The caller expects the current resolution.
+
+  m_activeDevices[0]->getAovHost(index, aov);
+}
@@ -88,6 +88,8 @@ RaytracerMultiGPUZeroCopy::RaytracerMultiGPUZeroCopy(const int devicesMask,
 // Returns the count of renderered iterations (m_iterationIndex after it has been incremented.
 unsigned int RaytracerMultiGPUZeroCopy::render()
 {
+  applyParameters(); // Upload the GUI edits since the last frame.
+
   // Continue manual accumulation rendering if the samples per pixel have not been reached.
   if (m_iterationIndex < m_samplesPerPixel)
   {
@@ -118,6 +120,8 @@ void RaytracerMultiGPUZeroCopy::updateDisplayTexture()
 
 const void* RaytracerMultiGPUZeroCopy::getOutputBufferHost()
 {
+  applyParameters(); // The caller expects the current resolution.
+
   // Finish rendering on all other devices before accessing the shared pinned memory buffer.
   for (size_t i = 1; i < m_activeDevices.size(); ++i)
   {
@@ -64,6 +64,14 @@ RaytracerSingleGPU::RaytracerSingleGPU(const int devicesMask,
   m_isValid = !m_activeDevices.empty();
 }
 
+RaytracerSingleGPU::RaytracerSingleGPU(RendererStrategy strategy,
+                                       const int interop,
+                                       const unsigned int tex,
+                                       const unsigned int pbo)
+: Raytracer(strategy, interop, tex, pbo)
+{
+}
+
 
 void RaytracerSingleGPU::updateDisplayTexture()
 {
@@ -75,6 +83,8 @@ void RaytracerSingleGPU::updateDisplayTexture()
 // Returns the count of renderered iterations (m_iterationIndex after it has been incremented.
 unsigned int RaytracerSingleGPU::render()
 {
+  applyParameters(); // Upload the GUI edits since the last frame.
+
   // Continue manual accumulation rendering if the samples per pixel have not been reached.
   if (m_iterationIndex < m_samplesPerPixel)
   {
@@ -88,6 +98,8 @@ unsigned int RaytracerSingleGPU::render()
 
 const void* RaytracerSingleGPU::getOutputBufferHost() // Not called when using OpenGL interop.
 {
+  applyParameters(); // The caller expects the current resolution.
+
   return m_activeDevices[0]->getOutputBufferHost(); // Only one device in this implementation.
 }
 
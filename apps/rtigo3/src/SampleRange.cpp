@@ -0,0 +1,143 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/SampleRange.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && 2 <= _M_IX86_FP)
+#define USE_MERGE_SSE 1
+#include <xmmintrin.h>
+#else
+#define USE_MERGE_SSE 0
+#endif
+
+
+SampleRange getSampleRange(const unsigned int samplesPerPixel, const int count, const int index)
+{
+  SampleRange range;
+
+  // Rounding up gives the first device the biggest range, so it's never empty. 64-bit intermediates, samplesPerPixel * count can overflow.
+  range.begin = static_cast<unsigned int>((static_cast<unsigned long long>(samplesPerPixel) * index       + count - 1) / count);
+  range.end   = static_cast<unsigned int>((static_cast<unsigned long long>(samplesPerPixel) * (index + 1) + count - 1) / count);
+
+  return range;
+}
+
+
+unsigned int getSampleCount(SampleRange const& range, const unsigned int iterationIndex)
+{
+  return std::min(iterationIndex, range.end - range.begin);
+}
+
+
+void mergeSampleRanges(float4* dst, std::vector<const float4*> const& sources, std::vector<unsigned int> const& counts, const size_t numPixels)
+{
+  // Gather the contributing devices and their weights.
+  std::vector<const float4*> src;
+  std::vector<float>         weights;
+
+  unsigned long long total = 0;
+
+  for (size_t i = 0; i < sources.size(); ++i)
+  {
+    if (counts[i] != 0)
+    {
+      src.push_back(sources[i]);
+      weights.push_back(float(counts[i]));
+      total += counts[i];
+    }
+  }
+
+  if (src.empty())
+  {
+    memset(dst, 0, sizeof(float4) * numPixels);
+    return;
+  }
+
+  if (src.size() == 1) // Single device or only one device started its range yet.
+  {
+    memcpy(dst, src[0], sizeof(float4) * numPixels);
+    return;
+  }
+
+  for (float& weight : weights)
+  {
+    weight /= float(total);
+  }
+
+  const size_t numSources = src.size();
+
+  // One float4 pixel per SSE register. The sources are streamed in the outer loop over blocks of pixels to stay in the cache.
+  const size_t blockSize = 4096;
+
+  for (size_t first = 0; first < numPixels; first += blockSize)
+  {
+    const size_t last = std::min(first + blockSize, numPixels);
+
+#if USE_MERGE_SSE
+    const __m128 w0 = _mm_set1_ps(weights[0]);
+
+    for (size_t i = first; i < last; ++i)
+    {
+      _mm_storeu_ps(&dst[i].x, _mm_mul_ps(_mm_loadu_ps(&src[0][i].x), w0));
+    }
+
+    for (size_t s = 1; s < numSources; ++s)
+    {
+      const __m128 w = _mm_set1_ps(weights[s]);
+
+      for (size_t i = first; i < last; ++i)
+      {
+        _mm_storeu_ps(&dst[i].x, _mm_add_ps(_mm_loadu_ps(&dst[i].x), _mm_mul_ps(_mm_loadu_ps(&src[s][i].x), w)));
+      }
+    }
+#else
+    for (size_t i = first; i < last; ++i)
+    {
+      const float w = weights[0];
+
+      dst[i] = make_float4(src[0][i].x * w, src[0][i].y * w, src[0][i].z * w, src[0][i].w * w);
+    }
+
+    for (size_t s = 1; s < numSources; ++s)
+    {
+      const float w = weights[s];
+
+      for (size_t i = first; i < last; ++i)
+      {
+        dst[i].x += src[s][i].x * w;
+        dst[i].y += src[s][i].y * w;
+        dst[i].z += src[s][i].z * w;
+        dst[i].w += src[s][i].w * w;
+      }
+    }
+#endif
+  }
+}
@@ -0,0 +1,265 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/SceneDiff.h"
+
+#include <dp/math/Batch.h>
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+
+static void flattenNode(std::shared_ptr<sg::Node> node, const float matrix[12], SceneInstance instance, std::vector<SceneInstance>& instances)
+{
+  switch (node->getType())
+  {
+    case sg::NodeType::NT_GROUP:
+    {
+      std::shared_ptr<sg::Group> group = std::dynamic_pointer_cast<sg::Group>(node);
+
+      for (size_t i = 0; i < group->getNumChildren(); ++i)
+      {
+        flattenNode(group->getChild(i), matrix, instance, instances);
+      }
+    }
+    break;
+
+    case sg::NodeType::NT_INSTANCE:
+    {
+      std::shared_ptr<sg::Instance> child = std::dynamic_pointer_cast<sg::Instance>(node);
+
+      float trafo[12];
+      dp::math::concatenateMatrices(matrix, child->getTransform(), trafo, 1);
+
+      if (0 <= child->getMaterial())
+      {
+        instance.idMaterial = child->getMaterial();
+      }
+      if (0 <= child->getLight())
+      {
+        instance.idLight = child->getLight();
+      }
+
+      flattenNode(child->getChild(), trafo, instance, instances);
+    }
+    break;
+
+    case sg::NodeType::NT_TRIANGLES:
+    {
+      instance.idGeometry = node->getId();
+      memcpy(instance.matrix, matrix, sizeof(float) * 12);
+
+      instances.push_back(instance);
+    }
+    break;
+  }
+}
+
+void flattenScene(std::shared_ptr<sg::Node> root, std::vector<SceneInstance>& instances)
+{
+  const float matrix[12] = { 1.0f, 0.0f, 0.0f, 0.0f,
+                             0.0f, 1.0f, 0.0f, 0.0f,
+                             0.0f, 0.0f, 1.0f, 0.0f };
+
+  SceneInstance instance;
+
+  instance.idGeometry = ~0u;
+  instance.idMaterial = -1;
+  instance.idLight    = -1;
+
+  flattenNode(root, matrix, instance, instances);
+}
+
+
+static bool isEqual(const float3 a, const float3 b)
+{
+  return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+static bool isEqual(MaterialGUI const& a, MaterialGUI const& b)
+{
+  return a.name             == b.name &&
+         a.indexBSDF        == b.indexBSDF &&
+         isEqual(a.albedo, b.albedo) &&
+         isEqual(a.absorptionColor, b.absorptionColor) &&
+         a.absorptionScale  == b.absorptionScale &&
+         a.roughness.x      == b.roughness.x &&
+         a.roughness.y      == b.roughness.y &&
+         a.ior              == b.ior &&
+         a.thinwalled       == b.thinwalled &&
+         a.useAlbedoTexture == b.useAlbedoTexture &&
+         a.useCutoutTexture == b.useCutoutTexture;
+}
+
+// The padding fields are not initialized, so compare member by member.
+static bool isEqual(LightDefinition const& a, LightDefinition const& b)
+{
+  return a.type == b.type &&
+         isEqual(a.position, b.position) &&
+         isEqual(a.vecU, b.vecU) &&
+         isEqual(a.vecV, b.vecV) &&
+         isEqual(a.normal, b.normal) &&
+         a.area == b.area &&
+         isEqual(a.emission, b.emission);
+}
+
+static std::vector<unsigned int> getGeometries(std::vector<SceneInstance> const& instances)
+{
+  std::vector<unsigned int> geometries;
+
+  for (SceneInstance const& instance : instances)
+  {
+    geometries.push_back(instance.idGeometry);
+  }
+
+  std::sort(geometries.begin(), geometries.end());
+  geometries.erase(std::unique(geometries.begin(), geometries.end()), geometries.end());
+
+  return geometries;
+}
+
+
+SceneDiff diffScenes(SceneDescription const& before, SceneDescription const& after)
+{
+  SceneDiff diff;
+
+  if (before.materials.size() != after.materials.size())
+  {
+    diff.materialsResized = true;
+  }
+  else
+  {
+    for (size_t i = 0; i < after.materials.size(); ++i)
+    {
+      if (!isEqual(before.materials[i], after.materials[i]))
+      {
+        diff.materials.push_back(static_cast<int>(i));
+      }
+    }
+  }
+
+  if (before.lights.size() != after.lights.size())
+  {
+    diff.lightsResized = true;
+  }
+  else
+  {
+    for (size_t i = 0; i < after.lights.size(); ++i)
+    {
+      if (!isEqual(before.lights[i], after.lights[i]))
+      {
+        diff.lights.push_back(static_cast<int>(i));
+      }
+    }
+  }
+
+  // Instances are matched by their index, which is their device instance ID.
+  // Inserting an instance in the middle of the scene description shifts all following IDs and needs the TLAS rebuild anyway.
+  if (before.instances.size() != after.instances.size())
+  {
+    diff.instancesChanged = true;
+  }
+
+  for (size_t i = 0; i < after.instances.size() && !diff.instancesChanged; ++i)
+  {
+    SceneInstance const& a = before.instances[i];
+    SceneInstance const& b = after.instances[i];
+
+    if (a.idGeometry != b.idGeometry || a.idMaterial != b.idMaterial || a.idLight != b.idLight)
+    {
+      diff.instancesChanged = true;
+    }
+    else if (memcmp(a.matrix, b.matrix, sizeof(float) * 12) != 0)
+    {
+      diff.instancesMoved.push_back(static_cast<unsigned int>(i));
+    }
+  }
+
+  if (diff.instancesChanged)
+  {
+    diff.instancesMoved.clear(); // Covered by the rebuild.
+  }
+
+  const std::vector<unsigned int> geometriesBefore = getGeometries(before.instances);
+  const std::vector<unsigned int> geometriesAfter  = getGeometries(after.instances);
+
+  std::set_difference(geometriesAfter.begin(), geometriesAfter.end(), geometriesBefore.begin(), geometriesBefore.end(), std::back_inserter(diff.geometriesAdded));
+  std::set_difference(geometriesBefore.begin(), geometriesBefore.end(), geometriesAfter.begin(), geometriesAfter.end(), std::back_inserter(diff.geometriesRemoved));
+
+  return diff;
+}
+
+
+bool isEmpty(SceneDiff const& diff)
+{
+  return !diff.materialsResized && diff.materials.empty() &&
+         !diff.lightsResized && diff.lights.empty() &&
+         !diff.instancesChanged && diff.instancesMoved.empty() &&
+         diff.geometriesAdded.empty() && diff.geometriesRemoved.empty();
+}
+
+
+std::string formatSceneDiff(SceneDiff const& diff)
+{
+  std::ostringstream stream;
+
+  stream << "materials ";
+  if (diff.materialsResized)
+  {
+    stream << "all";
+  }
+  else
+  {
+    stream << diff.materials.size();
+  }
+
+  stream << ", lights ";
+  if (diff.lightsResized)
+  {
+    stream << "all";
+  }
+  else
+  {
+    stream << diff.lights.size();
+  }
+
+  stream << ", instances ";
+  if (diff.instancesChanged)
+  {
+    stream << "rebuilt";
+  }
+  else
+  {
+    stream << diff.instancesMoved.size() << " moved";
+  }
+
+  stream << ", geometries +" << diff.geometriesAdded.size() << " -" << diff.geometriesRemoved.size();
+
+  return stream.str();
+}
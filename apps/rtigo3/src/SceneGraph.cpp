@@ -30,7 +30,10 @@
 
 #include "inc/SceneGraph.h"
 
+#include <cstdint>
+#include <cstdio>
 #include <cstring>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 
@@ -143,14 +146,33 @@ namespace sg
   }
 
   // ========== Triangles
+  
+  // Header of the host cache files.
+  struct TrianglesCacheHeader
+  {
+    unsigned int magic;
+    unsigned int sizeAttributes; // sizeof(TriangleAttributes), rejects files from builds with another layout.
+    uint64_t     numAttributes;
+    uint64_t     numIndices;
+  };
+
+  static const unsigned int TRIANGLES_CACHE_MAGIC = 0x33475452; // "RTG3"
+
   Triangles::Triangles(const unsigned int id)
   : Node(id)
+  , m_isHostResident(true)
+  , m_numAttributes(0)
+  , m_numIndices(0)
   {
   }
 
-  //Triangles::~Triangles()
-  //{
-  //}
+  Triangles::~Triangles()
+  {
+    if (!m_filenameCache.empty())
+    {
+      std::remove(m_filenameCache.c_str());
+    }
+  }
 
   sg::NodeType Triangles::getType() const
   {
@@ -159,25 +181,145 @@ namespace sg
 
   void Triangles::setAttributes(std::vector<TriangleAttributes> const& attributes)
   {
+    MY_ASSERT(m_isHostResident);
     m_attributes.resize(attributes.size());
     memcpy(m_attributes.data(), attributes.data(), sizeof(TriangleAttributes) * attributes.size());
+    m_filenameCache.clear(); // The old cache file is overwritten by the next releaseHost().
+  }
+
+  void Triangles::setAttributes(std::vector<TriangleAttributes>&& attributes)
+  {
+    MY_ASSERT(m_isHostResident);
+    m_attributes = std::move(attributes);
+    m_filenameCache.clear();
   }
 
   std::vector<TriangleAttributes> const& Triangles::getAttributes() const
   {
+    MY_ASSERT(m_isHostResident); // Call reloadHost() before accessing released data.
     return m_attributes;
   }
 
   void Triangles::setIndices(std::vector<unsigned int> const& indices)
   {
+    MY_ASSERT(m_isHostResident);
     m_indices.resize(indices.size());
     memcpy(m_indices.data(), indices.data(), sizeof(unsigned int) * indices.size());
+    m_filenameCache.clear();
+  }
+
+  void Triangles::setIndices(std::vector<unsigned int>&& indices)
+  {
+    MY_ASSERT(m_isHostResident);
+    m_indices = std::move(indices);
+    m_filenameCache.clear();
   }
   
   std::vector<unsigned int> const& Triangles::getIndices() const
   {
+    MY_ASSERT(m_isHostResident);
     return m_indices;
   }
 
+  bool Triangles::releaseHost(std::string const& filenameCache)
+  {
+    if (!m_isHostResident)
+    {
+      return true;
+    }
+
+    // The cache file is only written on the first release. The data doesn't change afterwards.
+    if (m_filenameCache.empty())
+    {
+      std::ofstream output(filenameCache, std::ios::binary);
+      if (!output)
+      {
+        std::cerr << "ERROR: releaseHost() failed to open cache file " << filenameCache << '\n';
+        return false;
+      }
+
+      TrianglesCacheHeader header;
+
+      header.magic          = TRIANGLES_CACHE_MAGIC;
+      header.sizeAttributes = sizeof(TriangleAttributes);
+      header.numAttributes  = m_attributes.size();
+      header.numIndices     = m_indices.size();
+
+      output.write(reinterpret_cast<const char*>(&header), sizeof(TrianglesCacheHeader));
+      output.write(reinterpret_cast<const char*>(m_attributes.data()), sizeof(TriangleAttributes) * m_attributes.size());
+      output.write(reinterpret_cast<const char*>(m_indices.data()), sizeof(unsigned int) * m_indices.size());
+      output.close();
+      
+      if (!output)
+      {
+        std::cerr << "ERROR: releaseHost() failed to write cache file " << filenameCache << '\n';
+        std::remove(filenameCache.c_str());
+        return false;
+      }
+      m_filenameCache = filenameCache;
+    }
+
+    m_numAttributes = m_attributes.size();
+    m_numIndices    = m_indices.size();
+
+    // clear() keeps the capacity. Swapping with empty vectors really frees the memory.
+    std::vector<TriangleAttributes>().swap(m_attributes);
+    std::vector<unsigned int>().swap(m_indices);
+
+    m_isHostResident = false;
+    return true;
+  }
+
+  bool Triangles::reloadHost()
+  {
+    if (m_isHostResident)
+    {
+      return true;
+    }
+
+    std::ifstream input(m_filenameCache, std::ios::binary);
+
+    TrianglesCacheHeader header;
+
+    if (!input.read(reinterpret_cast<char*>(&header), sizeof(TrianglesCacheHeader)) ||
+        header.magic          != TRIANGLES_CACHE_MAGIC ||
+        header.sizeAttributes != sizeof(TriangleAttributes) ||
+        header.numAttributes  != m_numAttributes ||
+        header.numIndices     != m_numIndices)
+    {
+      std::cerr << "ERROR: reloadHost() invalid cache file " << m_filenameCache << '\n';
+      return false;
+    }
+
+    m_attributes.resize(m_numAttributes);
+    m_indices.resize(m_numIndices);
+
+    if (!input.read(reinterpret_cast<char*>(m_attributes.data()), sizeof(TriangleAttributes) * m_numAttributes) ||
+        !input.read(reinterpret_cast<char*>(m_indices.data()), sizeof(unsigned int) * m_numIndices))
+    {
+      std::cerr << "ERROR: reloadHost() failed to read cache file " << m_filenameCache << '\n';
+      std::vector<TriangleAttributes>().swap(m_attributes);
+      std::vector<unsigned int>().swap(m_indices);
+      return false;
+    }
+
+    m_isHostResident = true;
+    return true;
+  }
+
+  bool Triangles::isHostResident() const
+  {
+    return m_isHostResident;
+  }
+
+  size_t Triangles::getHostSizeInBytes() const
+  {
+    if (m_isHostResident)
+    {
+      return sizeof(TriangleAttributes) * m_attributes.size() + sizeof(unsigned int) * m_indices.size();
+    }
+    return sizeof(TriangleAttributes) * m_numAttributes + sizeof(unsigned int) * m_numIndices;
+  }
+
 } // namespace sg
 
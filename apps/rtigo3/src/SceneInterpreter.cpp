@@ -0,0 +1,617 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/SceneInterpreter.h"
+
+#include "inc/Parser.h"
+
+#include "shaders/vector_math.h"
+
+#include <dp/math/Quatt.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <sstream>
+#include <stack>
+
+#include "inc/MyAssert.h"
+
+
+SceneInterpreter::SceneInterpreter()
+{
+  m_mapKeywordScene["albedo"]          = KS_ALBEDO;
+  m_mapKeywordScene["roughness"]       = KS_ROUGHNESS;
+  m_mapKeywordScene["absorption"]      = KS_ABSORPTION;
+  m_mapKeywordScene["absorptionScale"] = KS_ABSORPTION_SCALE;
+  m_mapKeywordScene["ior"]             = KS_IOR;
+  m_mapKeywordScene["thinwalled"]      = KS_THINWALLED;
+  m_mapKeywordScene["material"]        = KS_MATERIAL;
+  m_mapKeywordScene["identity"]        = KS_IDENTITY;
+  m_mapKeywordScene["push"]            = KS_PUSH;
+  m_mapKeywordScene["pop"]             = KS_POP;
+  m_mapKeywordScene["rotate"]          = KS_ROTATE;
+  m_mapKeywordScene["scale"]           = KS_SCALE;
+  m_mapKeywordScene["translate"]       = KS_TRANSLATE;
+  m_mapKeywordScene["model"]           = KS_MODEL;
+}
+
+
+// Reads count floating point values following a keyword.
+static void getValues(Parser& parser, float* values, const int count)
+{
+  std::string token;
+
+  for (int i = 0; i < count; ++i)
+  {
+    const ParserTokenType tokenType = parser.getNextToken(token);
+    MY_ASSERT(tokenType == PTT_VAL);
+    values[i] = (float) atof(token.c_str());
+  }
+}
+
+static void getTessellation(Parser& parser, unsigned int* tess, const int count)
+{
+  std::string token;
+
+  for (int i = 0; i < count; ++i)
+  {
+    const ParserTokenType tokenType = parser.getNextToken(token);
+    MY_ASSERT(tokenType == PTT_VAL);
+    tess[i] = atoi(token.c_str());
+  }
+}
+
+
+bool SceneInterpreter::lex(std::string const& filename)
+{
+  Parser parser;
+
+  if (!parser.load(filename))
+  {
+    std::cerr << "ERROR: loadSceneDescription() failed in loadString(" << filename << ")\n";
+    return false;
+  }
+
+  m_commands.clear();
+
+  ParserTokenType tokenType;
+  std::string token;
+
+  while ((tokenType = parser.getNextToken(token)) != PTT_EOF)
+  {
+    if (tokenType == PTT_UNKNOWN)
+    {
+      std::cerr << "ERROR: loadSceneDescription() " << filename << " (" << parser.getLine() << "): Unknown token type.\n";
+      MY_ASSERT(!"Unknown token type.");
+      return false;
+    }
+
+    if (tokenType != PTT_ID)
+    {
+      continue;
+    }
+
+    std::map<std::string, KeywordScene>::const_iterator it = m_mapKeywordScene.find(token);
+    if (it == m_mapKeywordScene.end())
+    {
+      std::cerr << "loadSceneDescription(): Unknown token " << token << " ignored.\n";
+      continue; // Just keep getting the next token until a known keyword is found.
+    }
+
+    SceneCommand command;
+
+    command.keyword = it->second;
+    command.model   = SMT_UNKNOWN;
+    memset(command.values, 0, sizeof(command.values));
+    memset(command.tess,   0, sizeof(command.tess));
+
+    switch (command.keyword)
+    {
+      case KS_ALBEDO:
+      case KS_ABSORPTION:
+      case KS_SCALE:
+      case KS_TRANSLATE:
+        getValues(parser, command.values, 3);
+        break;
+
+      case KS_ROUGHNESS:
+        getValues(parser, command.values, 2);
+        break;
+
+      case KS_ABSORPTION_SCALE:
+      case KS_IOR:
+        getValues(parser, command.values, 1);
+        break;
+
+      case KS_THINWALLED:
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_VAL);
+        command.values[0] = (atoi(token.c_str()) != 0) ? 1.0f : 0.0f;
+        break;
+
+      case KS_MATERIAL:
+        tokenType = parser.getNextToken(command.reference); // Internal material name. If there are duplicates the last name wins.
+        tokenType = parser.getNextToken(command.name);      // The actual material name.
+        break;
+
+      case KS_IDENTITY:
+      case KS_PUSH:
+      case KS_POP:
+        break;
+
+      case KS_ROTATE:
+        getValues(parser, command.values, 4); // Axis and angle in degrees.
+        break;
+
+      case KS_MODEL:
+        tokenType = parser.getNextToken(token);
+        MY_ASSERT(tokenType == PTT_ID);
+
+        if (token == "plane")
+        {
+          command.model = SMT_PLANE;
+          getTessellation(parser, command.tess, 3); // tessU, tessV, upAxis
+          tokenType = parser.getNextToken(command.reference);
+        }
+        else if (token == "box")
+        {
+          command.model = SMT_BOX;
+          tokenType = parser.getNextToken(command.reference);
+        }
+        else if (token == "sphere")
+        {
+          command.model = SMT_SPHERE;
+          getTessellation(parser, command.tess, 2);
+          // Theta is in the range [0.0f, 1.0f] and 1.0f means closed sphere, smaller values open the noth pole.
+          getValues(parser, command.values, 1);
+          tokenType = parser.getNextToken(command.reference);
+        }
+        else if (token == "torus")
+        {
+          command.model = SMT_TORUS;
+          getTessellation(parser, command.tess, 2);
+          getValues(parser, command.values, 2); // Inner and outer radius.
+          tokenType = parser.getNextToken(command.reference);
+        }
+        else if (token == "assimp" || token == "gltf")
+        {
+          command.model = (token == "assimp") ? SMT_ASSIMP : SMT_GLTF;
+          tokenType = parser.getNextToken(command.name); // Needs to be a path in quotation marks.
+          MY_ASSERT(tokenType == PTT_STRING);
+        }
+        break;
+    }
+
+    m_commands.push_back(command);
+  }
+
+  return true;
+}
+
+
+void SceneInterpreter::resolve()
+{
+  m_materials.clear();
+  m_models.clear();
+
+  // Reusing some math routines from the NVIDIA nvpro-pipeline https://github.com/nvpro-pipeline/pipeline
+  // Note that matrices in the nvpro-pipeline are defined row-major but are multiplied from the right,
+  // which means the order of transformations is simply from left to right matrix, means first matrix is applied first,
+  // but puts the translation into the last row elements (12 to 14).
+  // Only the object to world matrix is tracked. Nothing consumed the inverse and orientation stacks.
+  std::stack<dp::math::Mat44f> stackMatrix;
+
+  dp::math::Mat44f curMatrix(dp::math::cIdentity44f);
+
+  // Material parameters.
+  SceneMaterial curMaterial;
+
+  curMaterial.albedo          = make_float3(1.0f);
+  curMaterial.roughness       = make_float2(0.1f);
+  curMaterial.absorptionColor = make_float3(1.0f);
+  curMaterial.absorptionScale = 0.0f; // 0.0f means off.
+  curMaterial.ior             = 1.5f;
+  curMaterial.thinwalled      = false;
+
+  for (SceneCommand const& command : m_commands)
+  {
+    switch (command.keyword)
+    {
+      case KS_ALBEDO:
+        curMaterial.albedo = make_float3(command.values[0], command.values[1], command.values[2]);
+        break;
+
+      case KS_ROUGHNESS:
+        curMaterial.roughness = make_float2(command.values[0], command.values[1]);
+        break;
+
+      case KS_ABSORPTION: // For convenience this is an absoption color used to calculate the absorption coefficient.
+        curMaterial.absorptionColor = make_float3(command.values[0], command.values[1], command.values[2]);
+        break;
+
+      case KS_ABSORPTION_SCALE:
+        curMaterial.absorptionScale = command.values[0];
+        break;
+
+      case KS_IOR:
+        curMaterial.ior = command.values[0];
+        break;
+
+      case KS_THINWALLED:
+        curMaterial.thinwalled = (command.values[0] != 0.0f);
+        break;
+
+      case KS_MATERIAL:
+        curMaterial.reference = command.reference;
+        curMaterial.name      = command.name;
+
+        m_materials.push_back(curMaterial);
+        break;
+
+      case KS_IDENTITY:
+        curMatrix = dp::math::cIdentity44f;
+        break;
+
+      case KS_PUSH:
+        stackMatrix.push(curMatrix);
+        break;
+
+      case KS_POP:
+        if (!stackMatrix.empty())
+        {
+          curMatrix = stackMatrix.top();
+          stackMatrix.pop();
+        }
+        else
+        {
+          std::cerr << "ERROR: loadSceneDescription() pop on empty stack. Resetting to identity.\n";
+          curMatrix = dp::math::cIdentity44f;
+        }
+        break;
+
+      case KS_ROTATE:
+        {
+          dp::math::Vec3f axis(command.values[0], command.values[1], command.values[2]);
+          axis.normalize();
+
+          const float angle = dp::math::degToRad(command.values[3]);
+
+          dp::math::Quatf rotation(axis, angle);
+          dp::math::Mat44f matrix(rotation, dp::math::Vec3f(0.0f, 0.0f, 0.0f)); // Zero translation to get a Mat44f back. 
+          curMatrix *= matrix;
+        }
+        break;
+
+      case KS_SCALE:
+        {
+          dp::math::Mat44f scaling(dp::math::cIdentity44f);
+
+          scaling[0][0] = command.values[0];
+          scaling[1][1] = command.values[1];
+          scaling[2][2] = command.values[2];
+
+          curMatrix *= scaling;
+        }
+        break;
+
+      case KS_TRANSLATE:
+        {
+          dp::math::Mat44f translation(dp::math::cIdentity44f);
+        
+          // Translation is in the third row in dp::math::Mat44f.
+          translation[3][0] = command.values[0];
+          translation[3][1] = command.values[1];
+          translation[3][2] = command.values[2];
+
+          curMatrix *= translation;
+        }
+        break;
+
+      case KS_MODEL:
+        if (command.model != SMT_UNKNOWN)
+        {
+          SceneModel model;
+
+          model.type         = command.model;
+          model.tess[0]      = command.tess[0];
+          model.tess[1]      = command.tess[1];
+          model.tess[2]      = command.tess[2];
+          model.params[0]    = command.values[0];
+          model.params[1]    = command.values[1];
+          model.reference    = command.reference;
+          model.filename     = command.name;
+          model.numMaterials = m_materials.size();
+          model.matrix       = curMatrix;
+
+          m_models.push_back(model);
+        }
+        break;
+    }
+  }
+}
+
+
+// The key identifying runtime generated geometry with the same construction parameters.
+static std::string getGeometryKey(SceneModel const& model)
+{
+  std::ostringstream key;
+
+  switch (model.type)
+  {
+    case SMT_PLANE:
+      key << "plane_" << model.tess[0] << "_" << model.tess[1] << "_" << model.tess[2];
+      break;
+    case SMT_BOX:
+      key << "box_1_1"; // FIXME Implement tessellation. Must be a single value to get even distributions across edges.
+      break;
+    case SMT_SPHERE:
+      key << "sphere_" << model.tess[0] << "_" << model.tess[1] << "_" << model.params[0];
+      break;
+    case SMT_TORUS:
+      key << "torus_" << model.tess[0] << "_" << model.tess[1] << "_" << model.params[0] << "_" << model.params[1];
+      break;
+    default:
+      MY_ASSERT(!"getGeometryKey() Not a runtime generated geometry.");
+      break;
+  }
+  return key.str();
+}
+
+// The binary construction parameters. Models with equal parameters have equal geometry keys,
+// which saves formatting the key string for every instance of the same geometry.
+struct GeometryParameters
+{
+  uint32_t bits[6];
+
+  GeometryParameters(SceneModel const& model)
+  {
+    bits[0] = static_cast<uint32_t>(model.type);
+    bits[1] = model.tess[0];
+    bits[2] = model.tess[1];
+    bits[3] = model.tess[2];
+    memcpy(&bits[4], model.params, sizeof(float) * 2);
+  }
+
+  bool operator<(GeometryParameters const& rhs) const
+  {
+    return memcmp(bits, rhs.bits, sizeof(bits)) < 0;
+  }
+};
+
+static void createGeometry(sg::Triangles& geometry, SceneModel const& model)
+{
+  switch (model.type)
+  {
+    case SMT_PLANE:
+      geometry.createPlane(model.tess[0], model.tess[1], model.tess[2]);
+      break;
+    case SMT_BOX:
+      geometry.createBox();
+      break;
+    case SMT_SPHERE:
+      geometry.createSphere(model.tess[0], model.tess[1], 1.0f, model.params[0] * M_PIf);
+      break;
+    case SMT_TORUS:
+      geometry.createTorus(model.tess[0], model.tess[1], model.params[0], model.params[1]);
+      break;
+    default:
+      break;
+  }
+}
+
+static std::shared_ptr<sg::Instance> createInstance(const unsigned int id, dp::math::Mat44f const& matrix)
+{
+  // nvpro-pipeline matrices are row-major multiplied from the right, means the translation is in the last row. Transpose!
+  const float trafo[12] =
+  {
+    matrix[0][0], matrix[1][0], matrix[2][0], matrix[3][0], 
+    matrix[0][1], matrix[1][1], matrix[2][1], matrix[3][1], 
+    matrix[0][2], matrix[1][2], matrix[2][2], matrix[3][2]
+  };
+
+  MY_ASSERT(matrix[0][3] == 0.0f && 
+            matrix[1][3] == 0.0f && 
+            matrix[2][3] == 0.0f && 
+            matrix[3][3] == 1.0f);
+
+  std::shared_ptr<sg::Instance> instance(new sg::Instance(id));
+  instance->setTransform(trafo);
+
+  return instance;
+}
+
+bool SceneInterpreter::expand(SceneTarget& target, const unsigned int numThreads)
+{
+  const size_t numModels = m_models.size();
+
+  // Per model results of the sequential pass. The instances of the runtime generated geometries are only reserved here.
+  std::vector< std::shared_ptr<sg::Instance> >  children(numModels);
+  std::vector< std::shared_ptr<sg::Triangles> > childGeometries(numModels);
+  std::vector<unsigned int>                     childIds(numModels);
+  std::vector<int>                              childMaterials(numModels);
+
+  // The newly created geometries and the model with their construction parameters.
+  std::vector< std::shared_ptr<sg::Triangles> > geometries;
+  std::vector<size_t>                           geometryModels;
+
+  std::map<GeometryParameters, std::shared_ptr<sg::Triangles> > cacheGeometries;
+
+  size_t indexMaterial = 0;
+
+  for (size_t i = 0; i < numModels; ++i)
+  {
+    SceneModel const& model = m_models[i];
+
+    // Materials and models are created in the order of the scene description. The loaders look up and modify the materials.
+    for (; indexMaterial < model.numMaterials; ++indexMaterial)
+    {
+      target.createMaterial(m_materials[indexMaterial]);
+    }
+
+    if (model.type == SMT_ASSIMP || model.type == SMT_GLTF)
+    {
+      std::shared_ptr<sg::Group> group = target.createModel(model); // Assigns its own IDs before the instance.
+
+      children[i] = createInstance((*target.idInstance)++, model.matrix);
+      children[i]->setChild(group);
+      continue;
+    }
+
+    const GeometryParameters parameters(model);
+
+    std::shared_ptr<sg::Triangles> geometry;
+
+    std::map<GeometryParameters, std::shared_ptr<sg::Triangles> >::const_iterator itc = cacheGeometries.find(parameters);
+    if (itc != cacheGeometries.end())
+    {
+      geometry = itc->second;
+    }
+    else
+    {
+      const std::string keyGeometry = getGeometryKey(model);
+
+      std::map<std::string, unsigned int>::const_iterator itg = target.mapGeometries->find(keyGeometry);
+      if (itg == target.mapGeometries->end())
+      {
+        (*target.mapGeometries)[keyGeometry] = *target.idGeometry;
+
+        geometry = std::make_shared<sg::Triangles>((*target.idGeometry)++); // Filled by the workers.
+
+        target.geometries->push_back(geometry);
+
+        geometries.push_back(geometry);
+        geometryModels.push_back(i);
+      }
+      else
+      {
+        geometry = (*target.geometries)[itg->second];
+      }
+      cacheGeometries[parameters] = geometry;
+    }
+
+    childGeometries[i] = geometry;
+    childIds[i]        = (*target.idInstance)++;
+
+    int index = -1;
+    std::map<std::string, int>::const_iterator itm = target.mapMaterialReferences->find(model.reference);
+    if (itm != target.mapMaterialReferences->end())
+    {
+      index = itm->second;
+    }
+    else
+    {
+      std::cerr << "WARNING: appendInstance() No material found for " << model.reference << ". Trying default.\n";
+
+      std::map<std::string, int>::const_iterator itmd = target.mapMaterialReferences->find(std::string("default"));
+      if (itmd != target.mapMaterialReferences->end())
+      {
+        index = itmd->second;
+      }
+      else 
+      {
+        std::cerr << "ERROR: appendInstance() No default material found\n";
+      }
+    }
+    childMaterials[i] = index;
+  }
+
+  for (; indexMaterial < m_materials.size(); ++indexMaterial)
+  {
+    target.createMaterial(m_materials[indexMaterial]);
+  }
+
+  // Worker t generates every numWorkers-th new geometry and the t-th contiguous range of instances.
+  const size_t numWorkers = std::max(size_t(1), std::min(size_t(numThreads), std::max(geometries.size(), numModels)));
+
+  auto work = [&](const size_t t)
+  {
+    for (size_t g = t; g < geometries.size(); g += numWorkers)
+    {
+      createGeometry(*geometries[g], m_models[geometryModels[g]]);
+    }
+
+    const size_t begin = numModels * t / numWorkers;
+    const size_t end   = numModels * (t + 1) / numWorkers;
+
+    for (size_t i = begin; i < end; ++i)
+    {
+      if (childGeometries[i])
+      {
+        std::shared_ptr<sg::Instance> instance = createInstance(childIds[i], m_models[i].matrix);
+        instance->setChild(childGeometries[i]);
+        instance->setMaterial(childMaterials[i]);
+
+        children[i] = instance;
+      }
+    }
+  };
+
+  if (numWorkers == 1)
+  {
+    work(0);
+  }
+  else
+  {
+    std::vector< std::future<void> > futures;
+
+    for (size_t t = 0; t < numWorkers; ++t)
+    {
+      futures.push_back(std::async(std::launch::async, work, t));
+    }
+    for (std::future<void>& f : futures)
+    {
+      f.get(); // Rethrows exceptions of the workers.
+    }
+  }
+
+  for (size_t i = 0; i < numModels; ++i)
+  {
+    target.scene->addChild(children[i]);
+  }
+
+  return true;
+}
+
+std::vector<SceneCommand> const& SceneInterpreter::getCommands() const
+{
+  return m_commands;
+}
+
+std::vector<SceneMaterial> const& SceneInterpreter::getMaterials() const
+{
+  return m_materials;
+}
+
+std::vector<SceneModel> const& SceneInterpreter::getModels() const
+{
+  return m_models;
+}
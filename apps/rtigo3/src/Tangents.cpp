@@ -0,0 +1,109 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/Tangents.h"
+
+#include "shaders/vector_math.h"
+
+#include <dp/math/Batch.h>
+
+#include "inc/MyAssert.h"
+
+
+// Calculate (geometry) tangents with the global tangent direction aligned to the biggest AABB extend of this part.
+void calculateTangents(std::vector<TriangleAttributes>& attributes, std::vector<unsigned int> const& indices)
+{
+  MY_ASSERT(3 <= indices.size());
+
+  // Build an axis aligned bounding box over all vertices. The vertex is the first field of the TriangleAttributes.
+  float3 aabbLo;
+  float3 aabbHi;
+
+  dp::math::calculateBounds(nullptr, &attributes[0].vertex.x, sizeof(TriangleAttributes), attributes.size(), &aabbLo.x, &aabbHi.x);
+
+  // Get the longest extend and use that as general tangent direction.
+  const float3 extents = aabbHi - aabbLo;
+  
+  float f = extents.x;
+  int maxComponent = 0;
+
+  if (f < extents.y)
+  {
+    f = extents.y;
+    maxComponent = 1;
+  }
+  if (f < extents.z)
+  {
+    maxComponent = 2;
+  }
+
+  float3 direction;
+  float3 bidirection;
+
+  switch (maxComponent)
+  {
+  case 0: // x-axis
+  default:
+    direction   = make_float3(1.0f, 0.0f, 0.0f);
+    bidirection = make_float3(0.0f, 1.0f, 0.0f);
+    break;
+  case 1: // y-axis // DEBUG It might make sense to keep these directions aligned to the global coordinate system. Use the same coordinates as for z-axis then.
+    direction   = make_float3(0.0f, 1.0f, 0.0f); 
+    bidirection = make_float3(0.0f, 0.0f, -1.0f);
+    break;
+  case 2: // z-axis
+    direction   = make_float3(0.0f, 0.0f, -1.0f);
+    bidirection = make_float3(0.0f, 1.0f,  0.0f);
+    break;
+  }
+
+  // Build an ortho-normal basis with the existing normal.
+  for (size_t i = 0; i < attributes.size(); ++i)
+  {
+    float3 tangent   = direction;
+    float3 bitangent = bidirection;
+    // float3 normal    = attributes[i].normal;
+    float3 normal;
+    normal.x = attributes[i].normal.x;
+    normal.y = attributes[i].normal.y;
+    normal.z = attributes[i].normal.z;
+
+    if (0.001f < 1.0f - fabsf(dot(normal, tangent)))
+    {
+      bitangent = normalize(cross(normal, tangent));
+      tangent   = normalize(cross(bitangent, normal));
+    }
+    else // Normal and tangent direction too collinear.
+    {
+      MY_ASSERT(0.001f < 1.0f - fabsf(dot(bitangent, normal)));
+      tangent   = normalize(cross(bitangent, normal));
+      //bitangent = normalize(cross(normal, tangent));
+    }
+    attributes[i].tangent = tangent;
+  }
+}
@@ -32,6 +32,7 @@
 
 #include "inc/Texture.h"
 #include "inc/CheckMacros.h"
+#include "inc/EnvFormat.h"
 
 #include <algorithm>
 #include <cstring>
@@ -225,420 +226,6 @@ static void determineFormatChannels(const unsigned int deviceEncoding, CUarray_f
 }
 
 
-static unsigned int getElementSize(const unsigned int deviceEncoding)
-{
-  unsigned int bytes = 0;
-
-  const unsigned int type = deviceEncoding & (ENC_MASK << ENC_TYPE_SHIFT);
-  switch (type)
-  {
-    case ENC_TYPE_CHAR:
-    case ENC_TYPE_UNSIGNED_CHAR:
-      bytes = 1;
-      break;
-    case ENC_TYPE_SHORT:
-    case ENC_TYPE_UNSIGNED_SHORT:
-    //case ENC_TYPE_HALF: // FIXME Implement.
-    bytes = 2;
-      break;
-    case ENC_TYPE_INT:
-    case ENC_TYPE_UNSIGNED_INT:
-    case ENC_TYPE_FLOAT:
-      bytes = 4;
-      break;
-    default:
-      MY_ASSERT(!"getElementSize() Unexpected data type.");
-      break;
-  }
-  
-  const unsigned int numChannels = (deviceEncoding >> ENC_CHANNELS_SHIFT) & ENC_MASK;
-
-  return bytes * numChannels;
-}
-
-
-// Texture format conversion routines.
-
-template<typename T> 
-T getAlphaOne()
-{
-  return (std::numeric_limits<T>::is_integer ? std::numeric_limits<T>::max() : T(1));
-}
-
-// Fixed point adjustment for integer data D and S.
-template<typename D, typename S>
-D adjust(S value)
-{
-  int dstBits = int(sizeof(D)) * 8;
-  int srcBits = int(sizeof(S)) * 8;
-
-  D result = D(0); // Clear bits to allow OR operations.
-
-  if (std::numeric_limits<D>::is_signed)
-  {
-    if (std::numeric_limits<S>::is_signed)
-    {
-      // D signed, S signed
-      if (dstBits <= srcBits)
-      {
-        // More bits provided than needed. Use the most significant bits of value.
-        result = D(value >> (srcBits - dstBits));
-      }
-      else
-      {
-        // Shift value into the most significant bits of result and replicate value into the lower bits until all are touched.
-        int shifts = dstBits - srcBits;
-        result = D(value << shifts);            // This sets the destination sign bit as well.
-        value &= std::numeric_limits<S>::max(); // Clear the sign bit inside the source value.
-        srcBits--;                              // Reduce the number of srcBits used to replicate the remaining data.
-        shifts -= srcBits;                      // Subtracting the now one smaller srcBits from shifts means the next shift will fill up with the remaining non-sign bits as intended.
-        while (0 <= shifts)
-        {
-          result |= D(value << shifts);
-          shifts -= srcBits;
-        }
-        if (shifts < 0) // There can be one to three empty bits left blank in the result now.
-        {
-          result |= D(value >> -shifts); // Shift to the right to get the most significant bits of value into the least significant destination bits.
-        }
-      }
-    }
-    else
-    {
-      // D signed, S unsigned
-      if (dstBits <= srcBits)
-      {
-        // More bits provided than needed. Use the most significant bits of value.
-        result = D(value >> (srcBits - dstBits + 1)); // + 1 because the destination is signed and the value needs to remain positive.
-      }
-      else
-      {
-        // Shift value into the most significant bits of result, keep the sign clear, and replicate value into the lower bits until all are touched.
-        int shifts = dstBits - srcBits - 1; // - 1 because the destination is signed and the value needs to remain positive.
-        while (0 <= shifts)
-        {
-          result |= D(value << shifts);
-          shifts -= srcBits;
-        }
-        if (shifts < 0)
-        {
-          result |= D(value >> -shifts);
-        }
-      }
-    }
-  }
-  else
-  {
-    if (std::numeric_limits<S>::is_signed)
-    {
-      // D unsigned, S signed
-      value = std::max(S(0), value); // Only the positive values will be transferred.
-      srcBits--;                     // Skip the sign bit. Means equal bit size won't happen here.
-      if (dstBits <= srcBits)        // When it's really bigger it has at least 7 bits more, no need to care for dangling bits
-      {
-        result = D(value >> (srcBits - dstBits));
-      }
-      else
-      {
-        int shifts = dstBits - srcBits;
-        while (0 <= shifts)
-        {
-          result |= D(value << shifts);
-          shifts -= srcBits;
-        }
-        if (shifts < 0)
-        {
-          result |= D(value >> -shifts);
-        }
-      }
-    }
-    else
-    {
-      // D unsigned, S unsigned
-      if (dstBits <= srcBits)
-      {
-        // More bits provided than needed. Use the most significant bits of value.
-        result = D(value >> (srcBits - dstBits));
-      }
-      else
-      {
-        // Shift value into the most significant bits of result and replicate into the lower ones until all bits are touched.
-        int shifts = dstBits - srcBits;
-        while (0 <= shifts) 
-        {
-          result |= D(value << shifts);
-          shifts -= srcBits;
-        } 
-        // Both bit sizes are even multiples of 8, there are no trailing bits here.
-        MY_ASSERT(shifts == -srcBits);
-      }
-    }
-  }
-  return result;
-}
-
-
-template<typename D, typename S>
-void remapAdjust(void *dst, unsigned int dstEncoding, const void *src, unsigned int srcEncoding, size_t count)
-{
-  const S *psrc = reinterpret_cast<const S *>(src);
-  D *pdst = reinterpret_cast<D *>(dst);
-  unsigned int dstChannels = (dstEncoding >> ENC_CHANNELS_SHIFT) & ENC_MASK;
-  unsigned int srcChannels = (srcEncoding >> ENC_CHANNELS_SHIFT) & ENC_MASK;
-  bool fixedPoint = !!(dstEncoding & ENC_FIXED_POINT);
-  bool alphaOne   = !!(dstEncoding & ENC_ALPHA_ONE);
-
-  while (count--)
-  {
-    unsigned int shift = ENC_RED_SHIFT;
-    for (unsigned int i = 0; i < 5; ++i, shift += 4) // Five possible channels: R, G, B, A, L
-    {
-      unsigned int d = (dstEncoding >> shift) & ENC_MASK;
-      if (d < 4) // This data channel exists inside the destination.
-      {
-        unsigned int s = (srcEncoding >> shift) & ENC_MASK;
-        // If destination alpha was added to support this format or if no source data is given for alpha, fill it with 1.
-        if (shift == ENC_ALPHA_SHIFT && (alphaOne || 4 <= s))
-        {
-          pdst[d] = getAlphaOne<D>();
-        }
-        else
-        {
-          if (s < 4) // There is data for this channel inside the source. (This could be a luminance to RGB mapping as well).
-          {
-            S value = psrc[s];
-            pdst[d] = (fixedPoint) ? adjust<D>(value) : D(value);
-          }
-          else // no value provided
-          {
-            pdst[d] = D(0);
-          }
-        }
-      }
-    }
-    pdst += dstChannels;
-    psrc += srcChannels;
-  }
-}
-
-// Straight channel copy with no adjustment. Since the data types match, fixed point doesn't matter.
-template<typename T>
-void remapCopy(void *dst, unsigned int dstEncoding, const void *src, unsigned int srcEncoding, size_t count)
-{
-  const T *psrc = reinterpret_cast<const T *>(src);
-  T *pdst = reinterpret_cast<T *>(dst);
-  unsigned int dstChannels = (dstEncoding >> ENC_CHANNELS_SHIFT) & ENC_MASK;
-  unsigned int srcChannels = (srcEncoding >> ENC_CHANNELS_SHIFT) & ENC_MASK;
-  bool alphaOne = !!(dstEncoding & ENC_ALPHA_ONE);
-
-  while (count--)
-  {
-    unsigned int shift = ENC_RED_SHIFT;
-    for (unsigned int i = 0; i < 5; ++i, shift += 4) // Five possible channels: R, G, B, A, L
-    {
-      unsigned int d = (dstEncoding >> shift) & ENC_MASK;
-      if (d < 4) // This data channel exists inside the destination.
-      {
-        unsigned int s = (srcEncoding >> shift) & ENC_MASK;
-        if (shift == ENC_ALPHA_SHIFT && (alphaOne || 4 <= s))
-        {
-          pdst[d] = getAlphaOne<T>();
-        }
-        else
-        {
-          pdst[d] = (s < 4) ? psrc[s] : T(0);
-        }
-      }
-    }
-    pdst += dstChannels;
-    psrc += srcChannels;
-  }
-}
-
-template<typename D>
-void remapFromFloat(void *dst, unsigned int dstEncoding, const void *src, unsigned int srcEncoding, size_t count)
-{
-  const float *psrc = reinterpret_cast<const float *>(src);
-  D *pdst = reinterpret_cast<D *>(dst);
-  unsigned int dstChannels = (dstEncoding >> ENC_CHANNELS_SHIFT) & ENC_MASK;
-  unsigned int srcChannels = (srcEncoding >> ENC_CHANNELS_SHIFT) & ENC_MASK;
-  bool fixedPoint = !!(dstEncoding & ENC_FIXED_POINT);
-  bool alphaOne   = !!(dstEncoding & ENC_ALPHA_ONE);
-
-  while (count--)
-  {
-    unsigned int shift = ENC_RED_SHIFT;
-    for (unsigned int i = 0; i < 5; ++i, shift += 4)
-    {
-      unsigned int d = (dstEncoding >> shift) & ENC_MASK;
-      if (d < 4) // This data channel exists inside the destination.
-      {
-        unsigned int s = (srcEncoding >> shift) & ENC_MASK;
-        if (shift == ENC_ALPHA_SHIFT && (alphaOne || 4 <= s))
-        {
-          pdst[d] = getAlphaOne<D>();
-        }
-        else
-        {
-          if (s < 4) // This data channel exists inside the source.
-          {
-            float value = psrc[s];
-            if (fixedPoint)
-            {
-              MY_ASSERT(std::numeric_limits<D>::is_integer); // Destination with float format cannot be fixed point.
-
-              float minimum = (std::numeric_limits<D>::is_signed) ? -1.0f : 0.0f;
-              value = std::min(std::max(minimum, value), 1.0f);
-              pdst[d] = D(std::numeric_limits<D>::max() * value); // Scaled copy.
-            }
-            else // element type, clamped copy.
-            {
-              float maximum = float(std::numeric_limits<D>::max()); // This will run out of precision for int and unsigned int.
-              float minimum = -maximum;
-              pdst[d] = D(std::min(std::max(minimum, value), maximum));
-            }
-          }
-          else // no value provided
-          {
-            pdst[d] = D(0);
-          }
-        }
-      }
-    }
-    pdst += dstChannels;
-    psrc += srcChannels;
-  }
-}
-
-template<typename S>
-void remapToFloat(void *dst, unsigned int dstEncoding, const void *src, unsigned int srcEncoding, size_t count)
-{
-  const S *psrc = reinterpret_cast<const S *>(src);
-  float *pdst = reinterpret_cast<float *>(dst);
-  unsigned int dstChannels = (dstEncoding >> ENC_CHANNELS_SHIFT) & ENC_MASK;
-  unsigned int srcChannels = (srcEncoding >> ENC_CHANNELS_SHIFT) & ENC_MASK;
-  bool alphaOne = !!(dstEncoding & ENC_ALPHA_ONE);
-
-  while (count--)
-  {
-    unsigned int shift = ENC_RED_SHIFT;
-    for (unsigned int i = 0; i < 5; ++i, shift += 4)
-    {
-      unsigned int d = (dstEncoding >> shift) & ENC_MASK;
-      if (d < 4) // This data channel exists inside the destination.
-      {
-        unsigned int s = (srcEncoding >> shift) & ENC_MASK;
-        if (shift == ENC_ALPHA_SHIFT && (alphaOne || 4 <= s))
-        {
-          pdst[d] = 1.0f;
-        }
-        else
-        {
-          // If there is data for this channel just cast it straight in.
-          // This will run out of precision for int and unsigned int source data.
-          pdst[d] = (s < 4) ? float(psrc[s]) : 0.0f;
-        }
-      }
-    }
-    pdst += dstChannels;
-    psrc += srcChannels;
-  }
-}
-
-
-typedef void (*PFNREMAP)(void *dst, unsigned int dstEncoding, const void *src, unsigned int srcEncoding, size_t count);
-
-// Function table with 49 texture format conversion routines from loaded image data to supported CUDA texture formats.
-// Index is [destination type][source type]
-PFNREMAP remappers[7][7] = 
-{
-  {
-    remapCopy<char>,
-    remapAdjust<char, unsigned char>,
-    remapAdjust<char, short>,
-    remapAdjust<char, unsigned short>,
-    remapAdjust<char, int>,
-    remapAdjust<char, unsigned int>,
-    remapFromFloat<char>
-  },
-  { 
-    remapAdjust<unsigned char, char>,
-    remapCopy<unsigned char>,
-    remapAdjust<unsigned char, short>,
-    remapAdjust<unsigned char, unsigned short>,
-    remapAdjust<unsigned char, int>,
-    remapAdjust<unsigned char, unsigned int>,
-    remapFromFloat<unsigned char>
-  },
-  { 
-    remapAdjust<short, char>,
-    remapAdjust<short, unsigned char>,
-    remapCopy<short>,
-    remapAdjust<short, unsigned short>,
-    remapAdjust<short, int>,
-    remapAdjust<short, unsigned int>,
-    remapFromFloat<short>
-  },
-  {
-    remapAdjust<unsigned short, char>,
-    remapAdjust<unsigned short, unsigned char>,
-    remapAdjust<unsigned short, short>,
-    remapCopy<unsigned short>,
-    remapAdjust<unsigned short, int>,
-    remapAdjust<unsigned short, unsigned int>,
-    remapFromFloat<unsigned short>
-  },
-  { 
-    remapAdjust<int, char>,
-    remapAdjust<int, unsigned char>,
-    remapAdjust<int, short>,
-    remapAdjust<int, unsigned short>,
-    remapCopy<int>,
-    remapAdjust<int, unsigned int>,
-    remapFromFloat<int>
-  },
-  {
-    remapAdjust<unsigned int, char>,
-    remapAdjust<unsigned int, unsigned char>,
-    remapAdjust<unsigned int, short>,
-    remapAdjust<unsigned int, unsigned short>,
-    remapAdjust<unsigned int, int>,
-    remapCopy<unsigned int>,
-    remapFromFloat<unsigned int>
-  },
-  {
-    remapToFloat<char>,
-    remapToFloat<unsigned char>,
-    remapToFloat<short>,
-    remapToFloat<unsigned short>,
-    remapToFloat<int>,
-    remapToFloat<unsigned int>,
-    remapCopy<float>
-  }
-};
-
-
-// Finally the function which converts any loaded image into a texture format supported by CUDA (1, 2, 4 channels only).
-static void convert(void *dst, unsigned int deviceEncoding, const void *src, unsigned int hostEncoding, size_t elements)
-{
-  // Only destination encoding knows about the fixed-point encoding. For straight data memcpy() cases that is irrelevant.
-  // FIXME PERF Avoid this conversion altogether when it's just a memcpy().
-  if ((deviceEncoding & ~ENC_FIXED_POINT) == hostEncoding)
-  {
-    memcpy(dst, src, elements * getElementSize(deviceEncoding)); // The fastest path.
-  }
-  else
-  {
-    unsigned int dstType = (deviceEncoding >> ENC_TYPE_SHIFT) & ENC_MASK;
-    unsigned int srcType = (hostEncoding   >> ENC_TYPE_SHIFT) & ENC_MASK;
-    MY_ASSERT(dstType < 7 && srcType < 7); 
-          
-    PFNREMAP pfn = remappers[dstType][srcType];
-
-    (*pfn)(dst, deviceEncoding, src, hostEncoding, elements);
-  }
-}
-
 Texture::Texture()
 : m_width(0)
 , m_height(0)
@@ -653,6 +240,7 @@ Texture::Texture()
 , m_d_envCDF_U(0)
 , m_d_envCDF_V(0)
 , m_integral(1.0f)
+, m_envFormat(ENV_FORMAT_RGBA32F)
 {
   m_descArray3D.Width       = 0;
   m_descArray3D.Height      = 0;
@@ -773,6 +361,13 @@ void Texture::setMipmapLevelBiasMinMax(float bias, float minimum, float maximum)
   m_textureDescription.maxMipmapLevelClamp = maximum;
 }
 
+void Texture::setEnvFormat(const int format)
+{
+  MY_ASSERT(m_textureObject == 0 && 0 <= format && format < NUM_ENV_FORMATS);
+
+  m_envFormat = format;
+}
+
 void Texture::setReadMode(bool asInteger)
 {
   MY_ASSERT(m_textureObject == 0);
@@ -863,7 +458,7 @@ bool Texture::create1D(const Picture* picture)
       sizeElements = image->m_width * m_depth;
       sizeBytes    = sizeElements * m_sizeBytesPerElement;
 
-      convert(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
+      convertTexels(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
 
       CUDA_MEMCPY3D params = {};
 
@@ -897,7 +492,7 @@ bool Texture::create1D(const Picture* picture)
     sizeElements = m_width * m_depth;
     sizeBytes    = sizeElements * m_sizeBytesPerElement;
 
-    convert(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
+    convertTexels(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
     
     CUDA_MEMCPY3D params = {};
 
@@ -955,7 +550,7 @@ bool Texture::create2D(const Picture* picture)
   
   const unsigned int numLevels = picture->getNumberOfLevels(0); // This is the number of mipmap levels including LOD 0.
 
-  if (1 < numLevels && (m_flags & IMAGE_FLAG_MIPMAP)) // 2D (layered) mipmapped texture // FIXME Add a mechanism to generate mipmaps if there are none.
+  if (1 < numLevels && (m_flags & IMAGE_FLAG_MIPMAP)) // 2D (layered) mipmapped texture. Picture::load() generates missing mipmaps of plain 2D images.
   {
     // A 2D mipmapped array is allocated if only Depth extent is zero.
     // A 2D layered CUDA mipmapped array is allocated if all three extents are non-zero and the ::CUDA_ARRAY3D_LAYERED flag is set.
@@ -973,7 +568,7 @@ bool Texture::create2D(const Picture* picture)
       sizeElements = image->m_width * image->m_height * m_depth;
       sizeBytes    = sizeElements * m_sizeBytesPerElement;
       
-      convert(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
+      convertTexels(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
 
       CUDA_MEMCPY3D params = {};
 
@@ -1007,7 +602,7 @@ bool Texture::create2D(const Picture* picture)
     sizeElements = m_width * m_height * m_depth;
     sizeBytes    = sizeElements * m_sizeBytesPerElement;
 
-    convert(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
+    convertTexels(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
 
     CUDA_MEMCPY3D params = {};
 
@@ -1074,7 +669,7 @@ bool Texture::create3D(const Picture* picture)
       sizeElements = image->m_width * image->m_height * image->m_depth; // Really the image->m_depth here, no layers in 3D textures.
       sizeBytes    = sizeElements * m_sizeBytesPerElement;
 
-      convert(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
+      convertTexels(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
 
       CUDA_MEMCPY3D params = {};
 
@@ -1106,7 +701,7 @@ bool Texture::create3D(const Picture* picture)
     sizeElements = m_width * m_height * m_depth; // Really the image->m_depth here, no layers in 3D textures.
     sizeBytes    = sizeElements * m_sizeBytesPerElement;
 
-    convert(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
+    convertTexels(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
 
     CUDA_MEMCPY3D params = {};
 
@@ -1208,7 +803,7 @@ bool Texture::createCube(const Picture* picture)
           void* src = image->m_pixels + sizeBytesLayer *  layer;
           void* dst = data            + sizeBytesLayer * (layer * 6 + face); 
         
-          convert(dst, m_deviceEncoding, src, m_hostEncoding, sizeElementsLayer);
+          convertTexels(dst, m_deviceEncoding, src, m_hostEncoding, sizeElementsLayer);
         }
       }
 
@@ -1257,7 +852,7 @@ bool Texture::createCube(const Picture* picture)
         void* src = image->m_pixels + sizeBytesLayer *  layer;
         void* dst = data            + sizeBytesLayer * (layer * 6 + face); 
         
-        convert(dst, m_deviceEncoding, src, m_hostEncoding, sizeElementsLayer);
+        convertTexels(dst, m_deviceEncoding, src, m_hostEncoding, sizeElementsLayer);
       }
     }
 
@@ -1300,6 +895,19 @@ bool Texture::createEnv(const Picture* picture)
   m_descArray3D.Depth  = 0;
   determineFormatChannels(m_deviceEncoding, m_descArray3D.Format, m_descArray3D.NumChannels);
   m_descArray3D.Flags  = 0;
+
+  // The compact formats replace the RGBA32F device format. Only the uploaded texels are converted.
+  if (m_envFormat == ENV_FORMAT_RGBA16F)
+  {
+    m_descArray3D.Format      = CU_AD_FORMAT_HALF;
+    m_descArray3D.NumChannels = 4;
+  }
+  else if (m_envFormat == ENV_FORMAT_RGB9E5)
+  {
+    m_descArray3D.Format      = CU_AD_FORMAT_UNSIGNED_INT32;
+    m_descArray3D.NumChannels = 1;
+  }
+  m_sizeBytesPerElement = getEnvFormatElementSize(m_envFormat);
   
   size_t sizeElements = m_width * m_height; // The size for the LOD 0 in elements.
   //size_t sizeBytes    = sizeElements * m_sizeBytesPerElement;
@@ -1311,12 +919,14 @@ bool Texture::createEnv(const Picture* picture)
 
   const Image* image = picture->getImageLevel(0, 0); // LOD 0 only.
 
-  convert(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
+  convertTexels(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
+
+  std::vector<unsigned int> texels;
 
   CUDA_MEMCPY3D params = {};
 
   params.srcMemoryType = CU_MEMORYTYPE_HOST;
-  params.srcHost       = data;
+  params.srcHost       = convertEnv(data, sizeElements, texels);
   params.srcPitch      = m_width * m_sizeBytesPerElement;
   params.srcHeight     = m_height;
 
@@ -1349,6 +959,13 @@ bool Texture::createEnv(const Picture* picture)
 
   //m_textureDescription.flags = CU_TRSF_NORMALIZED_COORDINATES;
 
+  // 32-bit integer textures only support point sampling. The shaders filter RGB9E5 themselves, see sampleRGB9E5().
+  if (m_envFormat == ENV_FORMAT_RGB9E5)
+  {
+    m_textureDescription.filterMode = CU_TR_FILTER_MODE_POINT;
+    m_textureDescription.flags     |= CU_TRSF_READ_AS_INTEGER;
+  }
+
   //m_textureDescription.maxAnisotropy = 1;
 
   //m_textureDescription.mipmapFilterMode    = CU_TR_FILTER_MODE_POINT;
@@ -1487,153 +1104,23 @@ cudaTextureObject_t Texture::getTextureObject() const
 
 // The following functions are used to build the data needed for an importance sampled spherical HDR environment map. 
 
-// Implement a simple Gaussian 3x3 filter with sigma = 0.5
-// Needed for the CDF generation of the importance sampled HDR environment texture light.
-static float gaussianFilter(const float* rgba, unsigned int width, unsigned int height, unsigned int x, unsigned int y)
-{
-  // Lookup is repeated in x and clamped to edge in y.
-  unsigned int left   = (0 < x)          ? x - 1 : width - 1; // repeat
-  unsigned int right  = (x < width - 1)  ? x + 1 : 0;         // repeat
-  unsigned int bottom = (0 < y)          ? y - 1 : y;         // clamp
-  unsigned int top    = (y < height - 1) ? y + 1 : y;         // clamp
-  
-  // Center
-  const float *p = rgba + (width * y + x) * 4;
-  float intensity = (p[0] + p[1] + p[2]) * 0.619347f;
-
-  // 4-neighbours
-  p = rgba + (width * bottom + x) * 4;
-  float f = p[0] + p[1] + p[2];
-  p = rgba + (width * y + left) * 4;
-  f += p[0] + p[1] + p[2];
-  p = rgba + (width * y + right) * 4;
-  f += p[0] + p[1] + p[2];
-  p = rgba + (width * top + x) * 4;
-  f += p[0] + p[1] + p[2];
-  intensity += f * 0.0838195f;
-
-  // 8-neighbours corners
-  p = rgba + (width * bottom + left) * 4;
-  f  = p[0] + p[1] + p[2];
-  p = rgba + (width * bottom + right) * 4;
-  f += p[0] + p[1] + p[2];
-  p = rgba + (width * top + left) * 4;
-  f += p[0] + p[1] + p[2];
-  p = rgba + (width * top + right) * 4;
-  f += p[0] + p[1] + p[2];
-  intensity += f * 0.0113437f;
-
-  return intensity / 3.0f;
-}
-
-// Create cumulative distribution function for importance sampling of spherical environment lights.
-// This is a textbook implementation for the CDF generation of a spherical HDR environment.
-// See "Physically Based Rendering" v2, chapter 14.6.5 on Infinite Area Lights.
+// Create cumulative distribution function for importance sampling of spherical environment lights and upload it.
 void Texture::calculateSphericalCDF(const float* rgba)
 {
-  // The original data needs to be retained to calculate the PDF.
-  float *funcU = new float[m_width * m_height];
-  float *funcV = new float[m_height + 1];
-
-  float sum = 0.0f;
-  // First generate the function data.
-  for (unsigned int y = 0; y < m_height; ++y)
-  {
-    // Scale distibution by the sine to get the sampling uniform. (Avoid sampling more values near the poles.)
-    // See Physically Based Rendering v2, chapter 14.6.5 on Infinite Area Lights, page 728.
-    float sinTheta = float(sin(M_PI * (double(y) + 0.5) / double(m_height))); // Make this as accurate as possible.
-
-    for (unsigned int x = 0; x < m_width; ++x)
-    {
-      // Filter to keep the piecewise linear function intact for samples with zero value next to non-zero values.
-      const float value = gaussianFilter(rgba, m_width, m_height, x, y);
-      funcU[y * m_width + x] = value * sinTheta;
-
-      // Compute integral over the actual function.
-      const float *p = rgba + (y * m_width + x) * 4;
-      const float intensity = (p[0] + p[1] + p[2]) / 3.0f;
-      sum += intensity * sinTheta;
-    }
-  }
+  std::vector<float> cdfU;
+  std::vector<float> cdfV;
 
   // This integral is used inside the light sampling function (see sysData.envIntegral).
-  m_integral = sum * 2.0f * M_PIf * M_PIf / float(m_width * m_height);
-
-  // Now generate the CDF data.
-  // Normalized 1D distributions in the rows of the 2D buffer, and the marginal CDF in the 1D buffer.
-  // Include the starting 0.0f and the ending 1.0f to avoid special cases during the continuous sampling.
-  float *cdfU = new float[(m_width + 1) * m_height];
-  float *cdfV = new float[m_height + 1];
-
-  for (unsigned int y = 0; y < m_height; ++y)
-  {
-    unsigned int row = y * (m_width + 1); // Watch the stride!
-    cdfU[row + 0] = 0.0f; // CDF starts at 0.0f.
-
-    for (unsigned int x = 1; x <= m_width; ++x)
-    {
-      unsigned int i = row + x;
-      cdfU[i] = cdfU[i - 1] + funcU[y * m_width + x - 1]; // Attention, funcU is only m_width wide! 
-    }
-
-    const float integral = cdfU[row + m_width]; // The integral over this row is in the last element.
-    funcV[y] = integral;                        // Store this as function values of the marginal CDF.
-
-    if (integral != 0.0f)
-    {
-      for (unsigned int x = 1; x <= m_width; ++x)
-      {
-        cdfU[row + x] /= integral;
-      }
-    }
-    else // All texels were black in this row. Generate an equal distribution.
-    {
-      for (unsigned int x = 1; x <= m_width; ++x)
-      {
-        cdfU[row + x] = float(x) / float(m_width);
-      }
-    }
-  }
-
-  // Now do the same thing with the marginal CDF.
-  cdfV[0] = 0.0f; // CDF starts at 0.0f.
-  for (unsigned int y = 1; y <= m_height; ++y)
-  {
-    cdfV[y] = cdfV[y - 1] + funcV[y - 1];
-  }
-        
-  const float integral = cdfV[m_height]; // The integral over this marginal CDF is in the last element.
-  funcV[m_height] = integral;            // For completeness, actually unused.
-
-  if (integral != 0.0f)
-  {
-    for (unsigned int y = 1; y <= m_height; ++y)
-    {
-      cdfV[y] /= integral;
-    }
-  }
-  else // All texels were black in the whole image. Seriously? :-) Generate an equal distribution.
-  {
-    for (unsigned int y = 1; y <= m_height; ++y)
-    {
-      cdfV[y] = float(y) / float(m_height);
-    }
-  }
+  m_integral = ::calculateSphericalCDF(rgba, m_width, m_height, cdfU, cdfV);
 
   // Upload the CDFs into CUDA buffers.
-  size_t sizeBytes = (m_width + 1) * m_height * sizeof(float);
+  size_t sizeBytes = cdfU.size() * sizeof(float);
   CU_CHECK( cuMemAlloc(&m_d_envCDF_U, sizeBytes) );
-  CU_CHECK( cuMemcpyHtoD(m_d_envCDF_U, cdfU, sizeBytes) );
+  CU_CHECK( cuMemcpyHtoD(m_d_envCDF_U, cdfU.data(), sizeBytes) );
 
-  sizeBytes = (m_height + 1) * sizeof(float);
+  sizeBytes = cdfV.size() * sizeof(float);
   CU_CHECK( cuMemAlloc(&m_d_envCDF_V, sizeBytes) );
-  CU_CHECK( cuMemcpyHtoD(m_d_envCDF_V, cdfV, sizeBytes) );
-
-  delete[] cdfV;
-  delete[] cdfU;
-        
-  delete[] funcV;
-  delete[] funcU;
+  CU_CHECK( cuMemcpyHtoD(m_d_envCDF_V, cdfV.data(), sizeBytes) );
 }
 
 CUdeviceptr Texture::getCDF_U() const
@@ -1681,7 +1168,7 @@ bool Texture::update1D(const Picture* picture)
       sizeElements = image->m_width * m_depth;
       sizeBytes    = sizeElements * m_sizeBytesPerElement;
 
-      convert(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
+      convertTexels(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
 
       CUDA_MEMCPY3D params = {};
 
@@ -1707,7 +1194,7 @@ bool Texture::update1D(const Picture* picture)
     sizeElements = m_width * m_depth;
     sizeBytes    = sizeElements * m_sizeBytesPerElement;
 
-    convert(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
+    convertTexels(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
     
     CUDA_MEMCPY3D params = {};
 
@@ -1748,7 +1235,7 @@ bool Texture::update2D(const Picture* picture)
   
   const unsigned int numLevels = picture->getNumberOfLevels(0); // This is the number of mipmap levels including LOD 0.
 
-  if (1 < numLevels && (m_flags & IMAGE_FLAG_MIPMAP)) // 2D (layered) mipmapped texture // FIXME Add a mechanism to generate mipmaps if there are none.
+  if (1 < numLevels && (m_flags & IMAGE_FLAG_MIPMAP)) // 2D (layered) mipmapped texture. Picture::load() generates missing mipmaps of plain 2D images.
   {
     CU_CHECK( cuMipmappedArrayCreate(&m_d_mipmappedArray, &m_descArray3D, numLevels) );
 
@@ -1763,7 +1250,7 @@ bool Texture::update2D(const Picture* picture)
       sizeElements = image->m_width * image->m_height * m_depth;
       sizeBytes    = sizeElements * m_sizeBytesPerElement;
       
-      convert(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
+      convertTexels(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
 
       CUDA_MEMCPY3D params = {};
 
@@ -1789,7 +1276,7 @@ bool Texture::update2D(const Picture* picture)
     sizeElements = m_width * m_height * m_depth;
     sizeBytes    = sizeElements * m_sizeBytesPerElement;
 
-    convert(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
+    convertTexels(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
 
     CUDA_MEMCPY3D params = {};
 
@@ -1838,7 +1325,7 @@ bool Texture::update3D(const Picture* picture)
       sizeElements = image->m_width * image->m_height * image->m_depth; // Really the image->m_depth here, no layers in 3D textures.
       sizeBytes    = sizeElements * m_sizeBytesPerElement;
 
-      convert(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
+      convertTexels(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
 
       CUDA_MEMCPY3D params = {};
 
@@ -1864,7 +1351,7 @@ bool Texture::update3D(const Picture* picture)
     sizeElements = m_width * m_height * m_depth; // Really the image->m_depth here, no layers in 3D textures.
     sizeBytes    = sizeElements * m_sizeBytesPerElement;
 
-    convert(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
+    convertTexels(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
 
     CUDA_MEMCPY3D params = {};
 
@@ -1940,7 +1427,7 @@ bool Texture::updateCube(const Picture* picture)
           void* src = image->m_pixels + sizeBytesLayer *  layer;
           void* dst = data            + sizeBytesLayer * (layer * 6 + face); 
         
-          convert(dst, m_deviceEncoding, src, m_hostEncoding, sizeElementsLayer);
+          convertTexels(dst, m_deviceEncoding, src, m_hostEncoding, sizeElementsLayer);
         }
       }
 
@@ -1976,7 +1463,7 @@ bool Texture::updateCube(const Picture* picture)
         void* src = image->m_pixels + sizeBytesLayer *  layer;
         void* dst = data            + sizeBytesLayer * (layer * 6 + face); 
         
-        convert(dst, m_deviceEncoding, src, m_hostEncoding, sizeElementsLayer);
+        convertTexels(dst, m_deviceEncoding, src, m_hostEncoding, sizeElementsLayer);
       }
     }
 
@@ -2011,12 +1498,14 @@ bool Texture::updateEnv(const Picture* picture)
   
   const Image* image = picture->getImageLevel(0, 0); // LOD 0 only.
 
-  convert(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
+  convertTexels(data, m_deviceEncoding, image->m_pixels, m_hostEncoding, sizeElements);
+
+  std::vector<unsigned int> texels;
 
   CUDA_MEMCPY3D params = {};
 
   params.srcMemoryType = CU_MEMORYTYPE_HOST;
-  params.srcHost       = data;
+  params.srcHost       = convertEnv(data, sizeElements, texels);
   params.srcPitch      = m_width * m_sizeBytesPerElement;
   params.srcHeight     = m_height;
 
@@ -2041,6 +1530,25 @@ bool Texture::updateEnv(const Picture* picture)
 }
 
 
+// Returns the environment texels in the device format. The compact formats are converted into the buffer.
+const void* Texture::convertEnv(const float* rgba, const size_t count, std::vector<unsigned int>& buffer) const
+{
+  switch (m_envFormat)
+  {
+    case ENV_FORMAT_RGBA16F:
+      buffer.resize(count * 2); // Two halfs per unsigned int.
+      convertToRGBA16F(reinterpret_cast<unsigned short*>(buffer.data()), rgba, count);
+      return buffer.data();
+
+    case ENV_FORMAT_RGB9E5:
+      buffer.resize(count);
+      convertToRGB9E5(buffer.data(), rgba, count);
+      return buffer.data();
+  }
+  return rgba;
+}
+
+
 bool Texture::update(const Picture* picture)
 {
   bool success = false;
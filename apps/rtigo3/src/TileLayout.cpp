@@ -0,0 +1,125 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/TileLayout.h"
+
+#include "shaders/tile_layout.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && 2 <= _M_IX86_FP)
+#define USE_TILE_SSE 1
+#include <xmmintrin.h>
+#else
+#define USE_TILE_SSE 0
+#endif
+
+
+static int2 getTileShift(const int2 tileSize)
+{
+  int2 shift = make_int2(0, 0);
+
+  while ((1 << shift.x) < tileSize.x)
+  {
+    ++shift.x;
+  }
+  while ((1 << shift.y) < tileSize.y)
+  {
+    ++shift.y;
+  }
+  return shift;
+}
+
+// Copies one tile row segment. Every float4 pixel is one SSE register, two per iteration to overlap the loads and stores.
+static inline void copyPixels(float4* dst, const float4* src, const int count)
+{
+#if USE_TILE_SSE
+  int i = 0;
+  for (; i + 2 <= count; i += 2)
+  {
+    const __m128 a = _mm_loadu_ps(&src[i].x);
+    const __m128 b = _mm_loadu_ps(&src[i + 1].x);
+    _mm_storeu_ps(&dst[i].x,     a);
+    _mm_storeu_ps(&dst[i + 1].x, b);
+  }
+  if (i < count)
+  {
+    _mm_storeu_ps(&dst[i].x, _mm_loadu_ps(&src[i].x));
+  }
+#else
+  memcpy(dst, src, sizeof(float4) * count);
+#endif
+}
+
+
+size_t getTiledBufferSize(const int2 resolution, const int2 tileSize)
+{
+  const int2 tiles = tileCount(resolution, getTileShift(tileSize));
+
+  return size_t(tiles.x) * tiles.y * tileSize.x * tileSize.y;
+}
+
+
+// Both directions walk the linear buffer row by row, so one side is always streamed sequentially.
+// A tile row segment is contiguous in both layouts and gets copied in one go.
+void detileHost(float4* dst, const float4* src, const int2 resolution, const int2 tileSize)
+{
+  const int2 shift  = getTileShift(tileSize);
+  const int  tilesX = tileCount(resolution, shift).x;
+
+  for (int y = 0; y < resolution.y; ++y)
+  {
+    float4* row = dst + size_t(y) * resolution.x;
+
+    for (int x = 0; x < resolution.x; x += tileSize.x)
+    {
+      const int count = (tileSize.x < resolution.x - x) ? tileSize.x : resolution.x - x;
+
+      copyPixels(row + x, src + tiledIndex(x, y, tilesX, shift), count);
+    }
+  }
+}
+
+
+void retileHost(float4* dst, const float4* src, const int2 resolution, const int2 tileSize)
+{
+  const int2 shift  = getTileShift(tileSize);
+  const int  tilesX = tileCount(resolution, shift).x;
+
+  for (int y = 0; y < resolution.y; ++y)
+  {
+    const float4* row = src + size_t(y) * resolution.x;
+
+    for (int x = 0; x < resolution.x; x += tileSize.x)
+    {
+      const int count = (tileSize.x < resolution.x - x) ? tileSize.x : resolution.x - x;
+
+      copyPixels(dst + tiledIndex(x, y, tilesX, shift), row + x, count);
+    }
+  }
+}
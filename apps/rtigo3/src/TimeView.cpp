@@ -0,0 +1,303 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/TimeView.h"
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+
+
+void accumulateTimeView(std::vector<float>& cycles, std::vector<unsigned int>& ids,
+                        std::vector<float> const& cyclesDevice, std::vector<unsigned int> const& idsDevice)
+{
+  if (cycles.size() != cyclesDevice.size() || ids.size() != idsDevice.size())
+  {
+    // First device defines the layout.
+    cycles = cyclesDevice;
+    ids    = idsDevice;
+    return;
+  }
+
+  for (size_t i = 0; i < cycles.size(); ++i)
+  {
+    cycles[i] += cyclesDevice[i];
+  }
+  for (size_t i = 0; i < ids.size(); ++i)
+  {
+    if (idsDevice[i] != 0) // Only the owning device of a pixel wrote its IDs.
+    {
+      ids[i] = idsDevice[i];
+    }
+  }
+}
+
+
+struct TimeViewSum
+{
+  TimeViewSum()
+  : pixels(0)
+  , cycles(0.0)
+  {
+  }
+
+  unsigned int pixels;
+  double       cycles;
+};
+
+
+static std::vector<TimeViewGroup> sortGroups(std::map<int, TimeViewSum> const& sums)
+{
+  std::vector<TimeViewGroup> groups;
+
+  for (std::map<int, TimeViewSum>::const_iterator it = sums.begin(); it != sums.end(); ++it)
+  {
+    TimeViewGroup group;
+
+    group.id     = it->first;
+    group.pixels = it->second.pixels;
+    group.cycles = (0 < it->second.pixels) ? it->second.cycles / double(it->second.pixels) : 0.0;
+
+    groups.push_back(group);
+  }
+
+  // Most expensive first. Ties are resolved by the ID to keep the output deterministic.
+  std::sort(groups.begin(), groups.end(), [](TimeViewGroup const& a, TimeViewGroup const& b)
+  {
+    return (a.cycles != b.cycles) ? (b.cycles < a.cycles) : (a.id < b.id);
+  });
+
+  return groups;
+}
+
+
+bool analyzeTimeView(std::vector<float> const& cycles, std::vector<unsigned int> const& ids,
+                     const int width, const int height,
+                     const int tileWidth, const int tileHeight,
+                     const int numBins, const int numTiles,
+                     TimeViewReport& report)
+{
+  if (width <= 0 || height <= 0 || tileWidth <= 0 || tileHeight <= 0 || numBins <= 0 || numTiles < 0)
+  {
+    return false;
+  }
+
+  const size_t numPixels = size_t(width) * size_t(height);
+
+  if (cycles.size() != numPixels || (!ids.empty() && ids.size() != numPixels * 2))
+  {
+    return false;
+  }
+
+  report.width      = width;
+  report.height     = height;
+  report.tileWidth  = tileWidth;
+  report.tileHeight = tileHeight;
+
+  report.minimum = cycles[0];
+  report.maximum = cycles[0];
+
+  double sum = 0.0;
+
+  for (size_t i = 0; i < numPixels; ++i)
+  {
+    const double c = cycles[i];
+
+    report.minimum = std::min(report.minimum, c);
+    report.maximum = std::max(report.maximum, c);
+    sum += c;
+  }
+  report.average = sum / double(numPixels);
+
+  // Histogram. A constant image puts everything into the first bin.
+  report.histogram.assign(numBins, 0);
+  report.binWidth = (report.maximum - report.minimum) / double(numBins);
+
+  for (size_t i = 0; i < numPixels; ++i)
+  {
+    int bin = 0;
+    if (0.0 < report.binWidth)
+    {
+      bin = std::min(int((cycles[i] - report.minimum) / report.binWidth), numBins - 1);
+    }
+    ++report.histogram[bin];
+  }
+
+  // Tiles. The border tiles are averaged over their actually covered pixels.
+  const int tilesX = (width  + tileWidth  - 1) / tileWidth;
+  const int tilesY = (height + tileHeight - 1) / tileHeight;
+
+  std::vector<TimeViewSum> tileSums(size_t(tilesX) * size_t(tilesY));
+
+  for (int y = 0; y < height; ++y)
+  {
+    for (int x = 0; x < width; ++x)
+    {
+      TimeViewSum& tileSum = tileSums[(y / tileHeight) * tilesX + x / tileWidth];
+
+      tileSum.pixels += 1;
+      tileSum.cycles += cycles[size_t(y) * width + x];
+    }
+  }
+
+  report.tiles.clear();
+  report.tiles.reserve(tileSums.size());
+
+  for (int y = 0; y < tilesY; ++y)
+  {
+    for (int x = 0; x < tilesX; ++x)
+    {
+      TimeViewSum const& tileSum = tileSums[y * tilesX + x];
+
+      TimeViewTile tile;
+
+      tile.x      = x;
+      tile.y      = y;
+      tile.cycles = tileSum.cycles / double(tileSum.pixels);
+
+      report.tiles.push_back(tile);
+    }
+  }
+
+  // Partial sort is enough for the top N. Ties go to the lower scanline order.
+  const size_t numTop = std::min(size_t(numTiles), report.tiles.size());
+
+  std::partial_sort(report.tiles.begin(), report.tiles.begin() + numTop, report.tiles.end(), [](TimeViewTile const& a, TimeViewTile const& b)
+  {
+    return (a.cycles != b.cycles) ? (b.cycles < a.cycles) : ((a.y != b.y) ? (a.y < b.y) : (a.x < b.x));
+  });
+  report.tiles.resize(numTop);
+
+  // Per material and per instance averages of the primary hits.
+  report.materials.clear();
+  report.instances.clear();
+
+  if (!ids.empty())
+  {
+    std::map<int, TimeViewSum> sumsMaterial;
+    std::map<int, TimeViewSum> sumsInstance;
+
+    for (size_t i = 0; i < numPixels; ++i)
+    {
+      // The device stores the IDs biased by one so that zero is a miss. Misses end up in the group -1.
+      const int idInstance = int(ids[i * 2    ]) - 1;
+      const int idMaterial = int(ids[i * 2 + 1]) - 1;
+
+      TimeViewSum& sumInstance = sumsInstance[idInstance];
+      sumInstance.pixels += 1;
+      sumInstance.cycles += cycles[i];
+
+      TimeViewSum& sumMaterial = sumsMaterial[idMaterial];
+      sumMaterial.pixels += 1;
+      sumMaterial.cycles += cycles[i];
+    }
+
+    report.materials = sortGroups(sumsMaterial);
+    report.instances = sortGroups(sumsInstance);
+  }
+
+  return true;
+}
+
+
+// Material names come from the scene description. Fields with separators, quotes or line breaks are quoted
+// and embedded quotes doubled as in RFC 4180, so a name can't shift the columns or split the row.
+static std::string quoteCSV(std::string const& field)
+{
+  if (field.find_first_of(",\"\r\n") == std::string::npos)
+  {
+    return field;
+  }
+
+  std::string quoted("\"");
+  for (const char c : field)
+  {
+    if (c == '"')
+    {
+      quoted += '"';
+    }
+    quoted += c;
+  }
+  quoted += '"';
+
+  return quoted;
+}
+
+
+std::string formatTimeViewCSV(TimeViewReport const& report, std::vector<std::string> const& materialNames)
+{
+  std::ostringstream stream;
+
+  stream << "# summary\n";
+  stream << "width,height,tileWidth,tileHeight,minimum,maximum,average\n";
+  stream << report.width << ',' << report.height << ',' << report.tileWidth << ',' << report.tileHeight << ','
+         << report.minimum << ',' << report.maximum << ',' << report.average << '\n';
+
+  stream << "\n# histogram\n";
+  stream << "bin,lower,upper,pixels\n";
+  for (size_t i = 0; i < report.histogram.size(); ++i)
+  {
+    const double lower = report.minimum + report.binWidth * double(i);
+
+    stream << i << ',' << lower << ',' << lower + report.binWidth << ',' << report.histogram[i] << '\n';
+  }
+
+  stream << "\n# tiles\n";
+  stream << "rank,tileX,tileY,pixelX,pixelY,cycles\n";
+  for (size_t i = 0; i < report.tiles.size(); ++i)
+  {
+    TimeViewTile const& tile = report.tiles[i];
+
+    stream << i << ',' << tile.x << ',' << tile.y << ',' << tile.x * report.tileWidth << ',' << tile.y * report.tileHeight << ',' << tile.cycles << '\n';
+  }
+
+  stream << "\n# materials\n";
+  stream << "material,name,pixels,cycles\n";
+  for (size_t i = 0; i < report.materials.size(); ++i)
+  {
+    TimeViewGroup const& group = report.materials[i];
+
+    std::string name = (group.id < 0) ? std::string("miss") : std::string();
+    if (0 <= group.id && size_t(group.id) < materialNames.size())
+    {
+      name = materialNames[group.id];
+    }
+    stream << group.id << ',' << quoteCSV(name) << ',' << group.pixels << ',' << group.cycles << '\n';
+  }
+
+  stream << "\n# instances\n";
+  stream << "instance,pixels,cycles\n";
+  for (size_t i = 0; i < report.instances.size(); ++i)
+  {
+    TimeViewGroup const& group = report.instances[i];
+
+    stream << group.id << ',' << group.pixels << ',' << group.cycles << '\n';
+  }
+
+  return stream.str();
+}
@@ -0,0 +1,67 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/Tonemapper.h"
+
+#include "shaders/vector_math.h"
+
+
+void tonemap(TonemapperGUI const& parameters, const float4* src, uchar3* dst, const size_t count)
+{
+  const float  invGamma       = 1.0f / parameters.gamma;
+  const float3 colorBalance   = make_float3(parameters.colorBalance[0], parameters.colorBalance[1], parameters.colorBalance[2]);
+  const float  invWhitePoint  = parameters.brightness / parameters.whitePoint;
+  const float  burnHighlights = parameters.burnHighlights;
+  const float  crushBlacks    = parameters.crushBlacks + parameters.crushBlacks + 1.0f;
+  const float  saturation     = parameters.saturation;
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    // PERF Add a native CUDA kernel doing this.
+    float3 hdrColor = make_float3(src[i]);
+    float3 ldrColor = invWhitePoint * colorBalance * hdrColor;
+    ldrColor       *= ((ldrColor * burnHighlights) + 1.0f) / (ldrColor + 1.0f);
+    
+    float luminance = dot(ldrColor, make_float3(0.3f, 0.59f, 0.11f));
+    ldrColor = lerp(make_float3(luminance), ldrColor, saturation); // This can generate negative values for saturation > 1.0f!
+    ldrColor = fmaxf(make_float3(0.0f), ldrColor); // Prevent negative values.
+
+    luminance = dot(ldrColor, make_float3(0.3f, 0.59f, 0.11f));
+    if (luminance < 1.0f)
+    {
+      const float3 crushed = powf(ldrColor, crushBlacks);
+      ldrColor = lerp(crushed, ldrColor, sqrtf(luminance));
+      ldrColor = fmaxf(make_float3(0.0f), ldrColor); // Prevent negative values.
+    }
+    ldrColor = clamp(powf(ldrColor, invGamma), 0.0f, 1.0f); // Saturate, clamp to range [0.0f, 1.0f].
+
+    dst[i] = make_uchar3((unsigned char) (ldrColor.x * 255.0f),
+                         (unsigned char) (ldrColor.y * 255.0f),
+                         (unsigned char) (ldrColor.z * 255.0f));
+  }
+}
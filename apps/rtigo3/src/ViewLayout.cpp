@@ -0,0 +1,163 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "shaders/config.h"
+
+#include "inc/ViewLayout.h"
+
+#include "shaders/shader_common.h"
+
+#include <algorithm>
+
+
+// Scales the camera's U vector to the aspect ratio of the view. The vertical field of view stays the same.
+static CameraDefinition fitAspect(CameraDefinition const& camera, const int2 size)
+{
+  CameraDefinition result = camera;
+
+  result.U = normalize(camera.U) * length(camera.V) * (float(size.x) / float(size.y));
+
+  return result;
+}
+
+// Rotation around the world y-axis through the center point.
+static CameraDefinition rotateAroundY(CameraDefinition const& camera, const float3 center, const float angle)
+{
+  const float c = cosf(angle);
+  const float s = sinf(angle);
+
+  CameraDefinition result;
+
+  const float3 p = camera.P - center;
+
+  result.P = center + make_float3(c * p.x + s * p.z, p.y, -s * p.x + c * p.z);
+  result.U = make_float3(c * camera.U.x + s * camera.U.z, camera.U.y, -s * camera.U.x + c * camera.U.z);
+  result.V = make_float3(c * camera.V.x + s * camera.V.z, camera.V.y, -s * camera.V.x + c * camera.V.z);
+  result.W = make_float3(c * camera.W.x + s * camera.W.z, camera.W.y, -s * camera.W.x + c * camera.W.z);
+
+  return result;
+}
+
+static ViewDefinition makeView(const int x0, const int y0, const int x1, const int y1, const int idCamera)
+{
+  ViewDefinition view;
+
+  view.origin   = make_int2(x0, y0);
+  view.size     = make_int2(x1 - x0, y1 - y0);
+  view.idCamera = idCamera;
+
+  return view;
+}
+
+void createViewLayout(const int layout,
+                      const int2 grid,
+                      const int2 resolution,
+                      CameraDefinition const& camera,
+                      const float3 center,
+                      std::vector<CameraDefinition>& cameras,
+                      std::vector<ViewDefinition>& views)
+{
+  cameras.clear();
+  views.clear();
+
+  cameras.push_back(camera);
+
+  switch (layout)
+  {
+    case VIEW_LAYOUT_STEREO:
+      if (2 <= resolution.x)
+      {
+        // Parallel eyes. The interocular distance is the usual 1/30 of the distance to the sharp plane.
+        const float3 offset = normalize(camera.U) * (length(camera.P - center) / 60.0f);
+
+        const int split = resolution.x / 2;
+
+        views.push_back(makeView(0,     0, split,        resolution.y, 1));
+        views.push_back(makeView(split, 0, resolution.x, resolution.y, 2));
+
+        CameraDefinition left  = fitAspect(camera, views[0].size);
+        CameraDefinition right = fitAspect(camera, views[1].size);
+
+        left.P  -= offset;
+        right.P += offset;
+
+        cameras.push_back(left);
+        cameras.push_back(right);
+      }
+      break;
+
+    case VIEW_LAYOUT_CUBE:
+      if (3 <= resolution.x && 2 <= resolution.y)
+      {
+        // The faces always cover 90 degrees in both directions. They are only square for resolutions of 3n x 2n.
+        // W is the face direction, V the face's up direction. U = cross(W, V) like in Camera::getFrustum().
+        const float3 directions[6] = { make_float3( 1.0f, 0.0f, 0.0f), make_float3(-1.0f, 0.0f, 0.0f),
+                                       make_float3( 0.0f, 1.0f, 0.0f), make_float3( 0.0f,-1.0f, 0.0f),
+                                       make_float3( 0.0f, 0.0f, 1.0f), make_float3( 0.0f, 0.0f,-1.0f) };
+        const float3 ups[6]        = { make_float3( 0.0f, 1.0f, 0.0f), make_float3( 0.0f, 1.0f, 0.0f),
+                                       make_float3( 0.0f, 0.0f, 1.0f), make_float3( 0.0f, 0.0f,-1.0f),
+                                       make_float3( 0.0f, 1.0f, 0.0f), make_float3( 0.0f, 1.0f, 0.0f) };
+
+        for (int i = 0; i < 6; ++i)
+        {
+          CameraDefinition face;
+
+          face.P = camera.P;
+          face.W = directions[i];
+          face.V = ups[i]; // tan(45 degrees) == 1.0f
+          face.U = cross(face.W, face.V);
+
+          const int x = i % 3;
+          const int y = i / 3;
+
+          views.push_back(makeView((x * resolution.x) / 3, (y * resolution.y) / 2, ((x + 1) * resolution.x) / 3, ((y + 1) * resolution.y) / 2, 1 + i));
+          cameras.push_back(face);
+        }
+      }
+      break;
+
+    case VIEW_LAYOUT_GRID:
+      if (1 <= resolution.x && 1 <= resolution.y)
+      {
+        const int nx = std::max(1, std::min(grid.x, resolution.x));
+        const int ny = std::max(1, std::min(grid.y, resolution.y));
+        const int n  = nx * ny;
+
+        // Row 0 is at the bottom of the image. Start the sheet in the upper left corner.
+        for (int i = 0; i < n; ++i)
+        {
+          const int x = i % nx;
+          const int y = ny - 1 - i / nx;
+
+          views.push_back(makeView((x * resolution.x) / nx, (y * resolution.y) / ny, ((x + 1) * resolution.x) / nx, ((y + 1) * resolution.y) / ny, 1 + i));
+          cameras.push_back(fitAspect(rotateAroundY(camera, center, 2.0f * M_PIf * float(i) / float(n)), views.back().size));
+        }
+      }
+      break;
+  }
+}
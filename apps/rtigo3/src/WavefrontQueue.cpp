@@ -0,0 +1,120 @@
+/* 
+ * Copyright (c) 2013-2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "inc/WavefrontQueue.h"
+
+#include <vector>
+
+
+unsigned int sortWavefrontQueue(const unsigned int* keys, const unsigned int count, WavefrontCounters& counters, unsigned int* sortedQueue)
+{
+  // wavefront_histogram
+  unsigned int counts[WAVEFRONT_NUM_KEYS] = {};
+
+  for (unsigned int slot = 0; slot < count; ++slot)
+  {
+    wavefrontCountKey(counts, keys[slot]);
+  }
+  for (unsigned int key = 0; key < WAVEFRONT_NUM_KEYS; ++key)
+  {
+    wavefrontAddHistogram(&counters, counts, key);
+  }
+
+  // wavefront_offsets
+  wavefrontSortOffsets(&counters);
+
+  // wavefront_scatter
+  std::vector<unsigned int> ranks(count);
+
+  unsigned int blockCounts[WAVEFRONT_NUM_KEYS] = {};
+  unsigned int bases[WAVEFRONT_NUM_KEYS];
+
+  for (unsigned int slot = 0; slot < count; ++slot)
+  {
+    ranks[slot] = wavefrontCountKey(blockCounts, keys[slot]);
+  }
+  for (unsigned int key = 0; key < WAVEFRONT_NUM_KEYS; ++key)
+  {
+    bases[key] = wavefrontReserve(&counters, blockCounts, key);
+  }
+  for (unsigned int slot = 0; slot < count; ++slot)
+  {
+    const unsigned int key = keys[slot];
+    if (key < WAVEFRONT_NUM_KEYS)
+    {
+      sortedQueue[bases[key] + ranks[slot]] = slot;
+    }
+  }
+
+  return counters.hits;
+}
+
+
+bool isSortedWavefrontQueue(const unsigned int* keys, const unsigned int count, const unsigned int* sortedQueue, const unsigned int numHits)
+{
+  unsigned int ends[WAVEFRONT_NUM_KEYS] = {};
+
+  for (unsigned int slot = 0; slot < count; ++slot)
+  {
+    if (keys[slot] < WAVEFRONT_NUM_KEYS)
+    {
+      ++ends[keys[slot]];
+    }
+  }
+  for (unsigned int key = 1; key < WAVEFRONT_NUM_KEYS; ++key)
+  {
+    ends[key] += ends[key - 1]; // Inclusive prefix sum, one past the last entry of each key.
+  }
+
+  if (ends[WAVEFRONT_NUM_KEYS - 1] != numHits)
+  {
+    return false;
+  }
+
+  std::vector<bool> visited(count, false);
+
+  unsigned int key = 0;
+
+  for (unsigned int i = 0; i < numHits; ++i)
+  {
+    while (ends[key] <= i)
+    {
+      ++key;
+    }
+
+    const unsigned int slot = sortedQueue[i];
+
+    if (count <= slot || visited[slot] || keys[slot] != key)
+    {
+      return false;
+    }
+    visited[slot] = true;
+  }
+
+  return true;
+}
@@ -105,6 +105,10 @@ static int runApp(Options const& options)
   {
     g_app->benchmark();
   }
+  else if (mode == 2) // Input trace replay without GUI. Needs the --replay option.
+  {
+    g_app->replay();
+  }
 
   delete g_app;
 